@@ -199,6 +199,18 @@ RaParseComplete (int sig)
                           totalrecords, ArgusParser->ArgusTotalMarRecords, ArgusParser->ArgusTotalFarRecords, ArgusParser->ArgusTotalEventRecords,
                           ArgusParser->ArgusTotalPkts, ArgusParser->ArgusTotalBytes);
 #endif
+            if (ArgusParser->ArgusTimeRejects || ArgusParser->ArgusHeaderRejects ||
+                ArgusParser->ArgusLazyRejects || ArgusParser->ArgusFilterRejects) {
+#if defined(__OpenBSD__) || defined(__FreeBSD__) || defined(__APPLE_CC__) || defined(__APPLE__) || defined(ARGUS_SOLARIS)
+               printf (" TimeRejects  %-8lld  HeaderRejects   %-8lld  PreFilterRejects %-8lld FilterRejects     %-8lld\n",
+                          ArgusParser->ArgusTimeRejects, ArgusParser->ArgusHeaderRejects,
+                          ArgusParser->ArgusLazyRejects, ArgusParser->ArgusFilterRejects);
+#else
+               printf (" TimeRejects  %-8Ld  HeaderRejects   %-8Ld  PreFilterRejects %-8Ld FilterRejects     %-8Ld\n",
+                          ArgusParser->ArgusTimeRejects, ArgusParser->ArgusHeaderRejects,
+                          ArgusParser->ArgusLazyRejects, ArgusParser->ArgusFilterRejects);
+#endif
+            }
          }
 
          fflush(stdout);
@@ -56,12 +56,74 @@
 
 #include <argus_filter.h>
 #include <argus_cluster.h>
+#include <argus_grep.h>
+#include <argus_sketch.h>
 #include <netinet/ip_icmp.h>
 
 static int argus_version = ARGUS_VERSION;
 
 void ArgusIdleClientTimeout (void);
 
+/*
+ * Spill mode, -M spill=<size>.  When an aggregator's table holds
+ * more aggregates than fit in <size> bytes, the table is written out,
+ * spread over partition files by a direction independent hash of the
+ * flow key, and emptied, and from then on the records for that
+ * aggregator go straight to their partition file.  At the end each
+ * partition is read back and aggregated on its own, the aggregates
+ * restored as they were and the records merged with ArgusMergeRecords()
+ * in the order they arrived, so each partition ends up just as that
+ * part of the in-memory table would have.  A partition that still
+ * has too many aggregates is spilled again, the same way, over new
+ * partitions hashed with the next level's seed.  The partitions are
+ * sorted, written out as sorted runs, and the runs merged into the
+ * output.  Each record carries its arrival sequence, which stands in
+ * for the queue order when the sort keys tie.
+ */
+
+#define RACLUSTER_SPILL_PARTITIONS	64
+#define RACLUSTER_SPILL_MAXLEVEL	4
+#define RACLUSTER_SPILL_MAXRUNS		256
+#define RACLUSTER_SPILL_DSRBYTES	512
+
+struct RaClusterSpillStruct {
+   struct RaClusterSpillStruct *nxt;
+   struct ArgusAggregatorStruct *agg;
+   struct ArgusInput *input;
+   FILE *part[RACLUSTER_SPILL_PARTITIONS];
+   unsigned int partitions, respills;
+   long long aggs, records, bytes, peak;
+
+   FILE *runs[RACLUSTER_SPILL_MAXRUNS];
+   struct ArgusRecordStruct *heads[RACLUSTER_SPILL_MAXRUNS];
+   int nruns;
+};
+
+static long long RaClusterSpillMax = 0;
+static char *RaClusterSpillDir = NULL;
+static struct RaClusterSpillStruct *RaClusterSpillList = NULL;
+static struct ArgusInput *RaClusterSpillInput = NULL;
+static char RaClusterSpillBuffer[ARGUS_MAXRECORDSIZE];
+static unsigned int RaClusterSpillKey[256 / sizeof(unsigned int)];      /* RA_HASHSIZE */
+
+static struct ArgusRecordStruct *RaClusterInsertRecord (struct ArgusParserStruct *, struct ArgusAggregatorStruct *, struct ArgusRecordStruct *, struct ArgusRecordStruct *);
+static void RaClusterSpill (struct ArgusParserStruct *, struct ArgusAggregatorStruct *);
+static void RaClusterSpillRecord (struct ArgusParserStruct *, struct RaClusterSpillStruct *, struct ArgusRecordStruct *, struct ArgusRecordStruct *);
+static struct RaClusterSpillStruct *RaClusterFindSpill (struct ArgusAggregatorStruct *, int);
+static int RaClusterSpillable (struct ArgusAggregatorStruct *);
+static void RaClusterSpillComplete (struct ArgusParserStruct *, struct RaClusterSpillStruct *, int);
+
+#define RACLUSTER_COMPACT_HASHSIZE	0x10000
+#define RACLUSTER_COMPACT_SORTRUN	0x10000
+
+static int RaClusterCompactMode = 0;
+static struct RaClusterCompactTable *RaClusterCompactList = NULL;
+
+static struct RaClusterCompactTable *RaClusterFindCompact (struct ArgusAggregatorStruct *, int);
+static int RaClusterCompactable (struct ArgusAggregatorStruct *);
+static void RaClusterCompactRecord (struct ArgusParserStruct *, struct RaClusterCompactTable *, struct ArgusRecordStruct *, struct ArgusRecordStruct *);
+static void RaClusterCompactComplete (struct ArgusParserStruct *, struct RaClusterCompactTable *, int);
+
 void
 ArgusClientInit (struct ArgusParserStruct *parser)
 {
@@ -98,6 +160,9 @@ ArgusClientInit (struct ArgusParserStruct *parser)
                parser->RaMonMode++;
                correct = 0;
             } else
+            if (!(strncasecmp (mode->mode, "compact", 7)))
+               RaClusterCompactMode++;
+            else
             if (!(strncasecmp (mode->mode, "norep", 5)))
                parser->RaAgMode++;
             else
@@ -122,6 +187,28 @@ ArgusClientInit (struct ArgusParserStruct *parser)
             if (!(strncasecmp (mode->mode, "noman", 5)))
                parser->ArgusPrintMan = 0;
             else
+            if (!(strncasecmp (mode->mode, "spilldir=", 9))) {
+               if (RaClusterSpillDir != NULL)
+                  free(RaClusterSpillDir);
+               RaClusterSpillDir = strdup(&mode->mode[9]);
+            } else
+            if (!(strncasecmp (mode->mode, "spill=", 6))) {
+               char *endptr = NULL;
+               double size = strtod(&mode->mode[6], &endptr);
+
+               if ((endptr == &mode->mode[6]) || (size <= 0))
+                  ArgusLog (LOG_ERR, "ArgusClientInit: spill size %s invalid", &mode->mode[6]);
+
+               switch (*endptr) {
+                  case 'k': case 'K': size *= 1024.0; break;
+                  case 'm': case 'M': size *= 1024.0 * 1024.0; break;
+                  case 'g': case 'G': size *= 1024.0 * 1024.0 * 1024.0; break;
+               }
+
+               RaClusterSpillMax = size / (sizeof(struct ArgusRecordStruct) + sizeof(struct ArgusHashTableHdr) + RACLUSTER_SPILL_DSRBYTES);
+               if (RaClusterSpillMax < 1)
+                  RaClusterSpillMax = 1;
+            } else
             if (!(strncasecmp (mode->mode, "replace", 7))) {
                ArgusProcessFileIndependantly = 1;
                parser->ArgusReplaceMode |= ARGUS_REPLACE_MODE_TRUE;
@@ -168,6 +255,27 @@ ArgusClientInit (struct ArgusParserStruct *parser)
          }
       }
       
+      if (RaClusterCompactMode) {
+         struct ArgusAggregatorStruct *agg;
+
+         for (agg = parser->ArgusAggregator; agg != NULL; agg = agg->nxt) {
+            if (RaClusterCompactable(agg))
+               RaClusterFindCompact(agg, 1);
+            else
+               ArgusLog (LOG_INFO, "compact disabled for aggregator %s: needs a key, no timers and no -A",
+                                   agg->modeStr ? agg->modeStr : "");
+         }
+      }
+
+      if (RaClusterSpillMax) {
+         struct ArgusAggregatorStruct *agg;
+
+         for (agg = parser->ArgusAggregator; agg != NULL; agg = agg->nxt)
+            if (!(RaClusterSpillable(agg)))
+               ArgusLog (LOG_INFO, "spill disabled for aggregator %s: needs a key with both or neither of each src/dst pair, nocorrect, and no timers",
+                                   agg->modeStr ? agg->modeStr : "");
+      }
+
       if (parser->vflag)
          ArgusReverseSortDir++;
 
@@ -287,9 +395,17 @@ RaParseComplete (int sig)
          }
 
          while (agg != NULL) {
+            struct RaClusterSpillStruct *spill;
+            struct RaClusterCompactTable *ctbl;
             struct ArgusRecordStruct *ns;
             int cnt;
 
+            if ((spill = RaClusterFindSpill(agg, 0)) != NULL) {
+               RaClusterSpillComplete (ArgusParser, spill, nflag);
+            } else
+            if ((ctbl = RaClusterFindCompact(agg, 0)) != NULL) {
+               RaClusterCompactComplete (ArgusParser, ctbl, nflag);
+            } else
             if ((cnt = agg->queue->count) > 0) {
                struct ArgusRecordStruct *argus;
 
@@ -440,619 +556,1855 @@ RaParseComplete (int sig)
 }
 
 
-void
-ArgusIdleClientTimeout ()
+static struct RaClusterSpillStruct *
+RaClusterFindSpill (struct ArgusAggregatorStruct *agg, int create)
 {
-   struct ArgusAggregatorStruct *agg = ArgusParser->ArgusAggregator;
-
-   while (agg) {
-      struct ArgusRecordStruct *ns = NULL;
-
-      if (agg->idleint > 0) {
-         while ((ns = (struct ArgusRecordStruct *) agg->queue->start) != NULL) {
-            double nslt = ArgusFetchLastTime(ns);
-            double glt  = (double)(ArgusParser->ArgusGlobalTime.tv_sec * 1.0) + (double)(ArgusParser->ArgusGlobalTime.tv_usec/1000000.0);
+   struct RaClusterSpillStruct *spill;
+
+   for (spill = RaClusterSpillList; spill != NULL; spill = spill->nxt)
+      if (spill->agg == agg)
+         return (spill);
+
+   if (create) {
+      if ((spill = ArgusCalloc(1, sizeof(*spill))) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterFindSpill: ArgusCalloc error %s", strerror(errno));
+      spill->agg = agg;
+      spill->nxt = RaClusterSpillList;
+      RaClusterSpillList = spill;
+   }
+   return (spill);
+}
 
-            if ((glt - nslt) >= agg->idleint) {
-               ns = (void *) ArgusPopQueue(agg->queue, ARGUS_LOCK);
-               RaSendArgusRecord(ns);
-               ArgusDeleteRecordStruct (ArgusParser, ns);
+static void
+RaClusterDeleteSpill (struct RaClusterSpillStruct *spill)
+{
+   struct RaClusterSpillStruct **sptr;
+   int i;
 
-            } else
-               break;
-         }
+   for (sptr = &RaClusterSpillList; *sptr != NULL; sptr = &(*sptr)->nxt) {
+      if (*sptr == spill) {
+         *sptr = spill->nxt;
+         break;
       }
+   }
 
-      agg = agg->nxt;
+   for (i = 0; i < RACLUSTER_SPILL_PARTITIONS; i++)
+      if (spill->part[i] != NULL)
+         fclose(spill->part[i]);
+
+   for (i = 0; i < spill->nruns; i++) {
+      if (spill->heads[i] != NULL)
+         ArgusDeleteRecordStruct(ArgusParser, spill->heads[i]);
+      fclose(spill->runs[i]);
    }
 
-#ifdef ARGUSDEBUG
-   ArgusDebug (6, "ArgusIdleClientTimeout()\n");
-#endif
+   ArgusFree(spill);
 }
 
-void
-ArgusClientTimeout ()
-{
-   struct ArgusAggregatorStruct *agg = ArgusParser->ArgusAggregator;
+/* spill files are unlinked as soon as they are opened, so they go away with the process */
 
-   if ((agg != NULL) && (agg->statusint > 0)) {
-      int count, i;
+static FILE *
+RaClusterSpillFile (void)
+{
+   char path[MAXSTRLEN], *dir = RaClusterSpillDir;
+   FILE *fp;
+   int fd;
 
-#if defined(ARGUS_THREADS)
-      pthread_mutex_lock(&agg->queue->lock);
-#endif
+   if ((dir == NULL) && ((dir = getenv("TMPDIR")) == NULL))
+      dir = "/tmp";
 
-      if ((count = agg->queue->count) > 0) {
-         struct ArgusRecordStruct *ns = (struct ArgusRecordStruct *) agg->queue->start;
+   snprintf (path, MAXSTRLEN, "%s/racluster.XXXXXX", dir);
+   if ((fd = mkstemp(path)) < 0)
+      ArgusLog (LOG_ERR, "RaClusterSpillFile: mkstemp %s error %s", path, strerror(errno));
 
-         for (i = 0; i < count; i++) {
-            double nsst = ArgusFetchStartTime(ns);
-            double glt  = (double)(ArgusParser->ArgusGlobalTime.tv_sec * 1.0) + (double)(ArgusParser->ArgusGlobalTime.tv_usec/1000000.0);
+   unlink(path);
 
-            if (agg->statusint && ((glt - nsst) >= agg->statusint))
-               RaSendArgusRecord(ns);
+   if ((fp = fdopen(fd, "w+")) == NULL)
+      ArgusLog (LOG_ERR, "RaClusterSpillFile: fdopen error %s", strerror(errno));
 
-            ns = (struct ArgusRecordStruct *) ns->qhdr.nxt;
-         }
-      }
+   return (fp);
+}
 
-#if defined(ARGUS_THREADS)
-      pthread_mutex_unlock(&agg->queue->lock);
-#endif
-   }
+/*
+ * Each record in a spill file follows a RaClusterSpillHdr, and the
+ * hash table key if it is an aggregate, all in host byte order.  The
+ * header keeps what ArgusGenerateRecord() doesn't, the record status
+ * and its original length, which decide how the record is written out,
+ * the flow subtype, as ArgusGenerateRecordStruct() would swap the
+ * addresses of a flow marked ARGUS_REVERSE, and the record's file
+ * offset.  It also carries the record's arrival sequence and partition
+ * hash, which are kept in the record's seq and khash while it is read
+ * back.
+ */
 
+#define RACLUSTER_SPILL_AGGREGATE	0x01
 
-#ifdef ARGUSDEBUG
-   ArgusDebug (1, "ArgusClientTimeout()\n");
-#endif
-}
+struct RaClusterSpillHdr {
+   long long seq, offset;
+   unsigned long long khash;
+   unsigned int status, hash;
+   unsigned short len, klen;
+   unsigned char fsubtype, type, pad[2];
+};
 
-void
-parse_arg (int argc, char**argv)
-{}
+/*
+ * Generate ns into RaClusterSpillBuffer, as ArgusGenerateRecord()
+ * does for output, and fill in its header.  Returns the record length.
+ */
 
-void
-usage ()
+static int
+RaClusterSpillEncode (struct ArgusRecordStruct *ns, struct ArgusHashStruct *key, int type, struct RaClusterSpillHdr *hdr)
 {
-   extern char version[];  
-          
-   fprintf (stdout, "Racluster Version %s\n", version);
-   fprintf (stdout, "usage:  %s [-f racluster.conf]\n", ArgusParser->ArgusProgramName);
-   fprintf (stdout, "usage:  %s [-f racluster.conf] [ra-options] [- filter-expression]\n\n", ArgusParser->ArgusProgramName);
-   fprintf (stdout, "options:  -f <racluster.conf>      read aggregation rules from <racluster.conf>.\n");
-   fprintf (stdout, "          -m flow key fields       specify fields to be used as flow keys.\n");
-   fprintf (stdout, "          -M modes                 modify mode of operation.\n");
-   fprintf (stdout, "             Available modes:      \n");
-   fprintf (stdout, "                correct            turn on direction correction (default)\n");
-   fprintf (stdout, "                nocorrect          turn off direction correction\n");
-   fprintf (stdout, "                ind                aggregate multiple files independently\n");
-   fprintf (stdout, "                norep              do not report aggregation statistics\n");
-   fprintf (stdout, "                rmon               convert bi-directional data into rmon in/out data\n");
-   fprintf (stdout, "                replace            replace input files with aggregation output\n");
-   fprintf (stdout, "          -V                       verbose mode.\n");
-   fflush (stdout);
-
-   exit(1); 
-}
+   struct ArgusAggregatorStruct *agg = ArgusParser->ArgusAggregator;
+   struct ArgusFlow *flow = (struct ArgusFlow *) ns->dsrs[ARGUS_FLOW_INDEX];
+   struct ArgusRecord *argusrec;
+   unsigned char fsubtype = 0;
+   int len = 0;
 
+/*
+ * ArgusGenerateRecord() leaves out single record AGR DSRs when there
+ * is an aggregator, and ArgusGenerateRecordStruct() doesn't rebuild
+ * them quite the same, so keep them.
+ */
 
-void RaProcessThisRecord (struct ArgusParserStruct *, struct ArgusRecordStruct *);
+   if (flow != NULL) {
+      fsubtype = flow->hdr.subtype;
+      flow->hdr.subtype &= ~ARGUS_REVERSE;
+   }
 
-void
-RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *ns)
-{
-   {
-      double nowTime = ArgusFetchStartTime(ns);
-      if (parser->ArgusLastRecordTime == 0) {
-         parser->ArgusLastRecordTime = nowTime;
-      } else {
-         if (parser->ArgusLastRecordTime > nowTime)
-            parser->RaSortedInput = 0;
-         parser->ArgusLastRecordTime = nowTime;
+   ArgusParser->ArgusAggregator = NULL;
+   argusrec = ArgusGenerateRecord (ns, 0L, RaClusterSpillBuffer, ARGUS_VERSION);
+   ArgusParser->ArgusAggregator = agg;
+
+   if (flow != NULL)
+      flow->hdr.subtype = fsubtype;
+
+   if (argusrec != NULL) {
+      len = argusrec->hdr.len * 4;
+
+      bzero (hdr, sizeof(*hdr));
+      hdr->seq    = ns->seq;
+      hdr->offset = ns->offset;
+      hdr->khash  = ns->khash;
+      hdr->status = ns->status;
+      hdr->len    = ns->hdr.len;
+      hdr->fsubtype = fsubtype;
+      hdr->type   = type;
+      if ((key != NULL) && (key->buf != NULL)) {
+         hdr->hash = key->hash;
+         hdr->klen = key->len;
       }
    }
+   return (len);
+}
 
-   switch (ns->hdr.type & 0xF0) {
-      case ARGUS_EVENT:
-      case ARGUS_MAR:
-         break;
+static int
+RaClusterSpillWrite (FILE *fp, struct ArgusRecordStruct *ns, struct ArgusHashStruct *key, int type)
+{
+   struct RaClusterSpillHdr hdr;
+   int len;
 
-      case ARGUS_NETFLOW:
-      case ARGUS_AFLOW:
-      case ARGUS_FAR: {
-         struct ArgusFlow *flow = (struct ArgusFlow *) ns->dsrs[ARGUS_FLOW_INDEX];
+   if ((len = RaClusterSpillEncode (ns, key, type, &hdr)) > 0) {
+      if ((fwrite (&hdr, sizeof(hdr), 1, fp) != 1) || (hdr.klen && (fwrite (key->buf, hdr.klen, 1, fp) != 1)) ||
+          (fwrite (RaClusterSpillBuffer, len, 1, fp) != 1))
+         ArgusLog (LOG_ERR, "RaClusterSpillWrite: fwrite error %s", strerror(errno));
 
-         ArgusIdleClientTimeout();
+      len += sizeof(hdr) + hdr.klen;
+   }
+   return (len);
+}
 
-         if (parser->Vflag || parser->Aflag) {
-            ArgusProcessServiceAvailability(parser, ns);
-            if (parser->xflag) {
-               if ((parser->vflag && (ns->status & RA_SVCPASSED)) ||
-                  (!parser->vflag && (ns->status & RA_SVCFAILED))) {
-#ifdef ARGUSDEBUG
-                  ArgusDebug (3, "RaProcessRecord (0x%x, 0x%x) service test failed", parser, ns); 
-#endif
-                  return;
-               }
-            }
-         }
+static struct ArgusInput *
+RaClusterSpillNewInput (void)
+{
+   struct ArgusInput *input;
 
-         if (parser->ArgusNormalize) {
-            RaMatrixNormalizeEtherAddrs(ns);
-         }
+   if ((input = ArgusCalloc(1, sizeof(*input))) == NULL)
+      ArgusLog (LOG_ERR, "RaClusterSpillNewInput: ArgusCalloc error %s", strerror(errno));
+   input->major_version = MAJOR_VERSION_5;
+   return (input);
+}
 
-         if (parser->RaMonMode && (flow != NULL)) {
-            struct ArgusRecordStruct *tns = ArgusCopyRecordStruct(ns);
-            struct ArgusFlow *flow;
+static void
+RaClusterSpillRestore (struct ArgusRecordStruct *ns, struct RaClusterSpillHdr *hdr)
+{
+   struct ArgusFlow *flow = (struct ArgusFlow *) ns->dsrs[ARGUS_FLOW_INDEX];
+
+   ns->status  = hdr->status;
+   ns->hdr.len = hdr->len;
+   ns->seq     = hdr->seq;
+   ns->offset  = hdr->offset;
+   ns->khash   = hdr->khash;
+   if (flow != NULL)
+      flow->hdr.subtype = hdr->fsubtype;
+}
 
-            if ((flow = (void *)ns->dsrs[ARGUS_FLOW_INDEX]) != NULL) {
-               flow->hdr.subtype &= ~ARGUS_REVERSE;
-               flow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
-            }
+/* returns a copy of the record in RaClusterSpillBuffer, as it was written */
 
-            RaProcessThisRecord(parser, ns);
+static struct ArgusRecordStruct *
+RaClusterSpillDecode (struct RaClusterSpillHdr *hdr)
+{
+   struct ArgusRecordStruct *argus, *ns = NULL;
 
-            ArgusReverseRecord(tns);
+   if (RaClusterSpillInput == NULL)
+      RaClusterSpillInput = RaClusterSpillNewInput();
 
-            if ((flow = (void *)tns->dsrs[ARGUS_FLOW_INDEX]) != NULL) {
-               flow->hdr.subtype &= ~ARGUS_REVERSE;
-               flow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
-            }
+   if ((argus = ArgusGenerateRecordStruct (ArgusParser, RaClusterSpillInput, (struct ArgusRecord *) RaClusterSpillBuffer)) != NULL) {
+      if ((ns = ArgusCopyRecordStruct(argus)) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterSpillDecode: ArgusCopyRecordStruct error %s", strerror(errno));
+      RaClusterSpillRestore (ns, hdr);
+   }
+   return (ns);
+}
 
-            RaProcessThisRecord(parser, tns);
-            ArgusDeleteRecordStruct(parser, tns);
-            
-         } else {
-            struct ArgusAggregatorStruct *agg = parser->ArgusAggregator;
-         
-            if (flow && agg && agg->ArgusMatrixMode) {
-               if (agg->mask & ((0x01LL << ARGUS_MASK_SADDR) | (0x01LL << ARGUS_MASK_DADDR))) {
-                  switch (flow->hdr.subtype & 0x3F) {
-                     case ARGUS_FLOW_LAYER_3_MATRIX:
-                     case ARGUS_FLOW_CLASSIC5TUPLE: {
-                        switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
-                           case ARGUS_TYPE_IPV4: {
-                              if (flow->ip_flow.ip_src > flow->ip_flow.ip_dst) 
-                                 ArgusReverseRecord(ns);
-                           }
-                           break; 
+/* returns a copy of the record, as it was written, its type, and its key in RaClusterSpillKey */
 
-                           case ARGUS_TYPE_IPV6: {
-                              int i;
-                              for (i = 0; i < 4; i++) {
-                                 if (flow->ipv6_flow.ip_src[i] < flow->ipv6_flow.ip_dst[i])
-                                    break;
+static struct ArgusRecordStruct *
+RaClusterSpillRead (FILE *fp, int *type, struct ArgusHashStruct *key)
+{
+   struct ArgusRecord *argusrec = (struct ArgusRecord *) RaClusterSpillBuffer;
+   struct ArgusRecordStruct *ns = NULL;
+   struct RaClusterSpillHdr hdr;
+   int len;
 
-                                 if (flow->ipv6_flow.ip_src[i] > flow->ipv6_flow.ip_dst[i]) {
-                                    ArgusReverseRecord(ns);
-                                    break;
-                                 }
-                              }
-                           }
-                           break; 
-                        }
-                        break; 
-                     }
+   if (fread (&hdr, sizeof(hdr), 1, fp) != 1)
+      return (NULL);
 
-                     default:
-                        break; 
-                  }
+   if (hdr.klen > sizeof(RaClusterSpillKey))
+      ArgusLog (LOG_ERR, "RaClusterSpillRead: bad key length %d", hdr.klen);
 
-               } else 
-               if (agg->mask & ((0x01LL << ARGUS_MASK_SMAC) | (0x01LL << ARGUS_MASK_DMAC))) {
+   if (hdr.klen && (fread (RaClusterSpillKey, hdr.klen, 1, fp) != 1))
+      ArgusLog (LOG_ERR, "RaClusterSpillRead: short read %s", strerror(errno));
 
-                  struct ArgusMacStruct *m1 = NULL;
-                  if ((m1 = (struct ArgusMacStruct *) ns->dsrs[ARGUS_MAC_INDEX]) != NULL) {
-                     switch (m1->hdr.subtype) {
-                        default:
-                        case ARGUS_TYPE_ETHER: {
-                           struct ether_header *e1 = &m1->mac.mac_union.ether.ehdr;
-                           int i;
+   if (fread (&argusrec->hdr, sizeof(argusrec->hdr), 1, fp) != 1)
+      ArgusLog (LOG_ERR, "RaClusterSpillRead: short read %s", strerror(errno));
 
-                           for (i = 0; i < 6; i++) {
-#if defined(ARGUS_SOLARIS)
-                              if (e1->ether_shost.ether_addr_octet[i] < e1->ether_dhost.ether_addr_octet[i])
-                                 break;
-                              if (e1->ether_shost.ether_addr_octet[i] > e1->ether_dhost.ether_addr_octet[i]) {
-                                 ArgusReverseRecord(ns);
-                                 break;
-                              }
-#else
-                              if (e1->ether_shost[i] < e1->ether_dhost[i])
-                                 break;
-                              if (e1->ether_shost[i] > e1->ether_dhost[i]) {
-                                 ArgusReverseRecord(ns);
-                                 break;
-                              }
-#endif
-                           }
-                           break;
-                        }
-                     }
-                  }
-               }
+   len = argusrec->hdr.len * 4;
+   if ((len <= sizeof(argusrec->hdr)) || (len > ARGUS_MAXRECORDSIZE))
+      ArgusLog (LOG_ERR, "RaClusterSpillRead: bad record length %d", len);
 
-               flow->hdr.subtype &= ~ARGUS_REVERSE;
-               flow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
-            }
+   if (fread (&RaClusterSpillBuffer[sizeof(argusrec->hdr)], len - sizeof(argusrec->hdr), 1, fp) != 1)
+      ArgusLog (LOG_ERR, "RaClusterSpillRead: short read %s", strerror(errno));
 
-            RaProcessThisRecord(parser, ns);
-         }
-         break;
-      }
+   ns = RaClusterSpillDecode (&hdr);
+
+   if (type != NULL)
+      *type = hdr.type;
+   if (key != NULL) {
+      key->buf  = hdr.klen ? RaClusterSpillKey : NULL;
+      key->len  = hdr.klen;
+      key->hash = hdr.hash;
    }
+   return (ns);
 }
 
+/*
+ * The partition has to be the same for a flow and its reverse, so that
+ * bi-directional correction still finds both halves when the partition
+ * is re-aggregated, so take the smaller of the forward and reverse key
+ * hashes.  That only works when the reverse of a key is itself a key,
+ * i.e. the mask has both or neither of each src/dst pair, or there is
+ * no correction.  Otherwise which aggregate a record joins depends on
+ * the order the records arrive, and the table can't be partitioned.
+ */
 
-void
-RaProcessThisRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
+static const int RaClusterMaskPairs[][2] = {
+   { ARGUS_MASK_SMPLS, ARGUS_MASK_DMPLS }, { ARGUS_MASK_SVLAN, ARGUS_MASK_DVLAN },
+   { ARGUS_MASK_SADDR, ARGUS_MASK_DADDR }, { ARGUS_MASK_SPORT, ARGUS_MASK_DPORT },
+   { ARGUS_MASK_SNET,  ARGUS_MASK_DNET  }, { ARGUS_MASK_STOS,  ARGUS_MASK_DTOS  },
+   { ARGUS_MASK_STTL,  ARGUS_MASK_DTTL  }, { ARGUS_MASK_SIPID, ARGUS_MASK_DIPID },
+   { ARGUS_MASK_STCPB, ARGUS_MASK_DTCPB }, { ARGUS_MASK_SMAC,  ARGUS_MASK_DMAC  },
+   { ARGUS_MASK_SVID,  ARGUS_MASK_DVID  }, { ARGUS_MASK_SVPRI, ARGUS_MASK_DVPRI },
+   { ARGUS_MASK_SDSB,  ARGUS_MASK_DDSB  }, { ARGUS_MASK_SCO,   ARGUS_MASK_DCO   },
+   { ARGUS_MASK_SAS,   ARGUS_MASK_DAS   }, { ARGUS_MASK_SOUI,  ARGUS_MASK_DOUI  },
+};
+
+static int
+RaClusterSpillable (struct ArgusAggregatorStruct *agg)
 {
-   struct ArgusAggregatorStruct *agg = parser->ArgusAggregator;
-   struct ArgusHashStruct *hstruct = NULL;
-   int found = 0;
+   int i;
 
-   if (agg != NULL) {
-      while (agg && !found) {
-         int retn = 0, fretn = -1, lretn = -1;
+   if (!(agg->mask) || (agg->statusint > 0) || (agg->idleint > 0))
+      return (0);
 
-         if (agg->filterstr) {
-            struct nff_insn *fcode = agg->filter.bf_insns;
-            fretn = ArgusFilterRecord (fcode, argus);
+   if ((agg->correct != NULL) && !(ArgusParser->RaMonMode)) {
+      for (i = 0; i < sizeof(RaClusterMaskPairs)/sizeof(RaClusterMaskPairs[0]); i++) {
+         int s = (agg->mask & (0x01LL << RaClusterMaskPairs[i][0])) ? 1 : 0;
+         int d = (agg->mask & (0x01LL << RaClusterMaskPairs[i][1])) ? 1 : 0;
+         if (s != d)
+            return (0);
+      }
+   }
+   return (1);
+}
+
+/*
+ * ns has to have been masked already, with agg->fstruct still holding
+ * its flow, as RaClusterInsertRecord() leaves a new aggregate.  The
+ * partition hash is taken over the whole key, as the table hash is
+ * too weak to split a partition again.
+ */
+
+static unsigned long long
+RaClusterKeyHash (struct ArgusAggregatorStruct *agg, struct ArgusRecordStruct *ns)
+{
+   struct ArgusFlow *flow = (struct ArgusFlow *) ns->dsrs[ARGUS_FLOW_INDEX];
+   struct ArgusHashStruct *hstruct;
+   unsigned long long hash = 0, rhash;
+   long long mask = agg->mask;
+
+/*
+ * icmp types and codes are carried in the port fields, and a request
+ * matches the reverse of its reply, so leave them out of the partition
+ * key.
+ */
+
+   if ((flow != NULL) && ((flow->hdr.subtype & 0x3F) == ARGUS_FLOW_CLASSIC5TUPLE)) {
+      int proto = -1;
+
+      switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+         case ARGUS_TYPE_IPV4: proto = flow->ip_flow.ip_p; break;
+         case ARGUS_TYPE_IPV6: proto = flow->ipv6_flow.ip_p; break;
+      }
+      if ((proto == IPPROTO_ICMP) || (proto == IPPROTO_ICMPV6))
+         agg->mask &= ~((0x01LL << ARGUS_MASK_SPORT) | (0x01LL << ARGUS_MASK_DPORT));
+   }
+
+   if ((hstruct = ArgusGenerateHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
+      hash = ArgusSketchHash(hstruct->buf, hstruct->len);
+
+   if ((agg->correct != NULL) && (ns->dsrs[ARGUS_FLOW_INDEX] != NULL))
+      if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
+         if ((rhash = ArgusSketchHash(hstruct->buf, hstruct->len)) < hash)
+            hash = rhash;
+
+   agg->mask = mask;
+   return (hash);
+}
+
+/* each level spreads the keys with its own seed */
+
+static unsigned int
+RaClusterHashPartition (unsigned long long hash, int level)
+{
+   hash += level * 0x9e3779b97f4a7c15ULL;
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+
+   return (hash % RACLUSTER_SPILL_PARTITIONS);
+}
+
+static unsigned long long
+RaClusterPartition (struct ArgusAggregatorStruct *agg, struct ArgusRecordStruct *ns)
+{
+   if ((agg->rap = RaFlowModelOverRides(agg, ns)) == NULL)
+      agg->rap = agg->drap;
+
+   ArgusGenerateNewFlow(agg, ns);
+   agg->ArgusMaskDefs = NULL;
+
+   return (RaClusterKeyHash(agg, ns));
+}
+
+static FILE *
+RaClusterPartitionFile (struct RaClusterSpillStruct *spill, FILE **part, unsigned int p)
+{
+   if (part[p] == NULL) {
+      part[p] = RaClusterSpillFile();
+      spill->partitions++;
+   }
+   return (part[p]);
+}
+
+/*
+ * Write out the aggregator's table, in queue order, over the level's
+ * partitions, and empty it.  An aggregate's flow may have been widened
+ * by the records merged into it, so it goes to the partition of the
+ * record that created it, kept in its khash, and keeps its hash table
+ * key and its sequence.
+ */
+
+static long long
+RaClusterSpillTable (struct ArgusParserStruct *parser, struct RaClusterSpillStruct *spill, FILE **part, int level)
+{
+   struct ArgusAggregatorStruct *agg = spill->agg;
+   struct ArgusRecordStruct *ns;
+   long long bytes = 0;
+   FILE *fp;
+
+   while ((ns = (struct ArgusRecordStruct *) ArgusPopQueue(agg->queue, ARGUS_LOCK)) != NULL) {
+      fp = RaClusterPartitionFile(spill, part, RaClusterHashPartition(ns->khash, level));
+      bytes += RaClusterSpillWrite(fp, ns, ns->htblhdr ? &ns->htblhdr->hstruct : NULL, RACLUSTER_SPILL_AGGREGATE);
+      ArgusDeleteRecordStruct(parser, ns);
+   }
+   return (bytes);
+}
+
+/*
+ * The first spill of the table.  The aggregates take the first sequence
+ * numbers, the records that follow are numbered from there.
+ */
+
+static void
+RaClusterSpill (struct ArgusParserStruct *parser, struct ArgusAggregatorStruct *agg)
+{
+   struct RaClusterSpillStruct *spill = RaClusterFindSpill(agg, 1);
+   struct ArgusQueueHeader *qhdr;
+   int i;
+
+   spill->peak = agg->queue->count;
+
+   if ((qhdr = agg->queue->start) != NULL) {
+      for (i = 0; i < agg->queue->count; i++, qhdr = qhdr->nxt) {
+         struct ArgusRecordStruct *ns = (struct ArgusRecordStruct *) qhdr;
+         if (spill->input == NULL)
+            spill->input = ns->input;
+         ns->seq = spill->aggs++;
+      }
+   }
+
+   spill->bytes += RaClusterSpillTable (parser, spill, spill->part, 0);
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaClusterSpill(%p, %p) %lld aggregates %lld bytes\n", parser, agg, spill->aggs, spill->bytes);
+#endif
+}
+
+/*
+ * Once spilled, the records are written out as they came in, argus
+ * before any masking, and ns only serves to find the partition.
+ */
+
+static void
+RaClusterSpillRecord (struct ArgusParserStruct *parser, struct RaClusterSpillStruct *spill, struct ArgusRecordStruct *argus, struct ArgusRecordStruct *ns)
+{
+   unsigned long long khash = RaClusterPartition(spill->agg, ns);
+   FILE *fp = RaClusterPartitionFile(spill, spill->part, RaClusterHashPartition(khash, 0));
+
+   argus->seq = spill->aggs + spill->records++;
+   argus->khash = khash;
+   spill->bytes += RaClusterSpillWrite(fp, argus, NULL, 0);
+   ArgusDeleteRecordStruct(parser, ns);
+}
+
+static int
+RaClusterSpillCompare (struct ArgusRecordStruct *n1, struct ArgusRecordStruct *n2)
+{
+   int retn = 0;
+
+   if (ArgusSorter->ArgusSortAlgorithms[0] != NULL)
+      retn = ArgusSortRoutine (&n1, &n2);
+
+   if (retn == 0)
+      retn = (n1->seq < n2->seq) ? -1 : ((n1->seq > n2->seq) ? 1 : 0);
+
+   return (retn);
+}
+
+static struct ArgusRecordStruct *
+RaClusterSpillNext (struct RaClusterSpillStruct *spill, FILE *fp)
+{
+   struct ArgusRecordStruct *ns = NULL;
+
+   if ((fp != NULL) && ((ns = RaClusterSpillRead(fp, NULL, NULL)) != NULL))
+      ns->input = spill->input;
+
+   return (ns);
+}
+
+/*
+ * Merge the sorted runs into out, up to count records, or all of them
+ * when count is negative.  If out is NULL, the records are ranked and
+ * sent to RaSendArgusRecord() instead.
+ */
+
+static int
+RaClusterSpillMergeRuns (struct ArgusParserStruct *parser, struct RaClusterSpillStruct *spill, FILE *out, int count, struct ArgusRecordStruct *total)
+{
+   struct ArgusRecordStruct *ns;
+   int i, p;
+
+   for (p = 0; p < spill->nruns; p++)
+      if (spill->heads[p] == NULL)
+         spill->heads[p] = RaClusterSpillNext(spill, spill->runs[p]);
+
+   for (i = 0; (count < 0) || (i < count); i++) {
+      int min = -1;
+
+      for (p = 0; p < spill->nruns; p++)
+         if ((spill->heads[p] != NULL) && ((min < 0) || (RaClusterSpillCompare(spill->heads[p], spill->heads[min]) < 0)))
+            min = p;
+
+      if (min < 0)
+         break;
+
+      ns = spill->heads[min];
+      spill->heads[min] = RaClusterSpillNext(spill, spill->runs[min]);
+
+      if (out != NULL)
+         RaClusterSpillWrite (out, ns, NULL, 0);
+      else {
+         ns->rank = i;
+         if ((parser->eNoflag == 0 ) || ((parser->eNoflag >= (total->rank + 1)) && (parser->sNoflag <= (total->rank + 1))))
+            RaSendArgusRecord (ns);
+      }
+      ArgusDeleteRecordStruct(parser, ns);
+   }
+   return (i);
+}
+
+/*
+ * Runs are kept open until the final merge, so when there are too many,
+ * as after many respills, merge them into one.
+ */
+
+static FILE *
+RaClusterSpillNewRun (struct ArgusParserStruct *parser, struct RaClusterSpillStruct *spill)
+{
+   if (spill->nruns == RACLUSTER_SPILL_MAXRUNS) {
+      FILE *run = RaClusterSpillFile();
+      int p;
+
+      RaClusterSpillMergeRuns (parser, spill, run, -1, NULL);
+
+      for (p = 0; p < spill->nruns; p++)
+         fclose (spill->runs[p]);
+
+      rewind (run);
+      spill->runs[0] = run;
+      spill->nruns = 1;
+   }
+   return (spill->runs[spill->nruns++] = RaClusterSpillFile());
+}
+
+/*
+ * Re-aggregate a partition in memory, in the order the records were
+ * written.  If the table grows past RaClusterSpillMax again, it is
+ * spilled over the next level's partitions, along with the rest of the
+ * partition, and each of those is done the same way.  Otherwise the
+ * table is sorted and written out as a sorted run, accumulating the
+ * totals as we go.
+ */
+
+static void
+RaClusterSpillAggregate (struct ArgusParserStruct *parser, struct RaClusterSpillStruct *spill, FILE *fp, int level,
+                         struct ArgusRecordStruct **total, long long *peak, int *cnt)
+{
+   struct ArgusAggregatorStruct *agg = spill->agg;
+   FILE *part[RACLUSTER_SPILL_PARTITIONS], *run;
+   struct ArgusRecordStruct *argus, *ns, *tns;
+   struct ArgusHashStruct key;
+   int p, type, spilled = 0;
+
+   bzero (part, sizeof(part));
+   rewind (fp);
+
+   while ((argus = RaClusterSpillRead(fp, &type, &key)) != NULL) {
+      argus->input = spill->input;
+
+      if (spilled) {
+         FILE *pfp = RaClusterPartitionFile(spill, part, RaClusterHashPartition(argus->khash, level + 1));
+         spill->bytes += RaClusterSpillWrite(pfp, argus, key.len ? &key : NULL, type);
+         ArgusDeleteRecordStruct(parser, argus);
+         continue;
+      }
+
+      if (type & RACLUSTER_SPILL_AGGREGATE) {
+         if (key.len > 0)
+            argus->htblhdr = ArgusAddHashEntry (agg->htable, argus, &key);
+         ArgusAddToQueue (agg->queue, &argus->qhdr, ARGUS_LOCK);
+
+      } else {
+         if ((ns = ArgusCopyRecordStruct(argus)) == NULL)
+            ArgusLog (LOG_ERR, "RaClusterSpillAggregate: ArgusCopyRecordStruct error %s", strerror(errno));
+         if (agg->labelstr)
+            ArgusAddToRecordLabel(parser, ns, agg->labelstr);
+         if ((tns = RaClusterInsertRecord (parser, agg, argus, ns)) != NULL) {
+            tns->seq = argus->seq;
+            if (tns == ns)
+               tns->khash = argus->khash;
+         }
+         ArgusDeleteRecordStruct(parser, argus);
+      }
+
+      if ((agg->queue->count > RaClusterSpillMax) && (level < RACLUSTER_SPILL_MAXLEVEL)) {
+         if (agg->queue->count > *peak)
+            *peak = agg->queue->count;
+         spill->bytes += RaClusterSpillTable (parser, spill, part, level + 1);
+         spill->respills++;
+         spilled = 1;
+      }
+   }
+   fclose (fp);
+
+   if (spilled) {
+      for (p = 0; p < RACLUSTER_SPILL_PARTITIONS; p++)
+         if (part[p] != NULL)
+            RaClusterSpillAggregate (parser, spill, part[p], level + 1, total, peak, cnt);
+      return;
+   }
+
+   if (agg->queue->count > *peak)
+      *peak = agg->queue->count;
+
+   if (agg->queue->count > 1)
+      ArgusSortQueue (ArgusSorter, agg->queue, ARGUS_LOCK);
+
+   run = RaClusterSpillNewRun(parser, spill);
+
+   while ((ns = (struct ArgusRecordStruct *) ArgusPopQueue(agg->queue, ARGUS_LOCK)) != NULL) {
+      if (*total == NULL)
+         *total = ArgusCopyRecordStruct(ns);
+      else
+         ArgusMergeRecords (agg, *total, ns);
+
+      RaClusterSpillWrite (run, ns, NULL, 0);
+      ArgusDeleteRecordStruct(parser, ns);
+      (*cnt)++;
+   }
+   rewind (run);
+}
+
+/*
+ * Re-aggregate each partition, then merge the sorted runs to produce
+ * the same output as RaParseComplete() does for the in-memory table.
+ */
+
+static void
+RaClusterSpillComplete (struct ArgusParserStruct *parser, struct RaClusterSpillStruct *spill, int nflag)
+{
+   struct ArgusRecordStruct *total = NULL;
+   struct ArgusModeStruct *mode = NULL;
+   struct timeval start, now, diff;
+   long long peak = 0;
+   int i, x, p, cnt = 0;
+
+   gettimeofday (&start, NULL);
+
+   if (!(ArgusSorter))
+      if ((ArgusSorter = ArgusNewSorter(parser)) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterSpillComplete: ArgusNewSorter error %s", strerror(errno));
+
+   if ((mode = parser->ArgusMaskList) != NULL) {
+      for (i = 0; mode && (i < ARGUS_MAX_SORT_ALG); mode = mode->nxt) {
+         for (x = 0; x < MAX_SORT_ALG_TYPES; x++) {
+            if (ArgusSortKeyWords[x] != NULL) {
+               if (!strncmp (ArgusSortKeyWords[x], mode->mode, strlen(ArgusSortKeyWords[x]))) {
+                  ArgusSorter->ArgusSortAlgorithms[i++] = ArgusSortAlgorithmTable[x];
+                  break;
+               }
+            }
+         }
+      }
+   }
+
+   for (p = 0; p < RACLUSTER_SPILL_PARTITIONS; p++) {
+      if (spill->part[p] != NULL) {
+         RaClusterSpillAggregate (parser, spill, spill->part[p], 0, &total, &peak, &cnt);
+         spill->part[p] = NULL;
+      }
+   }
+
+   parser->ns = total;
+
+   if (nflag <= 0)
+      parser->eNflag = cnt;
+   else
+      parser->eNflag = nflag > cnt ? cnt : nflag;
+
+   RaClusterSpillMergeRuns (parser, spill, NULL, parser->eNflag, total);
+
+   if (total != NULL)
+      ArgusDeleteRecordStruct(parser, total);
+
+   gettimeofday (&now, NULL);
+   RaDiffTime (&now, &start, &diff);
+
+   ArgusLog (LOG_INFO, "spill: %lld aggregates %lld records %lld KB in %u partitions, %u respills, peak table %lld, peak partition %lld, %d aggregates merged in %d.%06d secs",
+                  spill->aggs, spill->records, spill->bytes / 1024, spill->partitions, spill->respills, spill->peak, peak, cnt,
+                  (int) diff.tv_sec, (int) diff.tv_usec);
+
+   RaClusterDeleteSpill (spill);
+}
+
+/*
+ * Compact mode, -M compact.  A full ArgusRecordStruct, with its
+ * canonical DSRs, hash table entry and queue header, runs to well over
+ * a kilobyte per aggregate, most of it empty.  In compact mode each
+ * aggregate is kept as its hash key followed by the record in the
+ * packed form ArgusGenerateRecord() writes out, usually a couple of
+ * hundred bytes, in a table of its own.  A record is merged by
+ * expanding its aggregate, merging with ArgusMergeRecords() as usual,
+ * and packing the result back, and the aggregates are only expanded
+ * again a run at a time to be sorted and sent.  The spill header keeps
+ * what the packed form doesn't, and its sequence number is the queue
+ * order, so ties in the sort come out as they do for the queue.
+ *
+ * There is no queue to run timers off, so this is for aggregators
+ * without idle or status timers.  Flow correction is done as it is for
+ * the queue, by looking for the reverse key when a record has no
+ * aggregate of its own.
+ */
+
+struct RaClusterCompactStruct {
+   struct RaClusterCompactStruct *nxt;
+   struct RaClusterSpillHdr hdr;
+   unsigned int data[];                  /* key, padded to 4 bytes, then the record */
+};
+
+#define RACLUSTER_COMPACT_KEYLEN(c)	(((c)->hdr.klen + 3) & ~3)
+#define RACLUSTER_COMPACT_RECORD(c)	((struct ArgusRecord *)((char *)(c)->data + RACLUSTER_COMPACT_KEYLEN(c)))
+#define RACLUSTER_COMPACT_SIZE(c)	(sizeof(struct RaClusterCompactStruct) + RACLUSTER_COMPACT_KEYLEN(c) + (RACLUSTER_COMPACT_RECORD(c)->hdr.len * 4))
+
+struct RaClusterCompactTable {
+   struct RaClusterCompactTable *nxt;
+   struct ArgusAggregatorStruct *agg;
+   struct RaClusterCompactStruct **array;
+   unsigned int size, count;
+   long long seq, records, bytes;
+};
+
+static struct RaClusterCompactTable *
+RaClusterFindCompact (struct ArgusAggregatorStruct *agg, int create)
+{
+   struct RaClusterCompactTable *ctbl;
+
+   for (ctbl = RaClusterCompactList; ctbl != NULL; ctbl = ctbl->nxt)
+      if (ctbl->agg == agg)
+         return (ctbl);
+
+   if (create) {
+      if ((ctbl = ArgusCalloc(1, sizeof(*ctbl))) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterFindCompact: ArgusCalloc error %s", strerror(errno));
+      ctbl->size = RACLUSTER_COMPACT_HASHSIZE;
+      if ((ctbl->array = ArgusCalloc(ctbl->size, sizeof(*ctbl->array))) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterFindCompact: ArgusCalloc error %s", strerror(errno));
+      ctbl->agg = agg;
+      ctbl->nxt = RaClusterCompactList;
+      RaClusterCompactList = ctbl;
+   }
+   return (ctbl);
+}
+
+static void
+RaClusterDeleteCompact (struct RaClusterCompactTable *ctbl)
+{
+   struct RaClusterCompactTable **cptr;
+   struct RaClusterCompactStruct *c, *nxt;
+   unsigned int i;
+
+   for (cptr = &RaClusterCompactList; *cptr != NULL; cptr = &(*cptr)->nxt) {
+      if (*cptr == ctbl) {
+         *cptr = ctbl->nxt;
+         break;
+      }
+   }
+
+   for (i = 0; i < ctbl->size; i++) {
+      for (c = ctbl->array[i]; c != NULL; c = nxt) {
+         nxt = c->nxt;
+         ArgusFree(c);
+      }
+   }
+   ArgusFree(ctbl->array);
+   ArgusFree(ctbl);
+}
+
+static int
+RaClusterCompactable (struct ArgusAggregatorStruct *agg)
+{
+   if (!(agg->mask) || (agg->statusint > 0) || (agg->idleint > 0) || ArgusParser->Aflag)
+      return (0);
+
+   return (1);
+}
+
+/* the key hash is a plain sum, so mix it before taking the low bits */
+
+static unsigned int
+RaClusterCompactSlot (unsigned int hash, unsigned int size)
+{
+   hash ^= hash >> 16;
+   hash *= 0x85ebca6b;
+   hash ^= hash >> 13;
+   hash *= 0xc2b2ae35;
+   hash ^= hash >> 16;
+
+   return (hash & (size - 1));
+}
+
+static void
+RaClusterCompactGrow (struct RaClusterCompactTable *ctbl)
+{
+   struct RaClusterCompactStruct **array, *c, *nxt;
+   unsigned int i, size = ctbl->size * 2;
+
+   if ((array = ArgusCalloc(size, sizeof(*array))) == NULL)
+      ArgusLog (LOG_ERR, "RaClusterCompactGrow: ArgusCalloc error %s", strerror(errno));
+
+   for (i = 0; i < ctbl->size; i++) {
+      for (c = ctbl->array[i]; c != NULL; c = nxt) {
+         nxt = c->nxt;
+         c->nxt = array[RaClusterCompactSlot(c->hdr.hash, size)];
+         array[RaClusterCompactSlot(c->hdr.hash, size)] = c;
+      }
+   }
+
+   ArgusFree(ctbl->array);
+   ctbl->array = array;
+   ctbl->size = size;
+}
+
+/*
+ * Returns the link that points to the key's aggregate, or the null one
+ * at the end of its chain.  ArgusFindRecord() compares keys over the
+ * zero filled hash buffer, so a key matches the same key with zeros on
+ * the end, as a reverse icmp key is, and the trailing zeros are trimmed
+ * here so that they match the same way.  The hash is unchanged.
+ */
+
+static struct RaClusterCompactStruct **
+RaClusterCompactLink (struct RaClusterCompactTable *ctbl, struct ArgusHashStruct *hstruct)
+{
+   struct RaClusterCompactStruct **cptr = &ctbl->array[RaClusterCompactSlot(hstruct->hash, ctbl->size)];
+   unsigned short *sptr = (unsigned short *) hstruct->buf;
+
+   while ((hstruct->len >= sizeof(*sptr)) && (sptr[(hstruct->len / sizeof(*sptr)) - 1] == 0))
+      hstruct->len -= sizeof(*sptr);
+
+   for (; *cptr != NULL; cptr = &(*cptr)->nxt)
+      if (((*cptr)->hdr.hash == hstruct->hash) && ((*cptr)->hdr.klen == hstruct->len) &&
+           !(bcmp((*cptr)->data, hstruct->buf, hstruct->len)))
+         break;
+
+   return (cptr);
+}
+
+static struct ArgusRecordStruct *
+RaClusterCompactExpand (struct RaClusterCompactStruct *c)
+{
+   bcopy (RACLUSTER_COMPACT_RECORD(c), RaClusterSpillBuffer, RACLUSTER_COMPACT_RECORD(c)->hdr.len * 4);
+   return (RaClusterSpillDecode (&c->hdr));
+}
+
+/*
+ * Pack ns in place of the aggregate *cptr, reusing its memory when the
+ * packed record is the same size, as it is for most merges.
+ */
+
+static void
+RaClusterCompactStore (struct RaClusterCompactTable *ctbl, struct RaClusterCompactStruct **cptr, struct ArgusRecordStruct *ns, struct ArgusHashStruct *hstruct)
+{
+   struct RaClusterCompactStruct *c = *cptr, *nc;
+   struct RaClusterSpillHdr hdr;
+   int len, klen, size;
+
+   ns->seq = ctbl->seq++;
+   if ((len = RaClusterSpillEncode (ns, hstruct, RACLUSTER_SPILL_AGGREGATE, &hdr)) <= 0)
+      return;
+
+   klen = (hdr.klen + 3) & ~3;
+   size = sizeof(*c) + klen + len;
+
+   if ((c != NULL) && (RACLUSTER_COMPACT_SIZE(c) == size)) {
+      nc = c;
+   } else {
+      if ((nc = ArgusMalloc(size)) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterCompactStore: ArgusMalloc error %s", strerror(errno));
+      bzero (nc->data, klen);
+      bcopy (hstruct->buf, nc->data, hdr.klen);
+
+      if (c != NULL) {
+         nc->nxt = c->nxt;
+         ctbl->bytes -= RACLUSTER_COMPACT_SIZE(c);
+         ArgusFree(c);
+      } else {
+         nc->nxt = NULL;
+         ctbl->count++;
+      }
+      ctbl->bytes += size;
+      *cptr = nc;
+   }
+
+   nc->hdr = hdr;
+   bcopy (RaClusterSpillBuffer, RACLUSTER_COMPACT_RECORD(nc), len);
+}
+
+/* the other half of an icmp request/reply pair, or -1 */
+
+static int
+RaClusterICMPPair (int type)
+{
+   switch (type) {
+      case ICMP_ECHO:          return (ICMP_ECHOREPLY);
+      case ICMP_ECHOREPLY:     return (ICMP_ECHO);
+      case ICMP_ROUTERADVERT:  return (ICMP_ROUTERSOLICIT);
+      case ICMP_ROUTERSOLICIT: return (ICMP_ROUTERADVERT);
+      case ICMP_TSTAMP:        return (ICMP_TSTAMPREPLY);
+      case ICMP_TSTAMPREPLY:   return (ICMP_TSTAMP);
+      case ICMP_IREQ:          return (ICMP_IREQREPLY);
+      case ICMP_IREQREPLY:     return (ICMP_IREQ);
+      case ICMP_MASKREQ:       return (ICMP_MASKREPLY);
+      case ICMP_MASKREPLY:     return (ICMP_MASKREQ);
+   }
+   return (-1);
+}
+
+/*
+ * The compact version of the flow correction in RaClusterInsertRecord(),
+ * for a record with no aggregate of its own.  If the reverse of its key
+ * has one, whichever of the two started the flow, by the same rules,
+ * keeps its direction and the other is turned around.  Returns the
+ * expanded aggregate to merge ns into, with *cptr and *hstruct set to
+ * its link and key, or NULL, leaving them for a new aggregate.
+ */
+
+static struct ArgusRecordStruct *
+RaClusterCompactReverse (struct ArgusParserStruct *parser, struct RaClusterCompactTable *ctbl, struct ArgusRecordStruct *argus,
+                         struct ArgusRecordStruct *ns, struct RaClusterCompactStruct ***cptr, struct ArgusHashStruct **hstruct)
+{
+   struct ArgusFlow *flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX];
+   struct ArgusAggregatorStruct *agg = ctbl->agg;
+   struct ArgusRecordStruct *tns = NULL;
+   struct RaClusterCompactStruct **rptr, *c;
+   struct ArgusHashStruct *rhstruct;
+   int proto = -1, keep = 0;
+
+   if (flow == NULL)
+      return (NULL);
+
+   switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+      case ARGUS_TYPE_IPV4: proto = flow->ip_flow.ip_p; break;
+      case ARGUS_TYPE_IPV6: proto = flow->ipv6_flow.ip_p; break;
+   }
+   if (proto == IPPROTO_ESP)
+      return (NULL);
+
+   if ((rhstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) == NULL)
+      return (NULL);
+
+   rptr = RaClusterCompactLink (ctbl, rhstruct);
+
+   if (*rptr == NULL) {
+      if ((proto == IPPROTO_ICMP) && ((flow->hdr.argus_dsrvl8.qual & 0x1F) == ARGUS_TYPE_IPV4)) {
+         struct ArgusICMPFlow *icmpFlow = &flow->flow_un.icmp;
+         int type = icmpFlow->type, pair = RaClusterICMPPair(type);
+
+         if (ICMP_INFOTYPE(type) && (pair >= 0)) {
+            icmpFlow->type = pair;
+            rhstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct);
+            icmpFlow->type = type;
+
+            if ((rhstruct != NULL) && (*(rptr = RaClusterCompactLink (ctbl, rhstruct)) != NULL)) {
+               if ((tns = RaClusterCompactExpand (*rptr)) != NULL) {
+                  ArgusReverseRecord (ns);
+                  *cptr = rptr;
+                  *hstruct = rhstruct;
+                  keep = 1;
+               }
+            }
+         }
+      }
+
+   } else
+   if ((tns = RaClusterCompactExpand (*rptr)) != NULL) {
+      struct ArgusNetworkStruct *nnet = (struct ArgusNetworkStruct *)ns->dsrs[ARGUS_NETWORK_INDEX];
+      struct ArgusNetworkStruct *tnet = (struct ArgusNetworkStruct *)tns->dsrs[ARGUS_NETWORK_INDEX];
+      int reverse = 0;         /* 1 turns ns around, 2 the aggregate */
+
+      if (proto == IPPROTO_TCP) {
+         if ((nnet != NULL) && (tnet != NULL)) {
+            struct ArgusTCPObject *ntcp = &nnet->net_union.tcp;
+            struct ArgusTCPObject *ttcp = &tnet->net_union.tcp;
+
+            if ((ntcp->status & ARGUS_SAW_SYN) && (ttcp->status & ARGUS_SAW_SYN)) {
+               ArgusDeleteRecordStruct(parser, tns);
+               tns = NULL;
+            } else
+            if ((ntcp->status & ARGUS_SAW_SYN) ||
+               ((ntcp->status & ARGUS_SAW_SYN_SENT) && (ntcp->status & ARGUS_CON_ESTABLISHED)))
+               reverse = 2;
+            else
+               reverse = 1;
+         }
+      } else
+         reverse = (ArgusFetchStartTime(tns) > ArgusFetchStartTime(ns)) ? 2 : 1;
+
+      switch (reverse) {
+         case 0:
+         case 1:
+            if (reverse)
+               ArgusReverseRecord (ns);
+            if (tns != NULL) {
+               *cptr = rptr;
+               *hstruct = rhstruct;
+               keep = 1;
+            }
+            break;
+
+         case 2: {
+            struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
+
+            c = *rptr;
+            *rptr = c->nxt;
+            ctbl->count--;
+            ctbl->bytes -= RACLUSTER_COMPACT_SIZE(c);
+            ArgusFree(c);
+
+            ArgusReverseRecord (tns);
+            if (tflow != NULL) {
+               tflow->hdr.subtype &= ~ARGUS_REVERSE;
+               tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
+            }
+            break;
+         }
+      }
+   }
+
+/* the reverse key shares the forward key's buffer, and unlinking the aggregate can take ns's link with it */
+
+   if (!keep) {
+      *hstruct = ArgusGenerateHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct);
+      *cptr = RaClusterCompactLink (ctbl, *hstruct);
+   }
+
+   return (tns);
+}
+
+/*
+ * The compact version of RaClusterInsertRecord(), without the timers.
+ */
+
+static void
+RaClusterCompactRecord (struct ArgusParserStruct *parser, struct RaClusterCompactTable *ctbl, struct ArgusRecordStruct *argus, struct ArgusRecordStruct *ns)
+{
+   struct ArgusAggregatorStruct *agg = ctbl->agg;
+   struct RaClusterCompactStruct **cptr;
+   struct ArgusHashStruct *hstruct;
+   struct ArgusRecordStruct *tns = NULL;
+
+   if ((agg->rap = RaFlowModelOverRides(agg, ns)) == NULL)
+      agg->rap = agg->drap;
+
+   ArgusGenerateNewFlow(agg, ns);
+   agg->ArgusMaskDefs = NULL;
+
+   if ((hstruct = ArgusGenerateHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL) {
+      cptr = RaClusterCompactLink (ctbl, hstruct);
+
+      if (*cptr != NULL)
+         tns = RaClusterCompactExpand (*cptr);
+      else
+      if ((agg->correct != NULL) && !parser->RaMonMode && parser->ArgusReverse)
+         tns = RaClusterCompactReverse (parser, ctbl, argus, ns, &cptr, &hstruct);
+
+      if (tns != NULL) {
+         ArgusMergeRecords (agg, tns, ns);
+         RaClusterCompactStore (ctbl, cptr, tns, hstruct);
+         ArgusDeleteRecordStruct(parser, tns);
+      } else
+         RaClusterCompactStore (ctbl, cptr, ns, hstruct);
+
+      if (ctbl->count > ctbl->size)
+         RaClusterCompactGrow (ctbl);
+
+      ctbl->records++;
+      agg->status |= ARGUS_AGGREGATOR_DIRTY;
+   }
+
+   ArgusDeleteRecordStruct(parser, ns);
+}
+
+/*
+ * Sorting expands each aggregate once to be compared.  The table is
+ * sorted RACLUSTER_COMPACT_SORTRUN aggregates at a time, and each run
+ * is left in order in the array, so that only their heads need to be
+ * expanded to merge them, as the spill runs are.
+ */
+
+struct RaClusterCompactSortStruct {
+   struct ArgusRecordStruct *ns;
+   struct RaClusterCompactStruct *c;
+};
+
+static int
+RaClusterCompactCompare (const void *void1, const void *void2)
+{
+   struct RaClusterCompactSortStruct *s1 = (struct RaClusterCompactSortStruct *)void1;
+   struct RaClusterCompactSortStruct *s2 = (struct RaClusterCompactSortStruct *)void2;
+
+   return (RaClusterSpillCompare (s1->ns, s2->ns));
+}
+
+/*
+ * Sort the aggregates into runs, totalling them as they are expanded,
+ * then merge the runs and send them, as RaParseComplete() does for the
+ * queue.
+ */
+
+static void
+RaClusterCompactComplete (struct ArgusParserStruct *parser, struct RaClusterCompactTable *ctbl, int nflag)
+{
+   struct ArgusAggregatorStruct *agg = ctbl->agg;
+   struct RaClusterCompactStruct **array, *c;
+   struct RaClusterCompactSortStruct *sort;
+   struct ArgusRecordStruct *ns, **heads, *total = NULL;
+   struct ArgusModeStruct *mode = NULL;
+   unsigned int i, x, n, r, k, cnt = 0, nruns = 0;
+   unsigned int *next, *ends;
+
+   if (ctbl->count > 0) {
+      if (!(ArgusSorter))
+         if ((ArgusSorter = ArgusNewSorter(parser)) == NULL)
+            ArgusLog (LOG_ERR, "RaClusterCompactComplete: ArgusNewSorter error %s", strerror(errno));
+
+      if ((ctbl->count > 1) && ((mode = parser->ArgusMaskList) != NULL)) {
+         for (i = 0; mode && (i < ARGUS_MAX_SORT_ALG); mode = mode->nxt) {
+            for (x = 0; x < MAX_SORT_ALG_TYPES; x++) {
+               if (ArgusSortKeyWords[x] != NULL) {
+                  if (!strncmp (ArgusSortKeyWords[x], mode->mode, strlen(ArgusSortKeyWords[x]))) {
+                     ArgusSorter->ArgusSortAlgorithms[i++] = ArgusSortAlgorithmTable[x];
+                     break;
+                  }
+               }
+            }
+         }
+      }
+
+      n = (ctbl->count < RACLUSTER_COMPACT_SORTRUN) ? ctbl->count : RACLUSTER_COMPACT_SORTRUN;
+      x = (ctbl->count + RACLUSTER_COMPACT_SORTRUN - 1) / RACLUSTER_COMPACT_SORTRUN;
+
+      if ((array = ArgusMalloc(ctbl->count * sizeof(*array))) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterCompactComplete: ArgusMalloc error %s", strerror(errno));
+      if ((sort = ArgusMalloc(n * sizeof(*sort))) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterCompactComplete: ArgusMalloc error %s", strerror(errno));
+      if ((heads = ArgusCalloc(x, sizeof(*heads))) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterCompactComplete: ArgusCalloc error %s", strerror(errno));
+      if ((next = ArgusCalloc(x, sizeof(*next))) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterCompactComplete: ArgusCalloc error %s", strerror(errno));
+      if ((ends = ArgusCalloc(x, sizeof(*ends))) == NULL)
+         ArgusLog (LOG_ERR, "RaClusterCompactComplete: ArgusCalloc error %s", strerror(errno));
+
+      for (i = 0; i < ctbl->size; i++)
+         for (c = ctbl->array[i]; c != NULL; c = c->nxt)
+            array[cnt++] = c;
+
+      for (i = 0, x = 0; i < cnt; i += n) {
+         for (r = i, k = 0; (r < i + n) && (r < cnt); r++) {
+            if ((ns = RaClusterCompactExpand (array[r])) != NULL) {
+               if (total == NULL)
+                  total = ArgusCopyRecordStruct(ns);
+               else
+                  ArgusMergeRecords (agg, total, ns);
+               sort[k].ns = ns;
+               sort[k++].c = array[r];
+            }
+         }
+
+         qsort (sort, k, sizeof(*sort), RaClusterCompactCompare);
+
+         next[nruns] = x;
+         for (r = 0; r < k; r++) {
+            array[x++] = sort[r].c;
+            ArgusDeleteRecordStruct(parser, sort[r].ns);
+         }
+         ends[nruns++] = x;
+      }
+      cnt = x;
+
+      parser->ns = total;
+
+      if (nflag <= 0)
+         parser->eNflag = cnt;
+      else
+         parser->eNflag = nflag > cnt ? cnt : nflag;
+
+      for (r = 0; r < nruns; r++)
+         if (next[r] < ends[r])
+            heads[r] = RaClusterCompactExpand (array[next[r]++]);
+
+      for (i = 0; i < parser->eNflag; i++) {
+         int min = -1;
+
+         for (r = 0; r < nruns; r++)
+            if ((heads[r] != NULL) && ((min < 0) || (RaClusterSpillCompare(heads[r], heads[min]) < 0)))
+               min = r;
+
+         if (min < 0)
+            break;
+
+         ns = heads[min];
+         heads[min] = (next[min] < ends[min]) ? RaClusterCompactExpand (array[next[min]++]) : NULL;
+
+         ns->rank = i;
+         if ((parser->eNoflag == 0 ) || ((parser->eNoflag >= (total->rank + 1)) && (parser->sNoflag <= (total->rank + 1))))
+            RaSendArgusRecord (ns);
+         ArgusDeleteRecordStruct(parser, ns);
+      }
+
+      for (r = 0; r < nruns; r++)
+         if (heads[r] != NULL)
+            ArgusDeleteRecordStruct(parser, heads[r]);
+
+      if (total != NULL)
+         ArgusDeleteRecordStruct(parser, total);
+      parser->ns = NULL;
+
+      ArgusFree(ends);
+      ArgusFree(next);
+      ArgusFree(heads);
+      ArgusFree(sort);
+      ArgusFree(array);
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (1, "RaClusterCompactComplete(%p, %p, %d) %lld records %u aggregates %lld bytes\n", parser, ctbl, nflag, ctbl->records, ctbl->count, ctbl->bytes);
+#endif
+
+   RaClusterDeleteCompact (ctbl);
+}
+
+void
+ArgusIdleClientTimeout ()
+{
+   struct ArgusAggregatorStruct *agg = ArgusParser->ArgusAggregator;
+
+   while (agg) {
+      struct ArgusRecordStruct *ns = NULL;
+
+      if (agg->idleint > 0) {
+         while ((ns = (struct ArgusRecordStruct *) agg->queue->start) != NULL) {
+            double nslt = ArgusFetchLastTime(ns);
+            double glt  = (double)(ArgusParser->ArgusGlobalTime.tv_sec * 1.0) + (double)(ArgusParser->ArgusGlobalTime.tv_usec/1000000.0);
+
+            if ((glt - nslt) >= agg->idleint) {
+               ns = (void *) ArgusPopQueue(agg->queue, ARGUS_LOCK);
+               RaSendArgusRecord(ns);
+               ArgusDeleteRecordStruct (ArgusParser, ns);
+
+            } else
+               break;
+         }
+      }
+
+      agg = agg->nxt;
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (6, "ArgusIdleClientTimeout()\n");
+#endif
+}
+
+void
+ArgusClientTimeout ()
+{
+   struct ArgusAggregatorStruct *agg = ArgusParser->ArgusAggregator;
+
+   if ((agg != NULL) && (agg->statusint > 0)) {
+      int count, i;
+
+#if defined(ARGUS_THREADS)
+      pthread_mutex_lock(&agg->queue->lock);
+#endif
+
+      if ((count = agg->queue->count) > 0) {
+         struct ArgusRecordStruct *ns = (struct ArgusRecordStruct *) agg->queue->start;
+
+         for (i = 0; i < count; i++) {
+            double nsst = ArgusFetchStartTime(ns);
+            double glt  = (double)(ArgusParser->ArgusGlobalTime.tv_sec * 1.0) + (double)(ArgusParser->ArgusGlobalTime.tv_usec/1000000.0);
+
+            if (agg->statusint && ((glt - nsst) >= agg->statusint))
+               RaSendArgusRecord(ns);
+
+            ns = (struct ArgusRecordStruct *) ns->qhdr.nxt;
+         }
+      }
+
+#if defined(ARGUS_THREADS)
+      pthread_mutex_unlock(&agg->queue->lock);
+#endif
+   }
+
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (1, "ArgusClientTimeout()\n");
+#endif
+}
+
+void
+parse_arg (int argc, char**argv)
+{}
+
+void
+usage ()
+{
+   extern char version[];  
+          
+   fprintf (stdout, "Racluster Version %s\n", version);
+   fprintf (stdout, "usage:  %s [-f racluster.conf]\n", ArgusParser->ArgusProgramName);
+   fprintf (stdout, "usage:  %s [-f racluster.conf] [ra-options] [- filter-expression]\n\n", ArgusParser->ArgusProgramName);
+   fprintf (stdout, "options:  -f <racluster.conf>      read aggregation rules from <racluster.conf>.\n");
+   fprintf (stdout, "          -m flow key fields       specify fields to be used as flow keys.\n");
+   fprintf (stdout, "          -M modes                 modify mode of operation.\n");
+   fprintf (stdout, "             Available modes:      \n");
+   fprintf (stdout, "                compact            hold aggregates in packed form\n");
+   fprintf (stdout, "                correct            turn on direction correction (default)\n");
+   fprintf (stdout, "                nocorrect          turn off direction correction\n");
+   fprintf (stdout, "                ind                aggregate multiple files independently\n");
+   fprintf (stdout, "                norep              do not report aggregation statistics\n");
+   fprintf (stdout, "                rmon               convert bi-directional data into rmon in/out data\n");
+   fprintf (stdout, "                replace            replace input files with aggregation output\n");
+   fprintf (stdout, "                spill=<size>       spill aggregates to disk when the table exceeds <size>[KMG] bytes\n");
+   fprintf (stdout, "                spilldir=<dir>     write spill files in <dir> (default $TMPDIR or /tmp)\n");
+   fprintf (stdout, "          -V                       verbose mode.\n");
+   fflush (stdout);
+
+   exit(1); 
+}
+
+
+void RaProcessThisRecord (struct ArgusParserStruct *, struct ArgusRecordStruct *);
+
+void
+RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *ns)
+{
+   {
+      double nowTime = ArgusFetchStartTime(ns);
+      if (parser->ArgusLastRecordTime == 0) {
+         parser->ArgusLastRecordTime = nowTime;
+      } else {
+         if (parser->ArgusLastRecordTime > nowTime)
+            parser->RaSortedInput = 0;
+         parser->ArgusLastRecordTime = nowTime;
+      }
+   }
+
+   switch (ns->hdr.type & 0xF0) {
+      case ARGUS_EVENT:
+      case ARGUS_MAR:
+         break;
+
+      case ARGUS_NETFLOW:
+      case ARGUS_AFLOW:
+      case ARGUS_FAR: {
+         struct ArgusFlow *flow = (struct ArgusFlow *) ns->dsrs[ARGUS_FLOW_INDEX];
+
+         ArgusIdleClientTimeout();
+
+         if (parser->Vflag || parser->Aflag) {
+            ArgusProcessServiceAvailability(parser, ns);
+            if (parser->xflag) {
+               if ((parser->vflag && (ns->status & RA_SVCPASSED)) ||
+                  (!parser->vflag && (ns->status & RA_SVCFAILED))) {
+#ifdef ARGUSDEBUG
+                  ArgusDebug (3, "RaProcessRecord (0x%x, 0x%x) service test failed", parser, ns); 
+#endif
+                  return;
+               }
+            }
          }
 
-         if (agg->grepstr) {
-            struct ArgusLabelStruct *label;
-            if (((label = (void *)argus->dsrs[ARGUS_LABEL_INDEX]) != NULL)) {
-               if (regexec(&agg->lpreg, label->l_un.label, 0, NULL, 0))
-                  lretn = 0;
-               else
-                  lretn = 1;
-            } else
-               lretn = 0;
+         if (parser->ArgusNormalize) {
+            RaMatrixNormalizeEtherAddrs(ns);
          }
 
-         retn = (lretn < 0) ? ((fretn < 0) ? 1 : fretn) : ((fretn < 0) ? lretn : (lretn && fretn));
+         if (parser->RaMonMode && (flow != NULL)) {
+            struct ArgusRecordStruct *tns = ArgusCopyRecordStruct(ns);
+            struct ArgusFlow *flow;
 
-         if (retn != 0) {
-            struct ArgusRecordStruct *tns, *ns;
-            struct ArgusFlow *flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX];
+            if ((flow = (void *)ns->dsrs[ARGUS_FLOW_INDEX]) != NULL) {
+               flow->hdr.subtype &= ~ARGUS_REVERSE;
+               flow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
+            }
 
-            ns = ArgusCopyRecordStruct(argus);
+            RaProcessThisRecord(parser, ns);
 
-            if (agg->labelstr)
-               ArgusAddToRecordLabel(parser, ns, agg->labelstr);
+            ArgusReverseRecord(tns);
+
+            if ((flow = (void *)tns->dsrs[ARGUS_FLOW_INDEX]) != NULL) {
+               flow->hdr.subtype &= ~ARGUS_REVERSE;
+               flow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
+            }
 
-            if (agg->mask) {
-               if ((agg->rap = RaFlowModelOverRides(agg, ns)) == NULL)
-                  agg->rap = agg->drap;
+            RaProcessThisRecord(parser, tns);
+            ArgusDeleteRecordStruct(parser, tns);
+            
+         } else {
+            struct ArgusAggregatorStruct *agg = parser->ArgusAggregator;
+         
+            if (flow && agg && agg->ArgusMatrixMode) {
+               if (agg->mask & ((0x01LL << ARGUS_MASK_SADDR) | (0x01LL << ARGUS_MASK_DADDR))) {
+                  switch (flow->hdr.subtype & 0x3F) {
+                     case ARGUS_FLOW_LAYER_3_MATRIX:
+                     case ARGUS_FLOW_CLASSIC5TUPLE: {
+                        switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+                           case ARGUS_TYPE_IPV4: {
+                              if (flow->ip_flow.ip_src > flow->ip_flow.ip_dst) 
+                                 ArgusReverseRecord(ns);
+                           }
+                           break; 
 
-               ArgusGenerateNewFlow(agg, ns);
-               agg->ArgusMaskDefs = NULL;
+                           case ARGUS_TYPE_IPV6: {
+                              int i;
+                              for (i = 0; i < 4; i++) {
+                                 if (flow->ipv6_flow.ip_src[i] < flow->ipv6_flow.ip_dst[i])
+                                    break;
 
-               if ((hstruct = ArgusGenerateHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL) {
-                  if ((tns = ArgusFindRecord(agg->htable, hstruct)) == NULL) {
-                     if (!parser->RaMonMode && parser->ArgusReverse) {
-                        int tryreverse = 0;
-
-                        if (flow != NULL) {
-                           if (agg->correct != NULL)
-                              tryreverse = 1;
-
-                           switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
-                              case ARGUS_TYPE_IPV4: {
-                                 switch (flow->ip_flow.ip_p) {
-                                   case IPPROTO_ESP:
-                                       tryreverse = 0;
-                                       break;
+                                 if (flow->ipv6_flow.ip_src[i] > flow->ipv6_flow.ip_dst[i]) {
+                                    ArgusReverseRecord(ns);
+                                    break;
                                  }
+                              }
+                           }
+                           break; 
+                        }
+                        break; 
+                     }
+
+                     default:
+                        break; 
+                  }
+
+               } else 
+               if (agg->mask & ((0x01LL << ARGUS_MASK_SMAC) | (0x01LL << ARGUS_MASK_DMAC))) {
+
+                  struct ArgusMacStruct *m1 = NULL;
+                  if ((m1 = (struct ArgusMacStruct *) ns->dsrs[ARGUS_MAC_INDEX]) != NULL) {
+                     switch (m1->hdr.subtype) {
+                        default:
+                        case ARGUS_TYPE_ETHER: {
+                           struct ether_header *e1 = &m1->mac.mac_union.ether.ehdr;
+                           int i;
+
+                           for (i = 0; i < 6; i++) {
+#if defined(ARGUS_SOLARIS)
+                              if (e1->ether_shost.ether_addr_octet[i] < e1->ether_dhost.ether_addr_octet[i])
+                                 break;
+                              if (e1->ether_shost.ether_addr_octet[i] > e1->ether_dhost.ether_addr_octet[i]) {
+                                 ArgusReverseRecord(ns);
                                  break;
                               }
-                              case ARGUS_TYPE_IPV6: {
-                                 switch (flow->ipv6_flow.ip_p) {
-                                    case IPPROTO_ESP:
-                                       tryreverse = 0;
-                                       break;
-                                 }
+#else
+                              if (e1->ether_shost[i] < e1->ether_dhost[i])
+                                 break;
+                              if (e1->ether_shost[i] > e1->ether_dhost[i]) {
+                                 ArgusReverseRecord(ns);
                                  break;
                               }
+#endif
                            }
-                        } else
-                           tryreverse = 0;
-
-                        if (tryreverse) {
-                           if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL) {
-
-                           if ((tns = ArgusFindRecord(agg->htable, hstruct)) == NULL) {
-                              switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
-                                 case ARGUS_TYPE_IPV4: {
-                                    switch (flow->ip_flow.ip_p) {
-                                       case IPPROTO_ICMP: {
-                                          struct ArgusICMPFlow *icmpFlow = &flow->flow_un.icmp;
-
-                                          if (ICMP_INFOTYPE(icmpFlow->type)) {
-                                             switch (icmpFlow->type) {
-                                                case ICMP_ECHO:
-                                                case ICMP_ECHOREPLY:
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_ECHO) ? ICMP_ECHOREPLY : ICMP_ECHO;
-                                                   if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
-                                                      tns = ArgusFindRecord(agg->htable, hstruct);
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_ECHO) ? ICMP_ECHOREPLY : ICMP_ECHO;
-                                                   if (tns)
-                                                      ArgusReverseRecord (ns);
-                                                   break;
-
-                                                case ICMP_ROUTERADVERT:
-                                                case ICMP_ROUTERSOLICIT:
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_ROUTERADVERT) ? ICMP_ROUTERSOLICIT : ICMP_ROUTERADVERT;
-                                                   if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
-                                                      tns = ArgusFindRecord(agg->htable, hstruct);
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_ROUTERADVERT) ? ICMP_ROUTERSOLICIT : ICMP_ROUTERADVERT;
-                                                   if (tns)
-                                                      ArgusReverseRecord (ns);
-                                                   break;
-
-                                                case ICMP_TSTAMP:
-                                                case ICMP_TSTAMPREPLY:
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_TSTAMP) ? ICMP_TSTAMPREPLY : ICMP_TSTAMP;
-                                                   if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
-                                                      tns = ArgusFindRecord(agg->htable, hstruct);
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_TSTAMP) ? ICMP_TSTAMPREPLY : ICMP_TSTAMP;
-                                                   if (tns)
-                                                      ArgusReverseRecord (ns);
-                                                   break;
-
-                                                case ICMP_IREQ:
-                                                case ICMP_IREQREPLY:
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_IREQ) ? ICMP_IREQREPLY : ICMP_IREQ;
-                                                   if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
-                                                      tns = ArgusFindRecord(agg->htable, hstruct);
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_IREQ) ? ICMP_IREQREPLY : ICMP_IREQ;
-                                                   if (tns)
-                                                      ArgusReverseRecord (ns);
-                                                   break;
-
-                                                case ICMP_MASKREQ:
-                                                case ICMP_MASKREPLY:
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_MASKREQ) ? ICMP_MASKREPLY : ICMP_MASKREQ;
-                                                   if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
-                                                      tns = ArgusFindRecord(agg->htable, hstruct);
-                                                   icmpFlow->type = (icmpFlow->type == ICMP_MASKREQ) ? ICMP_MASKREPLY : ICMP_MASKREQ;
-                                                   if (tns)
-                                                      ArgusReverseRecord (ns);
-                                                   break;
-                                             }
-                                          }
-                                          break;
-                                       }
-                                    }
-                                 }
-                              }
+                           break;
+                        }
+                     }
+                  }
+               }
+
+               flow->hdr.subtype &= ~ARGUS_REVERSE;
+               flow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
+            }
+
+            RaProcessThisRecord(parser, ns);
+         }
+         break;
+      }
+   }
+}
+
 
-                              hstruct = ArgusGenerateHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct);
+static struct ArgusRecordStruct *
+RaClusterInsertRecord (struct ArgusParserStruct *parser, struct ArgusAggregatorStruct *agg, struct ArgusRecordStruct *argus, struct ArgusRecordStruct *ns)
+{
+   struct ArgusFlow *flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX];
+   struct ArgusHashStruct *hstruct = NULL;
+   struct ArgusRecordStruct *tns = NULL;
 
-                           } else {    // OK, so we have a match (tns) that is the reverse of the current flow (ns)
-                                       // Need to decide which direction wins.
+   if (agg->mask) {
+      if ((agg->rap = RaFlowModelOverRides(agg, ns)) == NULL)
+         agg->rap = agg->drap;
 
-                              struct ArgusNetworkStruct *nnet = (struct ArgusNetworkStruct *)ns->dsrs[ARGUS_NETWORK_INDEX];
-                              struct ArgusNetworkStruct *tnet = (struct ArgusNetworkStruct *)tns->dsrs[ARGUS_NETWORK_INDEX];
+      ArgusGenerateNewFlow(agg, ns);
+      agg->ArgusMaskDefs = NULL;
 
-                              switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
-                                 case ARGUS_TYPE_IPV4: {
-                                    switch (flow->ip_flow.ip_p) {
-                                       case IPPROTO_TCP: {
-                                          if ((nnet != NULL) && (tnet != NULL)) {
-                                             struct ArgusTCPObject *ntcp = &nnet->net_union.tcp;
-                                             struct ArgusTCPObject *ttcp = &tnet->net_union.tcp;
+      if ((hstruct = ArgusGenerateHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL) {
+         if ((tns = ArgusFindRecord(agg->htable, hstruct)) == NULL) {
+            if (!parser->RaMonMode && parser->ArgusReverse) {
+               int tryreverse = 0;
 
-// first if both flows have syn, then don't merge;
-                                             if ((ntcp->status & ARGUS_SAW_SYN) && (ttcp->status & ARGUS_SAW_SYN)) {
-                                                tns = NULL;
-                                             } else {
-                                                if ((ntcp->status & ARGUS_SAW_SYN) || 
-                                                   ((ntcp->status & ARGUS_SAW_SYN_SENT) && (ntcp->status & ARGUS_CON_ESTABLISHED))) {
-                                                   struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
-                                                   ArgusRemoveHashEntry(&tns->htblhdr);
-                                                   ArgusReverseRecord (tns);
-                                                   hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
-                                                   tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
-                                                   tflow->hdr.subtype &= ~ARGUS_REVERSE;
-                                                   tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
-                                                } else
-                                                   ArgusReverseRecord (ns);
-                                             }
-                                          }
+               if (flow != NULL) {
+                  if (agg->correct != NULL)
+                     tryreverse = 1;
+
+                  switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+                     case ARGUS_TYPE_IPV4: {
+                        switch (flow->ip_flow.ip_p) {
+                          case IPPROTO_ESP:
+                              tryreverse = 0;
+                              break;
+                        }
+                        break;
+                     }
+                     case ARGUS_TYPE_IPV6: {
+                        switch (flow->ipv6_flow.ip_p) {
+                           case IPPROTO_ESP:
+                              tryreverse = 0;
+                              break;
+                        }
+                        break;
+                     }
+                  }
+               } else
+                  tryreverse = 0;
+
+               if (tryreverse) {
+                  if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL) {
+
+                  if ((tns = ArgusFindRecord(agg->htable, hstruct)) == NULL) {
+                     switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+                        case ARGUS_TYPE_IPV4: {
+                           switch (flow->ip_flow.ip_p) {
+                              case IPPROTO_ICMP: {
+                                 struct ArgusICMPFlow *icmpFlow = &flow->flow_un.icmp;
+
+                                 if (ICMP_INFOTYPE(icmpFlow->type)) {
+                                    switch (icmpFlow->type) {
+                                       case ICMP_ECHO:
+                                       case ICMP_ECHOREPLY:
+                                          icmpFlow->type = (icmpFlow->type == ICMP_ECHO) ? ICMP_ECHOREPLY : ICMP_ECHO;
+                                          if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
+                                             tns = ArgusFindRecord(agg->htable, hstruct);
+                                          icmpFlow->type = (icmpFlow->type == ICMP_ECHO) ? ICMP_ECHOREPLY : ICMP_ECHO;
+                                          if (tns)
+                                             ArgusReverseRecord (ns);
                                           break;
-                                       }
-
-                                       default: {
-                                          double  nstime = ArgusFetchStartTime(ns);
-                                          double tnstime = ArgusFetchStartTime(tns);
-                                          if (tnstime > nstime) {
-                                             struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
-                                             ArgusRemoveHashEntry(&tns->htblhdr);
-                                             ArgusReverseRecord (tns);
-                                             hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
-                                             tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
-                                             tflow->hdr.subtype &= ~ARGUS_REVERSE;
-                                             tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
-                                          } else
+
+                                       case ICMP_ROUTERADVERT:
+                                       case ICMP_ROUTERSOLICIT:
+                                          icmpFlow->type = (icmpFlow->type == ICMP_ROUTERADVERT) ? ICMP_ROUTERSOLICIT : ICMP_ROUTERADVERT;
+                                          if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
+                                             tns = ArgusFindRecord(agg->htable, hstruct);
+                                          icmpFlow->type = (icmpFlow->type == ICMP_ROUTERADVERT) ? ICMP_ROUTERSOLICIT : ICMP_ROUTERADVERT;
+                                          if (tns)
                                              ArgusReverseRecord (ns);
                                           break;
-                                       }
-                                    }
-                                    break;
-                                 }
 
-                                 case ARGUS_TYPE_IPV6: {
-                                    switch (flow->ipv6_flow.ip_p) {
-                                       case IPPROTO_TCP: {
-                                          if ((nnet != NULL) && (tnet != NULL)) {
-                                             struct ArgusTCPObject *ntcp = &nnet->net_union.tcp;
-                                             struct ArgusTCPObject *ttcp = &tnet->net_union.tcp;
+                                       case ICMP_TSTAMP:
+                                       case ICMP_TSTAMPREPLY:
+                                          icmpFlow->type = (icmpFlow->type == ICMP_TSTAMP) ? ICMP_TSTAMPREPLY : ICMP_TSTAMP;
+                                          if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
+                                             tns = ArgusFindRecord(agg->htable, hstruct);
+                                          icmpFlow->type = (icmpFlow->type == ICMP_TSTAMP) ? ICMP_TSTAMPREPLY : ICMP_TSTAMP;
+                                          if (tns)
+                                             ArgusReverseRecord (ns);
+                                          break;
 
-// first if both flows have syn, then don't merge;
-                                             if ((ntcp->status & ARGUS_SAW_SYN) && (ttcp->status & ARGUS_SAW_SYN)) {
-                                                tns = NULL;
-                                             } else {
-                                                if (ntcp->status & ARGUS_SAW_SYN) {
-                                                   ArgusRemoveHashEntry(&tns->htblhdr);
-                                                   ArgusReverseRecord (tns);
-                                                   hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
-                                                   tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
-                                                } else
-                                                if ((ntcp->status & ARGUS_SAW_SYN_SENT) && (ntcp->status & ARGUS_CON_ESTABLISHED)) {
-                                                   ArgusRemoveHashEntry(&tns->htblhdr);
-                                                   ArgusReverseRecord (tns);
-                                                   hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
-                                                   tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
-                                                } else
-                                                   ArgusReverseRecord (ns);
-                                             }
-                                          }
+                                       case ICMP_IREQ:
+                                       case ICMP_IREQREPLY:
+                                          icmpFlow->type = (icmpFlow->type == ICMP_IREQ) ? ICMP_IREQREPLY : ICMP_IREQ;
+                                          if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
+                                             tns = ArgusFindRecord(agg->htable, hstruct);
+                                          icmpFlow->type = (icmpFlow->type == ICMP_IREQ) ? ICMP_IREQREPLY : ICMP_IREQ;
+                                          if (tns)
+                                             ArgusReverseRecord (ns);
                                           break;
-                                       }
-
-                                       default: {
-                                          double  nstime = ArgusFetchStartTime(ns);
-                                          double tnstime = ArgusFetchStartTime(tns);
-                                          if (tnstime > nstime) {
-                                             struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
-                                             ArgusRemoveHashEntry(&tns->htblhdr);
-                                             ArgusReverseRecord (tns);
-                                             hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
-                                             tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
-                                             tflow->hdr.subtype &= ~ARGUS_REVERSE;
-                                             tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
-                                          } else
+
+                                       case ICMP_MASKREQ:
+                                       case ICMP_MASKREPLY:
+                                          icmpFlow->type = (icmpFlow->type == ICMP_MASKREQ) ? ICMP_MASKREPLY : ICMP_MASKREQ;
+                                          if ((hstruct = ArgusGenerateReverseHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct)) != NULL)
+                                             tns = ArgusFindRecord(agg->htable, hstruct);
+                                          icmpFlow->type = (icmpFlow->type == ICMP_MASKREQ) ? ICMP_MASKREPLY : ICMP_MASKREQ;
+                                          if (tns)
                                              ArgusReverseRecord (ns);
                                           break;
-                                       }
                                     }
-                                    break;
-                                 }
-
-                                 default: {
-                                    double  nstime = ArgusFetchStartTime(ns);
-                                    double tnstime = ArgusFetchStartTime(tns);
-                                    if (tnstime > nstime) {
-                                       struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
-                                       ArgusRemoveHashEntry(&tns->htblhdr);
-                                       ArgusReverseRecord (tns);
-                                       hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
-                                       tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
-                                       tflow->hdr.subtype &= ~ARGUS_REVERSE;
-                                       tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
-                                    } else
-                                       ArgusReverseRecord (ns);
-                                    break;
                                  }
+                                 break;
                               }
                            }
-                           }
                         }
                      }
-                  }
 
-                  if (tns != NULL) {                            // found record in queue
-                     if (parser->Aflag) {
-                        if ((tns->status & RA_SVCTEST) != (ns->status & RA_SVCTEST)) {
-                           RaSendArgusRecord(tns);
-                           tns->status &= ~(RA_SVCTEST);
-                           tns->status |= (ns->status & RA_SVCTEST);
-                        }
-                     }
+                     hstruct = ArgusGenerateHashStruct(agg, ns, (struct ArgusFlow *)&agg->fstruct);
 
-                     {
-// Test for TCP port reuse
-                        struct ArgusNetworkStruct *nnet = (struct ArgusNetworkStruct *)ns->dsrs[ARGUS_NETWORK_INDEX];
-                        struct ArgusNetworkStruct *tnet = (struct ArgusNetworkStruct *)tns->dsrs[ARGUS_NETWORK_INDEX];
-                        struct ArgusTCPObject *ntcp = NULL;
-                        struct ArgusTCPObject *ttcp = NULL;
+                  } else {    // OK, so we have a match (tns) that is the reverse of the current flow (ns)
+                              // Need to decide which direction wins.
 
-                        switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
-                           case ARGUS_TYPE_IPV4: {
-                              switch (flow->ip_flow.ip_p) {
-                                 case IPPROTO_TCP: {
-                                    if ((nnet != NULL) && (tnet != NULL)) {
-                                       ntcp = &nnet->net_union.tcp;
-                                       ttcp = &tnet->net_union.tcp;
+                     struct ArgusNetworkStruct *nnet = (struct ArgusNetworkStruct *)ns->dsrs[ARGUS_NETWORK_INDEX];
+                     struct ArgusNetworkStruct *tnet = (struct ArgusNetworkStruct *)tns->dsrs[ARGUS_NETWORK_INDEX];
+
+                     switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+                        case ARGUS_TYPE_IPV4: {
+                           switch (flow->ip_flow.ip_p) {
+                              case IPPROTO_TCP: {
+                                 if ((nnet != NULL) && (tnet != NULL)) {
+                                    struct ArgusTCPObject *ntcp = &nnet->net_union.tcp;
+                                    struct ArgusTCPObject *ttcp = &tnet->net_union.tcp;
+
+// first if both flows have syn, then don't merge;
+                                    if ((ntcp->status & ARGUS_SAW_SYN) && (ttcp->status & ARGUS_SAW_SYN)) {
+                                       tns = NULL;
+                                    } else {
+                                       if ((ntcp->status & ARGUS_SAW_SYN) || 
+                                          ((ntcp->status & ARGUS_SAW_SYN_SENT) && (ntcp->status & ARGUS_CON_ESTABLISHED))) {
+                                          struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
+                                          ArgusRemoveHashEntry(&tns->htblhdr);
+                                          ArgusReverseRecord (tns);
+                                          hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
+                                          tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
+                                          tflow->hdr.subtype &= ~ARGUS_REVERSE;
+                                          tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
+                                       } else
+                                          ArgusReverseRecord (ns);
                                     }
                                  }
+                                 break;
                               }
-                              break;
-                           }
 
-                           case ARGUS_TYPE_IPV6: {
-                              switch (flow->ipv6_flow.ip_p) {
-                                 case IPPROTO_TCP: {
-                                    if ((nnet != NULL) && (tnet != NULL)) {
-                                       ntcp = &nnet->net_union.tcp;
-                                       ttcp = &tnet->net_union.tcp;
-                                    }
-                                 }
+                              default: {
+                                 double  nstime = ArgusFetchStartTime(ns);
+                                 double tnstime = ArgusFetchStartTime(tns);
+                                 if (tnstime > nstime) {
+                                    struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
+                                    ArgusRemoveHashEntry(&tns->htblhdr);
+                                    ArgusReverseRecord (tns);
+                                    hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
+                                    tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
+                                    tflow->hdr.subtype &= ~ARGUS_REVERSE;
+                                    tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
+                                 } else
+                                    ArgusReverseRecord (ns);
+                                 break;
                               }
-                              break;
                            }
+                           break;
                         }
-                        if (ntcp && ttcp) {
-                           if (((ttcp->status & 0x0F) == 0x0F) && (ntcp->status & ARGUS_SAW_SYN)) {
-                              if (ntcp->status & ARGUS_PORT_REUSE) {
-//                               RaSendArgusRecord(tns);
+
+                        case ARGUS_TYPE_IPV6: {
+                           switch (flow->ipv6_flow.ip_p) {
+                              case IPPROTO_TCP: {
+                                 if ((nnet != NULL) && (tnet != NULL)) {
+                                    struct ArgusTCPObject *ntcp = &nnet->net_union.tcp;
+                                    struct ArgusTCPObject *ttcp = &tnet->net_union.tcp;
+
+// first if both flows have syn, then don't merge;
+                                    if ((ntcp->status & ARGUS_SAW_SYN) && (ttcp->status & ARGUS_SAW_SYN)) {
+                                       tns = NULL;
+                                    } else {
+                                       if (ntcp->status & ARGUS_SAW_SYN) {
+                                          ArgusRemoveHashEntry(&tns->htblhdr);
+                                          ArgusReverseRecord (tns);
+                                          hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
+                                          tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
+                                       } else
+                                       if ((ntcp->status & ARGUS_SAW_SYN_SENT) && (ntcp->status & ARGUS_CON_ESTABLISHED)) {
+                                          ArgusRemoveHashEntry(&tns->htblhdr);
+                                          ArgusReverseRecord (tns);
+                                          hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
+                                          tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
+                                       } else
+                                          ArgusReverseRecord (ns);
+                                    }
+                                 }
+                                 break;
                               }
-                           }
-                        }
-                     }
 
-                     if (tns->status & ARGUS_RECORD_WRITTEN) {
-                        ArgusZeroRecord (tns);
-                     } else {
-                        if ((agg->statusint > 0) || (agg->idleint > 0)) {   // if any timers, need to flush if needed
-                           double dur, nsst, tnsst, nslt, tnslt;
-
-                           nsst  = ArgusFetchStartTime(ns);
-                           tnsst = ArgusFetchStartTime(tns);
-                           nslt  = ArgusFetchLastTime(ns);
-                           tnslt = ArgusFetchLastTime(tns);
-
-                           dur = ((tnslt > nslt) ? tnslt : nslt) - ((nsst < tnsst) ? nsst : tnsst); 
-                        
-                           if ((agg->statusint > 0) && (dur >= agg->statusint)) {
-                              RaSendArgusRecord(tns);
-                              ArgusZeroRecord(tns);
-                           } else {
-                              dur = ((nslt < tnsst) ? (tnsst - nslt) : ((tnslt < nsst) ? (nsst - tnslt) : 0.0));
-                              if (agg->idleint && (dur >= agg->idleint)) {
-                                 RaSendArgusRecord(tns);
-                                 ArgusZeroRecord(tns);
+                              default: {
+                                 double  nstime = ArgusFetchStartTime(ns);
+                                 double tnstime = ArgusFetchStartTime(tns);
+                                 if (tnstime > nstime) {
+                                    struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
+                                    ArgusRemoveHashEntry(&tns->htblhdr);
+                                    ArgusReverseRecord (tns);
+                                    hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
+                                    tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
+                                    tflow->hdr.subtype &= ~ARGUS_REVERSE;
+                                    tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
+                                 } else
+                                    ArgusReverseRecord (ns);
+                                 break;
                               }
                            }
+                           break;
+                        }
 
+                        default: {
+                           double  nstime = ArgusFetchStartTime(ns);
+                           double tnstime = ArgusFetchStartTime(tns);
+                           if (tnstime > nstime) {
+                              struct ArgusFlow *tflow = (struct ArgusFlow *) tns->dsrs[ARGUS_FLOW_INDEX];
+                              ArgusRemoveHashEntry(&tns->htblhdr);
+                              ArgusReverseRecord (tns);
+                              hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct);
+                              tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
+                              tflow->hdr.subtype &= ~ARGUS_REVERSE;
+                              tflow->hdr.argus_dsrvl8.qual &= ~ARGUS_DIRECTION;
+                           } else
+                              ArgusReverseRecord (ns);
+                           break;
                         }
                      }
+                  }
+                  }
+               }
+            }
+         }
 
-                     ArgusMergeRecords (agg, tns, ns);
+         if (tns != NULL) {                            // found record in queue
+            if (parser->Aflag) {
+               if ((tns->status & RA_SVCTEST) != (ns->status & RA_SVCTEST)) {
+                  RaSendArgusRecord(tns);
+                  tns->status &= ~(RA_SVCTEST);
+                  tns->status |= (ns->status & RA_SVCTEST);
+               }
+            }
 
-                     ArgusRemoveFromQueue (agg->queue, &tns->qhdr, ARGUS_LOCK);
-                     ArgusAddToQueue (agg->queue, &tns->qhdr, ARGUS_LOCK);         // use the agg queue as an idle timeout queue
+            {
+// Test for TCP port reuse
+               struct ArgusNetworkStruct *nnet = (struct ArgusNetworkStruct *)ns->dsrs[ARGUS_NETWORK_INDEX];
+               struct ArgusNetworkStruct *tnet = (struct ArgusNetworkStruct *)tns->dsrs[ARGUS_NETWORK_INDEX];
+               struct ArgusTCPObject *ntcp = NULL;
+               struct ArgusTCPObject *ttcp = NULL;
+
+               switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+                  case ARGUS_TYPE_IPV4: {
+                     switch (flow->ip_flow.ip_p) {
+                        case IPPROTO_TCP: {
+                           if ((nnet != NULL) && (tnet != NULL)) {
+                              ntcp = &nnet->net_union.tcp;
+                              ttcp = &tnet->net_union.tcp;
+                           }
+                        }
+                     }
+                     break;
+                  }
 
-                     ArgusDeleteRecordStruct(parser, ns);
-                     agg->status |= ARGUS_AGGREGATOR_DIRTY;
+                  case ARGUS_TYPE_IPV6: {
+                     switch (flow->ipv6_flow.ip_p) {
+                        case IPPROTO_TCP: {
+                           if ((nnet != NULL) && (tnet != NULL)) {
+                              ntcp = &nnet->net_union.tcp;
+                              ttcp = &tnet->net_union.tcp;
+                           }
+                        }
+                     }
+                     break;
+                  }
+               }
+               if (ntcp && ttcp) {
+                  if (((ttcp->status & 0x0F) == 0x0F) && (ntcp->status & ARGUS_SAW_SYN)) {
+                     if (ntcp->status & ARGUS_PORT_REUSE) {
+//                               RaSendArgusRecord(tns);
+                     }
+                  }
+               }
+            }
 
+            if (tns->status & ARGUS_RECORD_WRITTEN) {
+               ArgusZeroRecord (tns);
+            } else {
+               if ((agg->statusint > 0) || (agg->idleint > 0)) {   // if any timers, need to flush if needed
+                  double dur, nsst, tnsst, nslt, tnslt;
+
+                  nsst  = ArgusFetchStartTime(ns);
+                  tnsst = ArgusFetchStartTime(tns);
+                  nslt  = ArgusFetchLastTime(ns);
+                  tnslt = ArgusFetchLastTime(tns);
+
+                  dur = ((tnslt > nslt) ? tnslt : nslt) - ((nsst < tnsst) ? nsst : tnsst); 
+               
+                  if ((agg->statusint > 0) && (dur >= agg->statusint)) {
+                     RaSendArgusRecord(tns);
+                     ArgusZeroRecord(tns);
                   } else {
-                     tns = ns;
-                     if ((hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct)) != NULL) {
-                        tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
-                        ArgusAddToQueue (agg->queue, &tns->qhdr, ARGUS_LOCK);
-                        agg->status |= ARGUS_AGGREGATOR_DIRTY;
+                     dur = ((nslt < tnsst) ? (tnsst - nslt) : ((tnslt < nsst) ? (nsst - tnslt) : 0.0));
+                     if (agg->idleint && (dur >= agg->idleint)) {
+                        RaSendArgusRecord(tns);
+                        ArgusZeroRecord(tns);
                      }
                   }
+
                }
+            }
 
-            } else {
-               ArgusAddToQueue (agg->queue, &ns->qhdr, ARGUS_LOCK);
+            ArgusMergeRecords (agg, tns, ns);
+
+            ArgusRemoveFromQueue (agg->queue, &tns->qhdr, ARGUS_LOCK);
+            ArgusAddToQueue (agg->queue, &tns->qhdr, ARGUS_LOCK);         // use the agg queue as an idle timeout queue
+
+            ArgusDeleteRecordStruct(parser, ns);
+            agg->status |= ARGUS_AGGREGATOR_DIRTY;
+
+         } else {
+            tns = ns;
+            if ((hstruct = ArgusGenerateHashStruct(agg, tns, (struct ArgusFlow *)&agg->fstruct)) != NULL) {
+               tns->htblhdr = ArgusAddHashEntry (agg->htable, tns, hstruct);
+               ArgusAddToQueue (agg->queue, &tns->qhdr, ARGUS_LOCK);
                agg->status |= ARGUS_AGGREGATOR_DIRTY;
             }
+         }
+      }
+
+   } else {
+      ArgusAddToQueue (agg->queue, &ns->qhdr, ARGUS_LOCK);
+      agg->status |= ARGUS_AGGREGATOR_DIRTY;
+      tns = ns;
+   }
+
+   return (tns);
+}
+
+
+void
+RaProcessThisRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
+{
+   struct ArgusAggregatorStruct *agg = parser->ArgusAggregator;
+   int found = 0;
+
+   if (agg != NULL) {
+      while (agg && !found) {
+         int retn = 0, fretn = -1, lretn = -1;
+
+         if (agg->filterstr) {
+            struct nff_insn *fcode = agg->filter.bf_insns;
+            fretn = ArgusFilterRecord (fcode, argus);
+         }
+
+         if (agg->grepstr) {
+            struct ArgusLabelStruct *label;
+            if (((label = (void *)argus->dsrs[ARGUS_LABEL_INDEX]) != NULL)) {
+               lretn = ArgusGrepLabel(agg->grepmatcher, &agg->lpreg, label->l_un.label);
+            } else
+               lretn = 0;
+         }
+
+         retn = (lretn < 0) ? ((fretn < 0) ? 1 : fretn) : ((fretn < 0) ? lretn : (lretn && fretn));
+
+         if (retn != 0) {
+            struct RaClusterSpillStruct *spill;
+            struct RaClusterCompactTable *ctbl;
+            struct ArgusRecordStruct *tns, *ns;
+
+            ns = ArgusCopyRecordStruct(argus);
+
+            if (agg->labelstr)
+               ArgusAddToRecordLabel(parser, ns, agg->labelstr);
+
+            if ((spill = RaClusterFindSpill(agg, 0)) != NULL)
+               RaClusterSpillRecord (parser, spill, argus, ns);
+            else
+            if ((ctbl = RaClusterFindCompact(agg, 0)) != NULL)
+               RaClusterCompactRecord (parser, ctbl, argus, ns);
+            else
+            if ((tns = RaClusterInsertRecord (parser, agg, argus, ns)) != NULL) {
+               if (RaClusterSpillMax && agg->mask) {
+                  if (tns == ns)
+                     tns->khash = RaClusterKeyHash(agg, tns);
+                  if ((agg->queue->count > RaClusterSpillMax) && RaClusterSpillable(agg))
+                     RaClusterSpill (parser, agg);
+               }
+            }
 
             if (agg->cont)
                agg = agg->nxt;
@@ -49,6 +49,7 @@
 #include <argus_main.h>
 
 #include <rabins.h>
+#include <argus_sketch.h>
 
 #include <signal.h>
 #include <ctype.h>
@@ -141,8 +142,16 @@
 #endif
 
 
+#define ARGUS_THIS_SRC_ADDR	0
+#define ARGUS_THIS_DST_ADDR	1
+
 int RaAddrMode = 0;
 int RaProtoMode = 0;
+int RaApproxMode = 0;
+
+int RaTopTalkers = 10;
+int RaHLLPrecision = 14;
+char *RaSketchFile = NULL;
 
 int ArgusIPv4AddrUnicast[2]            = {0,0};
 int ArgusIPv4AddrUnicastThisNet[2]     = {0,0};
@@ -191,6 +200,68 @@ signed long long ArgusTotalFlowRecs = 0;
 
 struct ArgusHashTable *ArgusSrcAddrTable, *ArgusDstAddrTable;
 
+/*
+ * In approx mode, the distinct addresses of each IPv4 address type
+ * are counted with an HLL, rather than held in the address tables,
+ * and the hosts with the most bytes are kept in a Space-Saving table,
+ * with an HLL of each host's peers.
+ */
+
+#define RA_TALKER_PEER_PRECISION	10
+
+struct RaAddrTallyStruct {
+   char *name;
+   int *tally;
+   struct ArgusHLLStruct *hll[2];
+};
+
+#define RA_TALLY_UNICAST	0
+#define RA_TALLY_THISNET	1
+#define RA_TALLY_PRIVATE	2
+#define RA_TALLY_LOOPBACK	3
+#define RA_TALLY_LINKLOCAL	4
+#define RA_TALLY_TESTNET	5
+#define RA_TALLY_RESERVED	6
+#define RA_TALLY_MC_LOCAL	7
+#define RA_TALLY_MC_INTERNET	8
+#define RA_TALLY_MC_ADHOC	9
+#define RA_TALLY_MC_RESERVED	10
+#define RA_TALLY_MC_SDPSAP	11
+#define RA_TALLY_MC_NASDAQ	12
+#define RA_TALLY_MC_DISTRANS	13
+#define RA_TALLY_MC_SRCSPEC	14
+#define RA_TALLY_MC_GLOP	15
+#define RA_TALLY_MC_ORGLOCAL	16
+#define RA_TALLY_MC_SITELOCAL	17
+
+struct RaAddrTallyStruct RaIPv4AddrTally[] = {
+   { "unicast",            ArgusIPv4AddrUnicast },
+   { "unicast.thisnet",    ArgusIPv4AddrUnicastThisNet },
+   { "unicast.private",    ArgusIPv4AddrUnicastPrivate },
+   { "unicast.loopback",   ArgusIPv4AddrUnicastLoopBack },
+   { "unicast.linklocal",  ArgusIPv4AddrUnicastLinkLocal },
+   { "unicast.testnet",    ArgusIPv4AddrUnicastTestNet },
+   { "unicast.reserved",   ArgusIPv4AddrUnicastReserved },
+   { "multicast.local",    ArgusIPv4AddrMulticastLocal },
+   { "multicast.internet", ArgusIPv4AddrMulticastInternet },
+   { "multicast.adhoc",    ArgusIPv4AddrMulticastAdHoc },
+   { "multicast.reserved", ArgusIPv4AddrMulticastReserved },
+   { "multicast.sdpsap",   ArgusIPv4AddrMulticastSdpSap },
+   { "multicast.nasdaq",   ArgusIPv4AddrMulticastNasdaq },
+   { "multicast.distrans", ArgusIPv4AddrMulticastDisTrans },
+   { "multicast.srcspec",  ArgusIPv4AddrMulticastSrcSpec },
+   { "multicast.glop",     ArgusIPv4AddrMulticastGlop },
+   { "multicast.orglocal", ArgusIPv4AddrMulticastOrgLocal },
+   { "multicast.sitelocal",ArgusIPv4AddrMulticastSiteLocal },
+   { NULL, NULL },
+};
+
+struct ArgusSketchSetStruct *RaSketchSet = NULL;
+struct ArgusTopKStruct *RaTalkers = NULL;
+
+void RaInitSketches(struct ArgusParserStruct *);
+void RaPrintTopTalkers(void);
+
 void RaPrintSrcAddressTally(void);
 void RaPrintAddressTally(void);
 void RaPrintProtoTally(void);
@@ -239,11 +310,39 @@ ArgusClientInit (struct ArgusParserStruct *parser)
             else
             if (!(strncasecmp (mode->mode, "nodir", 5)))
                parser->ArgusDirectionFunction = 0;
+            else
+            if (!(strncasecmp (mode->mode, "approx", 6))) {
+               RaApproxMode++;
+               RaAddrMode++;
+            } else
+            if (!(strncasecmp (mode->mode, "topk=", 5))) {
+               if ((RaTopTalkers = atoi(&mode->mode[5])) <= 0)
+                  ArgusLog (LOG_ERR, "ArgusClientInit: topk value %s must be > 0", &mode->mode[5]);
+               RaApproxMode++;
+               RaAddrMode++;
+            } else
+            if (!(strncasecmp (mode->mode, "hll=", 4))) {
+               RaHLLPrecision = atoi(&mode->mode[4]);
+               if ((RaHLLPrecision < ARGUS_HLL_MINP) || (RaHLLPrecision > ARGUS_HLL_MAXP))
+                  ArgusLog (LOG_ERR, "ArgusClientInit: hll precision %s must be %d-%d", &mode->mode[4], ARGUS_HLL_MINP, ARGUS_HLL_MAXP);
+            } else
+            if (!(strncasecmp (mode->mode, "sketch=", 7))) {
+               RaSketchFile = &mode->mode[7];
+               RaApproxMode++;
+               RaAddrMode++;
+            } else
+            if (!(strncasecmp (mode->mode, "merge=", 6))) {
+               RaApproxMode++;
+               RaAddrMode++;
+            }
 
             mode = mode->nxt;
          }
       }
 
+      if (RaApproxMode)
+         RaInitSketches(parser);
+
       if ((parser->ArgusAggregator = ArgusNewAggregator(parser, NULL, ARGUS_RECORD_AGGREGATOR)) == NULL)
          ArgusLog (LOG_ERR, "ArgusClientInit: ArgusNewAggregator error");
 
@@ -262,6 +361,44 @@ ArgusClientInit (struct ArgusParserStruct *parser)
    }
 }
 
+/*
+ * Merge any merge= sketch files first, so that the sketches they hold
+ * keep the precision and size they were written with.
+ */
+
+void
+RaInitSketches(struct ArgusParserStruct *parser)
+{
+   struct ArgusModeStruct *mode;
+   struct RaAddrTallyStruct *tally;
+   char name[MAXSTRLEN];
+   int k;
+
+   if ((RaSketchSet = ArgusNewSketchSet()) == NULL)
+      ArgusLog (LOG_ERR, "RaInitSketches: ArgusNewSketchSet error %s", strerror(errno));
+
+   for (mode = parser->ArgusModeList; mode != NULL; mode = mode->nxt)
+      if (!(strncasecmp (mode->mode, "merge=", 6)))
+         if (ArgusMergeSketchFile(RaSketchSet, &mode->mode[6]) < 0)
+            ArgusLog (LOG_ERR, "RaInitSketches: can't merge %s", &mode->mode[6]);
+
+   for (tally = RaIPv4AddrTally; tally->name != NULL; tally++) {
+      snprintf (name, MAXSTRLEN, "racount/ipv4/%s/src", tally->name);
+      tally->hll[ARGUS_THIS_SRC_ADDR] = ArgusGetSketch(RaSketchSet, name, ARGUS_SKETCH_HLL, RaHLLPrecision, 0);
+      snprintf (name, MAXSTRLEN, "racount/ipv4/%s/dst", tally->name);
+      tally->hll[ARGUS_THIS_DST_ADDR] = ArgusGetSketch(RaSketchSet, name, ARGUS_SKETCH_HLL, RaHLLPrecision, 0);
+
+      if ((tally->hll[ARGUS_THIS_SRC_ADDR] == NULL) || (tally->hll[ARGUS_THIS_DST_ADDR] == NULL))
+         ArgusLog (LOG_ERR, "RaInitSketches: %s is not an hll sketch", name);
+   }
+
+   if ((k = RaTopTalkers * 10) < 1000)
+      k = 1000;
+
+   if ((RaTalkers = ArgusGetSketch(RaSketchSet, "racount/talkers", ARGUS_SKETCH_TOPK, k, RA_TALKER_PEER_PRECISION)) == NULL)
+      ArgusLog (LOG_ERR, "RaInitSketches: racount/talkers is not a top-k sketch");
+}
+
 void RaArgusInputComplete (struct ArgusInput *input) { return; }
 
 void
@@ -286,12 +423,27 @@ RaParseComplete (int sig)
             RaPrintProtoTally();
 
          if (RaAddrMode) {
+            if (RaApproxMode) {
+               struct RaAddrTallyStruct *tally;
+
+               for (tally = RaIPv4AddrTally; tally->name != NULL; tally++) {
+                  tally->tally[ARGUS_THIS_SRC_ADDR] = ArgusHLLCount(tally->hll[ARGUS_THIS_SRC_ADDR]) + 0.5;
+                  tally->tally[ARGUS_THIS_DST_ADDR] = ArgusHLLCount(tally->hll[ARGUS_THIS_DST_ADDR]) + 0.5;
+               }
+            }
+
             if (ArgusParser->RaMonMode)
                RaPrintSrcAddressTally();
             else
                RaPrintAddressTally();
+
+            if (RaApproxMode)
+               RaPrintTopTalkers();
          }
 
+         if (RaSketchFile != NULL)
+            ArgusWriteSketchSet(RaSketchSet, RaSketchFile);
+
          fflush (stdout);
          ArgusShutDown(sig);
 
@@ -331,6 +483,7 @@ RaParseComplete (int sig)
 
          ArgusDeleteHashTable(ArgusSrcAddrTable);
          ArgusDeleteHashTable(ArgusDstAddrTable);
+         ArgusDeleteSketchSet(RaSketchSet);
 
 #if defined(ARGUS_THREADS)
          if (ArgusParser->Sflag) {
@@ -399,6 +552,12 @@ usage ()
    fprintf (stdout, "              supported modes  \n");
    fprintf (stdout, "                 addr          print detailed address usage counts\n");
    fprintf (stdout, "                 proto         print detailed protocol usage stats\n");
+   fprintf (stdout, "                 approx        estimate address counts, and top talkers, in\n");
+   fprintf (stdout, "                               fixed memory\n");
+   fprintf (stdout, "                 topk=<n>      print the <n> top talkers (default 10)\n");
+   fprintf (stdout, "                 hll=<p>       use 2^<p> registers for address counts (default 14)\n");
+   fprintf (stdout, "                 sketch=<file> write the approx mode sketches to <file>\n");
+   fprintf (stdout, "                 merge=<file>  merge the sketches in <file> into this run\n");
    fprintf (stdout, "            -r <file>          read argus data <file>. '-' denotes stdin.\n");
    fprintf (stdout, "            -s [-][+[#]]field  specify fields to print.\n");
    fprintf (stdout, "            -S <host[:port]>   specify remote argus <host> and optional port\n");
@@ -422,13 +581,12 @@ int RaLabelCounter = 0;
 
 #include <netinet/in.h>
 
-
-#define ARGUS_THIS_SRC_ADDR	0
-#define ARGUS_THIS_DST_ADDR	1
-
 void RaProcessThisRecord (struct ArgusParserStruct *, struct ArgusRecordStruct *);
 void RaTallyIPv4AddressType(struct ArgusParserStruct *, unsigned int, int);
 void RaTallyIPv6AddressType(struct ArgusParserStruct *, struct in6_addr *, int);
+int RaIPv4AddressTally(struct ArgusParserStruct *, unsigned int);
+void RaApproxIPv4Address(struct ArgusParserStruct *, unsigned int, int);
+void RaTallyTalkers(struct ArgusParserStruct *, struct ArgusRecordStruct *, void *, void *, int);
 
 void
 RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
@@ -589,6 +747,16 @@ RaProcessThisRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct
                switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
                   case ARGUS_TYPE_IPV4: {
                      int i, len, s = sizeof(unsigned short);
+
+                     if (RaApproxMode) {
+                        RaApproxIPv4Address(parser, flow->ip_flow.ip_src, ARGUS_THIS_SRC_ADDR);
+                        if (!(parser->RaMonMode))
+                           RaApproxIPv4Address(parser, flow->ip_flow.ip_dst, ARGUS_THIS_DST_ADDR);
+
+                        RaTallyTalkers(parser, argus, &flow->ip_flow.ip_src, &flow->ip_flow.ip_dst, 4);
+                        break;
+                     }
+
                      struct ArgusHashTableHdr *htbl = NULL;
                      struct ArgusHashStruct ArgusHash;
                      unsigned short *sptr;
@@ -635,6 +803,9 @@ RaProcessThisRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct
                   case ARGUS_TYPE_IPV6: {
                      RaTallyIPv6AddressType(parser, (struct in6_addr *)&flow->ipv6_flow.ip_src, ARGUS_THIS_SRC_ADDR);
                      RaTallyIPv6AddressType(parser, (struct in6_addr *)&flow->ipv6_flow.ip_dst, ARGUS_THIS_DST_ADDR);
+
+                     if (RaApproxMode)
+                        RaTallyTalkers(parser, argus, flow->ipv6_flow.ip_src, flow->ipv6_flow.ip_dst, 16);
                      break;
                   }
 
@@ -648,43 +819,101 @@ RaProcessThisRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct
 }
 
 
-void
-RaTallyIPv4AddressType(struct ArgusParserStruct *parser, unsigned int addr, int type)
+/*
+ * Returns the index of the address's type in RaIPv4AddrTally, or -1
+ * if the type isn't tallied.
+ */
+
+int
+RaIPv4AddressTally(struct ArgusParserStruct *parser, unsigned int addr)
 {
    unsigned int addrType = RaIPv4AddressType(parser, addr);
 
    switch (addrType) {
-      case ARGUS_IPV4_UNICAST: ArgusIPv4AddrUnicast[type]++; break;
-      case ARGUS_IPV4_UNICAST_THIS_NET: ArgusIPv4AddrUnicastThisNet[type]++; break;
-      case ARGUS_IPV4_UNICAST_PRIVATE: ArgusIPv4AddrUnicastPrivate[type]++; break;
-      case ARGUS_IPV4_UNICAST_LINK_LOCAL: ArgusIPv4AddrUnicastLinkLocal[type]++; break;
-      case ARGUS_IPV4_UNICAST_LOOPBACK: ArgusIPv4AddrUnicastLoopBack[type]++; break;
-      case ARGUS_IPV4_UNICAST_TESTNET: ArgusIPv4AddrUnicastTestNet[type]++; break;
-      case ARGUS_IPV4_UNICAST_RESERVED: ArgusIPv4AddrUnicastReserved[type]++; break;
+      case ARGUS_IPV4_UNICAST: return (RA_TALLY_UNICAST);
+      case ARGUS_IPV4_UNICAST_THIS_NET: return (RA_TALLY_THISNET);
+      case ARGUS_IPV4_UNICAST_PRIVATE: return (RA_TALLY_PRIVATE);
+      case ARGUS_IPV4_UNICAST_LOOPBACK: return (RA_TALLY_LOOPBACK);
+      case ARGUS_IPV4_UNICAST_LINK_LOCAL: return (RA_TALLY_LINKLOCAL);
+      case ARGUS_IPV4_UNICAST_TESTNET: return (RA_TALLY_TESTNET);
+      case ARGUS_IPV4_UNICAST_RESERVED: return (RA_TALLY_RESERVED);
 
       case ARGUS_IPV4_MULTICAST:
-      case ARGUS_IPV4_MULTICAST_LOCAL: ArgusIPv4AddrMulticastLocal[type]++; break;
-      case ARGUS_IPV4_MULTICAST_INTERNETWORK: ArgusIPv4AddrMulticastInternet[type]++;  break;
-      case ARGUS_IPV4_MULTICAST_RESERVED: ArgusIPv4AddrMulticastReserved[type]++; break;
-      case ARGUS_IPV4_MULTICAST_SDPSAP: ArgusIPv4AddrMulticastSdpSap[type]++; break;
-      case ARGUS_IPV4_MULTICAST_NASDAQ: ArgusIPv4AddrMulticastNasdaq[type]++; break;
-      case ARGUS_IPV4_MULTICAST_DIS: ArgusIPv4AddrMulticastDisTrans[type]++; break;
+      case ARGUS_IPV4_MULTICAST_LOCAL: return (RA_TALLY_MC_LOCAL);
+      case ARGUS_IPV4_MULTICAST_INTERNETWORK: return (RA_TALLY_MC_INTERNET);
+      case ARGUS_IPV4_MULTICAST_RESERVED: return (RA_TALLY_MC_RESERVED);
+      case ARGUS_IPV4_MULTICAST_SDPSAP: return (RA_TALLY_MC_SDPSAP);
+      case ARGUS_IPV4_MULTICAST_NASDAQ: return (RA_TALLY_MC_NASDAQ);
+      case ARGUS_IPV4_MULTICAST_DIS: return (RA_TALLY_MC_DISTRANS);
 
-      case ARGUS_IPV4_MULTICAST_SRCSPEC:ArgusIPv4AddrMulticastOrgLocal[type]++; break;
-      case ARGUS_IPV4_MULTICAST_GLOP: ArgusIPv4AddrMulticastGlop[type]++; break;
+      case ARGUS_IPV4_MULTICAST_SRCSPEC: return (RA_TALLY_MC_ORGLOCAL);
+      case ARGUS_IPV4_MULTICAST_GLOP: return (RA_TALLY_MC_GLOP);
 
       case ARGUS_IPV4_MULTICAST_ADMIN:
       case ARGUS_IPV4_MULTICAST_SCOPED:
-      case ARGUS_IPV4_MULTICAST_SCOPED_ORG_LOCAL: ArgusIPv4AddrMulticastOrgLocal[type]++; break;
-      case ARGUS_IPV4_MULTICAST_SCOPED_SITE_LOCAL: ArgusIPv4AddrMulticastSiteLocal[type]++; break;
+      case ARGUS_IPV4_MULTICAST_SCOPED_ORG_LOCAL: return (RA_TALLY_MC_ORGLOCAL);
+      case ARGUS_IPV4_MULTICAST_SCOPED_SITE_LOCAL: return (RA_TALLY_MC_SITELOCAL);
       case ARGUS_IPV4_MULTICAST_SCOPED_REL: break;
 
       case ARGUS_IPV4_MULTICAST_ADHOC:
       case ARGUS_IPV4_MULTICAST_ADHOC_BLK1:
       case ARGUS_IPV4_MULTICAST_ADHOC_BLK2:
       case ARGUS_IPV4_MULTICAST_ADHOC_BLK3:
-         ArgusIPv4AddrMulticastAdHoc[type]++;
-         break;
+         return (RA_TALLY_MC_ADHOC);
+   }
+   return (-1);
+}
+
+void
+RaTallyIPv4AddressType(struct ArgusParserStruct *parser, unsigned int addr, int type)
+{
+   int index;
+
+   if ((index = RaIPv4AddressTally(parser, addr)) >= 0)
+      RaIPv4AddrTally[index].tally[type]++;
+}
+
+void
+RaApproxIPv4Address(struct ArgusParserStruct *parser, unsigned int addr, int type)
+{
+   unsigned int naddr = htonl(addr);
+   int index;
+
+   if ((index = RaIPv4AddressTally(parser, addr)) >= 0)
+      ArgusHLLAdd(RaIPv4AddrTally[index].hll[type], ArgusSketchHash(&naddr, sizeof(naddr)));
+}
+
+/*
+ * Credit the flow's bytes to both hosts, and add each to the other's
+ * peers.  In rmon mode each flow is seen from both sides, so only the
+ * source is credited.  IPv4 keys are kept in network byte order, so
+ * sketch files can be merged between hosts.
+ */
+
+void
+RaTallyTalkers(struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus, void *src, void *dst, int len)
+{
+   struct ArgusMetricStruct *metric = (void *)argus->dsrs[ARGUS_METRIC_INDEX];
+   struct ArgusTopKEntryStruct *entry;
+   unsigned int saddr, daddr;
+   unsigned long long bytes = 0;
+
+   if (metric != NULL)
+      bytes = metric->src.bytes + metric->dst.bytes;
+
+   if (len == 4) {
+      saddr = htonl(*(unsigned int *)src);
+      daddr = htonl(*(unsigned int *)dst);
+      src = &saddr;
+      dst = &daddr;
+   }
+
+   entry = ArgusTopKUpdate(RaTalkers, src, len, bytes);
+   ArgusHLLAdd(entry->hll, ArgusSketchHash(dst, len));
+
+   if (!(parser->RaMonMode)) {
+      entry = ArgusTopKUpdate(RaTalkers, dst, len, bytes);
+      ArgusHLLAdd(entry->hll, ArgusSketchHash(src, len));
    }
 }
 
@@ -727,7 +956,10 @@ void ArgusWindowClose(void) {
 void
 RaPrintAddressTally(void)
 {
-   printf ("Address Summary\n");
+   if (RaApproxMode)
+      printf ("Address Summary (IPv4 estimated, +/- %.1f%%)\n", ArgusHLLError(RaIPv4AddrTally[0].hll[0]) * 100.0);
+   else
+      printf ("Address Summary\n");
    if (ArgusIPv4AddrUnicast[0] || ArgusIPv4AddrUnicast[1])
       printf ("  IPv4 Unicast              src %-10d  dst %-10d\n", ArgusIPv4AddrUnicast[0], ArgusIPv4AddrUnicast[1]);
    if (ArgusIPv4AddrUnicastThisNet[0] || ArgusIPv4AddrUnicastThisNet[1])
@@ -789,7 +1021,10 @@ RaPrintAddressTally(void)
 void
 RaPrintSrcAddressTally(void)
 {
-   printf ("Address Summary\n");
+   if (RaApproxMode)
+      printf ("Address Summary (IPv4 estimated, +/- %.1f%%)\n", ArgusHLLError(RaIPv4AddrTally[0].hll[0]) * 100.0);
+   else
+      printf ("Address Summary\n");
    if (ArgusIPv4AddrUnicast[0])
       printf ("  IPv4 Unicast              %-10d\n", ArgusIPv4AddrUnicast[0]);
    if (ArgusIPv4AddrUnicastThisNet[0])
@@ -848,6 +1083,50 @@ RaPrintSrcAddressTally(void)
       printf ("  IPv6 Multicast Global     %-10d\n", ArgusIPv6AddrMulticastGlobal[0]);
 }
 
+/*
+ * Each host's bytes are high by no more than its err, and any host
+ * not listed has at most the table's bound.
+ */
+
+void
+RaPrintTopTalkers(void)
+{
+   struct ArgusTopKEntryStruct **list;
+   unsigned int addr;
+   char *name;
+   int i, count;
+
+   if ((list = ArgusCalloc (RaTalkers->k, sizeof(*list))) == NULL)
+      ArgusLog (LOG_ERR, "RaPrintTopTalkers: ArgusCalloc error %s", strerror(errno));
+
+   count = ArgusTopKSort(RaTalkers, list);
+   if (count > RaTopTalkers)
+      count = RaTopTalkers;
+
+#if defined(__OpenBSD__) || defined(__FreeBSD__) || defined(__APPLE_CC__) || defined(__APPLE__) || defined(ARGUS_SOLARIS)
+   printf ("Top Talkers (bytes, unlisted hosts <= %lld)\n", ArgusTopKError(RaTalkers));
+#else
+   printf ("Top Talkers (bytes, unlisted hosts <= %Ld)\n", ArgusTopKError(RaTalkers));
+#endif
+   for (i = 0; i < count; i++) {
+      struct ArgusTopKEntryStruct *entry = list[i];
+
+      if (entry->len == 4) {
+         bcopy (entry->key, &addr, sizeof(addr));
+         addr = ntohl(addr);
+         name = ArgusGetName(ArgusParser, (unsigned char *)&addr);
+      } else
+         name = ArgusGetV6Name(ArgusParser, entry->key);
+
+#if defined(__OpenBSD__) || defined(__FreeBSD__) || defined(__APPLE_CC__) || defined(__APPLE__) || defined(ARGUS_SOLARIS)
+      printf ("  %-39s %-18lld err %-18lld peers %.0f\n", name, entry->count, entry->error, ArgusHLLCount(entry->hll));
+#else
+      printf ("  %-39s %-18Ld err %-18Ld peers %.0f\n", name, entry->count, entry->error, ArgusHLLCount(entry->hll));
+#endif
+   }
+   ArgusFree (list);
+}
+
 void
 RaPrintProtoTally(void)
 {
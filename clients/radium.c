@@ -574,26 +574,35 @@ RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *arg
             break;
       }
 
-      if (ns != NULL)
-         ArgusPushBackList(parser->ArgusOutput->ArgusOutputList, (struct ArgusListRecord *) ns, ARGUS_LOCK);
-   }
-
+      if (ns != NULL) {
 #if defined(ARGUS_THREADS)
-   if (parser->ArgusOutput && parser->ArgusOutput->ArgusOutputList) {
-      unsigned int cnt;
+         struct ArgusListStruct *list = parser->ArgusOutput->ArgusOutputList;
+         unsigned int cnt;
 
-      pthread_mutex_lock(&parser->ArgusOutput->ArgusOutputList->lock);
-      pthread_cond_signal(&parser->ArgusOutput->ArgusOutputList->cond);
-      cnt = parser->ArgusOutput->ArgusOutputList->count;
-      pthread_mutex_unlock(&parser->ArgusOutput->ArgusOutputList->lock);
-
-      if (cnt > ArgusClientMaxQueueDepth) {
-         struct timespec tsbuf = {0, 10000000}, *ts = &tsbuf;
-         nanosleep (ts, NULL);
+/*
+   Hand the record to the output thread with a single trip through the
+   list lock.  The output thread only sleeps on the condition when it
+   finds the list empty while holding the lock, so it only needs waking
+   when this record is the first one in the list; signalling on every
+   record just costs a futex call per record at high rates.
+*/
+         pthread_mutex_lock(&list->lock);
+         ArgusPushBackList(list, (struct ArgusListRecord *) ns, ARGUS_NOLOCK);
+         if ((cnt = list->count) == 1)
+            pthread_cond_signal(&list->cond);
+         pthread_mutex_unlock(&list->lock);
+
+         if (cnt > ArgusClientMaxQueueDepth) {
+            struct timespec tsbuf = {0, 10000000}, *ts = &tsbuf;
+            nanosleep (ts, NULL);
+         }
+#else
+         ArgusPushBackList(parser->ArgusOutput->ArgusOutputList, (struct ArgusListRecord *) ns, ARGUS_LOCK);
+#endif
       }
    }
 
-#else
+#if !defined(ARGUS_THREADS)
    ArgusListenProcess(parser);
    ArgusOutputProcess(parser->ArgusOutput);
 #endif
@@ -47,6 +47,14 @@
 #include <zlib.h>
 #endif
 
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
 #ifdef HAVE_LIBCARES
 # ifdef HAVE_NETDB_H
 #  include <netdb.h>
@@ -96,6 +104,11 @@ static int ares_query_started;
 #endif
 
 
+enum {
+   RAMANAGE_COMPRESS_GZIP = 0,
+   RAMANAGE_COMPRESS_ZSTD = 1,
+} ramanage_compress_method_e;
+
 enum {
    RAMANAGE_CMDMASK_COMPRESS = 0x1,
    RAMANAGE_CMDMASK_UPLOAD = 0x2,
@@ -113,6 +126,9 @@ typedef struct _configuration_t {
    unsigned int compress_effort;
    unsigned int compress_method;
    unsigned int compress_max_kb;
+   unsigned int compress_workers;
+   unsigned int compress_rate_kb; /* input KB/s across all workers, 0 is unlimited */
+   char *compress_ioprio;
 
    unsigned char upload_use_dns;
    char *upload_use_dns_domain; /* look for DNS SRV record in this domain */
@@ -155,6 +171,9 @@ enum RamanageOpts {
    RAMANAGE_COMPRESS_EFFORT,
    RAMANAGE_COMPRESS_METHOD,
    RAMANAGE_COMPRESS_MAX_KB,
+   RAMANAGE_COMPRESS_WORKERS,
+   RAMANAGE_COMPRESS_RATE_KB,
+   RAMANAGE_COMPRESS_IOPRIO,
    RAMANAGE_UPLOAD_USE_DNS,
    RAMANAGE_UPLOAD_USE_DNS_DOMAIN,
    RAMANAGE_UPLOAD_SERVER,
@@ -185,6 +204,9 @@ static char *RamanageResourceFileStr[] = {
    "RAMANAGE_COMPRESS_EFFORT=",
    "RAMANAGE_COMPRESS_METHOD=",
    "RAMANAGE_COMPRESS_MAX_KB=",
+   "RAMANAGE_COMPRESS_WORKERS=",
+   "RAMANAGE_COMPRESS_RATE_KB=",
+   "RAMANAGE_COMPRESS_IOPRIO=",
    "RAMANAGE_UPLOAD_USE_DNS=",
    "RAMANAGE_UPLOAD_USE_DNS_DOMAIN=",
    "RAMANAGE_UPLOAD_SERVER=",
@@ -240,6 +262,9 @@ struct {
    REG_INIT("RAMANAGE_COMPRESS_EFFORT", RAMANAGE_TYPE_UINT, compress_effort),
    REG_INIT("RAMANAGE_COMPRESS_METHOD", RAMANAGE_TYPE_UINT, compress_method),
    REG_INIT("RAMANAGE_COMPRESS_MAX_KB", RAMANAGE_TYPE_UINT, compress_max_kb),
+   REG_INIT("RAMANAGE_COMPRESS_WORKERS", RAMANAGE_TYPE_UINT, compress_workers),
+   REG_INIT("RAMANAGE_COMPRESS_RATE_KB", RAMANAGE_TYPE_UINT, compress_rate_kb),
+   REG_INIT("RAMANAGE_COMPRESS_IOPRIO", RAMANAGE_TYPE_STR, compress_ioprio),
    REG_INIT("RAMANAGE_UPLOAD_USE_DNS", RAMANAGE_TYPE_YESNO, upload_use_dns),
    REG_INIT("RAMANAGE_UPLOAD_USE_DNS_DOMAIN", RAMANAGE_TYPE_STR, upload_use_dns_domain),
    REG_INIT("RAMANAGE_UPLOAD_SERVER", RAMANAGE_TYPE_INET, upload_server),
@@ -767,19 +792,157 @@ __parse_network_address(const char * const src, struct sockaddr_storage *dst)
    return 0;
 }
 
+/* I/O priority for the compression workers: "none", "idle" or "be[:N]".
+ * Returns the ioprio_set() value, or 0 for none, in *dst.
+ */
+#define RAMANAGE_IOPRIO_CLASS_SHIFT	13
+#define RAMANAGE_IOPRIO_CLASS_BE	2
+#define RAMANAGE_IOPRIO_CLASS_IDLE	3
+
+static int
+__parse_ioprio(const char * const src, int *dst)
+{
+   char *endptr;
+   long level = 4;
+
+   *dst = 0;
+   if (src == NULL || strcasecmp(src, "none") == 0)
+      return 0;
+
+   if (strcasecmp(src, "idle") == 0) {
+      *dst = RAMANAGE_IOPRIO_CLASS_IDLE << RAMANAGE_IOPRIO_CLASS_SHIFT;
+      return 0;
+   }
+
+   if (strncasecmp(src, "be", 2) == 0) {
+      if (src[2] == ':') {
+         level = strtol(&src[3], &endptr, 10);
+         if (endptr == &src[3] || *endptr != '\0' || level < 0 || level > 7)
+            return -1;
+      } else if (src[2] != '\0')
+         return -1;
+
+      *dst = (RAMANAGE_IOPRIO_CLASS_BE << RAMANAGE_IOPRIO_CLASS_SHIFT) | level;
+      return 0;
+   }
+
+   return -1;
+}
+
+/* Compression runs as a pool of workers that take the next eligible
+ * file from the (sorted) file array.  The pool also holds the shared
+ * byte budget, the rate limit and the progress counters.
+ */
+#define RAMANAGE_MAX_WORKERS		64
+#define RAMANAGE_PROGRESS_INTERVAL	10
+
+typedef struct _ramanage_compress_pool_t {
+#if defined(ARGUS_THREADS)
+   pthread_mutex_t lock;
+#endif
+   const configuration_t *config;
+   struct ArgusFileInput **filvec;
+   size_t filcount;
+   size_t next;			/* next index of filvec to consider */
+   time_t when;			/* files older than this are compressed */
+   unsigned long long claimed_kb;
+   unsigned long long bytes_read;	/* for the rate limit */
+   unsigned long long bytes_in;
+   unsigned long long bytes_out;
+   unsigned int files;
+   unsigned int failed;
+   struct timeval start;
+   struct timeval lastreport;
+   int verbose;
+} ramanage_compress_pool_t;
+
+static inline void
+__pool_lock(ramanage_compress_pool_t *pool)
+{
+#if defined(ARGUS_THREADS)
+   pthread_mutex_lock(&pool->lock);
+#endif
+}
+
+static inline void
+__pool_unlock(ramanage_compress_pool_t *pool)
+{
+#if defined(ARGUS_THREADS)
+   pthread_mutex_unlock(&pool->lock);
+#endif
+}
+
+static double
+__elapsed(const struct timeval * const start)
+{
+   struct timeval now;
+
+   gettimeofday(&now, NULL);
+   return (now.tv_sec - start->tv_sec) +
+          (now.tv_usec - start->tv_usec) / 1000000.0;
+}
+
+/* Account for len bytes read by a worker and sleep long enough to keep
+ * the pool's combined read rate at or below RAMANAGE_COMPRESS_RATE_KB.
+ */
+static void
+__compress_throttle(ramanage_compress_pool_t *pool, size_t len)
+{
+   double allowed, ahead = 0.0;
+   double rate;
+
+   if (pool == NULL || pool->config->compress_rate_kb == 0)
+      return;
+
+   rate = pool->config->compress_rate_kb * 1024.0;
+
+   __pool_lock(pool);
+   pool->bytes_read += len;
+   allowed = __elapsed(&pool->start) * rate;
+   if (pool->bytes_read > allowed)
+      ahead = (pool->bytes_read - allowed) / rate;
+   __pool_unlock(pool);
+
+   if (ahead > 0.0)
+      usleep((useconds_t)(ahead * 1000000.0));
+}
+
+/* returns 1 if the file starts with a gzip or zstd header */
+static int
+__is_compressed(FILE *fp, const char * const filename)
+{
+   unsigned char hdr[4];
+   int magicbytes;
+   int retn = 0;
+
+   magicbytes = fread(&hdr[0], 1, 4, fp);
+   if (magicbytes >= 3 && hdr[0] == 31 && hdr[1] == 139 && hdr[2] == 8) {
+      DEBUGLOG(2, "skipping gzipped file %s\n", filename);
+      retn = 1;
+   } else if (magicbytes == 4 && hdr[0] == 0x28 && hdr[1] == 0xb5 &&
+              hdr[2] == 0x2f && hdr[3] == 0xfd) {
+      DEBUGLOG(2, "skipping zstd compressed file %s\n", filename);
+      retn = 1;
+   }
+   rewind(fp);
+   return retn;
+}
+
 #ifdef HAVE_ZLIB_H
-/* __gzip() returns 0 on success, -1 otherwise. */
+/* __gzip() returns 0 on success, 1 if the file is already compressed
+ * and -1 otherwise.
+ */
 static int
 __gzip(const char * const filename, const char * const gzfilename,
-       off_t filesz, unsigned char *buf, size_t buflen)
+       off_t filesz, unsigned char *buf, size_t buflen,
+       unsigned int level, ramanage_compress_pool_t *pool)
 {
    gzFile gzfp;
    FILE *fp;
    size_t remain;
    size_t blocks;
    int gzerr;
-   unsigned char hdr[3];
-   int magicbytes;
+   char gzmode[16];
 
    fp = fopen(filename, "rb");
    if (fp == NULL) {
@@ -787,28 +950,25 @@ __gzip(const char * const filename, const char * const gzfilename,
       return -1;
    }
 
-   /* don't try to gzip a gzip file */
-   magicbytes = fread(&hdr[0], 1, 3, fp);
-   if (magicbytes == 3) {
-      if (hdr[0] == 31 && hdr[1] == 139 && hdr[2] == 8) {
-         DEBUGLOG(2, "skipping gzipped file %s\n", filename);
-         fclose(fp);
-         return -1;
-      }
+   /* don't try to gzip a compressed file */
+   if (__is_compressed(fp, filename)) {
+      fclose(fp);
+      return 1;
    }
-   rewind(fp);
 
-   gzfp = gzopen(gzfilename,"wb");
+   /* level zero means the zlib default */
+   if (level > 0)
+      snprintf(gzmode, sizeof(gzmode), "wb%u", level);
+   else
+      snprintf(gzmode, sizeof(gzmode), "wb");
+
+   gzfp = gzopen(gzfilename, gzmode);
    if (gzfp == NULL) {
       ArgusLog(LOG_WARNING, "unable to open file %s\n", gzfilename);
       fclose(fp);
       return -1;
    }
 
-   /* note: use gzsetparams OF((gzFile file, int level, int strategy)) to set
-    * compression level
-    */
-
    remain = filesz;
    gzerr = 0;
 
@@ -823,6 +983,7 @@ __gzip(const char * const filename, const char * const gzfilename,
       }
 
       remain -= buflen;
+      __compress_throttle(pool, buflen);
    }
 
    if (remain > 0 && remain < buflen && !gzerr) {
@@ -834,6 +995,7 @@ __gzip(const char * const filename, const char * const gzfilename,
                   "failed writing last bytes of gzip file\n");
          gzerr = -1;
       }
+      __compress_throttle(pool, remain);
    }
 
    if (!gzerr && gzclose(gzfp) != Z_OK) {
@@ -852,6 +1014,101 @@ __gzip(const char * const filename, const char * const gzfilename,
 }
 #endif
 
+#ifdef HAVE_LIBZSTD
+/* __zstd() returns 0 on success, 1 if the file is already compressed
+ * and -1 otherwise.  As with __gzip(), only the filesz bytes the file
+ * had when it was listed are compressed.
+ */
+static int
+__zstd(const char * const filename, const char * const zfilename,
+       off_t filesz, unsigned char *buf, size_t buflen,
+       unsigned int level, ramanage_compress_pool_t *pool)
+{
+   ZSTD_CCtx *cctx;
+   FILE *fp, *zfp;
+   size_t obuflen = ZSTD_CStreamOutSize();
+   unsigned char *obuf;
+   size_t remain = filesz;
+   int zerr = 0;
+   int done = 0;
+
+   fp = fopen(filename, "rb");
+   if (fp == NULL) {
+      ArgusLog(LOG_WARNING, "unable to open file %s\n", filename);
+      return -1;
+   }
+
+   if (__is_compressed(fp, filename)) {
+      fclose(fp);
+      return 1;
+   }
+
+   zfp = fopen(zfilename, "wb");
+   if (zfp == NULL) {
+      ArgusLog(LOG_WARNING, "unable to open file %s\n", zfilename);
+      fclose(fp);
+      return -1;
+   }
+
+   if ((cctx = ZSTD_createCCtx()) == NULL)
+      ArgusLog(LOG_ERR, "unable to allocate zstd context\n");
+   if ((obuf = ArgusMalloc(obuflen)) == NULL)
+      ArgusLog(LOG_ERR, "unable to allocate memory for zstd buffer\n");
+
+   /* level zero means the zstd default */
+   ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, level);
+   ZSTD_CCtx_setParameter(cctx, ZSTD_c_checksumFlag, 1);
+
+   while (!done && !zerr) {
+      size_t want = (remain < buflen) ? remain : buflen;
+      size_t nread = want ? fread(buf, 1, want, fp) : 0;
+      ZSTD_EndDirective mode;
+      ZSTD_inBuffer in = { buf, nread, 0 };
+      int finished = 0;
+
+      if (ferror(fp)) {
+         zerr = -1;
+         break;
+      }
+      remain -= nread;
+      done = (remain == 0) || (nread < want);
+      mode = done ? ZSTD_e_end : ZSTD_e_continue;
+
+      while (!finished && !zerr) {
+         ZSTD_outBuffer out = { obuf, obuflen, 0 };
+         size_t rem = ZSTD_compressStream2(cctx, &out, &in, mode);
+
+         if (ZSTD_isError(rem)) {
+            ArgusLog(LOG_WARNING, "zstd compression failed: %s\n",
+                     ZSTD_getErrorName(rem));
+            zerr = -1;
+         } else if (fwrite(obuf, 1, out.pos, zfp) != out.pos) {
+            ArgusLog(LOG_WARNING, "failed writing zstd file\n");
+            zerr = -1;
+         }
+         finished = done ? (rem == 0) : (in.pos == in.size);
+      }
+      __compress_throttle(pool, nread);
+   }
+
+   if (fclose(zfp) != 0 && !zerr) {
+      ArgusLog(LOG_WARNING, "failed to flush and close zstd file %s\n",
+               zfilename);
+      zerr = -1;
+   }
+
+   if (zerr) {
+      ArgusLog(LOG_WARNING, "removing failed zstd file %s\n", zfilename);
+      unlink(zfilename);
+   }
+
+   ZSTD_freeCCtx(cctx);
+   ArgusFree(obuf);
+   fclose(fp);
+   return zerr;
+}
+#endif
+
 #ifdef HAVE_LIBCURL
 # include <curl/curl.h>
 #else
@@ -1333,22 +1590,51 @@ RamanageConfigureParse(struct ArgusParserStruct *parser,
          retn = __parse_str(optarg, &global_config.lockfile, PATH_MAX);
          break;
       case RAMANAGE_COMPRESS_EFFORT:
+         /* the range depends on the method, checked in RamanageConfigure() */
          retn = __parse_uint(optarg, &global_config.compress_effort);
-         if (retn == 0 && global_config.compress_effort > 9) {
-            ArgusLog(LOG_WARNING, "RAMANAGE_COMPRESS_EFFORT must be <= 9\n");
-            retn = -1;
-         }
          break;
       case RAMANAGE_COMPRESS_METHOD:
-         retn = __parse_str(optarg, &global_config.upload_dir, NAME_MAX);
-         if (retn == 0 && strcasecmp(global_config.upload_dir, "gzip") != 0) {
-            ArgusLog(LOG_WARNING, "only gzip compression is supported\n");
-            retn = -1;
-         }
+         if (strcasecmp(optarg, "gzip") == 0) {
+#ifdef HAVE_ZLIB_H
+            global_config.compress_method = RAMANAGE_COMPRESS_GZIP;
+            retn = 0;
+#else
+            ArgusLog(LOG_WARNING, "no gzip support, only zstd compression is supported\n");
+#endif
+         } else if (strcasecmp(optarg, "zstd") == 0) {
+#ifdef HAVE_LIBZSTD
+            global_config.compress_method = RAMANAGE_COMPRESS_ZSTD;
+            retn = 0;
+#else
+            ArgusLog(LOG_WARNING, "no zstd support, only gzip compression is supported\n");
+#endif
+         } else
+            ArgusLog(LOG_WARNING, "only gzip and zstd compression are supported\n");
          break;
       case RAMANAGE_COMPRESS_MAX_KB:
          retn = __parse_uint(optarg, &global_config.compress_max_kb);
          break;
+      case RAMANAGE_COMPRESS_WORKERS:
+         retn = __parse_uint(optarg, &global_config.compress_workers);
+         if (retn == 0 && global_config.compress_workers > RAMANAGE_MAX_WORKERS) {
+            ArgusLog(LOG_WARNING, "RAMANAGE_COMPRESS_WORKERS must be <= %d\n",
+                     RAMANAGE_MAX_WORKERS);
+            retn = -1;
+         }
+         break;
+      case RAMANAGE_COMPRESS_RATE_KB:
+         retn = __parse_uint(optarg, &global_config.compress_rate_kb);
+         break;
+      case RAMANAGE_COMPRESS_IOPRIO: {
+         int ioprio;
+
+         retn = __parse_str(optarg, &global_config.compress_ioprio, NAME_MAX);
+         if (retn == 0 && __parse_ioprio(global_config.compress_ioprio, &ioprio) < 0) {
+            ArgusLog(LOG_WARNING, "RAMANAGE_COMPRESS_IOPRIO must be none, idle or be[:0-7]\n");
+            retn = -1;
+         }
+         break;
+      }
       case RAMANAGE_UPLOAD_USE_DNS:
          retn = __parse_yesno(optarg, &global_config.upload_use_dns);
          break;
@@ -1472,6 +1758,20 @@ RamanageConfigure(struct ArgusParserStruct * const parser,
    }
 #endif
 
+   if (config->compress_method == RAMANAGE_COMPRESS_GZIP &&
+       config->compress_effort > 9)
+      ArgusLog(LOG_ERR, "RAMANAGE_COMPRESS_EFFORT must be <= 9 for gzip\n");
+#if !defined(HAVE_ZLIB_H) && defined(HAVE_LIBZSTD)
+   /* gzip is the default, so fall back to zstd when it's all there is */
+   config->compress_method = RAMANAGE_COMPRESS_ZSTD;
+#endif
+#ifdef HAVE_LIBZSTD
+   if (config->compress_method == RAMANAGE_COMPRESS_ZSTD &&
+       config->compress_effort > ZSTD_maxCLevel())
+      ArgusLog(LOG_ERR, "RAMANAGE_COMPRESS_EFFORT must be <= %d for zstd\n",
+               ZSTD_maxCLevel());
+#endif
+
 #ifndef HAVE_LIBCARES
    if (config->upload_use_dns)
       ArgusLog(LOG_WARNING,
@@ -1482,92 +1782,226 @@ RamanageConfigure(struct ArgusParserStruct * const parser,
 }
 
 
-#ifdef HAVE_ZLIB_H
-static int
-RamanageCompress(const struct ArgusParserStruct * const parser,
-                 struct ArgusFileInput **filvec, size_t filcount,
-                 const configuration_t * const config)
+#if defined(HAVE_ZLIB_H) || defined(HAVE_LIBZSTD)
+static void
+__compress_report(ramanage_compress_pool_t *pool, const char * const what)
 {
-   static const size_t buflen = 32*1024;
+   double secs = __elapsed(&pool->start);
+   double ratio = pool->bytes_in ?
+                  (double)pool->bytes_out / pool->bytes_in : 0.0;
+
+   ArgusLog(LOG_INFO, "compress %s: %u files %llu KB -> %llu KB (%.2f) "
+            "in %.1f secs, %.2f MB/s, %u failed\n", what, pool->files,
+            pool->bytes_in / 1024, pool->bytes_out / 1024, ratio, secs,
+            secs > 0.0 ? (pool->bytes_in / 1048576.0) / secs : 0.0,
+            pool->failed);
+}
+
+/* Take the next file to compress, or NULL when done.  Files are taken
+ * in array order, and once the amount claimed exceeds
+ * RAMANAGE_COMPRESS_MAX_KB no more files are started.
+ */
+static struct ArgusFileInput *
+__compress_next(ramanage_compress_pool_t *pool)
+{
+   const configuration_t * const config = pool->config;
+   struct ArgusFileInput *file = NULL;
+
+   __pool_lock(pool);
+   while (pool->next < pool->filcount && file == NULL) {
+      if (config->compress_max_kb && pool->claimed_kb > config->compress_max_kb) {
+         pool->next = pool->filcount;
+         break;
+      }
+      if (__file_older_than(pool->filvec[pool->next], pool->when)) {
+         file = pool->filvec[pool->next];
+         pool->claimed_kb += file->statbuf.st_size / 1024;
+      }
+      pool->next++;
+   }
+   __pool_unlock(pool);
+   return file;
+}
+
+static void *
+RamanageCompressWorker(void *arg)
+{
+   static const size_t buflen = 128*1024;
+   ramanage_compress_pool_t *pool = arg;
+   const configuration_t * const config = pool->config;
    struct ArgusFileInput *file;
-   time_t when; /* files older than this are compressed */
+   const char *ext;
    char *gzfilename;
    char *origfilename;
    unsigned char *buf;
-   int gzerr;
    struct utimbuf ut;
-   unsigned int compress_kb = 0;
-   size_t i;
+   off_t origsize;
+   int ioprio;
+   int gzerr;
 
+#if defined(__linux__) && defined(SYS_ioprio_set)
+   /* 1 == IOPRIO_WHO_PROCESS, and 0 is the calling thread */
+   if (__parse_ioprio(config->compress_ioprio, &ioprio) == 0 && ioprio)
+      if (syscall(SYS_ioprio_set, 1, 0, ioprio) < 0)
+         ArgusLog(LOG_WARNING, "unable to set compression I/O priority: %s\n",
+                  strerror(errno));
+#else
+   (void)ioprio;
+#endif
+
+   ext = (config->compress_method == RAMANAGE_COMPRESS_ZSTD) ? "zst" : "gz";
 
    gzfilename = ArgusMalloc(PATH_MAX);
    if (gzfilename == NULL)
-      ArgusLog(LOG_ERR, "unable to allocate memory for gzip filename\n");
+      ArgusLog(LOG_ERR, "unable to allocate memory for compressed filename\n");
 
    buf = ArgusMalloc(buflen);
    if (buf == NULL)
-      ArgusLog(LOG_ERR, "unable to allocate memory for gzip buffer\n");
+      ArgusLog(LOG_ERR, "unable to allocate memory for compression buffer\n");
 
-   when = __days_ago(&parser->ArgusRealTime, config->rpolicy_compress_after);
-   i = 0;
-   while (i < filcount && compress_kb <= config->compress_max_kb) {
-      file = filvec[i];
-      if (__file_older_than(file, when)) {
-         int slen;
+   while ((file = __compress_next(pool)) != NULL) {
+      int slen;
 
-         slen = snprintf(gzfilename, PATH_MAX, "%s.gz", file->filename);
-         if (slen >= PATH_MAX) {
-            ArgusLog(LOG_WARNING, "filename too long with .gz extension: %s\n",
-                     file->filename);
-            i++;
-            continue;
-         }
+      origsize = file->statbuf.st_size;
+      slen = snprintf(gzfilename, PATH_MAX, "%s.%s", file->filename, ext);
+      if (slen >= PATH_MAX) {
+         ArgusLog(LOG_WARNING, "filename too long with .%s extension: %s\n",
+                  ext, file->filename);
+         gzerr = -1;
+      } else {
          DEBUGLOG(4, "compress file %s -> %s\n", file->filename, gzfilename);
+#ifdef HAVE_LIBZSTD
+         if (config->compress_method == RAMANAGE_COMPRESS_ZSTD)
+            gzerr = __zstd(file->filename, gzfilename, origsize, buf, buflen,
+                           config->compress_effort, pool);
+         else
+#endif
+#ifdef HAVE_ZLIB_H
+         gzerr = __gzip(file->filename, gzfilename, origsize, buf, buflen,
+                        config->compress_effort, pool);
+#else
+         gzerr = -1;
+#endif
+      }
 
-         gzerr = __gzip(file->filename, gzfilename, file->statbuf.st_size,
-                        buf, buflen);
-
-         if (gzerr) {
-            i++;
-            continue;
-         }
-
-         compress_kb += file->statbuf.st_size / 1024;
-
-         /* Make the new gzip file's attributes look like those of the
-          * original file.  Copy timestamps, ownerhip and permissions
-          * to the new file.  Then remove the original, uncompressed,
-          * file and update the filename and attributes in the linked
-          * list so that subsequent ramanage commands operate on the
-          * gzip file.
-          */
+      if (gzerr) {
+         __pool_lock(pool);
+         pool->claimed_kb -= origsize / 1024;
+         if (gzerr < 0)
+            pool->failed++;
+         __pool_unlock(pool);
+         continue;
+      }
 
-         ut.actime = file->statbuf.st_atime;
-         ut.modtime = file->statbuf.st_mtime;
-         if (utime(gzfilename, &ut) < 0)
-            ArgusLog(LOG_WARNING, "failed to update timestamp on file %s\n",
-                     gzfilename);
-         if (chmod(gzfilename, file->statbuf.st_mode) < 0)
-            ArgusLog(LOG_WARNING,
-                     "failed to update permissions on file %s\n", gzfilename);
-         if (chown(gzfilename, file->statbuf.st_uid, file->statbuf.st_gid) < 0)
-            ArgusLog(LOG_WARNING, "failed to update ownership of file %s\n",
-                     gzfilename);
-         origfilename = file->filename;
-         file->filename = strdup(gzfilename);
-         if (file->filename == NULL)
-            ArgusLog(LOG_ERR, "unable to update filename in list\n");
-         if (stat(file->filename, &file->statbuf) < 0 )
-            ArgusLog(LOG_ERR, "unable to stat new gzip file\n");
-         unlink(origfilename);
-         free(origfilename);
+      /* Make the new compressed file's attributes look like those of the
+       * original file.  Copy timestamps, ownerhip and permissions
+       * to the new file.  Then remove the original, uncompressed,
+       * file and update the filename and attributes in the linked
+       * list so that subsequent ramanage commands operate on the
+       * compressed file.
+       */
 
+      ut.actime = file->statbuf.st_atime;
+      ut.modtime = file->statbuf.st_mtime;
+      if (utime(gzfilename, &ut) < 0)
+         ArgusLog(LOG_WARNING, "failed to update timestamp on file %s\n",
+                  gzfilename);
+      if (chmod(gzfilename, file->statbuf.st_mode) < 0)
+         ArgusLog(LOG_WARNING,
+                  "failed to update permissions on file %s\n", gzfilename);
+      if (chown(gzfilename, file->statbuf.st_uid, file->statbuf.st_gid) < 0)
+         ArgusLog(LOG_WARNING, "failed to update ownership of file %s\n",
+                  gzfilename);
+      origfilename = file->filename;
+      file->filename = strdup(gzfilename);
+      if (file->filename == NULL)
+         ArgusLog(LOG_ERR, "unable to update filename in list\n");
+      if (stat(file->filename, &file->statbuf) < 0 )
+         ArgusLog(LOG_ERR, "unable to stat new compressed file\n");
+      unlink(origfilename);
+      free(origfilename);
+
+      __pool_lock(pool);
+      pool->files++;
+      pool->bytes_in += origsize;
+      pool->bytes_out += file->statbuf.st_size;
+      if (pool->verbose &&
+          __elapsed(&pool->lastreport) >= RAMANAGE_PROGRESS_INTERVAL) {
+         gettimeofday(&pool->lastreport, NULL);
+         __compress_report(pool, "progress");
       }
-      i++;
+      __pool_unlock(pool);
    }
 
    ArgusFree(gzfilename);
    ArgusFree(buf);
+   return NULL;
+}
+
+static int
+RamanageCompress(const struct ArgusParserStruct * const parser,
+                 struct ArgusFileInput **filvec, size_t filcount,
+                 const configuration_t * const config)
+{
+   ramanage_compress_pool_t pool;
+   unsigned int workers = config->compress_workers;
+
+   memset(&pool, 0, sizeof(pool));
+   pool.config = config;
+   pool.filvec = filvec;
+   pool.filcount = filcount;
+   pool.when = __days_ago(&parser->ArgusRealTime, config->rpolicy_compress_after);
+   pool.verbose = parser->Vflag;
+   gettimeofday(&pool.start, NULL);
+   pool.lastreport = pool.start;
+
+   if (workers == 0)
+      workers = 1;
+   if (workers > filcount)
+      workers = filcount ? filcount : 1;
+
+#if defined(ARGUS_THREADS)
+   if (workers > 1) {
+      pthread_t tids[RAMANAGE_MAX_WORKERS];
+      unsigned int i, started = 0;
+
+      pthread_mutex_init(&pool.lock, NULL);
+      for (i = 0; i < workers; i++) {
+         int rv = pthread_create(&tids[i], NULL, RamanageCompressWorker, &pool);
+
+         if (rv != 0) {
+            ArgusLog(LOG_WARNING, "unable to start compression worker: %s\n",
+                     strerror(rv));
+            break;
+         }
+         started++;
+      }
+
+      /* if no worker could be started, do the work here */
+      if (started == 0)
+         RamanageCompressWorker(&pool);
+
+      for (i = 0; i < started; i++)
+         pthread_join(tids[i], NULL);
+      pthread_mutex_destroy(&pool.lock);
+   } else
+#endif
+   {
+#if defined(ARGUS_THREADS)
+      pthread_mutex_init(&pool.lock, NULL);
+#endif
+      RamanageCompressWorker(&pool);
+#if defined(ARGUS_THREADS)
+      pthread_mutex_destroy(&pool.lock);
+#endif
+   }
+
+   DEBUGLOG(1, "%s: %u files, %llu KB in, %llu KB out, %u failed\n", __func__,
+            pool.files, pool.bytes_in / 1024, pool.bytes_out / 1024,
+            pool.failed);
+   if (pool.verbose)
+      __compress_report(&pool, "done");
+
    return 0;
 }
 #endif
@@ -2082,7 +2516,7 @@ main(int argc, char **argv)
    }
 #endif
 
-#ifdef HAVE_ZLIB_H
+#if defined(HAVE_ZLIB_H) || defined(HAVE_LIBZSTD)
    if (cmdmask & RAMANAGE_CMDMASK_COMPRESS) {
       cmdres = RamanageCompress(parser, &filvec[filindex], filcount,
                                 &global_config);
@@ -40,6 +40,8 @@
 
 #include <unistd.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <sys/wait.h>
 
 #include <ranonymize.h>
 
@@ -48,6 +50,16 @@
 unsigned int RaMapHash = 0;
 unsigned int RaHashSize  = 1024;
 
+/*
+ * "-M jobs=N" with "-M replace" forks N workers that each anonymize
+ * every Nth input file.  In replace mode every file is anonymized
+ * with its own maps anyway, so the only shared state the workers
+ * need is the prefix preserving key, which is set before the fork.
+ */
+
+int RaAnonJobs = 1;
+int RaAnonWorker = -1;
+
 char *RaNonEthernetAnonmyization = "sequential";
 int RaMacAnonymize = 1;
 char *RaNonIPAnonmyization = NULL;
@@ -114,7 +126,7 @@ void ArgusAnonymizeCountryCode(struct ArgusParserStruct *, struct ArgusRecordStr
 unsigned char RaMapInventoryToTTL (void *, int, int);
 
 struct RaMapHashTableStruct {
-   int size;
+   int size, count;
    struct RaMapHashTableHeader **array;
 };
 
@@ -168,6 +180,7 @@ char *RaNonASNumOffset = "random";
 #define RANON_SUBNET            1
 #define RANON_CLASS             2
 #define RANON_CIDR              3
+#define RANON_PREFIX            4
 
 #define RANON_RANDOM            1
 #define RANON_SHIFT             2
@@ -176,6 +189,34 @@ char *RaNonASNumOffset = "random";
 char *RaNonPreserveNetAddrHierarchy = "class";
 unsigned int RaMapNetAddrHierarchy = RANON_CLASS;
 
+/*
+ * Prefix preserving anonymization, in the style of Crypto-PAn.  Bit i
+ * of the address is flipped by a keyed pseudo random function of the
+ * i leading bits, so two addresses that share a k bit prefix map to
+ * addresses that share a k bit prefix, and no mapping table is needed.
+ * The PRF is SipHash-2-4, keyed with RANON_PREFIX_KEY, or with a key
+ * drawn from the RANON_SEED generator.  The results are kept in a
+ * direct mapped cache, as most of the addresses in a file repeat.
+ */
+
+#define RANON_PREFIX_CACHE_SIZE		0x10000
+
+struct RaMapPrefixCacheStruct {
+   unsigned int addr, value;
+   int valid;
+};
+
+char *RaNonPrefixKey = NULL;
+uint64_t RaMapPrefixKey[2];
+int RaMapPrefixKeyed = 0;
+struct RaMapPrefixCacheStruct *RaMapPrefixCache = NULL;
+
+static uint64_t RaMapSipHash (uint64_t, uint64_t, uint64_t);
+static void RaMapSetPrefixKey (void);
+static unsigned int RaMapPrefixPad (unsigned int);
+unsigned int RaMapPrefixPreserve (unsigned int);
+static void RaAnonForkJobs (struct ArgusParserStruct *);
+
 
 #define ARGUS_ADD_OPTION		1
 #define ARGUS_SUB_OPTION		2
@@ -241,11 +282,19 @@ ArgusClientInit (struct ArgusParserStruct *parser)
             if (!(strncasecmp (mode->mode, "noman", 5)))
                parser->ArgusPrintMan = 0;
             else
-            if (!(strncasecmp ("replace", mode->mode, strlen("replace")))) {
-               ArgusProcessFileIndependantly = 1;
-               parser->ArgusReplaceMode++;
-               if ((parser->ArgusWfileList != NULL) && (!(ArgusListEmpty(parser->ArgusWfileList)))) {
-                  ArgusLog (LOG_ERR, "replace mode and -w option are incompatible\n");
+            if (!(strncasecmp ("replace", mode->mode, strlen("replace"))) ||
+                !(strncasecmp ("jobs=", mode->mode, strlen("jobs=")))) {
+               if (!(strncasecmp ("jobs=", mode->mode, strlen("jobs=")))) {
+                  char *endptr = NULL;
+                  RaAnonJobs = strtol(&mode->mode[5], &endptr, 10);
+                  if ((endptr == &mode->mode[5]) || (RaAnonJobs < 1))
+                     ArgusLog (LOG_ERR, "jobs value %s invalid\n", &mode->mode[5]);
+               } else {
+                  ArgusProcessFileIndependantly = 1;
+                  parser->ArgusReplaceMode++;
+                  if ((parser->ArgusWfileList != NULL) && (!(ArgusListEmpty(parser->ArgusWfileList)))) {
+                     ArgusLog (LOG_ERR, "replace mode and -w option are incompatible\n");
+                  }
                }
                if (pmode) {
                   pmode->nxt = mode->nxt;
@@ -283,12 +332,14 @@ ArgusClientInit (struct ArgusParserStruct *parser)
          ArgusLog (LOG_ERR, "RaMapInit: ArgusCalloc error %s\n", strerror(errno));
 
       RaMapHashTable.size = RaHashSize;
+      RaMapHashTable.count = 0;
 
       if ((RaMapNetTable.array = (struct RaMapHashTableHeader **)
                   ArgusCalloc (RaHashSize, sizeof (struct RaMapHashTableHeader))) == NULL)
          ArgusLog (LOG_ERR, "RaMapInit: ArgusCalloc error %s\n", strerror(errno));
 
       RaMapNetTable.size = RaHashSize;
+      RaMapNetTable.count = 0;
 
       if (parser->ArgusFlowModelFile)
          if ((RaNonParseResourceFile (parser->ArgusFlowModelFile)) < 0)
@@ -392,6 +443,10 @@ ArgusClientInit (struct ArgusParserStruct *parser)
                ArgusLog(LOG_ERR, "RANON_TIME_USEC_OFFSET syntax error\n");
       }
 
+      if (!(strncmp(RaNonPreserveNetAddrHierarchy, "prefix", 6))) {
+         RaMapNetAddrHierarchy = RANON_PREFIX;
+         RaMapSetPrefixKey();
+      } else
       if (!(strncmp(RaNonPreserveNetAddrHierarchy, "cidr", 4))) {
          RaMapNetAddrHierarchy = RANON_CIDR;
       } else {
@@ -508,7 +563,67 @@ ArgusClientInit (struct ArgusParserStruct *parser)
          }
       }
 
+      if ((RaAnonJobs > 1) && (RaAnonWorker < 0))
+         RaAnonForkJobs (parser);
+   }
+}
+
+/*
+ * RaAnonForkJobs - split the input files across RaAnonJobs worker
+ * processes.  The parent waits for the workers and exits with the
+ * first failing status.
+ */
+
+static void
+RaAnonForkJobs (struct ArgusParserStruct *parser)
+{
+   struct ArgusFileInput *file, *nxt, *tail = NULL;
+   int i, status, retn = 0;
+   pid_t pid;
+
+   if (!(parser->ArgusReplaceMode))
+      ArgusLog (LOG_ERR, "jobs option requires replace mode\n");
+
+   for (i = 0; i < RaAnonJobs; i++) {
+      if ((pid = fork()) < 0)
+         ArgusLog (LOG_ERR, "RaAnonForkJobs: fork error %s\n", strerror(errno));
+
+      if (pid == 0) {
+         RaAnonWorker = i;
+         break;
+      }
+   }
+
+   if (RaAnonWorker < 0) {
+      while (wait(&status) > 0)
+         if ((retn == 0) && (!(WIFEXITED(status)) || WEXITSTATUS(status)))
+            retn = 1;
+      exit(retn);
+   }
+
+   file = parser->ArgusInputFileList;
+   parser->ArgusInputFileList = NULL;
+
+   for (i = 0; file != NULL; i++, file = nxt) {
+      nxt = (struct ArgusFileInput *) file->qhdr.nxt;
+      if ((i % RaAnonJobs) == RaAnonWorker) {
+         file->qhdr.nxt = NULL;
+         if (tail != NULL)
+            tail->qhdr.nxt = &file->qhdr;
+         else
+            parser->ArgusInputFileList = file;
+         tail = file;
+      } else
+         ArgusFileFree(file);
    }
+   parser->ArgusInputFileListTail = tail;
+
+   if (parser->ArgusInputFileList == NULL)
+      exit(0);
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (1, "RaAnonForkJobs: worker %d of %d started\n", RaAnonWorker, RaAnonJobs);
+#endif
 }
 
 void
@@ -620,6 +735,7 @@ usage ()
    fprintf (stdout, "usage: %s [-M [modes] [+|-]dsr [dsr ...]] [ra-options]\n\n", ArgusParser->ArgusProgramName);
 
    fprintf (stdout, "options: -M replace      nonymize dsrs and overwrite current file.\n");
+   fprintf (stdout, "            jobs=<N>     with replace, anonymize the files using N processes.\n");
    fprintf (stdout, "            [+|-] dsrs   [add|subtract] dsrs from records.\n");
    fprintf (stdout, "               dsrs:     stime, ltime, count, dur, avgdur,\n");
    fprintf (stdout, "                         srcid, ind, mac, dir, jitter, status, user,\n");
@@ -1400,6 +1516,14 @@ RaMapInventory (void *oid, int type, int len)
       }
 
       case RAMAP_IP_ADDR: {
+         if (RaIPAnonymize && (RaMapNetAddrHierarchy == RANON_PREFIX)) {
+            if (RaMapConvert) {
+               if ((retn = RaMapFindHashObject (&RaMapHashTable, oid, type, len)) && retn->sub)
+                  bcopy ((char *)retn->sub, (char *) oid, len);
+               else
+                  *(unsigned int *)oid = RaMapPrefixPreserve (*(unsigned int *)oid);
+            }
+         } else
          if (RaIPAnonymize) {
             if (!(retn = RaMapFindHashObject (&RaMapHashTable, oid, type, len))) {
                if (!(retn = RaMapAllocateIPAddr (oid, type, len)))
@@ -1451,11 +1575,18 @@ RaMapInventoryToTTL (void *oid, int type, int len)
 }
 
 
+/*
+ * RaMapCalcHash - FNV-1a over the object bytes, with a murmur3
+ * finalizer, so that the sequential addresses and AS numbers
+ * that make up most of the keys spread over the whole table.
+ */
+
 unsigned int
 RaMapCalcHash (void *obj, int type, int len)
 {
-   u_char buf[MAX_OBJ_SIZE];
-   unsigned int retn = 0;
+   unsigned char *ptr = (unsigned char *) obj;
+   unsigned int hash = 2166136261U;
+   int i;
 
    switch (type) {
       case RAMAP_ETHER_MAC_ADDR:
@@ -1468,49 +1599,64 @@ RaMapCalcHash (void *obj, int type, int len)
           break;
 
       default:
+          if (len > MAX_OBJ_SIZE)
+             len = MAX_OBJ_SIZE;
           break;
    }
 
-   bzero (buf, sizeof buf);
-
-   if (RaHashSize <= 0x100) {
-      unsigned char hash = 0, *ptr = (unsigned char *) buf;
-      int i, nitems = len;
-
-      bcopy ((char *) obj, (char *) &buf, len);
-
-      for (i = 0; i < nitems; i++)
-         hash += *ptr++;
-
-      retn = hash;
-
-   } else
-   if (RaHashSize <= 0x10000) {
-      unsigned short hash = 0, *ptr = (unsigned short *) buf;
-      int i, nitems = (len / sizeof(unsigned short)) + 2;
-
-      bcopy ((char *) obj, &buf[1], len);
-
-      for (i = 0; i < nitems; i++)
-         hash += *ptr++;
-
-      retn = hash;
+   for (i = 0; i < len; i++) {
+      hash ^= ptr[i];
+      hash *= 16777619U;
+   }
 
-   } else {
-      unsigned int hash = 0, *ptr = (unsigned int *) buf;
-      int i, nitems = (len /sizeof(unsigned int)) + 2;
+   hash ^= hash >> 16;
+   hash *= 0x85ebca6bU;
+   hash ^= hash >> 13;
+   hash *= 0xc2b2ae35U;
+   hash ^= hash >> 16;
 
-      bcopy ((char *) obj, &buf[3], len);
+   return (hash);
+}
 
-      for (i = 0; i < nitems; i++)
-         hash += *ptr++;
+/*
+ * RaMapGrowHashTable - double the table when the chains average
+ * more than two entries, rehashing with the stored hash values.
+ */
 
-      retn = hash;
+static void
+RaMapGrowHashTable (struct RaMapHashTableStruct *table)
+{
+   struct RaMapHashTableHeader **array, *head, *target, *nxt, *start;
+   int i, size = table->size * 2;
+
+   if ((array = (struct RaMapHashTableHeader **) ArgusCalloc (size, sizeof(*array))) == NULL)
+      ArgusLog (LOG_ERR, "RaMapGrowHashTable: ArgusCalloc error %s\n", strerror(errno));
+
+   for (i = 0; i < table->size; i++) {
+      if ((head = table->array[i]) != NULL) {
+         head->prv->nxt = NULL;
+         for (target = head; target != NULL; target = nxt) {
+            nxt = target->nxt;
+            if ((start = array[target->hash % size]) != NULL) {
+               target->nxt = start;
+               target->prv = start->prv;
+               target->prv->nxt = target;
+               target->nxt->prv = target;
+            } else
+               target->prv = target->nxt = target;
+            array[target->hash % size] = target;
+         }
+      }
    }
 
-   return (retn);
-}
+   ArgusFree(table->array);
+   table->array = array;
+   table->size  = size;
 
+#ifdef ARGUSDEBUG
+   ArgusDebug (3, "RaMapGrowHashTable (%p) size %d count %d\n", table, table->size, table->count);
+#endif
+}
 
 
 struct RaMapHashTableHeader *
@@ -1569,6 +1715,9 @@ RaMapAddHashEntry (struct RaMapHashTableStruct *table, void *oid, int type, int
          retn->prv = retn->nxt = retn;
 
       table->array[RaMapHash % table->size] = retn;
+
+      if (++table->count > (table->size * 2))
+         RaMapGrowHashTable (table);
    }
 
 #ifdef TCPCLEANDEBUG
@@ -1582,7 +1731,7 @@ RaMapAddHashEntry (struct RaMapHashTableStruct *table, void *oid, int type, int
 void
 RaMapRemoveHashEntry (struct RaMapHashTableStruct *table, struct RaMapHashTableHeader *htblhdr)
 {
-   unsigned short hash = htblhdr->hash;
+   unsigned int hash = htblhdr->hash;
 
    htblhdr->prv->nxt = htblhdr->nxt;
    htblhdr->nxt->prv = htblhdr->prv;
@@ -1593,6 +1742,7 @@ RaMapRemoveHashEntry (struct RaMapHashTableStruct *table, struct RaMapHashTableH
       else
          table->array[hash % table->size] = htblhdr->nxt;
    }
+   table->count--;
 
    ArgusFree (htblhdr);
 
@@ -1602,7 +1752,141 @@ RaMapRemoveHashEntry (struct RaMapHashTableStruct *table, struct RaMapHashTableH
 }
 
 
-#define RANON_RCITEMS				35
+#define RANON_ROTL(x, b)	(uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+
+#define RANON_SIPROUND			\
+   do {					\
+      v0 += v1; v1 = RANON_ROTL(v1, 13);	\
+      v1 ^= v0; v0 = RANON_ROTL(v0, 32);	\
+      v2 += v3; v3 = RANON_ROTL(v3, 16);	\
+      v3 ^= v2;				\
+      v0 += v3; v3 = RANON_ROTL(v3, 21);	\
+      v3 ^= v0;				\
+      v2 += v1; v1 = RANON_ROTL(v1, 17);	\
+      v1 ^= v2; v2 = RANON_ROTL(v2, 32);	\
+   } while (0)
+
+/*
+ * RaMapSipHash - SipHash-2-4 of a single 64 bit word.
+ */
+
+static uint64_t
+RaMapSipHash (uint64_t k0, uint64_t k1, uint64_t m)
+{
+   uint64_t v0 = k0 ^ 0x736f6d6570736575ULL;
+   uint64_t v1 = k1 ^ 0x646f72616e646f6dULL;
+   uint64_t v2 = k0 ^ 0x6c7967656e657261ULL;
+   uint64_t v3 = k1 ^ 0x7465646279746573ULL;
+   uint64_t b = ((uint64_t) 8) << 56;
+
+   v3 ^= m;
+   RANON_SIPROUND; RANON_SIPROUND;
+   v0 ^= m;
+
+   v3 ^= b;
+   RANON_SIPROUND; RANON_SIPROUND;
+   v0 ^= b;
+
+   v2 ^= 0xff;
+   RANON_SIPROUND; RANON_SIPROUND; RANON_SIPROUND; RANON_SIPROUND;
+
+   return (v0 ^ v1 ^ v2 ^ v3);
+}
+
+/*
+ * RaMapSetPrefixKey - derive the prefix preserving key, once, from
+ * RANON_PREFIX_KEY, or from the seeded random() generator.  The key
+ * survives the re-initialization done for each file in replace mode,
+ * so all the files, and all the jobs, get the same mapping.
+ */
+
+static void
+RaMapSetPrefixKey (void)
+{
+   if (RaMapPrefixKeyed)
+      return;
+
+   if (RaNonPrefixKey != NULL) {
+      uint64_t h0 = 0x0123456789abcdefULL, h1 = 0xfedcba9876543210ULL;
+      unsigned char *ptr = (unsigned char *) RaNonPrefixKey;
+      int i, len = strlen(RaNonPrefixKey);
+
+      for (i = 0; i < len; i += 8) {
+         uint64_t m = 0;
+         int x;
+         for (x = 0; (x < 8) && ((i + x) < len); x++)
+            m |= ((uint64_t) ptr[i + x]) << (x * 8);
+         h0 = RaMapSipHash (h0, h1, m);
+         h1 = RaMapSipHash (h1, h0, m ^ len);
+      }
+      RaMapPrefixKey[0] = h0;
+      RaMapPrefixKey[1] = h1;
+
+   } else {
+      int i;
+      for (i = 0; i < 2; i++)
+         RaMapPrefixKey[i] = (((uint64_t) random()) << 33) ^ (((uint64_t) random()) << 11) ^ random();
+   }
+
+   if ((RaMapPrefixCache = ArgusCalloc (RANON_PREFIX_CACHE_SIZE, sizeof(*RaMapPrefixCache))) == NULL)
+      ArgusLog (LOG_ERR, "RaMapSetPrefixKey: ArgusCalloc error %s\n", strerror(errno));
+
+   RaMapPrefixKeyed = 1;
+}
+
+/*
+ * RaMapPrefixPreserve - prefix preserving mapping of a host order
+ * IPv4 address.  When broadcast preservation is on, host parts of
+ * 0 and 255 are kept, and the other host parts are cycle walked
+ * through the permutation of their /24 until they land in 1..254,
+ * so the mapping stays one-to-one.
+ */
+
+static unsigned int
+RaMapPrefixPad (unsigned int addr)
+{
+   unsigned int pad = 0;
+   int i;
+
+   for (i = 0; i < 32; i++) {
+      uint64_t prefix = i ? (addr >> (32 - i)) : 0;
+      if (RaMapSipHash (RaMapPrefixKey[0], RaMapPrefixKey[1], (prefix << 8) | i) & 0x01)
+         pad |= 0x80000000 >> i;
+   }
+   return (pad);
+}
+
+unsigned int
+RaMapPrefixPreserve (unsigned int addr)
+{
+   struct RaMapPrefixCacheStruct *cache;
+   unsigned int retn, host;
+
+   cache = &RaMapPrefixCache[RaMapCalcHash (&addr, RAMAP_IP_ADDR, 4) % RANON_PREFIX_CACHE_SIZE];
+   if (cache->valid && (cache->addr == addr))
+      return (cache->value);
+
+   retn = addr ^ RaMapPrefixPad (addr);
+
+   if (RaPreserveBroadcastAddress) {
+      if (((addr & 0xff) == 0xff) || ((addr & 0xff) == 0x00))
+         retn = (retn & 0xffffff00) | (addr & 0xff);
+      else
+         while (((host = (retn & 0xff)) == 0xff) || (host == 0x00)) {
+            unsigned int next = (addr & 0xffffff00) | host;
+            retn = (retn & 0xffffff00) | ((next ^ RaMapPrefixPad (next)) & 0xff);
+         }
+   }
+
+   cache->addr  = addr;
+   cache->value = retn;
+   cache->valid = 1;
+
+   return (retn);
+}
+
+
+#define RANON_RCITEMS				37
 
 #define RANON_SEED				0
 #define RANON_TRANSREFNUM_OFFSET 		1
@@ -1640,6 +1924,7 @@ RaMapRemoveHashEntry (struct RaMapHashTableStruct *table, struct RaMapHashTableH
 #define RANON_PRESERVE_IP_OPTIONS		33
 #define RANON_AS_ANONYMIZATION			34
 #define RANON_SPECIFY_ASN_TRANSLATION		35
+#define RANON_PREFIX_KEY			36
 
 
 char *RaNonResourceFileStr [] = {
@@ -1681,6 +1966,7 @@ char *RaNonResourceFileStr [] = {
    "RANON_PRESERVE_IP_OPTIONS=",
    "RANON_AS_ANONYMIZATION=",
    "RANON_SPECIFY_ASN_TRANSLATION=",
+   "RANON_PREFIX_KEY=",
 };
 
 #include <ctype.h>
@@ -1798,6 +2084,10 @@ RaNonParseResourceFile (char *file)
                               RaNonPreserveNetAddrHierarchy = strdup(optarg); 
                               break;
 
+                           case RANON_PREFIX_KEY:
+                              RaNonPrefixKey = strdup(optarg); 
+                              break;
+
                            case RANON_PRESERVE_BROADCAST_ADDRESS:
                               if (!(strncasecmp(optarg, "yes", 3)))
                                  RaPreserveBroadcastAddress++;
@@ -65,7 +65,9 @@ struct ArgusFileCacheStruct {
    time_t ArgusFileStartSecs;
    time_t ArgusFileEndSecs;
 
-   struct timeval lasttime;
+   struct timeval lasttime, lastfile;
+   struct RastreamLatenessStruct *late;
+   double hold;
    struct ArgusWfileStruct wfile;
    struct ArgusListStruct *files;
    struct ArgusHashTable htable;
@@ -79,7 +81,132 @@ struct RastreamFileMap {
    int nodelete;
 };
 
+/*
+ * Asynchronous output.  Records for each output file are collected in
+ * a buffer on the main thread, and the full buffers are handed to a
+ * writer thread, chosen by the filename, so that one thread owns each
+ * open file and writes to it in order.  Closing the file, and
+ * scheduling the -f script, is queued the same way, so the script only
+ * sees the file after all of its records are written.  The scripts
+ * are run from a bounded queue by a fixed number of script threads.
+ */
+
+#define ARGUS_WRITER_BUFSIZE		(64 * 1024)
+#define ARGUS_WRITER_MAXQUEUE		256
+#define ARGUS_MAX_WRITERS		32
+#define ARGUS_DEFAULT_WRITERS		2
+
+#define ARGUS_SCRIPT_MAXQUEUE		1024
+#define ARGUS_MAX_SCRIPTS		32
+
+#define ARGUS_WRITE_DATA		1
+#define ARGUS_WRITE_CLOSE		2
+
+#define ARGUS_LAG_REPORT_INTERVAL	60
+
+struct RastreamWriterStruct {
+   struct RastreamWriterStruct *nxt, *prv;
+   char *filename;
+   FILE *fd;
+   int thread, len;
+   char *buf;
+   time_t laststat;
+   struct ArgusRecord header;
+};
+
+struct RastreamWriteJob {
+   struct ArgusListObjectStruct *nxt;
+   struct RastreamWriterStruct *writer;
+   struct ArgusScriptStruct *script;
+   char *buf;
+   int len, op;
+};
+
+struct RastreamWriterThread {
+   pthread_t thread;
+   struct ArgusListStruct *jobs;
+   int done;
+};
+
+/* the files added by ArgusAddFilename() carry their writer */
+
+struct RastreamWfileStruct {
+   struct ArgusWfileStruct wfile;
+   struct RastreamWriterStruct *writer;
+};
+
+struct RastreamStatsStruct {
+   unsigned int late, closes, scripts;
+   unsigned int writerstalls, scriptstalls;
+   unsigned int maxwriteq, maxscriptq;
+   int minhold, maxhold;
+   time_t maxlag, lastreport;
+};
+
+/*
+ * Adaptive hold buffer.  How late each record arrives, the current
+ * time less its start time, is kept in a histogram of 1 second bins
+ * over a sliding window, made of two halves that take turns being
+ * cleared.  Each file cache closes its files after the lateness
+ * quantile that keeps the drops at the target rate, so with $srcid in
+ * the filename, punctual sensors aren't held up by the late ones.
+ * The same histograms, kept for each srcid, are used to report drops.
+ */
+
+#define ARGUS_LATE_BINS			601
+#define ARGUS_LATE_WINDOW		300
+#define ARGUS_LATE_MINSAMPLES		100
+#define ARGUS_DEFAULT_HOLD_RATE		0.001
+#define ARGUS_SOURCE_HASHSIZE		256
+
+struct RastreamLatenessStruct {
+   unsigned int bins[2][ARGUS_LATE_BINS];
+   unsigned int count[2];
+   int current;
+   time_t rotate;
+};
+
+struct RastreamSourceStruct {
+   struct RastreamSourceStruct *nxt;
+   struct ArgusAddrStruct srcid;
+   unsigned char type;
+   char name[64];
+   unsigned int records, dropped, reported;
+   struct RastreamLatenessStruct late;
+};
+
 void *ArgusScriptProcess (void *);
+void *RastreamWriterProcess (void *);
+
+static struct RastreamWriterThread *RastreamWriters = NULL;
+static struct RastreamWriterStruct *RastreamOpenWriters = NULL;
+static int RastreamWriterCount = ARGUS_DEFAULT_WRITERS;
+
+static pthread_t *RastreamScriptThreads = NULL;
+static int RastreamScriptCount = 1;
+static int RastreamScriptsDone = 0;
+
+static struct RastreamStatsStruct RastreamStats;
+
+static double RastreamHoldRate = 0.0;
+static struct RastreamSourceStruct *RastreamSources[ARGUS_SOURCE_HASHSIZE];
+
+static void RastreamAddLateness(struct RastreamLatenessStruct *, time_t, time_t);
+static int RastreamLatenessQuantile(struct RastreamLatenessStruct *, double);
+static double RastreamHoldTime(struct ArgusFileCacheStruct *);
+static struct RastreamSourceStruct *RastreamFindSource(struct ArgusParserStruct *,
+                                                       struct ArgusRecordStruct *);
+
+static int RastreamWriteRecord(struct ArgusParserStruct *,
+                               struct ArgusInput *,
+                               struct ArgusWfileStruct *,
+                               struct ArgusRecord *);
+static void RastreamCloseFile(struct ArgusParserStruct *,
+                              struct ArgusWfileStruct *, int);
+static void RastreamFlushWriters(void);
+static void RastreamStopWriters(void);
+static void RastreamStopScripts(void);
+static void RastreamReportLag(struct ArgusParserStruct *, int);
 
 #ifdef HAVE_FCNTL_H
 # include <limits.h>
@@ -125,6 +252,8 @@ static int argus_version = ARGUS_VERSION;
 
 static int ArgusRunFileScript(struct ArgusParserStruct *,
                               struct ArgusWfileStruct *, int);
+static struct ArgusScriptStruct *ArgusNewFileScript(struct ArgusParserStruct *,
+                                                    struct ArgusWfileStruct *);
 static int ArgusRunScript(struct ArgusParserStruct *,
                           struct ArgusScriptStruct *, int);
 
@@ -370,6 +499,27 @@ ArgusClientInit (struct ArgusParserStruct *parser)
             } else if (!strncmp(mode->mode, "lock", 4)) {
                /* This is handled in ArgusParseArgs() but check for
                "lock" here so rastream doesn't exit if it's specified */
+            } else if (!(strncasecmp (mode->mode, "writers=", 8))) {
+               RastreamWriterCount = atoi(&mode->mode[8]);
+               if ((RastreamWriterCount < 0) || (RastreamWriterCount > ARGUS_MAX_WRITERS))
+                  ArgusLog (LOG_ERR, "writers mode: value must be 0-%d", ARGUS_MAX_WRITERS);
+               mode = mode->nxt;
+               continue;
+            } else if (!(strncasecmp (mode->mode, "hold=", 5))) {
+               if (!(strcasecmp (&mode->mode[5], "auto")))
+                  RastreamHoldRate = ARGUS_DEFAULT_HOLD_RATE;
+               else
+                  RastreamHoldRate = strtod(&mode->mode[5], NULL);
+               if ((RastreamHoldRate <= 0.0) || (RastreamHoldRate >= 1.0))
+                  ArgusLog (LOG_ERR, "hold mode: drop rate must be between 0 and 1");
+               mode = mode->nxt;
+               continue;
+            } else if (!(strncasecmp (mode->mode, "scripts=", 8))) {
+               RastreamScriptCount = atoi(&mode->mode[8]);
+               if ((RastreamScriptCount < 1) || (RastreamScriptCount > ARGUS_MAX_SCRIPTS))
+                  ArgusLog (LOG_ERR, "scripts mode: value must be 1-%d", ARGUS_MAX_SCRIPTS);
+               mode = mode->nxt;
+               continue;
             } else {
                   int done = 0;
                   for (i = 0, ind = -1; (i < ARGUSSPLITMODENUM) && !done; i++) {
@@ -659,13 +809,40 @@ ArgusClientInit (struct ArgusParserStruct *parser)
       parser->RaClientTimeout.tv_usec = 330000;
       parser->RaInitialized++;
 
+      if ((ArgusScriptList = ArgusNewList()) == NULL)
+         ArgusLog (LOG_ERR, "ArgusClientInit: ArgusNewList error %s\n", strerror(errno));
+
 #if defined(ARGUS_THREADS)
 extern void * ArgusScriptProcess (void *);
 
       if (pthread_attr_init(&attr) != 0)
          ArgusLog (LOG_ERR, "pthreads init error");
-      if ((pthread_create(&ArgusParser->script, &attr, ArgusScriptProcess, ArgusParser)) != 0)
-         ArgusLog (LOG_ERR, "ArgusSciptProcessor() pthread_create error %s\n", strerror(errno));
+
+      if ((RastreamScriptThreads = ArgusCalloc(RastreamScriptCount, sizeof(pthread_t))) == NULL)
+         ArgusLog (LOG_ERR, "ArgusClientInit: ArgusCalloc error %s\n", strerror(errno));
+
+      for (i = 0; i < RastreamScriptCount; i++)
+         if ((pthread_create(&RastreamScriptThreads[i], &attr, ArgusScriptProcess, ArgusParser)) != 0)
+            ArgusLog (LOG_ERR, "ArgusSciptProcessor() pthread_create error %s\n", strerror(errno));
+
+/* file locking relies on the result of each write, so it stays on the main thread */
+
+      if (parser->ArgusLockWriteFiles)
+         RastreamWriterCount = 0;
+
+      if (RastreamWriterCount > 0) {
+         if ((RastreamWriters = ArgusCalloc(RastreamWriterCount, sizeof(*RastreamWriters))) == NULL)
+            ArgusLog (LOG_ERR, "ArgusClientInit: ArgusCalloc error %s\n", strerror(errno));
+
+         for (i = 0; i < RastreamWriterCount; i++) {
+            if ((RastreamWriters[i].jobs = ArgusNewList()) == NULL)
+               ArgusLog (LOG_ERR, "ArgusClientInit: ArgusNewList error %s\n", strerror(errno));
+            if ((pthread_create(&RastreamWriters[i].thread, &attr, RastreamWriterProcess, &RastreamWriters[i])) != 0)
+               ArgusLog (LOG_ERR, "RastreamWriterProcess() pthread_create error %s\n", strerror(errno));
+         }
+      }
+#else
+      RastreamWriterCount = 0;
 #endif
    }
 
@@ -692,11 +869,10 @@ RaParseComplete (int sig)
 #endif
          RastreamProcessAllFileCaches(agg ? agg->queue : NULL);
          RastreamCloseAllWfiles();
+         RastreamStopWriters();
          ArgusParser->RaParseDone = 1;
-         if (ArgusParser->script != (pthread_t) 0) {
-            pthread_join(ArgusParser->script, NULL);
-            ArgusParser->script = (pthread_t) 0;
-         }
+         RastreamStopScripts();
+         RastreamReportLag(ArgusParser, 1);
 
          switch (sig) {
             case SIGHUP:
@@ -723,7 +899,9 @@ ArgusClientTimeout ()
 {
    struct ArgusAggregatorStruct *agg;
 
-   if (ArgusParser->Bflag > 0) {
+   RastreamFlushWriters();
+
+   if ((ArgusParser->Bflag > 0) || (RastreamHoldRate > 0.0)) {
       struct ArgusFileCacheStruct *fcache = NULL;
 
       if ((agg = ArgusParser->ArgusAggregator) != NULL) {
@@ -738,15 +916,14 @@ ArgusClientTimeout ()
             if ((fcache = (void *)ArgusPopQueue(queue, ARGUS_NOLOCK)) != NULL) {
                int i, count;
                if ((count = fcache->files->count) != 0) {
+                  double hold = RastreamHoldTime(fcache);
                   for (i = 0; i < count; i++) {
                      struct ArgusWfileStruct *wfile = (struct ArgusWfileStruct *)ArgusPopFrontList(fcache->files, ARGUS_NOLOCK);
-                     if ((wfile->etime.tv_sec + ArgusParser->Bflag) <= ArgusParser->ArgusRealTime.tv_sec) {
+                     if ((wfile->etime.tv_sec + hold) <= ArgusParser->ArgusRealTime.tv_sec) {
                         ArgusLastFileTime = wfile->etime;
-                        if (wfile->fd != NULL) {
-                           fclose (wfile->fd);
-                           wfile->fd = NULL;
-                        }
-                        ArgusRunFileScript(ArgusParser, wfile, ARGUS_SCHEDULE_SCRIPT);
+                        if (fcache->lastfile.tv_sec < wfile->etime.tv_sec)
+                           fcache->lastfile = wfile->etime;
+                        RastreamCloseFile(ArgusParser, wfile, 1);
                      } else {
                         ArgusPushBackList(fcache->files, (struct ArgusListRecord *)wfile, ARGUS_NOLOCK);
                      }
@@ -763,15 +940,14 @@ ArgusClientTimeout ()
          if ((fcache = ArgusThisFileCache) != NULL) {
             int i, count;
             if ((count = fcache->files->count) != 0) {
+               double hold = RastreamHoldTime(fcache);
                for (i = 0; i < count; i++) {
                   struct ArgusWfileStruct *wfile = (struct ArgusWfileStruct *)ArgusPopFrontList(fcache->files, ARGUS_NOLOCK);
-                  if ((wfile->etime.tv_sec + ArgusParser->Bflag) <= ArgusParser->ArgusRealTime.tv_sec) {
+                  if ((wfile->etime.tv_sec + hold) <= ArgusParser->ArgusRealTime.tv_sec) {
                      ArgusLastFileTime = wfile->etime;
-                     if (wfile->fd != NULL) {
-                        fclose (wfile->fd);
-                        wfile->fd = NULL;
-                     }
-                     ArgusRunFileScript(ArgusParser, wfile, ARGUS_SCHEDULE_SCRIPT);
+                     if (fcache->lastfile.tv_sec < wfile->etime.tv_sec)
+                        fcache->lastfile = wfile->etime;
+                     RastreamCloseFile(ArgusParser, wfile, 1);
                   } else
                      ArgusPushBackList(fcache->files, (struct ArgusListRecord *)wfile, ARGUS_NOLOCK);
                }
@@ -780,6 +956,8 @@ ArgusClientTimeout ()
       }
    }
 
+   RastreamReportLag(ArgusParser, 0);
+
 #ifdef ARGUSDEBUG
    ArgusDebug (9, "ArgusClientTimeout()\n");
 #endif
@@ -812,6 +990,10 @@ usage ()
    fprintf (stdout, "           count n[kmb]\n");
    fprintf (stdout, "            size n[kmb]\n");
    fprintf (stdout, "            nomodify\n");
+   fprintf (stdout, "            writers=<n>      output writer threads, 0 writes inline\n");
+   fprintf (stdout, "            scripts=<n>      -f programs run at once\n");
+   fprintf (stdout, "            hold=<rate|auto> set the hold buffer from observed lateness,\n");
+   fprintf (stdout, "                             to drop at most <rate> of the records\n");
 
    fprintf (stdout, "         -r <file>           read argus data <file>. '-' denotes stdin.\n");
    fprintf (stdout, "         -S <host[:port]>    specify remote argus <host> and optional port\n");
@@ -1095,20 +1277,39 @@ RaSendArgusRecord(struct ArgusRecordStruct *argus)
       case ARGUSSPLITTIME: {
          long long start = ArgusFetchStartuSecTime(argus);
          time_t fileSecs = start / 1000000;
+         time_t now = ArgusParser->ArgusRealTime.tv_sec;
          int size = ArgusNadp->size / 1000000;
+         struct RastreamSourceStruct *source;
          struct tm tmval;
 
+         if ((source = RastreamFindSource(ArgusParser, argus)) != NULL) {
+            source->records++;
+            RastreamAddLateness(&source->late, now, now - fileSecs);
+         }
+
+         if ((RastreamHoldRate > 0.0) && (fcache != NULL)) {
+            if (fcache->late == NULL)
+               if ((fcache->late = ArgusCalloc(1, sizeof(*fcache->late))) == NULL)
+                  ArgusLog (LOG_ERR, "RaSendArgusRecord: ArgusCalloc error %s", strerror(errno));
+            RastreamAddLateness(fcache->late, now, now - fileSecs);
+         }
+
 // so we've got the fcache, and we have a time.  before we go through the painful
 // process of generating a filename, lets look to see if we have a file that can
 // handle our startime.  If so just write into that file, if not, do the painful thing.
    
 // First, if we've closed a file after this record, we're done.....
 
-         if (ArgusLastFileTime.tv_sec > 0)
-            if (ArgusLastFileTime.tv_sec >= fileSecs) {
+         if (fcache && (fcache->lastfile.tv_sec > 0))
+            if (fcache->lastfile.tv_sec > fileSecs) {
+               RastreamStats.late++;
+               if ((fcache->lastfile.tv_sec - fileSecs) > RastreamStats.maxlag)
+                  RastreamStats.maxlag = fcache->lastfile.tv_sec - fileSecs;
+               if (source != NULL)
+                  source->dropped++;
 #ifdef ARGUSDEBUG
-               ArgusDebug (2, "RaSendArgusRecord () rejecting late record secs %d done file secs\n",
-                    fileSecs, ArgusLastFileTime.tv_sec);
+               ArgusDebug (2, "RaSendArgusRecord () rejecting late record secs %d done file secs %d\n",
+                    fileSecs, fcache->lastfile.tv_sec);
 #endif
                return (retn);
             }
@@ -1295,8 +1496,8 @@ RaSendArgusRecord(struct ArgusRecordStruct *argus)
 #ifdef _LITTLE_ENDIAN
                ArgusHtoN(argusrec);
 #endif
-               rv = RastreamWriteNewLogfile (ArgusParser, argus->input, tfile,
-                                             argusrec);
+               rv = RastreamWriteRecord (ArgusParser, argus->input, tfile,
+                                         argusrec);
                if (rv < 0)
                   ArgusLog(LOG_ERR, "%s unable to open file\n", __func__);
             }
@@ -1395,6 +1596,500 @@ out:
    return retn;
 }
 
+/*
+ * Build the file header that ArgusWriteNewLogfile() would write at the
+ * start of a new file, so the writer thread can write it without
+ * touching the parser.
+ */
+
+static void
+RastreamGenerateHeader(struct ArgusParserStruct *parser, struct ArgusRecord *argus, struct ArgusRecord *header)
+{
+   unsigned char version = argus->hdr.type & ARGUS_VERSION_MASK;
+   unsigned char initversion = parser->ArgusInitCon.hdr.type & ARGUS_VERSION_MASK;
+   struct ArgusRecord *ns = &parser->ArgusInitCon;
+   int len = ntohs(parser->ArgusInitCon.hdr.len) * 4;
+
+   if (parser->ver3flag)
+      version = ARGUS_VERSION_3;
+
+   if (len == 0 || (version != initversion)) {
+      ns->hdr.type   = (ARGUS_MAR | version);
+      ns->hdr.cause  = ARGUS_START;
+      ns->hdr.len    = (unsigned short) sizeof(struct ArgusRecord)/4;
+
+      ns->argus_mar.thisid           = 0;
+      ns->argus_mar.argusid          = version == 3 ? ARGUS_V3_COOKIE : ARGUS_COOKIE;
+      ns->argus_mar.startime.tv_sec  = parser->ArgusGlobalTime.tv_sec;
+      ns->argus_mar.startime.tv_usec = parser->ArgusGlobalTime.tv_usec;
+      ns->argus_mar.now              = ns->argus_mar.startime;
+      ns->argus_mar.record_len       = -1;
+
+      ArgusHtoN(ns);
+
+   } else {
+      ns->argus_mar.now.tv_sec       = htonl(parser->ArgusGlobalTime.tv_sec);
+      ns->argus_mar.now.tv_usec      = htonl(parser->ArgusGlobalTime.tv_usec);
+   }
+
+   bcopy(ns, header, sizeof(*header));
+}
+
+static struct RastreamWriterStruct *
+RastreamNewWriter(struct ArgusParserStruct *parser, struct ArgusWfileStruct *wfile, struct ArgusRecord *argus)
+{
+   struct RastreamWriterStruct *writer;
+   unsigned int hash = 0;
+   char *ptr;
+
+   if ((writer = ArgusCalloc(1, sizeof(*writer))) == NULL)
+      ArgusLog (LOG_ERR, "RastreamNewWriter: ArgusCalloc error %s", strerror(errno));
+
+   if ((writer->filename = strdup(wfile->filename)) == NULL)
+      ArgusLog (LOG_ERR, "RastreamNewWriter: strdup error %s", strerror(errno));
+
+   for (ptr = writer->filename; *ptr; ptr++)
+      hash = (hash * 31) + (unsigned char) *ptr;
+
+   writer->thread = hash % RastreamWriterCount;
+   RastreamGenerateHeader(parser, argus, &writer->header);
+
+   if ((writer->nxt = RastreamOpenWriters) != NULL)
+      writer->nxt->prv = writer;
+   RastreamOpenWriters = writer;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (3, "RastreamNewWriter(%p, %s) thread %d", parser, writer->filename, writer->thread);
+#endif
+   return (writer);
+}
+
+/* hand a buffer, or the close, to the writer thread that owns the file */
+
+static void
+RastreamQueueWrite(struct RastreamWriterStruct *writer, int op, struct ArgusScriptStruct *script)
+{
+   struct ArgusListStruct *jobs = RastreamWriters[writer->thread].jobs;
+   struct RastreamWriteJob *job;
+
+   if ((job = ArgusCalloc(1, sizeof(*job))) == NULL)
+      ArgusLog (LOG_ERR, "RastreamQueueWrite: ArgusCalloc error %s", strerror(errno));
+
+   job->writer = writer;
+   job->script = script;
+   job->buf = writer->buf;
+   job->len = writer->len;
+   job->op  = op;
+
+   writer->buf = NULL;
+   writer->len = 0;
+
+   MUTEX_LOCK(&jobs->lock);
+#if defined(ARGUS_THREADS)
+   if (jobs->count >= ARGUS_WRITER_MAXQUEUE) {
+      RastreamStats.writerstalls++;
+      while (jobs->count >= ARGUS_WRITER_MAXQUEUE)
+         pthread_cond_wait(&jobs->cond, &jobs->lock);
+   }
+#endif
+   ArgusPushBackList(jobs, (struct ArgusListRecord *) job, ARGUS_NOLOCK);
+   if (jobs->count > RastreamStats.maxwriteq)
+      RastreamStats.maxwriteq = jobs->count;
+#if defined(ARGUS_THREADS)
+   pthread_cond_broadcast(&jobs->cond);
+#endif
+   MUTEX_UNLOCK(&jobs->lock);
+}
+
+static int
+RastreamWriteRecord(struct ArgusParserStruct *parser,
+                    struct ArgusInput *input,
+                    struct ArgusWfileStruct *wfile,
+                    struct ArgusRecord *argusrec)
+{
+   struct RastreamWfileStruct *rfile = (struct RastreamWfileStruct *) wfile;
+   struct RastreamWriterStruct *writer;
+   int len = ntohs(argusrec->hdr.len) * 4;
+
+   if ((RastreamWriterCount == 0) || (wfile->filename == NULL) || (*wfile->filename == '-') ||
+       !(strncmp(wfile->filename, "/dev/null", 9)))
+      return (RastreamWriteNewLogfile(parser, input, wfile, argusrec));
+
+   if (len <= 0)
+      return (0);
+
+   if ((writer = rfile->writer) == NULL)
+      writer = rfile->writer = RastreamNewWriter(parser, wfile, argusrec);
+
+   if (writer->buf && ((writer->len + len) > ARGUS_WRITER_BUFSIZE))
+      RastreamQueueWrite(writer, ARGUS_WRITE_DATA, NULL);
+
+   if (writer->buf == NULL)
+      if ((writer->buf = ArgusMalloc(ARGUS_WRITER_BUFSIZE)) == NULL)
+         ArgusLog (LOG_ERR, "RastreamWriteRecord: ArgusMalloc error %s", strerror(errno));
+
+   bcopy(argusrec, &writer->buf[writer->len], len);
+   writer->len += len;
+   return (0);
+}
+
+/* pass on the partial buffers, so the files don't fall behind the stream */
+
+static void
+RastreamFlushWriters(void)
+{
+   struct RastreamWriterStruct *writer;
+
+   for (writer = RastreamOpenWriters; writer != NULL; writer = writer->nxt)
+      if (writer->len > 0)
+         RastreamQueueWrite(writer, ARGUS_WRITE_DATA, NULL);
+}
+
+/*
+ * Close an output file, and if script is set, schedule the -f program
+ * for it.  If the file has a writer, the close is queued behind its
+ * records and the script is scheduled by the writer thread.
+ */
+
+static void
+RastreamCloseFile(struct ArgusParserStruct *parser, struct ArgusWfileStruct *wfile, int script)
+{
+   struct RastreamWfileStruct *rfile = (struct RastreamWfileStruct *) wfile;
+   struct RastreamWriterStruct *writer;
+
+   RastreamStats.closes++;
+
+   if (wfile->fd != NULL) {
+      fclose (wfile->fd);
+      wfile->fd = NULL;
+   }
+
+   if ((RastreamWriterCount > 0) && ((writer = rfile->writer) != NULL)) {
+      if (writer->prv != NULL)
+         writer->prv->nxt = writer->nxt;
+      else
+         RastreamOpenWriters = writer->nxt;
+      if (writer->nxt != NULL)
+         writer->nxt->prv = writer->prv;
+
+      rfile->writer = NULL;
+      RastreamQueueWrite(writer, ARGUS_WRITE_CLOSE, script ? ArgusNewFileScript(parser, wfile) : NULL);
+
+   } else
+   if (script)
+      ArgusRunFileScript(parser, wfile, ARGUS_SCHEDULE_SCRIPT);
+}
+
+static void
+RastreamWriterJob(struct RastreamWriteJob *job)
+{
+   struct RastreamWriterStruct *writer = job->writer;
+   struct stat statbuf;
+
+   if (job->len > 0) {
+
+/* if the file has been moved or removed, start a new one, as ArgusWriteNewLogfile() does */
+
+      if ((writer->fd != NULL) && (ArgusParser->ArgusRealTime.tv_sec > writer->laststat)) {
+         if (stat(writer->filename, &statbuf) < 0) {
+            fclose (writer->fd);
+            writer->fd = NULL;
+         }
+         writer->laststat = ArgusParser->ArgusRealTime.tv_sec;
+      }
+
+      if (writer->fd == NULL) {
+         ArgusMkdirPath(writer->filename);
+
+         if ((writer->fd = fopen (writer->filename, "a+")) == NULL)
+            ArgusLog (LOG_ERR, "RastreamWriterJob(%s) fopen %s", writer->filename, strerror(errno));
+
+         if ((fstat(fileno(writer->fd), &statbuf) == 0) && (statbuf.st_size == 0)) {
+            int hlen = ntohs(writer->header.hdr.len) * 4;
+
+            if ((hlen > 0) && (hlen <= sizeof(writer->header)))
+               if (fwrite (&writer->header, 1, hlen, writer->fd) < hlen)
+                  ArgusLog (LOG_WARNING, "RastreamWriterJob(%s) fwrite %s", writer->filename, strerror(errno));
+         }
+         writer->laststat = ArgusParser->ArgusRealTime.tv_sec;
+      }
+
+      if (fwrite (job->buf, 1, job->len, writer->fd) < job->len)
+         ArgusLog (LOG_WARNING, "RastreamWriterJob(%s) fwrite %s", writer->filename, strerror(errno));
+
+      fflush (writer->fd);
+   }
+
+   if (job->op == ARGUS_WRITE_CLOSE) {
+#ifdef ARGUSDEBUG
+      ArgusDebug (3, "RastreamWriterJob: closing %s", writer->filename);
+#endif
+      if (writer->fd != NULL)
+         fclose (writer->fd);
+
+      if (job->script != NULL)
+         ArgusRunScript(ArgusParser, job->script, ARGUS_SCHEDULE_SCRIPT);
+
+      if (writer->buf != NULL)
+         ArgusFree(writer->buf);
+      free(writer->filename);
+      ArgusFree(writer);
+   }
+
+   if (job->buf != NULL)
+      ArgusFree(job->buf);
+   ArgusFree(job);
+}
+
+static void
+RastreamStopWriters(void)
+{
+#if defined(ARGUS_THREADS)
+   int i;
+
+   if (RastreamWriters == NULL)
+      return;
+
+   RastreamFlushWriters();
+
+   for (i = 0; i < RastreamWriterCount; i++) {
+      struct ArgusListStruct *jobs = RastreamWriters[i].jobs;
+
+      MUTEX_LOCK(&jobs->lock);
+      RastreamWriters[i].done = 1;
+      pthread_cond_broadcast(&jobs->cond);
+      MUTEX_UNLOCK(&jobs->lock);
+
+      pthread_join(RastreamWriters[i].thread, NULL);
+      ArgusDeleteList(jobs, ARGUS_OBJECT_LIST);
+   }
+
+   ArgusFree(RastreamWriters);
+   RastreamWriters = NULL;
+   RastreamWriterCount = 0;
+#endif
+}
+
+static void
+RastreamStopScripts(void)
+{
+#if defined(ARGUS_THREADS)
+   int i;
+
+   if (RastreamScriptThreads == NULL)
+      return;
+
+   MUTEX_LOCK(&ArgusScriptList->lock);
+   RastreamScriptsDone = 1;
+   pthread_cond_broadcast(&ArgusScriptList->cond);
+   MUTEX_UNLOCK(&ArgusScriptList->lock);
+
+   for (i = 0; i < RastreamScriptCount; i++)
+      pthread_join(RastreamScriptThreads[i], NULL);
+
+   ArgusFree(RastreamScriptThreads);
+   RastreamScriptThreads = NULL;
+#endif
+}
+
+/*
+ * Report records that arrived behind the hold buffer, and whether the
+ * writers or the scripts are holding up the stream.  The counts are
+ * logged once a minute when there is something to report, and at the
+ * end of the run.
+ */
+
+static void
+RastreamReportLag(struct ArgusParserStruct *parser, int final)
+{
+   struct RastreamStatsStruct *stats = &RastreamStats;
+   time_t now = parser->ArgusRealTime.tv_sec;
+
+   if (!final) {
+      if (stats->lastreport == 0)
+         stats->lastreport = now;
+      if ((now - stats->lastreport) < ARGUS_LAG_REPORT_INTERVAL)
+         return;
+   }
+
+   if (stats->late || stats->writerstalls || stats->scriptstalls) {
+      struct RastreamSourceStruct *source;
+      int i;
+
+      ArgusLog (LOG_WARNING, "rastream: %u records behind hold buffer, max %d secs late, %u writer stalls (max queue %u), %u script stalls (max queue %u)",
+                stats->late, (int) stats->maxlag, stats->writerstalls, stats->maxwriteq,
+                stats->scriptstalls, stats->maxscriptq);
+
+      for (i = 0; i < ARGUS_SOURCE_HASHSIZE; i++) {
+         for (source = RastreamSources[i]; source != NULL; source = source->nxt) {
+            if (source->dropped > source->reported) {
+               ArgusLog (LOG_WARNING, "rastream: srcid %s: %u of %u records behind hold buffer, lateness p50 %d p99 %d secs",
+                         source->name, source->dropped - source->reported, source->records,
+                         RastreamLatenessQuantile(&source->late, 0.50),
+                         RastreamLatenessQuantile(&source->late, 0.99));
+               source->reported = source->dropped;
+            }
+         }
+      }
+      stats->late = stats->writerstalls = stats->scriptstalls = 0;
+      stats->maxlag = 0;
+   }
+
+   if (RastreamHoldRate > 0.0) {
+#ifdef ARGUSDEBUG
+      ArgusDebug (1, "RastreamReportLag: hold buffer %d-%d secs for drop rate %f",
+                  stats->minhold, stats->maxhold, RastreamHoldRate);
+#endif
+      stats->minhold = stats->maxhold = 0;
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (1, "RastreamReportLag: %u files closed, %u scripts scheduled, hold lag %d secs",
+               stats->closes, stats->scripts,
+               ArgusLastFileTime.tv_sec ? (int)(now - ArgusLastFileTime.tv_sec) : 0);
+#endif
+   stats->lastreport = now;
+}
+
+static void
+RastreamAddLateness(struct RastreamLatenessStruct *late, time_t now, time_t secs)
+{
+   if (late->rotate == 0)
+      late->rotate = now;
+
+   if ((now - late->rotate) >= ARGUS_LATE_WINDOW) {
+      if ((now - late->rotate) >= (2 * ARGUS_LATE_WINDOW)) {
+         bzero(late->bins, sizeof(late->bins));
+         bzero(late->count, sizeof(late->count));
+      } else {
+         late->current ^= 1;
+         bzero(late->bins[late->current], sizeof(late->bins[late->current]));
+         late->count[late->current] = 0;
+      }
+      late->rotate = now;
+   }
+
+   if (secs < 0)
+      secs = 0;
+   if (secs >= ARGUS_LATE_BINS)
+      secs = ARGUS_LATE_BINS - 1;
+
+   late->bins[late->current][secs]++;
+   late->count[late->current]++;
+}
+
+/* the lateness, in seconds, that q of the records in the window arrived within, or -1 */
+
+static int
+RastreamLatenessQuantile(struct RastreamLatenessStruct *late, double q)
+{
+   unsigned int total = late->count[0] + late->count[1], sum = 0;
+   double target = q * total;
+   int i;
+
+   if (total == 0)
+      return (-1);
+
+   for (i = 0; i < ARGUS_LATE_BINS; i++) {
+      sum += late->bins[0][i] + late->bins[1][i];
+      if (sum >= target)
+         break;
+   }
+   return ((i < ARGUS_LATE_BINS) ? i : ARGUS_LATE_BINS - 1);
+}
+
+/*
+ * The hold buffer for a file cache.  A record in bin i arrived up to
+ * i + 1 seconds after it started, so holding the files that long keeps
+ * all but the target rate.  -B, if given, is the upper bound, and it's
+ * also used until there are enough samples to go on.
+ */
+
+static double
+RastreamHoldTime(struct ArgusFileCacheStruct *fcache)
+{
+   double retn, limit;
+   int q;
+
+   if (RastreamHoldRate <= 0.0)
+      return (ArgusParser->Bflag);
+
+   limit = (ArgusParser->Bflag > 0) ? ArgusParser->Bflag : (ARGUS_LATE_BINS - 1);
+
+   if ((fcache->late == NULL) || ((fcache->late->count[0] + fcache->late->count[1]) < ARGUS_LATE_MINSAMPLES) ||
+      ((q = RastreamLatenessQuantile(fcache->late, 1.0 - RastreamHoldRate)) < 0))
+      retn = limit;
+   else
+      retn = ((q + 1) < limit) ? (q + 1) : limit;
+
+   fcache->hold = retn;
+
+   if ((RastreamStats.minhold == 0) || (retn < RastreamStats.minhold))
+      RastreamStats.minhold = retn;
+   if (retn > RastreamStats.maxhold)
+      RastreamStats.maxhold = retn;
+
+   return (retn);
+}
+
+static struct RastreamSourceStruct *
+RastreamFindSource(struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
+{
+   struct ArgusTransportStruct *trans = (struct ArgusTransportStruct *) argus->dsrs[ARGUS_TRANSPORT_INDEX];
+   struct RastreamSourceStruct *source;
+   struct ArgusAddrStruct srcid;
+   unsigned int hash = 0;
+   unsigned char type = 0;
+   int i;
+
+/* management records keep the record itself where the transport dsr would be */
+
+   if ((argus->hdr.type & 0xF0) == ARGUS_MAR)
+      return (NULL);
+
+   bzero(&srcid, sizeof(srcid));
+   if (trans != NULL) {
+      srcid = trans->srcid;
+      type = trans->hdr.argus_dsrvl8.qual;
+   }
+
+   for (i = 0; i < sizeof(srcid); i++)
+      hash = (hash * 31) + ((unsigned char *) &srcid)[i];
+   hash %= ARGUS_SOURCE_HASHSIZE;
+
+   for (source = RastreamSources[hash]; source != NULL; source = source->nxt)
+      if ((source->type == type) && !(bcmp(&source->srcid, &srcid, sizeof(srcid))))
+         return (source);
+
+   if ((source = ArgusCalloc(1, sizeof(*source))) == NULL)
+      ArgusLog (LOG_ERR, "RastreamFindSource: ArgusCalloc error %s", strerror(errno));
+
+   source->srcid = srcid;
+   source->type = type;
+
+   if (trans != NULL) {
+      char *sptr = source->name, *eptr;
+
+      ArgusPrintSourceID(parser, source->name, argus, sizeof(source->name) - 1);
+      while (isspace((int)*sptr)) sptr++;
+      if (sptr != source->name)
+         memmove(source->name, sptr, strlen(sptr) + 1);
+      eptr = &source->name[strlen(source->name)];
+      while ((eptr > source->name) && isspace((int)eptr[-1]))
+         *--eptr = '\0';
+   }
+   if (source->name[0] == '\0')
+      snprintf (source->name, sizeof(source->name), "unknown");
+
+   source->nxt = RastreamSources[hash];
+   RastreamSources[hash] = source;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RastreamFindSource: new source %s", source->name);
+#endif
+   return (source);
+}
+
 void ArgusWindowClose(void);
 
 void ArgusWindowClose(void) { 
@@ -1598,7 +2293,7 @@ ArgusAddFilename(struct ArgusParserStruct *parser, struct ArgusFileCacheStruct *
    struct ArgusHashStruct *hash = ArgusGenerateFileHash(parser, filename);
 
    if (hash != NULL) {
-      if ((retn = (struct ArgusWfileStruct *) ArgusCalloc(1, sizeof(*retn))) != NULL) {
+      if ((retn = (struct ArgusWfileStruct *) ArgusCalloc(1, sizeof(struct RastreamWfileStruct))) != NULL) {
          if ((retn->htblhdr = ArgusAddHashEntry (&ArgusFileTable, (void *)retn, hash)) != NULL) {
             ArgusPushBackList(fcache->files, (struct ArgusListRecord *)retn, ARGUS_NOLOCK);
          } else {
@@ -1649,13 +2344,7 @@ ArgusProcessFileCache(struct ArgusFileCacheStruct *fcache)
 #endif
       if (tfile->htblhdr != NULL) ArgusRemoveHashEntry (&tfile->htblhdr);
 
-      if (tfile->fd != NULL) {
-         fclose (tfile->fd);
-         tfile->fd = NULL;
-      }
-
-      if (!(ArgusParser->Sflag)) 
-         ArgusRunFileScript(ArgusParser, tfile, ARGUS_SCHEDULE_SCRIPT);
+      RastreamCloseFile(ArgusParser, tfile, !(ArgusParser->Sflag));
 
       if (tfile->filename)
          free(tfile->filename);
@@ -1701,6 +2390,8 @@ static
 void
 ArgusDeleteFileCache(struct ArgusFileCacheStruct *fcache)
 {
+   if (fcache->late != NULL)
+      ArgusFree(fcache->late);
    ArgusDeleteList(fcache->files, ARGUS_WFILE_LIST);
    ArgusFree(fcache->htable.array);
    ArgusFree(fcache);
@@ -1744,6 +2435,23 @@ ArgusRunFileScript (struct ArgusParserStruct *parser, struct ArgusWfileStruct *f
    ArgusDebug (1, "ArgusRunFileScript(0x%x, %x) filename %s", parser, file, file->filename);
 #endif
 
+   if ((script = ArgusNewFileScript(parser, file)) != NULL)
+      ArgusRunScript(parser, script, status);
+   else
+      retn = 1;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (1, "ArgusRunFileScript(%p, %p) done", parser, file);
+#endif
+   return (retn);
+}
+
+static
+struct ArgusScriptStruct *
+ArgusNewFileScript (struct ArgusParserStruct *parser, struct ArgusWfileStruct *file)
+{
+   struct ArgusScriptStruct *script = NULL;
+
    if (file && parser->ArgusFlowModelFile) {
       char sbuf[1024];
       int i;
@@ -1772,15 +2480,12 @@ ArgusRunFileScript (struct ArgusParserStruct *parser, struct ArgusWfileStruct *f
       }
 
       script->cmd = strdup(sbuf);
-      ArgusRunScript(parser, script, status);
-
-   } else
-      retn = 1;
+   }
 
 #ifdef ARGUSDEBUG
-   ArgusDebug (1, "ArgusRunFileScript(%p, %p) done", parser, file);
+   ArgusDebug (3, "ArgusNewFileScript(%p, %p) returning %p", parser, file, script);
 #endif
-   return (retn);
+   return (script);
 }
 
 static
@@ -1796,15 +2501,27 @@ ArgusRunScript (struct ArgusParserStruct *parser, struct ArgusScriptStruct *scri
 
    switch (status) {
       case ARGUS_SCHEDULE_SCRIPT: {
-         if (ArgusScriptList == NULL)
-            if ((ArgusScriptList = ArgusNewList()) == NULL)
-               ArgusLog (LOG_ERR, "ArgusRunScript (%s) ArgusNewList() error %s\n", script->filename, strerror(errno));
-
 #ifdef ARGUSDEBUG
          ArgusDebug (1, "ArgusRunScript(%p, %p) scheduling %s", parser, script, script->cmd);
 #endif
-         ArgusPushBackList(ArgusScriptList, (struct ArgusListRecord *) script, ARGUS_LOCK);
+/* the queue is bounded, so a backlog of scripts holds up the file closes */
 
+         MUTEX_LOCK(&ArgusScriptList->lock);
+#if defined(ARGUS_THREADS)
+         if (ArgusScriptList->count >= ARGUS_SCRIPT_MAXQUEUE) {
+            RastreamStats.scriptstalls++;
+            while ((ArgusScriptList->count >= ARGUS_SCRIPT_MAXQUEUE) && !RastreamScriptsDone)
+               pthread_cond_wait(&ArgusScriptList->cond, &ArgusScriptList->lock);
+         }
+#endif
+         ArgusPushBackList(ArgusScriptList, (struct ArgusListRecord *) script, ARGUS_NOLOCK);
+         if (ArgusScriptList->count > RastreamStats.maxscriptq)
+            RastreamStats.maxscriptq = ArgusScriptList->count;
+         RastreamStats.scripts++;
+#if defined(ARGUS_THREADS)
+         pthread_cond_broadcast(&ArgusScriptList->cond);
+#endif
+         MUTEX_UNLOCK(&ArgusScriptList->lock);
          break;
       }
 
@@ -1849,32 +2566,66 @@ RastreamCloseAllWfiles(void) {
 }
 
 #if defined(ARGUS_THREADS)
+void *
+RastreamWriterProcess (void *args) {
+   struct RastreamWriterThread *thread = args;
+   struct ArgusListStruct *jobs = thread->jobs;
+   struct RastreamWriteJob *job;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RastreamWriterProcess() starting");
+#endif
+
+   MUTEX_LOCK(&jobs->lock);
+   for (;;) {
+      while ((jobs->start == NULL) && !thread->done)
+         pthread_cond_wait(&jobs->cond, &jobs->lock);
+
+      if ((job = (struct RastreamWriteJob *) ArgusPopFrontList(jobs, ARGUS_NOLOCK)) == NULL)
+         break;
+
+      pthread_cond_broadcast(&jobs->cond);
+      MUTEX_UNLOCK(&jobs->lock);
+
+      RastreamWriterJob(job);
+
+      MUTEX_LOCK(&jobs->lock);
+   }
+   MUTEX_UNLOCK(&jobs->lock);
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RastreamWriterProcess() done!");
+#endif
+
+   pthread_exit (NULL);
+}
+
 void *
 ArgusScriptProcess (void *args) {
-   struct timespec tsbuf = {1, 0}, *ts = &tsbuf;
+   struct ArgusListStruct *list = ArgusScriptList;
    struct ArgusScriptStruct *script;
 
 #ifdef ARGUSDEBUG
    ArgusDebug (2, "ArgusScriptProcess() starting");
 #endif
 
-   while (!(ArgusParser->RaParseDone)) {
-      if (ArgusScriptList != NULL) {
-         if (!ArgusListEmpty(ArgusScriptList)) {
-            while ((script = (struct ArgusScriptStruct *) ArgusPopFrontList(ArgusScriptList, ARGUS_LOCK)) != NULL)
-               ArgusRunScript(ArgusParser, script, ARGUS_RUN_SCRIPT);
-         }
-      }
-      if (!ArgusParser->RaParseDone)
-         nanosleep(ts, NULL);
-   }
+   MUTEX_LOCK(&list->lock);
+   for (;;) {
+      while ((list->start == NULL) && !RastreamScriptsDone)
+         pthread_cond_wait(&list->cond, &list->lock);
 
-   if (ArgusScriptList != NULL) {
-      if (!ArgusListEmpty(ArgusScriptList)) {
-         while ((script = (struct ArgusScriptStruct *) ArgusPopFrontList(ArgusScriptList, ARGUS_LOCK)) != NULL)
-            ArgusRunScript(ArgusParser, script, ARGUS_RUN_SCRIPT);
-      }
+      if ((script = (struct ArgusScriptStruct *) ArgusPopFrontList(list, ARGUS_NOLOCK)) == NULL)
+         break;
+
+      pthread_cond_broadcast(&list->cond);
+      MUTEX_UNLOCK(&list->lock);
+
+      ArgusRunScript(ArgusParser, script, ARGUS_RUN_SCRIPT);
+      ArgusFree(script);
+
+      MUTEX_LOCK(&list->lock);
    }
+   MUTEX_UNLOCK(&list->lock);
 
 #ifdef ARGUSDEBUG
    ArgusDebug (2, "ArgusScriptProcess() done!");
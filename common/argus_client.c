@@ -73,6 +73,7 @@
 #include <argus_metric.h>
 #include <argus_histo.h>
 #include <argus_label.h>
+#include <argus_grep.h>
 
 #include <rasplit.h>
 
@@ -1618,6 +1619,61 @@ unsigned char ArgusCanonDstEncapsBuffer[MAXBUFFERLEN];
 
 struct ArgusRecordStruct *
 ArgusGenerateRecordStruct (struct ArgusParserStruct *parser, struct ArgusInput *input, struct ArgusRecord *argus)
+{
+   return (ArgusGenerateRecordStructDSRs (parser, input, argus, 0xFFFFFFFF));
+}
+
+/*
+ * Map a DSR type to the dsrs[] indexes that its decoder fills, so
+ * that ArgusGenerateRecordStructDSRs() can pass over the DSRs that
+ * the caller doesn't need.  Unknown types map to every index, and
+ * are always decoded.
+ */
+
+static unsigned int
+ArgusDSRTypeIndexMask (unsigned char type)
+{
+   switch (type & 0x7F) {
+      case ARGUS_TRANSPORT_DSR: return (0x01 << ARGUS_TRANSPORT_INDEX);
+      case ARGUS_FLOW_DSR:      return (0x01 << ARGUS_FLOW_INDEX);
+      case ARGUS_TIME_DSR:      return (0x01 << ARGUS_TIME_INDEX);
+      case ARGUS_FLOW_HASH_DSR: return (0x01 << ARGUS_FLOW_HASH_INDEX);
+      case ARGUS_METER_DSR:     return (0x01 << ARGUS_METRIC_INDEX);
+      case ARGUS_PSIZE_DSR:     return (0x01 << ARGUS_PSIZE_INDEX);
+      case ARGUS_ENCAPS_DSR:    return (0x01 << ARGUS_ENCAPS_INDEX);
+      case ARGUS_NETWORK_DSR:   return (0x01 << ARGUS_NETWORK_INDEX);
+      case ARGUS_ICMP_DSR:      return (0x01 << ARGUS_ICMP_INDEX);
+      case ARGUS_MAC_DSR:       return (0x01 << ARGUS_MAC_INDEX);
+      case ARGUS_VLAN_DSR:      return (0x01 << ARGUS_VLAN_INDEX);
+      case ARGUS_VXLAN_DSR:     return (0x01 << ARGUS_VXLAN_INDEX);
+      case ARGUS_GENEVE_DSR:    return (0x01 << ARGUS_GENEVE_INDEX);
+      case ARGUS_GRE_DSR:       return (0x01 << ARGUS_GRE_INDEX);
+      case ARGUS_MPLS_DSR:      return (0x01 << ARGUS_MPLS_INDEX);
+      case ARGUS_COR_DSR:       return (0x01 << ARGUS_COR_INDEX);
+      case ARGUS_AGR_DSR:       return (0x01 << ARGUS_AGR_INDEX);
+      case ARGUS_JITTER_DSR:    return (0x01 << ARGUS_JITTER_INDEX);
+      case ARGUS_IPATTR_DSR:    return (0x01 << ARGUS_IPATTR_INDEX);
+      case ARGUS_ASN_DSR:       return (0x01 << ARGUS_ASN_INDEX);
+      case ARGUS_BEHAVIOR_DSR:  return (0x01 << ARGUS_BEHAVIOR_INDEX);
+      case ARGUS_SCORE_DSR:     return (0x01 << ARGUS_SCORE_INDEX);
+      case ARGUS_COCODE_DSR:    return (0x01 << ARGUS_COCODE_INDEX);
+      case ARGUS_LABEL_DSR:     return (0x01 << ARGUS_LABEL_INDEX);
+      case ARGUS_DATA_DSR:      return ((0x01 << ARGUS_SRCUSERDATA_INDEX) | (0x01 << ARGUS_DSTUSERDATA_INDEX));
+      case ARGUS_GEO_DSR:       return (0x01 << ARGUS_GEO_INDEX);
+      case ARGUS_LOCAL_DSR:     return (0x01 << ARGUS_LOCAL_INDEX);
+   }
+   return (0xFFFFFFFF);
+}
+
+/*
+ * ArgusGenerateRecordStructDSRs - ArgusGenerateRecordStruct() that only
+ * decodes the DSRs whose dsrs[] index is set in dsrmask.  The others are
+ * skipped over, and left NULL in the returned record, so a partial record
+ * is only good for tests against those DSRs, such as a pre-filter pass.
+ */
+
+struct ArgusRecordStruct *
+ArgusGenerateRecordStructDSRs (struct ArgusParserStruct *parser, struct ArgusInput *input, struct ArgusRecord *argus, unsigned int dsrmask)
 {
    unsigned int ArgusReverse = 0, status = 0;
    struct ArgusRecordStruct *retn = NULL;
@@ -1736,6 +1792,11 @@ ArgusGenerateRecordStruct (struct ArgusParserStruct *parser, struct ArgusInput *
                   if (argusend < ((char *)dsr + cnt))
                      break;
 
+                  if ((dsrmask != 0xFFFFFFFF) && !(ArgusDSRTypeIndexMask(type) & dsrmask)) {
+                     dsr = (struct ArgusDSRHeader *)((char *)dsr + cnt);
+                     continue;
+                  }
+
                   switch (type & 0x7F) {
                      case ARGUS_FLOW_DSR: {
                         struct ArgusFlow *flow = (struct ArgusFlow *) dsr;
@@ -4636,6 +4697,334 @@ ArgusSelectRevMaskDefs(struct ArgusRecordStruct *ns)
 }
 
 
+/*
+ * Flow keys are built by a key program, compiled from the aggregator's
+ * mask and the mask definitions of the flow type, the first time that
+ * pair is seen.  Each op copies a key field, or a run of contiguous
+ * fields of a DSR, into the key buffer.  Only the fields whose value
+ * depends on the flow itself, the ports, mpls labels, ether types and
+ * intermediate node addresses, have their own ops.
+ *
+ * The key buffer isn't cleared, as only the key length is ever compared
+ * or copied, so just the pad byte of an odd length key is zeroed.
+ */
+
+#define ARGUS_KEY_COPY		0
+#define ARGUS_KEY_MPLS		1
+#define ARGUS_KEY_PORT		2
+#define ARGUS_KEY_INDEX		3
+#define ARGUS_KEY_ETYPE		4
+#define ARGUS_KEY_INODE		5
+
+#define ARGUS_KEY_PROGRAMS	8
+
+struct ArgusKeyOp {
+   unsigned char op, ind, dsr, pad;
+   short offset, len;
+};
+
+struct ArgusKeyProgram {
+   struct ArgusMaskStruct *defs;
+   long long mask;
+   int generation, reverse, hdr, nops;
+   struct ArgusKeyOp ops[ARGUS_MAX_MASK_LIST];
+};
+
+struct ArgusKeyCache {
+   int count, next, last;
+   struct ArgusKeyProgram progs[ARGUS_KEY_PROGRAMS];
+};
+
+/* bumped when the mask definitions are (re)initialized */
+static int ArgusKeyGeneration = 1;
+
+static void
+ArgusCompileKeyProgram (struct ArgusAggregatorStruct *na, struct ArgusKeyProgram *prog,
+                        struct ArgusMaskStruct *defs, int reverse)
+{
+   struct ArgusKeyOp *op = NULL;
+   int i, type;
+
+   bzero (prog, sizeof(*prog));
+   prog->defs = defs;
+   prog->mask = na->mask;
+   prog->reverse = reverse;
+   prog->generation = ArgusKeyGeneration;
+   prog->hdr = (na->mask & ((0x01LL << ARGUS_MASK_SADDR) | (0x01LL << ARGUS_MASK_DADDR))) ? 1 : 0;
+
+   for (i = 0; i < ARGUS_MAX_MASK_LIST; i++) {
+      if (na->mask < (0x01LL << i))
+         break;
+      if (!(na->mask & (0x01LL << i)))
+         continue;
+      if (!reverse && (defs[i].name == NULL))
+         continue;
+
+      switch (i) {
+         case ARGUS_MASK_SMPLS:
+         case ARGUS_MASK_DMPLS:
+            type = ARGUS_KEY_MPLS;
+            break;
+
+         case ARGUS_MASK_SPORT:
+         case ARGUS_MASK_DPORT:
+            type = ARGUS_KEY_PORT;
+            break;
+
+         default:
+            if (defs[i].len <= 0)
+               continue;
+            if (!reverse && (i == ARGUS_MASK_STIME))
+               continue;
+
+            if (!reverse && (i == ARGUS_MASK_INODE))
+               type = ARGUS_KEY_INODE;
+            else
+            if (defs[i].offset == NLI)
+               type = ARGUS_KEY_INDEX;
+            else
+            if (!reverse && (i == ARGUS_MASK_ETYPE))
+               type = ARGUS_KEY_ETYPE;
+            else
+               type = ARGUS_KEY_COPY;
+            break;
+      }
+
+      if ((type == ARGUS_KEY_COPY) && (op != NULL) && (op->op == ARGUS_KEY_COPY) &&
+          (op->dsr == defs[i].dsr) && ((op->offset + op->len) == defs[i].offset)) {
+         op->len += defs[i].len;
+         continue;
+      }
+
+      op = &prog->ops[prog->nops++];
+      op->op     = type;
+      op->ind    = i;
+      op->dsr    = defs[i].dsr;
+      op->offset = defs[i].offset;
+      op->len    = defs[i].len;
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (3, "ArgusCompileKeyProgram (%p, %p, %p, %d) mask 0x%llx %d ops\n", na, prog, defs, reverse, na->mask, prog->nops);
+#endif
+}
+
+static struct ArgusKeyProgram *
+ArgusFindKeyProgram (struct ArgusAggregatorStruct *na, struct ArgusMaskStruct *defs, int reverse)
+{
+   struct ArgusKeyCache *kc;
+   struct ArgusKeyProgram *prog;
+   int i;
+
+   if ((kc = na->kcache) == NULL) {
+      if ((kc = na->kcache = (struct ArgusKeyCache *) ArgusCalloc(1, sizeof(*kc))) == NULL)
+         ArgusLog (LOG_ERR, "ArgusFindKeyProgram: ArgusCalloc error %s", strerror(errno));
+   }
+
+   prog = &kc->progs[kc->last];
+   if ((kc->count > 0) && (prog->defs == defs) && (prog->mask == na->mask) && (prog->reverse == reverse) &&
+                          (prog->generation == ArgusKeyGeneration))
+      return (prog);
+
+   for (i = 0; i < kc->count; i++) {
+      prog = &kc->progs[i];
+      if ((prog->defs == defs) && (prog->mask == na->mask) && (prog->reverse == reverse) &&
+                                  (prog->generation == ArgusKeyGeneration)) {
+         kc->last = i;
+         return (prog);
+      }
+   }
+
+   if (kc->count < ARGUS_KEY_PROGRAMS)
+      i = kc->count++;
+   else {
+      i = kc->next;
+      kc->next = (kc->next + 1) % ARGUS_KEY_PROGRAMS;
+   }
+
+   prog = &kc->progs[i];
+   ArgusCompileKeyProgram (na, prog, defs, reverse);
+   kc->last = i;
+   return (prog);
+}
+
+static void
+ArgusKeyCopy (char *dst, char *src, int len)
+{
+   switch (len) {
+      case 1:  *dst = *src; break;
+      case 2:  memcpy (dst, src, 2); break;
+      case 4:  memcpy (dst, src, 4); break;
+      case 8:  memcpy (dst, src, 8); break;
+      case 16: memcpy (dst, src, 16); break;
+      default: bcopy (src, dst, len); break;
+   }
+}
+
+static void
+ArgusKeyIndex (char *dst, int *index, int len)
+{
+   unsigned char cbuf;
+   unsigned short sbuf;
+
+   switch (len) {
+      case 0:
+      case 1: cbuf = *index; bcopy (&cbuf, dst, len); break;
+      case 2: sbuf = *index; bcopy (&sbuf, dst, len); break;
+      case 4:
+      default:
+         bcopy (index, dst, len);
+         break;
+   }
+}
+
+/*
+ * the IPv4 port fields hold the spi for ESP, and the type and code
+ * for ICMP, so how much of them is key is decided for each flow.
+ * returns the number of key bytes, or -1 for none.
+ */
+
+static int
+ArgusKeyPortLength (struct ArgusKeyProgram *prog, struct ArgusKeyOp *op, struct ArgusFlow *flow, int *offset)
+{
+   int slen = 0;
+
+   if ((flow != NULL) && ((flow->hdr.subtype & 0x3F) == ARGUS_FLOW_CLASSIC5TUPLE) &&
+                         ((flow->hdr.argus_dsrvl8.qual & 0x1F) == ARGUS_TYPE_IPV4)) {
+      switch (flow->ip_flow.ip_p) {
+         case IPPROTO_ESP: {
+            slen    = (op->ind == ARGUS_MASK_SPORT) ? -1 : 4;
+            *offset = (op->ind == ARGUS_MASK_SPORT) ? -1 : op->offset;
+            break;
+         }
+
+         case IPPROTO_ICMP: {
+            if (op->ind == ARGUS_MASK_SPORT) {
+               slen = 1;
+               *offset = op->offset;
+            } else
+            if (prog->reverse) {
+               slen = 1;
+               *offset = op->offset - 1;
+            } else {
+               switch (flow->icmp_flow.type) {
+                  case ICMP_ECHO:
+                  case ICMP_ECHOREPLY:
+                     slen = -1;
+                     break;
+
+                  case ICMP_MASKREQ:
+                  case ICMP_TSTAMP:
+                  case ICMP_IREQ:
+                  case ICMP_MASKREPLY:
+                  case ICMP_TSTAMPREPLY:
+                  case ICMP_IREQREPLY:
+                     *offset = op->offset - 1;
+                     slen = 5;
+                     break;
+
+                  default:
+                     *offset = op->offset - 1;
+                     slen = 1;
+                     break;
+               }
+            }
+            break;
+         }
+      }
+   }
+   return (slen);
+}
+
+static int
+ArgusRunKeyProgram (struct ArgusAggregatorStruct *na, struct ArgusKeyProgram *prog,
+                    struct ArgusRecordStruct *ns, struct ArgusFlow *flow, char *ptr)
+{
+   int i, tlen = 0;
+
+   if (prog->hdr && (flow != NULL)) {
+      bcopy ((char *)&flow->hdr, ptr, sizeof(flow->hdr));
+      ((struct ArgusFlow *)ptr)->hdr.subtype           &= 0x3F;
+      ((struct ArgusFlow *)ptr)->hdr.argus_dsrvl8.qual &= 0x1F;
+      ((struct ArgusFlow *)ptr)->hdr.argus_dsrvl8.len   = 0;
+      ptr += sizeof(flow->hdr);
+      tlen += sizeof(flow->hdr);
+   }
+
+   for (i = 0; (i < prog->nops) && (tlen < RA_HASHSIZE); i++) {
+      struct ArgusKeyOp *op = &prog->ops[i];
+      char *p = (char *)ns->dsrs[op->dsr];
+      int offset = op->offset, slen = op->len;
+
+      if (p == NULL)
+         continue;
+
+      switch (op->op) {
+         case ARGUS_KEY_COPY:
+            ArgusKeyCopy (ptr, &p[offset], slen);
+            break;
+
+         case ARGUS_KEY_MPLS: {
+            unsigned int label  = (*(unsigned int *)&p[offset]) >> 12;
+            bcopy ((char *)&label, ptr, slen);
+            break;
+         }
+
+         case ARGUS_KEY_INDEX:
+            ArgusKeyIndex (ptr, &prog->defs[op->ind].index, slen);
+            break;
+
+         case ARGUS_KEY_ETYPE: {
+            u_short etype;
+            bcopy (&p[offset], ptr, slen);
+            etype = *(u_short *)ptr;
+            if (etype < 1500)
+               *(u_short *)ptr = 0;
+            break;
+         }
+
+         case ARGUS_KEY_INODE: {
+            unsigned int iaddr[4];
+            bcopy (&p[offset], iaddr, slen);
+
+            if (na->iaddrlen > 0)
+               iaddr[0] &= na->imask.addr_un.ipv4;
+
+            bcopy (iaddr, ptr, slen);
+            break;
+         }
+
+         case ARGUS_KEY_PORT: {
+            if ((slen = ArgusKeyPortLength (prog, op, flow, &offset)) < 0) {
+               slen = 0;
+               break;
+            }
+
+            if (op->len > 0) {
+               if (!slen) {
+                  slen = op->len;
+                  offset = op->offset;
+               }
+               if (offset == NLI)
+                  ArgusKeyIndex (ptr, &prog->defs[op->ind].index, slen);
+               else
+                  ArgusKeyCopy (ptr, &p[offset], slen);
+            } else
+               bzero (ptr, slen);
+            break;
+         }
+      }
+
+      ptr  += slen;
+      tlen += slen;
+   }
+
+   if ((tlen & 0x01) && (tlen < RA_HASHSIZE))
+      *ptr = 0;
+
+   return (tlen);
+}
+
 struct ArgusHashStruct *
 ArgusGenerateHashStruct (struct ArgusAggregatorStruct *na,  struct ArgusRecordStruct *ns, struct ArgusFlow *flow)
 {
@@ -4646,8 +5035,7 @@ ArgusGenerateHashStruct (struct ArgusAggregatorStruct *na,  struct ArgusRecordSt
       if (na->hstruct.buf == NULL) {
          if ((na->hstruct.buf = (unsigned int *) ArgusCalloc(1, RA_HASHSIZE)) == NULL)
             ArgusLog (LOG_ERR, "ArgusGenerateHashStruct(%p, %p, %p) ArgusCalloc returned error %s\n", na, ns, flow, strerror(errno));
-      } else
-         bzero(na->hstruct.buf, RA_HASHSIZE);
+      }
 
       ptr = (char *) na->hstruct.buf;
 
@@ -4732,154 +5120,7 @@ ArgusGenerateHashStruct (struct ArgusAggregatorStruct *na,  struct ArgusRecordSt
                   if ((na->ArgusMaskDefs = ArgusSelectMaskDefs(ns)) == NULL) 
                      return(retn);
 
-               if ((flow != NULL)) {
-                  if (na->mask & ((0x01LL << ARGUS_MASK_SADDR) | (0x01LL << ARGUS_MASK_DADDR))) {
-                     bcopy ((char *)&flow->hdr, ptr, sizeof(flow->hdr));
-                     ((struct ArgusFlow *)ptr)->hdr.subtype           &= 0x3F;
-                     ((struct ArgusFlow *)ptr)->hdr.argus_dsrvl8.qual &= 0x1F;
-                     ((struct ArgusFlow *)ptr)->hdr.argus_dsrvl8.len   = 0;
-                     ptr += sizeof(flow->hdr);
-                     tlen += sizeof(flow->hdr);
-                  }
-               }
-                   
-               for (i = 0; ((i < ARGUS_MAX_MASK_LIST) && (tlen < RA_HASHSIZE)); i++) {
-                  if (na->mask < (0x01LL << i)) 
-                     break;
-                  if (na->mask & (0x01LL << i)) {
-                     if (na->ArgusMaskDefs[i].name != NULL) {
-                     char *p = (char *)ns->dsrs[na->ArgusMaskDefs[i].dsr];
-
-                     if (p != NULL) {
-                        int offset = 0, slen = 0;
-
-                        switch (i) {
-                           case ARGUS_MASK_STIME:
-                              break;
-
-                           case ARGUS_MASK_SMPLS:
-                           case ARGUS_MASK_DMPLS: {
-                              unsigned int label  = (*(unsigned int *)&((char *) p)[na->ArgusMaskDefs[i].offset]) >> 12;
-                              bcopy ((char *)&label, ptr, na->ArgusMaskDefs[i].len);
-                              ptr  += na->ArgusMaskDefs[i].len;
-                              tlen += na->ArgusMaskDefs[i].len;
-                              break;
-                           }
-
-                           case ARGUS_MASK_SPORT:
-                           case ARGUS_MASK_DPORT: {
-                              if (flow != NULL) {
-                                 switch (flow->hdr.subtype & 0x3F) {
-                                    case ARGUS_FLOW_CLASSIC5TUPLE: {
-                                       switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
-                                          case ARGUS_TYPE_IPV4:
-                                             switch (flow->ip_flow.ip_p) {
-                                                case IPPROTO_ESP: {
-                                                   slen   = (i == ARGUS_MASK_SPORT) ? -1 : 4;
-                                                   offset = (i == ARGUS_MASK_SPORT) ? -1 : na->ArgusMaskDefs[i].offset;
-                                                   break;
-                                                }
-
-                                                case IPPROTO_ICMP: {
-                                                   if (i == ARGUS_MASK_SPORT) {
-                                                      slen = 1;
-                                                      offset = na->ArgusMaskDefs[i].offset;
-                                                   } else {
-                                                      switch (flow->icmp_flow.type) {
-                                                         case ICMP_ECHO:
-                                                         case ICMP_ECHOREPLY:
-                                                            slen = -1;
-                                                            break;
-
-                                                         case ICMP_MASKREQ:
-                                                         case ICMP_TSTAMP:
-                                                         case ICMP_IREQ: 
-                                                         case ICMP_MASKREPLY:
-                                                         case ICMP_TSTAMPREPLY:
-                                                         case ICMP_IREQREPLY:
-                                                            offset = na->ArgusMaskDefs[i].offset - 1;
-                                                            slen = 5;
-                                                            break;
-  
-                                                         default:
-                                                            offset = na->ArgusMaskDefs[i].offset - 1;
-                                                            slen = 1;
-                                                      }
-                                                   }
-                                                   break;
-                                                }
-                                             }
-                                             break;  
-                                       }
-                                    }
-                                 }
-                              }
-                           }
-
-                           default: {
-                              if (slen < 0) {
-                                 slen = 0;
-                                 break;
-                              }
-
-                              if (na->ArgusMaskDefs[i].len > 0) {
-                                 if (!slen) {
-                                    slen = na->ArgusMaskDefs[i].len;
-                                    offset = na->ArgusMaskDefs[i].offset;
-                                 }
-
-                                 if (offset == NLI) {
-                                    unsigned char *cptr = NULL, cbuf;
-                                    unsigned short sbuf;
-                                    switch (slen) {
-                                       case 0: cbuf = na->ArgusMaskDefs[i].index; cptr = &cbuf; break;
-                                       case 1: cbuf = na->ArgusMaskDefs[i].index; cptr = &cbuf; break;
-                                       case 2: sbuf = na->ArgusMaskDefs[i].index; cptr = (unsigned char *)&sbuf; break;
-                                       case 4:
-                                       default:
-                                          cptr = (unsigned char *)&na->ArgusMaskDefs[i].index;
-                                          break;
-                                    }
-
-                                    bcopy (cptr, ptr, slen);
-
-                                 } else {
-                                    bcopy (&((char *) p)[offset], ptr, slen);
-
-                                    if (ARGUS_MASK_ETYPE == i) {
-                                       u_short etype = *(u_short *)ptr;
-                                       if (etype < 1500) {
-                                          *(u_short *)ptr = 0;
-                                       }
-                                    }
-                                 }
-                              }
-                              break;
-                           }
-
-
-                           case ARGUS_MASK_INODE: {
-                              if (na->ArgusMaskDefs[i].len > 0) {
-                                 unsigned int iaddr[4];
-                                 slen = na->ArgusMaskDefs[i].len;
-                                 offset = na->ArgusMaskDefs[i].offset;
-                                 bcopy (&((char *) p)[offset], iaddr, slen);
-
-                                 if (na->iaddrlen > 0)
-                                    iaddr[0] &= na->imask.addr_un.ipv4;
-
-                                 bcopy (iaddr, ptr, slen);
-                              }
-                              break;
-                           }
-                        }
-
-                        ptr  += slen;
-                        tlen += slen;
-                     }
-                     }
-                  }
-               }
+               tlen = ArgusRunKeyProgram (na, ArgusFindKeyProgram (na, na->ArgusMaskDefs, 0), ns, flow, ptr);
 
                retn->len = s * ((tlen + (s - 1))/ s); 
                if (retn->len > RA_HASHSIZE)
@@ -4914,9 +5155,7 @@ ArgusGenerateReverseHashStruct (struct ArgusAggregatorStruct *na,  struct ArgusR
          ArgusLog (LOG_ERR, "ArgusGenerateHashStruct(%p, %p, %p) ArgusCalloc returned error %s\n", na, ns, flow, strerror(errno));
 
       ptr = (char *) na->hstruct.buf;
-
-   } else
-      bzero ((char *)ptr, retn->len);
+   }
 
    retn->hash = 0; 
    retn->len  = 0;
@@ -4929,114 +5168,22 @@ ArgusGenerateReverseHashStruct (struct ArgusAggregatorStruct *na,  struct ArgusR
 //       if (na->ArgusMaskDefs == NULL)
             na->ArgusMaskDefs = ArgusSelectRevMaskDefs(ns);
 
-         if (na->mask & ((0x01LL << ARGUS_MASK_SADDR) | (0x01LL << ARGUS_MASK_DADDR))) {
-            bcopy ((char *)&flow->hdr, ptr, sizeof(flow->hdr));
-            ((struct ArgusFlow *)ptr)->hdr.subtype           &= 0x3F;
-            ((struct ArgusFlow *)ptr)->hdr.argus_dsrvl8.qual &= 0x1F;
-            ((struct ArgusFlow *)ptr)->hdr.argus_dsrvl8.len   = 0;
-            ptr += sizeof(flow->hdr);
-            tlen += sizeof(flow->hdr);
-         }
-          
-         for (i = 0; ((i < ARGUS_MAX_MASK_LIST) && (tlen < RA_HASHSIZE)); i++) {
-            if (na->mask < (0x01LL << i))
-               break;
-
-            if (na->mask & (0x01LL << i)) {
-               int offset = 0, slen = 0;
-               char *p = (char *)ns->dsrs[na->ArgusMaskDefs[i].dsr];
+         tlen = ArgusRunKeyProgram (na, ArgusFindKeyProgram (na, na->ArgusMaskDefs, 1), ns, flow, ptr);
 
-               if (p != NULL) {
-                  switch (i) {
-                     case ARGUS_MASK_SMPLS:
-                     case ARGUS_MASK_DMPLS: {
-                        unsigned int label  = (*(unsigned int *)&((char *) p)[na->ArgusMaskDefs[i].offset]) >> 12;
-                        bcopy ((char *)&label, ptr, na->ArgusMaskDefs[i].len);
-                        ptr  += na->ArgusMaskDefs[i].len;
-                        tlen += na->ArgusMaskDefs[i].len;
-                        break;
-                     }
+         retn->len = s * ((tlen + (s - 1))/ s); 
+         if (retn->len > RA_HASHSIZE)
+            retn->len = RA_HASHSIZE;
+         sptr = (unsigned short *)&retn->buf[0];
 
-                     case ARGUS_MASK_SPORT:
-                     case ARGUS_MASK_DPORT:
-                        switch (flow->hdr.subtype & 0x3F) {
-                           case ARGUS_FLOW_CLASSIC5TUPLE: {
-                              switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
-                                 case ARGUS_TYPE_IPV4:
-                                    switch (flow->ip_flow.ip_p) {
-                                       case IPPROTO_ESP: { 
-                                          slen   = (i == ARGUS_MASK_SPORT) ? -1 : 4;
-                                          offset = (i == ARGUS_MASK_SPORT) ? -1 : na->ArgusMaskDefs[i].offset;
-                                          break;
-                                       }
+         for (i = 0, len = retn->len / s; i < len; i++)
+            retn->hash += *sptr++;
 
-                                       case IPPROTO_ICMP: { 
-                                          slen = 1;
-                                          offset = (i == ARGUS_MASK_SPORT) ? na->ArgusMaskDefs[i].offset :
-                                                                             na->ArgusMaskDefs[i].offset - 1;
-                                          break;
-                                       }
-                                    }
-                                    break;  
-                              }
-                           }
-                        }
+         na->ArgusMaskDefs = NULL;
+      }
+   }
 
-                     default: {
-                        if (slen < 0) {
-                           slen = 0;
-                           break;
-                        }
-
-                        if (na->ArgusMaskDefs[i].len > 0) {
-                           if (!slen) {
-                              slen = na->ArgusMaskDefs[i].len;
-                              offset = na->ArgusMaskDefs[i].offset;
-                           }
-
-                           if (offset == NLI) {
-                              unsigned char *cptr = NULL, cbuf;
-                              unsigned short sbuf;
-                              switch (slen) {
-                                 case 0: cbuf = na->ArgusMaskDefs[i].index; cptr = &cbuf; break;
-                                 case 1: cbuf = na->ArgusMaskDefs[i].index; cptr = &cbuf; break;
-                                 case 2: sbuf = na->ArgusMaskDefs[i].index; cptr = (unsigned char *)&sbuf; break;
-                                 case 4:
-                                 default:
-                                    cptr = (unsigned char *)&na->ArgusMaskDefs[i].index;
-                                    break;
-                              }
-
-                              bcopy (cptr, ptr, slen);
-
-                           } else {
-                              bcopy (&((char *) p)[offset], ptr, slen);
-                           }
-                        }
-                        break;
-                     }
-                  }
-
-                  ptr  += slen;
-                  tlen += slen;
-               }
-            }
-         }
-
-         retn->len = s * ((tlen + (s - 1))/ s); 
-         if (retn->len > RA_HASHSIZE)
-            retn->len = RA_HASHSIZE;
-         sptr = (unsigned short *)&retn->buf[0];
-
-         for (i = 0, len = retn->len / s; i < len; i++)
-            retn->hash += *sptr++;
-
-         na->ArgusMaskDefs = NULL;
-      }
-   }
-
-   return (retn);
-}
+   return (retn);
+}
 
 
 struct ArgusHashStruct *
@@ -5057,9 +5204,7 @@ ArgusGenerateHintStruct (struct ArgusAggregatorStruct *na,  struct ArgusRecordSt
             ArgusLog (LOG_ERR, "ArgusGenerateHashStruct(%p, %p, %p) ArgusCalloc returned error %s\n", na, ns, flow, strerror(errno));
 
          ptr = (char *) na->hstruct.buf;
-
-      } else
-         bzero ((char *)ptr, retn->len);
+      }
 
       retn->hash = 0; 
       retn->len  = 0;
@@ -5133,6 +5278,8 @@ ArgusGenerateHintStruct (struct ArgusAggregatorStruct *na,  struct ArgusRecordSt
       }
 
       if (len > 0) {
+         if (len & 0x01)
+            ((char *) na->hstruct.buf)[len] = 0;
          retn->len = s * ((len + (s - 1))/ s); 
          sptr = (unsigned short *)&retn->buf[0];
 
@@ -5950,7 +6097,8 @@ ArgusGenerateNewFlow(struct ArgusAggregatorStruct *na, struct ArgusRecordStruct
          tflow.hdr.subtype &= 0x3F;
          tflow.hdr.argus_dsrvl8.qual &= 0x1F;
       }
-      for (i = 0; i < ARGUS_MAX_MASK_LIST; i++) {
+      /* only the proto, address and port keys change the flow */
+      for (i = ARGUS_MASK_PROTO; i <= ARGUS_MASK_DPORT; i++) {
          if (na->mask < (0x01LL << i))
             break;
          if (na->mask & (0x01LL << i)) {
@@ -6387,307 +6535,211 @@ ArgusMergeAddress(unsigned int *a1, unsigned int *a2, int type, int dir, unsigne
 }
 
 
-void
-ArgusMergeRecords (const struct ArgusAggregatorStruct * const na,
-                   struct ArgusRecordStruct *ns1, struct ArgusRecordStruct *ns2)
-{
-   struct ArgusAgrStruct *agr = NULL;
-   double seconds;
-   int i;
-
-   if (ns1 && ns2) {
-      if ((ns1->hdr.type & 0xF0) == (ns2->hdr.type & 0xF0)) {
-         switch (ns1->hdr.type & 0xF0) {
-            case ARGUS_MAR: {
-               struct ArgusMarStruct *man1 = (struct ArgusMarStruct *) &((struct ArgusRecord *) ns1->dsrs[0])->ar_un.mar;
-               struct ArgusMarStruct *man2 = (struct ArgusMarStruct *) &((struct ArgusRecord *) ns2->dsrs[0])->ar_un.mar;
-
-               if ((ns1->hdr.cause & 0xF0) == ARGUS_START) {
-               } else
-               if ((ns1->hdr.cause & 0xF0) == ARGUS_STATUS) {
-                  double stime1 = ArgusFetchStartuSecTime(ns1);
-                  double stime2 = ArgusFetchStartuSecTime(ns2);
-                  double ltime1 = ArgusFetchLastuSecTime(ns1);
-                  double ltime2 = ArgusFetchLastuSecTime(ns2);
+/*
+ * ArgusMergeRecords() merges each DSR with its own routine, called in
+ * DSR index order, as some routines depend on what was merged before
+ * them.  Most DSR routines only do something when ns2 has the DSR, so
+ * the set of routines to run is decided by the layout of ns2, the
+ * dsrindex, plus the few that also act when ns2 doesn't have the DSR.
+ * The common FAR layouts, flow, time, metrics, attributes, network,
+ * jitter and packet size, get a kernel that calls the routines directly.
+ */
 
-                  if ((stime2 < stime1) || (stime1 == 0)) {
-                     man1->startime          = man2->startime;
-                     man1->nextMrSequenceNum = man2->nextMrSequenceNum;
-                     man1->interfaceStatus   = man2->interfaceStatus;
-                     man1->drift             = man2->drift;
-                     man1->clients           = man2->clients;
-                  }
+struct ArgusMergeContext {
+   double deltaSrcFlowTime, deltaDstFlowTime;
+};
 
-                  if ((ltime2 > ltime1) || (ltime1 == 0))
-                     man1->now = man2->now;
+typedef void (*ArgusMergeDSRRoutine) (const struct ArgusAggregatorStruct * const, struct ArgusRecordStruct *,
+                                      struct ArgusRecordStruct *, int, struct ArgusMergeContext *);
 
-                  man1->pktsRcvd  += man2->pktsRcvd;
-                  man1->bytesRcvd += man2->bytesRcvd;
-                  man1->drift      = man2->drift;
-                  man1->records   += man2->records;
-                  man1->queue      = man2->queue;
-                  man1->output    += man2->output;
-                  man1->flows     += man2->flows;
-                  man1->dropped   += man2->dropped;
-                  man1->bytes     += man2->bytes;
-                  man1->bufs       = man2->bufs;
-                  man1->suserlen   = man2->suserlen;
-                  man1->duserlen   = man2->duserlen;
+// Merging Flow records is a matter of testing each field and
+// transforming values that are not equal to either run length
+// and'ing or zeroing out the value.  When a value is zero'ed
+// we need to indicate it in the status field of the flow
+// descriptor so that values resulting from merging are not
+// confused with values actually off the wire.
+//
+// run length and'ing is an attempt to preserve CIDR addresses.
+// any other value should be either preserved or invalidated.
+static void
+ArgusMergeFlowDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                   struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusFlow *f1 = (struct ArgusFlow *) ns1->dsrs[ARGUS_FLOW_INDEX];
+   struct ArgusFlow *f2 = (struct ArgusFlow *) ns2->dsrs[ARGUS_FLOW_INDEX];
 
-                  man1->status |= ARGUS_RECORD_MODIFIED;
+   if (f1 && f2) {
+      unsigned char masklen = 0;
+      if ((f1->hdr.subtype & 0x3F) == (f2->hdr.subtype & 0x3F)) {
+         char f1qual = f1->hdr.argus_dsrvl8.qual & 0x1F;
+         char f2qual = f2->hdr.argus_dsrvl8.qual & 0x1F;
+
+         if (f1->hdr.subtype != f2->hdr.subtype) {
+            if ((f1->hdr.subtype & ARGUS_REVERSE) || (f2->hdr.subtype & ARGUS_REVERSE)) {
+               long long v1 = ArgusFetchStartTime(ns1);
+               long long v2 = ArgusFetchStartTime(ns2);
+               if (v1 > v2) {
+                  f1->hdr.subtype = f2->hdr.subtype;
                }
-               break;
             }
+         }
 
-            case ARGUS_NETFLOW:
-            case ARGUS_AFLOW:
-            case ARGUS_FAR: {
-               struct ArgusTimeObject *ns1time = (void *)ns1->dsrs[ARGUS_TIME_INDEX];
-               struct ArgusTimeObject *ns2time = (void *)ns2->dsrs[ARGUS_TIME_INDEX];
-               struct ArgusMetricStruct *ns1metric = (void *)ns1->dsrs[ARGUS_METRIC_INDEX];
-               struct ArgusMetricStruct *ns2metric = (void *)ns2->dsrs[ARGUS_METRIC_INDEX];
-
-               double deltaSrcFlowTime = 0.0;
-               double deltaDstFlowTime = 0.0;
-
-               if ((ns1time && ns2time) && (ns1metric && ns2metric)) {
-                  double senst1 = (ns1time->src.end.tv_sec * 1000000LL) + ns1time->src.end.tv_usec;
-                  double denst1 = (ns1time->dst.end.tv_sec * 1000000LL) + ns1time->dst.end.tv_usec;
-
-                  double ssnst2 = (ns2time->src.start.tv_sec * 1000000LL) + ns2time->src.start.tv_usec;
-                  double dsnst2 = (ns2time->dst.start.tv_sec * 1000000LL) + ns2time->dst.start.tv_usec;
+         switch (f1->hdr.subtype & 0x3F) {
+            case ARGUS_FLOW_LAYER_3_MATRIX: {
+               if (f1qual == f2qual) {
+                  switch (f1qual) {
+                     case ARGUS_TYPE_IPV4: {
+                        masklen = (f1->ip_flow.smask > f2->ip_flow.smask) ? f2->ip_flow.smask : f1->ip_flow.smask;
+                        f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ip_flow.ip_src, &f2->ip_flow.ip_src, ARGUS_TYPE_IPV4, ARGUS_SRC, &masklen);
+                        f1->ip_flow.smask = masklen;
+                        masklen = (f1->ip_flow.dmask > f2->ip_flow.dmask) ? f2->ip_flow.dmask : f1->ip_flow.dmask;
+                        f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ip_flow.ip_dst, &f2->ip_flow.ip_dst, ARGUS_TYPE_IPV4, ARGUS_DST, &masklen);
+                        f1->ip_flow.dmask = masklen;
+                        f1->hdr.argus_dsrvl8.qual |= ARGUS_MASKLEN;
+                        break;
 
-                  double slstime = (ns1->lastSrcStartTime.tv_sec * 1000000LL) + ns1->lastSrcStartTime.tv_usec;
+                     case ARGUS_TYPE_IPV6:  
+                        masklen = (f1->ipv6_flow.smask > f2->ipv6_flow.smask) ? f2->ipv6_flow.smask : f1->ipv6_flow.smask;
+                        f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ipv6_flow.ip_src[0], &f2->ipv6_flow.ip_src[0], ARGUS_TYPE_IPV6, ARGUS_SRC, &masklen);
+                        f1->ip_flow.smask = masklen;
+                        masklen = (f1->ipv6_flow.dmask > f2->ipv6_flow.dmask) ? f2->ipv6_flow.dmask : f1->ipv6_flow.dmask;
+                        f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ipv6_flow.ip_dst[0], &f2->ipv6_flow.ip_dst[0], ARGUS_TYPE_IPV6, ARGUS_DST, &masklen);
+                        f1->ip_flow.dmask = masklen;
+                        f1->hdr.argus_dsrvl8.qual |= ARGUS_MASKLEN;
+                        break;
 
-                  if (ns1metric->src.pkts && ns2metric->src.pkts) {
-                     if (slstime) {
-                     } else {
                      }
-                     deltaSrcFlowTime = fabs(ssnst2 - senst1)/1000000.0;
-                  }
-
-                  if (ns1metric->dst.pkts && ns2metric->dst.pkts) {
-                     deltaDstFlowTime = fabs(dsnst2 - denst1)/1000000.0;
                   }
                }
+               break;
+            }
 
-               ns1->status &= ~ARGUS_RECORD_WRITTEN; 
-           
-               if ((agr = (struct ArgusAgrStruct *) ns1->dsrs[ARGUS_AGR_INDEX]) == NULL) {
-                  struct ArgusMetricStruct *metric = (void *)ns1->dsrs[ARGUS_METRIC_INDEX];
-                  if ((metric != NULL) && ((metric->src.pkts + metric->dst.pkts) > 0)) {
-                     double value = na->RaMetricFetchAlgorithm(ns1);
-
-                     if ((agr = ArgusCalloc(1, sizeof(*agr))) == NULL)
-                        ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error: %s", strerror(errno));
-
-                     agr->hdr.type              = ARGUS_AGR_DSR;
-                     agr->hdr.subtype           = na->ArgusMetricIndex;
-                     agr->hdr.argus_dsrvl8.qual = 0x01;
-                     agr->hdr.argus_dsrvl8.len  = (sizeof(*agr) + 3)/4;
-                     agr->count                 = 1;
-                     agr->act.maxval            = value;
-                     agr->act.minval            = value;
-                     agr->act.meanval           = value;
-                     agr->act.n                 = 1;
-                     bzero ((char *)&agr->idle, sizeof(agr->idle));
-                     agr->idle.minval           = 1000000000.0;
-
-                     ns1->dsrs[ARGUS_AGR_INDEX] = (struct ArgusDSRHeader *) agr;
-                     ns1->dsrindex |= (0x01 << ARGUS_AGR_INDEX);
-                  }
-               }
+            case ARGUS_FLOW_CLASSIC5TUPLE: {
+                  switch (f1qual) {
+                     case ARGUS_TYPE_IPV4:
+                        if (f1qual == f2qual) {
+                           masklen = (f1->ip_flow.smask > f2->ip_flow.smask) ? f2->ip_flow.smask : f1->ip_flow.smask;
+                           ArgusMergeAddress(&f1->ip_flow.ip_src, &f2->ip_flow.ip_src, ARGUS_TYPE_IPV4, ARGUS_SRC, &masklen);
+                           f1->ip_flow.smask = masklen;
 
-               for (i = 0; i < ARGUSMAXDSRTYPE; i++) {
-                  switch (i) {
+                           masklen = (f1->ip_flow.dmask > f2->ip_flow.dmask) ? f2->ip_flow.dmask : f1->ip_flow.dmask;
+                           ArgusMergeAddress(&f1->ip_flow.ip_dst, &f2->ip_flow.ip_dst, ARGUS_TYPE_IPV4, ARGUS_DST, &masklen);
+                           f1->ip_flow.dmask = masklen;
 
-// Merging Flow records is a matter of testing each field and
-// transforming values that are not equal to either run length
-// and'ing or zeroing out the value.  When a value is zero'ed
-// we need to indicate it in the status field of the flow
-// descriptor so that values resulting from merging are not
-// confused with values actually off the wire.
-//
-// run length and'ing is an attempt to preserve CIDR addresses.
-// any other value should be either preserved or invalidated.
+                           f1->hdr.argus_dsrvl8.qual |= ARGUS_MASKLEN;
 
-                     case ARGUS_FLOW_INDEX: {
-                        struct ArgusFlow *f1 = (struct ArgusFlow *) ns1->dsrs[ARGUS_FLOW_INDEX];
-                        struct ArgusFlow *f2 = (struct ArgusFlow *) ns2->dsrs[ARGUS_FLOW_INDEX];
-
-                        if (f1 && f2) {
-                           unsigned char masklen = 0;
-                           if ((f1->hdr.subtype & 0x3F) == (f2->hdr.subtype & 0x3F)) {
-                              char f1qual = f1->hdr.argus_dsrvl8.qual & 0x1F;
-                              char f2qual = f2->hdr.argus_dsrvl8.qual & 0x1F;
-
-                              if (f1->hdr.subtype != f2->hdr.subtype) {
-                                 if ((f1->hdr.subtype & ARGUS_REVERSE) || (f2->hdr.subtype & ARGUS_REVERSE)) {
-                                    long long v1 = ArgusFetchStartTime(ns1);
-                                    long long v2 = ArgusFetchStartTime(ns2);
-                                    if (v1 > v2) {
-                                       f1->hdr.subtype = f2->hdr.subtype;
-                                    }
+                           if (f1->ip_flow.ip_p  != f2->ip_flow.ip_p)
+                              f1->ip_flow.ip_p = 0;
+                           else {
+                              switch (f1->ip_flow.ip_p) {
+                                 case IPPROTO_ESP: {
+                                    if (f1->esp_flow.spi != f2->esp_flow.spi)
+                                       f1->esp_flow.spi = 0;
+                                    break;
                                  }
-                              }
-
-                              switch (f1->hdr.subtype & 0x3F) {
-                                 case ARGUS_FLOW_LAYER_3_MATRIX: {
-                                    if (f1qual == f2qual) {
-                                       switch (f1qual) {
-                                          case ARGUS_TYPE_IPV4: {
-                                             masklen = (f1->ip_flow.smask > f2->ip_flow.smask) ? f2->ip_flow.smask : f1->ip_flow.smask;
-                                             f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ip_flow.ip_src, &f2->ip_flow.ip_src, ARGUS_TYPE_IPV4, ARGUS_SRC, &masklen);
-                                             f1->ip_flow.smask = masklen;
-                                             masklen = (f1->ip_flow.dmask > f2->ip_flow.dmask) ? f2->ip_flow.dmask : f1->ip_flow.dmask;
-                                             f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ip_flow.ip_dst, &f2->ip_flow.ip_dst, ARGUS_TYPE_IPV4, ARGUS_DST, &masklen);
-                                             f1->ip_flow.dmask = masklen;
-                                             f1->hdr.argus_dsrvl8.qual |= ARGUS_MASKLEN;
-                                             break;
-
-                                          case ARGUS_TYPE_IPV6:  
-                                             masklen = (f1->ipv6_flow.smask > f2->ipv6_flow.smask) ? f2->ipv6_flow.smask : f1->ipv6_flow.smask;
-                                             f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ipv6_flow.ip_src[0], &f2->ipv6_flow.ip_src[0], ARGUS_TYPE_IPV6, ARGUS_SRC, &masklen);
-                                             f1->ip_flow.smask = masklen;
-                                             masklen = (f1->ipv6_flow.dmask > f2->ipv6_flow.dmask) ? f2->ipv6_flow.dmask : f1->ipv6_flow.dmask;
-                                             f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ipv6_flow.ip_dst[0], &f2->ipv6_flow.ip_dst[0], ARGUS_TYPE_IPV6, ARGUS_DST, &masklen);
-                                             f1->ip_flow.dmask = masklen;
-                                             f1->hdr.argus_dsrvl8.qual |= ARGUS_MASKLEN;
-                                             break;
 
-                                          }
-                                       }
-                                    }
+                                 default: {
+                                    if (f1->ip_flow.sport != f2->ip_flow.sport)
+                                       f1->ip_flow.sport = 0;
+                                    if (f1->ip_flow.dport != f2->ip_flow.dport)
+                                       f1->ip_flow.dport = 0;
                                     break;
                                  }
+                              }
+                           }
 
-                                 case ARGUS_FLOW_CLASSIC5TUPLE: {
-                                       switch (f1qual) {
-                                          case ARGUS_TYPE_IPV4:
-                                             if (f1qual == f2qual) {
-                                                masklen = (f1->ip_flow.smask > f2->ip_flow.smask) ? f2->ip_flow.smask : f1->ip_flow.smask;
-                                                ArgusMergeAddress(&f1->ip_flow.ip_src, &f2->ip_flow.ip_src, ARGUS_TYPE_IPV4, ARGUS_SRC, &masklen);
-                                                f1->ip_flow.smask = masklen;
-
-                                                masklen = (f1->ip_flow.dmask > f2->ip_flow.dmask) ? f2->ip_flow.dmask : f1->ip_flow.dmask;
-                                                ArgusMergeAddress(&f1->ip_flow.ip_dst, &f2->ip_flow.ip_dst, ARGUS_TYPE_IPV4, ARGUS_DST, &masklen);
-                                                f1->ip_flow.dmask = masklen;
-
-                                                f1->hdr.argus_dsrvl8.qual |= ARGUS_MASKLEN;
-
-                                                if (f1->ip_flow.ip_p  != f2->ip_flow.ip_p)
-                                                   f1->ip_flow.ip_p = 0;
-                                                else {
-                                                   switch (f1->ip_flow.ip_p) {
-                                                      case IPPROTO_ESP: {
-                                                         if (f1->esp_flow.spi != f2->esp_flow.spi)
-                                                            f1->esp_flow.spi = 0;
-                                                         break;
-                                                      }
-
-                                                      default: {
-                                                         if (f1->ip_flow.sport != f2->ip_flow.sport)
-                                                            f1->ip_flow.sport = 0;
-                                                         if (f1->ip_flow.dport != f2->ip_flow.dport)
-                                                            f1->ip_flow.dport = 0;
-                                                         break;
-                                                      }
-                                                   }
-                                                }
+                        } else {
+                           f1->ip_flow.ip_src = 0;
+                           f1->ip_flow.ip_dst = 0;
+
+                           switch (f2qual) {
+                              case ARGUS_TYPE_IPV6:
+                                 if (f1->ip_flow.ip_p  != f2->ipv6_flow.ip_p)
+                                    f1->ip_flow.ip_p = 0;
+                                 if (f1->ip_flow.sport != f2->ipv6_flow.sport)
+                                    f1->ip_flow.sport = 0;
+                                 if (f1->ip_flow.dport != f2->ipv6_flow.dport)
+                                    f1->ip_flow.dport = 0;
+                                 break;
 
-                                             } else {
-                                                f1->ip_flow.ip_src = 0;
-                                                f1->ip_flow.ip_dst = 0;
-                                             
-                                                switch (f2qual) {
-                                                   case ARGUS_TYPE_IPV6:
-                                                      if (f1->ip_flow.ip_p  != f2->ipv6_flow.ip_p)
-                                                         f1->ip_flow.ip_p = 0;
-                                                      if (f1->ip_flow.sport != f2->ipv6_flow.sport)
-                                                         f1->ip_flow.sport = 0;
-                                                      if (f1->ip_flow.dport != f2->ipv6_flow.dport)
-                                                         f1->ip_flow.dport = 0;
-                                                      break;
-                       
-                                                   default:
-                                                      f1->ip_flow.ip_p = 0;
-                                                      f1->ip_flow.sport = 0;
-                                                      f1->ip_flow.dport = 0;
-                                                      break;
-                                                }
-                                             }
-                                             break;
+                              default:
+                                 f1->ip_flow.ip_p = 0;
+                                 f1->ip_flow.sport = 0;
+                                 f1->ip_flow.dport = 0;
+                                 break;
+                           }
+                        }
+                        break;
 
-                                          case ARGUS_TYPE_IPV6:  
-                                             if (f1qual == f2qual) {
-                                                masklen = (f1->ipv6_flow.smask > f2->ipv6_flow.smask) ? f2->ipv6_flow.smask : f1->ipv6_flow.smask;
-                                                f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ipv6_flow.ip_src[0], &f2->ipv6_flow.ip_src[0], ARGUS_TYPE_IPV6, ARGUS_SRC, &masklen);
-                                                f1->ipv6_flow.smask = masklen;
-                                                masklen = (f1->ipv6_flow.dmask > f2->ipv6_flow.dmask) ? f2->ipv6_flow.dmask : f1->ipv6_flow.dmask;
-                                                f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ipv6_flow.ip_dst[0], &f2->ipv6_flow.ip_dst[0], ARGUS_TYPE_IPV6, ARGUS_DST, &masklen);
-                                                f1->ipv6_flow.dmask = masklen;
+                     case ARGUS_TYPE_IPV6:  
+                        if (f1qual == f2qual) {
+                           masklen = (f1->ipv6_flow.smask > f2->ipv6_flow.smask) ? f2->ipv6_flow.smask : f1->ipv6_flow.smask;
+                           f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ipv6_flow.ip_src[0], &f2->ipv6_flow.ip_src[0], ARGUS_TYPE_IPV6, ARGUS_SRC, &masklen);
+                           f1->ipv6_flow.smask = masklen;
+                           masklen = (f1->ipv6_flow.dmask > f2->ipv6_flow.dmask) ? f2->ipv6_flow.dmask : f1->ipv6_flow.dmask;
+                           f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->ipv6_flow.ip_dst[0], &f2->ipv6_flow.ip_dst[0], ARGUS_TYPE_IPV6, ARGUS_DST, &masklen);
+                           f1->ipv6_flow.dmask = masklen;
 
-                                                f1->hdr.argus_dsrvl8.qual |= ARGUS_MASKLEN;
+                           f1->hdr.argus_dsrvl8.qual |= ARGUS_MASKLEN;
 
-                                                if (f1->ipv6_flow.ip_p  != f2->ipv6_flow.ip_p)  f1->ipv6_flow.ip_p = 0;
-                                                if (f1->ipv6_flow.sport != f2->ipv6_flow.sport) f1->ipv6_flow.sport = 0;
-                                                if (f1->ipv6_flow.dport != f2->ipv6_flow.dport) f1->ipv6_flow.dport = 0;
+                           if (f1->ipv6_flow.ip_p  != f2->ipv6_flow.ip_p)  f1->ipv6_flow.ip_p = 0;
+                           if (f1->ipv6_flow.sport != f2->ipv6_flow.sport) f1->ipv6_flow.sport = 0;
+                           if (f1->ipv6_flow.dport != f2->ipv6_flow.dport) f1->ipv6_flow.dport = 0;
 
-                                             } else {
-                                                bzero ((char *)&f1->ipv6_flow.ip_src[0], sizeof(f1->ipv6_flow.ip_src));
-                                                bzero ((char *)&f1->ipv6_flow.ip_dst[0], sizeof(f1->ipv6_flow.ip_dst));
-                                                if (f1->ipv6_flow.ip_p  != f2->ip_flow.ip_p)  f1->ipv6_flow.ip_p = 0;
-                                                if (f1->ipv6_flow.sport != f2->ip_flow.sport) f1->ipv6_flow.sport = 0;
-                                                if (f1->ipv6_flow.dport != f2->ip_flow.dport) f1->ipv6_flow.dport = 0;
-                                             }
-                                             break;
+                        } else {
+                           bzero ((char *)&f1->ipv6_flow.ip_src[0], sizeof(f1->ipv6_flow.ip_src));
+                           bzero ((char *)&f1->ipv6_flow.ip_dst[0], sizeof(f1->ipv6_flow.ip_dst));
+                           if (f1->ipv6_flow.ip_p  != f2->ip_flow.ip_p)  f1->ipv6_flow.ip_p = 0;
+                           if (f1->ipv6_flow.sport != f2->ip_flow.sport) f1->ipv6_flow.sport = 0;
+                           if (f1->ipv6_flow.dport != f2->ip_flow.dport) f1->ipv6_flow.dport = 0;
+                        }
+                        break;
 
-                                        case ARGUS_TYPE_RARP:
-                                           if (bcmp(&f1->rarp_flow.shaddr, &f2->rarp_flow.shaddr, 6))
-                                              bzero(&f1->rarp_flow.shaddr, 6);
-                                           if (bcmp(&f1->rarp_flow.dhaddr, &f2->rarp_flow.dhaddr, 6))
-                                              bzero(&f1->rarp_flow.dhaddr, 6);
-                                           break;
-                                        case ARGUS_TYPE_ARP:
-                                           f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->arp_flow.arp_spa, &f2->arp_flow.arp_spa, ARGUS_TYPE_ARP, ARGUS_SRC, &masklen);
-                                           f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->arp_flow.arp_tpa, &f2->arp_flow.arp_tpa, ARGUS_TYPE_ARP, ARGUS_DST, &masklen);
-                                           break;
-                                    }
-                                    break;
-                                 }
+                   case ARGUS_TYPE_RARP:
+                      if (bcmp(&f1->rarp_flow.shaddr, &f2->rarp_flow.shaddr, 6))
+                         bzero(&f1->rarp_flow.shaddr, 6);
+                      if (bcmp(&f1->rarp_flow.dhaddr, &f2->rarp_flow.dhaddr, 6))
+                         bzero(&f1->rarp_flow.dhaddr, 6);
+                      break;
+                   case ARGUS_TYPE_ARP:
+                      f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->arp_flow.arp_spa, &f2->arp_flow.arp_spa, ARGUS_TYPE_ARP, ARGUS_SRC, &masklen);
+                      f1->hdr.argus_dsrvl8.qual |= ArgusMergeAddress(&f1->arp_flow.arp_tpa, &f2->arp_flow.arp_tpa, ARGUS_TYPE_ARP, ARGUS_DST, &masklen);
+                      break;
+               }
+               break;
+            }
 
-                                 case ARGUS_FLOW_ARP: {
-                                    switch (f1qual) {
-                                        case ARGUS_TYPE_RARP: {
-                                           if (bcmp(&f1->rarp_flow.shaddr, &f2->rarp_flow.shaddr, 6))
-                                                   bzero(&f1->rarp_flow.shaddr, 6);
-                                           if (bcmp(&f1->rarp_flow.dhaddr, &f2->rarp_flow.dhaddr, 6))
-                                                   bzero(&f1->rarp_flow.dhaddr, 6);
-
-                                           if (f1->arp_flow.pln == 4) {
-                                              ArgusMergeAddress(&f1->arp_flow.arp_tpa, &f2->arp_flow.arp_tpa, ARGUS_TYPE_IPV4, ARGUS_DST, &masklen);
-                                           }
-                                           break;
-                                       }
+            case ARGUS_FLOW_ARP: {
+               switch (f1qual) {
+                   case ARGUS_TYPE_RARP: {
+                      if (bcmp(&f1->rarp_flow.shaddr, &f2->rarp_flow.shaddr, 6))
+                              bzero(&f1->rarp_flow.shaddr, 6);
+                      if (bcmp(&f1->rarp_flow.dhaddr, &f2->rarp_flow.dhaddr, 6))
+                              bzero(&f1->rarp_flow.dhaddr, 6);
+
+                      if (f1->arp_flow.pln == 4) {
+                         ArgusMergeAddress(&f1->arp_flow.arp_tpa, &f2->arp_flow.arp_tpa, ARGUS_TYPE_IPV4, ARGUS_DST, &masklen);
+                      }
+                      break;
+                  }
 
-                                        case ARGUS_TYPE_ARP: {
-                                           if (bcmp(&f1->arp_flow.haddr, &f2->arp_flow.haddr, 6))
-                                              bzero(&f1->arp_flow.haddr, 6);
+                   case ARGUS_TYPE_ARP: {
+                      if (bcmp(&f1->arp_flow.haddr, &f2->arp_flow.haddr, 6))
+                         bzero(&f1->arp_flow.haddr, 6);
 
-                                           if (f1->arp_flow.pln == 4) {
-                                              ArgusMergeAddress(&f1->arp_flow.arp_spa, &f2->arp_flow.arp_spa, ARGUS_TYPE_IPV4, ARGUS_SRC, &masklen);
-                                              ArgusMergeAddress(&f1->arp_flow.arp_tpa, &f2->arp_flow.arp_tpa, ARGUS_TYPE_IPV4, ARGUS_DST, &masklen);
-                                           }
-                                           break;
-                                       }
-                                    }
-                                    break;
-                                 }
-                              }
-                           }
-                        }
-                     }
-                     break;
+                      if (f1->arp_flow.pln == 4) {
+                         ArgusMergeAddress(&f1->arp_flow.arp_spa, &f2->arp_flow.arp_spa, ARGUS_TYPE_IPV4, ARGUS_SRC, &masklen);
+                         ArgusMergeAddress(&f1->arp_flow.arp_tpa, &f2->arp_flow.arp_tpa, ARGUS_TYPE_IPV4, ARGUS_DST, &masklen);
+                      }
+                      break;
+                  }
+               }
+               break;
+            }
+         }
+      }
+   }
+}
 
 // Merging Transport objects involves simply checking that the source
 // id and seqnum are the same, and if not, removing the fields until
@@ -6699,604 +6751,611 @@ ArgusMergeRecords (const struct ArgusAggregatorStruct * const na,
 //    unsigned int seqnum;
 // };
 
-                     case ARGUS_TRANSPORT_INDEX: {
-                        struct ArgusTransportStruct *t1 = (struct ArgusTransportStruct *) ns1->dsrs[ARGUS_TRANSPORT_INDEX];
-                        struct ArgusTransportStruct *t2 = (struct ArgusTransportStruct *) ns2->dsrs[ARGUS_TRANSPORT_INDEX];
-                        int match = 0;
+static void
+ArgusMergeTransportDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                        struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusTransportStruct *t1 = (struct ArgusTransportStruct *) ns1->dsrs[ARGUS_TRANSPORT_INDEX];
+   struct ArgusTransportStruct *t2 = (struct ArgusTransportStruct *) ns2->dsrs[ARGUS_TRANSPORT_INDEX];
+   int match = 0;
 
-                        if (t1 && t2) {
-                           if ((t1->hdr.subtype & ARGUS_SRCID) && (t2->hdr.subtype & ARGUS_SRCID)) {
-                              switch (t1->hdr.argus_dsrvl8.qual & ~ARGUS_TYPE_INTERFACE) {
-                                 case ARGUS_TYPE_INT:
-                                 case ARGUS_TYPE_IPV4:
-                                 case ARGUS_TYPE_STRING:
-                                    if (t1->srcid.a_un.ipv4 == t2->srcid.a_un.ipv4)
-                                       match = 1;
-                                    break;
+   if (t1 && t2) {
+      if ((t1->hdr.subtype & ARGUS_SRCID) && (t2->hdr.subtype & ARGUS_SRCID)) {
+         switch (t1->hdr.argus_dsrvl8.qual & ~ARGUS_TYPE_INTERFACE) {
+            case ARGUS_TYPE_INT:
+            case ARGUS_TYPE_IPV4:
+            case ARGUS_TYPE_STRING:
+               if (t1->srcid.a_un.ipv4 == t2->srcid.a_un.ipv4)
+                  match = 1;
+               break;
 
-                                 case ARGUS_TYPE_IPV6:
-                                 case ARGUS_TYPE_UUID: {
-                                    int x;
-                                    match = 1;
-                                    for (x = 0; x < 16; x++) {
-                                       if (t1->srcid.a_un.uuid[x] != t2->srcid.a_un.uuid[x]) {
-                                          match = 1;
-                                          break;
-                                       }
-                                    }
-                                    break;
-                                 }
+            case ARGUS_TYPE_IPV6:
+            case ARGUS_TYPE_UUID: {
+               int x;
+               match = 1;
+               for (x = 0; x < 16; x++) {
+                  if (t1->srcid.a_un.uuid[x] != t2->srcid.a_un.uuid[x]) {
+                     match = 1;
+                     break;
+                  }
+               }
+               break;
+            }
 
-                                 case ARGUS_TYPE_ETHER:
-                                    break;
-                              }
-                              if (match && (t1->hdr.argus_dsrvl8.qual & ARGUS_TYPE_INTERFACE)) {
-                                 if (bcmp(t1->srcid.inf, t2->srcid.inf, 4))
-                                    bzero(t1->srcid.inf, 4);
-                              }
-                           }
-                        }
-                        if (match == 0) {
-                           if (t1) {
-                              ArgusFree(ns1->dsrs[ARGUS_TRANSPORT_INDEX]);
-                              ns1->dsrs[ARGUS_TRANSPORT_INDEX] = NULL;
-                              ns1->dsrindex &= ~(0x1 << ARGUS_TRANSPORT_INDEX);
-                           }
-                        }
-                        break;
-                     }
+            case ARGUS_TYPE_ETHER:
+               break;
+         }
+         if (match && (t1->hdr.argus_dsrvl8.qual & ARGUS_TYPE_INTERFACE)) {
+            if (bcmp(t1->srcid.inf, t2->srcid.inf, 4))
+               bzero(t1->srcid.inf, 4);
+         }
+      }
+   }
+   if (match == 0) {
+      if (t1) {
+         ArgusFree(ns1->dsrs[ARGUS_TRANSPORT_INDEX]);
+         ns1->dsrs[ARGUS_TRANSPORT_INDEX] = NULL;
+         ns1->dsrindex &= ~(0x1 << ARGUS_TRANSPORT_INDEX);
+      }
+   }
+}
 
 // Merging Time objects may result in a change in the storage
 // type of the time structure, from an ABSOLUTE_TIMESTAMP
 // to an ABSOLUTE_RANGE, to hold the new ending time.
 
-                     case ARGUS_TIME_INDEX: {
-                        struct ArgusTimeObject *t1 = (struct ArgusTimeObject *) ns1->dsrs[ARGUS_TIME_INDEX];
-                        struct ArgusTimeObject *t2 = (struct ArgusTimeObject *) ns2->dsrs[ARGUS_TIME_INDEX];
-
-                        if (t1 && t2) {
-                           unsigned int st1, st2;
+static void
+ArgusMergeTimeDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                   struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusTimeObject *t1 = (struct ArgusTimeObject *) ns1->dsrs[ARGUS_TIME_INDEX];
+   struct ArgusTimeObject *t2 = (struct ArgusTimeObject *) ns2->dsrs[ARGUS_TIME_INDEX];
 
-                           if (t1->hdr.argus_dsrvl8.len == 0) {
-                              bcopy ((char *) t2, (char *) t1, sizeof (*t1));
-                              break;
-                           }
+   if (t1 && t2) {
+      unsigned int st1, st2;
 
-                           st1 = t1->hdr.subtype & (ARGUS_TIME_SRC_START | ARGUS_TIME_DST_START |
-                                                    ARGUS_TIME_SRC_END   | ARGUS_TIME_DST_END);
+      if (t1->hdr.argus_dsrvl8.len == 0) {
+         bcopy ((char *) t2, (char *) t1, sizeof (*t1));
+         return;
+      }
 
-                           st2 = t2->hdr.subtype & (ARGUS_TIME_SRC_START | ARGUS_TIME_DST_START |
-                                                    ARGUS_TIME_SRC_END   | ARGUS_TIME_DST_END);
+      st1 = t1->hdr.subtype & (ARGUS_TIME_SRC_START | ARGUS_TIME_DST_START |
+                               ARGUS_TIME_SRC_END   | ARGUS_TIME_DST_END);
 
-                           if (st2) {
-                              if (st2 & ARGUS_TIME_SRC_START) {
-                                 if (st1 & ARGUS_TIME_SRC_START) {
-                                    if ((t1->src.start.tv_sec  >  t2->src.start.tv_sec) ||
-                                       ((t1->src.start.tv_sec  == t2->src.start.tv_sec) &&
-                                        (t1->src.start.tv_usec >  t2->src.start.tv_usec))) {
-                                       t1->src.start = t2->src.start;
-                                       t1->hdr.subtype |= ARGUS_TIME_SRC_START;
-                                    } else {
-                                       if ((t1->src.end.tv_sec  <  t2->src.start.tv_sec) ||
-                                          ((t1->src.end.tv_sec  == t2->src.start.tv_sec) &&
-                                           (t1->src.end.tv_usec >  t2->src.start.tv_usec))) {
-                                          t1->src.end = t2->src.start;
-                                          t1->hdr.subtype |= ARGUS_TIME_SRC_END;
-                                       }
-                                    }
-                                 } else {
-                                    t1->src = t2->src;
-                                    t1->hdr.subtype |= st2 & (ARGUS_TIME_SRC_START |
-                                                              ARGUS_TIME_SRC_END);
-                                 }
-                              }
-                              if (st2 & (ARGUS_TIME_SRC_START | ARGUS_TIME_SRC_END)) {
-                                 if (st1 & (ARGUS_TIME_SRC_START | ARGUS_TIME_SRC_END)) {
-                                    if (t2->src.end.tv_sec) {
-                                       if ((t1->src.end.tv_sec  <  t2->src.end.tv_sec) ||
-                                          ((t1->src.end.tv_sec  == t2->src.end.tv_sec) &&
-                                           (t1->src.end.tv_usec <  t2->src.end.tv_usec))) {
-                                          t1->src.end = t2->src.end;
-                                          t1->hdr.subtype |= ARGUS_TIME_SRC_END;
-                                       }
-                                    } else {
-                                       if ((t1->src.end.tv_sec  <  t2->src.start.tv_sec) ||
-                                          ((t1->src.end.tv_sec  == t2->src.start.tv_sec) &&
-                                           (t1->src.end.tv_usec <  t2->src.start.tv_usec))) {
-                                          t1->src.end = t2->src.end;
-                                          t1->hdr.subtype |= ARGUS_TIME_SRC_END;
-                                       }
-                                    }
+      st2 = t2->hdr.subtype & (ARGUS_TIME_SRC_START | ARGUS_TIME_DST_START |
+                               ARGUS_TIME_SRC_END   | ARGUS_TIME_DST_END);
 
-                                 } else {
-                                    t1->src.end = t2->src.end;
-                                    t1->hdr.subtype |= st2 & (ARGUS_TIME_SRC_START |
-                                                              ARGUS_TIME_SRC_END);
-                                 }
-                              }
-                              if (st2 & ARGUS_TIME_DST_START) {
-                                 if (st1 & ARGUS_TIME_DST_START) {
-                                    if ((t1->dst.start.tv_sec  >  t2->dst.start.tv_sec) ||
-                                       ((t1->dst.start.tv_sec  == t2->dst.start.tv_sec) &&
-                                        (t1->dst.start.tv_usec >  t2->dst.start.tv_usec))) {
-                                       t1->dst.start = t2->dst.start;
-                                       t1->hdr.subtype |= ARGUS_TIME_DST_START;
-                                    }
-                                 } else {
-                                    t1->dst = t2->dst;
-                                    t1->hdr.subtype |= st2 & (ARGUS_TIME_DST_START |
-                                                              ARGUS_TIME_DST_END);
-                                 }
-                              }
-                              if (st2 & (ARGUS_TIME_DST_START | ARGUS_TIME_DST_END)) {
-                                 if (st1 & (ARGUS_TIME_DST_START | ARGUS_TIME_DST_END)) {
-                                    if ((t1->dst.end.tv_sec  <  t2->dst.end.tv_sec) ||
-                                       ((t1->dst.end.tv_sec  == t2->dst.end.tv_sec) &&
-                                        (t1->dst.end.tv_usec <  t2->dst.end.tv_usec))) {
-                                       t1->dst.end = t2->dst.end;
-                                       t1->hdr.subtype |= ARGUS_TIME_DST_END;
-                                    }
-                                 } else {
-                                    t1->dst = t2->dst;
-                                    t1->hdr.subtype |= st2 & (ARGUS_TIME_DST_START |
-                                                              ARGUS_TIME_DST_END);
-                                 }
-                              }
+      if (st2) {
+         if (st2 & ARGUS_TIME_SRC_START) {
+            if (st1 & ARGUS_TIME_SRC_START) {
+               if ((t1->src.start.tv_sec  >  t2->src.start.tv_sec) ||
+                  ((t1->src.start.tv_sec  == t2->src.start.tv_sec) &&
+                   (t1->src.start.tv_usec >  t2->src.start.tv_usec))) {
+                  t1->src.start = t2->src.start;
+                  t1->hdr.subtype |= ARGUS_TIME_SRC_START;
+               } else {
+                  if ((t1->src.end.tv_sec  <  t2->src.start.tv_sec) ||
+                     ((t1->src.end.tv_sec  == t2->src.start.tv_sec) &&
+                      (t1->src.end.tv_usec >  t2->src.start.tv_usec))) {
+                     t1->src.end = t2->src.start;
+                     t1->hdr.subtype |= ARGUS_TIME_SRC_END;
+                  }
+               }
+            } else {
+               t1->src = t2->src;
+               t1->hdr.subtype |= st2 & (ARGUS_TIME_SRC_START |
+                                         ARGUS_TIME_SRC_END);
+            }
+         }
+         if (st2 & (ARGUS_TIME_SRC_START | ARGUS_TIME_SRC_END)) {
+            if (st1 & (ARGUS_TIME_SRC_START | ARGUS_TIME_SRC_END)) {
+               if (t2->src.end.tv_sec) {
+                  if ((t1->src.end.tv_sec  <  t2->src.end.tv_sec) ||
+                     ((t1->src.end.tv_sec  == t2->src.end.tv_sec) &&
+                      (t1->src.end.tv_usec <  t2->src.end.tv_usec))) {
+                     t1->src.end = t2->src.end;
+                     t1->hdr.subtype |= ARGUS_TIME_SRC_END;
+                  }
+               } else {
+                  if ((t1->src.end.tv_sec  <  t2->src.start.tv_sec) ||
+                     ((t1->src.end.tv_sec  == t2->src.start.tv_sec) &&
+                      (t1->src.end.tv_usec <  t2->src.start.tv_usec))) {
+                     t1->src.end = t2->src.end;
+                     t1->hdr.subtype |= ARGUS_TIME_SRC_END;
+                  }
+               }
 
-                           } else {
+            } else {
+               t1->src.end = t2->src.end;
+               t1->hdr.subtype |= st2 & (ARGUS_TIME_SRC_START |
+                                         ARGUS_TIME_SRC_END);
+            }
+         }
+         if (st2 & ARGUS_TIME_DST_START) {
+            if (st1 & ARGUS_TIME_DST_START) {
+               if ((t1->dst.start.tv_sec  >  t2->dst.start.tv_sec) ||
+                  ((t1->dst.start.tv_sec  == t2->dst.start.tv_sec) &&
+                   (t1->dst.start.tv_usec >  t2->dst.start.tv_usec))) {
+                  t1->dst.start = t2->dst.start;
+                  t1->hdr.subtype |= ARGUS_TIME_DST_START;
+               }
+            } else {
+               t1->dst = t2->dst;
+               t1->hdr.subtype |= st2 & (ARGUS_TIME_DST_START |
+                                         ARGUS_TIME_DST_END);
+            }
+         }
+         if (st2 & (ARGUS_TIME_DST_START | ARGUS_TIME_DST_END)) {
+            if (st1 & (ARGUS_TIME_DST_START | ARGUS_TIME_DST_END)) {
+               if ((t1->dst.end.tv_sec  <  t2->dst.end.tv_sec) ||
+                  ((t1->dst.end.tv_sec  == t2->dst.end.tv_sec) &&
+                   (t1->dst.end.tv_usec <  t2->dst.end.tv_usec))) {
+                  t1->dst.end = t2->dst.end;
+                  t1->hdr.subtype |= ARGUS_TIME_DST_END;
+               }
+            } else {
+               t1->dst = t2->dst;
+               t1->hdr.subtype |= st2 & (ARGUS_TIME_DST_START |
+                                         ARGUS_TIME_DST_END);
+            }
+         }
 
-                              if (t1->src.start.tv_sec == 0) {
-                                 bcopy ((char *)t2, (char *)t1, sizeof (*t1));
-                              } else {
-                                 struct ArgusTimeObject t2cpy = *t2;
+      } else {
 
-                                 if ((t1->src.start.tv_sec  >  t2->src.start.tv_sec) ||
-                                    ((t1->src.start.tv_sec  == t2->src.start.tv_sec) &&
-                                     (t1->src.start.tv_usec >  t2->src.start.tv_usec)))
-                                    t1->src.start = t2->src.start;
+         if (t1->src.start.tv_sec == 0) {
+            bcopy ((char *)t2, (char *)t1, sizeof (*t1));
+         } else {
+            struct ArgusTimeObject t2cpy = *t2;
 
-                                 if ((t1->src.end.tv_sec == 0) || (t1->hdr.subtype == ARGUS_TIME_ABSOLUTE_TIMESTAMP)) {
-                                    t1->src.end = t1->src.start;
-                                    t1->hdr.subtype         = ARGUS_TIME_ABSOLUTE_RANGE;
-                                    t1->hdr.argus_dsrvl8.len = sizeof(*t1);
-                                 }
-                                 if ((t2->src.end.tv_sec == 0) || (t2->hdr.subtype == ARGUS_TIME_ABSOLUTE_TIMESTAMP)) {
-                                    t2cpy.src.end = t2->src.start;
-                                    t2cpy.hdr.subtype         = ARGUS_TIME_ABSOLUTE_RANGE;
-                                    t2cpy.hdr.argus_dsrvl8.len = sizeof(*t1);
-                                 }
-                                 if ((t1->src.end.tv_sec  <  t2cpy.src.end.tv_sec) ||
-                                    ((t1->src.end.tv_sec  == t2cpy.src.end.tv_sec) &&
-                                     (t1->src.end.tv_usec <  t2cpy.src.end.tv_usec)))
-                                    t1->src.end = t2cpy.src.end;
-                              }
-                           }
-                        }
-                        break;
-                     }
+            if ((t1->src.start.tv_sec  >  t2->src.start.tv_sec) ||
+               ((t1->src.start.tv_sec  == t2->src.start.tv_sec) &&
+                (t1->src.start.tv_usec >  t2->src.start.tv_usec)))
+               t1->src.start = t2->src.start;
 
-                     case ARGUS_TIME_ADJ_INDEX: {
-                        break;
-                     }
+            if ((t1->src.end.tv_sec == 0) || (t1->hdr.subtype == ARGUS_TIME_ABSOLUTE_TIMESTAMP)) {
+               t1->src.end = t1->src.start;
+               t1->hdr.subtype         = ARGUS_TIME_ABSOLUTE_RANGE;
+               t1->hdr.argus_dsrvl8.len = sizeof(*t1);
+            }
+            if ((t2->src.end.tv_sec == 0) || (t2->hdr.subtype == ARGUS_TIME_ABSOLUTE_TIMESTAMP)) {
+               t2cpy.src.end = t2->src.start;
+               t2cpy.hdr.subtype         = ARGUS_TIME_ABSOLUTE_RANGE;
+               t2cpy.hdr.argus_dsrvl8.len = sizeof(*t1);
+            }
+            if ((t1->src.end.tv_sec  <  t2cpy.src.end.tv_sec) ||
+               ((t1->src.end.tv_sec  == t2cpy.src.end.tv_sec) &&
+                (t1->src.end.tv_usec <  t2cpy.src.end.tv_usec)))
+               t1->src.end = t2cpy.src.end;
+         }
+      }
+   }
+}
 
 // Merging networks objects involve copying and masking
 // various protocol specific network structs together.
 // First test for the protocols, and if they are the same,
 // then merge, if not, just remove the dsrs[] pointers;
 
-                     case ARGUS_NETWORK_INDEX: {
-                        struct ArgusNetworkStruct *n1 = (void *)ns1->dsrs[ARGUS_NETWORK_INDEX];
-                        struct ArgusNetworkStruct *n2 = (void *)ns2->dsrs[ARGUS_NETWORK_INDEX];
-
-                        if ((n1 != NULL) && (n2 != NULL)) {
-                           if (n1->hdr.subtype != n2->hdr.subtype) {
-                              if (!(((n1->hdr.subtype == ARGUS_TCP_INIT) || (n1->hdr.subtype == ARGUS_TCP_STATUS) || (n1->hdr.subtype == ARGUS_TCP_PERF)) &&
-                                    ((n2->hdr.subtype == ARGUS_TCP_INIT) || (n2->hdr.subtype == ARGUS_TCP_STATUS) || (n2->hdr.subtype == ARGUS_TCP_PERF)))) {
-                                 ArgusFree(ns1->dsrs[i]);
-                                 ns1->dsrs[i] = NULL;
-                                 ns1->dsrindex &= ~(0x01 << i);
-                                 n1 = NULL;
-                                 break;
-                              }
-                           }
+static void
+ArgusMergeNetworkDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                      struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusNetworkStruct *n1 = (void *)ns1->dsrs[ARGUS_NETWORK_INDEX];
+   struct ArgusNetworkStruct *n2 = (void *)ns2->dsrs[ARGUS_NETWORK_INDEX];
+
+   if ((n1 != NULL) && (n2 != NULL)) {
+      if (n1->hdr.subtype != n2->hdr.subtype) {
+         if (!(((n1->hdr.subtype == ARGUS_TCP_INIT) || (n1->hdr.subtype == ARGUS_TCP_STATUS) || (n1->hdr.subtype == ARGUS_TCP_PERF)) &&
+               ((n2->hdr.subtype == ARGUS_TCP_INIT) || (n2->hdr.subtype == ARGUS_TCP_STATUS) || (n2->hdr.subtype == ARGUS_TCP_PERF)))) {
+            ArgusFree(ns1->dsrs[i]);
+            ns1->dsrs[i] = NULL;
+            ns1->dsrindex &= ~(0x01 << i);
+            n1 = NULL;
+            return;
+         }
+      }
 
-                           if ((n1 != NULL) && (n2 != NULL)) {
-                              switch (n1->hdr.subtype) {
-                                 case ARGUS_TCP_INIT: {
-                                    struct ArgusTCPObject *t1 = (struct ArgusTCPObject *)&n1->net_union.tcp;
-                                    struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
+      if ((n1 != NULL) && (n2 != NULL)) {
+         switch (n1->hdr.subtype) {
+            case ARGUS_TCP_INIT: {
+               struct ArgusTCPObject *t1 = (struct ArgusTCPObject *)&n1->net_union.tcp;
+               struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
 
-                                    switch (n2->hdr.subtype) {
-                                       case ARGUS_TCP_INIT: {
-                                          t1->status    |= t2->status;
-                                          t1->options   |= t2->options;
-                                          t1->src.flags |= t2->src.flags;
+               switch (n2->hdr.subtype) {
+                  case ARGUS_TCP_INIT: {
+                     t1->status    |= t2->status;
+                     t1->options   |= t2->options;
+                     t1->src.flags |= t2->src.flags;
 
-                                          break;
-                                       }
-                                       case ARGUS_TCP_STATUS: {
-                                          n1->hdr.subtype          = ARGUS_TCP_PERF;
-                                          n1->hdr.argus_dsrvl8.len = 1 + sizeof(*t1)/4; 
-                                          t1->status             = t2->status;
-                                          t1->options            = t2->options;
-                                          t1->src.status         = t2->src.status;
-                                          t1->src.seqbase        = t2->src.seqbase;
-                                          t1->src.win            = t2->src.win;
-                                          t1->src.flags          = t2->src.flags;
-                                          t1->src.winshift       = t2->src.winshift;
-                                          t1->dst.flags          = t2->dst.flags;
-                                          break;
-                                       }
-                                       case ARGUS_TCP_PERF: {
-                                          struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
-                                          struct ArgusTCPObject *tobj = (struct ArgusTCPObject *)&n1->net_union.tcp;
-
-                                          bcopy(t2, tobj, sizeof(*t2));
-                                          t1->status       |= t2->status;
-                                          t1->options      |= t2->options;
-                                          t1->src.status   |= t2->src.status;
-                                          t1->src.seqbase   = t2->src.seqbase;
-                                          t1->src.win       = t2->src.win;
-                                          t1->src.flags    |= t2->src.flags;
-                                          t1->src.winshift  = t2->src.winshift;
-                                          break;
-                                       }
-                                    }
-                                    break;
-                                 }
+                     break;
+                  }
+                  case ARGUS_TCP_STATUS: {
+                     n1->hdr.subtype          = ARGUS_TCP_PERF;
+                     n1->hdr.argus_dsrvl8.len = 1 + sizeof(*t1)/4; 
+                     t1->status             = t2->status;
+                     t1->options            = t2->options;
+                     t1->src.status         = t2->src.status;
+                     t1->src.seqbase        = t2->src.seqbase;
+                     t1->src.win            = t2->src.win;
+                     t1->src.flags          = t2->src.flags;
+                     t1->src.winshift       = t2->src.winshift;
+                     t1->dst.flags          = t2->dst.flags;
+                     break;
+                  }
+                  case ARGUS_TCP_PERF: {
+                     struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
+                     struct ArgusTCPObject *tobj = (struct ArgusTCPObject *)&n1->net_union.tcp;
+
+                     bcopy(t2, tobj, sizeof(*t2));
+                     t1->status       |= t2->status;
+                     t1->options      |= t2->options;
+                     t1->src.status   |= t2->src.status;
+                     t1->src.seqbase   = t2->src.seqbase;
+                     t1->src.win       = t2->src.win;
+                     t1->src.flags    |= t2->src.flags;
+                     t1->src.winshift  = t2->src.winshift;
+                     break;
+                  }
+               }
+               break;
+            }
 
-                                 case ARGUS_TCP_STATUS: {
-                                    struct ArgusTCPStatus *t1 = (struct ArgusTCPStatus *)&n1->net_union.tcp;
-                                    struct ArgusTCPStatus tcpstatusbuf, *tcps = &tcpstatusbuf;
-                                    bcopy(t1, tcps, sizeof(*t1));
-                                    switch (n2->hdr.subtype) {
-                                       case ARGUS_TCP_INIT: {
-                                          struct ArgusTCPInitStatus *t2 = (struct ArgusTCPInitStatus *)&n2->net_union.tcp;
-                                          struct ArgusTCPObject *tobj = (struct ArgusTCPObject *)&n1->net_union.tcp;
-
-                                          bzero(tobj, sizeof(*tobj));
-                                          n1->hdr.subtype          = ARGUS_TCP_PERF;
-                                          n1->hdr.argus_dsrvl8.len = 1 + sizeof(*tobj)/4; 
-                                          tobj->status       = tcps->status | t2->status;
-                                          tobj->options      = t2->options;
-                                          tobj->src.status   = t2->status;
-                                          tobj->src.seqbase  = t2->seqbase;
-                                          tobj->src.win      = t2->win;
-                                          tobj->src.flags    = t2->flags | tcps->src;
-                                          tobj->src.winshift = t2->winshift;
-                                          tobj->dst.flags    = tcps->dst;
+            case ARGUS_TCP_STATUS: {
+               struct ArgusTCPStatus *t1 = (struct ArgusTCPStatus *)&n1->net_union.tcp;
+               struct ArgusTCPStatus tcpstatusbuf, *tcps = &tcpstatusbuf;
+               bcopy(t1, tcps, sizeof(*t1));
+               switch (n2->hdr.subtype) {
+                  case ARGUS_TCP_INIT: {
+                     struct ArgusTCPInitStatus *t2 = (struct ArgusTCPInitStatus *)&n2->net_union.tcp;
+                     struct ArgusTCPObject *tobj = (struct ArgusTCPObject *)&n1->net_union.tcp;
+
+                     bzero(tobj, sizeof(*tobj));
+                     n1->hdr.subtype          = ARGUS_TCP_PERF;
+                     n1->hdr.argus_dsrvl8.len = 1 + sizeof(*tobj)/4; 
+                     tobj->status       = tcps->status | t2->status;
+                     tobj->options      = t2->options;
+                     tobj->src.status   = t2->status;
+                     tobj->src.seqbase  = t2->seqbase;
+                     tobj->src.win      = t2->win;
+                     tobj->src.flags    = t2->flags | tcps->src;
+                     tobj->src.winshift = t2->winshift;
+                     tobj->dst.flags    = tcps->dst;
 
-                                          break;
-                                       }
-                                       case ARGUS_TCP_STATUS: {
-                                          struct ArgusTCPStatus *t2 = (struct ArgusTCPStatus *)&n2->net_union.tcp;
-                                          t1->status |= t2->status;
-                                          break;
-                                       }
-                                       case ARGUS_TCP_PERF: {
-                                          struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
-                                          struct ArgusTCPObject *tobj = (struct ArgusTCPObject *)&n1->net_union.tcp;
-
-                                          bcopy(t2, tobj, sizeof(*t2));
-                                          tobj->status       |= tcps->status;
-                                          tobj->src.status   |= tcps->status;
-                                          tobj->src.flags    |= tcps->src;
-                                          tobj->dst.flags    |= tcps->dst;
-                                          break;
-                                       }
-                                    }
-                                    break;
-                                 }
+                     break;
+                  }
+                  case ARGUS_TCP_STATUS: {
+                     struct ArgusTCPStatus *t2 = (struct ArgusTCPStatus *)&n2->net_union.tcp;
+                     t1->status |= t2->status;
+                     break;
+                  }
+                  case ARGUS_TCP_PERF: {
+                     struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
+                     struct ArgusTCPObject *tobj = (struct ArgusTCPObject *)&n1->net_union.tcp;
+
+                     bcopy(t2, tobj, sizeof(*t2));
+                     tobj->status       |= tcps->status;
+                     tobj->src.status   |= tcps->status;
+                     tobj->src.flags    |= tcps->src;
+                     tobj->dst.flags    |= tcps->dst;
+                     break;
+                  }
+               }
+               break;
+            }
 
-                                 case ARGUS_TCP_PERF: {
-                                    struct ArgusTCPObject *t1 = (struct ArgusTCPObject *)&n1->net_union.tcp;
-                                    switch (n2->hdr.subtype) {
-                                       case ARGUS_TCP_INIT: 
-                                       case ARGUS_TCP_STATUS: {
-                                          struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
+            case ARGUS_TCP_PERF: {
+               struct ArgusTCPObject *t1 = (struct ArgusTCPObject *)&n1->net_union.tcp;
+               switch (n2->hdr.subtype) {
+                  case ARGUS_TCP_INIT: 
+                  case ARGUS_TCP_STATUS: {
+                     struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
 
-                                          t1->status    |= t2->status;
-                                          t1->options   |= t2->options;
-                                          t1->src.flags |= t2->src.flags;
+                     t1->status    |= t2->status;
+                     t1->options   |= t2->options;
+                     t1->src.flags |= t2->src.flags;
 
-                                          break;
-                                       }
+                     break;
+                  }
 
-                                       case ARGUS_TCP_PERF: {
-                                          struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
+                  case ARGUS_TCP_PERF: {
+                     struct ArgusTCPObject *t2 = (struct ArgusTCPObject *)&n2->net_union.tcp;
 
-                                          if (n1->hdr.argus_dsrvl8.len == 0) {
-                                             bcopy ((char *) n2, (char *) n1, sizeof (*n1));
-                                          } else {
-                                             t1->status  |= t2->status;
-                                             t1->state   |= t2->state;
-                                             t1->options |= t2->options;
+                     if (n1->hdr.argus_dsrvl8.len == 0) {
+                        bcopy ((char *) n2, (char *) n1, sizeof (*n1));
+                     } else {
+                        t1->status  |= t2->status;
+                        t1->state   |= t2->state;
+                        t1->options |= t2->options;
 
-                                             if (t1->synAckuSecs == 0)
-                                                t1->synAckuSecs  = t2->synAckuSecs;
-                                             if (t1->ackDatauSecs == 0)
-                                                t1->ackDatauSecs = t2->ackDatauSecs;
+                        if (t1->synAckuSecs == 0)
+                           t1->synAckuSecs  = t2->synAckuSecs;
+                        if (t1->ackDatauSecs == 0)
+                           t1->ackDatauSecs = t2->ackDatauSecs;
 
-                                             t1->src.status   |= t2->src.status;
-                                             t1->src.ack       = t2->src.ack;
+                        t1->src.status   |= t2->src.status;
+                        t1->src.ack       = t2->src.ack;
 
-                                             if (t1->src.seqbase > t2->src.seqbase) {  // potential roll over
+                        if (t1->src.seqbase > t2->src.seqbase) {  // potential roll over
 
 #define TCP_MAX_WINDOWSIZE	65536
-                                                if ((t1->src.seqbase - t2->src.seqbase) > TCP_MAX_WINDOWSIZE) {  // roll over
-                                                   t1->src.ackbytes += (t2->src.seq + (0xffffffff - t1->src.seqbase));
-                                                } else
-                                                   t1->src.seqbase = t2->src.seqbase;
-                                             } else
-                                                t1->src.seq       = t2->src.seq;
-
-                                             t1->src.winnum   += t2->src.winnum;
-                                             t1->src.bytes    += t2->src.bytes;
-                                             t1->src.retrans  += t2->src.retrans;
-
-                                             t1->src.win       = t2->src.win;
-                                             t1->src.winbytes  = t2->src.winbytes;
-                                             t1->src.flags    |= t2->src.flags;
-
-                                             t1->dst.status   |= t2->dst.status;
-                                             t1->dst.ack       = t2->dst.ack;
-
-                                             if (t1->dst.seqbase > t2->dst.seqbase) {  // potential roll over
-                                                if ((t1->dst.seqbase - t2->dst.seqbase) > TCP_MAX_WINDOWSIZE) {  // roll over
-                                                   t1->dst.ackbytes += (t2->dst.seq + (0xffffffff - t1->dst.seqbase));
-                                                } else
-                                                   t1->dst.seqbase = t2->dst.seqbase;
-                                             } else
-                                                t1->dst.seq       = t2->dst.seq;
-
-                                             t1->dst.winnum   += t2->dst.winnum;
-                                             t1->dst.bytes    += t2->dst.bytes;
-                                             t1->dst.retrans  += t2->dst.retrans;
-
-                                             t1->dst.win       = t2->dst.win;
-                                             t1->dst.winbytes  = t2->dst.winbytes;
-                                             t1->dst.flags    |= t2->dst.flags;
-
-                                             if (n1->hdr.subtype != n2->hdr.subtype) {
-                                                if (n1->hdr.subtype == ARGUS_TCP_INIT) {
-                                                   n1->hdr.subtype = ARGUS_TCP_PERF;
-                                                   n1->hdr.argus_dsrvl8.len = (sizeof(*t1) + 3) / 4;
-                                                }
-                                             }
-                                          }
-                                          break;
-                                       }
-                                       break;
-                                    }
-                                    break;
-                                 }
+                           if ((t1->src.seqbase - t2->src.seqbase) > TCP_MAX_WINDOWSIZE) {  // roll over
+                              t1->src.ackbytes += (t2->src.seq + (0xffffffff - t1->src.seqbase));
+                           } else
+                              t1->src.seqbase = t2->src.seqbase;
+                        } else
+                           t1->src.seq       = t2->src.seq;
 
-                                 case ARGUS_RTP_FLOW: {
-                                    struct ArgusRTPObject *r1 = &n1->net_union.rtp;
-                                    struct ArgusRTPObject *r2 = &n2->net_union.rtp;
-                                    r1->sdrop += r2->sdrop;
-                                    r1->ddrop += r2->ddrop;
-                                    r1->src = r2->src;
-                                    r1->dst = r2->dst;
-                                    break;
-                                 }
+                        t1->src.winnum   += t2->src.winnum;
+                        t1->src.bytes    += t2->src.bytes;
+                        t1->src.retrans  += t2->src.retrans;
 
-                                 case ARGUS_UDT_FLOW: {
-                                    struct ArgusUDTObject *u1 = &n1->net_union.udt;
-                                    struct ArgusUDTObject *u2 = &n2->net_union.udt;
-
-                                    if (u1->hshake.version != u2->hshake.version)
-                                       u1->hshake.version = 0;
-                                    if (u1->hshake.socktype != u2->hshake.socktype)
-                                       u1->hshake.version = 0;
-                                    if (u1->hshake.conntype != u2->hshake.conntype)
-                                       u1->hshake.conntype = 0;
-                                    if (u1->hshake.sockid != u2->hshake.sockid)
-                                       u1->hshake.sockid = 0;
-
-                                    u1->src.solo    += u2->src.solo;
-                                    u1->src.first   += u2->src.first;
-                                    u1->src.middle  += u2->src.middle;
-                                    u1->src.last    += u2->src.last;
-                                    u1->src.drops   += u2->src.drops;
-                                    u1->src.retrans += u2->src.retrans;
-                                    u1->src.nacked  += u2->src.nacked;
-                                    break;
-                                 }
+                        t1->src.win       = t2->src.win;
+                        t1->src.winbytes  = t2->src.winbytes;
+                        t1->src.flags    |= t2->src.flags;
 
-                                 case ARGUS_ESP_DSR: {
-                                    struct ArgusESPObject *e1 = &n1->net_union.esp;
-                                    struct ArgusESPObject *e2 = &n2->net_union.esp;
+                        t1->dst.status   |= t2->dst.status;
+                        t1->dst.ack       = t2->dst.ack;
 
-                                    n1->hdr.argus_dsrvl8.qual |= n2->hdr.argus_dsrvl8.qual;
+                        if (t1->dst.seqbase > t2->dst.seqbase) {  // potential roll over
+                           if ((t1->dst.seqbase - t2->dst.seqbase) > TCP_MAX_WINDOWSIZE) {  // roll over
+                              t1->dst.ackbytes += (t2->dst.seq + (0xffffffff - t1->dst.seqbase));
+                           } else
+                              t1->dst.seqbase = t2->dst.seqbase;
+                        } else
+                           t1->dst.seq       = t2->dst.seq;
 
-                                    e1->lastseq = e2->lastseq;
-                                    e1->lostseq += e2->lostseq;
-                                    if (e1->spi != e2->spi) {
-                                       e1->spi = 0;
-                                    }
-                                 }
-                              }
+                        t1->dst.winnum   += t2->dst.winnum;
+                        t1->dst.bytes    += t2->dst.bytes;
+                        t1->dst.retrans  += t2->dst.retrans;
+
+                        t1->dst.win       = t2->dst.win;
+                        t1->dst.winbytes  = t2->dst.winbytes;
+                        t1->dst.flags    |= t2->dst.flags;
 
+                        if (n1->hdr.subtype != n2->hdr.subtype) {
+                           if (n1->hdr.subtype == ARGUS_TCP_INIT) {
+                              n1->hdr.subtype = ARGUS_TCP_PERF;
+                              n1->hdr.argus_dsrvl8.len = (sizeof(*t1) + 3) / 4;
                            }
                         }
-                        break;
                      }
+                     break;
+                  }
+                  break;
+               }
+               break;
+            }
+
+            case ARGUS_RTP_FLOW: {
+               struct ArgusRTPObject *r1 = &n1->net_union.rtp;
+               struct ArgusRTPObject *r2 = &n2->net_union.rtp;
+               r1->sdrop += r2->sdrop;
+               r1->ddrop += r2->ddrop;
+               r1->src = r2->src;
+               r1->dst = r2->dst;
+               break;
+            }
+
+            case ARGUS_UDT_FLOW: {
+               struct ArgusUDTObject *u1 = &n1->net_union.udt;
+               struct ArgusUDTObject *u2 = &n2->net_union.udt;
+
+               if (u1->hshake.version != u2->hshake.version)
+                  u1->hshake.version = 0;
+               if (u1->hshake.socktype != u2->hshake.socktype)
+                  u1->hshake.version = 0;
+               if (u1->hshake.conntype != u2->hshake.conntype)
+                  u1->hshake.conntype = 0;
+               if (u1->hshake.sockid != u2->hshake.sockid)
+                  u1->hshake.sockid = 0;
+
+               u1->src.solo    += u2->src.solo;
+               u1->src.first   += u2->src.first;
+               u1->src.middle  += u2->src.middle;
+               u1->src.last    += u2->src.last;
+               u1->src.drops   += u2->src.drops;
+               u1->src.retrans += u2->src.retrans;
+               u1->src.nacked  += u2->src.nacked;
+               break;
+            }
+
+            case ARGUS_ESP_DSR: {
+               struct ArgusESPObject *e1 = &n1->net_union.esp;
+               struct ArgusESPObject *e2 = &n2->net_union.esp;
+
+               n1->hdr.argus_dsrvl8.qual |= n2->hdr.argus_dsrvl8.qual;
+
+               e1->lastseq = e2->lastseq;
+               e1->lostseq += e2->lostseq;
+               if (e1->spi != e2->spi) {
+                  e1->spi = 0;
+               }
+            }
+         }
+
+      }
+   }
+}
 
 // Merging IP Attribute objects involves
 // of rollover any time soon, as we're working with 64 bit
 // ints with the canonical DSR.  We should test for rollover
 // but lets do that later - cb
 
-                     case ARGUS_IPATTR_INDEX: {
-                        struct ArgusIPAttrStruct *attr1 = (struct ArgusIPAttrStruct *)ns1->dsrs[ARGUS_IPATTR_INDEX];
-                        struct ArgusIPAttrStruct *attr2 = (struct ArgusIPAttrStruct *)ns2->dsrs[ARGUS_IPATTR_INDEX]; 
+static void
+ArgusMergeIPAttrDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                     struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusIPAttrStruct *attr1 = (struct ArgusIPAttrStruct *)ns1->dsrs[ARGUS_IPATTR_INDEX];
+   struct ArgusIPAttrStruct *attr2 = (struct ArgusIPAttrStruct *)ns2->dsrs[ARGUS_IPATTR_INDEX]; 
 
-                        if (attr1 && attr2) {
-                           if (attr1->hdr.argus_dsrvl8.len == 0) {
-                              bcopy ((char *) attr2, (char *) attr1, sizeof (*attr1));
-                              break;
-                           }
+   if (attr1 && attr2) {
+      if (attr1->hdr.argus_dsrvl8.len == 0) {
+         bcopy ((char *) attr2, (char *) attr1, sizeof (*attr1));
+         return;
+      }
 
-                           if ((attr1->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC) &&
-                               (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC)) {
-                              if (attr1->src.tos != attr2->src.tos)
-                                 attr1->src.tos = 0;
+      if ((attr1->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC) &&
+          (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC)) {
+         if (attr1->src.tos != attr2->src.tos)
+            attr1->src.tos = 0;
 
-                              if (attr1->src.ttl != attr2->src.ttl)
-                                 if ((attr2->src.ttl > 0) && (attr1->src.ttl > attr2->src.ttl)) 
-                                    attr1->src.ttl = attr2->src.ttl;
+         if (attr1->src.ttl != attr2->src.ttl)
+            if ((attr2->src.ttl > 0) && (attr1->src.ttl > attr2->src.ttl)) 
+               attr1->src.ttl = attr2->src.ttl;
 
-                              attr1->src.options ^= attr2->src.options;
-                              if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC_FRAGMENTS)
-                                 attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_SRC_FRAGMENTS;
+         attr1->src.options ^= attr2->src.options;
+         if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC_FRAGMENTS)
+            attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_SRC_FRAGMENTS;
 
-                           } else 
-                           if (!(attr1->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC) &&
-                                (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC)) {
-                              bcopy ((char *)&attr2->src, (char *)&attr1->src, sizeof(attr1->src));
-                              attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_SRC;
-                              if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC_OPTIONS)
-                                 attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_SRC_OPTIONS;
-                              if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC_FRAGMENTS)
-                                 attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_SRC_FRAGMENTS;
-                           }
+      } else 
+      if (!(attr1->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC) &&
+           (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC)) {
+         bcopy ((char *)&attr2->src, (char *)&attr1->src, sizeof(attr1->src));
+         attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_SRC;
+         if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC_OPTIONS)
+            attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_SRC_OPTIONS;
+         if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_SRC_FRAGMENTS)
+            attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_SRC_FRAGMENTS;
+      }
 
-                           if ((attr1->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST) &&
-                               (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST)) {
-                              if (attr1->dst.tos != attr2->dst.tos)
-                                 attr1->dst.tos = 0;
+      if ((attr1->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST) &&
+          (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST)) {
+         if (attr1->dst.tos != attr2->dst.tos)
+            attr1->dst.tos = 0;
 
-                              if (attr1->dst.ttl != attr2->dst.ttl)
-                                 if ((attr2->dst.ttl > 0) && (attr1->dst.ttl > attr2->dst.ttl)) 
-                                    attr1->dst.ttl = attr2->dst.ttl;
+         if (attr1->dst.ttl != attr2->dst.ttl)
+            if ((attr2->dst.ttl > 0) && (attr1->dst.ttl > attr2->dst.ttl)) 
+               attr1->dst.ttl = attr2->dst.ttl;
 
-                              attr1->dst.options ^= attr2->dst.options;
-                              if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST_FRAGMENTS)
-                                 attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_DST_FRAGMENTS;
+         attr1->dst.options ^= attr2->dst.options;
+         if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST_FRAGMENTS)
+            attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_DST_FRAGMENTS;
 
-                           } else
-                           if (!(attr1->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST) &&
-                                (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST)) {
-                              bcopy ((char *)&attr2->dst, (char *)&attr1->dst, sizeof(attr1->dst));
-                              attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_DST;
-                              if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST_OPTIONS)
-                                 attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_DST_OPTIONS;
-                              if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST_FRAGMENTS)
-                                 attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_DST_FRAGMENTS;
-                           }
-                        }
-                        break;
-                     }
+      } else
+      if (!(attr1->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST) &&
+           (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST)) {
+         bcopy ((char *)&attr2->dst, (char *)&attr1->dst, sizeof(attr1->dst));
+         attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_DST;
+         if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST_OPTIONS)
+            attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_DST_OPTIONS;
+         if (attr2->hdr.argus_dsrvl8.qual & ARGUS_IPATTR_DST_FRAGMENTS)
+            attr1->hdr.argus_dsrvl8.qual |= ARGUS_IPATTR_DST_FRAGMENTS;
+      }
+   }
+}
 
 // Merging metrics data  involves accumulating counters.
 
-                     case ARGUS_METRIC_INDEX: {
-                        struct ArgusMetricStruct *m1 = (struct ArgusMetricStruct *) ns1->dsrs[ARGUS_METRIC_INDEX];
-                        struct ArgusMetricStruct *m2 = (struct ArgusMetricStruct *) ns2->dsrs[ARGUS_METRIC_INDEX];
-                        if (m1 && m2) {
-                           if (m1->hdr.argus_dsrvl8.len == 0) {
-                              bcopy ((char *) m2, (char *) m1, sizeof (*m1));
-                              break;
-                           }
-
-                           m1->src.pkts     += m2->src.pkts;
-                           m1->src.bytes    += m2->src.bytes;
-                           m1->src.appbytes += m2->src.appbytes;
-                           m1->dst.pkts     += m2->dst.pkts;
-                           m1->dst.bytes    += m2->dst.bytes;
-                           m1->dst.appbytes += m2->dst.appbytes;
-                        }
-                        break;
-                     }
+static void
+ArgusMergeMetricDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                     struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusMetricStruct *m1 = (struct ArgusMetricStruct *) ns1->dsrs[ARGUS_METRIC_INDEX];
+   struct ArgusMetricStruct *m2 = (struct ArgusMetricStruct *) ns2->dsrs[ARGUS_METRIC_INDEX];
+   if (m1 && m2) {
+      if (m1->hdr.argus_dsrvl8.len == 0) {
+         bcopy ((char *) m2, (char *) m1, sizeof (*m1));
+         return;
+      }
 
+      m1->src.pkts     += m2->src.pkts;
+      m1->src.bytes    += m2->src.bytes;
+      m1->src.appbytes += m2->src.appbytes;
+      m1->dst.pkts     += m2->dst.pkts;
+      m1->dst.bytes    += m2->dst.bytes;
+      m1->dst.appbytes += m2->dst.appbytes;
+   }
+}
 
 // Merging packet size data involves max min comparisons
 // as well as a reformulation of the histogram if being used.
 
-                     case ARGUS_PSIZE_INDEX: {
-                        struct ArgusPacketSizeStruct *p1 = (struct ArgusPacketSizeStruct *) ns1->dsrs[ARGUS_PSIZE_INDEX];
-                        struct ArgusPacketSizeStruct *p2 = (struct ArgusPacketSizeStruct *) ns2->dsrs[ARGUS_PSIZE_INDEX];
+static void
+ArgusMergePsizeDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                    struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusPacketSizeStruct *p1 = (struct ArgusPacketSizeStruct *) ns1->dsrs[ARGUS_PSIZE_INDEX];
+   struct ArgusPacketSizeStruct *p2 = (struct ArgusPacketSizeStruct *) ns2->dsrs[ARGUS_PSIZE_INDEX];
 
-                        if (p1 && p2) {
-                           if (p1->hdr.argus_dsrvl8.len == 0) {
-                              bcopy ((char *) p2, (char *) p1, sizeof (*p1));
-                           } else {
-                              if ((p1->hdr.subtype & ARGUS_PSIZE_SRC_MAX_MIN) && 
-                                  (p2->hdr.subtype & ARGUS_PSIZE_SRC_MAX_MIN))  {
-                                 if (p1->src.psizemax < p2->src.psizemax)
-                                    p1->src.psizemax = p2->src.psizemax;
-                                 if (p1->src.psizemin > p2->src.psizemin)
-                                    p1->src.psizemin = p2->src.psizemin;
-
-                                 if (p1->hdr.subtype & ARGUS_PSIZE_HISTO) {
-                                    int x, max, tot, val[8];
-                                    for (x = 0, max = 0, tot = 0; x < 8; x++) {
-                                       val[x] = (p1->src.psize[x] + p2->src.psize[x]);
-                                       tot += val[x];
-                                       if (max < val[x])
-                                          max = val[x];
-                                    }
-                                    for (x = 0; x < 8; x++) {
-                                       if (val[x]) {
-                                          if (max > 255)
-                                             val[x] = (val[x] * 255)/max;
-                                          if (val[x] == 0)
-                                             val[x] = 1;
-                                       }
-                                       p1->src.psize[x] = val[x];
-                                    }
-                                 }
+   if (p1 && p2) {
+      if (p1->hdr.argus_dsrvl8.len == 0) {
+         bcopy ((char *) p2, (char *) p1, sizeof (*p1));
+      } else {
+         if ((p1->hdr.subtype & ARGUS_PSIZE_SRC_MAX_MIN) && 
+             (p2->hdr.subtype & ARGUS_PSIZE_SRC_MAX_MIN))  {
+            if (p1->src.psizemax < p2->src.psizemax)
+               p1->src.psizemax = p2->src.psizemax;
+            if (p1->src.psizemin > p2->src.psizemin)
+               p1->src.psizemin = p2->src.psizemin;
+
+            if (p1->hdr.subtype & ARGUS_PSIZE_HISTO) {
+               int x, max, tot, val[8];
+               for (x = 0, max = 0, tot = 0; x < 8; x++) {
+                  val[x] = (p1->src.psize[x] + p2->src.psize[x]);
+                  tot += val[x];
+                  if (max < val[x])
+                     max = val[x];
+               }
+               for (x = 0; x < 8; x++) {
+                  if (val[x]) {
+                     if (max > 255)
+                        val[x] = (val[x] * 255)/max;
+                     if (val[x] == 0)
+                        val[x] = 1;
+                  }
+                  p1->src.psize[x] = val[x];
+               }
+            }
 
-                              } else {
-                                 if (p2->hdr.subtype & ARGUS_PSIZE_SRC_MAX_MIN) {
-                                    p1->hdr.subtype |= ARGUS_PSIZE_SRC_MAX_MIN;
-                                    bcopy (&p2->src, &p1->src, sizeof(p1->src));
-                                 }
-                              }
-                              if ((p1->hdr.subtype & ARGUS_PSIZE_DST_MAX_MIN) && 
-                                  (p2->hdr.subtype & ARGUS_PSIZE_DST_MAX_MIN))  {
-                                 if (p1->dst.psizemax < p2->dst.psizemax)
-                                    p1->dst.psizemax = p2->dst.psizemax;
-                                 if (p1->dst.psizemin > p2->dst.psizemin)
-                                    p1->dst.psizemin = p2->dst.psizemin;
-
-                                 if (p1->hdr.subtype & ARGUS_PSIZE_HISTO) {
-                                    int x, max, tot, val[8];
-                                    for (x = 0, max = 0, tot = 0; x < 8; x++) {
-                                       val[x] = (p1->dst.psize[x] + p2->dst.psize[x]);
-                                       tot += val[x];
-                                       if (max < val[x])
-                                          max = val[x];
-                                    }
-                                    for (x = 0; x < 8; x++) {
-                                       if (val[x]) {
-                                          if (max > 255) 
-                                             val[x] = (val[x] * 255)/max;
-                                          if (val[x] == 0)
-                                             val[x] = 1; 
-                                       }  
-                                       p1->dst.psize[x] = val[x];
-                                    }
-                                 }
-                              } else {
-                                 if (p2->hdr.subtype & ARGUS_PSIZE_DST_MAX_MIN) {
-                                    p1->hdr.subtype |= ARGUS_PSIZE_DST_MAX_MIN;
-                                    bcopy (&p2->dst, &p1->dst, sizeof(p1->dst));
-                                 }
-                              }
-                           }
-                        } else {
-                           if (!(p1) && p2) {
-                              if ((p1 = ArgusCalloc(1, sizeof(*p1))) == NULL)
-                                 ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
-                              bcopy ((char *)p2, (char *)p1, sizeof(*p2));
-                              ns1->dsrs[ARGUS_PSIZE_INDEX] = (struct ArgusDSRHeader *) p1;
-                              ns1->dsrindex |= (0x01 << ARGUS_PSIZE_INDEX);
-                           }
-                        }
-                        break;
-                     }
+         } else {
+            if (p2->hdr.subtype & ARGUS_PSIZE_SRC_MAX_MIN) {
+               p1->hdr.subtype |= ARGUS_PSIZE_SRC_MAX_MIN;
+               bcopy (&p2->src, &p1->src, sizeof(p1->src));
+            }
+         }
+         if ((p1->hdr.subtype & ARGUS_PSIZE_DST_MAX_MIN) && 
+             (p2->hdr.subtype & ARGUS_PSIZE_DST_MAX_MIN))  {
+            if (p1->dst.psizemax < p2->dst.psizemax)
+               p1->dst.psizemax = p2->dst.psizemax;
+            if (p1->dst.psizemin > p2->dst.psizemin)
+               p1->dst.psizemin = p2->dst.psizemin;
+
+            if (p1->hdr.subtype & ARGUS_PSIZE_HISTO) {
+               int x, max, tot, val[8];
+               for (x = 0, max = 0, tot = 0; x < 8; x++) {
+                  val[x] = (p1->dst.psize[x] + p2->dst.psize[x]);
+                  tot += val[x];
+                  if (max < val[x])
+                     max = val[x];
+               }
+               for (x = 0; x < 8; x++) {
+                  if (val[x]) {
+                     if (max > 255) 
+                        val[x] = (val[x] * 255)/max;
+                     if (val[x] == 0)
+                        val[x] = 1; 
+                  }  
+                  p1->dst.psize[x] = val[x];
+               }
+            }
+         } else {
+            if (p2->hdr.subtype & ARGUS_PSIZE_DST_MAX_MIN) {
+               p1->hdr.subtype |= ARGUS_PSIZE_DST_MAX_MIN;
+               bcopy (&p2->dst, &p1->dst, sizeof(p1->dst));
+            }
+         }
+      }
+   } else {
+      if (!(p1) && p2) {
+         if ((p1 = ArgusCalloc(1, sizeof(*p1))) == NULL)
+            ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
+         bcopy ((char *)p2, (char *)p1, sizeof(*p2));
+         ns1->dsrs[ARGUS_PSIZE_INDEX] = (struct ArgusDSRHeader *) p1;
+         ns1->dsrindex |= (0x01 << ARGUS_PSIZE_INDEX);
+      }
+   }
+}
 
 // Merging the aggregation object results in ns1 having
 // a valid aggregation object, with updates to the various
@@ -7307,761 +7366,987 @@ ArgusMergeRecords (const struct ArgusAggregatorStruct * const na,
 // for ns2's metrics.  If ns2 does exist, then just merge
 // the two agr's.
 
-                     case ARGUS_AGR_INDEX: {
-                        struct ArgusAgrStruct *a1 = (struct ArgusAgrStruct *) ns1->dsrs[ARGUS_AGR_INDEX];
-                        struct ArgusAgrStruct *a2 = (struct ArgusAgrStruct *) ns2->dsrs[ARGUS_AGR_INDEX];
-                        struct ArgusAgrStruct databuf, *data = &databuf;
-                        double ss1 = 0, ss2 = 0, sum1 = 0, sum2 = 0, value = 0;
-                        int x = 0, n = 0, items = 0;
+static void
+ArgusMergeAgrDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                  struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusAgrStruct *a1 = (struct ArgusAgrStruct *) ns1->dsrs[ARGUS_AGR_INDEX];
+   struct ArgusAgrStruct *a2 = (struct ArgusAgrStruct *) ns2->dsrs[ARGUS_AGR_INDEX];
+   struct ArgusAgrStruct databuf, *data = &databuf;
+   double deltaSrcFlowTime = mc->deltaSrcFlowTime, deltaDstFlowTime = mc->deltaDstFlowTime;
+   double ss1 = 0, ss2 = 0, sum1 = 0, sum2 = 0, value = 0;
+   int x = 0, n = 0, items = 0;
 
-                        if (a1 && a2) {
-                           if ((a1->hdr.subtype == a2->hdr.subtype) ||
-                             (((a1->hdr.subtype == ARGUSMETRICDURATION) || (a1->hdr.subtype == 0x01)) &&
-                              ((a2->hdr.subtype == ARGUSMETRICDURATION) || (a2->hdr.subtype == 0x01)))) {
+   if (a1 && a2) {
+      if ((a1->hdr.subtype == a2->hdr.subtype) ||
+        (((a1->hdr.subtype == ARGUSMETRICDURATION) || (a1->hdr.subtype == 0x01)) &&
+         ((a2->hdr.subtype == ARGUSMETRICDURATION) || (a2->hdr.subtype == 0x01)))) {
 
-                              double tvalstd = 0, tvalmean = 0, meansqrd = 0;
+         double tvalstd = 0, tvalmean = 0, meansqrd = 0;
 
-                              bzero(data, sizeof(*data));
+         bzero(data, sizeof(*data));
 
-                              if (a1->hdr.argus_dsrvl8.len == 0) {
-                                 bcopy ((char *) a2, (char *) a1, sizeof (*a1));
-                                 break;
-                              }
+         if (a1->hdr.argus_dsrvl8.len == 0) {
+            bcopy ((char *) a2, (char *) a1, sizeof (*a1));
+            return;
+         }
 
-                              bcopy ((char *)&a1->hdr, (char *)&data->hdr, sizeof(data->hdr));
+         bcopy ((char *)&a1->hdr, (char *)&data->hdr, sizeof(data->hdr));
 
-                              data->count = a1->count + a2->count;
+         data->count = a1->count + a2->count;
 
-                              if (data->count) {
-                                 data->act.maxval   = (a1->act.maxval > a2->act.maxval) ? a1->act.maxval : a2->act.maxval;
-                                 data->act.minval   = (a1->act.minval < a2->act.minval) ? a1->act.minval : a2->act.minval;
-                                 data->act.n        = a1->act.n + a2->act.n;
+         if (data->count) {
+            data->act.maxval   = (a1->act.maxval > a2->act.maxval) ? a1->act.maxval : a2->act.maxval;
+            data->act.minval   = (a1->act.minval < a2->act.minval) ? a1->act.minval : a2->act.minval;
+            data->act.n        = a1->act.n + a2->act.n;
 
-                                 sum1               = (a1->act.n > 1) ? (a1->act.meanval * a1->act.n) : a1->act.meanval;
-                                 sum2               = (a2->act.n > 1) ? (a2->act.meanval * a2->act.n) : a2->act.meanval;
+            sum1               = (a1->act.n > 1) ? (a1->act.meanval * a1->act.n) : a1->act.meanval;
+            sum2               = (a2->act.n > 1) ? (a2->act.meanval * a2->act.n) : a2->act.meanval;
 
-                                 if (a1->act.n > 1) {
-                                    tvalstd  = pow(a1->act.stdev, 2.0);
-                                    tvalmean = pow(a1->act.meanval, 2.0);
+            if (a1->act.n > 1) {
+               tvalstd  = pow(a1->act.stdev, 2.0);
+               tvalmean = pow(a1->act.meanval, 2.0);
 
-                                    ss1 = a1->act.n * (tvalstd + tvalmean);
-                                 } else {
-                                    ss1 = pow(a1->act.meanval, 2.0);
-                                 }
-                                 if (a2->act.n > 1) {
-                                    tvalstd  = pow(a2->act.stdev, 2.0);
-                                    tvalmean = pow(a2->act.meanval, 2.0);
-                                    ss2 = a2->act.n * (tvalstd + tvalmean);
+               ss1 = a1->act.n * (tvalstd + tvalmean);
+            } else {
+               ss1 = pow(a1->act.meanval, 2.0);
+            }
+            if (a2->act.n > 1) {
+               tvalstd  = pow(a2->act.stdev, 2.0);
+               tvalmean = pow(a2->act.meanval, 2.0);
+               ss2 = a2->act.n * (tvalstd + tvalmean);
 
-                                 } else {
-                                    ss2 = pow(a2->act.meanval, 2.0);
-                                 }
+            } else {
+               ss2 = pow(a2->act.meanval, 2.0);
+            }
 
-                                 if (data->act.n > 0) {
-                                    data->act.meanval  = (sum1 + sum2) / data->act.n;
-                                    meansqrd = pow(data->act.meanval, 2.0);
-                                    data->act.stdev    = sqrt(fabs(((ss1 + ss2)/(data->act.n)) - meansqrd));
-                                 }
+            if (data->act.n > 0) {
+               data->act.meanval  = (sum1 + sum2) / data->act.n;
+               meansqrd = pow(data->act.meanval, 2.0);
+               data->act.stdev    = sqrt(fabs(((ss1 + ss2)/(data->act.n)) - meansqrd));
+            }
 
-                                 value = 0.0;
-                                 ss1 = 0.0;
+            value = 0.0;
+            ss1 = 0.0;
 
-                                 sum1  = (a1->idle.n > 1) ? (a1->idle.meanval * a1->idle.n) : a1->idle.meanval;
-                                 sum2  = (a2->idle.n > 1) ? (a2->idle.meanval * a2->idle.n) : a2->idle.meanval;
+            sum1  = (a1->idle.n > 1) ? (a1->idle.meanval * a1->idle.n) : a1->idle.meanval;
+            sum2  = (a2->idle.n > 1) ? (a2->idle.meanval * a2->idle.n) : a2->idle.meanval;
 
-                                 if (a1->idle.stdev != 0) {
-                                    tvalstd  = pow(a1->idle.stdev, 2.0);
-                                    ss1 = a1->idle.n * (tvalstd + pow(a1->idle.meanval, 2.0));
+            if (a1->idle.stdev != 0) {
+               tvalstd  = pow(a1->idle.stdev, 2.0);
+               ss1 = a1->idle.n * (tvalstd + pow(a1->idle.meanval, 2.0));
 
-                                 } else
-                                    ss1 = pow(a1->idle.meanval, 2.0);
+            } else
+               ss1 = pow(a1->idle.meanval, 2.0);
 
-                                 if (a2->idle.stdev != 0) {
-                                    tvalstd  = pow(a2->idle.stdev, 2.0);
-                                    ss2 = a2->idle.n * (tvalstd + pow(a2->idle.meanval, 2.0));
+            if (a2->idle.stdev != 0) {
+               tvalstd  = pow(a2->idle.stdev, 2.0);
+               ss2 = a2->idle.n * (tvalstd + pow(a2->idle.meanval, 2.0));
 
-                                 } else
-                                    ss2 = pow(a2->idle.meanval, 2.0);
-
-                                 if ((items = (a1->idle.n + a2->idle.n)) > 0) {
-                                    for (n = 0; n < 8; n++) {
-                                       int val = ((a1->idle.fdist[n] * a1->idle.n) + (a2->idle.fdist[n] * a2->idle.n)) / items;
-                                       data->idle.fdist[n] = (val > 0xFF) ? 0xFF : val;
-                                       if (data->idle.fdist[n] == 0) {
-                                          if (a1->idle.fdist[n] || a2->idle.fdist[n])
-                                             data->idle.fdist[n] = 1;
-                                       }
-                                    }
-                                 }
-                              }
+            } else
+               ss2 = pow(a2->idle.meanval, 2.0);
+
+            if ((items = (a1->idle.n + a2->idle.n)) > 0) {
+               for (n = 0; n < 8; n++) {
+                  int val = ((a1->idle.fdist[n] * a1->idle.n) + (a2->idle.fdist[n] * a2->idle.n)) / items;
+                  data->idle.fdist[n] = (val > 0xFF) ? 0xFF : val;
+                  if (data->idle.fdist[n] == 0) {
+                     if (a1->idle.fdist[n] || a2->idle.fdist[n])
+                        data->idle.fdist[n] = 1;
+                  }
+               }
+            }
+         }
 
-                              if (deltaSrcFlowTime) {
-                                 value += deltaSrcFlowTime;
-                                 if (deltaSrcFlowTime > a1->idle.maxval)  a1->idle.maxval = deltaSrcFlowTime;
-                                 if (deltaSrcFlowTime < a1->idle.minval)  a1->idle.minval = deltaSrcFlowTime;
-                              } else 
-                              if (deltaDstFlowTime) {
-                                 value += deltaDstFlowTime;
-                                 if (deltaDstFlowTime > a1->idle.maxval)  a1->idle.maxval = deltaDstFlowTime;
-                                 if (deltaDstFlowTime < a1->idle.minval)  a1->idle.minval = deltaDstFlowTime;
-                              }
-                              a1->idle.n++;
+         if (deltaSrcFlowTime) {
+            value += deltaSrcFlowTime;
+            if (deltaSrcFlowTime > a1->idle.maxval)  a1->idle.maxval = deltaSrcFlowTime;
+            if (deltaSrcFlowTime < a1->idle.minval)  a1->idle.minval = deltaSrcFlowTime;
+         } else 
+         if (deltaDstFlowTime) {
+            value += deltaDstFlowTime;
+            if (deltaDstFlowTime > a1->idle.maxval)  a1->idle.maxval = deltaDstFlowTime;
+            if (deltaDstFlowTime < a1->idle.minval)  a1->idle.minval = deltaDstFlowTime;
+         }
+         a1->idle.n++;
 
-                              sum1 += value;
-                              ss1  += pow(value, 2.0);
+         sum1 += value;
+         ss1  += pow(value, 2.0);
 
-                              data->idle.maxval  = (a1->idle.maxval > a2->idle.maxval) ? a1->idle.maxval : a2->idle.maxval;
-                              data->idle.minval  = (a1->idle.minval < a2->idle.minval) ? a1->idle.minval : a2->idle.minval;
+         data->idle.maxval  = (a1->idle.maxval > a2->idle.maxval) ? a1->idle.maxval : a2->idle.maxval;
+         data->idle.minval  = (a1->idle.minval < a2->idle.minval) ? a1->idle.minval : a2->idle.minval;
 
-                              if ((data->idle.n = a1->idle.n + a2->idle.n) > 0) {
-                                    data->idle.meanval = (sum1 + sum2) / data->idle.n;
+         if ((data->idle.n = a1->idle.n + a2->idle.n) > 0) {
+               data->idle.meanval = (sum1 + sum2) / data->idle.n;
 
-                                    if (data->idle.n > 1)
-                                       data->idle.stdev = sqrt (fabs(((ss1 + ss2)/(data->idle.n)) - pow(data->idle.meanval, 2.0)));
-                                 }
+               if (data->idle.n > 1)
+                  data->idle.stdev = sqrt (fabs(((ss1 + ss2)/(data->idle.n)) - pow(data->idle.meanval, 2.0)));
+            }
 
-                                 for (n = 0, x = 10; (n < 8) && (deltaSrcFlowTime || deltaDstFlowTime); n++) {
-                                    if (deltaSrcFlowTime && (deltaSrcFlowTime < x)) {
-                                       if (data->idle.fdist[n] < 0xFF)
-                                          data->idle.fdist[n]++;
-                                       deltaSrcFlowTime = 0;
-                                    } 
-                                    if (deltaDstFlowTime && (deltaDstFlowTime < x)) {
-                                       if (data->idle.fdist[n] < 0xFF)
-                                          data->idle.fdist[n]++;
-                                       deltaDstFlowTime = 0;
-                                    }
-                                    x *= 10;
-                                 }
+            for (n = 0, x = 10; (n < 8) && (deltaSrcFlowTime || deltaDstFlowTime); n++) {
+               if (deltaSrcFlowTime && (deltaSrcFlowTime < x)) {
+                  if (data->idle.fdist[n] < 0xFF)
+                     data->idle.fdist[n]++;
+                  deltaSrcFlowTime = 0;
+               } 
+               if (deltaDstFlowTime && (deltaDstFlowTime < x)) {
+                  if (data->idle.fdist[n] < 0xFF)
+                     data->idle.fdist[n]++;
+                  deltaDstFlowTime = 0;
+               }
+               x *= 10;
+            }
 
-                                 data->laststartime = ((a1->laststartime.tv_sec  > a2->laststartime.tv_sec) ||
-                                                      ((a1->laststartime.tv_sec == a2->laststartime.tv_sec) &&
-                                                       (a1->laststartime.tv_usec > a2->laststartime.tv_usec))) ?
-                                                        a1->laststartime : a2->laststartime;
+            data->laststartime = ((a1->laststartime.tv_sec  > a2->laststartime.tv_sec) ||
+                                 ((a1->laststartime.tv_sec == a2->laststartime.tv_sec) &&
+                                  (a1->laststartime.tv_usec > a2->laststartime.tv_usec))) ?
+                                   a1->laststartime : a2->laststartime;
 
-                                 data->lasttime     = ((a1->lasttime.tv_sec  > a2->lasttime.tv_sec) ||
-                                                      ((a1->lasttime.tv_sec == a2->lasttime.tv_sec) &&
-                                                       (a1->lasttime.tv_usec > a2->lasttime.tv_usec))) ?
-                                                        a1->lasttime : a2->lasttime;
+            data->lasttime     = ((a1->lasttime.tv_sec  > a2->lasttime.tv_sec) ||
+                                 ((a1->lasttime.tv_sec == a2->lasttime.tv_sec) &&
+                                  (a1->lasttime.tv_usec > a2->lasttime.tv_usec))) ?
+                                   a1->lasttime : a2->lasttime;
 
-                              bcopy ((char *)data, (char *) a1, sizeof (databuf));
-                           }
+         bcopy ((char *)data, (char *) a1, sizeof (databuf));
+      }
 
-                        } else {
-                           if (a1 && !(a2)) {
-                              double value = na->RaMetricFetchAlgorithm(ns2);
-                              double tvalstd = 0, meansqrd = 0;
+   } else {
+      if (a1 && !(a2)) {
+         double value = na->RaMetricFetchAlgorithm(ns2);
+         double tvalstd = 0, meansqrd = 0;
 
-                              a1->count++;
+         a1->count++;
 
-                              if (a1->act.maxval < value) a1->act.maxval = value;
+         if (a1->act.maxval < value) a1->act.maxval = value;
 
-                              if (value != 0)
-                                 if (a1->act.minval > value)
-                                    a1->act.minval = value;
+         if (value != 0)
+            if (a1->act.minval > value)
+               a1->act.minval = value;
 
-                              sum1  = a1->act.meanval * a1->act.n;
-                              sum1 += value;
+         sum1  = a1->act.meanval * a1->act.n;
+         sum1 += value;
 
-                              if (a1->act.stdev != 0) {
-                                 tvalstd  = pow(a1->act.stdev, 2.0);
-                                 ss1 = a1->act.n * (tvalstd + pow(a1->act.meanval, 2.0));
+         if (a1->act.stdev != 0) {
+            tvalstd  = pow(a1->act.stdev, 2.0);
+            ss1 = a1->act.n * (tvalstd + pow(a1->act.meanval, 2.0));
 
-                              } else
-                                 ss1 = pow(a1->act.meanval, 2.0);
-                             
-                              ss1 += pow(value, 2.0);
+         } else
+            ss1 = pow(a1->act.meanval, 2.0);
 
-                              a1->act.n++;
-                              a1->act.meanval  = sum1 / a1->act.n;
-                              meansqrd = pow(a1->act.meanval, 2.0);
+         ss1 += pow(value, 2.0);
 
-                              a1->act.stdev    = sqrt(fabs((ss1/(a1->act.n)) - meansqrd));
+         a1->act.n++;
+         a1->act.meanval  = sum1 / a1->act.n;
+         meansqrd = pow(a1->act.meanval, 2.0);
 
-                           } else {
-                              if (!(a1) && a2) {
-                                 if ((a1 = ArgusCalloc(1, sizeof(*a1))) == NULL)
-                                    ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
-                                 bcopy ((char *)a2, (char *)a1, sizeof(*a2));
-                                 ns1->dsrs[ARGUS_AGR_INDEX] = (struct ArgusDSRHeader *) a1;
-                                 ns1->dsrindex |= (0x01 << ARGUS_AGR_INDEX);
-                              }
-                           }
-                        }
-                        break;
-                     }
+         a1->act.stdev    = sqrt(fabs((ss1/(a1->act.n)) - meansqrd));
+
+      } else {
+         if (!(a1) && a2) {
+            if ((a1 = ArgusCalloc(1, sizeof(*a1))) == NULL)
+               ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
+            bcopy ((char *)a2, (char *)a1, sizeof(*a2));
+            ns1->dsrs[ARGUS_AGR_INDEX] = (struct ArgusDSRHeader *) a1;
+            ns1->dsrindex |= (0x01 << ARGUS_AGR_INDEX);
+         }
+      }
+   }
+}
 
 // Merging the jitter object involves both records having
 // a valid jitter object.  If they don't just drop the dsr;
 
+static void
+ArgusMergeJitterDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                     struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusJitterStruct *j1 = (struct ArgusJitterStruct *) ns1->dsrs[ARGUS_JITTER_INDEX];
+   struct ArgusJitterStruct *j2 = (struct ArgusJitterStruct *) ns2->dsrs[ARGUS_JITTER_INDEX];
 
-                     case ARGUS_JITTER_INDEX: {
-                        struct ArgusJitterStruct *j1 = (struct ArgusJitterStruct *) ns1->dsrs[ARGUS_JITTER_INDEX];
-                        struct ArgusJitterStruct *j2 = (struct ArgusJitterStruct *) ns2->dsrs[ARGUS_JITTER_INDEX];
+   if (j1 && j2) {
+      if (j1->hdr.argus_dsrvl8.len == 0) {
+         bcopy ((char *) j2, (char *) j1, sizeof (*j1));
+         return;
+      }
 
-                        if (j1 && j2) {
-                           if (j1->hdr.argus_dsrvl8.len == 0) {
-                              bcopy ((char *) j2, (char *) j1, sizeof (*j1));
-                              break;
-                           }
+      if (j2->src.act.n > 0) {
+         unsigned int n, stdev = 0;
+         double meanval, sumsqrd = 0.0;
 
-                           if (j2->src.act.n > 0) {
-                              unsigned int n, stdev = 0;
-                              double meanval, sumsqrd = 0.0;
-                              
-                              n = (j1->src.act.n + j2->src.act.n);
-                              meanval = (((double)j1->src.act.meanval * (double)j1->src.act.n) +
-                                         ((double)j2->src.act.meanval * (double)j2->src.act.n)) / n;
-
-                              if (j1->src.act.n) {
-                                 double sum = (double)j1->src.act.meanval * (double)j1->src.act.n;
-                                 sumsqrd += (j1->src.act.n * ((double)j1->src.act.stdev * (double)j1->src.act.stdev)) +
-                                            (sum * sum)/j1->src.act.n;
-                              }
+         n = (j1->src.act.n + j2->src.act.n);
+         meanval = (((double)j1->src.act.meanval * (double)j1->src.act.n) +
+                    ((double)j2->src.act.meanval * (double)j2->src.act.n)) / n;
 
-                              if (j2->src.act.n) {
-                                 double sum  =  (double)j2->src.act.meanval * (double)j2->src.act.n;
-                                 sumsqrd += (j2->src.act.n * ((double)j2->src.act.stdev * (double)j2->src.act.stdev)) +
-                                            (sum * sum)/j2->src.act.n;
-                              }
-                              stdev = (int) sqrt (fabs((sumsqrd/n) - ((double)meanval * (double)meanval)));
-
-                              j1->src.act.n       = n;
-                              j1->src.act.meanval = (unsigned int) meanval;
-                              j1->src.act.stdev   = stdev;
-                              if (j1->src.act.minval > j2->src.act.minval)
-                                 j1->src.act.minval = j2->src.act.minval;
-                              if (j1->src.act.maxval < j2->src.act.maxval)
-                                 j1->src.act.maxval = j2->src.act.maxval;
-
-                              switch (j1->hdr.subtype & (ARGUS_HISTO_EXP | ARGUS_HISTO_LINEAR)) {
-                                 case ARGUS_HISTO_EXP: {
-                                    int x, max, tot, val[8];
-
-                                    for (x = 0, max = 0, tot = 0; x < 8; x++) {
-                                       val[x] = (j1->src.act.fdist[x] + j2->src.act.fdist[x]);
-                                       tot += val[x];
-                                       if (max < val[x])
-                                          max = val[x];
-                                    }
-                                    for (x = 0; x < 8; x++) {
-                                       if (val[x]) {
-                                          if (max > 255)
-                                             val[x] = (val[x] * 255)/max;
-                                          if (val[x] == 0)
-                                             val[x] = 1;
-                                       }
-                                       j1->src.act.fdist[x] = val[x];
-                                    }
-                                    break;
-                                 }
-                                 case ARGUS_HISTO_LINEAR: {
-                                    break;
-                                 }
-                              }
-                           }
+         if (j1->src.act.n) {
+            double sum = (double)j1->src.act.meanval * (double)j1->src.act.n;
+            sumsqrd += (j1->src.act.n * ((double)j1->src.act.stdev * (double)j1->src.act.stdev)) +
+                       (sum * sum)/j1->src.act.n;
+         }
 
-                           if (j2->src.idle.n > 0) {
-                              unsigned int n, stdev = 0;
-                              double meanval, sumsqrd = 0.0;
-                              
-                              n = (j1->src.idle.n + j2->src.idle.n);
-                              meanval  = (((double) j1->src.idle.meanval * (double) j1->src.idle.n) +
-                                          ((double) j2->src.idle.meanval * (double) j2->src.idle.n)) / n;
-
-                              if (j1->src.idle.n) {
-                                 double sum  =  (double) j1->src.idle.meanval * (double) j1->src.idle.n;
-                                 sumsqrd += (j1->src.idle.n * ((double)j1->src.idle.stdev * (double)j1->src.idle.stdev)) +
-                                            ((double)sum *(double)sum)/j1->src.idle.n;
-                              }
+         if (j2->src.act.n) {
+            double sum  =  (double)j2->src.act.meanval * (double)j2->src.act.n;
+            sumsqrd += (j2->src.act.n * ((double)j2->src.act.stdev * (double)j2->src.act.stdev)) +
+                       (sum * sum)/j2->src.act.n;
+         }
+         stdev = (int) sqrt (fabs((sumsqrd/n) - ((double)meanval * (double)meanval)));
+
+         j1->src.act.n       = n;
+         j1->src.act.meanval = (unsigned int) meanval;
+         j1->src.act.stdev   = stdev;
+         if (j1->src.act.minval > j2->src.act.minval)
+            j1->src.act.minval = j2->src.act.minval;
+         if (j1->src.act.maxval < j2->src.act.maxval)
+            j1->src.act.maxval = j2->src.act.maxval;
+
+         switch (j1->hdr.subtype & (ARGUS_HISTO_EXP | ARGUS_HISTO_LINEAR)) {
+            case ARGUS_HISTO_EXP: {
+               int x, max, tot, val[8];
+
+               for (x = 0, max = 0, tot = 0; x < 8; x++) {
+                  val[x] = (j1->src.act.fdist[x] + j2->src.act.fdist[x]);
+                  tot += val[x];
+                  if (max < val[x])
+                     max = val[x];
+               }
+               for (x = 0; x < 8; x++) {
+                  if (val[x]) {
+                     if (max > 255)
+                        val[x] = (val[x] * 255)/max;
+                     if (val[x] == 0)
+                        val[x] = 1;
+                  }
+                  j1->src.act.fdist[x] = val[x];
+               }
+               break;
+            }
+            case ARGUS_HISTO_LINEAR: {
+               break;
+            }
+         }
+      }
 
-                              if (j2->src.idle.n) {
-                                 double sum  =  (double) j2->src.idle.meanval * (double) j2->src.idle.n;
-                                 sumsqrd += (j2->src.idle.n * ((double)j2->src.idle.stdev * (double)j2->src.idle.stdev)) +
-                                            ((double)sum *(double)sum)/j2->src.idle.n;
-                              }
-                              stdev = (int) sqrt (fabs((sumsqrd/n) - ((double)meanval * (double)meanval)));
-
-                              j1->src.idle.n       = n;
-                              j1->src.idle.meanval = (unsigned int) meanval;
-                              j1->src.idle.stdev   = stdev;
-                              if (j1->src.idle.minval > j2->src.idle.minval)
-                                 j1->src.idle.minval = j2->src.idle.minval;
-                              if (j1->src.idle.maxval < j2->src.idle.maxval)
-                                 j1->src.idle.maxval = j2->src.idle.maxval;
-
-                              switch (j1->hdr.subtype & (ARGUS_HISTO_EXP | ARGUS_HISTO_LINEAR)) {
-                                 case ARGUS_HISTO_EXP: {
-                                    int x, max, tot, val[8];
-
-                                    for (x = 0, max = 0, tot = 0; x < 8; x++) {
-                                       val[x] = (j1->src.idle.fdist[x] + j2->src.idle.fdist[x]);
-                                       tot += val[x];
-                                       if (max < val[x])
-                                          max = val[x];
-                                    }
-                                    for (x = 0; x < 8; x++) {
-                                       if (val[x]) {
-                                          if (max > 255)
-                                             val[x] = (val[x] * 255)/max;
-                                          if (val[x] == 0)
-                                             val[x] = 1;
-                                       }
-                                       j1->src.idle.fdist[x] = val[x];
-                                    }
-                                    break;
-                                 }
-                                 case ARGUS_HISTO_LINEAR: {
-                                    break;
-                                 }
-                              }  
-                           }
+      if (j2->src.idle.n > 0) {
+         unsigned int n, stdev = 0;
+         double meanval, sumsqrd = 0.0;
 
-                           if (j2->dst.act.n > 0) {
-                              unsigned int n, stdev = 0;
-                              double meanval, sumsqrd = 0.0;
-                              
-                              n = (j1->dst.act.n + j2->dst.act.n);
-                              meanval  = (((double) j1->dst.act.meanval * (double) j1->dst.act.n) +
-                                          ((double) j2->dst.act.meanval * (double) j2->dst.act.n)) / n;
-
-                              if (j1->dst.act.n) {
-                                 double sum  =  j1->dst.act.meanval * j1->dst.act.n;
-                                 sumsqrd += (j1->dst.act.n * ((double)j1->dst.act.stdev * (double)j1->dst.act.stdev)) +
-                                            (sum * sum)/j1->dst.act.n;
-                              }
+         n = (j1->src.idle.n + j2->src.idle.n);
+         meanval  = (((double) j1->src.idle.meanval * (double) j1->src.idle.n) +
+                     ((double) j2->src.idle.meanval * (double) j2->src.idle.n)) / n;
 
-                              if (j2->dst.act.n) {
-                                 double sum  =  (double) j2->dst.act.meanval * (double) j2->dst.act.n;
-                                 sumsqrd += (j2->dst.act.n * ((double)j2->dst.act.stdev * (double)j2->dst.act.stdev)) +
-                                            ((double)sum *(double)sum)/j2->dst.act.n;
-                              }
-                              stdev = (int) sqrt (fabs((sumsqrd/n) - ((double)meanval * (double)meanval)));
-
-                              j1->dst.act.n       = n;
-                              j1->dst.act.meanval = (unsigned int) meanval;
-                              j1->dst.act.stdev   = stdev;
-                              if (j1->dst.act.minval > j2->dst.act.minval)
-                                 j1->dst.act.minval = j2->dst.act.minval;
-                              if (j1->dst.act.maxval < j2->dst.act.maxval)
-                                 j1->dst.act.maxval = j2->dst.act.maxval;
-
-                              switch (j1->hdr.subtype & (ARGUS_HISTO_EXP | ARGUS_HISTO_LINEAR)) {
-                                 case ARGUS_HISTO_EXP: {
-                                    int x, max, tot, val[8];
-
-                                    for (x = 0, max = 0, tot = 0; x < 8; x++) {
-                                       val[x] = (j1->dst.act.fdist[x] + j2->dst.act.fdist[x]);
-                                       tot += val[x];
-                                       if (max < val[x])
-                                          max = val[x];
-                                    }
-                                    for (x = 0; x < 8; x++) {
-                                       if (val[x]) {
-                                          if (max > 255)
-                                             val[x] = (val[x] * 255)/max;
-                                          if (val[x] == 0)
-                                             val[x] = 1;
-                                       }
-                                       j1->dst.act.fdist[x] = val[x];
-                                    }
-                                    break;
-                                 }
-                                 case ARGUS_HISTO_LINEAR: {
-                                    break;
-                                 }
-                              }  
-                           }
+         if (j1->src.idle.n) {
+            double sum  =  (double) j1->src.idle.meanval * (double) j1->src.idle.n;
+            sumsqrd += (j1->src.idle.n * ((double)j1->src.idle.stdev * (double)j1->src.idle.stdev)) +
+                       ((double)sum *(double)sum)/j1->src.idle.n;
+         }
 
-                           if (j2->dst.idle.n > 0) {
-                              unsigned int n, stdev = 0;
-                              double meanval, sumsqrd = 0.0;
-                              
-                              n = (j1->dst.idle.n + j2->dst.idle.n);
-                              meanval  = (((double) j1->dst.idle.meanval * (double) j1->dst.idle.n) +
-                                          ((double) j2->dst.idle.meanval * (double) j2->dst.idle.n)) / n;
-
-                              if (j1->dst.idle.n) {
-                                 int sum  =  (double) j1->dst.idle.meanval * (double) j1->dst.idle.n;
-                                 sumsqrd += (j1->dst.idle.n * ((double)j1->dst.idle.stdev * (double)j1->dst.idle.stdev)) +
-                                            ((double)sum *(double)sum)/j1->dst.idle.n;
-                              }
+         if (j2->src.idle.n) {
+            double sum  =  (double) j2->src.idle.meanval * (double) j2->src.idle.n;
+            sumsqrd += (j2->src.idle.n * ((double)j2->src.idle.stdev * (double)j2->src.idle.stdev)) +
+                       ((double)sum *(double)sum)/j2->src.idle.n;
+         }
+         stdev = (int) sqrt (fabs((sumsqrd/n) - ((double)meanval * (double)meanval)));
+
+         j1->src.idle.n       = n;
+         j1->src.idle.meanval = (unsigned int) meanval;
+         j1->src.idle.stdev   = stdev;
+         if (j1->src.idle.minval > j2->src.idle.minval)
+            j1->src.idle.minval = j2->src.idle.minval;
+         if (j1->src.idle.maxval < j2->src.idle.maxval)
+            j1->src.idle.maxval = j2->src.idle.maxval;
+
+         switch (j1->hdr.subtype & (ARGUS_HISTO_EXP | ARGUS_HISTO_LINEAR)) {
+            case ARGUS_HISTO_EXP: {
+               int x, max, tot, val[8];
+
+               for (x = 0, max = 0, tot = 0; x < 8; x++) {
+                  val[x] = (j1->src.idle.fdist[x] + j2->src.idle.fdist[x]);
+                  tot += val[x];
+                  if (max < val[x])
+                     max = val[x];
+               }
+               for (x = 0; x < 8; x++) {
+                  if (val[x]) {
+                     if (max > 255)
+                        val[x] = (val[x] * 255)/max;
+                     if (val[x] == 0)
+                        val[x] = 1;
+                  }
+                  j1->src.idle.fdist[x] = val[x];
+               }
+               break;
+            }
+            case ARGUS_HISTO_LINEAR: {
+               break;
+            }
+         }  
+      }
 
-                              if (j2->dst.idle.n) {
-                                 double sum  =  (double) j2->dst.idle.meanval * (double) j2->dst.idle.n;
-                                 sumsqrd += (j2->dst.idle.n * ((double)j2->dst.idle.stdev * (double)j2->dst.idle.stdev)) +
-                                            ((double)sum *(double)sum)/j2->dst.idle.n;
-                              }
-                              stdev = (int) sqrt (fabs((sumsqrd/n) - ((double)meanval * (double)meanval)));
-
-                              j1->dst.idle.n       = n;
-                              j1->dst.idle.meanval = (unsigned int) meanval;
-                              j1->dst.idle.stdev   = stdev;
-                              if (j1->dst.idle.minval > j2->dst.idle.minval)
-                                 j1->dst.idle.minval = j2->dst.idle.minval;
-                              if (j1->dst.idle.maxval < j2->dst.idle.maxval)
-                                 j1->dst.idle.maxval = j2->dst.idle.maxval;
-
-                              switch (j1->hdr.subtype & (ARGUS_HISTO_EXP | ARGUS_HISTO_LINEAR)) {
-                                 case ARGUS_HISTO_EXP: {
-                                    int x, max, tot, val[8];
-
-                                    for (x = 0, max = 0, tot = 0; x < 8; x++) {
-                                       val[x] = (j1->dst.idle.fdist[x] + j2->dst.idle.fdist[x]);
-                                       tot += val[x];
-                                       if (max < val[x])
-                                          max = val[x];
-                                    }
-                                    for (x = 0; x < 8; x++) {
-                                       if (val[x]) {
-                                          if (max > 255)
-                                             val[x] = (val[x] * 255)/max;
-                                          if (val[x] == 0)
-                                             val[x] = 1;
-                                       }
-                                       j1->dst.idle.fdist[x] = val[x];
-                                    }
-                                    break;
-                                 }
-                                 case ARGUS_HISTO_LINEAR: {
-                                    break;
-                                 }
-                              }  
-                           }
+      if (j2->dst.act.n > 0) {
+         unsigned int n, stdev = 0;
+         double meanval, sumsqrd = 0.0;
 
-                        } else {
-                           if (!j1 && j2) {
-                              if ((j1 = (void *) ArgusCalloc (1, sizeof(*j1))) == NULL)
-                                 ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
-                              bcopy ((char *) j2, (char *)j1, sizeof (*j1));
-                              ns1->dsrs[i] = (struct ArgusDSRHeader *) j1;
-                              ns1->dsrindex |= (0x01 << i);
-                           }
-                        }
+         n = (j1->dst.act.n + j2->dst.act.n);
+         meanval  = (((double) j1->dst.act.meanval * (double) j1->dst.act.n) +
+                     ((double) j2->dst.act.meanval * (double) j2->dst.act.n)) / n;
+
+         if (j1->dst.act.n) {
+            double sum  =  j1->dst.act.meanval * j1->dst.act.n;
+            sumsqrd += (j1->dst.act.n * ((double)j1->dst.act.stdev * (double)j1->dst.act.stdev)) +
+                       (sum * sum)/j1->dst.act.n;
+         }
+
+         if (j2->dst.act.n) {
+            double sum  =  (double) j2->dst.act.meanval * (double) j2->dst.act.n;
+            sumsqrd += (j2->dst.act.n * ((double)j2->dst.act.stdev * (double)j2->dst.act.stdev)) +
+                       ((double)sum *(double)sum)/j2->dst.act.n;
+         }
+         stdev = (int) sqrt (fabs((sumsqrd/n) - ((double)meanval * (double)meanval)));
+
+         j1->dst.act.n       = n;
+         j1->dst.act.meanval = (unsigned int) meanval;
+         j1->dst.act.stdev   = stdev;
+         if (j1->dst.act.minval > j2->dst.act.minval)
+            j1->dst.act.minval = j2->dst.act.minval;
+         if (j1->dst.act.maxval < j2->dst.act.maxval)
+            j1->dst.act.maxval = j2->dst.act.maxval;
+
+         switch (j1->hdr.subtype & (ARGUS_HISTO_EXP | ARGUS_HISTO_LINEAR)) {
+            case ARGUS_HISTO_EXP: {
+               int x, max, tot, val[8];
+
+               for (x = 0, max = 0, tot = 0; x < 8; x++) {
+                  val[x] = (j1->dst.act.fdist[x] + j2->dst.act.fdist[x]);
+                  tot += val[x];
+                  if (max < val[x])
+                     max = val[x];
+               }
+               for (x = 0; x < 8; x++) {
+                  if (val[x]) {
+                     if (max > 255)
+                        val[x] = (val[x] * 255)/max;
+                     if (val[x] == 0)
+                        val[x] = 1;
+                  }
+                  j1->dst.act.fdist[x] = val[x];
+               }
+               break;
+            }
+            case ARGUS_HISTO_LINEAR: {
+               break;
+            }
+         }  
+      }
+
+      if (j2->dst.idle.n > 0) {
+         unsigned int n, stdev = 0;
+         double meanval, sumsqrd = 0.0;
+
+         n = (j1->dst.idle.n + j2->dst.idle.n);
+         meanval  = (((double) j1->dst.idle.meanval * (double) j1->dst.idle.n) +
+                     ((double) j2->dst.idle.meanval * (double) j2->dst.idle.n)) / n;
+
+         if (j1->dst.idle.n) {
+            int sum  =  (double) j1->dst.idle.meanval * (double) j1->dst.idle.n;
+            sumsqrd += (j1->dst.idle.n * ((double)j1->dst.idle.stdev * (double)j1->dst.idle.stdev)) +
+                       ((double)sum *(double)sum)/j1->dst.idle.n;
+         }
+
+         if (j2->dst.idle.n) {
+            double sum  =  (double) j2->dst.idle.meanval * (double) j2->dst.idle.n;
+            sumsqrd += (j2->dst.idle.n * ((double)j2->dst.idle.stdev * (double)j2->dst.idle.stdev)) +
+                       ((double)sum *(double)sum)/j2->dst.idle.n;
+         }
+         stdev = (int) sqrt (fabs((sumsqrd/n) - ((double)meanval * (double)meanval)));
+
+         j1->dst.idle.n       = n;
+         j1->dst.idle.meanval = (unsigned int) meanval;
+         j1->dst.idle.stdev   = stdev;
+         if (j1->dst.idle.minval > j2->dst.idle.minval)
+            j1->dst.idle.minval = j2->dst.idle.minval;
+         if (j1->dst.idle.maxval < j2->dst.idle.maxval)
+            j1->dst.idle.maxval = j2->dst.idle.maxval;
+
+         switch (j1->hdr.subtype & (ARGUS_HISTO_EXP | ARGUS_HISTO_LINEAR)) {
+            case ARGUS_HISTO_EXP: {
+               int x, max, tot, val[8];
+
+               for (x = 0, max = 0, tot = 0; x < 8; x++) {
+                  val[x] = (j1->dst.idle.fdist[x] + j2->dst.idle.fdist[x]);
+                  tot += val[x];
+                  if (max < val[x])
+                     max = val[x];
+               }
+               for (x = 0; x < 8; x++) {
+                  if (val[x]) {
+                     if (max > 255)
+                        val[x] = (val[x] * 255)/max;
+                     if (val[x] == 0)
+                        val[x] = 1;
+                  }
+                  j1->dst.idle.fdist[x] = val[x];
+               }
+               break;
+            }
+            case ARGUS_HISTO_LINEAR: {
+               break;
+            }
+         }  
+      }
+
+   } else {
+      if (!j1 && j2) {
+         if ((j1 = (void *) ArgusCalloc (1, sizeof(*j1))) == NULL)
+            ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
+         bcopy ((char *) j2, (char *)j1, sizeof (*j1));
+         ns1->dsrs[i] = (struct ArgusDSRHeader *) j1;
+         ns1->dsrindex |= (0x01 << i);
+      }
+   }
+}
+
+// Merging the user data object involves leaving the ns1 buffer,
+// or making the ns2 buffer, ns1's.  Since these are allocated
+// objects, make sure you deal with them as such.
+
+static void
+ArgusMergeUserDataDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                       struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusDataStruct *d1 = (struct ArgusDataStruct *) ns1->dsrs[i];
+   struct ArgusDataStruct *d2 = (struct ArgusDataStruct *) ns2->dsrs[i];
+
+   if (d1 && d2) {
+      unsigned short d2count = d2->count;
+      int t1len = d1->size - d1->count;
+      int t2len = d2->size - d2->count;
+
+      if (t1len < 0) { d1->count = d1->size; t1len = 0; }
+      if (t2len < 0) { d2count = d2->size; t2len = 0; }
+
+      t1len = (t1len > d2count) ? d2count : t1len;
+
+      if (t1len > 0) {
+         bcopy(d2->array, &d1->array[d1->count], t1len);
+         d1->count += t1len;
+      }
+
+   } else
+   if (!d1 && d2) {
+      struct ArgusDataStruct *t2;
+      int len = (((d2->hdr.type & ARGUS_IMMEDIATE_DATA) ? 1 :
+                 ((d2->hdr.subtype & ARGUS_LEN_16BITS)  ? d2->hdr.argus_dsrvl16.len :
+                                                          d2->hdr.argus_dsrvl8.len)));
+      if ((t2 = (struct ArgusDataStruct *) ArgusCalloc((2 + len), 4)) == NULL)
+         ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
+
+      bcopy ((char *)d2, (char *)t2, len * 4);
+      t2->size  = (len - 2) * 4;
+      t2->count  = (len - 2) * 4;
+      ns1->dsrs[i] = (struct ArgusDSRHeader *) t2;
+      ns1->dsrindex |= (0x01 << i);
+   }
+}
+
+// Merging the MAC data object involves comparing the ns1 buffer,
+// leaving them if they are equal and blowing away the value if they
+// are different.
+
+static void
+ArgusMergeEncapsDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                     struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusEncapsStruct *e1  = (struct ArgusEncapsStruct *) ns1->dsrs[ARGUS_ENCAPS_INDEX];
+   struct ArgusEncapsStruct *e2  = (struct ArgusEncapsStruct *) ns2->dsrs[ARGUS_ENCAPS_INDEX];
+
+   if (e1 && e2) {
+      if (e1->src != e2->src) {
+         e1->hdr.argus_dsrvl8.qual |= ARGUS_SRC_CHANGED;
+         e1->src |= e2->src;
+      }
+      if (e1->dst != e2->dst) {
+         e1->hdr.argus_dsrvl8.qual |= ARGUS_DST_CHANGED;
+         e1->dst |= e2->dst;
+      }
+   }
+}
+
+static void
+ArgusMergeMacDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                  struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusMacStruct *m1 = (struct ArgusMacStruct *) ns1->dsrs[ARGUS_MAC_INDEX];
+   struct ArgusMacStruct *m2 = (struct ArgusMacStruct *) ns2->dsrs[ARGUS_MAC_INDEX];
+
+   if (m1 && m2) {
+      if (m1->hdr.subtype == m2->hdr.subtype) {
+         switch (m1->hdr.subtype) {
+            default:
+            case ARGUS_TYPE_ETHER: {
+               struct ether_header *e1 = &m1->mac.mac_union.ether.ehdr;
+               struct ether_header *e2 = &m2->mac.mac_union.ether.ehdr;
+
+               if (bcmp(&e1->ether_shost, &e2->ether_shost, sizeof(e1->ether_shost)))
+                  bzero ((char *)&e1->ether_shost, sizeof(e1->ether_shost));
+
+               if (bcmp(&e1->ether_dhost, &e2->ether_dhost, sizeof(e1->ether_dhost)))
+                  bzero ((char *)&e1->ether_dhost, sizeof(e1->ether_dhost));
+
+               if (e1->ether_type != e2->ether_type) 
+                  e1->ether_type = 0;
+               break;
+            }
+         }
+
+      } else {
+         ArgusFree(ns1->dsrs[ARGUS_MAC_INDEX]);
+         ns1->dsrs[ARGUS_MAC_INDEX] = NULL;
+         ns1->dsrindex &= ~(0x01 << i);
+      }
+
+   } else {
+      if (ns1->dsrs[ARGUS_MAC_INDEX] != NULL) {
+         ArgusFree(ns1->dsrs[ARGUS_MAC_INDEX]);
+         ns1->dsrs[ARGUS_MAC_INDEX] = NULL;
+         ns1->dsrindex &= ~(0x01 << i);
+      }
+   }
+}
+
+static void
+ArgusMergeIcmpDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                   struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusIcmpStruct *i1 = (struct ArgusIcmpStruct *) ns1->dsrs[ARGUS_ICMP_INDEX];
+   struct ArgusIcmpStruct *i2 = (struct ArgusIcmpStruct *) ns2->dsrs[ARGUS_ICMP_INDEX];
+
+   if (i1 && i2) {
+      if ((i1->hdr.argus_dsrvl8.qual & ARGUS_ICMP_MAPPED) &&
+          (i2->hdr.argus_dsrvl8.qual & ARGUS_ICMP_MAPPED)) {
+         struct ArgusFlow *flow = (void *)ns1->dsrs[ARGUS_FLOW_INDEX];
+         int type = 0;
+
+         if (flow != NULL) {
+            switch (flow->hdr.subtype & 0x3F) {
+               case ARGUS_FLOW_CLASSIC5TUPLE:
+               case ARGUS_FLOW_LAYER_3_MATRIX: {
+                  switch (type = (flow->hdr.argus_dsrvl8.qual & 0x1F)) {
+                     case ARGUS_TYPE_IPV4: {
+                        unsigned char masklen = 32;
+                        ArgusMergeAddress(&i1->osrcaddr, &i2->osrcaddr, ARGUS_TYPE_IPV4, ARGUS_SRC, &masklen);
                         break;
                      }
 
-// Merging the user data object involves leaving the ns1 buffer,
-// or making the ns2 buffer, ns1's.  Since these are allocated
-// objects, make sure you deal with them as such.
+                     case ARGUS_TYPE_IPV6:
+                        break;
+                  }
+                  break;
+               }
+            }
+         }
+      }
+   }
+
+   if (!i1 && i2) {
+      int len = i2->hdr.argus_dsrvl8.len;
+
+      if (len > 0) {
+         if ((i1 = ArgusCalloc(1, len * 4)) == NULL)
+            ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
+         bcopy ((char *)i2, (char *)i1, len * 4);
+
+         ns1->dsrs[ARGUS_ICMP_INDEX] = (struct ArgusDSRHeader *) i1;
+         ns1->dsrindex |= (0x01 << ARGUS_ICMP_INDEX);
+      }
+   }
+}
+
+static void
+ArgusMergeCocodeDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                     struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusCountryCodeStruct *c1 = (void *) ns1->dsrs[ARGUS_COCODE_INDEX];
+   struct ArgusCountryCodeStruct *c2 = (void *) ns2->dsrs[ARGUS_COCODE_INDEX];
+
+   if (c1 && c2) {
+      if (bcmp(c1->src, c2->src, sizeof(c1->src)))
+         bzero(&c1->src, sizeof(c1->src));
+      if (bcmp(c1->dst, c2->dst, sizeof(c1->dst)))
+         bzero(&c1->dst, sizeof(c1->dst));
 
+   } else
+   if (c2) {
+      int len = c2->hdr.argus_dsrvl8.len;
 
-                     case ARGUS_SRCUSERDATA_INDEX: 
-                     case ARGUS_DSTUSERDATA_INDEX: {
-                        struct ArgusDataStruct *d1 = (struct ArgusDataStruct *) ns1->dsrs[i];
-                        struct ArgusDataStruct *d2 = (struct ArgusDataStruct *) ns2->dsrs[i];
+      if (len > 0) {
+         if ((c1 = ArgusCalloc(1, len * 4)) == NULL)
+            ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
+         bcopy ((char *)c2, (char *)c2, len * 4);
 
-                        if (d1 && d2) {
-                           unsigned short d2count = d2->count;
-                           int t1len = d1->size - d1->count;
-                           int t2len = d2->size - d2->count;
+         ns1->dsrs[ARGUS_COCODE_INDEX] = (struct ArgusDSRHeader *) c1;
+         ns1->dsrindex |= (0x01 << ARGUS_COCODE_INDEX);
+      }
+   }
+}
 
-                           if (t1len < 0) { d1->count = d1->size; t1len = 0; }
-                           if (t2len < 0) { d2count = d2->size; t2len = 0; }
+static void
+ArgusMergeLabelDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                    struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusLabelStruct *l1 = (void *) ns1->dsrs[ARGUS_LABEL_INDEX];
+   struct ArgusLabelStruct *l2 = (void *) ns2->dsrs[ARGUS_LABEL_INDEX];
+
+   if (l1 && l2) {
+      if ((l1->l_un.label != NULL) && (l2->l_un.label != NULL)) {
+         if (strcmp(l1->l_un.label, l2->l_un.label)) {
+            char *buf = calloc(1, MAXBUFFERLEN);
+            int len;
+
+            if ((ArgusMergeLabel(l1->l_un.label, l2->l_un.label, buf, MAXBUFFERLEN, ARGUS_UNION)) != NULL) {
+               free(l1->l_un.label);
+               l1->l_un.label = strdup(buf);
+               len = 1 + ((strlen(buf) + 3)/4);
+               l1->hdr.argus_dsrvl8.len  = len;
+            }
+            free(buf);
+         }
+      } else {
+         if (l2->l_un.label != NULL) {
+            if (l1->l_un.label != NULL) free (l1->l_un.label);
+            l1->l_un.label = strdup(l2->l_un.label);
+         }
+      }
 
-                           t1len = (t1len > d2count) ? d2count : t1len;
+   } else {
+      if (l2 && (l1 == NULL)) {
+         ns1->dsrs[ARGUS_LABEL_INDEX] = calloc(1, sizeof(struct ArgusLabelStruct));
+         ns1->dsrindex |= (0x01 << ARGUS_LABEL_INDEX);
 
-                           if (t1len > 0) {
-                              bcopy(d2->array, &d1->array[d1->count], t1len);
-                              d1->count += t1len;
-                           }
+         l1 = (void *) ns1->dsrs[ARGUS_LABEL_INDEX];
 
-                        } else
-                        if (!d1 && d2) {
-                           struct ArgusDataStruct *t2;
-                           int len = (((d2->hdr.type & ARGUS_IMMEDIATE_DATA) ? 1 :
-                                      ((d2->hdr.subtype & ARGUS_LEN_16BITS)  ? d2->hdr.argus_dsrvl16.len :
-                                                                               d2->hdr.argus_dsrvl8.len)));
-                           if ((t2 = (struct ArgusDataStruct *) ArgusCalloc((2 + len), 4)) == NULL)
-                              ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
-
-                           bcopy ((char *)d2, (char *)t2, len * 4);
-                           t2->size  = (len - 2) * 4;
-                           t2->count  = (len - 2) * 4;
-                           ns1->dsrs[i] = (struct ArgusDSRHeader *) t2;
-                           ns1->dsrindex |= (0x01 << i);
-                        }
-                        break;
-                     }
+         bcopy(l2, l1, sizeof(*l2));
+         l1->l_un.label = NULL;
 
+         if (l2->l_un.label != NULL)
+            l1->l_un.label = strdup(l2->l_un.label);
+      }
+   }
+}
 
-// Merging the MAC data object involves comparing the ns1 buffer,
-// leaving them if they are equal and blowing away the value if they
-// are different.
+// Merging the behavioral dsr's currently involve accumulating the counters for keystrokes.
+// and taking the greatest of the scores.
 
-                     case ARGUS_ENCAPS_INDEX: {
-                        struct ArgusEncapsStruct *e1  = (struct ArgusEncapsStruct *) ns1->dsrs[ARGUS_ENCAPS_INDEX];
-                        struct ArgusEncapsStruct *e2  = (struct ArgusEncapsStruct *) ns2->dsrs[ARGUS_ENCAPS_INDEX];
+static void
+ArgusMergeBehaviorDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                       struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusBehaviorStruct *a1 = (void *) ns1->dsrs[ARGUS_BEHAVIOR_INDEX];
+   struct ArgusBehaviorStruct *a2 = (void *) ns2->dsrs[ARGUS_BEHAVIOR_INDEX];
+
+   if (a1 && a2) {
+      if (a1->hdr.subtype == a2->hdr.subtype) {
+         switch (a1->hdr.subtype) {
+            case ARGUS_TCP_KEYSTROKE: 
+            case ARGUS_SSH_KEYSTROKE: 
+            case ARGUS_BEHAVIOR_KEYSTROKE: {
+               a1->keyStroke.src.n_strokes += a2->keyStroke.src.n_strokes;
+               a1->keyStroke.dst.n_strokes += a2->keyStroke.dst.n_strokes;
+               break;
+            }
+         }
+      }
 
-                        if (e1 && e2) {
-                           if (e1->src != e2->src) {
-                              e1->hdr.argus_dsrvl8.qual |= ARGUS_SRC_CHANGED;
-                              e1->src |= e2->src;
-                           }
-                           if (e1->dst != e2->dst) {
-                              e1->hdr.argus_dsrvl8.qual |= ARGUS_DST_CHANGED;
-                              e1->dst |= e2->dst;
-                           }
-                        }
-                        break;
-                     }
+   } else {
+      if (a2 && (a1 == NULL)) {
+         ns1->dsrs[ARGUS_BEHAVIOR_INDEX] = calloc(1, sizeof(struct ArgusBehaviorStruct));
+         ns1->dsrindex |= (0x01 << ARGUS_BEHAVIOR_INDEX);
 
-                     case ARGUS_MAC_INDEX: {
-                        struct ArgusMacStruct *m1 = (struct ArgusMacStruct *) ns1->dsrs[ARGUS_MAC_INDEX];
-                        struct ArgusMacStruct *m2 = (struct ArgusMacStruct *) ns2->dsrs[ARGUS_MAC_INDEX];
+         a1 = (void *) ns1->dsrs[ARGUS_BEHAVIOR_INDEX];
+         bcopy(a2, a1, sizeof(*a2));
+      }
+   }
+}
 
-                        if (m1 && m2) {
-                           if (m1->hdr.subtype == m2->hdr.subtype) {
-                              switch (m1->hdr.subtype) {
-                                 default:
-                                 case ARGUS_TYPE_ETHER: {
-                                    struct ether_header *e1 = &m1->mac.mac_union.ether.ehdr;
-                                    struct ether_header *e2 = &m2->mac.mac_union.ether.ehdr;
+static void
+ArgusMergeScoreDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                    struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusScoreStruct *s1 = (void *) ns1->dsrs[ARGUS_SCORE_INDEX];
+   struct ArgusScoreStruct *s2 = (void *) ns2->dsrs[ARGUS_SCORE_INDEX];
 
-                                    if (bcmp(&e1->ether_shost, &e2->ether_shost, sizeof(e1->ether_shost)))
-                                       bzero ((char *)&e1->ether_shost, sizeof(e1->ether_shost));
-                          
-                                    if (bcmp(&e1->ether_dhost, &e2->ether_dhost, sizeof(e1->ether_dhost)))
-                                       bzero ((char *)&e1->ether_dhost, sizeof(e1->ether_dhost));
+   if (s1 || s2) {
+      if (s1 && s2) {
+         if (s1->hdr.subtype == s2->hdr.subtype) {
+            switch (s1->hdr.subtype) {
+               case ARGUS_BEHAVIOR_SCORE: {
+                  int i;
+                  for (i = 0; i < 8; i++) {
+                     if (s2->behvScore.values[i] > s1->behvScore.values[i])
+                        s1->behvScore.values[i] = s2->behvScore.values[i];
+                  }
+               }
+            }
+         }
+      } else 
+      if (!s1 && s2) {
+         ns1->dsrs[ARGUS_SCORE_INDEX] = calloc(1, sizeof(struct ArgusScoreStruct));
+         ns1->dsrindex |= (0x01 << ARGUS_SCORE_INDEX);
 
-                                    if (e1->ether_type != e2->ether_type) 
-                                       e1->ether_type = 0;
-                                    break;
-                                 }
-                              }
+         s1 = (void *) ns1->dsrs[ARGUS_SCORE_INDEX];
+         bcopy(s2, s1, sizeof(*s2));
+      }
+   }
+}
 
-                           } else {
-                              ArgusFree(ns1->dsrs[ARGUS_MAC_INDEX]);
-                              ns1->dsrs[ARGUS_MAC_INDEX] = NULL;
-                              ns1->dsrindex &= ~(0x01 << i);
-                           }
+static void
+ArgusMergeGeoDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                  struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusGeoLocationStruct *g1 = (void *) ns1->dsrs[ARGUS_GEO_INDEX];
+   struct ArgusGeoLocationStruct *g2 = (void *) ns2->dsrs[ARGUS_GEO_INDEX];
 
-                        } else {
-                           if (ns1->dsrs[ARGUS_MAC_INDEX] != NULL) {
-                              ArgusFree(ns1->dsrs[ARGUS_MAC_INDEX]);
-                              ns1->dsrs[ARGUS_MAC_INDEX] = NULL;
-                              ns1->dsrindex &= ~(0x01 << i);
-                           }
-                        }
-                        break;
-                     }
+   if (g1 && g2) {
 
-// Merging vlan and mpls tags needs a bit of work.
+   } else {
+      if (g2 && (g1 == NULL)) {
+         ns1->dsrs[ARGUS_GEO_INDEX] = calloc(1, sizeof(struct ArgusGeoLocationStruct));
+         ns1->dsrindex |= (0x01 << ARGUS_GEO_INDEX);
 
-                     case ARGUS_VLAN_INDEX:
-                     case ARGUS_MPLS_INDEX: {
-                        break;
-                     }
+         g1 = (void *) ns1->dsrs[ARGUS_GEO_INDEX];
+         bcopy(g2, g1, sizeof(*g2));
+      }
+   }
+}
 
-                     case ARGUS_ICMP_INDEX: {
-                        struct ArgusIcmpStruct *i1 = (struct ArgusIcmpStruct *) ns1->dsrs[ARGUS_ICMP_INDEX];
-                        struct ArgusIcmpStruct *i2 = (struct ArgusIcmpStruct *) ns2->dsrs[ARGUS_ICMP_INDEX];
+static void
+ArgusMergeLocalDSR (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                    struct ArgusRecordStruct *ns2, int i, struct ArgusMergeContext *mc)
+{
+   struct ArgusNetspatialStruct *l1 = (void *) ns1->dsrs[ARGUS_LOCAL_INDEX];
+   struct ArgusNetspatialStruct *l2 = (void *) ns2->dsrs[ARGUS_LOCAL_INDEX];
 
-                        if (i1 && i2) {
-                           if ((i1->hdr.argus_dsrvl8.qual & ARGUS_ICMP_MAPPED) &&
-                               (i2->hdr.argus_dsrvl8.qual & ARGUS_ICMP_MAPPED)) {
-                              struct ArgusFlow *flow = (void *)ns1->dsrs[ARGUS_FLOW_INDEX];
-                              int type = 0;
+   if (l1 && l2) {
+      if (l1->sloc > l2->sloc) l1->sloc = l2->sloc;
+      if (l1->dloc > l2->dloc) l1->dloc = l2->dloc;
 
-                              if (flow != NULL) {
-                                 switch (flow->hdr.subtype & 0x3F) {
-                                    case ARGUS_FLOW_CLASSIC5TUPLE:
-                                    case ARGUS_FLOW_LAYER_3_MATRIX: {
-                                       switch (type = (flow->hdr.argus_dsrvl8.qual & 0x1F)) {
-                                          case ARGUS_TYPE_IPV4: {
-                                             unsigned char masklen = 32;
-                                             ArgusMergeAddress(&i1->osrcaddr, &i2->osrcaddr, ARGUS_TYPE_IPV4, ARGUS_SRC, &masklen);
-                                             break;
-                                          }
+   } else {
+      if (l2 && (l1 == NULL)) {
+         ns1->dsrs[ARGUS_LOCAL_INDEX] = calloc(1, sizeof(struct ArgusNetspatialStruct));
+         ns1->dsrindex |= (0x01 << ARGUS_LOCAL_INDEX);
 
-                                          case ARGUS_TYPE_IPV6:
-                                             break;
-                                       }
-                                       break;
-                                    }
-                                 }
-                              }
-                           }
-                        }
+         l1 = (void *) ns1->dsrs[ARGUS_LOCAL_INDEX];
+         bcopy(l2, l1, sizeof(*l2));
+      }
+   }
+}
 
-                        if (!i1 && i2) {
-                           int len = i2->hdr.argus_dsrvl8.len;
+// Merging vlan and mpls tags needs a bit of work, and the time
+// adjustment, flow hash and tunnel DSRs are left as they are.
+
+static const ArgusMergeDSRRoutine ArgusMergeDSRRoutines[ARGUSMAXDSRTYPE] = {
+   ArgusMergeTransportDSR,     /* ARGUS_TRANSPORT_INDEX */
+   ArgusMergeFlowDSR,          /* ARGUS_FLOW_INDEX */
+   ArgusMergeTimeDSR,          /* ARGUS_TIME_INDEX */
+   ArgusMergeMetricDSR,        /* ARGUS_METRIC_INDEX */
+   ArgusMergeAgrDSR,           /* ARGUS_AGR_INDEX */
+   ArgusMergeNetworkDSR,       /* ARGUS_NETWORK_INDEX */
+   NULL,                       /* ARGUS_VLAN_INDEX */
+   NULL,                       /* ARGUS_MPLS_INDEX */
+   ArgusMergeJitterDSR,        /* ARGUS_JITTER_INDEX */
+   ArgusMergeIPAttrDSR,        /* ARGUS_IPATTR_INDEX */
+   ArgusMergePsizeDSR,         /* ARGUS_PSIZE_INDEX */
+   ArgusMergeUserDataDSR,      /* ARGUS_SRCUSERDATA_INDEX */
+   ArgusMergeUserDataDSR,      /* ARGUS_DSTUSERDATA_INDEX */
+   ArgusMergeMacDSR,           /* ARGUS_MAC_INDEX */
+   ArgusMergeIcmpDSR,          /* ARGUS_ICMP_INDEX */
+   ArgusMergeEncapsDSR,        /* ARGUS_ENCAPS_INDEX */
+   NULL,                       /* ARGUS_TIME_ADJ_INDEX */
+   ArgusMergeBehaviorDSR,      /* ARGUS_BEHAVIOR_INDEX */
+   NULL,                       /* ARGUS_COR_INDEX */
+   ArgusMergeCocodeDSR,        /* ARGUS_COCODE_INDEX */
+   ArgusMergeLabelDSR,         /* ARGUS_LABEL_INDEX */
+   NULL,                       /* ARGUS_ASN_INDEX */
+   ArgusMergeGeoDSR,           /* ARGUS_GEO_INDEX */
+   ArgusMergeLocalDSR,         /* ARGUS_LOCAL_INDEX */
+   NULL,                       /* ARGUS_FLOW_HASH_INDEX */
+   NULL,                       /* ARGUS_VXLAN_INDEX */
+   NULL,                       /* ARGUS_GRE_INDEX */
+   NULL,                       /* ARGUS_GENEVE_INDEX */
+   ArgusMergeScoreDSR,         /* ARGUS_SCORE_INDEX */
+};
 
-                           if (len > 0) {
-                              if ((i1 = ArgusCalloc(1, len * 4)) == NULL)
-                                 ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
-                              bcopy ((char *)i2, (char *)i1, len * 4);
+/*
+ * The transport and mac DSRs are removed from ns1 and its aggregation
+ * object is updated, when ns2 doesn't have them, so they always run.
+ */
 
-                              ns1->dsrs[ARGUS_ICMP_INDEX] = (struct ArgusDSRHeader *) i1;
-                              ns1->dsrindex |= (0x01 << ARGUS_ICMP_INDEX);
-                           }
-                        }
-                        break;
-                     }
+#define ARGUS_MERGE_NS1_DSRS     ((0x01 << ARGUS_TRANSPORT_INDEX) | (0x01 << ARGUS_AGR_INDEX) | (0x01 << ARGUS_MAC_INDEX))
 
-                     case ARGUS_COCODE_INDEX: {
-                        struct ArgusCountryCodeStruct *c1 = (void *) ns1->dsrs[ARGUS_COCODE_INDEX];
-                        struct ArgusCountryCodeStruct *c2 = (void *) ns2->dsrs[ARGUS_COCODE_INDEX];
-                        
-                        if (c1 && c2) {
-                           if (bcmp(c1->src, c2->src, sizeof(c1->src)))
-                              bzero(&c1->src, sizeof(c1->src));
-                           if (bcmp(c1->dst, c2->dst, sizeof(c1->dst)))
-                              bzero(&c1->dst, sizeof(c1->dst));
-                           
-                        } else
-                        if (c2) {
-                           int len = c2->hdr.argus_dsrvl8.len;
+#define ARGUS_MERGE_COMMON_DSRS  ((0x01 << ARGUS_TRANSPORT_INDEX) | (0x01 << ARGUS_FLOW_INDEX)   | \
+                                  (0x01 << ARGUS_TIME_INDEX)      | (0x01 << ARGUS_METRIC_INDEX) | \
+                                  (0x01 << ARGUS_AGR_INDEX)       | (0x01 << ARGUS_NETWORK_INDEX)| \
+                                  (0x01 << ARGUS_VLAN_INDEX)      | (0x01 << ARGUS_MPLS_INDEX)   | \
+                                  (0x01 << ARGUS_JITTER_INDEX)    | (0x01 << ARGUS_IPATTR_INDEX) | \
+                                  (0x01 << ARGUS_PSIZE_INDEX)     | (0x01 << ARGUS_MAC_INDEX))
 
-                           if (len > 0) {
-                              if ((c1 = ArgusCalloc(1, len * 4)) == NULL)
-                                 ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error %s", strerror(errno));
-                              bcopy ((char *)c2, (char *)c2, len * 4);
+static void
+ArgusMergeCommonDSRs (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                      struct ArgusRecordStruct *ns2, struct ArgusMergeContext *mc)
+{
+   unsigned int dsrs = ns2->dsrindex;
+
+   ArgusMergeTransportDSR (na, ns1, ns2, ARGUS_TRANSPORT_INDEX, mc);
+   if (dsrs & (0x01 << ARGUS_FLOW_INDEX))
+      ArgusMergeFlowDSR (na, ns1, ns2, ARGUS_FLOW_INDEX, mc);
+   if (dsrs & (0x01 << ARGUS_TIME_INDEX))
+      ArgusMergeTimeDSR (na, ns1, ns2, ARGUS_TIME_INDEX, mc);
+   if (dsrs & (0x01 << ARGUS_METRIC_INDEX))
+      ArgusMergeMetricDSR (na, ns1, ns2, ARGUS_METRIC_INDEX, mc);
+   ArgusMergeAgrDSR (na, ns1, ns2, ARGUS_AGR_INDEX, mc);
+   if (dsrs & (0x01 << ARGUS_NETWORK_INDEX))
+      ArgusMergeNetworkDSR (na, ns1, ns2, ARGUS_NETWORK_INDEX, mc);
+   if (dsrs & (0x01 << ARGUS_JITTER_INDEX))
+      ArgusMergeJitterDSR (na, ns1, ns2, ARGUS_JITTER_INDEX, mc);
+   if (dsrs & (0x01 << ARGUS_IPATTR_INDEX))
+      ArgusMergeIPAttrDSR (na, ns1, ns2, ARGUS_IPATTR_INDEX, mc);
+   if (dsrs & (0x01 << ARGUS_PSIZE_INDEX))
+      ArgusMergePsizeDSR (na, ns1, ns2, ARGUS_PSIZE_INDEX, mc);
+   ArgusMergeMacDSR (na, ns1, ns2, ARGUS_MAC_INDEX, mc);
+}
 
-                              ns1->dsrs[ARGUS_COCODE_INDEX] = (struct ArgusDSRHeader *) c1;
-                              ns1->dsrindex |= (0x01 << ARGUS_COCODE_INDEX);
-                           }
-                        }
-                        break;
-                     }
+static void
+ArgusMergeDSRs (const struct ArgusAggregatorStruct * const na, struct ArgusRecordStruct *ns1,
+                struct ArgusRecordStruct *ns2, struct ArgusMergeContext *mc)
+{
+   unsigned int dsrs = ns2->dsrindex | ARGUS_MERGE_NS1_DSRS;
+   int i;
 
-                     case ARGUS_LABEL_INDEX: {
-                        struct ArgusLabelStruct *l1 = (void *) ns1->dsrs[ARGUS_LABEL_INDEX];
-                        struct ArgusLabelStruct *l2 = (void *) ns2->dsrs[ARGUS_LABEL_INDEX];
-
-                        if (l1 && l2) {
-                           if ((l1->l_un.label != NULL) && (l2->l_un.label != NULL)) {
-                              if (strcmp(l1->l_un.label, l2->l_un.label)) {
-                                 char *buf = calloc(1, MAXBUFFERLEN);
-                                 int len;
-
-                                 if ((ArgusMergeLabel(l1->l_un.label, l2->l_un.label, buf, MAXBUFFERLEN, ARGUS_UNION)) != NULL) {
-                                    free(l1->l_un.label);
-                                    l1->l_un.label = strdup(buf);
-                                    len = 1 + ((strlen(buf) + 3)/4);
-                                    l1->hdr.argus_dsrvl8.len  = len;
-                                 }
-                                 free(buf);
-                              }
-                           } else {
-                              if (l2->l_un.label != NULL) {
-                                 if (l1->l_un.label != NULL) free (l1->l_un.label);
-                                 l1->l_un.label = strdup(l2->l_un.label);
-                              }
-                           }
+   if (!(ArgusMergeFastPath))
+      dsrs = ~0;
 
-                        } else {
-                           if (l2 && (l1 == NULL)) {
-                              ns1->dsrs[ARGUS_LABEL_INDEX] = calloc(1, sizeof(struct ArgusLabelStruct));
-                              l1 = (void *) ns1->dsrs[ARGUS_LABEL_INDEX];
+   for (i = 0; (i < ARGUSMAXDSRTYPE) && dsrs; i++, dsrs >>= 1)
+      if ((dsrs & 0x01) && (ArgusMergeDSRRoutines[i] != NULL))
+         ArgusMergeDSRRoutines[i] (na, ns1, ns2, i, mc);
+}
 
-                              bcopy(l2, l1, sizeof(*l2));
-                              l1->l_un.label = NULL;
+void
+ArgusMergeRecords (const struct ArgusAggregatorStruct * const na,
+                   struct ArgusRecordStruct *ns1, struct ArgusRecordStruct *ns2)
+{
+   struct ArgusAgrStruct *agr = NULL;
+   double seconds;
 
-                              if (l2->l_un.label != NULL)
-                                 l1->l_un.label = strdup(l2->l_un.label);
-                           }
-                        }
-                        break;
-                     }
+   if (ns1 && ns2) {
+      if ((ns1->hdr.type & 0xF0) == (ns2->hdr.type & 0xF0)) {
+         switch (ns1->hdr.type & 0xF0) {
+            case ARGUS_MAR: {
+               struct ArgusMarStruct *man1 = (struct ArgusMarStruct *) &((struct ArgusRecord *) ns1->dsrs[0])->ar_un.mar;
+               struct ArgusMarStruct *man2 = (struct ArgusMarStruct *) &((struct ArgusRecord *) ns2->dsrs[0])->ar_un.mar;
 
-// Merging the behavioral dsr's currently involve accumulating the counters for keystrokes.
-// and taking the greatest of the scores.
+               if ((ns1->hdr.cause & 0xF0) == ARGUS_START) {
+               } else
+               if ((ns1->hdr.cause & 0xF0) == ARGUS_STATUS) {
+                  double stime1 = ArgusFetchStartuSecTime(ns1);
+                  double stime2 = ArgusFetchStartuSecTime(ns2);
+                  double ltime1 = ArgusFetchLastuSecTime(ns1);
+                  double ltime2 = ArgusFetchLastuSecTime(ns2);
 
-                     case ARGUS_BEHAVIOR_INDEX: {
-                        struct ArgusBehaviorStruct *a1 = (void *) ns1->dsrs[ARGUS_BEHAVIOR_INDEX];
-                        struct ArgusBehaviorStruct *a2 = (void *) ns2->dsrs[ARGUS_BEHAVIOR_INDEX];
-
-                        if (a1 && a2) {
-                           if (a1->hdr.subtype == a2->hdr.subtype) {
-                              switch (a1->hdr.subtype) {
-                                 case ARGUS_TCP_KEYSTROKE: 
-                                 case ARGUS_SSH_KEYSTROKE: 
-                                 case ARGUS_BEHAVIOR_KEYSTROKE: {
-                                    a1->keyStroke.src.n_strokes += a2->keyStroke.src.n_strokes;
-                                    a1->keyStroke.dst.n_strokes += a2->keyStroke.dst.n_strokes;
-                                    break;
-                                 }
-                              }
-                           }
+                  if ((stime2 < stime1) || (stime1 == 0)) {
+                     man1->startime          = man2->startime;
+                     man1->nextMrSequenceNum = man2->nextMrSequenceNum;
+                     man1->interfaceStatus   = man2->interfaceStatus;
+                     man1->drift             = man2->drift;
+                     man1->clients           = man2->clients;
+                  }
 
-                        } else {
-                           if (a2 && (a1 == NULL)) {
-                              ns1->dsrs[ARGUS_BEHAVIOR_INDEX] = calloc(1, sizeof(struct ArgusBehaviorStruct));
-                              ns1->dsrindex |= (0x01 << ARGUS_BEHAVIOR_INDEX);
+                  if ((ltime2 > ltime1) || (ltime1 == 0))
+                     man1->now = man2->now;
 
-                              a1 = (void *) ns1->dsrs[ARGUS_BEHAVIOR_INDEX];
-                              bcopy(a2, a1, sizeof(*a2));
-                           }
-                        }
-                        break;
-                     }
+                  man1->pktsRcvd  += man2->pktsRcvd;
+                  man1->bytesRcvd += man2->bytesRcvd;
+                  man1->drift      = man2->drift;
+                  man1->records   += man2->records;
+                  man1->queue      = man2->queue;
+                  man1->output    += man2->output;
+                  man1->flows     += man2->flows;
+                  man1->dropped   += man2->dropped;
+                  man1->bytes     += man2->bytes;
+                  man1->bufs       = man2->bufs;
+                  man1->suserlen   = man2->suserlen;
+                  man1->duserlen   = man2->duserlen;
 
-                     case ARGUS_SCORE_INDEX: {
-                        struct ArgusScoreStruct *s1 = (void *) ns1->dsrs[ARGUS_SCORE_INDEX];
-                        struct ArgusScoreStruct *s2 = (void *) ns2->dsrs[ARGUS_SCORE_INDEX];
-                        
-                        if (s1 || s2) {
-                           if (s1 && s2) {
-                              if (s1->hdr.subtype == s2->hdr.subtype) {
-                                 switch (s1->hdr.subtype) {
-                                    case ARGUS_BEHAVIOR_SCORE: {
-                                       int i;
-                                       for (i = 0; i < 8; i++) {
-                                          if (s2->behvScore.values[i] > s1->behvScore.values[i])
-                                             s1->behvScore.values[i] = s2->behvScore.values[i];
-                                       }
-                                    }
-                                 }
-                              }
-                           } else 
-                           if (!s1 && s2) {
-                              ns1->dsrs[ARGUS_SCORE_INDEX] = calloc(1, sizeof(struct ArgusScoreStruct));
-                              ns1->dsrindex |= (0x01 << ARGUS_SCORE_INDEX);
+                  man1->status |= ARGUS_RECORD_MODIFIED;
+               }
+               break;
+            }
 
-                              s1 = (void *) ns1->dsrs[ARGUS_SCORE_INDEX];
-                              bcopy(s2, s1, sizeof(*s2));
-                           }
-                        }
-                        break;
-                     }
+            case ARGUS_NETFLOW:
+            case ARGUS_AFLOW:
+            case ARGUS_FAR: {
+               struct ArgusTimeObject *ns1time = (void *)ns1->dsrs[ARGUS_TIME_INDEX];
+               struct ArgusTimeObject *ns2time = (void *)ns2->dsrs[ARGUS_TIME_INDEX];
+               struct ArgusMetricStruct *ns1metric = (void *)ns1->dsrs[ARGUS_METRIC_INDEX];
+               struct ArgusMetricStruct *ns2metric = (void *)ns2->dsrs[ARGUS_METRIC_INDEX];
 
-                     case ARGUS_GEO_INDEX: {
-                        struct ArgusGeoLocationStruct *g1 = (void *) ns1->dsrs[ARGUS_GEO_INDEX];
-                        struct ArgusGeoLocationStruct *g2 = (void *) ns2->dsrs[ARGUS_GEO_INDEX];
+               double deltaSrcFlowTime = 0.0;
+               double deltaDstFlowTime = 0.0;
+               struct ArgusMergeContext mc;
 
-                        if (g1 && g2) {
+               if ((ns1time && ns2time) && (ns1metric && ns2metric)) {
+                  double senst1 = (ns1time->src.end.tv_sec * 1000000LL) + ns1time->src.end.tv_usec;
+                  double denst1 = (ns1time->dst.end.tv_sec * 1000000LL) + ns1time->dst.end.tv_usec;
 
-                        } else {
-                           if (g2 && (g1 == NULL)) {
-                              ns1->dsrs[ARGUS_GEO_INDEX] = calloc(1, sizeof(struct ArgusGeoLocationStruct));
-                              g1 = (void *) ns1->dsrs[ARGUS_GEO_INDEX];
-                              bcopy(g2, g1, sizeof(*g2));
-                           }
-                        }
-                        break;
+                  double ssnst2 = (ns2time->src.start.tv_sec * 1000000LL) + ns2time->src.start.tv_usec;
+                  double dsnst2 = (ns2time->dst.start.tv_sec * 1000000LL) + ns2time->dst.start.tv_usec;
+
+                  double slstime = (ns1->lastSrcStartTime.tv_sec * 1000000LL) + ns1->lastSrcStartTime.tv_usec;
+
+                  if (ns1metric->src.pkts && ns2metric->src.pkts) {
+                     if (slstime) {
+                     } else {
                      }
+                     deltaSrcFlowTime = fabs(ssnst2 - senst1)/1000000.0;
+                  }
+
+                  if (ns1metric->dst.pkts && ns2metric->dst.pkts) {
+                     deltaDstFlowTime = fabs(dsnst2 - denst1)/1000000.0;
+                  }
+               }
+
+               ns1->status &= ~ARGUS_RECORD_WRITTEN; 
+           
+               if ((agr = (struct ArgusAgrStruct *) ns1->dsrs[ARGUS_AGR_INDEX]) == NULL) {
+                  struct ArgusMetricStruct *metric = (void *)ns1->dsrs[ARGUS_METRIC_INDEX];
+                  if ((metric != NULL) && ((metric->src.pkts + metric->dst.pkts) > 0)) {
+                     double value = na->RaMetricFetchAlgorithm(ns1);
 
-                     case ARGUS_LOCAL_INDEX: {
-                        struct ArgusNetspatialStruct *l1 = (void *) ns1->dsrs[ARGUS_LOCAL_INDEX];
-                        struct ArgusNetspatialStruct *l2 = (void *) ns2->dsrs[ARGUS_LOCAL_INDEX];
+                     if ((agr = ArgusCalloc(1, sizeof(*agr))) == NULL)
+                        ArgusLog (LOG_ERR, "ArgusMergeRecords: ArgusCalloc error: %s", strerror(errno));
 
-                        if (l1 && l2) {
-                           if (l1->sloc > l2->sloc) l1->sloc = l2->sloc;
-                           if (l1->dloc > l2->dloc) l1->dloc = l2->dloc;
+                     agr->hdr.type              = ARGUS_AGR_DSR;
+                     agr->hdr.subtype           = na->ArgusMetricIndex;
+                     agr->hdr.argus_dsrvl8.qual = 0x01;
+                     agr->hdr.argus_dsrvl8.len  = (sizeof(*agr) + 3)/4;
+                     agr->count                 = 1;
+                     agr->act.maxval            = value;
+                     agr->act.minval            = value;
+                     agr->act.meanval           = value;
+                     agr->act.n                 = 1;
+                     bzero ((char *)&agr->idle, sizeof(agr->idle));
+                     agr->idle.minval           = 1000000000.0;
 
-                        } else {
-                           if (l2 && (l1 == NULL)) {
-                              ns1->dsrs[ARGUS_LOCAL_INDEX] = calloc(1, sizeof(struct ArgusNetspatialStruct));
-                              l1 = (void *) ns1->dsrs[ARGUS_LOCAL_INDEX];
-                              bcopy(l2, l1, sizeof(*l2));
-                           }
-                        }
-                        break;
-                     }
+                     ns1->dsrs[ARGUS_AGR_INDEX] = (struct ArgusDSRHeader *) agr;
+                     ns1->dsrindex |= (0x01 << ARGUS_AGR_INDEX);
                   }
                }
 
+               mc.deltaSrcFlowTime = deltaSrcFlowTime;
+               mc.deltaDstFlowTime = deltaDstFlowTime;
+
+               if (ArgusMergeFastPath && !(ns2->dsrindex & ~ARGUS_MERGE_COMMON_DSRS))
+                  ArgusMergeCommonDSRs (na, ns1, ns2, &mc);
+               else
+                  ArgusMergeDSRs (na, ns1, ns2, &mc);
+
                if ((seconds = RaGetFloatDuration(ns1)) > 0) {
                   struct ArgusMetricStruct *metric = (void *)ns1->dsrs[ARGUS_METRIC_INDEX];
                   if (metric != NULL) {
@@ -10090,10 +10375,7 @@ ArgusInsertRecord (struct ArgusParserStruct *parser, struct RaBinProcessStruct *
                if (agg->grepstr) {
                   struct ArgusLabelStruct *label;
                   if (((label = (void *)argus->dsrs[ARGUS_LABEL_INDEX]) != NULL)) {
-                     if (regexec(&agg->lpreg, label->l_un.label, 0, NULL, 0))
-                        lretn = 0;
-                     else
-                        lretn = 1;
+                     lretn = ArgusGrepLabel(agg->grepmatcher, &agg->lpreg, label->l_un.label);
                   } else
                      lretn = 0;
                }
@@ -10423,6 +10705,8 @@ ArgusInitAggregatorStructs(struct ArgusAggregatorStruct *nag)
    struct ArgusFlow flowbuf, *flow = &flowbuf;
    int i;
 
+   ArgusKeyGeneration++;
+
    for (i = 0; i < ARGUS_MAX_MASK_LIST; i++) {
       switch (i) {
          case ARGUS_MASK_PROTO:
@@ -10870,6 +11154,7 @@ ArgusCopyAggregator (struct ArgusAggregatorStruct *agg)
       if (agg->argus != NULL) tagg->argus = NULL;
 
       bzero(&agg->hstruct, sizeof(agg->hstruct));
+      tagg->kcache = NULL;
 
       if (agg->drap != NULL) {
          if ((tagg->drap = (void *) ArgusCalloc (1, sizeof(*tagg->drap))) == NULL)
@@ -10983,9 +11268,15 @@ ArgusDeleteAggregator (struct ArgusParserStruct *parser, struct ArgusAggregatorS
    if (agg->hstruct.buf != NULL)
       ArgusFree(agg->hstruct.buf);
 
+   if (agg->kcache != NULL)
+      ArgusFree(agg->kcache);
+
    if (agg->drap != NULL)
       ArgusFree(agg->drap);
 
+   if (agg->grepmatcher != NULL)
+      ArgusDeleteGrepMatcher(agg->grepmatcher);
+
    if (agg->queue && agg->queue->count) {
       switch (agg->status & ( ARGUS_RECORD_AGGREGATOR | ARGUS_OBJ_AGGREGATOR)) {
          default:
@@ -11317,6 +11608,9 @@ ArgusParseAggregator (struct ArgusParserStruct *parser, char *file, char *buf[])
                   if (regerror(rege, &parser->lpreg, errbuf, MAXSTRLEN))
                      ArgusLog (LOG_ERR, "ArgusProcessLabelOption: grep regex error %s", errbuf);
                }
+
+               if ((agg->grepmatcher = ArgusNewGrepMatcher(parser->iflag)) != NULL)
+                  ArgusGrepMatcherAdd(agg->grepmatcher, grep);
             }
 
             if (status) {
@@ -204,6 +204,74 @@ ArgusFilterRecord (struct nff_insn *pc, struct ArgusRecordStruct *argus)
       return -1;
 }
 
+/*
+ * Return the mask of dsrs[] indexes that the filter program reads, with
+ * ARGUS_FILTER_HDR set if it reads the record header.  Loads of other
+ * ArgusRecordStruct fields, and abs, indirect and length loads, can
+ * depend on the whole record, so those programs return
+ * ARGUS_FILTER_ALL_DSRS.
+ */
+
+unsigned int
+ArgusFilterDSRs (struct nff_program *prog)
+{
+   struct ArgusRecordStruct argus;
+   int hdroff = ((char *)&argus.hdr - (char *)&argus);
+   unsigned int retn = 0;
+   int i;
+
+   if ((prog == NULL) || (prog->bf_insns == NULL))
+      return (ARGUS_FILTER_ALL_DSRS);
+
+   for (i = 0; i < prog->bf_len; i++) {
+      struct nff_insn *pc = &prog->bf_insns[i];
+
+      switch (NFF_CLASS(pc->code)) {
+         case NFF_LD:
+         case NFF_LDX: {
+            switch (NFF_MODE(pc->code)) {
+               case NFF_IMM:
+               case NFF_MEM:
+                  break;
+
+               case NFF_DSR: {
+                  int size;
+
+                  if ((pc->dsr >= 0) && (pc->dsr < 31)) {
+                     retn |= (0x01 << pc->dsr);
+                     break;
+                  }
+                  if (pc->dsr >= 0)
+                     return (ARGUS_FILTER_ALL_DSRS);
+
+                  switch (pc->code & (NFF_H | NFF_B | NFF_L | NFF_D | NFF_F)) {
+                     case NFF_B: size = 1; break;
+                     case NFF_H: size = 2; break;
+                     case NFF_L:
+                     case NFF_D: size = 8; break;
+                     default:    size = 4; break;
+                  }
+                  if ((pc->data.k < hdroff) || ((pc->data.k + size) > (hdroff + sizeof(struct ArgusRecordHeader))))
+                     return (ARGUS_FILTER_ALL_DSRS);
+
+                  retn |= ARGUS_FILTER_HDR;
+                  break;
+               }
+
+               default:
+                  return (ARGUS_FILTER_ALL_DSRS);
+            }
+            break;
+         }
+      }
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (4, "ArgusFilterDSRs (%p) returning 0x%x\n", prog, retn);
+#endif
+   return (retn);
+}
+
 static int
 floatisequal(double F, double f)
 {
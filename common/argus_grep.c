@@ -37,6 +37,7 @@
 #endif
 
 #include <unistd.h>
+#include <ctype.h>
 #include <sys/types.h>
 
 #include <argus_compat.h>
@@ -49,8 +50,6 @@
 #include <argus_filter.h>
 #include <argus_grep.h>
 
-int ArgusGrepBuf (regex_t *, char *, char *);
-
 void
 ArgusInitializeGrep (struct ArgusParserStruct *parser)
 {
@@ -76,6 +75,11 @@ ArgusInitializeGrep (struct ArgusParserStruct *parser)
                ArgusLog (LOG_ERR, "ArgusProcessLabelOption: user data regex error %s", errbuf);
          }
 
+         if (parser->ArgusGrepMatcher == NULL)
+            if ((parser->ArgusGrepMatcher = ArgusNewGrepMatcher(parser->iflag)) == NULL)
+               ArgusLog (LOG_ERR, "ArgusInitializeGrep: ArgusNewGrepMatcher error %s", strerror(errno));
+
+         ArgusGrepMatcherAdd (parser->ArgusGrepMatcher, parser->estr);
          parser->ArgusRegExItems++;
 
       } else
@@ -125,7 +129,7 @@ int
 ArgusGrepUserData (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
 {
    struct ArgusDataStruct *user = NULL;
-   int i, len, retn = 0, found = 0;
+   int len, retn = 0, found = 0;
 
    if (parser->ArgusGrepSource) {
       if ((user = (struct ArgusDataStruct *)argus->dsrs[ARGUS_SRCUSERDATA_INDEX]) !=  NULL) {
@@ -135,12 +139,8 @@ ArgusGrepUserData (struct ArgusParserStruct *parser, struct ArgusRecordStruct *a
          } else 
             len = (user->hdr.argus_dsrvl8.len - 2 ) * 4;
 
-         for (i = 0; i < parser->ArgusRegExItems; i++) {
-            if ((retn = ArgusGrepBuf (&parser->upreg[i], buf, &buf[len]))) {
-               found++;
-               break;
-            }
-         }
+         if ((retn = ArgusGrepMatch (parser->ArgusGrepMatcher, parser->upreg, buf, &buf[len])))
+            found++;
       }
    }
 
@@ -152,13 +152,462 @@ ArgusGrepUserData (struct ArgusParserStruct *parser, struct ArgusRecordStruct *a
          } else
             len = (user->hdr.argus_dsrvl8.len - 2 ) * 4;
 
-         for (i = 0; !found && i < parser->ArgusRegExItems; i++) {
-            if ((retn = ArgusGrepBuf (&parser->upreg[i], buf, &buf[len])))
-               found = 1;
-         }
+         if (!found && (retn = ArgusGrepMatch (parser->ArgusGrepMatcher, parser->upreg, buf, &buf[len])))
+            found = 1;
       }
    }
 
    retn = (parser->vflag) ? (found ? 0 : 1) : found;
    return (retn);
 }
+
+
+/*
+ * Multi-pattern matching.
+ *
+ * ArgusGrepLiterals() finds, for each top level alternative of an
+ * extended regular expression, the longest run of literal characters
+ * that every match has to contain.  Anything it isn't sure of, groups,
+ * bracket expressions, escapes other than an escaped metacharacter,
+ * like \w, \x41 or the \< and \' anchors, and atoms that a quantifier
+ * makes optional, just ends the current run, so a pattern only gets
+ * literals that are really required.  If any alternative
+ * has none, the pattern is marked to always be run.
+ *
+ * The literals of all the patterns go into an Aho-Corasick automaton.
+ * ArgusGrepMatch() runs it over the buffer once, and when a literal is
+ * found, confirms its pattern with ArgusGrepBuf(), so the result is
+ * the same as running every regex over the buffer.
+ */
+
+#define ARGUS_GREP_MAXBRANCH	64
+
+static char *
+ArgusGrepSkipBracket (char *p)
+{
+   char *q = p + 1;
+
+   if (*q == '^') q++;
+   if (*q == ']') q++;
+
+   while (*q && (*q != ']')) {
+      if ((q[0] == '[') && ((q[1] == ':') || (q[1] == '.') || (q[1] == '='))) {
+         char *r, term[3] = { q[1], ']', '\0' };
+         if ((r = strstr(q + 2, term)) == NULL)
+            return (NULL);
+         q = r + 2;
+         continue;
+      }
+#if defined(ARGUS_PCRE)
+      if ((q[0] == '\\') && q[1])
+         q++;
+#endif
+      q++;
+   }
+   return ((*q == ']') ? q + 1 : NULL);
+}
+
+static char *
+ArgusGrepSkipGroup (char *p)
+{
+   int depth = 0;
+
+   while (p && *p) {
+      switch (*p) {
+         case '\\':
+            if (p[1]) p++;
+            break;
+         case '[':
+            if ((p = ArgusGrepSkipBracket(p)) == NULL)
+               return (NULL);
+            continue;
+         case '(':
+            depth++;
+            break;
+         case ')':
+            if (--depth == 0)
+               return (p + 1);
+            break;
+      }
+      p++;
+   }
+   return (NULL);
+}
+
+/*
+ * Fill buf with the literal for each alternative, and their offsets
+ * and lengths.  buf needs twice the length of the pattern.  Returns the
+ * number of alternatives, or 0 if the pattern has to always be run.
+ */
+
+static int
+ArgusGrepLiterals (char *pattern, int icase, char *buf, int *off, int *len)
+{
+   char *p = pattern, *run = buf + strlen(pattern) + 1;
+   int branches = 0, rlen = 0, blen = 0, used = 0;
+
+   if (strstr(pattern, "(?") != NULL)
+      return (0);
+
+   for (;;) {
+      int c = -1;
+
+      switch (*p) {
+         case '\0':
+         case '|':
+            if (rlen > blen) {
+               bcopy (run, &buf[used], rlen);
+               blen = rlen;
+            }
+            if ((blen == 0) || (branches == ARGUS_GREP_MAXBRANCH))
+               return (0);
+
+            off[branches] = used;
+            len[branches] = blen;
+            branches++;
+            used += blen;
+            rlen = blen = 0;
+
+            if (*p++ == '\0')
+               return (branches);
+            continue;
+
+         case '(':
+            if ((p = ArgusGrepSkipGroup(p)) == NULL)
+               return (0);
+            break;
+
+         case '[':
+            if ((p = ArgusGrepSkipBracket(p)) == NULL)
+               return (0);
+            break;
+
+         case '\\':
+            if (p[1] == '\0')
+               return (0);
+            if (strchr(".[]()*+?{}|^$\\", p[1]) != NULL) {
+               c = (unsigned char) p[1];
+               p += 2;
+            } else
+            if (p[1] == 'c') {
+               p += (p[2] != '\0') ? 3 : 2;
+            } else
+            if (strchr("xopPNgkuU0123456789", p[1]) != NULL) {
+               p += 2;
+               if (*p == '{') {
+                  if ((p = strchr(p, '}')) == NULL)
+                     return (0);
+                  p++;
+               } else
+                  while (isalnum((unsigned char)*p)) p++;
+            } else
+               p += 2;
+            break;
+
+         case '.': case '^': case '$': case ')':
+         case '*': case '+': case '?': case '{':
+            p++;
+            break;
+
+         default:
+            c = (unsigned char) *p++;
+            break;
+      }
+
+      switch (*p) {
+         case '*':
+         case '?':
+            c = -1;
+            break;
+         case '{':
+            c = -1;
+            if ((p = strchr(p, '}')) == NULL)
+               return (0);
+            p++;
+            break;
+         case '+':
+            if (c >= 0)
+               run[rlen++] = icase ? tolower(c) : c;
+            c = -1;
+            p++;
+            break;
+      }
+
+      if (c >= 0)
+         run[rlen++] = icase ? tolower(c) : c;
+      else {
+         if (rlen > blen) {
+            bcopy (run, &buf[used], rlen);
+            blen = rlen;
+         }
+         rlen = 0;
+      }
+   }
+}
+
+struct ArgusGrepMatcherStruct *
+ArgusNewGrepMatcher (int icase)
+{
+   struct ArgusGrepMatcherStruct *matcher = NULL;
+
+   if ((matcher = ArgusCalloc(1, sizeof(*matcher))) != NULL) {
+      matcher->icase = icase;
+      if ((matcher->node = ArgusCalloc(256, sizeof(*matcher->node))) == NULL) {
+         ArgusFree(matcher);
+         return (NULL);
+      }
+      matcher->nsize = 256;
+      matcher->nodes = 1;
+      matcher->node[0].hits = -1;
+   }
+   return (matcher);
+}
+
+void
+ArgusDeleteGrepMatcher (struct ArgusGrepMatcherStruct *matcher)
+{
+   if (matcher != NULL) {
+      if (matcher->node != NULL) ArgusFree(matcher->node);
+      if (matcher->hit != NULL) ArgusFree(matcher->hit);
+      if (matcher->always != NULL) ArgusFree(matcher->always);
+      if (matcher->stamp != NULL) ArgusFree(matcher->stamp);
+      ArgusFree(matcher);
+   }
+}
+
+static int
+ArgusGrepChild (struct ArgusGrepMatcherStruct *matcher, int state, int c)
+{
+   int child;
+
+   if (state == 0)
+      return (matcher->root[c]);
+
+   for (child = matcher->node[state].child; child; child = matcher->node[child].sibling)
+      if (matcher->node[child].ch == c)
+         break;
+   return (child);
+}
+
+static void
+ArgusGrepAddLiteral (struct ArgusGrepMatcherStruct *matcher, int pattern, char *str, int len)
+{
+   struct ArgusGrepHitStruct *hit;
+   int i, state = 0;
+
+   for (i = 0; i < len; i++) {
+      int c = (unsigned char) str[i], next;
+
+      if ((next = ArgusGrepChild(matcher, state, c)) == 0) {
+         struct ArgusGrepNodeStruct *node;
+
+         if (matcher->nodes == matcher->nsize) {
+            if ((node = ArgusCalloc(matcher->nsize * 2, sizeof(*node))) == NULL)
+               ArgusLog (LOG_ERR, "ArgusGrepAddLiteral: ArgusCalloc error %s", strerror(errno));
+            bcopy (matcher->node, node, matcher->nodes * sizeof(*node));
+            ArgusFree(matcher->node);
+            matcher->node = node;
+            matcher->nsize *= 2;
+         }
+
+         next = matcher->nodes++;
+         node = &matcher->node[next];
+         node->ch = c;
+         node->hits = -1;
+
+         if (state == 0)
+            matcher->root[c] = next;
+         else {
+            node->sibling = matcher->node[state].child;
+            matcher->node[state].child = next;
+         }
+      }
+      state = next;
+   }
+
+   if (matcher->hits == matcher->hsize) {
+      int size = matcher->hsize ? matcher->hsize * 2 : 64;
+
+      if ((hit = ArgusCalloc(size, sizeof(*hit))) == NULL)
+         ArgusLog (LOG_ERR, "ArgusGrepAddLiteral: ArgusCalloc error %s", strerror(errno));
+      if (matcher->hit != NULL) {
+         bcopy (matcher->hit, hit, matcher->hits * sizeof(*hit));
+         ArgusFree(matcher->hit);
+      }
+      matcher->hit = hit;
+      matcher->hsize = size;
+   }
+
+   hit = &matcher->hit[matcher->hits];
+   hit->pattern = pattern;
+   hit->nxt = matcher->node[state].hits;
+   matcher->node[state].hits = matcher->hits++;
+}
+
+/*
+ * Add the next pattern, which is the regex_t with the same index in
+ * the array passed to ArgusGrepMatch().  Returns the number of literals
+ * the pattern was given, 0 meaning it is always run.
+ */
+
+int
+ArgusGrepMatcherAdd (struct ArgusGrepMatcherStruct *matcher, char *pattern)
+{
+   int off[ARGUS_GREP_MAXBRANCH], len[ARGUS_GREP_MAXBRANCH];
+   int i, retn = 0, pattern_index;
+   char *buf;
+
+   if (matcher->patterns == matcher->psize) {
+      int size = matcher->psize ? matcher->psize * 2 : 16;
+      unsigned char *always;
+      unsigned int *stamp;
+
+      if ((always = ArgusCalloc(size, sizeof(*always))) == NULL)
+         ArgusLog (LOG_ERR, "ArgusGrepMatcherAdd: ArgusCalloc error %s", strerror(errno));
+      if ((stamp = ArgusCalloc(size, sizeof(*stamp))) == NULL)
+         ArgusLog (LOG_ERR, "ArgusGrepMatcherAdd: ArgusCalloc error %s", strerror(errno));
+
+      if (matcher->always != NULL) {
+         bcopy (matcher->always, always, matcher->patterns * sizeof(*always));
+         ArgusFree(matcher->always);
+         ArgusFree(matcher->stamp);
+      }
+      matcher->always = always;
+      matcher->stamp = stamp;
+      matcher->psize = size;
+   }
+
+   pattern_index = matcher->patterns++;
+
+   if ((buf = ArgusMalloc((strlen(pattern) + 1) * 2)) == NULL)
+      ArgusLog (LOG_ERR, "ArgusGrepMatcherAdd: ArgusMalloc error %s", strerror(errno));
+
+   if ((retn = ArgusGrepLiterals(pattern, matcher->icase, buf, off, len)) > 0) {
+      for (i = 0; i < retn; i++)
+         ArgusGrepAddLiteral(matcher, pattern_index, &buf[off[i]], len[i]);
+   } else
+      matcher->always[pattern_index] = 1;
+
+   ArgusFree(buf);
+   matcher->compiled = 0;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (3, "ArgusGrepMatcherAdd(%p, '%s') pattern %d literals %d\n", matcher, pattern, pattern_index, retn);
+#endif
+   return (retn);
+}
+
+/* Set the failure and output links, breadth first from the root. */
+
+static void
+ArgusGrepCompile (struct ArgusGrepMatcherStruct *matcher)
+{
+   struct ArgusGrepNodeStruct *node = matcher->node;
+   int *queue, head = 0, tail = 0, c;
+
+   if ((queue = ArgusCalloc(matcher->nodes, sizeof(*queue))) == NULL)
+      ArgusLog (LOG_ERR, "ArgusGrepCompile: ArgusCalloc error %s", strerror(errno));
+
+   for (c = 0; c < 256; c++) {
+      int child;
+      if ((child = matcher->root[c]) != 0) {
+         node[child].fail = 0;
+         node[child].output = 0;
+         queue[tail++] = child;
+      }
+   }
+
+   while (head < tail) {
+      int state = queue[head++], child;
+
+      for (child = node[state].child; child; child = node[child].sibling) {
+         int fail = node[state].fail, next;
+
+         while (fail && ((next = ArgusGrepChild(matcher, fail, node[child].ch)) == 0))
+            fail = node[fail].fail;
+
+         if (fail == 0)
+            next = matcher->root[node[child].ch];
+
+         node[child].fail = (next != child) ? next : 0;
+         fail = node[child].fail;
+         node[child].output = (node[fail].hits >= 0) ? fail : node[fail].output;
+         queue[tail++] = child;
+      }
+   }
+
+   ArgusFree(queue);
+   matcher->compiled = 1;
+}
+
+/*
+ * Scan beg through lim once for the literals of all the patterns, and
+ * confirm each pattern that shows up with ArgusGrepBuf().  Patterns
+ * without literals are run last.  Returns 1 if any pattern matches.
+ */
+
+int
+ArgusGrepMatch (struct ArgusGrepMatcherStruct *matcher, regex_t *preg, char *beg, char *lim)
+{
+   unsigned char *p = (unsigned char *) beg, *end = (unsigned char *) lim;
+   struct ArgusGrepNodeStruct *node;
+   unsigned int gen;
+   int i, state = 0;
+
+   if ((matcher == NULL) || (matcher->patterns == 0))
+      return (0);
+
+   if (!matcher->compiled)
+      ArgusGrepCompile(matcher);
+
+   node = matcher->node;
+   if ((gen = ++matcher->generation) == 0) {
+      bzero (matcher->stamp, matcher->psize * sizeof(*matcher->stamp));
+      gen = ++matcher->generation;
+   }
+
+   if (matcher->hits > 0) {
+      for (; p < end; p++) {
+         int c = matcher->icase ? tolower(*p) : *p, next;
+
+         while (state && ((next = ArgusGrepChild(matcher, state, c)) == 0))
+            state = node[state].fail;
+         if (state == 0)
+            next = matcher->root[c];
+
+         if ((state = next) != 0) {
+            int out = (node[state].hits >= 0) ? state : node[state].output;
+
+            for (; out; out = node[out].output) {
+               int h;
+               for (h = node[out].hits; h >= 0; h = matcher->hit[h].nxt) {
+                  int pattern = matcher->hit[h].pattern;
+
+                  if (matcher->stamp[pattern] != gen) {
+                     matcher->stamp[pattern] = gen;
+                     if (ArgusGrepBuf(&preg[pattern], beg, lim))
+                        return (1);
+                  }
+               }
+            }
+         }
+      }
+   }
+
+   for (i = 0; i < matcher->patterns; i++)
+      if (matcher->always[i] && ArgusGrepBuf(&preg[i], beg, lim))
+         return (1);
+
+   return (0);
+}
+
+/* Match a single label regex, skipping regexec() if its literals are absent. */
+
+int
+ArgusGrepLabel (struct ArgusGrepMatcherStruct *matcher, regex_t *preg, char *label)
+{
+   if (matcher == NULL)
+      return (regexec(preg, label, 0, NULL, 0) == 0);
+
+   return (ArgusGrepMatch(matcher, preg, label, label + strlen(label)));
+}
@@ -33,6 +33,10 @@
  * $Change: 3226 $
  */
 
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #ifdef HAVE_CONFIG_H
 #include "argus_config.h"
 #endif
@@ -57,6 +61,10 @@
 
 #include <netinet/tcp.h>
 
+#if defined(MSG_WAITFORONE)
+#define ARGUS_DGRAM_BATCHING
+#endif
+
 #define Version1        1
 #define Version5        5
 #define Version6        6
@@ -84,20 +92,46 @@ struct ArgusRecord *ArgusNetFlowArgusRecord = (struct ArgusRecord *) ArgusNetFlo
 #define ARGUSCISCOTEMPLATEIPV4		0x04
 #define ARGUSCISCOTEMPLATEIPV6		0x06
 
+/*
+ * v9 templates are compiled, when they arrive, into a list of fields
+ * with their offset into the data record and the width of the value
+ * to extract, so that the data records are decoded without walking
+ * the raw template.  Exporters are hashed on (source address, source id)
+ * and their templates are kept in a small hash table keyed by template id,
+ * so only the templates an exporter actually uses take up space.
+ */
+
+#define ARGUS_CISCO_SOURCE_HASH		256
+#define ARGUS_CISCO_TEMPLATE_HASH	64
+
+struct ArgusCiscoFieldStruct {
+   u_int16_t type, length, offset, conv;
+};
+
 struct ArgusCiscoTemplateStruct {
+   struct ArgusCiscoTemplateStruct *nxt;
    struct timeval lasttime;
-   int status, length, count;
-   CiscoFlowTemplateFlowEntryV9_t **tHdr;
+   int id, status, length, count;
+   struct ArgusCiscoFieldStruct *fields;
 };
 
 struct ArgusCiscoSourceStruct {
    struct ArgusQueueHeader qhdr;
-   struct ArgusHashTableHdr htblbuf, *htblhdr;
+   struct ArgusCiscoSourceStruct *nxt;
    unsigned int srcid, saddr;
    struct timeval startime, lasttime;
-   struct ArgusCiscoTemplateStruct templates[0x10000];
+   struct ArgusCiscoTemplateStruct *cache;
+   struct ArgusCiscoTemplateStruct *templates[ARGUS_CISCO_TEMPLATE_HASH];
 };
 
+static struct ArgusCiscoSourceStruct *ArgusCiscoSourceTable[ARGUS_CISCO_SOURCE_HASH];
+static struct ArgusCiscoSourceStruct *ArgusCiscoLastSource = NULL;
+
+static struct ArgusCiscoSourceStruct *ArgusFindCiscoSource (struct ArgusParserStruct *, struct ArgusQueueStruct *, int);
+static struct ArgusCiscoTemplateStruct *ArgusFindCiscoTemplate (struct ArgusCiscoSourceStruct *, int);
+static void ArgusDeleteCiscoTemplate (struct ArgusCiscoSourceStruct *, int);
+static struct ArgusCiscoTemplateStruct *ArgusCompileCiscoTemplate (struct ArgusParserStruct *, CiscoFlowTemplateHeaderV9_t *);
+
 unsigned int ArgusFlowSeq = 0, ArgusCounter;
 unsigned int ArgusCiscoSrcId = 0;
 unsigned int ArgusCiscoSrcAddr = 0;
@@ -982,24 +1016,14 @@ typedef struct value {
 struct ArgusRecord *
 ArgusParseCiscoRecordV9Data (struct ArgusParserStruct *parser, struct ArgusInput *input, struct ArgusQueueStruct *tqueue, u_char *ptr, int *cnt)
 {
-   struct ArgusCiscoTemplateStruct *templates = NULL;
+   struct ArgusCiscoTemplateStruct *tmpl = NULL;
    struct ArgusCiscoSourceStruct *src;
    struct ArgusRecord *retn = NULL;
    int ArgusParsingIPv6 = 0;
 
    u_char *tptr = ptr;
 
-   if (tqueue != NULL) {
-      int i, cnt = tqueue->count;
-      for (i = 0; (i < cnt) && (templates == NULL); i++) {
-         src = (struct ArgusCiscoSourceStruct *)ArgusPopQueue (tqueue, ARGUS_LOCK);
-         if ((src->srcid == ArgusCiscoSrcId) && (src->saddr == ArgusCiscoSrcAddr))
-            templates = src->templates;
-         ArgusAddToQueue(tqueue, &src->qhdr, ARGUS_LOCK);
-      }
-   }
-
-   if (templates == NULL)
+   if ((src = ArgusFindCiscoSource (parser, tqueue, 0)) == NULL)
       return(retn);
 
 //  using the matching template, parse out a single record.  we need to update ptr and
@@ -1007,8 +1031,7 @@ ArgusParseCiscoRecordV9Data (struct ArgusParserStruct *parser, struct ArgusInput
 //  
    {
       CiscoFlowEntryV9_t *cflow = (CiscoFlowEntryV9_t *) tptr;
-      CiscoFlowTemplateHeaderV9_t *tHdr = NULL;
-      CiscoFlowTemplateFlowEntryV9_t *tData;
+      struct ArgusCiscoFieldStruct *tData;
       int flowset_id, length;
 
       flowset_id = ntohs(cflow->flowset_id);
@@ -1017,9 +1040,9 @@ ArgusParseCiscoRecordV9Data (struct ArgusParserStruct *parser, struct ArgusInput
       if (length) {
 #define ARGUS_TEMPLATE_TIMEOUT	1800
 
-         if ((tHdr = (CiscoFlowTemplateHeaderV9_t *) templates[flowset_id].tHdr) != NULL) {
-            if ((templates[flowset_id].lasttime.tv_sec + ARGUS_TEMPLATE_TIMEOUT) > parser->ArgusGlobalTime.tv_sec) {
-               int i, count = tHdr->count, nflowPad = 3;
+         if ((tmpl = ArgusFindCiscoTemplate (src, flowset_id)) != NULL) {
+            if ((tmpl->lasttime.tv_sec + ARGUS_TEMPLATE_TIMEOUT) > parser->ArgusGlobalTime.tv_sec) {
+               int i, count = tmpl->count, nflowPad = 3;
                struct ArgusRecordStruct *ns = &parser->argus;
                struct ArgusCanonRecord *canon = &parser->canon;
                u_char *sptr = (u_char *)(cflow + 1);
@@ -1027,28 +1050,28 @@ ArgusParseCiscoRecordV9Data (struct ArgusParserStruct *parser, struct ArgusInput
 
 // process an entire flow set
 
-               while ((*cnt > 0) && (sptr < (eptr - nflowPad))) {
+               while ((*cnt > 0) && (tmpl->length > 0) && (sptr < (eptr - nflowPad)) && ((sptr + tmpl->length) <= eptr)) {
                   struct ArgusRecord *argus = ArgusNetFlowArgusRecord;
                   struct ArgusDSRHeader *dsr = (struct ArgusDSRHeader *) &ArgusNetFlowArgusRecordBuf[4];
 
                   bzero(canon, sizeof(*canon));
                   bzero(ns, sizeof(*ns));
 
-                  tData = (CiscoFlowTemplateFlowEntryV9_t *)(tHdr + 1);
+                  tData = tmpl->fields;
 
                   for (i = 0; i < count; i++) {
+                     u_char *fptr = sptr + tData->offset;
                      value_t value;
 
                      bzero(&value, sizeof(value));
                      
-                     switch (tData->length) {
-                        case  1: value.val8[0] = *sptr; break;
-                        case  2: value.val16[0] = EXTRACT_16BITS(sptr); break;
-                        case  4: value.val32[0] = EXTRACT_32BITS(sptr); break;
-                        case  8: value.val64[0] = EXTRACT_64BITS(sptr); break;
-                        case 16: bcopy(sptr, &value.val128, 16); break;
+                     switch (tData->conv) {
+                        case  1: value.val8[0] = *fptr; break;
+                        case  2: value.val16[0] = EXTRACT_16BITS(fptr); break;
+                        case  4: value.val32[0] = EXTRACT_32BITS(fptr); break;
+                        case  8: value.val64[0] = EXTRACT_64BITS(fptr); break;
+                        case 16: bcopy(fptr, &value.val128, 16); break;
                      }
-                     sptr += tData->length;
 
                      switch (tData->type) {
                         case k_CiscoV9InBytes: {
@@ -1521,6 +1544,7 @@ ArgusParseCiscoRecordV9Data (struct ArgusParserStruct *parser, struct ArgusInput
                      }
                      tData++;
                   }
+                  sptr += tmpl->length;
 
                   {
                      struct timeval tdiffbuf, *tdiff = &tdiffbuf;
@@ -1698,7 +1722,7 @@ ArgusParseCiscoRecordV9Data (struct ArgusParserStruct *parser, struct ArgusInput
 #endif
                      ArgusHandleRecord (parser, input, argus, 0, &ArgusParser->ArgusFilterCode);
 #ifdef ARGUSDEBUG
-                     ArgusDebug (3, "ArgusParseCiscoRecordV9Data (%p, %p, %p, %p, %d) new flow\n", parser, input, templates, sptr, *cnt);
+                     ArgusDebug (3, "ArgusParseCiscoRecordV9Data (%p, %p, %p, %p, %d) new flow\n", parser, input, tmpl, sptr, *cnt);
 #endif
                   }
 
@@ -1707,13 +1731,8 @@ ArgusParseCiscoRecordV9Data (struct ArgusParserStruct *parser, struct ArgusInput
                }
                src->lasttime = parser->ArgusGlobalTime;
 
-            } else {
-               if (templates[flowset_id].tHdr != NULL) {
-                  ArgusFree(templates[flowset_id].tHdr);
-                  bzero(&templates[flowset_id], sizeof(struct ArgusCiscoTemplateStruct));
-                  templates[flowset_id].tHdr = NULL;
-               }
-            }
+            } else
+               ArgusDeleteCiscoTemplate (src, flowset_id);
          }
       }
    }
@@ -1732,40 +1751,17 @@ struct ArgusRecord *ArgusParseCiscoRecordV9OptionTemplate (struct ArgusParserStr
 struct ArgusRecord *
 ArgusParseCiscoRecordV9Template (struct ArgusParserStruct *parser, struct ArgusQueueStruct *tqueue, u_char *ptr, int len)
 {
-   struct ArgusCiscoTemplateStruct *templates = NULL;
+   struct ArgusCiscoTemplateStruct *tmpl = NULL;
    struct ArgusRecord *retn = NULL;
    struct ArgusCiscoSourceStruct *src;
-   int i, done = 0;
-
-   if (tqueue != NULL) {
-      int cnt = tqueue->count;
-      for (i = 0; (i < cnt) && (templates == NULL); i++) {
-         src = (struct ArgusCiscoSourceStruct *)ArgusPopQueue (tqueue, ARGUS_LOCK);
-         if ((src->srcid == ArgusCiscoSrcId) && (src->saddr == ArgusCiscoSrcAddr))
-            templates = src->templates;
-         ArgusAddToQueue(tqueue, &src->qhdr, ARGUS_LOCK);
-      }
-   }
+   int done = 0;
 
-   if (templates == NULL) {
-      if ((src = (struct ArgusCiscoSourceStruct *)ArgusCalloc (1, sizeof(*src))) == NULL)
-         ArgusLog(LOG_ERR, "ArgusParseCiscoRecordV9Template: ArgusCalloc(%d, %d) error %s\n", 1, sizeof(*src), strerror(errno));
-
-      src->srcid = ArgusCiscoSrcId;
-      src->saddr = ArgusCiscoSrcAddr;
-      src->startime = parser->ArgusGlobalTime;
-      src->lasttime = parser->ArgusGlobalTime;
-      templates = src->templates;
-      ArgusAddToQueue (tqueue, &src->qhdr, ARGUS_LOCK);
-   }
-
-   if (templates) {
+   if ((src = ArgusFindCiscoSource (parser, tqueue, 1)) != NULL) {
       while (!done) {
          CiscoFlowTemplateHeaderV9_t *tHdr = (CiscoFlowTemplateHeaderV9_t *) ptr;
          CiscoFlowTemplateFlowEntryV9_t *tData = (CiscoFlowTemplateFlowEntryV9_t *)(tHdr + 1);
-         CiscoFlowTemplateFlowEntryV9_t **dArray = NULL;
          short count = ntohs(tHdr->count);
-         int slen = 0, protocol = 0;
+         int slen = 0;
 
          slen = (sizeof(*tData) * count) + sizeof(*tHdr);
 
@@ -1775,43 +1771,16 @@ ArgusParseCiscoRecordV9Template (struct ArgusParserStruct *parser, struct ArgusQ
          tHdr->template_id = ntohs(tHdr->template_id);
          tHdr->count = count;
 
-         if (templates[tHdr->template_id].tHdr != NULL) {
-            ArgusFree(templates[tHdr->template_id].tHdr);
-            templates[tHdr->template_id].tHdr =  NULL;
-         }
-
-         if ((dArray = ArgusCalloc(1, slen)) == NULL)
-            ArgusLog(LOG_ERR, "ArgusCalloc(%d, %d) error %s\n", tHdr->count, sizeof(*tData), strerror(errno));
+         ArgusDeleteCiscoTemplate (src, tHdr->template_id);
 
-         for (i = 0; i < tHdr->count; i++) {
-            tData->type   = ntohs(tData->type);
-            tData->length = ntohs(tData->length);
-            switch (tData->type) {
-               case k_CiscoV9IpV4SrcAddr:
-               case k_CiscoV9IpV4DstAddr:
-                  protocol = 4;
-                  break;
-                  
-               case k_CiscoV9IpV6SrcAddr: 
-               case k_CiscoV9IpV6DstAddr: 
-               case k_CiscoV9IPV6SrcMask: 
-               case k_CiscoV9IpV6DstMask: 
-               case k_CiscoV9IpV6FlowLabel: 
-               case k_CiscoV9IpV6IcmpType: 
-               case k_CiscoV9IpV6MulIgmpType: 
-                  protocol = 6;
-                  break;
-            }
-            tData++;
+         if ((tmpl = ArgusCompileCiscoTemplate (parser, tHdr)) != NULL) {
+            int ind = tmpl->id % ARGUS_CISCO_TEMPLATE_HASH;
+            tmpl->nxt = src->templates[ind];
+            src->templates[ind] = tmpl;
          }
 
-         bcopy(tHdr, dArray, slen);
-         templates[tHdr->template_id].tHdr = dArray;
-         templates[tHdr->template_id].lasttime = parser->ArgusGlobalTime;
-         templates[tHdr->template_id].status = protocol;
-
 #ifdef ARGUSDEBUG
-         ArgusDebug (5, "ArgusParseCiscoRecordV9Template (%p, %p, %p, %d) tHdr template id %d len %d\n", parser, templates, ptr, len, tHdr->template_id, tHdr->count);
+         ArgusDebug (5, "ArgusParseCiscoRecordV9Template (%p, %p, %p, %d) tHdr template id %d len %d\n", parser, tmpl, ptr, len, tHdr->template_id, tHdr->count);
 #endif
          if ((len - slen) > (sizeof(*tData) + sizeof(*tHdr))) {
             ptr += slen;
@@ -1822,7 +1791,7 @@ ArgusParseCiscoRecordV9Template (struct ArgusParserStruct *parser, struct ArgusQ
    }
 
 #ifdef ARGUSDEBUG
-   ArgusDebug (5, "ArgusParseCiscoRecordV9Template (%p, %p, %p, %d) returning %p\n", parser, templates, ptr, len, retn);
+   ArgusDebug (5, "ArgusParseCiscoRecordV9Template (%p, %p, %p, %d) returning %p\n", parser, src, ptr, len, retn);
 #endif
    return(retn);
 }
@@ -1830,22 +1799,10 @@ ArgusParseCiscoRecordV9Template (struct ArgusParserStruct *parser, struct ArgusQ
 struct ArgusRecord *
 ArgusParseCiscoRecordV9OptionTemplate (struct ArgusParserStruct *parser, struct ArgusQueueStruct *tqueue, u_char *ptr, int len)
 {
-   struct ArgusCiscoTemplateStruct *templates = NULL;
    struct ArgusRecord *retn = NULL;
    struct ArgusCiscoSourceStruct *src;
-   int i;
 
-   if (tqueue != NULL) {
-      int cnt = tqueue->count;
-      for (i = 0; (i < cnt) && (templates == NULL); i++) {
-         src = (struct ArgusCiscoSourceStruct *)ArgusPopQueue (tqueue, ARGUS_LOCK);
-         if ((src->srcid == ArgusCiscoSrcId) && (src->saddr == ArgusCiscoSrcAddr))
-            templates = src->templates;
-         ArgusAddToQueue(tqueue, &src->qhdr, ARGUS_LOCK);
-      }
-   }
-
-   if (templates) {
+   if ((src = ArgusFindCiscoSource (parser, tqueue, 0)) != NULL) {
    }
 
 #ifdef ARGUSDEBUG
@@ -1856,6 +1813,144 @@ ArgusParseCiscoRecordV9OptionTemplate (struct ArgusParserStruct *parser, struct
 
 
 
+static struct ArgusCiscoSourceStruct *
+ArgusFindCiscoSource (struct ArgusParserStruct *parser, struct ArgusQueueStruct *tqueue, int create)
+{
+   struct ArgusCiscoSourceStruct *src = ArgusCiscoLastSource;
+   unsigned int ind;
+
+   if ((src != NULL) && (src->srcid == ArgusCiscoSrcId) && (src->saddr == ArgusCiscoSrcAddr))
+      return (src);
+
+   ind = (ArgusCiscoSrcAddr ^ (ArgusCiscoSrcAddr >> 16) ^ (ArgusCiscoSrcId * 2654435761U)) % ARGUS_CISCO_SOURCE_HASH;
+
+   for (src = ArgusCiscoSourceTable[ind]; src != NULL; src = src->nxt)
+      if ((src->srcid == ArgusCiscoSrcId) && (src->saddr == ArgusCiscoSrcAddr))
+         break;
+
+   if ((src == NULL) && create && (tqueue != NULL)) {
+      if ((src = (struct ArgusCiscoSourceStruct *)ArgusCalloc (1, sizeof(*src))) == NULL)
+         ArgusLog(LOG_ERR, "ArgusFindCiscoSource: ArgusCalloc(%d, %d) error %s\n", 1, sizeof(*src), strerror(errno));
+
+      src->srcid = ArgusCiscoSrcId;
+      src->saddr = ArgusCiscoSrcAddr;
+      src->startime = parser->ArgusGlobalTime;
+      src->lasttime = parser->ArgusGlobalTime;
+      src->nxt = ArgusCiscoSourceTable[ind];
+      ArgusCiscoSourceTable[ind] = src;
+      ArgusAddToQueue (tqueue, &src->qhdr, ARGUS_LOCK);
+   }
+
+   if (src != NULL)
+      ArgusCiscoLastSource = src;
+
+   return (src);
+}
+
+static struct ArgusCiscoTemplateStruct *
+ArgusFindCiscoTemplate (struct ArgusCiscoSourceStruct *src, int id)
+{
+   struct ArgusCiscoTemplateStruct *tmpl;
+
+   if (((tmpl = src->cache) != NULL) && (tmpl->id == id))
+      return (tmpl);
+
+   for (tmpl = src->templates[id % ARGUS_CISCO_TEMPLATE_HASH]; tmpl != NULL; tmpl = tmpl->nxt)
+      if (tmpl->id == id)
+         break;
+
+   if (tmpl != NULL)
+      src->cache = tmpl;
+
+   return (tmpl);
+}
+
+static void
+ArgusDeleteCiscoTemplate (struct ArgusCiscoSourceStruct *src, int id)
+{
+   struct ArgusCiscoTemplateStruct **prv = &src->templates[id % ARGUS_CISCO_TEMPLATE_HASH];
+   struct ArgusCiscoTemplateStruct *tmpl;
+
+   while ((tmpl = *prv) != NULL) {
+      if (tmpl->id == id) {
+         *prv = tmpl->nxt;
+         if (src->cache == tmpl)
+            src->cache = NULL;
+         if (tmpl->fields != NULL)
+            ArgusFree(tmpl->fields);
+         ArgusFree(tmpl);
+         break;
+      }
+      prv = &tmpl->nxt;
+   }
+}
+
+/*
+ * ArgusCompileCiscoTemplate - convert a template, whose header has already
+ * been converted to host order, into its decode plan.  The field offsets
+ * and the total record length are computed once here; fields whose width
+ * isn't one we extract keep their offset, but have no converter.
+ */
+
+static struct ArgusCiscoTemplateStruct *
+ArgusCompileCiscoTemplate (struct ArgusParserStruct *parser, CiscoFlowTemplateHeaderV9_t *tHdr)
+{
+   CiscoFlowTemplateFlowEntryV9_t *tData = (CiscoFlowTemplateFlowEntryV9_t *)(tHdr + 1);
+   struct ArgusCiscoTemplateStruct *tmpl = NULL;
+   int i, offset = 0, protocol = 0;
+
+   if ((tmpl = ArgusCalloc(1, sizeof(*tmpl))) == NULL)
+      ArgusLog(LOG_ERR, "ArgusCompileCiscoTemplate: ArgusCalloc error %s\n", strerror(errno));
+
+   if (tHdr->count > 0)
+      if ((tmpl->fields = ArgusCalloc(tHdr->count, sizeof(*tmpl->fields))) == NULL)
+         ArgusLog(LOG_ERR, "ArgusCompileCiscoTemplate: ArgusCalloc(%d, %d) error %s\n", tHdr->count, sizeof(*tmpl->fields), strerror(errno));
+
+   for (i = 0; i < tHdr->count; i++, tData++) {
+      struct ArgusCiscoFieldStruct *field = &tmpl->fields[i];
+
+      field->type   = ntohs(tData->type);
+      field->length = ntohs(tData->length);
+      field->offset = offset;
+
+      switch (field->length) {
+         case  1: case  2: case  4: case  8: case 16:
+            field->conv = field->length;
+            break;
+      }
+      offset += field->length;
+
+      switch (field->type) {
+         case k_CiscoV9IpV4SrcAddr:
+         case k_CiscoV9IpV4DstAddr:
+            protocol = 4;
+            break;
+            
+         case k_CiscoV9IpV6SrcAddr: 
+         case k_CiscoV9IpV6DstAddr: 
+         case k_CiscoV9IPV6SrcMask: 
+         case k_CiscoV9IpV6DstMask: 
+         case k_CiscoV9IpV6FlowLabel: 
+         case k_CiscoV9IpV6IcmpType: 
+         case k_CiscoV9IpV6MulIgmpType: 
+            protocol = 6;
+            break;
+      }
+   }
+
+   tmpl->id       = tHdr->template_id;
+   tmpl->count    = tHdr->count;
+   tmpl->length   = offset;
+   tmpl->status   = protocol;
+   tmpl->lasttime = parser->ArgusGlobalTime;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (6, "ArgusCompileCiscoTemplate (%p, %p) template %d fields %d length %d\n", parser, tHdr, tmpl->id, tmpl->count, tmpl->length);
+#endif
+   return (tmpl);
+}
+
+
 struct ArgusRecord *
 ArgusParseCiscoRecordV9 (struct ArgusParserStruct *parser, struct ArgusInput *input, u_char **ptr, int *count)
 {
@@ -2587,6 +2682,7 @@ static void SFDecodeIPLayer4(SFSample *, u_char *);
 #define ARGUS_TRUE   1
 
 int ArgusProcessSflowDatagram (struct ArgusParserStruct *, struct ArgusInput *, int);
+int ArgusProcessCiscoDatagram (struct ArgusParserStruct *, struct ArgusInput *, int);
 
 static void ArgusParseSFFlowSample(SFSample *, int);
 static void ArgusParseSFCountersSample(SFSample *, int);
@@ -3045,6 +3141,236 @@ ArgusReadSflowStreamSocket (struct ArgusParserStruct *parser, struct ArgusInput
    return (retn);
 }
 
+/*
+   Batched datagram receive.
+
+   Where recvmmsg() is available, the Netflow/IPFIX and sFlow collectors
+   pull up to ARGUS_DGRAM_BATCH datagrams out of the socket per system
+   call, rather than one recvfrom() per datagram, and then parse them in
+   arrival order.  The first read on a socket also grows its receive
+   buffer, so that bursts from the exporters queue in the kernel rather
+   than being dropped, and asks the kernel for per-datagram timestamps
+   and the socket drop counter, where supported.
+
+   From those we keep, per input, the number of datagrams and batches
+   read, the kernel drop count, and the time datagrams waited in the
+   socket before we parsed them.  Increases in the drop count are
+   logged, at most once every ARGUS_DGRAM_REPORT seconds, along with
+   the queueing latency, so that an overloaded collector is visible.
+*/
+
+#if defined(ARGUS_DGRAM_BATCHING)
+
+#define ARGUS_DGRAM_BATCH	32
+#define ARGUS_DGRAM_SLOTSIZE	65536
+#define ARGUS_DGRAM_RCVBUF	(8 * 1024 * 1024)
+#define ARGUS_DGRAM_REPORT	10
+#define ARGUS_DGRAM_CTRLSIZE	(CMSG_SPACE(sizeof(struct timeval)) + CMSG_SPACE(sizeof(uint32_t)))
+
+struct ArgusDatagramBatch {
+   unsigned char *buffers;
+   struct mmsghdr msgs[ARGUS_DGRAM_BATCH];
+   struct iovec iovs[ARGUS_DGRAM_BATCH];
+   struct sockaddr_storage addrs[ARGUS_DGRAM_BATCH];
+   char ctrl[ARGUS_DGRAM_BATCH][ARGUS_DGRAM_CTRLSIZE];
+
+   unsigned long long datagrams, batches, bytes;
+   unsigned int maxbatch, drops, reported;
+   long long latency, maxlatency, samples;
+   struct timeval lastreport;
+};
+
+static struct ArgusDatagramBatch *
+ArgusNewDatagramBatch (struct ArgusInput *input)
+{
+   struct ArgusDatagramBatch *batch = NULL;
+   int size = ARGUS_DGRAM_RCVBUF, on = 1;
+
+   if ((batch = ArgusCalloc(1, sizeof(*batch))) == NULL)
+      ArgusLog (LOG_ERR, "ArgusNewDatagramBatch: ArgusCalloc error %s", strerror(errno));
+
+   if ((batch->buffers = ArgusMalloc(ARGUS_DGRAM_BATCH * ARGUS_DGRAM_SLOTSIZE)) == NULL)
+      ArgusLog (LOG_ERR, "ArgusNewDatagramBatch: ArgusMalloc error %s", strerror(errno));
+
+   if (setsockopt(input->fd, SOL_SOCKET, SO_RCVBUF, (char *)&size, sizeof(size)) < 0) {
+#ifdef ARGUSDEBUG
+      ArgusDebug (1, "ArgusNewDatagramBatch: setsockopt(%d, SO_RCVBUF, %d) failed: %s", input->fd, size, strerror(errno));
+#endif
+   }
+#if defined(SO_TIMESTAMP)
+   (void) setsockopt(input->fd, SOL_SOCKET, SO_TIMESTAMP, (char *)&on, sizeof(on));
+#endif
+#if defined(SO_RXQ_OVFL)
+   (void) setsockopt(input->fd, SOL_SOCKET, SO_RXQ_OVFL, (char *)&on, sizeof(on));
+#endif
+
+   gettimeofday (&batch->lastreport, NULL);
+   input->ArgusDgramBatch = batch;
+
+#ifdef ARGUSDEBUG
+   {
+      socklen_t len = sizeof(size);
+      if (getsockopt(input->fd, SOL_SOCKET, SO_RCVBUF, (char *)&size, &len) == 0)
+         ArgusDebug (1, "ArgusNewDatagramBatch (%p) fd %d receive buffer %d\n", input, input->fd, size);
+   }
+#endif
+   return (batch);
+}
+
+static void
+ArgusReportDatagramBatch (struct ArgusInput *input, struct ArgusDatagramBatch *batch, int level)
+{
+   char *name = input->hostname ? input->hostname : "udp";
+   long long avg = batch->samples ? (batch->latency / batch->samples) : 0;
+
+   if (level == LOG_WARNING)
+      ArgusLog (LOG_WARNING, "%s:%d kernel dropped %u datagrams (%u total), %llu received, queue latency avg %lld max %lld usecs",
+                name, input->portnum, batch->drops - batch->reported, batch->drops,
+                batch->datagrams, avg, batch->maxlatency);
+#ifdef ARGUSDEBUG
+   else
+      ArgusDebug (1, "%s:%d datagrams %llu bytes %llu batches %llu max batch %u drops %u latency avg %lld max %lld usecs\n",
+                name, input->portnum, batch->datagrams, batch->bytes, batch->batches, batch->maxbatch,
+                batch->drops, avg, batch->maxlatency);
+#endif
+   batch->reported = batch->drops;
+}
+
+void
+ArgusDeleteDatagramBatch (struct ArgusInput *input)
+{
+   struct ArgusDatagramBatch *batch;
+
+   if ((batch = input->ArgusDgramBatch) != NULL) {
+      if (batch->drops != batch->reported)
+         ArgusReportDatagramBatch (input, batch, LOG_WARNING);
+      else
+         ArgusReportDatagramBatch (input, batch, LOG_DEBUG);
+
+      ArgusFree(batch->buffers);
+      ArgusFree(batch);
+      input->ArgusDgramBatch = NULL;
+   }
+}
+
+int
+ArgusReadDatagramBatch (struct ArgusParserStruct *parser, struct ArgusInput *input,
+                        int (*process)(struct ArgusParserStruct *, struct ArgusInput *, int))
+{
+   struct ArgusDatagramBatch *batch = input->ArgusDgramBatch;
+   unsigned char *readptr = input->ArgusReadPtr;
+   struct timeval now;
+   int retn = 0, cnt, i;
+
+   if (batch == NULL)
+      batch = ArgusNewDatagramBatch (input);
+
+   for (i = 0; i < ARGUS_DGRAM_BATCH; i++) {
+      struct msghdr *msg = &batch->msgs[i].msg_hdr;
+
+      batch->iovs[i].iov_base = batch->buffers + (i * ARGUS_DGRAM_SLOTSIZE);
+      batch->iovs[i].iov_len  = ARGUS_DGRAM_SLOTSIZE;
+
+      msg->msg_name       = &batch->addrs[i];
+      msg->msg_namelen    = sizeof(batch->addrs[i]);
+      msg->msg_iov        = &batch->iovs[i];
+      msg->msg_iovlen     = 1;
+      msg->msg_control    = batch->ctrl[i];
+      msg->msg_controllen = ARGUS_DGRAM_CTRLSIZE;
+      msg->msg_flags      = 0;
+      batch->msgs[i].msg_len = 0;
+   }
+
+   if ((cnt = recvmmsg (input->fd, batch->msgs, ARGUS_DGRAM_BATCH, MSG_DONTWAIT, NULL)) > 0) {
+      gettimeofday (&now, NULL);
+
+      batch->batches++;
+      if (cnt > batch->maxbatch)
+         batch->maxbatch = cnt;
+
+      for (i = 0; (i < cnt) && (retn == 0); i++) {
+         struct msghdr *msg = &batch->msgs[i].msg_hdr;
+         struct sockaddr *from = (struct sockaddr *) &batch->addrs[i];
+         struct cmsghdr *cmsg;
+         int len = batch->msgs[i].msg_len;
+
+         for (cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+            if (cmsg->cmsg_level != SOL_SOCKET)
+               continue;
+#if defined(SO_TIMESTAMP)
+            if (cmsg->cmsg_type == SO_TIMESTAMP) {
+               struct timeval tvbuf, diff;
+               long long usecs;
+
+               bcopy (CMSG_DATA(cmsg), &tvbuf, sizeof(tvbuf));
+               RaDiffTime (&now, &tvbuf, &diff);
+               if ((usecs = (diff.tv_sec * 1000000LL) + diff.tv_usec) >= 0) {
+                  batch->latency += usecs;
+                  batch->samples++;
+                  if (usecs > batch->maxlatency)
+                     batch->maxlatency = usecs;
+               }
+            }
+#endif
+#if defined(SO_RXQ_OVFL)
+            if (cmsg->cmsg_type == SO_RXQ_OVFL) {
+               uint32_t drops;
+               bcopy (CMSG_DATA(cmsg), &drops, sizeof(drops));
+               batch->drops = drops;
+            }
+#endif
+         }
+
+         batch->datagrams++;
+         batch->bytes += len;
+
+         if (from->sa_family == AF_INET)
+            input->addr.s_addr = ntohl(((struct sockaddr_in *)from)->sin_addr.s_addr);
+         else
+            input->addr.s_addr = 0;
+
+         input->ArgusReadPtr = batch->iovs[i].iov_base;
+         input->ArgusReadSocketCnt = len;
+
+#ifdef ARGUSDEBUG
+         ArgusDebug (8, "ArgusReadDatagramBatch (%p) datagram %d of %d, %d bytes\n", input, i + 1, cnt, len);
+#endif
+         if (process (parser, input, len))
+            retn = 1;
+      }
+
+      input->ArgusReadPtr = readptr;
+
+      if ((batch->drops != batch->reported) && ((now.tv_sec - batch->lastreport.tv_sec) >= ARGUS_DGRAM_REPORT)) {
+         ArgusReportDatagramBatch (input, batch, LOG_WARNING);
+         batch->lastreport = now;
+      }
+
+   } else {
+#ifdef ARGUSDEBUG
+      ArgusDebug (3, "ArgusReadDatagramBatch (%p) recvmmsg returned %d error %s\n", input, cnt, strerror(errno));
+#endif
+      if ((cnt < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)))
+         retn = 0;
+      else
+         retn = 1;
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (5, "ArgusReadDatagramBatch (%p, %p) returning %d\n", parser, input, retn);
+#endif
+   return (retn);
+}
+
+#else
+
+void
+ArgusDeleteDatagramBatch (struct ArgusInput *input)
+{
+}
+
+#endif
+
 int
 ArgusReadSflowDatagramSocket (struct ArgusParserStruct *parser, struct ArgusInput *input)
 {
@@ -3057,6 +3383,10 @@ ArgusReadSflowDatagramSocket (struct ArgusParserStruct *parser, struct ArgusInpu
    ArgusDebug (8, "ArgusReadSflowDatagramSocket (0x%x) starting\n", input);
 #endif
 
+#if defined(ARGUS_DGRAM_BATCHING)
+   return (ArgusReadDatagramBatch (parser, input, ArgusProcessSflowDatagram));
+#endif
+
    if ((cnt = recvfrom (input->fd, input->ArgusReadPtr, input->ArgusReadSocketSize, 0L, &from, &fromlen)) > 0) {
       input->ArgusReadSocketCnt = cnt;
 
@@ -3301,190 +3631,203 @@ ArgusReadCiscoStreamSocket (struct ArgusParserStruct *parser, struct ArgusInput
 int ArgusCiscoDatagramSocketStart = 1;
 
 int
-ArgusReadCiscoDatagramSocket (struct ArgusParserStruct *parser, struct ArgusInput *input)
+ArgusProcessCiscoDatagram (struct ArgusParserStruct *parser, struct ArgusInput *input, int cnt)
 {
-   int retn = 0, cnt = 0, count = 0;
-   struct sockaddr from;
-   socklen_t fromlen = sizeof(from);
-   struct sockaddr_in *sin = (struct sockaddr_in *)&from;
+   int ArgusReadSocketState = ARGUS_READINGPREHDR;
    unsigned char *ptr = NULL, *end = NULL;
    unsigned short *sptr = NULL;
-
-#ifdef ARGUSDEBUG
-   ArgusDebug (8, "ArgusReadCiscoDatagramSocket (0x%x) starting\n", input);
-#endif
+   int count = 0;
 
    if (ArgusTemplateQueue == NULL)
       if ((ArgusTemplateQueue = ArgusNewQueue()) == NULL)
-         ArgusLog (LOG_ERR, "ArgusReadCiscoDatagramSocket: ArgusNewQueue error %s", strerror(errno));
-
-   if ((cnt = recvfrom (input->fd, input->ArgusReadPtr, input->ArgusReadSocketSize, 0L, &from, &fromlen)) > 0) {
-      int ArgusReadSocketState = ARGUS_READINGPREHDR;
-//    int ArgusReadSocketSize = 0;
-
-      input->ArgusReadSocketCnt = cnt;
-      ptr = (unsigned char *) input->ArgusReadPtr;
-      sptr = (unsigned short *) ptr;
-      end = ptr + cnt;
+         ArgusLog (LOG_ERR, "ArgusProcessCiscoDatagram: ArgusNewQueue error %s", strerror(errno));
 
-      if (from.sa_family == AF_INET)
-         input->addr.s_addr = ntohl(sin->sin_addr.s_addr);
-      else
-         input->addr.s_addr = 0;
+   ptr = (unsigned char *) input->ArgusReadPtr;
+   sptr = (unsigned short *) ptr;
+   end = ptr + cnt;
 
-#ifdef ARGUSDEBUG
-      ArgusDebug (8, "ArgusReadCiscoDatagramSocket (%p) read %d bytes, capacity %d\n",
-                      input, cnt, input->ArgusReadSocketCnt, input->ArgusReadSocketSize);
-#endif
-
-      while ((char *)ptr < (char *) end) {
-         switch (ArgusReadSocketState) {
-            case ARGUS_READINGPREHDR: {
-               sptr = (unsigned short *) ptr;
-               input->ArgusReadCiscoVersion = ntohs(*sptr++);
+   while ((char *)ptr < (char *) end) {
+      switch (ArgusReadSocketState) {
+         case ARGUS_READINGPREHDR: {
+            sptr = (unsigned short *) ptr;
+            input->ArgusReadCiscoVersion = ntohs(*sptr++);
 //             ArgusReadSocketNum  = ntohs(*sptr);
-               ArgusReadSocketState = ARGUS_READINGHDR;
-               break;
-            }
+            ArgusReadSocketState = ARGUS_READINGHDR;
+            break;
+         }
 
-            case ARGUS_READINGHDR: {
+         case ARGUS_READINGHDR: {
 #ifdef ARGUSDEBUG
-               ArgusDebug (7, "ArgusReadCiscoDatagramSocket (%p, %p) read record header\n", parser, input);
+            ArgusDebug (7, "ArgusReadCiscoDatagramSocket (%p, %p) read record header\n", parser, input);
 #endif
-               switch (input->ArgusReadCiscoVersion) {
-                  case CISCO_VERSION_1: {
-                     CiscoFlowHeaderV1_t *ArgusNetFlow = (CiscoFlowHeaderV1_t *) ptr;
+            switch (input->ArgusReadCiscoVersion) {
+               case CISCO_VERSION_1: {
+                  CiscoFlowHeaderV1_t *ArgusNetFlow = (CiscoFlowHeaderV1_t *) ptr;
 //                   ArgusReadSocketSize  = sizeof(*ArgusNetFlow);
 
-                     input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV1;
-                     ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
-                     ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
-                     ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
-                     ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
-                     ArgusNetFlowRecordHeader      = ptr;
-
-                     ptr = (unsigned char *) (ArgusNetFlow + 1);
-                     count = ArgusNetFlow->count;
-                     break;
-                  }
+                  input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV1;
+                  ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
+                  ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
+                  ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
+                  ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
+                  ArgusNetFlowRecordHeader      = ptr;
 
-                  case CISCO_VERSION_5: {
-                     CiscoFlowHeaderV5_t *ArgusNetFlow = (CiscoFlowHeaderV5_t *) ptr;
+                  ptr = (unsigned char *) (ArgusNetFlow + 1);
+                  count = ArgusNetFlow->count;
+                  break;
+               }
+
+               case CISCO_VERSION_5: {
+                  CiscoFlowHeaderV5_t *ArgusNetFlow = (CiscoFlowHeaderV5_t *) ptr;
 //                   ArgusReadSocketSize  = sizeof(*ArgusNetFlow);
 
-                     input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV5;
-                     ArgusNetFlow->version         = ntohs(ArgusNetFlow->version);
-                     ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
-                     ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
-                     ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
-                     ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
-                     ArgusNetFlow->flow_sequence   = ntohl(ArgusNetFlow->flow_sequence);
-                     ArgusNetFlowRecordHeader      = ptr;
-
-                     ptr = (unsigned char *) (ArgusNetFlow + 1);
-                     count = ArgusNetFlow->count;
-                     break;
-                  }
+                  input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV5;
+                  ArgusNetFlow->version         = ntohs(ArgusNetFlow->version);
+                  ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
+                  ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
+                  ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
+                  ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
+                  ArgusNetFlow->flow_sequence   = ntohl(ArgusNetFlow->flow_sequence);
+                  ArgusNetFlowRecordHeader      = ptr;
+
+                  ptr = (unsigned char *) (ArgusNetFlow + 1);
+                  count = ArgusNetFlow->count;
+                  break;
+               }
 
-                  case CISCO_VERSION_6: {
-                     CiscoFlowHeaderV6_t *ArgusNetFlow = (CiscoFlowHeaderV6_t *) ptr;
+               case CISCO_VERSION_6: {
+                  CiscoFlowHeaderV6_t *ArgusNetFlow = (CiscoFlowHeaderV6_t *) ptr;
 //                   ArgusReadSocketSize  = sizeof(*ArgusNetFlow);
-          
-                     input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV6;
-                     ArgusNetFlow->version         = ntohs(ArgusNetFlow->version);
-                     ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
-                     ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
-                     ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
-                     ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
-                     ArgusNetFlow->flow_sequence   = ntohl(ArgusNetFlow->flow_sequence);
-
-                     ArgusNetFlowRecordHeader = ptr;
-                     ptr = (unsigned char *) (ArgusNetFlow + 1);
-                     count = ArgusNetFlow->count;
-                     break;
-                  }
+       
+                  input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV6;
+                  ArgusNetFlow->version         = ntohs(ArgusNetFlow->version);
+                  ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
+                  ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
+                  ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
+                  ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
+                  ArgusNetFlow->flow_sequence   = ntohl(ArgusNetFlow->flow_sequence);
+
+                  ArgusNetFlowRecordHeader = ptr;
+                  ptr = (unsigned char *) (ArgusNetFlow + 1);
+                  count = ArgusNetFlow->count;
+                  break;
+               }
 
-                  case CISCO_VERSION_7: {
-                     CiscoFlowHeaderV7_t *ArgusNetFlow = (CiscoFlowHeaderV7_t *) ptr;
+               case CISCO_VERSION_7: {
+                  CiscoFlowHeaderV7_t *ArgusNetFlow = (CiscoFlowHeaderV7_t *) ptr;
 //                   ArgusReadSocketSize  = sizeof(*ArgusNetFlow);
-          
-                     input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV7;
-                     ArgusNetFlow->version         = ntohs(ArgusNetFlow->version);
-                     ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
-                     ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
-                     ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
-                     ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
-                     ArgusNetFlow->flow_sequence   = ntohl(ArgusNetFlow->flow_sequence);
-
-                     ArgusNetFlowRecordHeader = ptr;
-                     ptr = (unsigned char *) (ArgusNetFlow + 1);
-                     count = ArgusNetFlow->count;
-                     break;
-                  }
+       
+                  input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV7;
+                  ArgusNetFlow->version         = ntohs(ArgusNetFlow->version);
+                  ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
+                  ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
+                  ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
+                  ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
+                  ArgusNetFlow->flow_sequence   = ntohl(ArgusNetFlow->flow_sequence);
+
+                  ArgusNetFlowRecordHeader = ptr;
+                  ptr = (unsigned char *) (ArgusNetFlow + 1);
+                  count = ArgusNetFlow->count;
+                  break;
+               }
 
-                  case CISCO_VERSION_8: {
-                     CiscoFlowHeaderV8_t *ArgusNetFlow = (CiscoFlowHeaderV8_t *) ptr;
+               case CISCO_VERSION_8: {
+                  CiscoFlowHeaderV8_t *ArgusNetFlow = (CiscoFlowHeaderV8_t *) ptr;
 //                   ArgusReadSocketSize  = sizeof(*ArgusNetFlow);
 
-                     input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV8;
-                     ArgusNetFlow->version         = ntohs(ArgusNetFlow->version);
-                     ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
-                     ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
-                     ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
-                     ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
-                     ArgusNetFlow->flow_sequence   = ntohl(ArgusNetFlow->flow_sequence);
+                  input->ArgusCiscoNetFlowParse = ArgusParseCiscoRecordV8;
+                  ArgusNetFlow->version         = ntohs(ArgusNetFlow->version);
+                  ArgusNetFlow->count           = ntohs(ArgusNetFlow->count);
+                  ArgusNetFlow->sysUptime       = ntohl(ArgusNetFlow->sysUptime);
+                  ArgusNetFlow->unix_secs       = ntohl(ArgusNetFlow->unix_secs);
+                  ArgusNetFlow->unix_nsecs      = ntohl(ArgusNetFlow->unix_nsecs);
+                  ArgusNetFlow->flow_sequence   = ntohl(ArgusNetFlow->flow_sequence);
 
-                     ArgusNetFlowRecordHeader = ptr;
-                     ptr = (unsigned char *) (ArgusNetFlow + 1);
-                     count = ArgusNetFlow->count;
+                  ArgusNetFlowRecordHeader = ptr;
+                  ptr = (unsigned char *) (ArgusNetFlow + 1);
+                  count = ArgusNetFlow->count;
 
-                     if ((input->ArgusCiscoNetFlowParse =
-                            ArgusLookUpNetFlow(input, ArgusNetFlow->agg_method)) != NULL) {
-                     }
-                     break;
+                  if ((input->ArgusCiscoNetFlowParse =
+                         ArgusLookUpNetFlow(input, ArgusNetFlow->agg_method)) != NULL) {
                   }
+                  break;
+               }
 
-                  case CISCO_VERSION_9: {
-                     CiscoFlowHeaderV9_t *ArgusNetFlow = (CiscoFlowHeaderV9_t *) ptr;
+               case CISCO_VERSION_9: {
+                  CiscoFlowHeaderV9_t *ArgusNetFlow = (CiscoFlowHeaderV9_t *) ptr;
 //                   ArgusReadSocketSize  = sizeof(*ArgusNetFlow);
 
-                     input->ArgusCiscoNetFlowParse  = ArgusParseCiscoRecordV9;
-                     ArgusNetFlow->version          = ntohs(ArgusNetFlow->version);
-                     ArgusNetFlow->count            = ntohs(ArgusNetFlow->count);
-                     ArgusNetFlow->sysUptime        = ntohl(ArgusNetFlow->sysUptime);
-                     ArgusNetFlow->unix_secs        = ntohl(ArgusNetFlow->unix_secs);
-                     ArgusNetFlow->package_sequence = ntohl(ArgusNetFlow->package_sequence);
-                     ArgusNetFlow->source_id        = ntohl(ArgusNetFlow->source_id);
-                     ArgusCiscoTvp->tv_sec          = ArgusNetFlow->unix_secs;
-                     ArgusCiscoTvp->tv_usec         = 0;
-                     ArgusCiscoSrcId                = ArgusNetFlow->source_id;
-                     ArgusCiscoSrcAddr              = input->addr.s_addr;
-
-                     ArgusNetFlowRecordHeader = ptr;
-                     ptr = (unsigned char *) (ArgusNetFlow + 1);
-                     count = ArgusNetFlow->count;
-                     break;
-                  }
+                  input->ArgusCiscoNetFlowParse  = ArgusParseCiscoRecordV9;
+                  ArgusNetFlow->version          = ntohs(ArgusNetFlow->version);
+                  ArgusNetFlow->count            = ntohs(ArgusNetFlow->count);
+                  ArgusNetFlow->sysUptime        = ntohl(ArgusNetFlow->sysUptime);
+                  ArgusNetFlow->unix_secs        = ntohl(ArgusNetFlow->unix_secs);
+                  ArgusNetFlow->package_sequence = ntohl(ArgusNetFlow->package_sequence);
+                  ArgusNetFlow->source_id        = ntohl(ArgusNetFlow->source_id);
+                  ArgusCiscoTvp->tv_sec          = ArgusNetFlow->unix_secs;
+                  ArgusCiscoTvp->tv_usec         = 0;
+                  ArgusCiscoSrcId                = ArgusNetFlow->source_id;
+                  ArgusCiscoSrcAddr              = input->addr.s_addr;
+
+                  ArgusNetFlowRecordHeader = ptr;
+                  ptr = (unsigned char *) (ArgusNetFlow + 1);
+                  count = ArgusNetFlow->count;
+                  break;
+               }
 
-                  default: {
+               default: {
 #ifdef ARGUSDEBUG
-                     ArgusDebug (4, "ArgusReadCiscoStreamSocket (%p) unknown header version %d\n", ptr, input->ArgusReadCiscoVersion);
+                  ArgusDebug (4, "ArgusReadCiscoStreamSocket (%p) unknown header version %d\n", ptr, input->ArgusReadCiscoVersion);
 #endif
-                  }
                }
-
-               ArgusReadSocketState = ARGUS_READINGBLOCK;
-               break;
             }
 
-            case ARGUS_READINGBLOCK: {
-               if (ArgusHandleRecord (parser, input, input->ArgusCiscoNetFlowParse (parser, input, &ptr, &count), 0, &ArgusParser->ArgusFilterCode) < 0)
-                  return(1);
+            ArgusReadSocketState = ARGUS_READINGBLOCK;
+            break;
+         }
 
-               break;
-            }
+         case ARGUS_READINGBLOCK: {
+            if (ArgusHandleRecord (parser, input, input->ArgusCiscoNetFlowParse (parser, input, &ptr, &count), 0, &ArgusParser->ArgusFilterCode) < 0)
+               return(1);
+
+            break;
          }
       }
+   }
+
+   return (0);
+}
+
+int
+ArgusReadCiscoDatagramSocket (struct ArgusParserStruct *parser, struct ArgusInput *input)
+{
+   int retn = 0, cnt = 0;
+   struct sockaddr from;
+   socklen_t fromlen = sizeof(from);
+   struct sockaddr_in *sin = (struct sockaddr_in *)&from;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (8, "ArgusReadCiscoDatagramSocket (0x%x) starting\n", input);
+#endif
+
+#if defined(ARGUS_DGRAM_BATCHING)
+   return (ArgusReadDatagramBatch (parser, input, ArgusProcessCiscoDatagram));
+#endif
+
+   if ((cnt = recvfrom (input->fd, input->ArgusReadPtr, input->ArgusReadSocketSize, 0L, &from, &fromlen)) > 0) {
+      input->ArgusReadSocketCnt = cnt;
+
+      if (from.sa_family == AF_INET)
+         input->addr.s_addr = ntohl(sin->sin_addr.s_addr);
+      else
+         input->addr.s_addr = 0;
+
+#ifdef ARGUSDEBUG
+      ArgusDebug (8, "ArgusReadCiscoDatagramSocket (%p) read %d bytes, capacity %d\n",
+                      input, cnt, input->ArgusReadSocketCnt, input->ArgusReadSocketSize);
+#endif
+      if (ArgusProcessCiscoDatagram (parser, input, cnt))
+         retn = 1;
 
    } else {
 #ifdef ARGUSDEBUG
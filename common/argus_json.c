@@ -207,8 +207,7 @@ vector_foreach(const vector* v, ArgusJsonValue *parent, vector_foreach_t fp) {
 
 void
 skip_whitespace(const char** cursor) {
-   if (**cursor == '\0') return;
-   while (iscntrl(**cursor) || isspace(**cursor)) ++(*cursor);
+   while (**cursor && (iscntrl(**cursor) || isspace(**cursor))) ++(*cursor);
 }
 
 int
@@ -715,6 +714,136 @@ ArgusJsonParse(const char* input, ArgusJsonValue *result) {
    return (retn);
 }
 
+// Streaming reader.  ArgusJsonScan() walks one object in place and
+// hands each member's key and value text to the handler, so records
+// can be read without building, walking and freeing a value tree.
+
+// Return the closing quote of the string starting at cursor, skipping
+// escaped quotes, or NULL if the string isn't terminated.
+
+static const char *
+json_scan_string(const char *cursor) {
+   const char *start = cursor, *end, *bs;
+
+   while ((end = strchr(cursor, '"')) != NULL) {
+      for (bs = end; (bs > start) && (bs[-1] == '\\'); bs--) ;
+      if (((end - bs) & 0x01) == 0)
+         break;
+      cursor = end + 1;
+   }
+   return end;
+}
+
+// Return the end of the array or object starting at cursor.
+
+static const char *
+json_scan_nested(const char *cursor) {
+   int depth = 0;
+
+   for (; *cursor != '\0'; cursor++) {
+      switch (*cursor) {
+         case '"':
+            if ((cursor = json_scan_string(cursor + 1)) == NULL)
+               return NULL;
+            break;
+         case '{':
+         case '[':
+            depth++;
+            break;
+         case '}':
+         case ']':
+            if (--depth == 0)
+               return cursor + 1;
+            break;
+      }
+   }
+   return NULL;
+}
+
+int
+ArgusJsonScan(const char** cursor, ArgusJsonHandler handler, void *arg) {
+   const char *key, *kend, *val, *vend;
+   int type;
+
+   if (!has_char(cursor, '{'))
+      return 0;
+   if (has_char(cursor, '}'))
+      return 1;
+
+   for (;;) {
+      if (!has_char(cursor, '"'))
+         return 0;
+      key = *cursor;
+      if ((kend = json_scan_string(key)) == NULL)
+         return 0;
+      *cursor = kend + 1;
+
+      if (!has_char(cursor, ':'))
+         return 0;
+      skip_whitespace(cursor);
+
+      val = *cursor;
+      switch (*val) {
+         case '"':
+            type = ARGUS_JSON_STRING;
+            if ((vend = json_scan_string(++val)) == NULL)
+               return 0;
+            *cursor = vend + 1;
+            break;
+
+         case '{':
+         case '[':
+            type = (*val == '{') ? ARGUS_JSON_OBJECT : ARGUS_JSON_ARRAY;
+            if ((vend = json_scan_nested(val)) == NULL)
+               return 0;
+            *cursor = vend;
+            break;
+
+         case 't':
+         case 'f':
+         case 'n':
+            if (json_is_literal(cursor, "true") || json_is_literal(cursor, "false")) {
+               type = ARGUS_JSON_BOOL;
+               vend = *cursor;
+               break;
+            }
+            if (json_is_literal(cursor, "null")) {
+               type = ARGUS_JSON_NULL;
+               vend = *cursor;
+               break;
+            }
+
+         // not a literal, so a number, or like json_parse_value(), an unquoted word
+
+            /* fall through */
+         default:
+            type = ARGUS_JSON_INTEGER;
+            for (vend = val; *vend && !strchr(",}] \t\r\n", *vend); vend++) {
+               if (!isdigit((int)*vend) && (*vend != '-') && (*vend != '+')) {
+                  if ((*vend == '.') || (*vend == 'e') || (*vend == 'E')) {
+                     if (type == ARGUS_JSON_INTEGER)
+                        type = ARGUS_JSON_DOUBLE;
+                  } else
+                     type = ARGUS_JSON_STRING;
+               }
+            }
+            if (vend == val)
+               return 0;
+            *cursor = vend;
+            break;
+      }
+
+      if (handler != NULL)
+         handler(arg, key, kend - key, type, val, vend - val);
+
+      if (has_char(cursor, ','))
+         continue;
+      if (has_char(cursor, '}'))
+         return 1;
+      return 0;
+   }
+}
+
 char *
 ArgusJsonPrint(ArgusJsonValue *result, char *buf, int len) {
    json_print_value(result, buf, len);
@@ -108,6 +108,8 @@ void RaAddToSrvTree (struct RaSrvSignature *, int);
 int RaGenerateBinaryTrees(struct ArgusParserStruct *, struct ArgusLabelerStruct *);
 int RaReadSrvSignature(struct ArgusParserStruct *, struct ArgusLabelerStruct *, char *);
 struct RaSrvSignature *RaFindSrv (struct RaSrvTreeNode *, u_char *ptr, int, int, int);
+struct RaSrvMatch *RaCompileSrvNode (struct RaSrvTreeNode *, int);
+void RaCompileSrvTree (struct RaSrvTreeNode *, int);
 
 int ArgusAddToRecordLabel (struct ArgusParserStruct *, struct ArgusRecordStruct *, char *);
 
@@ -126,7 +128,7 @@ int RaPrintLabelTreeLevel = 1000000;
 
 int RaPrintLabelTreeDebug = 0;
 
-#define RALABEL_RCITEMS                         29
+#define RALABEL_RCITEMS                         30
 
 #define RALABEL_IANA_ADDRESS                    0
 #define RALABEL_IANA_ADDRESS_FILE               1
@@ -157,6 +159,7 @@ int RaPrintLabelTreeDebug = 0;
 #define RALABEL_ARGUS_FLOW_SERVICE              26
 #define RALABEL_SERVICE_SIGNATURES              27
 #define RALABEL_FIREHOL_FILES			28
+#define RALABEL_GEOIP_CACHE_SIZE		29
 
 char *RaLabelResourceFileStr [] = {
    "RALABEL_IANA_ADDRESS=",
@@ -188,6 +191,7 @@ char *RaLabelResourceFileStr [] = {
    "RALABEL_ARGUS_FLOW_SERVICE=",
    "RALABEL_SERVICE_SIGNATURES=",
    "RALABEL_FIREHOL_FILES=",
+   "RALABEL_GEOIP_CACHE_SIZE=",
 };
 
 
@@ -542,6 +546,7 @@ RaLabelParseResourceStr (struct ArgusParserStruct *parser, struct ArgusLabelerSt
                         if (status != MMDB_SUCCESS) {
                            ArgusLog(LOG_ERR, "%s: failed to open GeoIP2 ASN database: %s\n", __func__, MMDB_strerror(status));
                         }
+                        ArgusFlushGeoIP2Cache(labeler);
                         break;
                      }
 
@@ -594,6 +599,17 @@ RaLabelParseResourceStr (struct ArgusParserStruct *parser, struct ArgusLabelerSt
                                     "%s: failed to open GeoIP2 city database: %s\n",
                                     __func__, MMDB_strerror(status));
                         }
+                        ArgusFlushGeoIP2Cache(labeler);
+                        break;
+                     }
+
+                     case RALABEL_GEOIP_CACHE_SIZE: {
+                        if (!(strncasecmp(optarg, "no", 2)))
+                           labeler->RaGeoIPCacheSize = 0;
+                        else
+                           labeler->RaGeoIPCacheSize = atoi(optarg);
+
+                        ArgusDeleteGeoIP2Cache(labeler);
                         break;
                      }
 #endif
@@ -1170,6 +1186,11 @@ char *ArgusFlowLabelFields[ARGUS_RCITEMS] = {
    "filter", "label", "color", "cont",
 };
 
+void RaFlowLabelParseKey (struct RaFlowLabelKey *, char *);
+void RaDeleteFlowLabelIndex (struct ArgusLabelerStruct *);
+struct RaFlowLabelIndex *RaFlowLabelGetIndex (struct ArgusLabelerStruct *);
+int RaFlowLabelKeyMatch (struct RaFlowLabelKey *, struct ArgusRecordStruct *);
+
 
 
 int
@@ -1271,6 +1292,7 @@ RaReadFlowLabels (struct ArgusParserStruct *parser, struct ArgusLabelerStruct *l
                               raflow->filterstr = filter; filter = NULL;
                               if (ArgusFilterCompile (&raflow->filter, raflow->filterstr, ArgusParser->Oflag) < 0)
                                  ArgusLog (LOG_ERR, "RaReadFlowLabels ArgusFilterCompile returned error");
+                              RaFlowLabelParseKey (&raflow->key, raflow->filterstr);
                            }
 
                            if (label != NULL) {
@@ -1304,6 +1326,7 @@ RaReadFlowLabels (struct ArgusParserStruct *parser, struct ArgusLabelerStruct *l
       if (label != NULL) free(label);
       if (color != NULL) free(color);
 
+      RaDeleteFlowLabelIndex (labeler);
       ArgusFree(strbuf);
    }
  
@@ -3528,6 +3551,10 @@ ArgusNewLabeler (struct ArgusParserStruct *parser, int status)
 
    retn->RaPrintLabelTreeMode = ARGUS_TREE;
 
+#if defined(ARGUS_GEOIP2)
+   retn->RaGeoIPCacheSize = ARGUS_GEOIP2_CACHE_DEFAULT;
+#endif
+
    if (parser->ArgusLabelerFileList != NULL) {
 /*
       struct ArgusWfileStruct *wfile = NULL, *start = NULL;
@@ -3589,6 +3616,12 @@ ArgusDeleteLabeler (struct ArgusParserStruct *parser, struct ArgusLabelerStruct
       if (labeler->htable !=  NULL)
          ArgusDeleteHashTable (labeler->htable);
 
+#if defined(ARGUS_GEOIP2)
+      ArgusDeleteGeoIP2Cache (labeler);
+#endif
+
+      RaDeleteFlowLabelIndex (labeler);
+
       if ((ArgusAddrTree = labeler->ArgusAddrTree) != NULL) {
          if (labeler->ArgusAddrTree[AF_INET] != NULL)
             RaDeleteAddressTree (labeler, labeler->ArgusAddrTree[AF_INET]);
@@ -3885,6 +3918,9 @@ RaPrintSrvTree (struct ArgusLabelerStruct *labeler, struct RaSrvTreeNode *node,
 }
 
 
+struct RaSrvTreeNode *RaTCPSrcArray[0x10000], *RaTCPDstArray[0x10000];
+struct RaSrvTreeNode *RaUDPSrcArray[0x10000], *RaUDPDstArray[0x10000];
+
 int
 RaGenerateBinaryTrees(struct ArgusParserStruct *parser, struct ArgusLabelerStruct *labeler)
 {
@@ -3906,6 +3942,24 @@ RaGenerateBinaryTrees(struct ArgusParserStruct *parser, struct ArgusLabelerStruc
          RaAddToSrvTree (srv, RA_DST_SERVICES);
    }
 
+   {
+      int i;
+
+      for (i = 0; i < 0x10000; i++) {
+         RaCompileSrvTree (RaTCPSrcArray[i], RA_SRC_SERVICES);
+         RaCompileSrvTree (RaTCPDstArray[i], RA_DST_SERVICES);
+         RaCompileSrvTree (RaUDPSrcArray[i], RA_SRC_SERVICES);
+         RaCompileSrvTree (RaUDPDstArray[i], RA_DST_SERVICES);
+      }
+
+      for (i = 0; i < RASIGLENGTH; i++) {
+         RaCompileSrvTree (RaSrcTCPServicesTree[i], RA_SRC_SERVICES);
+         RaCompileSrvTree (RaDstTCPServicesTree[i], RA_DST_SERVICES);
+         RaCompileSrvTree (RaSrcUDPServicesTree[i], RA_SRC_SERVICES);
+         RaCompileSrvTree (RaDstUDPServicesTree[i], RA_DST_SERVICES);
+      }
+   }
+
 #ifdef ARGUSDEBUG
    if (ARGUS_DEBUG_SERVICES & parser->dflag) {
       int i;
@@ -3958,8 +4012,6 @@ RaGenerateBinaryTrees(struct ArgusParserStruct *parser, struct ArgusLabelerStruc
    return (retn);
 }
 
-struct RaSrvTreeNode *RaTCPSrcArray[0x10000], *RaTCPDstArray[0x10000];
-struct RaSrvTreeNode *RaUDPSrcArray[0x10000], *RaUDPDstArray[0x10000];
 int RaAddToArray(struct RaSrvTreeNode **, struct RaSrvSignature *, int);
 
 int
@@ -4164,75 +4216,150 @@ RaAddToSrvTree (struct RaSrvSignature *srv, int mode)
 }
 
 
-struct RaSrvSignature *
-RaFindSrv (struct RaSrvTreeNode *node, u_char *ptr, int len, int mode, int wildcard)
+/*
+ * Compile a signature tree node into word form.  For each position the
+ * signature cares about, care holds 0xFF, raw holds the signature byte,
+ * and for alphabetic bytes value holds the lower case byte and fold
+ * holds 0x20, so that ((data | fold) ^ value) & care is zero exactly
+ * when the data matches the signature, ignoring case.
+ */
+
+struct RaSrvMatch *
+RaCompileSrvNode (struct RaSrvTreeNode *node, int mode)
 {
-   int i, nomatch = 0, guess = 0;
-   struct RaSrvSignature *retn = NULL;
+   struct RaSrvMatch *match;
    unsigned int mask;
-   u_char *buf = NULL;
+   u_char *buf;
+   int i;
 
-   if ((node != NULL)  && (ptr != NULL)) {
-      switch (mode) {
-         case RA_SRC_SERVICES:
-            mask = node->srv->srcmask;
-            buf  = node->srv->src;
-            break;
-         case RA_DST_SERVICES:
-            mask = node->srv->dstmask;
-            buf  = node->srv->dst;
-            break;
+   switch (mode) {
+      case RA_SRC_SERVICES:
+         mask = node->srv->srcmask;
+         buf  = node->srv->src;
+         break;
+      case RA_DST_SERVICES:
+         mask = node->srv->dstmask;
+         buf  = node->srv->dst;
+         break;
 
-         default:
-            return (retn);
+      default:
+         return (NULL);
+   }
+
+   if ((match = node->match) == NULL) {
+      if ((match = (struct RaSrvMatch *) ArgusCalloc (1, sizeof(*match))) == NULL)
+         ArgusLog (LOG_ERR, "RaCompileSrvNode: ArgusCalloc error %s\n", strerror(errno));
+   } else
+      bzero(match, sizeof(*match));
+
+   match->mode  = mode;
+   match->valid = (mask != 0xFFFFFFFF);
+
+   for (i = 0; i < RASIGLENGTH; i++) {
+      if (!(((u_char *)&mask)[i/8] & (0x80 >> (i % 8)))) {
+         match->care.b[i]  = 0xFF;
+         match->raw.b[i]   = buf[i];
+         match->value.b[i] = buf[i];
+         if (isalpha(buf[i])) {
+            match->fold.b[i]   = 0x20;
+            match->value.b[i] |= 0x20;
+         }
       }
+   }
+
+   node->match = match;
+   return (match);
+}
+
+void
+RaCompileSrvTree (struct RaSrvTreeNode *node, int mode)
+{
+   while (node != NULL) {
+      RaCompileSrvNode (node, mode);
+      RaCompileSrvTree (node->l, mode);
+      node = node->r;
+   }
+}
+
+/*
+ * Walk the signature tree for the user data in ptr.  The data is loaded
+ * into words once, and each node on the path costs a few masked word
+ * compares.  On a mismatch the node is scored, as it always has been,
+ * by the number of positions before the first mismatch, plus the
+ * don't care and exactly matching positions after it.  The best scoring
+ * node on the path becomes RaBestGuess, with the deepest node winning
+ * ties, as in the original recursive search.
+ */
+
+struct RaSrvSignature *
+RaFindSrv (struct RaSrvTreeNode *node, u_char *ptr, int len, int mode, int wildcard)
+{
+   struct RaSrvSignature *retn = NULL, *guessSrv = NULL;
+   struct RaSrvTreeNode *root = node;
+   union RaSrvSigWords data, diff;
+   int guessScore = 0;
+
+   if ((node == NULL) || (ptr == NULL))
+      return (retn);
+
+   if ((mode != RA_SRC_SERVICES) && (mode != RA_DST_SERVICES))
+      return (retn);
+
+   bcopy(ptr, data.b, RASIGLENGTH);
+
+   while (node != NULL) {
+      struct RaSrvMatch *match = node->match;
+      int w, i, guess;
+
+      if ((match == NULL) || (match->mode != mode))
+         match = RaCompileSrvNode (node, mode);
+
+      if (!match->valid)
+         break;
 
-      if (buf && (mask != 0xFFFFFFFF)) {
+      for (w = 0; w < RASIGWORDS; w++)
+         if ((diff.w[w] = ((data.w[w] | match->fold.w[w]) ^ match->value.w[w]) & match->care.w[w]) != 0)
+            break;
+
+      if (w == RASIGWORDS) {
          retn = node->srv;
+         break;
+      }
 
-         for (i = 0; i < RASIGLENGTH; i++) {
-            if (!(((u_char *)&mask)[i/8] & (0x80 >> (i % 8)))) {
-               if (buf[i] != ptr[i]) {
-                  if (!(isalpha(buf[i]) && 
-                      ((isupper(buf[i]) ? (tolower(buf[i]) == ptr[i]) :
-                                          (toupper(buf[i]) == ptr[i]))))) {
-                     nomatch++;
-                     if (buf[i] > ptr[i]) 
-                        retn = RaFindSrv (node->l, ptr, len, mode, wildcard);
-                     else
-                        retn = RaFindSrv (node->r, ptr, len, mode, wildcard);
-                     break;
+      for (i = w * 8; diff.b[i] == 0; i++) ;
 
-                  } else {
-                     guess++;
-                  }
-               } else {
-                  guess++;
-               }
-            } else
-               guess++;
-         }
+      guess = i;
+      for (w = 0; w < RASIGWORDS; w++)
+         diff.w[w] = (data.w[w] ^ match->raw.w[w]) & match->care.w[w];
 
-         for (; i < RASIGLENGTH; i++) {
-            if (!(((u_char *)&mask)[i/8] & (0x80 >> (i % 8)))) {
-               if (buf[i] == ptr[i])
-                  guess++;
-            } else
-               guess++;
-         }
+      for (w = i + 1; w < RASIGLENGTH; w++) {
+         if (((w % 8) == 0) && (diff.w[w / 8] == 0)) {
+            guess += 8;
+            w += 7;
+         } else
+         if (diff.b[w] == 0)
+            guess++;
+      }
 
-         if (nomatch) {
-            if (guess > RaBestGuessScore) {
-               RaBestGuessScore = guess;
-               RaBestGuess = node->srv;
-            }
-         }
+      if (guess >= guessScore) {
+         guessScore = guess;
+         guessSrv = node->srv;
       }
 
-      if (wildcard)
-         retn = node->srv;
+      if (match->raw.b[i] > data.b[i])
+         node = node->l;
+      else
+         node = node->r;
    }
 
+   if (guessSrv && (guessScore > RaBestGuessScore)) {
+      RaBestGuessScore = guessScore;
+      RaBestGuess = guessSrv;
+   }
+
+   if (wildcard)
+      retn = root->srv;
+
    return (retn);
 }
 
@@ -5450,13 +5577,404 @@ RaFetchIPPortLabel(struct ArgusParserStruct *parser, unsigned short proto, unsig
 }
 
 
+/*
+ * Flow label rule index.
+ *
+ * Label configs can hold thousands of (filter, label) rules, and running
+ * every filter against every record dominates ralabel.  When a rule is
+ * read, the top level conjuncts of its filter that we understand, tcp,
+ * udp, [src|dst] port N, [src|dst] host A and [src|dst] net A/M, are
+ * pulled out as conditions that any matching record must meet.  Filters
+ * with or, not or parenthesis get no conditions, and anything we don't
+ * understand is just ignored, so the conditions never reject a record
+ * that the filter would accept.
+ *
+ * The rules are then indexed by their first port condition.  A tcp or
+ * udp record only needs to consider the rules in its two port buckets,
+ * and the rules without a port, merged back into config order, so first
+ * match and 'cont' behave exactly as walking the whole list.
+ */
+
+static int
+RaFlowLabelParseNumber (char *str, unsigned int max, unsigned int *value)
+{
+   char *endptr = NULL;
+   unsigned long v;
+
+   if ((str == NULL) || !isdigit((int)*str))
+      return 0;
+
+   v = strtoul(str, &endptr, 10);
+   if ((endptr == NULL) || (*endptr != '\0') || (v > max))
+      return 0;
+
+   *value = (unsigned int) v;
+   return 1;
+}
+
+static int
+RaFlowLabelParseAddr (char *str, int net, struct RaFlowLabelTerm *term)
+{
+   unsigned int masklen = 32;
+   struct in_addr addr;
+   char *slash, *ptr;
+   int dots = 0;
+
+   if ((slash = strchr(str, '/')) != NULL) {
+      if (!net)
+         return 0;
+      *slash++ = '\0';
+      if (!RaFlowLabelParseNumber(slash, 32, &masklen))
+         return 0;
+   }
+
+   for (ptr = str; *ptr; ptr++) {
+      if (*ptr == '.')
+         dots++;
+      else if (!isdigit((int)*ptr))
+         return 0;
+   }
+
+   if ((dots != 3) || (inet_aton(str, &addr) == 0))
+      return 0;
+
+   term->mask  = masklen ? (0xFFFFFFFF << (32 - masklen)) : 0;
+   term->value = ntohl(addr.s_addr) & term->mask;
+   return 1;
+}
+
+void
+RaFlowLabelParseKey (struct RaFlowLabelKey *key, char *filterstr)
+{
+   char *buf, *tok, *sptr = NULL, *toks[8];
+   int ntoks = 0, i;
+
+   bzero(key, sizeof(*key));
+
+   if ((filterstr == NULL) || strpbrk(filterstr, "()!|"))
+      return;
+
+   if ((buf = strdup(filterstr)) == NULL)
+      ArgusLog (LOG_ERR, "RaFlowLabelParseKey: strdup error %s\n", strerror(errno));
+
+   for (tok = strtok_r(buf, " \t\n", &sptr); ; tok = strtok_r(NULL, " \t\n", &sptr)) {
+      if ((tok != NULL) && (!strcmp(tok, "or") || !strcmp(tok, "not"))) {
+         bzero(key, sizeof(*key));
+         break;
+      }
+
+      if ((tok == NULL) || !strcmp(tok, "and") || !strcmp(tok, "&&")) {
+         struct RaFlowLabelTerm term;
+         int proto = 0, dir = 0, x = 0;
+
+         if ((x < ntoks) && (!strcmp(toks[x], "tcp") || !strcmp(toks[x], "udp")))
+            proto = (toks[x++][0] == 't') ? IPPROTO_TCP : IPPROTO_UDP;
+
+         if ((x < ntoks) && (!strcmp(toks[x], "src") || !strcmp(toks[x], "dst")))
+            dir = (toks[x++][0] == 's') ? ARGUS_SRC_ADDR : ARGUS_DST_ADDR;
+
+         bzero(&term, sizeof(term));
+         term.dir = dir;
+
+         if ((x == ntoks) && proto && !dir) {
+            if (key->proto == 0)
+               key->proto = proto;
+
+         } else
+         if (((x + 2) == ntoks) && !strcmp(toks[x], "port")) {
+            if (RaFlowLabelParseNumber(toks[x + 1], 0xFFFF, &term.value)) {
+               if (proto && (key->proto == 0))
+                  key->proto = proto;
+               if (key->nports < RA_FLOW_LABEL_MAXTERMS)
+                  key->ports[key->nports++] = term;
+            }
+
+         } else
+         if (((x + 2) == ntoks) && !proto && (!strcmp(toks[x], "host") || !strcmp(toks[x], "net"))) {
+            if (RaFlowLabelParseAddr(toks[x + 1], (toks[x][0] == 'n'), &term))
+               if (key->naddrs < RA_FLOW_LABEL_MAXTERMS)
+                  key->addrs[key->naddrs++] = term;
+         }
+
+         ntoks = 0;
+         if (tok == NULL)
+            break;
+
+      } else {
+         if (ntoks < (sizeof(toks)/sizeof(toks[0])))
+            toks[ntoks] = tok;
+         ntoks++;
+      }
+   }
+
+   for (i = 0; i < key->nports; i++)
+      if (key->ports[i].dir == 0)
+         key->ports[i].dir = ARGUS_SRC_ADDR | ARGUS_DST_ADDR;
+   for (i = 0; i < key->naddrs; i++)
+      if (key->addrs[i].dir == 0)
+         key->addrs[i].dir = ARGUS_SRC_ADDR | ARGUS_DST_ADDR;
+
+   free(buf);
+}
+
+/* return 0 only if the record can't possibly match the rule filter */
+
+int
+RaFlowLabelKeyMatch (struct RaFlowLabelKey *key, struct ArgusRecordStruct *argus)
+{
+   struct ArgusFlow *flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX];
+   unsigned int saddr = 0, daddr = 0;
+   unsigned short sport, dport;
+   int i, proto, v4 = 0;
+
+   if ((flow == NULL) || ((flow->hdr.subtype & 0x3F) != ARGUS_FLOW_CLASSIC5TUPLE))
+      return 1;
+
+   switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+      case ARGUS_TYPE_IPV4:
+         proto = flow->ip_flow.ip_p;
+         sport = flow->ip_flow.sport;
+         dport = flow->ip_flow.dport;
+         saddr = flow->ip_flow.ip_src;
+         daddr = flow->ip_flow.ip_dst;
+         v4 = 1;
+         break;
+
+      case ARGUS_TYPE_IPV6:
+         proto = flow->ipv6_flow.ip_p;
+         sport = flow->ipv6_flow.sport;
+         dport = flow->ipv6_flow.dport;
+         break;
+
+      default:
+         return 1;
+   }
+
+   if (key->proto && (key->proto != proto))
+      return 0;
+
+   if ((proto == IPPROTO_TCP) || (proto == IPPROTO_UDP)) {
+      for (i = 0; i < key->nports; i++) {
+         struct RaFlowLabelTerm *term = &key->ports[i];
+         if (!(((term->dir & ARGUS_SRC_ADDR) && (sport == term->value)) ||
+               ((term->dir & ARGUS_DST_ADDR) && (dport == term->value))))
+            return 0;
+      }
+   } else
+   if (key->nports)
+      return 0;
+
+   if (v4) {
+      for (i = 0; i < key->naddrs; i++) {
+         struct RaFlowLabelTerm *term = &key->addrs[i];
+         if (!(((term->dir & ARGUS_SRC_ADDR) && ((saddr & term->mask) == term->value)) ||
+               ((term->dir & ARGUS_DST_ADDR) && ((daddr & term->mask) == term->value))))
+            return 0;
+      }
+   }
+
+   return 1;
+}
+
+static void
+RaFlowLabelBucketAdd (struct RaFlowLabelBucket *bucket, int rule)
+{
+   if (bucket->count == bucket->size) {
+      int size = bucket->size ? (bucket->size * 2) : 4;
+      int *rules;
+
+      if ((rules = ArgusCalloc(size, sizeof(*rules))) == NULL)
+         ArgusLog (LOG_ERR, "RaFlowLabelBucketAdd: ArgusCalloc error %s\n", strerror(errno));
+
+      if (bucket->rules != NULL) {
+         bcopy(bucket->rules, rules, bucket->count * sizeof(*rules));
+         ArgusFree(bucket->rules);
+      }
+      bucket->rules = rules;
+      bucket->size = size;
+   }
+   bucket->rules[bucket->count++] = rule;
+}
+
+void
+RaDeleteFlowLabelIndex (struct ArgusLabelerStruct *labeler)
+{
+   struct RaFlowLabelIndex *index;
+
+   if ((index = labeler->ArgusFlowIndex) != NULL) {
+      if (index->ports != NULL) {
+         int i;
+         for (i = 0; i < 0x10000; i++)
+            if (index->ports[i].rules != NULL)
+               ArgusFree(index->ports[i].rules);
+         ArgusFree(index->ports);
+      }
+      if (index->generic.rules != NULL)
+         ArgusFree(index->generic.rules);
+      if (index->rules != NULL)
+         ArgusFree(index->rules);
+      ArgusFree(index);
+      labeler->ArgusFlowIndex = NULL;
+   }
+}
+
+struct RaFlowLabelIndex *
+RaFlowLabelGetIndex (struct ArgusLabelerStruct *labeler)
+{
+   struct ArgusQueueStruct *queue = labeler->ArgusFlowQueue;
+   struct RaFlowLabelIndex *index;
+   int x, count;
+
+   if ((queue == NULL) || ((count = queue->count) == 0))
+      return (NULL);
+
+   if ((index = labeler->ArgusFlowIndex) != NULL) {
+      if (index->count == count)
+         return (index);
+      RaDeleteFlowLabelIndex (labeler);
+   }
+
+   if ((index = ArgusCalloc(1, sizeof(*index))) == NULL)
+      ArgusLog (LOG_ERR, "RaFlowLabelGetIndex: ArgusCalloc error %s\n", strerror(errno));
+
+   if ((index->rules = ArgusCalloc(count, sizeof(*index->rules))) == NULL)
+      ArgusLog (LOG_ERR, "RaFlowLabelGetIndex: ArgusCalloc error %s\n", strerror(errno));
+
+   for (x = 0; x < count; x++) {
+      struct RaFlowLabelStruct *raflow;
+
+      if ((raflow = (void *)ArgusPopQueue(queue, ARGUS_LOCK)) != NULL) {
+         index->rules[index->count] = raflow;
+
+         if (raflow->key.nports) {
+            if (index->ports == NULL)
+               if ((index->ports = ArgusCalloc(0x10000, sizeof(*index->ports))) == NULL)
+                  ArgusLog (LOG_ERR, "RaFlowLabelGetIndex: ArgusCalloc error %s\n", strerror(errno));
+            RaFlowLabelBucketAdd (&index->ports[raflow->key.ports[0].value], index->count);
+         } else
+            RaFlowLabelBucketAdd (&index->generic, index->count);
+
+         index->count++;
+         ArgusAddToQueue (queue, &raflow->qhdr, ARGUS_LOCK);
+      }
+   }
+
+   labeler->ArgusFlowIndex = index;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaFlowLabelGetIndex (%p) %d rules %d unindexed\n", labeler, index->count, index->generic.count);
+#endif
+   return (index);
+}
+
+/*
+ * Run the rules that could match argus, in config order, calling
+ * the match routine for each rule whose filter passes, until a rule
+ * without 'cont' matches.
+ */
+
+typedef void (*RaFlowLabelMatchFunc)(struct RaFlowLabelStruct *, void *);
+
+static int
+RaFlowLabelProcess (struct ArgusLabelerStruct *labeler, struct ArgusRecordStruct *argus,
+                    RaFlowLabelMatchFunc match, void *arg)
+{
+   struct RaFlowLabelIndex *index;
+   struct RaFlowLabelBucket *lists[3];
+   int cursor[3], nlists = 0, found = 0;
+   struct ArgusFlow *flow;
+
+   if ((index = RaFlowLabelGetIndex (labeler)) == NULL)
+      return (0);
+
+   lists[nlists++] = &index->generic;
+
+   if ((index->ports != NULL) && ((flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX]) != NULL) &&
+       ((flow->hdr.subtype & 0x3F) == ARGUS_FLOW_CLASSIC5TUPLE)) {
+      unsigned short sport = 0, dport = 0;
+      int proto = 0;
+
+      switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+         case ARGUS_TYPE_IPV4:
+            proto = flow->ip_flow.ip_p;
+            sport = flow->ip_flow.sport;
+            dport = flow->ip_flow.dport;
+            break;
+         case ARGUS_TYPE_IPV6:
+            proto = flow->ipv6_flow.ip_p;
+            sport = flow->ipv6_flow.sport;
+            dport = flow->ipv6_flow.dport;
+            break;
+      }
+
+      if ((proto == IPPROTO_TCP) || (proto == IPPROTO_UDP)) {
+         lists[nlists++] = &index->ports[sport];
+         if (dport != sport)
+            lists[nlists++] = &index->ports[dport];
+      }
+   }
+
+   bzero(cursor, sizeof(cursor));
+
+   for (;;) {
+      struct RaFlowLabelStruct *raflow;
+      int i, min = -1, rule = index->count;
+
+      for (i = 0; i < nlists; i++) {
+         if ((cursor[i] < lists[i]->count) && (lists[i]->rules[cursor[i]] < rule)) {
+            rule = lists[i]->rules[cursor[i]];
+            min = i;
+         }
+      }
+
+      if (min < 0)
+         break;
+      cursor[min]++;
+
+      raflow = index->rules[rule];
+
+      if (raflow->filterstr != NULL) {
+         if (!RaFlowLabelKeyMatch (&raflow->key, argus))
+            continue;
+         if (ArgusFilterRecord (raflow->filter.bf_insns, argus) == 0)
+            continue;
+      }
+
+      match (raflow, arg);
+      found++;
+
+      if (raflow->cont == 0)
+         break;
+   }
+
+   return (found);
+}
+
+struct RaFlowLabelBuffer {
+   char *buf;
+   int len, found;
+};
+
+static void
+RaFlowLabelAppend (struct RaFlowLabelStruct *raflow, void *arg)
+{
+   struct RaFlowLabelBuffer *lbuf = arg;
+   char *buf = lbuf->buf;
+   int slen = strlen(buf);
+
+   if (lbuf->found) {
+      snprintf (&buf[slen], MAXSTRLEN - slen, ":");
+      slen++;
+   }
+   snprintf (&buf[slen], MAXSTRLEN - slen, "flow=%s", raflow->labelstr);
+   lbuf->found++;
+}
+
 char *
 RaFlowLabel (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus, char *buf, int len)
 {
    struct ArgusLabelerStruct *labeler = NULL;
-   struct RaFlowLabelStruct *raflow = NULL;
-   int found = 0, count = 0, done = 0, x, z;
-   struct ArgusQueueStruct *queue = NULL;
+   struct RaFlowLabelBuffer lbuf;
    char *retn = NULL;
 
    if ((labeler = parser->ArgusLabeler) == NULL)
@@ -5464,40 +5982,16 @@ RaFlowLabel (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus,
 
    bzero (buf, len);
 
-   if ((queue = labeler->ArgusFlowQueue) && ((count = labeler->ArgusFlowQueue->count) > 0)) {
-      for (x = 0, z = count; x < z; x++) {
-         if ((raflow = (void *)ArgusPopQueue(queue, ARGUS_NOLOCK)) != NULL) {
-            if (!done) {
-               int pass = 1;
-               if (raflow->filterstr != NULL) {
-                  struct nff_insn *wfcode = raflow->filter.bf_insns;
-                  pass = ArgusFilterRecord (wfcode, argus);
-               }
-
-               if (pass != 0) {
-                  int slen = strlen(buf);
-                  if (found) {
-                     snprintf (&buf[slen], MAXSTRLEN - slen, ":");
-                     slen++;
-                  }
-                  snprintf (&buf[slen], MAXSTRLEN - slen, "flow=%s", raflow->labelstr);
-                  found++;
-                  if (raflow->cont == 0)
-                     done = 1;
-               }
-            }
-            ArgusAddToQueue (queue, &raflow->qhdr, ARGUS_NOLOCK);
-         }
-      }
-   }
+   lbuf.buf = buf;
+   lbuf.len = len;
+   lbuf.found = 0;
 
-   if (found)
+   if (RaFlowLabelProcess (labeler, argus, RaFlowLabelAppend, &lbuf))
       retn = buf;
 
    return(retn);
 }
 
-
 char *
 ArgusReturnLabel (struct RaAddressStruct *raddr)
 {
@@ -5524,13 +6018,22 @@ ArgusReturnLabel (struct RaAddressStruct *raddr)
 
 char RaFlowColorBuffer[1024];
 
+static void
+RaFlowColorAppend (struct RaFlowLabelStruct *raflow, void *arg)
+{
+   int slen = strlen(RaFlowColorBuffer);
+
+   if (slen) {
+      snprintf (&RaFlowColorBuffer[slen], 1024 - slen, ";");
+      slen++;
+   }
+   snprintf (&RaFlowColorBuffer[slen], 1024 - slen, "%s", raflow->colorstr);
+}
+
 char *
 RaFlowColor (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
 {
    struct ArgusLabelerStruct *labeler = NULL;
-   struct RaFlowLabelStruct *raflow = NULL;
-   struct ArgusQueueStruct *queue = NULL;
-   int count = 0, done = 0, x, z;
    char *retn = NULL;
 
    if ((labeler = parser->ArgusColorLabeler) == NULL)
@@ -5538,31 +6041,7 @@ RaFlowColor (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
 
    bzero (RaFlowColorBuffer, sizeof(RaFlowColorBuffer));
 
-   if ((queue = labeler->ArgusFlowQueue) && ((count = labeler->ArgusFlowQueue->count) > 0)) {
-      for (x = 0, z = count; x < z; x++) {
-         if ((raflow = (void *)ArgusPopQueue(queue, ARGUS_NOLOCK)) != NULL) {
-            if (!done) {
-               int pass = 1;
-               if (raflow->filterstr != NULL) {
-                  struct nff_insn *wfcode = raflow->filter.bf_insns;
-                  pass = ArgusFilterRecord (wfcode, argus);
-               }
-
-               if (pass != 0) {
-                  int slen = strlen(RaFlowColorBuffer);
-                  if (slen) {
-                     snprintf (&RaFlowColorBuffer[slen], 1024 - slen, ";");
-                     slen++;
-                  }
-                  snprintf (&RaFlowColorBuffer[slen], 1024 - slen, "%s", raflow->colorstr);
-                  if (raflow->cont == 0)
-                     done = 1;
-               }
-            }
-            ArgusAddToQueue (queue, &raflow->qhdr, ARGUS_NOLOCK);
-         }
-      }
-   }
+   RaFlowLabelProcess (labeler, argus, RaFlowColorAppend, NULL);
 
    if (strlen(RaFlowColorBuffer))
       retn = RaFlowColorBuffer;
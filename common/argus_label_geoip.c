@@ -423,65 +423,50 @@ ArgusLabelRecordGeoIP(struct ArgusParserStruct *parser,
 #include <maxminddb.h>
 #include "maxminddb-compat-util.h"
 
+/* The values that a geoip2 lookup contributes to the record DSRs,
+ * gathered while walking the entry data list, so they can be cached
+ * along with the formatted label fragment and applied to any record.
+ */
+
+#define ARGUS_GEOIP2_RESULT_LAT		0x01
+#define ARGUS_GEOIP2_RESULT_LON		0x02
+#define ARGUS_GEOIP2_RESULT_ASN		0x04
+
+struct ArgusGeoIP2Result {
+   int flags;
+   float lat, lon;
+   uint32_t asn;
+};
+
 typedef int (*geoip2_fmt_dsr_func)(struct ArgusParserStruct *,
-                                   struct ArgusRecordStruct *,
+                                   struct ArgusGeoIP2Result *,
                                    MMDB_entry_data_list_s *const, void *, int);
 
-/* arg: pointer to integer with direction information.  Can be
- * ARGUS_INODE_ADDR, ARGUS_DST_ADDR or ARGUS_SRC_ADDR.
- */
 static int
 ArgusFormatDSR_GEO(struct ArgusParserStruct *parser,
-                   struct ArgusRecordStruct *argus,
+                   struct ArgusGeoIP2Result *res,
                    MMDB_entry_data_list_s *const value,
                    void *user,
                    int dir)
 {
-   struct ArgusGeoLocationStruct *geo = NULL;
-
-   geo = (struct ArgusGeoLocationStruct *)argus->dsrs[ARGUS_GEO_INDEX];
-   if (geo == NULL) {
-      geo = (struct ArgusGeoLocationStruct *) ArgusCalloc(1, sizeof(*geo));
-      geo->hdr.type = ARGUS_GEO_DSR;
-      geo->hdr.argus_dsrvl8.len = (sizeof(*geo) + 3) / 4;
-      argus->dsrs[ARGUS_GEO_INDEX] = &geo->hdr;
-      argus->dsrindex |= (0x1 << ARGUS_GEO_INDEX);
-   }
-
-   geo->hdr.argus_dsrvl8.qual |= ARGUS_DST_GEO;
    if (!strcmp(user, "latitude")) {
-      if (dir & ARGUS_DST_ADDR)
-         geo->dst.lat = (float)value->entry_data.double_value;
-      else if (dir & ARGUS_SRC_ADDR)
-         geo->src.lat = (float)value->entry_data.double_value;
-      else if (dir == ARGUS_INODE_ADDR)
-         geo->inode.lat = (float)value->entry_data.double_value;
+      res->lat = (float)value->entry_data.double_value;
+      res->flags |= ARGUS_GEOIP2_RESULT_LAT;
    } else if (!strcmp(user, "longitude")) {
-      if (dir & ARGUS_DST_ADDR)
-         geo->dst.lon = (float)value->entry_data.double_value;
-      else if (dir & ARGUS_SRC_ADDR)
-         geo->src.lon = (float)value->entry_data.double_value;
-      else if (dir == ARGUS_INODE_ADDR)
-         geo->inode.lon = (float)value->entry_data.double_value;
+      res->lon = (float)value->entry_data.double_value;
+      res->flags |= ARGUS_GEOIP2_RESULT_LON;
    }
 
    return 1;
 }
 
-/* arg: pointer to integer with direction information.  Can be
- * ARGUS_INODE_ADDR, ARGUS_DST_ADDR or ARGUS_SRC_ADDR.
- */
 static int
 ArgusFormatDSR_ASN(struct ArgusParserStruct *parser,
-                   struct ArgusRecordStruct *argus,
+                   struct ArgusGeoIP2Result *res,
                    MMDB_entry_data_list_s *const value,
                    void *user,
                    int dir)
 {
-   uint32_t vasn = value->entry_data.uint32;
-   struct ArgusAsnStruct *asn = (struct ArgusAsnStruct *) argus->dsrs[ARGUS_ASN_INDEX];
-   struct ArgusFlow *flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX];
-   struct ArgusIcmpStruct *icmp = (void *)argus->dsrs[ARGUS_ICMP_INDEX];
    struct ArgusLabelerStruct *labeler = parser->ArgusLabeler;
 
    if (value->entry_data.type != MMDB_DATA_TYPE_UINT32) {
@@ -493,49 +478,14 @@ ArgusFormatDSR_ASN(struct ArgusParserStruct *parser,
    if (!labeler->RaLabelGeoIPAsn)
       return 0;
 
-   if (flow == NULL)
-      return 0;
-
-   if (asn == NULL) {
-      if ((asn = ArgusCalloc(1, sizeof(*asn))) == NULL)
-         ArgusLog (LOG_ERR, "RaProcessRecord: ArgusCalloc error %s", strerror(errno));
-
-      asn->hdr.type              = ARGUS_ASN_DSR;
-      asn->hdr.subtype           = ARGUS_ASN_ORIGIN;
-      asn->hdr.argus_dsrvl8.qual = 0;
-      asn->hdr.argus_dsrvl8.len  = 3;
-
-      argus->dsrs[ARGUS_ASN_INDEX] = (struct ArgusDSRHeader *) asn;
-      argus->dsrindex |= (0x01 << ARGUS_ASN_INDEX);
-   }
-
-   switch (flow->hdr.subtype & 0x3F) {
-      case ARGUS_FLOW_CLASSIC5TUPLE:
-      case ARGUS_FLOW_LAYER_3_MATRIX:
-         switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
-            case ARGUS_TYPE_IPV4:
-            case ARGUS_TYPE_IPV6:
-
-               if (dir & ARGUS_SRC_ADDR)
-                  asn->src_as = asn->src_as ? asn->src_as : vasn;
-               else if (dir & ARGUS_DST_ADDR)
-                  asn->dst_as = asn->dst_as ? asn->dst_as : vasn;
-               else if (dir == ARGUS_INODE_ADDR && icmp) {
-                  if (icmp->hdr.argus_dsrvl8.qual & ARGUS_ICMP_MAPPED) {
-                     asn->inode_as = vasn;
-                     asn->hdr.argus_dsrvl8.len  = 4;
-                  }
-               }
-               break;
-            }
-         break;
-   }
+   res->asn = value->entry_data.uint32;
+   res->flags |= ARGUS_GEOIP2_RESULT_ASN;
    return 1;
 }
 
 static int
 ArgusFormatDSR_ASNORG(struct ArgusParserStruct *parser,
-                   struct ArgusRecordStruct *argus,
+                   struct ArgusGeoIP2Result *res,
                    MMDB_entry_data_list_s *const value,
                    void *user,
                    int dir)
@@ -552,6 +502,90 @@ ArgusFormatDSR_ASNORG(struct ArgusParserStruct *parser,
    return 1;
 }
 
+/* arg: dir is the direction of the looked up address.  Can be
+ * ARGUS_INODE_ADDR, ARGUS_DST_ADDR or ARGUS_SRC_ADDR.
+ */
+static void
+ArgusApplyGeoIP2Result(struct ArgusParserStruct *parser,
+                       struct ArgusRecordStruct *argus,
+                       struct ArgusGeoIP2Result *res,
+                       int dir)
+{
+   if (res->flags & (ARGUS_GEOIP2_RESULT_LAT | ARGUS_GEOIP2_RESULT_LON)) {
+      struct ArgusGeoLocationStruct *geo = NULL;
+
+      geo = (struct ArgusGeoLocationStruct *)argus->dsrs[ARGUS_GEO_INDEX];
+      if (geo == NULL) {
+         geo = (struct ArgusGeoLocationStruct *) ArgusCalloc(1, sizeof(*geo));
+         geo->hdr.type = ARGUS_GEO_DSR;
+         geo->hdr.argus_dsrvl8.len = (sizeof(*geo) + 3) / 4;
+         argus->dsrs[ARGUS_GEO_INDEX] = &geo->hdr;
+         argus->dsrindex |= (0x1 << ARGUS_GEO_INDEX);
+      }
+
+      geo->hdr.argus_dsrvl8.qual |= ARGUS_DST_GEO;
+      if (res->flags & ARGUS_GEOIP2_RESULT_LAT) {
+         if (dir & ARGUS_DST_ADDR)
+            geo->dst.lat = res->lat;
+         else if (dir & ARGUS_SRC_ADDR)
+            geo->src.lat = res->lat;
+         else if (dir == ARGUS_INODE_ADDR)
+            geo->inode.lat = res->lat;
+      }
+      if (res->flags & ARGUS_GEOIP2_RESULT_LON) {
+         if (dir & ARGUS_DST_ADDR)
+            geo->dst.lon = res->lon;
+         else if (dir & ARGUS_SRC_ADDR)
+            geo->src.lon = res->lon;
+         else if (dir == ARGUS_INODE_ADDR)
+            geo->inode.lon = res->lon;
+      }
+   }
+
+   if (res->flags & ARGUS_GEOIP2_RESULT_ASN) {
+      struct ArgusAsnStruct *asn = (struct ArgusAsnStruct *) argus->dsrs[ARGUS_ASN_INDEX];
+      struct ArgusFlow *flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX];
+      struct ArgusIcmpStruct *icmp = (void *)argus->dsrs[ARGUS_ICMP_INDEX];
+
+      if (flow == NULL)
+         return;
+
+      if (asn == NULL) {
+         if ((asn = ArgusCalloc(1, sizeof(*asn))) == NULL)
+            ArgusLog (LOG_ERR, "RaProcessRecord: ArgusCalloc error %s", strerror(errno));
+
+         asn->hdr.type              = ARGUS_ASN_DSR;
+         asn->hdr.subtype           = ARGUS_ASN_ORIGIN;
+         asn->hdr.argus_dsrvl8.qual = 0;
+         asn->hdr.argus_dsrvl8.len  = 3;
+
+         argus->dsrs[ARGUS_ASN_INDEX] = (struct ArgusDSRHeader *) asn;
+         argus->dsrindex |= (0x01 << ARGUS_ASN_INDEX);
+      }
+
+      switch (flow->hdr.subtype & 0x3F) {
+         case ARGUS_FLOW_CLASSIC5TUPLE:
+         case ARGUS_FLOW_LAYER_3_MATRIX:
+            switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+               case ARGUS_TYPE_IPV4:
+               case ARGUS_TYPE_IPV6:
+
+                  if (dir & ARGUS_SRC_ADDR)
+                     asn->src_as = asn->src_as ? asn->src_as : res->asn;
+                  else if (dir & ARGUS_DST_ADDR)
+                     asn->dst_as = asn->dst_as ? asn->dst_as : res->asn;
+                  else if (dir == ARGUS_INODE_ADDR && icmp) {
+                     if (icmp->hdr.argus_dsrvl8.qual & ARGUS_ICMP_MAPPED) {
+                        asn->inode_as = res->asn;
+                        asn->hdr.argus_dsrvl8.len  = 4;
+                     }
+                  }
+                  break;
+               }
+            break;
+      }
+   }
+}
 
 static int _geoip2_to_argus_names_sorted = 0;
 typedef struct _geoip2_to_argus_names {
@@ -627,7 +661,7 @@ is_item_enabled(struct ArgusParserStruct *parser, int item)
 static MMDB_entry_data_list_s *
 dump_entry_data_list(
     struct ArgusParserStruct *parser,
-    struct ArgusRecordStruct *argus,
+    struct ArgusGeoIP2Result *res,
     MMDB_entry_data_list_s *entry_data_list,
     const char * const path, /* where we are in the data structure, e.g.
                               * "country names"
@@ -669,7 +703,7 @@ dump_entry_data_list(
             free(key);
 
             entry_data_list = entry_data_list->next;
-            entry_data_list = dump_entry_data_list(parser, argus, entry_data_list, nextpath, str,
+            entry_data_list = dump_entry_data_list(parser, res, entry_data_list, nextpath, str,
                                          str_offset, str_remain, dir, status);
 
             ArgusFree(nextpath);
@@ -685,7 +719,7 @@ dump_entry_data_list(
          uint32_t size = entry_data_list->entry_data.data_size;
 
          for (entry_data_list = entry_data_list->next; size && entry_data_list; size--) {
-            entry_data_list = dump_entry_data_list(parser, argus, entry_data_list, path, str,
+            entry_data_list = dump_entry_data_list(parser, res, entry_data_list, path, str,
                                          str_offset, str_remain, dir, status);
             if (MMDB_SUCCESS != *status) {
                return NULL;
@@ -727,15 +761,15 @@ dump_entry_data_list(
 
    if (xlate->fmt_dsr_func) {
       char *key = strrchr(gkey.geoip2_path, ' ');
-      int res;
+      int fres;
 
       if (key == NULL)
          key = gkey.geoip2_path;
       else
          key++;
 
-      res = xlate->fmt_dsr_func(parser, argus, entry_data_list, key, dir);
-      if (res < 0)
+      fres = xlate->fmt_dsr_func(parser, res, entry_data_list, key, dir);
+      if (fres < 0)
          ArgusLog(LOG_WARNING, "%s: path=\"%s\": DSR formatting function failed\n", __func__, path);
    }
    free(gkey.geoip2_path);
@@ -868,7 +902,7 @@ out:
 static MMDB_entry_data_list_s *
 dump_result_entry_data_list(
     struct ArgusParserStruct *parser,
-    struct ArgusRecordStruct *argus,
+    struct ArgusGeoIP2Result *res,
     MMDB_lookup_result_s *result,
     const char * const path, /* where we are in the data structure, e.g.
                               * "country names"
@@ -898,7 +932,7 @@ dump_result_entry_data_list(
        return NULL;
    }
 
-   rv = dump_entry_data_list(parser, argus, entry_data_list, path,
+   rv = dump_entry_data_list(parser, res, entry_data_list, path,
                         str, str_offset, str_remain,
                         dir, status);
 
@@ -911,10 +945,165 @@ dump_result_entry_data_list(
    return rv;
 }
 
+/*
+ * Per-address result cache.
+ *
+ * Traffic is dominated by a relatively small set of addresses, so the
+ * formatted label fragment and the DSR values for each (database,
+ * direction, address) are remembered in a bounded, 4-way set associative
+ * cache with LRU replacement within each set.  The cache belongs to the
+ * labeler, and is only touched by the thread doing the labeling, so
+ * there is no locking on the lookup path.  Negative results are cached
+ * as well, since unknown addresses are just as expensive to look up.
+ */
+
+#define ARGUS_GEOIP2_CACHE_WAYS		4
+#define ARGUS_GEOIP2_CACHE_FRAGLEN	512
+
+#define ARGUS_GEOIP2_CITY_DB		0
+#define ARGUS_GEOIP2_ASN_DB		1
+
+struct ArgusGeoIP2CacheEntry {
+   unsigned int stamp;
+   unsigned char db, dir, family, found;
+   unsigned char addr[16];
+   struct ArgusGeoIP2Result result;
+   char frag[ARGUS_GEOIP2_CACHE_FRAGLEN];
+};
+
+struct ArgusGeoIP2Cache {
+   struct ArgusGeoIP2CacheEntry *entries;
+   unsigned int sets, clock;
+   unsigned long long hits, misses, evictions;
+};
+
+static struct ArgusGeoIP2Cache *
+ArgusNewGeoIP2Cache(int size)
+{
+   struct ArgusGeoIP2Cache *retn = NULL;
+   unsigned int sets = 1;
+
+   if (size <= 0)
+      return NULL;
+
+   while ((sets * ARGUS_GEOIP2_CACHE_WAYS) < (unsigned int) size)
+      sets <<= 1;
+
+   if ((retn = ArgusCalloc(1, sizeof(*retn))) == NULL)
+      ArgusLog (LOG_ERR, "ArgusNewGeoIP2Cache: ArgusCalloc error %s", strerror(errno));
+
+   if ((retn->entries = ArgusCalloc(sets * ARGUS_GEOIP2_CACHE_WAYS, sizeof(*retn->entries))) == NULL)
+      ArgusLog (LOG_ERR, "ArgusNewGeoIP2Cache: ArgusCalloc error %s", strerror(errno));
+
+   retn->sets = sets;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (1, "ArgusNewGeoIP2Cache (%d) %u sets returning %p\n", size, sets, retn);
+#endif
+   return (retn);
+}
+
+void
+ArgusDeleteGeoIP2Cache(struct ArgusLabelerStruct *labeler)
+{
+   struct ArgusGeoIP2Cache *cache;
+
+   if ((cache = labeler->RaGeoIPCache) != NULL) {
+#ifdef ARGUSDEBUG
+      ArgusDebug (1, "ArgusDeleteGeoIP2Cache (%p) hits %llu misses %llu evictions %llu\n",
+                     labeler, cache->hits, cache->misses, cache->evictions);
+#endif
+      ArgusFree(cache->entries);
+      ArgusFree(cache);
+      labeler->RaGeoIPCache = NULL;
+   }
+}
+
+/* drop all cached results, e.g. when a database is (re)opened */
+void
+ArgusFlushGeoIP2Cache(struct ArgusLabelerStruct *labeler)
+{
+   struct ArgusGeoIP2Cache *cache;
+
+   if ((cache = labeler->RaGeoIPCache) != NULL) {
+      bzero(cache->entries, cache->sets * ARGUS_GEOIP2_CACHE_WAYS * sizeof(*cache->entries));
+      cache->clock = 0;
+   }
+}
+
+static struct ArgusGeoIP2CacheEntry *
+ArgusFindGeoIP2CacheEntry(struct ArgusGeoIP2Cache *cache, int db, int dir,
+                          struct sockaddr *sa, int *hit)
+{
+   struct ArgusGeoIP2CacheEntry *set, *ent, *victim;
+   unsigned char addr[16];
+   unsigned int hash, family = sa->sa_family;
+   int i, alen;
+
+   bzero(addr, sizeof(addr));
+   if (family == AF_INET) {
+      struct sockaddr_in *sin = (struct sockaddr_in *) sa;
+      alen = sizeof(sin->sin_addr.s_addr);
+      bcopy(&sin->sin_addr.s_addr, addr, alen);
+   } else {
+      struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) sa;
+      alen = sizeof(sin6->sin6_addr.s6_addr);
+      bcopy(sin6->sin6_addr.s6_addr, addr, alen);
+   }
+
+   hash = (db << 4) | dir;
+   for (i = 0; i < alen; i += 4) {
+      unsigned int word;
+      bcopy(&addr[i], &word, sizeof(word));
+      hash = (hash ^ word) * 0x9E3779B1;
+   }
+   hash ^= hash >> 15;
+
+   set = &cache->entries[(hash & (cache->sets - 1)) * ARGUS_GEOIP2_CACHE_WAYS];
+   victim = set;
+
+   if (++cache->clock == 0) {
+      /* stamp wrapped, restart the ages so LRU order stays sane */
+      for (i = 0; i < (int)(cache->sets * ARGUS_GEOIP2_CACHE_WAYS); i++)
+         if (cache->entries[i].stamp)
+            cache->entries[i].stamp = 1;
+      cache->clock = 2;
+   }
+
+   for (i = 0, ent = set; i < ARGUS_GEOIP2_CACHE_WAYS; i++, ent++) {
+      if (ent->stamp && (ent->db == db) && (ent->dir == dir) &&
+          (ent->family == family) && !memcmp(ent->addr, addr, sizeof(addr))) {
+         ent->stamp = cache->clock;
+         cache->hits++;
+         *hit = 1;
+         return ent;
+      }
+      if (ent->stamp < victim->stamp)
+         victim = ent;
+   }
+
+   if (victim->stamp)
+      cache->evictions++;
+
+   cache->misses++;
+   victim->stamp  = cache->clock;
+   victim->db     = db;
+   victim->dir    = dir;
+   victim->family = family;
+   victim->found  = 0;
+   bcopy(addr, victim->addr, sizeof(addr));
+   bzero(&victim->result, sizeof(victim->result));
+   victim->frag[0] = '\0';
+   *hit = 0;
+   return victim;
+}
+
 static int
-lookup_city(
+lookup_geoip2(
     struct ArgusParserStruct *parser,
     struct ArgusRecordStruct *argus,
+    MMDB_s *mmdb,
+    int db,
     const char * const path, /* where we are in the data structure, e.g.
                               * "country names"
                               */
@@ -928,41 +1117,92 @@ lookup_city(
    int mmdb_error;
    MMDB_lookup_result_s result;
    struct ArgusLabelerStruct *labeler = parser->ArgusLabeler;
+   struct ArgusGeoIP2CacheEntry *ent = NULL;
+   struct ArgusGeoIP2Result res;
+
+   if ((labeler->RaGeoIPCache == NULL) && (labeler->RaGeoIPCacheSize > 0))
+      labeler->RaGeoIPCache = ArgusNewGeoIP2Cache(labeler->RaGeoIPCacheSize);
+
+   if (labeler->RaGeoIPCache != NULL) {
+      int hit = 0;
 
-   result = MMDB_lookup_sockaddr(&labeler->RaGeoIPCityObject, sa, &mmdb_error);
-   if (result.found_entry) {
-      dump_result_entry_data_list(parser, argus, &result, path, str,
-                                  str_offset, str_remain, dir, &status);
-      return 1;
+      ent = ArgusFindGeoIP2CacheEntry(labeler->RaGeoIPCache, db, dir, sa, &hit);
+      if (hit) {
+         if (ent->found) {
+            ArgusApplyGeoIP2Result(parser, argus, &ent->result, dir);
+            if (ent->frag[0])
+               (void)snprintf_append(str, str_offset, str_remain, "%s", ent->frag);
+         }
+         return ent->found;
+      }
    }
-   return 0;
+
+   result = MMDB_lookup_sockaddr(mmdb, sa, &mmdb_error);
+   if (!result.found_entry)
+      return 0;
+
+   bzero(&res, sizeof(res));
+
+   if (ent != NULL) {
+      size_t frag_offset = 0, frag_remain = sizeof(ent->frag);
+
+      dump_result_entry_data_list(parser, &res, &result, path, ent->frag,
+                                  &frag_offset, &frag_remain, dir, &status);
+
+      if (frag_remain > 0) {
+         ent->result = res;
+         ent->found = 1;
+         ArgusApplyGeoIP2Result(parser, argus, &res, dir);
+         if (ent->frag[0])
+            (void)snprintf_append(str, str_offset, str_remain, "%s", ent->frag);
+         return 1;
+      }
+
+      /* fragment too large to cache, release the slot and format
+       * directly into the label */
+      ent->stamp = 0;
+      ent->frag[0] = '\0';
+      bzero(&res, sizeof(res));
+   }
+
+   dump_result_entry_data_list(parser, &res, &result, path, str,
+                               str_offset, str_remain, dir, &status);
+   ArgusApplyGeoIP2Result(parser, argus, &res, dir);
+   return 1;
+}
+
+static int
+lookup_city(
+    struct ArgusParserStruct *parser,
+    struct ArgusRecordStruct *argus,
+    const char * const path,
+    struct sockaddr *sa,
+    char *str,
+    size_t *str_offset,
+    size_t *str_remain,
+    int dir)
+{
+   struct ArgusLabelerStruct *labeler = parser->ArgusLabeler;
+
+   return lookup_geoip2(parser, argus, &labeler->RaGeoIPCityObject, ARGUS_GEOIP2_CITY_DB,
+                        path, sa, str, str_offset, str_remain, dir);
 }
 
 static int
 lookup_asn(
     struct ArgusParserStruct *parser,
     struct ArgusRecordStruct *argus,
-    const char * const path, /* where we are in the data structure, e.g.
-                              * "country names"
-                              */
+    const char * const path,
     struct sockaddr *sa,
-    char *str,               /* output string */
-    size_t *str_offset,      /* string end pointer (IN/OUT) */
-    size_t *str_remain,      /* remaining bytes allocated for string (IN/OUT) */
+    char *str,
+    size_t *str_offset,
+    size_t *str_remain,
     int dir)
 {
-   int status;
-   int mmdb_error;
-   MMDB_lookup_result_s result;
    struct ArgusLabelerStruct *labeler = parser->ArgusLabeler;
 
-   result = MMDB_lookup_sockaddr(&labeler->RaGeoIPAsnObject, sa, &mmdb_error);
-   if (result.found_entry) {
-      dump_result_entry_data_list(parser, argus, &result, path, str,
-                                  str_offset, str_remain, dir, &status);
-      return 1;
-   }
-   return 0;
+   return lookup_geoip2(parser, argus, &labeler->RaGeoIPAsnObject, ARGUS_GEOIP2_ASN_DB,
+                        path, sa, str, str_offset, str_remain, dir);
 }
 
 int
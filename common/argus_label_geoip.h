@@ -39,6 +39,8 @@ int ArgusLabelRecordGeoIP(struct ArgusParserStruct *,
 #endif
 
 #if defined(ARGUS_GEOIP2)
+struct ArgusLabelerStruct;
+
 int ArgusLabelRecordGeoIP2(struct ArgusParserStruct *,
                            struct ArgusRecordStruct *, char *, size_t, int *);
 int ArgusGeoIP2FindObject(const char * const);
@@ -46,4 +48,6 @@ int ArgusGeoIP2FindObject(const char * const);
 int geoip2_path_compare(const void *, const void *);
 int ArgusLabelRecordGeoIP2(struct ArgusParserStruct *, struct ArgusRecordStruct *, char *, size_t, int *);
 int ArgusGeoIP2FindObject(const char * const);
+void ArgusFlushGeoIP2Cache(struct ArgusLabelerStruct *);
+void ArgusDeleteGeoIP2Cache(struct ArgusLabelerStruct *);
 #endif
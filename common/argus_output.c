@@ -3729,8 +3729,13 @@ __ArgusOutputProcess(struct ArgusOutputStruct *output,
                ts->tv_sec++;
                ts->tv_nsec -= 1000000000;
             }
+
+/* recheck under the lock, a producer that signals only on the first
+   record pushed may have pushed and signalled since the test above */
+
             pthread_mutex_lock(&list->lock);
-            pthread_cond_timedwait(&list->cond, &list->lock, ts);
+            if (ArgusListEmpty(list))
+               pthread_cond_timedwait(&list->cond, &list->lock, ts);
             pthread_mutex_unlock(&list->lock);
          }
 #endif
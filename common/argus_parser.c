@@ -53,6 +53,7 @@
 #include <argus_util.h>
 #include <argus_client.h>
 #include <argus_main.h>
+#include <argus_grep.h>
 
 struct ArgusParserStruct *ArgusParser = NULL; 
 
@@ -137,6 +138,10 @@ ArgusInitializeParser(struct ArgusParserStruct *parser)
    parser->ArgusTotalRecords    = 0;
    parser->ArgusTotalMarRecords = 0;
    parser->ArgusTotalFarRecords = 0;
+   parser->ArgusTimeRejects     = 0;
+   parser->ArgusHeaderRejects   = 0;
+   parser->ArgusLazyRejects     = 0;
+   parser->ArgusFilterRejects   = 0;
    parser->ArgusTotalPkts       = 0;
    parser->ArgusTotalSrcPkts    = 0;
    parser->ArgusTotalDstPkts    = 0;
@@ -328,10 +333,17 @@ ArgusCloseParser(struct ArgusParserStruct *parser)
          regfree(&parser->upreg[i]);
    }
 
+   if (parser->ArgusGrepMatcher != NULL) {
+      ArgusDeleteGrepMatcher(parser->ArgusGrepMatcher);
+      parser->ArgusGrepMatcher = NULL;
+   }
+
    if (parser->ArgusMatchLabel != NULL) {
       free(parser->ArgusMatchLabel);
       parser->ArgusMatchLabel = NULL;
       regfree(&parser->lpreg);
+      ArgusDeleteGrepMatcher(parser->ArgusLabelMatcher);
+      parser->ArgusLabelMatcher = NULL;
    }
 
    if (parser->ArgusMatchGroup != NULL) {
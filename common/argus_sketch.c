@@ -0,0 +1,833 @@
+/*
+ * Argus-5.0 Client Software. Tools to read, analyze and manage Argus data.
+ * Copyright (c) 2000-2024 QoSient, LLC
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+/*
+ * argus_sketch.c  - fixed memory distinct counters and heavy hitter
+ *                   tables, and the file format used to save and merge
+ *                   them.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "argus_config.h"
+#endif
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <math.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+
+#include <argus_compat.h>
+#include <argus_def.h>
+#include <argus_out.h>
+
+#include <argus_util.h>
+#include <argus_client.h>
+#include <argus_main.h>
+#include <argus_sketch.h>
+
+
+/*
+ * 64 bit FNV-1a, with the murmur3 finalizer, so that the high bits
+ * used for the HLL register index are well mixed.
+ */
+
+unsigned long long
+ArgusSketchHash (void *buf, int len)
+{
+   unsigned long long hash = 0xcbf29ce484222325ULL;
+   unsigned char *ptr = buf;
+   int i;
+
+   for (i = 0; i < len; i++) {
+      hash ^= ptr[i];
+      hash *= 0x100000001b3ULL;
+   }
+
+   hash ^= hash >> 33;
+   hash *= 0xff51afd7ed558ccdULL;
+   hash ^= hash >> 33;
+   hash *= 0xc4ceb9fe1a85ec53ULL;
+   hash ^= hash >> 33;
+   return (hash);
+}
+
+
+struct ArgusHLLStruct *
+ArgusNewHLL (int p)
+{
+   struct ArgusHLLStruct *retn = NULL;
+
+   if ((p < ARGUS_HLL_MINP) || (p > ARGUS_HLL_MAXP))
+      return (retn);
+
+   if ((retn = ArgusCalloc (1, sizeof(*retn))) != NULL) {
+      retn->p = p;
+      retn->m = 1 << p;
+      if ((retn->reg = ArgusCalloc (retn->m, sizeof(*retn->reg))) == NULL) {
+         ArgusFree (retn);
+         retn = NULL;
+      }
+   }
+   return (retn);
+}
+
+void
+ArgusDeleteHLL (struct ArgusHLLStruct *hll)
+{
+   if (hll != NULL) {
+      if (hll->reg != NULL)
+         ArgusFree (hll->reg);
+      ArgusFree (hll);
+   }
+}
+
+void
+ArgusHLLAdd (struct ArgusHLLStruct *hll, unsigned long long hash)
+{
+   unsigned int index = hash >> (64 - hll->p);
+   unsigned long long w = hash << hll->p;
+   unsigned char rho = 1, max = (64 - hll->p) + 1;
+
+   while ((rho < max) && !(w & 0x8000000000000000ULL)) {
+      w <<= 1;
+      rho++;
+   }
+
+   if (hll->reg[index] < rho)
+      hll->reg[index] = rho;
+}
+
+double
+ArgusHLLCount (struct ArgusHLLStruct *hll)
+{
+   double m = hll->m, sum = 0.0, alpha, estimate;
+   int i, zeros = 0;
+
+   switch (hll->m) {
+      case 16: alpha = 0.673; break;
+      case 32: alpha = 0.697; break;
+      case 64: alpha = 0.709; break;
+      default: alpha = 0.7213 / (1.0 + 1.079 / m); break;
+   }
+
+   for (i = 0; i < hll->m; i++) {
+      sum += ldexp(1.0, -hll->reg[i]);
+      if (hll->reg[i] == 0)
+         zeros++;
+   }
+
+   estimate = (alpha * m * m) / sum;
+
+   if ((estimate <= (2.5 * m)) && (zeros > 0))
+      estimate = m * log(m / zeros);
+
+   return (estimate);
+}
+
+double
+ArgusHLLError (struct ArgusHLLStruct *hll)
+{
+   return (1.04 / sqrt((double) hll->m));
+}
+
+int
+ArgusMergeHLL (struct ArgusHLLStruct *dst, struct ArgusHLLStruct *src)
+{
+   int i;
+
+   if (dst->p != src->p)
+      return (-1);
+
+   for (i = 0; i < dst->m; i++)
+      if (dst->reg[i] < src->reg[i])
+         dst->reg[i] = src->reg[i];
+
+   return (0);
+}
+
+
+/*
+ * Space-Saving.  The entries are kept in a min heap on count, so the
+ * smallest can be replaced, and are found through a chained hash on
+ * the key.
+ */
+
+struct ArgusTopKStruct *
+ArgusNewTopK (int k, int p)
+{
+   struct ArgusTopKStruct *retn = NULL;
+   int i;
+
+   if (k <= 0)
+      return (retn);
+
+   if ((retn = ArgusCalloc (1, sizeof(*retn))) == NULL)
+      return (retn);
+
+   retn->k = k;
+   retn->p = p;
+   for (retn->buckets = 1; retn->buckets < k; retn->buckets <<= 1) ;
+
+   if (((retn->entries = ArgusCalloc (k, sizeof(*retn->entries))) == NULL) ||
+       ((retn->heap    = ArgusCalloc (k, sizeof(*retn->heap))) == NULL) ||
+       ((retn->bucket  = ArgusCalloc (retn->buckets, sizeof(*retn->bucket))) == NULL)) {
+      ArgusDeleteTopK (retn);
+      return (NULL);
+   }
+
+   for (i = 0; i < retn->buckets; i++)
+      retn->bucket[i] = -1;
+
+   return (retn);
+}
+
+void
+ArgusDeleteTopK (struct ArgusTopKStruct *topk)
+{
+   int i;
+
+   if (topk != NULL) {
+      if (topk->entries != NULL) {
+         for (i = 0; i < topk->count; i++)
+            ArgusDeleteHLL (topk->entries[i].hll);
+         ArgusFree (topk->entries);
+      }
+      if (topk->heap != NULL)
+         ArgusFree (topk->heap);
+      if (topk->bucket != NULL)
+         ArgusFree (topk->bucket);
+      ArgusFree (topk);
+   }
+}
+
+static void
+ArgusTopKSwap (struct ArgusTopKStruct *topk, int a, int b)
+{
+   int tmp = topk->heap[a];
+
+   topk->heap[a] = topk->heap[b];
+   topk->heap[b] = tmp;
+   topk->entries[topk->heap[a]].heap = a;
+   topk->entries[topk->heap[b]].heap = b;
+}
+
+static void
+ArgusTopKSiftUp (struct ArgusTopKStruct *topk, int i)
+{
+   while (i > 0) {
+      int parent = (i - 1) / 2;
+      if (topk->entries[topk->heap[parent]].count <= topk->entries[topk->heap[i]].count)
+         break;
+      ArgusTopKSwap (topk, i, parent);
+      i = parent;
+   }
+}
+
+static void
+ArgusTopKSiftDown (struct ArgusTopKStruct *topk, int i)
+{
+   for (;;) {
+      int l = (2 * i) + 1, r = l + 1, min = i;
+
+      if ((l < topk->count) && (topk->entries[topk->heap[l]].count < topk->entries[topk->heap[min]].count))
+         min = l;
+      if ((r < topk->count) && (topk->entries[topk->heap[r]].count < topk->entries[topk->heap[min]].count))
+         min = r;
+      if (min == i)
+         break;
+      ArgusTopKSwap (topk, i, min);
+      i = min;
+   }
+}
+
+static struct ArgusTopKEntryStruct *
+ArgusTopKFind (struct ArgusTopKStruct *topk, void *key, int len, unsigned int hash)
+{
+   int i;
+
+   for (i = topk->bucket[hash & (topk->buckets - 1)]; i >= 0; i = topk->entries[i].nxt) {
+      struct ArgusTopKEntryStruct *entry = &topk->entries[i];
+      if ((entry->hash == hash) && (entry->len == len) && !bcmp(entry->key, key, len))
+         return (entry);
+   }
+   return (NULL);
+}
+
+static void
+ArgusTopKUnlink (struct ArgusTopKStruct *topk, int i)
+{
+   int *ptr = &topk->bucket[topk->entries[i].hash & (topk->buckets - 1)];
+
+   while (*ptr != i)
+      ptr = &topk->entries[*ptr].nxt;
+   *ptr = topk->entries[i].nxt;
+}
+
+static void
+ArgusTopKLink (struct ArgusTopKStruct *topk, int i)
+{
+   int *ptr = &topk->bucket[topk->entries[i].hash & (topk->buckets - 1)];
+
+   topk->entries[i].nxt = *ptr;
+   *ptr = i;
+}
+
+/*
+ * Add weight to a key.  When the table is full, the key takes the
+ * place of the smallest entry, and starts from its count, which is
+ * recorded as the key's error.  Returns the key's entry, so callers
+ * can update the entry's HLL.
+ */
+
+struct ArgusTopKEntryStruct *
+ArgusTopKUpdate (struct ArgusTopKStruct *topk, void *key, int len, unsigned long long weight)
+{
+   struct ArgusTopKEntryStruct *entry;
+   unsigned int hash;
+   int i;
+
+   if (len > ARGUS_SKETCH_KEYLEN)
+      len = ARGUS_SKETCH_KEYLEN;
+
+   hash = ArgusSketchHash(key, len);
+   topk->total += weight;
+
+   if ((entry = ArgusTopKFind (topk, key, len, hash)) != NULL) {
+      entry->count += weight;
+      ArgusTopKSiftDown (topk, entry->heap);
+      return (entry);
+   }
+
+   if (topk->count < topk->k) {
+      i = topk->count++;
+      entry = &topk->entries[i];
+      bzero (entry, sizeof(*entry));
+      if (topk->p && ((entry->hll = ArgusNewHLL(topk->p)) == NULL))
+         ArgusLog (LOG_ERR, "ArgusTopKUpdate: ArgusNewHLL error %s", strerror(errno));
+
+      entry->heap = i;
+      topk->heap[i] = i;
+      entry->count = weight;
+
+   } else {
+      i = topk->heap[0];
+      entry = &topk->entries[i];
+      ArgusTopKUnlink (topk, i);
+
+      entry->error  = entry->count;
+      entry->count += weight;
+      entry->flags  = 0;
+      if (entry->hll != NULL)
+         bzero (entry->hll->reg, entry->hll->m);
+   }
+
+   entry->hash = hash;
+   entry->len  = len;
+   bcopy (key, entry->key, len);
+   ArgusTopKLink (topk, i);
+
+   ArgusTopKSiftUp (topk, entry->heap);
+   ArgusTopKSiftDown (topk, entry->heap);
+   return (entry);
+}
+
+/*
+ * The most that any count can be over, and the most that a key that
+ * isn't in the table can have been seen.
+ */
+
+unsigned long long
+ArgusTopKError (struct ArgusTopKStruct *topk)
+{
+   if (topk->count < topk->k)
+      return (0);
+   return (topk->entries[topk->heap[0]].count);
+}
+
+static int
+ArgusTopKEntryCompare (const void *a, const void *b)
+{
+   const struct ArgusTopKEntryStruct *ea = a, *eb = b;
+
+   if (ea->count > eb->count) return (-1);
+   if (ea->count < eb->count) return (1);
+   return (0);
+}
+
+static int
+ArgusTopKCompare (const void *a, const void *b)
+{
+   return (ArgusTopKEntryCompare (*(void **) a, *(void **) b));
+}
+
+/*
+ * Fill list, which holds k pointers, with the entries, largest count
+ * first.  Returns the number of entries.
+ */
+
+int
+ArgusTopKSort (struct ArgusTopKStruct *topk, struct ArgusTopKEntryStruct **list)
+{
+   int i;
+
+   for (i = 0; i < topk->count; i++)
+      list[i] = &topk->entries[i];
+
+   qsort (list, topk->count, sizeof(*list), ArgusTopKCompare);
+   return (topk->count);
+}
+
+/*
+ * Merge src into dst.  Keys missing from one of the tables could have
+ * been seen there as many times as that table's smallest count, so
+ * that is added to both their count and error, and the k largest are
+ * kept.
+ */
+
+int
+ArgusMergeTopK (struct ArgusTopKStruct *dst, struct ArgusTopKStruct *src)
+{
+   struct ArgusTopKEntryStruct *list, *entry, *sentry;
+   unsigned long long dmin = ArgusTopKError(dst), smin = ArgusTopKError(src);
+   int i, count = 0;
+
+   if (dst->p != src->p)
+      return (-1);
+
+   if ((list = ArgusCalloc (dst->count + src->count, sizeof(*list))) == NULL)
+      ArgusLog (LOG_ERR, "ArgusMergeTopK: ArgusCalloc error %s", strerror(errno));
+
+   for (i = 0; i < dst->count; i++) {
+      entry = &list[count++];
+      *entry = dst->entries[i];
+
+      if ((sentry = ArgusTopKFind (src, entry->key, entry->len, entry->hash)) != NULL) {
+         entry->count += sentry->count;
+         entry->error += sentry->error;
+         if (entry->flags == 0)
+            entry->flags = sentry->flags;
+         if (entry->hll && sentry->hll)
+            ArgusMergeHLL (entry->hll, sentry->hll);
+      } else {
+         entry->count += smin;
+         entry->error += smin;
+      }
+   }
+
+   for (i = 0; i < src->count; i++) {
+      sentry = &src->entries[i];
+      if (ArgusTopKFind (dst, sentry->key, sentry->len, sentry->hash) == NULL) {
+         entry = &list[count++];
+         *entry = *sentry;
+         entry->count += dmin;
+         entry->error += dmin;
+         if (sentry->hll != NULL) {
+            if ((entry->hll = ArgusNewHLL(sentry->hll->p)) == NULL)
+               ArgusLog (LOG_ERR, "ArgusMergeTopK: ArgusNewHLL error %s", strerror(errno));
+            ArgusMergeHLL (entry->hll, sentry->hll);
+         }
+      }
+   }
+
+   qsort (list, count, sizeof(*list), ArgusTopKEntryCompare);
+
+   for (i = dst->k; i < count; i++)
+      ArgusDeleteHLL (list[i].hll);
+
+   dst->count = (count > dst->k) ? dst->k : count;
+   dst->total += src->total;
+
+   for (i = 0; i < dst->buckets; i++)
+      dst->bucket[i] = -1;
+
+   for (i = 0; i < dst->count; i++) {
+      dst->entries[i] = list[i];
+      dst->entries[i].heap = i;
+      dst->heap[i] = i;
+      ArgusTopKLink (dst, i);
+   }
+
+   for (i = (dst->count / 2) - 1; i >= 0; i--)
+      ArgusTopKSiftDown (dst, i);
+
+   ArgusFree (list);
+   return (0);
+}
+
+
+/*
+ * Named sets of sketches, and their file format.  The file is the
+ * magic string, the version and the number of sketches, then, for each
+ * sketch, its type, name and contents.  Integers are in network byte
+ * order, the counters are written as two 32 bit words, high word first.
+ */
+
+struct ArgusSketchSetStruct *
+ArgusNewSketchSet (void)
+{
+   return (ArgusCalloc (1, sizeof(struct ArgusSketchSetStruct)));
+}
+
+void
+ArgusDeleteSketchSet (struct ArgusSketchSetStruct *set)
+{
+   struct ArgusSketchStruct *sketch, *nxt;
+
+   if (set != NULL) {
+      for (sketch = set->start; sketch != NULL; sketch = nxt) {
+         nxt = sketch->nxt;
+         switch (sketch->type) {
+            case ARGUS_SKETCH_HLL:  ArgusDeleteHLL (sketch->sketch); break;
+            case ARGUS_SKETCH_TOPK: ArgusDeleteTopK (sketch->sketch); break;
+         }
+         free (sketch->name);
+         ArgusFree (sketch);
+      }
+      ArgusFree (set);
+   }
+}
+
+struct ArgusSketchStruct *
+ArgusFindSketch (struct ArgusSketchSetStruct *set, char *name)
+{
+   struct ArgusSketchStruct *sketch;
+
+   for (sketch = set->start; sketch != NULL; sketch = sketch->nxt)
+      if (!strcmp (sketch->name, name))
+         return (sketch);
+
+   return (NULL);
+}
+
+static struct ArgusSketchStruct *
+ArgusAddSketch (struct ArgusSketchSetStruct *set, char *name, int type, void *ptr)
+{
+   struct ArgusSketchStruct *sketch, **tail = &set->start;
+
+   if ((sketch = ArgusCalloc (1, sizeof(*sketch))) == NULL)
+      ArgusLog (LOG_ERR, "ArgusAddSketch: ArgusCalloc error %s", strerror(errno));
+
+   sketch->name   = strdup(name);
+   sketch->type   = type;
+   sketch->sketch = ptr;
+
+   while (*tail != NULL)
+      tail = &(*tail)->nxt;
+   *tail = sketch;
+   set->count++;
+   return (sketch);
+}
+
+/*
+ * Find the named sketch, creating it if it isn't there.  For an HLL,
+ * a is the precision, for a top-k table, a is k and b is the precision
+ * of its entries' HLLs.
+ */
+
+void *
+ArgusGetSketch (struct ArgusSketchSetStruct *set, char *name, int type, int a, int b)
+{
+   struct ArgusSketchStruct *sketch;
+   void *ptr = NULL;
+
+   if ((sketch = ArgusFindSketch (set, name)) != NULL)
+      return ((sketch->type == type) ? sketch->sketch : NULL);
+
+   switch (type) {
+      case ARGUS_SKETCH_HLL:  ptr = ArgusNewHLL (a); break;
+      case ARGUS_SKETCH_TOPK: ptr = ArgusNewTopK (a, b); break;
+   }
+
+   if (ptr == NULL)
+      ArgusLog (LOG_ERR, "ArgusGetSketch: %s: bad sketch parameters %d %d", name, a, b);
+
+   ArgusAddSketch (set, name, type, ptr);
+   return (ptr);
+}
+
+static int
+ArgusSketchPutInt (FILE *fd, unsigned int value)
+{
+   value = htonl(value);
+   return (fwrite (&value, sizeof(value), 1, fd) == 1) ? 0 : -1;
+}
+
+static int
+ArgusSketchPutLong (FILE *fd, unsigned long long value)
+{
+   if (ArgusSketchPutInt (fd, value >> 32) < 0)
+      return (-1);
+   return (ArgusSketchPutInt (fd, value & 0xFFFFFFFF));
+}
+
+static int
+ArgusSketchGetInt (FILE *fd, unsigned int *value)
+{
+   if (fread (value, sizeof(*value), 1, fd) != 1)
+      return (-1);
+   *value = ntohl(*value);
+   return (0);
+}
+
+static int
+ArgusSketchGetLong (FILE *fd, unsigned long long *value)
+{
+   unsigned int hi, lo;
+
+   if ((ArgusSketchGetInt (fd, &hi) < 0) || (ArgusSketchGetInt (fd, &lo) < 0))
+      return (-1);
+   *value = ((unsigned long long) hi << 32) | lo;
+   return (0);
+}
+
+static int
+ArgusWriteHLL (FILE *fd, struct ArgusHLLStruct *hll)
+{
+   if (ArgusSketchPutInt (fd, hll->p) < 0)
+      return (-1);
+   return (fwrite (hll->reg, 1, hll->m, fd) == hll->m) ? 0 : -1;
+}
+
+static struct ArgusHLLStruct *
+ArgusReadHLL (FILE *fd)
+{
+   struct ArgusHLLStruct *hll;
+   unsigned int p;
+
+   if ((ArgusSketchGetInt (fd, &p) < 0) || ((hll = ArgusNewHLL(p)) == NULL))
+      return (NULL);
+
+   if (fread (hll->reg, 1, hll->m, fd) != hll->m) {
+      ArgusDeleteHLL (hll);
+      return (NULL);
+   }
+   return (hll);
+}
+
+static int
+ArgusWriteTopK (FILE *fd, struct ArgusTopKStruct *topk)
+{
+   int i;
+
+   if ((ArgusSketchPutInt (fd, topk->k) < 0) || (ArgusSketchPutInt (fd, topk->p) < 0) ||
+       (ArgusSketchPutInt (fd, topk->count) < 0) || (ArgusSketchPutLong (fd, topk->total) < 0))
+      return (-1);
+
+   for (i = 0; i < topk->count; i++) {
+      struct ArgusTopKEntryStruct *entry = &topk->entries[i];
+
+      if ((ArgusSketchPutLong (fd, entry->count) < 0) || (ArgusSketchPutLong (fd, entry->error) < 0) ||
+          (ArgusSketchPutInt (fd, entry->flags) < 0) || (ArgusSketchPutInt (fd, entry->len) < 0) ||
+          (fwrite (entry->key, 1, entry->len, fd) != entry->len))
+         return (-1);
+
+      if (topk->p && (fwrite (entry->hll->reg, 1, entry->hll->m, fd) != entry->hll->m))
+         return (-1);
+   }
+   return (0);
+}
+
+static struct ArgusTopKStruct *
+ArgusReadTopK (FILE *fd)
+{
+   struct ArgusTopKStruct *topk = NULL;
+   unsigned int k, p, count, i;
+   unsigned long long total;
+
+   if ((ArgusSketchGetInt (fd, &k) < 0) || (ArgusSketchGetInt (fd, &p) < 0) ||
+       (ArgusSketchGetInt (fd, &count) < 0) || (ArgusSketchGetLong (fd, &total) < 0))
+      return (NULL);
+
+   if ((count > k) || (p && ((p < ARGUS_HLL_MINP) || (p > ARGUS_HLL_MAXP))))
+      return (NULL);
+
+   if ((topk = ArgusNewTopK (k, p)) == NULL)
+      return (NULL);
+
+   for (i = 0; i < count; i++) {
+      struct ArgusTopKEntryStruct *entry = &topk->entries[i];
+      unsigned int flags, len;
+
+      if ((ArgusSketchGetLong (fd, &entry->count) < 0) || (ArgusSketchGetLong (fd, &entry->error) < 0) ||
+          (ArgusSketchGetInt (fd, &flags) < 0) || (ArgusSketchGetInt (fd, &len) < 0) ||
+          (len > ARGUS_SKETCH_KEYLEN) || (fread (entry->key, 1, len, fd) != len))
+         break;
+
+      entry->flags = flags;
+      entry->len   = len;
+      entry->hash  = ArgusSketchHash(entry->key, len);
+
+      if (p) {
+         if ((entry->hll = ArgusNewHLL(p)) == NULL)
+            break;
+         topk->count = i + 1;
+         if (fread (entry->hll->reg, 1, entry->hll->m, fd) != entry->hll->m)
+            break;
+      }
+
+      topk->count = i + 1;
+      entry->heap = i;
+      topk->heap[i] = i;
+      ArgusTopKLink (topk, i);
+   }
+
+   if (i < count) {
+      ArgusDeleteTopK (topk);
+      return (NULL);
+   }
+
+   topk->total = total;
+   for (i = count / 2; i-- > 0; )
+      ArgusTopKSiftDown (topk, i);
+
+   return (topk);
+}
+
+int
+ArgusWriteSketchSet (struct ArgusSketchSetStruct *set, char *filename)
+{
+   char tmpfile[MAXSTRLEN];
+   struct ArgusSketchStruct *sketch;
+   int retn = 0;
+   FILE *fd;
+
+   snprintf (tmpfile, MAXSTRLEN, "%s.tmp", filename);
+
+   if ((fd = fopen (tmpfile, "w")) == NULL) {
+      ArgusLog (LOG_WARNING, "ArgusWriteSketchSet: open %s error %s", tmpfile, strerror(errno));
+      return (-1);
+   }
+
+   if ((fwrite (ARGUS_SKETCH_MAGIC, 1, 8, fd) != 8) || (ArgusSketchPutInt (fd, ARGUS_SKETCH_VERSION) < 0) ||
+       (ArgusSketchPutInt (fd, set->count) < 0))
+      retn = -1;
+
+   for (sketch = set->start; (retn == 0) && (sketch != NULL); sketch = sketch->nxt) {
+      int len = strlen(sketch->name);
+
+      if ((ArgusSketchPutInt (fd, sketch->type) < 0) || (ArgusSketchPutInt (fd, len) < 0) ||
+          (fwrite (sketch->name, 1, len, fd) != len)) {
+         retn = -1;
+         break;
+      }
+
+      switch (sketch->type) {
+         case ARGUS_SKETCH_HLL:  retn = ArgusWriteHLL (fd, sketch->sketch); break;
+         case ARGUS_SKETCH_TOPK: retn = ArgusWriteTopK (fd, sketch->sketch); break;
+      }
+   }
+
+   if ((fclose (fd) != 0) || (retn < 0)) {
+      ArgusLog (LOG_WARNING, "ArgusWriteSketchSet: write %s error %s", tmpfile, strerror(errno));
+      unlink (tmpfile);
+      return (-1);
+   }
+
+   if (rename (tmpfile, filename) < 0) {
+      ArgusLog (LOG_WARNING, "ArgusWriteSketchSet: rename %s error %s", filename, strerror(errno));
+      unlink (tmpfile);
+      return (-1);
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "ArgusWriteSketchSet(%p, %s) wrote %d sketches\n", set, filename, set->count);
+#endif
+   return (set->count);
+}
+
+/*
+ * Merge the sketches in filename into the set.  Sketches that aren't
+ * in the set are added to it.  Returns the number of sketches read, or
+ * -1 if the file isn't a sketch file or a sketch can't be merged.
+ */
+
+int
+ArgusMergeSketchFile (struct ArgusSketchSetStruct *set, char *filename)
+{
+   char magic[8], name[MAXSTRLEN];
+   unsigned int version, count, type, len, i;
+   struct ArgusSketchStruct *sketch;
+   int retn = -1, merged;
+   void *ptr;
+   FILE *fd;
+
+   if ((fd = fopen (filename, "r")) == NULL) {
+      ArgusLog (LOG_WARNING, "ArgusMergeSketchFile: open %s error %s", filename, strerror(errno));
+      return (retn);
+   }
+
+   if ((fread (magic, 1, 8, fd) != 8) || bcmp (magic, ARGUS_SKETCH_MAGIC, 8) ||
+       (ArgusSketchGetInt (fd, &version) < 0) || (version != ARGUS_SKETCH_VERSION) ||
+       (ArgusSketchGetInt (fd, &count) < 0)) {
+      ArgusLog (LOG_WARNING, "ArgusMergeSketchFile: %s is not a sketch file", filename);
+      fclose (fd);
+      return (retn);
+   }
+
+   for (i = 0; i < count; i++) {
+      if ((ArgusSketchGetInt (fd, &type) < 0) || (ArgusSketchGetInt (fd, &len) < 0) ||
+          (len >= MAXSTRLEN) || (fread (name, 1, len, fd) != len))
+         break;
+      name[len] = '\0';
+
+      ptr = NULL;
+      switch (type) {
+         case ARGUS_SKETCH_HLL:  ptr = ArgusReadHLL (fd); break;
+         case ARGUS_SKETCH_TOPK: ptr = ArgusReadTopK (fd); break;
+      }
+      if (ptr == NULL)
+         break;
+
+      if ((sketch = ArgusFindSketch (set, name)) == NULL) {
+         ArgusAddSketch (set, name, type, ptr);
+         continue;
+      }
+
+      merged = -1;
+      switch (type) {
+         case ARGUS_SKETCH_HLL:
+            if (sketch->type == type)
+               merged = ArgusMergeHLL (sketch->sketch, ptr);
+            ArgusDeleteHLL (ptr);
+            break;
+         case ARGUS_SKETCH_TOPK:
+            if (sketch->type == type)
+               merged = ArgusMergeTopK (sketch->sketch, ptr);
+            ArgusDeleteTopK (ptr);
+            break;
+      }
+      if (merged < 0)
+         break;
+   }
+
+   if (i < count)
+      ArgusLog (LOG_WARNING, "ArgusMergeSketchFile: %s: sketch %d is damaged, or doesn't match", filename, i);
+   else
+      retn = count;
+
+   fclose (fd);
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "ArgusMergeSketchFile(%p, %s) returning %d\n", set, filename, retn);
+#endif
+   return (retn);
+}
@@ -1742,6 +1742,9 @@ ArgusParseArgs(struct ArgusParserStruct *parser, int argc, char **argv)
             if (!(strncmp(parser->ArgusProgramName, "rampcd", 6))) {
                parser->ArgusPortNum = atoi (optarg);
             } else 
+            if (!(strncmp(parser->ArgusProgramName, "raload", 6))) {
+               parser->ArgusPortNum = atoi (optarg);
+            } else 
             if (!(strncmp(parser->ArgusProgramName, "rabins", 6))) {
                while (parser->RaSortOptionIndex > 0) {
                   free(parser->RaSortOptionStrings[parser->RaSortOptionIndex - 1]);
@@ -3645,6 +3648,158 @@ time that needs to lapse */
 
 char ArgusHandleRecordBuffer[ARGUS_MAXRECORDSIZE];
 
+/*
+ * Pre-filter stages for ArgusHandleRecord().  Flow records are tested
+ * against partial decodes, from a copy of the record, before the full
+ * ArgusGenerateRecordStruct() runs.
+ *
+ * The header stage decodes only the time and transport DSRs, and the
+ * metric and icmp DSRs that time canonicalization uses.  It rejects
+ * records outside the -t time range, and, when the filter only tests
+ * the record header and transport DSR, (record type, srcid, ...), the
+ * records that the filter rejects.  Its pass rate is sampled too, and
+ * it is turned off for a while when it isn't rejecting much, as with a
+ * wide -t range, since the records it passes are decoded again.
+ *
+ * When the filter only reads a few DSRs, the lazy stage decodes those,
+ * plus the DSRs that ArgusGenerateRecordStruct() post-processing and
+ * ArgusProcessDirection() need, and drops the records the filter
+ * rejects.  When most records pass, that is a loss, so the pass rate is
+ * sampled and the lazy stage is turned off for a while when it is high.
+ *
+ * Records that get through are decoded in full, from the original
+ * buffer, and go through the normal path.  The reject counts of each
+ * stage are kept in the parser.
+ */
+
+#define ARGUS_HDR_STAGE_DSRS	((0x01 << ARGUS_TRANSPORT_INDEX) | (0x01 << ARGUS_TIME_INDEX) | \
+				 (0x01 << ARGUS_METRIC_INDEX)    | (0x01 << ARGUS_ICMP_INDEX))
+
+#define ARGUS_LAZY_BASE_DSRS	((0x01 << ARGUS_FLOW_INDEX)    | (0x01 << ARGUS_TIME_INDEX)    | \
+				 (0x01 << ARGUS_METRIC_INDEX)  | (0x01 << ARGUS_NETWORK_INDEX) | \
+				 (0x01 << ARGUS_ICMP_INDEX)    | (0x01 << ARGUS_MAC_INDEX)     | \
+				 (0x01 << ARGUS_TRANSPORT_INDEX) | (0x01 << ARGUS_IPATTR_INDEX) | \
+				 (0x01 << ARGUS_LOCAL_INDEX))
+
+#define ARGUS_LAZY_SAMPLE	4096
+#define ARGUS_LAZY_BACKOFF	65536
+
+struct ArgusLazyFilterStruct {
+   struct nff_insn *insns;
+   unsigned int dsrs;
+   int hdronly, tested, passed, skip;
+   int hdrtested, hdrpassed, hdrskip;
+};
+
+static struct ArgusLazyFilterStruct ArgusLazyFilter = { NULL, ARGUS_FILTER_ALL_DSRS, 0, 0, 0, 0, 0, 0, 0 };
+static char ArgusLazyRecordBuffer[ARGUS_MAXRECORDSIZE];
+
+static int
+ArgusPreFilterReject (struct ArgusParserStruct *parser, struct ArgusInput *input, struct ArgusRecord *ptr, int len, struct nff_program *filter)
+{
+   struct ArgusLazyFilterStruct *lazy = &ArgusLazyFilter;
+   struct ArgusRecordStruct *argus;
+   int timechecked = 0, retn = 0;
+
+   switch (ptr->hdr.type & 0xF0) {
+      case ARGUS_NETFLOW:
+      case ARGUS_AFLOW:
+      case ARGUS_FAR:
+         break;
+      default:
+         return (0);
+   }
+
+   if ((parser->exceptfile != NULL) || (len > sizeof(ArgusLazyRecordBuffer)))
+      return (0);
+
+   if (lazy->insns != filter->bf_insns) {
+      lazy->insns   = filter->bf_insns;
+      lazy->dsrs    = ArgusFilterDSRs(filter);
+      lazy->hdronly = !(lazy->dsrs & ~(ARGUS_FILTER_HDR | (0x01 << ARGUS_TRANSPORT_INDEX)));
+      lazy->tested  = lazy->passed = lazy->skip = 0;
+      lazy->hdrtested = lazy->hdrpassed = lazy->hdrskip = 0;
+      if (lazy->dsrs != ARGUS_FILTER_ALL_DSRS)
+         lazy->dsrs |= ARGUS_LAZY_BASE_DSRS;
+   }
+
+/*
+ * decode from a copy, ArgusGenerateRecordStruct() can adjust the
+ * record it is given, and the full decode needs the original.
+ */
+
+   if (parser->tflag || (lazy->hdronly && (filter->bf_insns != NULL))) {
+      if (lazy->hdrskip > 0) {
+         lazy->hdrskip--;
+         if (lazy->hdronly && (filter->bf_insns != NULL))
+            return (0);
+
+      } else {
+         bcopy ((char *)ptr, ArgusLazyRecordBuffer, len);
+
+         if ((argus = ArgusGenerateRecordStructDSRs (parser, input, (struct ArgusRecord *) ArgusLazyRecordBuffer, ARGUS_HDR_STAGE_DSRS)) == NULL)
+            return (0);
+
+         timechecked++;
+         if (ArgusCheckTime (parser, argus, ArgusTimeRangeStrategy) == 0) {
+            parser->ArgusTimeRejects++;
+            retn = 1;
+         } else
+         if (lazy->hdronly && (filter->bf_insns != NULL)) {
+            if (ArgusFilterRecord (filter->bf_insns, argus) == 0) {
+               parser->ArgusHeaderRejects++;
+               retn = 1;
+            }
+         }
+
+         lazy->hdrtested++;
+         if (retn == 0)
+            lazy->hdrpassed++;
+
+         if (lazy->hdrtested >= ARGUS_LAZY_SAMPLE) {
+            if (lazy->hdrpassed > (lazy->hdrtested / 2))
+               lazy->hdrskip = ARGUS_LAZY_BACKOFF;
+            lazy->hdrtested = lazy->hdrpassed = 0;
+         }
+
+         if (retn || (lazy->hdronly && (filter->bf_insns != NULL)))
+            return (retn);
+      }
+   }
+
+   if ((filter->bf_insns == NULL) || (lazy->dsrs == ARGUS_FILTER_ALL_DSRS))
+      return (0);
+
+   if (lazy->skip > 0) {
+      lazy->skip--;
+      return (0);
+   }
+
+   bcopy ((char *)ptr, ArgusLazyRecordBuffer, len);
+
+   if ((argus = ArgusGenerateRecordStructDSRs (parser, input, (struct ArgusRecord *) ArgusLazyRecordBuffer, lazy->dsrs)) != NULL) {
+      if (!timechecked)
+         ArgusCheckTime (parser, argus, ArgusTimeRangeStrategy);
+      ArgusProcessDirection(parser, argus);
+      if (ArgusFilterRecord (filter->bf_insns, argus) == 0) {
+         parser->ArgusLazyRejects++;
+         retn = 1;
+      }
+   }
+
+   lazy->tested++;
+   if (retn == 0)
+      lazy->passed++;
+
+   if (lazy->tested >= ARGUS_LAZY_SAMPLE) {
+      if (lazy->passed > (lazy->tested / 2))
+         lazy->skip = ARGUS_LAZY_BACKOFF;
+      lazy->tested = lazy->passed = 0;
+   }
+
+   return (retn);
+}
+
 int
 ArgusHandleRecord (struct ArgusParserStruct *parser, struct ArgusInput *input, struct ArgusRecord *ptr, unsigned long length, struct nff_program *filter)
 {
@@ -3687,6 +3842,9 @@ ArgusHandleRecord (struct ArgusParserStruct *parser, struct ArgusInput *input, s
          if (parser->sNflag && (parser->sNflag >= parser->ArgusTotalRecords))
             return (ptr->hdr.len * 4);
 
+         if (ArgusPreFilterReject (parser, input, ptr, len, filter))
+            retn = 0;
+         else
          if ((argus = ArgusGenerateRecordStruct (parser, input, (struct ArgusRecord *) ptr)) != NULL) {
             if ((retn = ArgusCheckTime (parser, argus, ArgusTimeRangeStrategy)) != 0) {
                ArgusProcessDirection(parser, argus);
@@ -3700,7 +3858,7 @@ ArgusHandleRecord (struct ArgusParserStruct *parser, struct ArgusInput *input, s
                   if (parser->ArgusMatchLabel) {
                      struct ArgusLabelStruct *label;
                      if (((label = (void *)argus->dsrs[ARGUS_LABEL_INDEX]) != NULL)) {
-                        if (regexec(&parser->lpreg, label->l_un.label, 0, NULL, 0))
+                        if (!ArgusGrepLabel(parser->ArgusLabelMatcher, &parser->lpreg, label->l_un.label))
                            return (argus->hdr.len * 4);
                      } else
                         return (argus->hdr.len * 4);
@@ -3808,6 +3966,7 @@ ArgusHandleRecord (struct ArgusParserStruct *parser, struct ArgusInput *input, s
                         RaScheduleRecord (parser, argus);
 
                } else {
+                  parser->ArgusFilterRejects++;
                   if (parser->exceptfile) {
                      struct ArgusWfileStruct *wfile = NULL, *start = NULL;
 
@@ -3848,7 +4007,8 @@ ArgusHandleRecord (struct ArgusParserStruct *parser, struct ArgusInput *input, s
                      }
                   }
                }
-            }
+            } else
+               parser->ArgusTimeRejects++;
 
          } else
             retn = -1;
@@ -3862,7 +4022,7 @@ ArgusHandleRecord (struct ArgusParserStruct *parser, struct ArgusInput *input, s
             retn = -1;
 
          if (retn >= 0)
-            retn = argus->hdr.len * 4;
+            retn = ((argus != NULL) ? argus->hdr.len : ptr->hdr.len) * 4;
       }
       if (ArgusCheckTimeout(parser, input)) {
           ArgusClientTimeout();
@@ -3898,7 +4058,7 @@ ArgusHandleRecordStruct (struct ArgusParserStruct *parser, struct ArgusInput *in
          if (parser->ArgusMatchLabel) {
             struct ArgusLabelStruct *label;
             if (((label = (void *)argus->dsrs[ARGUS_LABEL_INDEX]) != NULL)) {
-               if (regexec(&parser->lpreg, label->l_un.label, 0, NULL, 0))
+               if (!ArgusGrepLabel(parser->ArgusLabelMatcher, &parser->lpreg, label->l_un.label))
                   return (argus->hdr.len * 4);
             } else
                return (argus->hdr.len * 4);
@@ -30997,6 +31157,7 @@ ArgusReadConnection (struct ArgusParserStruct *parser, struct ArgusInput *input,
                      if (((ptr[0] == 0x1F) && ((ptr[1] == 0x8B) || (ptr[1] == 0x9D))) ||
                          ((ptr[0] == 0xFD) &&  (ptr[1] == 0x37) && (ptr[2] == 0x7A) && (ptr[3] == 0x58) &&  (ptr[4] == 0x5A) && (ptr[5] == 0x00)) || 
                          ((ptr[0] == 0xFD) && ((ptr[1] == 0x37) || (ptr[2] == 0x7A))) ||
+                         ((ptr[0] == 0x28) && (ptr[1] == 0xB5) && (ptr[2] == 0x2F) && (ptr[3] == 0xFD)) ||
                          ((ptr[0] == 'B') && (ptr[1] == 'Z') && (ptr[2] == 'h'))) {
                         char cmd[256];
                         bzero(cmd, 256);
@@ -31010,6 +31171,9 @@ ArgusReadConnection (struct ArgusParserStruct *parser, struct ArgusInput *input,
                         if (ptr[1] == 0x8B)
                            strncpy(cmd, "gzip -dc \"", 12);
                         else
+                        if (ptr[0] == 0x28)
+                           strncpy(cmd, "zstd -dc \"", 12);
+                        else
                         if ((ptr[0] == 0xFD) && (ptr[1] == 0x37) && (ptr[2] == 0x7A) && (ptr[3] == 0x58) &&  (ptr[4] == 0x5A) && (ptr[5] == 0x00))
                            strncpy(cmd, "xzcat \"", 8);
                         else
@@ -32000,6 +32164,9 @@ ArgusCloseInput(struct ArgusParserStruct *parser, struct ArgusInput *input)
    if (parser->Sflag)
       ArgusWriteConnection (parser, input, (u_char *)"DONE: ", strlen("DONE: "));
 
+   if (input->ArgusDgramBatch != NULL)
+      ArgusDeleteDatagramBatch (input);
+
    if (input->fd > 0) {
       if (close (input->fd))
          ArgusLog (LOG_ERR, "ArgusCloseInput: close error %s", strerror(errno));
@@ -33909,6 +34076,9 @@ ArgusProcessLabelOptions(struct ArgusParserStruct *parser, char *label)
             ArgusFree(errbuf);
          }
       }
+
+      if ((parser->ArgusLabelMatcher = ArgusNewGrepMatcher(parser->iflag)) != NULL)
+         ArgusGrepMatcherAdd(parser->ArgusLabelMatcher, label);
    }
 }
 
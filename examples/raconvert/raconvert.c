@@ -297,7 +297,7 @@ main (int argc, char **argv) {
       struct ArgusFileInput *file;
 
       while (ArgusParser->ArgusPassNum) {
-         if ((input = ArgusMalloc(sizeof(*input))) == NULL)
+         if ((input = ArgusCalloc(1, sizeof(*input))) == NULL)
             ArgusLog(LOG_ERR, "unable to allocate input structure\n");
 
          file = ArgusParser->ArgusInputFileList;
@@ -526,7 +526,6 @@ RaConvertParseTitleString (char *str)
 
 
 int RaConvertParseRecordString (struct ArgusParserStruct *, char *, int);
-int RaConvertJsonValue (struct ArgusParserStruct *, ArgusJsonValue *);
 
 unsigned int ArgusRecordSequence = 1;
 int ArgusParseDirStatus = 0;
@@ -534,277 +533,348 @@ int ArgusConvertParseState = 0;
 extern int ArgusThisProto;
 
 
-#define ARGUS_PARSING_KEY	0
-#define ARGUS_PARSING_VALUE	1
+/*
+ * JSON records are read with ArgusJsonScan(), which hands each member's
+ * key and value text straight to RaConvertJsonItem() without building a
+ * value tree.  Keys are looked up in a hash of the RaParseAlgorithmTable
+ * field names, built on first use, and the value is copied into a reused
+ * buffer for the field's parser.
+ */
 
-int ArgusProcessJsonItem(struct ArgusParserStruct *, char *, ArgusJsonValue *);
+#define RACONVERT_JSON_HASHSIZE		512
 
-int
-ArgusProcessJsonItem(struct ArgusParserStruct *parser, char *key, ArgusJsonValue *item) 
+struct RaConvertJsonKeyStruct {
+   struct RaConvertJsonKeyStruct *nxt;
+   struct ArgusParseFieldStruct *field;
+   int len;
+};
+
+static struct RaConvertJsonKeyStruct *RaConvertJsonKeys[RACONVERT_JSON_HASHSIZE];
+static char *RaConvertJsonBuffer = NULL;
+
+static unsigned int
+RaConvertJsonHash (const char *key, int len)
+{
+   unsigned int hash = 5381;
+
+   while (len-- > 0)
+      hash = (hash * 33) ^ (unsigned char) *key++;
+   return (hash % RACONVERT_JSON_HASHSIZE);
+}
+
+static void
+RaConvertJsonInit (void)
 {
-   char valbuf[32], *val = valbuf;
-   char *value = NULL, *buf = NULL;
-   int retn = 1, i;
+   int i;
+
+   if ((RaConvertJsonBuffer = (char *)ArgusCalloc(1, ARGUSMAXSTR)) == NULL)
+      ArgusLog (LOG_ERR, "RaConvertJsonInit: ArgusCalloc error %s", strerror(errno));
+
+   for (i = 0; i < MAX_PRINT_ALG_TYPES; i++) {
+      struct ArgusParseFieldStruct *field = &RaParseAlgorithmTable[i];
+      struct RaConvertJsonKeyStruct *key, **kptr;
+
+      if ((field->field == NULL) || (field->parse == NULL))
+         continue;
+
+      if ((key = (struct RaConvertJsonKeyStruct *) ArgusCalloc(1, sizeof(*key))) == NULL)
+         ArgusLog (LOG_ERR, "RaConvertJsonInit: ArgusCalloc error %s", strerror(errno));
+
+      key->field = field;
+      key->len = strlen(field->field);
+
+      kptr = &RaConvertJsonKeys[RaConvertJsonHash(field->field, key->len)];
+      while (*kptr != NULL)
+         kptr = &(*kptr)->nxt;
+      *kptr = key;
+   }
+}
+
+static struct ArgusParseFieldStruct *
+RaConvertJsonField (const char *key, int len)
+{
+   struct RaConvertJsonKeyStruct *kptr = RaConvertJsonKeys[RaConvertJsonHash(key, len)];
+
+   while (kptr != NULL) {
+      if ((kptr->len == len) && !(strncmp(kptr->field->field, key, len)))
+         return (kptr->field);
+      kptr = kptr->nxt;
+   }
+   return (NULL);
+}
+
+static int
+RaConvertJsonItem (void *arg, const char *key, int klen, int type, const char *val, int vlen)
+{
+   struct ArgusParserStruct *parser = (struct ArgusParserStruct *) arg;
+   struct ArgusParseFieldStruct *field;
+   char *buf = RaConvertJsonBuffer;
+   int slen = 0;
+
+   if ((field = RaConvertJsonField(key, klen)) == NULL)
+      return (0);
+
+   switch (type) {
+      case ARGUS_JSON_NULL:
+      case ARGUS_JSON_OBJECT:
+         return (0);
 
-   switch (item->type) {
       case ARGUS_JSON_BOOL:
-         sprintf(val, "%c", (item->value.boolean) ? 'T': 'F');
+         val = (*val == 't') ? "T" : "F";
+         vlen = 1;
          break;
-      case ARGUS_JSON_INTEGER: {
-         sprintf(val, "%d", (int) item->value.number);
-         break;
-      }
-      case ARGUS_JSON_DOUBLE: {
-         sprintf(val, "%f", item->value.number);
-         break;
-      }
-      case ARGUS_JSON_STRING: {
-         val = item->value.string;
-         break;
-      }
-      case ARGUS_JSON_ARRAY: {
-         if ((buf = ArgusCalloc (1, MAXSTRLEN)) != NULL) {
-            val = buf;
-            ArgusJsonPrint(item, val, MAXSTRLEN);
-	    if (strchr(val, ']') == NULL) {
-	       int slen = strlen(val);
-	       while ((val[slen] != ',') && (slen > 0)) slen--;
-	       val[slen] = ']';
-	       val[slen + 1] = '\0';
-	    }
-         }
-         break;
-      }
    }
 
-   for (i = 0; i < MAX_PRINT_ALG_TYPES; i++) {
-      int len = strlen(RaParseAlgorithmTable[i].field);
-      if (!(strncmp(RaParseAlgorithmTable[i].field, key, len))) {
-         if (RaParseAlgorithmTable[i].parse == ArgusParseLabel) {
-            if ((value = ArgusCalloc (1, MAXSTRLEN)) != NULL) {
-               snprintf (value, ARGUSMAXSTR, "%s=%s", key, val);
-               val = value;
-            }
-         }
-         RaParseAlgorithmTable[i].parse(parser, val);
-         if (i == ARGUSPARSEDIR)
-            RaConvertParseDirLabel = 1;
-         if (i == ARGUSPARSESTATE)
-            RaConvertParseStateLabel = 1;
-      } 
-   }
+   if (field->parse == ArgusParseLabel)
+      slen = snprintf (buf, ARGUSMAXSTR, "%.*s=", klen, key);
 
-   if (buf != NULL)
-      ArgusFree (buf);
-   if (value != NULL)
-      ArgusFree(value);
+   if (vlen > (ARGUSMAXSTR - 1 - slen))
+      vlen = ARGUSMAXSTR - 1 - slen;
+   bcopy (val, &buf[slen], vlen);
+   buf[slen + vlen] = '\0';
+
+   field->parse(parser, buf);
+
+   if (field->value == ARGUSPARSEDIR)
+      RaConvertParseDirLabel = 1;
+   if (field->value == ARGUSPARSESTATE)
+      RaConvertParseStateLabel = 1;
 
 #ifdef ARGUSDEBUG
-   ArgusDebug (1, "ArgusProcessJsonItem(%p, '%s', '%s') returning %d", parser, key, val, retn);
+   ArgusDebug (9, "RaConvertJsonItem(%p, '%.*s', '%s') done", parser, klen, key, buf);
 #endif
-   return retn;
+   return (1);
 }
 
-int
-RaConvertJsonValue (struct ArgusParserStruct *parser, ArgusJsonValue *parent) {
-   int retn = 1, i;
-
-   if (parent->type == ARGUS_JSON_OBJECT) {
-      vector *vec = (vector *) &parent->value.array;
-      ArgusJsonValue *item = (ArgusJsonValue *)vec->data;
-      int state = ARGUS_PARSING_KEY;
-      char *key = NULL;
-
-      for (i = 0; i < vec->size; i++) {
-         switch (item->type) {
-            case ARGUS_JSON_KEY: {
-               key = item->value.string;
-               state = ARGUS_PARSING_VALUE;
-               break;
-            }
+static int
+RaConvertJsonRecord (struct ArgusParserStruct *parser, const char *str)
+{
+   int retn;
 
-            case ARGUS_JSON_BOOL:
-            case ARGUS_JSON_INTEGER:
-            case ARGUS_JSON_DOUBLE:
-            case ARGUS_JSON_STRING: {
-               if (state == ARGUS_PARSING_VALUE) {
-                  retn = ArgusProcessJsonItem(parser, key, item);
-                  state = ARGUS_PARSING_KEY;
-	       }
-               break;
-            }
-            case ARGUS_JSON_OBJECT: {
-               break;
-            }
-            case ARGUS_JSON_ARRAY: {
-               if (state == ARGUS_PARSING_VALUE) {
-                  retn = ArgusProcessJsonItem(parser, key, item);
-                  state = ARGUS_PARSING_KEY;
-	       }
-               break;
-            }
-         }
-         item = (ArgusJsonValue *)((char *)item + vec->data_size);
-      }
-   }
+   if (RaConvertJsonBuffer == NULL)
+      RaConvertJsonInit();
+
+   retn = ArgusJsonScan(&str, RaConvertJsonItem, parser);
 
 #ifdef ARGUSDEBUG
-   ArgusDebug (9, "RaConvertJsonValue(%p, %p) returning %d", parser, parent, retn);
+   ArgusDebug (9, "RaConvertJsonRecord(%p) returning %d", parser, retn);
 #endif
-   return retn;
+   return (retn);
 }
 
-int
-RaConvertParseRecordString (struct ArgusParserStruct *parser, char *str, int slen)
+/*
+ * Column values are split in place, finding the delimiters with memchr(),
+ * which libc does with vector compares, and each value is handed to the
+ * parser that RaConvertParseTitleString() mapped to its column.  The value
+ * is copied into a single buffer that is reused for every field, so no
+ * memory is allocated per record.
+ */
+
+static char *RaConvertFieldBuffer = NULL;
+
+static int
+RaConvertSplitFields (char *ptr, char *end, char **argv)
 {
-   struct ArgusRecordStruct *argus = &parser->argus;
-   int retn = 1, numfields = 0, i;
-   char *argv[ARGUS_MAX_PRINT_FIELDS], **ap = argv;
-   char delim[16], *ptr, *tptr, *tok;
+   int delim = RaConvertFieldDelimiter[0], numfields = 0;
+   char *tok;
 
-   if (str != NULL) {
-      if ((ptr = strchr(str, '\n')) != NULL)
-         *ptr = '\0';
+   while (numfields < ARGUS_MAX_PRINT_FIELDS) {
+      if ((delim == '\0') || ((tok = memchr(ptr, delim, end - ptr)) == NULL))
+         tok = end;
+
+      *tok = '\0';
+      argv[numfields++] = (tok > ptr) ? ptr : NULL;
 
-      ptr = str;
-      bzero (argv, sizeof(argv));
-      bzero ((char *)argus, sizeof(*argus));
+      if (tok == end)
+         break;
+      ptr = tok + 1;
+   }
+   return (numfields);
+}
 
-      bzero (delim, sizeof(delim));
+static int RaConvertFinishRecord (struct ArgusParserStruct *);
 
-      bzero ((char *)&parser->argus, sizeof(parser->argus));
-      bzero ((char *)&parser->canon, sizeof(parser->canon));
+static int
+RaConvertParseFields (struct ArgusParserStruct *parser, char **argv, int numfields)
+{
+   int i;
 
-      ArgusThisProto = 0;
+   if (RaConvertFieldBuffer == NULL)
+      if ((RaConvertFieldBuffer = (char *)ArgusCalloc(1, ARGUSMAXSTR)) == NULL)
+         ArgusLog (LOG_ERR, "RaConvertParseFields: ArgusCalloc error %s", strerror(errno));
 
-      while (isspace((int)*ptr)) ptr++;
-      sprintf (delim, "%c", RaConvertFieldDelimiter[0]);
-      tptr = ptr;
+   for (i = 0; i < numfields; i++) {
+      char *value = argv[i];
 
-      if ((ptr[0] == '{') || (ptr[0] == '[')) {
-         ArgusJsonValue l1root, *res1 = NULL;
-         bzero(&l1root, sizeof(l1root));
+      if ((RaParseAlgorithms[i] != NULL) && (value != NULL)) {
+         int len;
 
-         if ((res1 = ArgusJsonParse(ptr, &l1root)) != NULL) {
-            retn = RaConvertJsonValue(parser, res1);
-            numfields = ARGUS_MAX_PRINT_FIELDS;
-         }
+         if ((value[0] == '-') && (value[1] == '\0'))
+            continue;
 
-      }
-      if (numfields == 0) {
-         while ((tok = strchr(tptr, RaConvertFieldDelimiter[0])) != NULL) {
-            *tok++ = '\0';
-            if (strlen(tptr))
-               *ap = tptr;
-            else
-               *ap = NULL;
-      
-            numfields++;
-            if (++ap >= &argv[ARGUS_MAX_PRINT_FIELDS])
+         if ((len = strlen(value)) >= ARGUSMAXSTR)
+            len = ARGUSMAXSTR - 1;
+         bcopy (value, RaConvertFieldBuffer, len);
+         RaConvertFieldBuffer[len] = '\0';
+
+         RaParseAlgorithms[i]->parse(ArgusParser, RaConvertFieldBuffer);
+
+         switch (parser->argus.hdr.type) {
+            case ARGUS_MAR:
+            case ARGUS_EVENT:
+               return(1);
                break;
-            tptr = tok;
-         }
-         if (strlen(tptr)) {
-            *ap = tptr;
-            numfields++;
          }
       }
+   }
 
-      for (i = 0; i < numfields; i++) {
-            if (RaParseAlgorithms[i] != NULL) {
-               if ((argv[i] != NULL) && strlen(argv[i]) && strcmp(argv[i], "-")) {
-                  char *value = NULL;
-                  if ((value = (char *)ArgusCalloc(1, ARGUSMAXSTR)) != NULL) {
-                     if (RaParseAlgorithms[i]->parse == ArgusParseLabel) {
-                        snprintf (value, ARGUSMAXSTR, "%s", argv[i]);
-	             } else {
-                        snprintf(value, ARGUSMAXSTR, "%s", argv[i]);
-	             }
-
-                     RaParseAlgorithms[i]->parse(ArgusParser, value);
-                     ArgusFree(value);
-                     switch (parser->argus.hdr.type) {
-                        case ARGUS_MAR:
-                        case ARGUS_EVENT:
-                           return(retn);
-                           break;
-                     }
+   return (RaConvertFinishRecord(parser));
+}
 
-	          } else
-                     ArgusLog (LOG_ERR, "RaConvertParseRecordString: ArgusCalloc error %s", strerror(errno));
-               }
-            }
-      }
+static int
+RaConvertFinishRecord (struct ArgusParserStruct *parser)
+{
+   struct ArgusRecordStruct *argus = &parser->argus;
+   int retn = 1;
 
-      if (argus->dsrs[ARGUS_TRANSPORT_INDEX] == NULL) {
-            argus->dsrs[ARGUS_TRANSPORT_INDEX] = &parser->canon.trans.hdr;
-            argus->dsrindex |= 0x1 << ARGUS_TRANSPORT_INDEX;
+   if (argus->dsrs[ARGUS_TRANSPORT_INDEX] == NULL) {
+      argus->dsrs[ARGUS_TRANSPORT_INDEX] = &parser->canon.trans.hdr;
+      argus->dsrindex |= 0x1 << ARGUS_TRANSPORT_INDEX;
 
-            bcopy(&parser->trans, &parser->canon.trans, sizeof(parser->trans));
-            parser->canon.trans.seqnum = ArgusRecordSequence++;
-            if (ArgusRecordSequence == 0) ArgusRecordSequence++;
-      }
+      bcopy(&parser->trans, &parser->canon.trans, sizeof(parser->trans));
+      parser->canon.trans.seqnum = ArgusRecordSequence++;
+      if (ArgusRecordSequence == 0) ArgusRecordSequence++;
+   }
 
-      if (RaConvertParseDirLabel) {
-            struct ArgusNetworkStruct *net = (struct ArgusNetworkStruct *) &parser->canon.net;
-            if (net) {
-               switch (net->hdr.subtype) {
-                  case ARGUS_TCP_INIT:
-                  case ARGUS_TCP_STATUS:
-                  case ARGUS_TCP_PERF: {
-                     struct ArgusTCPObject *tcp = (struct ArgusTCPObject *)&net->net_union.tcp;
-                     tcp->status |= ArgusParseDirStatus;
-                  }
-               }
+   if (RaConvertParseDirLabel) {
+      struct ArgusNetworkStruct *net = (struct ArgusNetworkStruct *) &parser->canon.net;
+      if (net) {
+         switch (net->hdr.subtype) {
+            case ARGUS_TCP_INIT:
+            case ARGUS_TCP_STATUS:
+            case ARGUS_TCP_PERF: {
+               struct ArgusTCPObject *tcp = (struct ArgusTCPObject *)&net->net_union.tcp;
+               tcp->status |= ArgusParseDirStatus;
             }
+         }
       }
-      if (RaConvertParseStateLabel) {
-            struct ArgusNetworkStruct *net = (struct ArgusNetworkStruct *) &parser->canon.net;
-            if (net) {
-               switch (net->hdr.subtype) {
-                  case ARGUS_TCP_INIT:
-                  case ARGUS_TCP_STATUS:
-                  case ARGUS_TCP_PERF: {
-                     struct ArgusTCPObject *tcp = (struct ArgusTCPObject *)&net->net_union.tcp;
-                     tcp->status |= ArgusConvertParseState;
-                  }
-               }
+   }
+   if (RaConvertParseStateLabel) {
+      struct ArgusNetworkStruct *net = (struct ArgusNetworkStruct *) &parser->canon.net;
+      if (net) {
+         switch (net->hdr.subtype) {
+            case ARGUS_TCP_INIT:
+            case ARGUS_TCP_STATUS:
+            case ARGUS_TCP_PERF: {
+               struct ArgusTCPObject *tcp = (struct ArgusTCPObject *)&net->net_union.tcp;
+               tcp->status |= ArgusConvertParseState;
             }
+         }
       }
+   }
 
-      if (RaFlagsIndicationStatus[3] != 0) {
-            switch (parser->canon.flow.hdr.argus_dsrvl8.qual & 0x1F) {
-               case ARGUS_TYPE_IPV4: {
-                  switch (parser->canon.flow.ip_flow.ip_p) {
-                     case IPPROTO_TCP: {
-                        struct ArgusNetworkStruct *net;
-                        struct ArgusTCPObject *tcp;
-                        if ((net = (struct ArgusNetworkStruct *)argus->dsrs[ARGUS_NETWORK_INDEX]) == NULL) {
-                           argus->dsrs[ARGUS_NETWORK_INDEX] = &parser->canon.net.hdr;
-                           argus->dsrindex |= 0x1 << ARGUS_NETWORK_INDEX;
-                           net = (struct ArgusNetworkStruct *)argus->dsrs[ARGUS_NETWORK_INDEX];
-                           net->hdr.type    = ARGUS_NETWORK_DSR;
-                           net->hdr.subtype = ARGUS_TCP_INIT;
-                           net->hdr.argus_dsrvl8.len = ((sizeof(*tcp) + 3)/4) + 1;
-                        }
-                        tcp = (struct ArgusTCPObject *)&net->net_union.tcp;
-                        tcp->status |= RaFlagsIndicationStatus[3];
-                     }
+   if (RaFlagsIndicationStatus[3] != 0) {
+      switch (parser->canon.flow.hdr.argus_dsrvl8.qual & 0x1F) {
+         case ARGUS_TYPE_IPV4: {
+            switch (parser->canon.flow.ip_flow.ip_p) {
+               case IPPROTO_TCP: {
+                  struct ArgusNetworkStruct *net;
+                  struct ArgusTCPObject *tcp;
+                  if ((net = (struct ArgusNetworkStruct *)argus->dsrs[ARGUS_NETWORK_INDEX]) == NULL) {
+                     argus->dsrs[ARGUS_NETWORK_INDEX] = &parser->canon.net.hdr;
+                     argus->dsrindex |= 0x1 << ARGUS_NETWORK_INDEX;
+                     net = (struct ArgusNetworkStruct *)argus->dsrs[ARGUS_NETWORK_INDEX];
+                     net->hdr.type    = ARGUS_NETWORK_DSR;
+                     net->hdr.subtype = ARGUS_TCP_INIT;
+                     net->hdr.argus_dsrvl8.len = ((sizeof(*tcp) + 3)/4) + 1;
                   }
-                  break;
+                  tcp = (struct ArgusTCPObject *)&net->net_union.tcp;
+                  tcp->status |= RaFlagsIndicationStatus[3];
                }
             }
+            break;
+         }
       }
+   }
 
-      if (argus->dsrs[ARGUS_METRIC_INDEX] != NULL) {
-         if ((parser->canon.metric.src.pkts == 0) && (parser->canon.metric.dst.pkts == 0))
-            retn = 0;
-      } else
+   if (argus->dsrs[ARGUS_METRIC_INDEX] != NULL) {
+      if ((parser->canon.metric.src.pkts == 0) && (parser->canon.metric.dst.pkts == 0))
          retn = 0;
-
    } else
       retn = 0;
 
+   return (retn);
+}
+
+/*
+ * JSON input has one record per line, either bare, or wrapped as
+ * {"ArgusData":[ ... ]}, with the wrapper on the first record's line
+ * and the closing ]} on the last, as in pythonlib/test/argus.out.json.  Step past the record separator and
+ * any array or wrapper opening, so the line starts at its record.
+ */
+
+static char *
+RaConvertJsonUnwrap (char *ptr)
+{
+   while (isspace((int)*ptr) || (*ptr == ',')) ptr++;
+
+   if (*ptr == '{') {
+      char *key = ptr + 1;
+
+      while (isspace((int)*key)) key++;
+      if (!strncmp(key, "\"ArgusData\"", 11)) {
+         key += 11;
+         while (isspace((int)*key)) key++;
+         if (*key++ == ':') {
+            while (isspace((int)*key)) key++;
+            if (*key == '[')
+               ptr = key;
+         }
+      }
+   }
+
+   if (*ptr == '[') {
+      ptr++;
+      while (isspace((int)*ptr) || (*ptr == ',')) ptr++;
+   }
+   return (ptr);
+}
+
+static void
+RaConvertResetRecord (struct ArgusParserStruct *parser)
+{
+   bzero ((char *)&parser->argus, sizeof(parser->argus));
+   bzero ((char *)&parser->canon, sizeof(parser->canon));
+
+   ArgusThisProto = 0;
+}
+
+int
+RaConvertParseRecordString (struct ArgusParserStruct *parser, char *str, int slen)
+{
+   char *argv[ARGUS_MAX_PRINT_FIELDS];
+   int retn = 0, numfields;
+   char *ptr, *end;
+
+   if (str != NULL) {
+      if ((end = memchr(str, '\n', slen)) == NULL)
+         end = str + strnlen(str, slen);
+      *end = '\0';
+
+      RaConvertResetRecord (parser);
+
+      ptr = RaConvertJsonUnwrap(str);
+
+      if (ptr[0] == '{') {
+         if ((retn = RaConvertJsonRecord(parser, ptr)) != 0)
+            retn = RaConvertFinishRecord(parser);
+      } else
+      if (ptr[0] != '[') {
+         numfields = RaConvertSplitFields(ptr, end, argv);
+         retn = RaConvertParseFields(parser, argv, numfields);
+      }
+   }
+
 #ifdef ARGUSDEBUG
    ArgusDebug (9, "RaConvertParseRecordString('%s') returning %d", str, retn);
 #endif
@@ -816,12 +886,244 @@ RaConvertParseRecordString (struct ArgusParserStruct *parser, char *str, int sle
 int RaPrintCounter = 1;
 char ArgusRecordBuffer[ARGUS_MAXRECORDSIZE];
 
+/*
+ * Input is read in large blocks and split into lines with memchr(),
+ * rather than with a getline() call per record.  Lines are returned in
+ * place, with the newline replaced by a '\0', and a line that runs past
+ * the end of the block is moved to the front before the next read.
+ */
+
+#define RACONVERT_BLOCKSIZE	0x100000
+
+struct RaConvertScanStruct {
+   FILE *fd;
+   char *buf;
+   size_t size, len, pos;
+   int eof;
+};
+
+static struct RaConvertScanStruct *
+RaConvertOpenScanner (FILE *fd)
+{
+   struct RaConvertScanStruct *scan = NULL;
+
+   if ((scan = ArgusCalloc (1, sizeof(*scan))) != NULL) {
+      if ((scan->buf = ArgusMalloc (RACONVERT_BLOCKSIZE + 1)) != NULL) {
+         scan->size = RACONVERT_BLOCKSIZE;
+         scan->fd = fd;
+      } else {
+         ArgusFree (scan);
+         scan = NULL;
+      }
+   }
+   return (scan);
+}
+
+static void
+RaConvertCloseScanner (struct RaConvertScanStruct *scan)
+{
+   if (scan != NULL) {
+      if (scan->buf != NULL)
+         ArgusFree (scan->buf);
+      ArgusFree (scan);
+   }
+}
+
+static void
+RaConvertFillScanner (struct RaConvertScanStruct *scan)
+{
+   size_t cnt;
+
+   if (scan->pos > 0) {
+      scan->len -= scan->pos;
+      memmove (scan->buf, scan->buf + scan->pos, scan->len);
+      scan->pos = 0;
+   }
+
+   if (scan->len == scan->size) {
+      char *buf;
+
+      if ((buf = ArgusMalloc ((scan->size * 2) + 1)) == NULL)
+         ArgusLog (LOG_ERR, "RaConvertFillScanner: ArgusMalloc error %s", strerror(errno));
+
+      bcopy (scan->buf, buf, scan->len);
+      ArgusFree (scan->buf);
+      scan->buf = buf;
+      scan->size *= 2;
+   }
+
+   if ((cnt = fread (scan->buf + scan->len, 1, scan->size - scan->len, scan->fd)) == 0)
+      scan->eof = 1;
+
+   scan->len += cnt;
+}
+
+static char *
+RaConvertNextLine (struct RaConvertScanStruct *scan, size_t *slen)
+{
+   size_t off = 0;
+   char *line, *nl;
+
+   for (;;) {
+      line = scan->buf + scan->pos;
+
+      if ((nl = memchr (line + off, '\n', scan->len - scan->pos - off)) != NULL) {
+         *nl = '\0';
+         *slen = (nl - line) + 1;
+         scan->pos += *slen;
+         return (line);
+      }
+
+      off = scan->len - scan->pos;
+
+      if (scan->eof) {
+         if (off == 0)
+            return (NULL);
+
+         line[off] = '\0';
+         *slen = off;
+         scan->pos = scan->len;
+         return (line);
+      }
+
+      RaConvertFillScanner (scan);
+   }
+}
+
+static void
+RaConvertOutputRecord (struct ArgusParserStruct *parser, struct ArgusInput *input, int sNflag, int eNflag)
+{
+   struct ArgusRecordStruct *argus = &parser->argus;
+
+   if (parser->ArgusWfileList != NULL) {
+      struct ArgusWfileStruct *wfile = NULL;
+      struct ArgusListObjectStruct *lobj = NULL;
+      int i, count = parser->ArgusWfileList->count;
+
+      if ((lobj = parser->ArgusWfileList->start) != NULL) {
+         for (i = 0; i < count; i++) {
+            if ((wfile = (struct ArgusWfileStruct *) lobj) != NULL) {
+               int retn = 1;
+               if (wfile->filterstr) {
+                  struct nff_insn *wfcode = wfile->filter.bf_insns;
+                  retn = ArgusFilterRecord (wfcode, argus);
+               }
+
+               if (retn != 0) {
+                  if ((parser->exceptfile == NULL) || strcmp(wfile->filename, parser->exceptfile)) {
+                     struct ArgusRecord *argusrec = NULL;
+                     int rv;
+
+                     if ((argusrec = ArgusGenerateRecord (argus, 0L, ArgusRecordBuffer, argus_version)) != NULL) {
+#ifdef _LITTLE_ENDIAN
+                        ArgusHtoN(argusrec);
+#endif
+                        rv = ArgusWriteNewLogfile (parser, input, wfile, argusrec);
+                        if (rv < 0)
+                           ArgusLog (LOG_ERR, "%s: unable to open file\n", __func__);
+                     }
+                  }
+               }
+            }
+
+            lobj = lobj->nxt;
+         }
+      }
+   } else {
+      if (!parser->qflag) {
+         char *buf = NULL;
+         int retn = 0;
+
+         if ((buf = ArgusCalloc (1, ARGUSMAXSTR)) != NULL) {
+            argus->rank = RaPrintCounter++;
+
+            if (parser->Lflag && (!(ArgusParser->ArgusPrintJson))) {
+               if (parser->RaLabel == NULL)
+                  parser->RaLabel = ArgusGenerateLabel(parser, argus);
+
+               if (!(parser->RaLabelCounter++ % parser->Lflag))
+                  if ((retn = printf ("%s\n", parser->RaLabel)) < 0)
+                     RaParseComplete (SIGQUIT);
+
+               if (parser->Lflag < 0)
+                  parser->Lflag = 0;
+            }
+
+            if ((eNflag == 0 ) || ((eNflag >= argus->rank) && (sNflag <= argus->rank))) {
+               ArgusPrintRecord(parser, buf, argus, ARGUSMAXSTR);
+   
+               if ((retn = fprintf (stdout, "%s", buf)) < 0)
+                  RaParseComplete (SIGQUIT);
+   
+               if (parser->eflag == ARGUS_HEXDUMP) {
+                  char *sbuf;
+                  int i;
+
+                  if ((sbuf = ArgusCalloc(1, 65536)) == NULL)
+                     ArgusLog (LOG_ERR, "RaProcessThisRecord: ArgusCalloc error");
+
+                  for (i = 0; i < MAX_PRINT_ALG_TYPES; i++) {
+                     if (ArgusParser->RaPrintAlgorithmList[i] != NULL) {
+                        struct ArgusDataStruct *user = NULL;
+                        if (ArgusParser->RaPrintAlgorithmList[i]->print == ArgusPrintSrcUserData) {
+                           int slen = 0, len = ArgusParser->RaPrintAlgorithmList[i]->length;
+                           if (len > 0) {
+                              if ((user = (struct ArgusDataStruct *)argus->dsrs[ARGUS_SRCUSERDATA_INDEX]) != NULL) {
+                                 if (user->hdr.type == ARGUS_DATA_DSR) {
+                                    slen = (user->hdr.argus_dsrvl16.len - 2 ) * 4;
+                                 } else
+                                    slen = (user->hdr.argus_dsrvl8.len - 2 ) * 4;
+
+                                 slen = (user->count < slen) ? user->count : slen;
+                                 slen = (slen > len) ? len : slen;
+                                 ArgusDump ((const u_char *) &user->array, slen, "      ", sbuf);
+                                 printf ("%s\n", sbuf);
+                              }
+                           }
+                        }
+                        if (ArgusParser->RaPrintAlgorithmList[i]->print == ArgusPrintDstUserData) {
+                           int slen = 0, len = ArgusParser->RaPrintAlgorithmList[i]->length;
+                           if (len > 0) {
+                              if ((user = (struct ArgusDataStruct *)argus->dsrs[ARGUS_DSTUSERDATA_INDEX]) != NULL) {
+                                 if (user->hdr.type == ARGUS_DATA_DSR) {
+                                    slen = (user->hdr.argus_dsrvl16.len - 2 ) * 4;
+                                 } else
+                                    slen = (user->hdr.argus_dsrvl8.len - 2 ) * 4;
+
+                                 slen = (user->count < slen) ? user->count : slen;
+                                 slen = (slen > len) ? len : slen;
+                                 ArgusDump ((const u_char *) &user->array, slen, "      ", sbuf);
+                                 printf ("%s\n", sbuf);
+                              }
+                           }
+                        }
+                     } else
+                        break;
+                  }
+                  ArgusFree(sbuf);
+               }
+      
+               fprintf (stdout, "\n");
+               fflush (stdout);
+
+            } else {
+               if ((eNflag != 0 ) && (eNflag < argus->rank))
+                  RaParseComplete (SIGQUIT);
+            }
+            ArgusFree(buf);
+         } else 
+            ArgusLog (LOG_ERR, "RaConvertReadFile: ArgusCalloc: error %s", strerror(errno));
+      }
+   }
+}
+
+
 void
 RaConvertReadFile (struct ArgusParserStruct *parser, struct ArgusInput *input)
 {
    FILE *fd = NULL;
    char *file = input->filename;
-   int retn = 0, sNflag = 0, eNflag = 0;
+   int sNflag = 0, eNflag = 0;
 
    if ((ArgusParser->sNoflag > 0) || (ArgusParser->eNoflag > 0)) {
       sNflag = ArgusParser->sNoflag;
@@ -888,16 +1190,16 @@ RaConvertReadFile (struct ArgusParserStruct *parser, struct ArgusInput *input)
       fd = stdin;
 
    if (fd != NULL) {
-      char *strbuf = NULL, *str;
-      size_t len = ARGUSMAXSTR, slen;
+      struct RaConvertScanStruct *scan = NULL;
+      size_t slen;
+      char *str;
       int line = 0, done = 0;
 
-      if ((strbuf = ArgusCalloc (1, ARGUSMAXSTR)) == NULL)
-         ArgusLog (LOG_ERR, "%s: ArgusCalloc error\n", __func__, strerror(errno));
+      if ((scan = RaConvertOpenScanner (fd)) == NULL)
+         ArgusLog (LOG_ERR, "%s: ArgusCalloc error %s\n", __func__, strerror(errno));
 
-      while (!done && ((slen = getline(&strbuf, &len, fd)) != -1)) {
+      while (!done && ((str = RaConvertNextLine(scan, &slen)) != NULL)) {
          int i;
-         str = strbuf;
          line++;
 
          if (line == 1) {
@@ -915,131 +1217,8 @@ RaConvertReadFile (struct ArgusParserStruct *parser, struct ArgusInput *input)
 
          if ((*str != '#') && (slen > 1)) {
             if (ArgusProcessTitleString) {
-               struct ArgusRecordStruct *argus = &parser->argus;
-
-               if (RaConvertParseRecordString(parser, str, slen)) {
-                  if (parser->ArgusWfileList != NULL) {
-                     struct ArgusWfileStruct *wfile = NULL;
-                     struct ArgusListObjectStruct *lobj = NULL;
-                     int i, count = parser->ArgusWfileList->count;
- 
-                     if ((lobj = parser->ArgusWfileList->start) != NULL) {
-                        for (i = 0; i < count; i++) {
-                           if ((wfile = (struct ArgusWfileStruct *) lobj) != NULL) {
-                              retn = 1;
-                              if (wfile->filterstr) {
-                                 struct nff_insn *wfcode = wfile->filter.bf_insns;
-                                 retn = ArgusFilterRecord (wfcode, argus);
-                              }
- 
-                              if (retn != 0) {
-                                 if ((parser->exceptfile == NULL) || strcmp(wfile->filename, parser->exceptfile)) {
-                                    struct ArgusRecord *argusrec = NULL;
-                                    int rv;
-
-                                       if ((argusrec = ArgusGenerateRecord (argus, 0L, ArgusRecordBuffer, argus_version)) != NULL) {
-#ifdef _LITTLE_ENDIAN
-                                          ArgusHtoN(argusrec);
-#endif
-                                          rv = ArgusWriteNewLogfile (parser, input, wfile, argusrec);
-                                          if (rv < 0)
-                                             ArgusLog (LOG_ERR, "%s: unable to open file\n", __func__);
-                                       }
-                                    }
-                                 }
-                              }
-                           }
- 
-                           lobj = lobj->nxt;
-                        }
-                     } else {
-
-                     if (!parser->qflag) {
-                        char *buf = NULL;
-                        int retn = 0;
-
-                        if ((buf = ArgusCalloc (1, ARGUSMAXSTR)) != NULL) {
-                           argus->rank = RaPrintCounter++;
-
-			      if (parser->Lflag && (!(ArgusParser->ArgusPrintJson))) {
-                              if (parser->RaLabel == NULL)
-                                 parser->RaLabel = ArgusGenerateLabel(parser, argus);
-
-                              if (!(parser->RaLabelCounter++ % parser->Lflag))
-                                 if ((retn = printf ("%s\n", parser->RaLabel)) < 0)
-                                    RaParseComplete (SIGQUIT);
-
-                              if (parser->Lflag < 0)
-                                 parser->Lflag = 0;
-                           }
-
-                           if ((eNflag == 0 ) || ((eNflag >= argus->rank) && (sNflag <= argus->rank))) {
-                              ArgusPrintRecord(parser, buf, argus, ARGUSMAXSTR);
-                  
-                              if ((retn = fprintf (stdout, "%s", buf)) < 0)
-                                 RaParseComplete (SIGQUIT);
-                  
-                              if (parser->eflag == ARGUS_HEXDUMP) {
-                                 char *sbuf;
-                                 int i;
-
-                                 if ((sbuf = ArgusCalloc(1, 65536)) == NULL)
-                                    ArgusLog (LOG_ERR, "RaProcessThisRecord: ArgusCalloc error");
-
-                                 for (i = 0; i < MAX_PRINT_ALG_TYPES; i++) {
-                                    if (ArgusParser->RaPrintAlgorithmList[i] != NULL) {
-                                       struct ArgusDataStruct *user = NULL;
-                                       if (ArgusParser->RaPrintAlgorithmList[i]->print == ArgusPrintSrcUserData) {
-                                          int slen = 0, len = ArgusParser->RaPrintAlgorithmList[i]->length;
-                                          if (len > 0) {
-                                             if ((user = (struct ArgusDataStruct *)argus->dsrs[ARGUS_SRCUSERDATA_INDEX]) != NULL) {
-                                                if (user->hdr.type == ARGUS_DATA_DSR) {
-                                                   slen = (user->hdr.argus_dsrvl16.len - 2 ) * 4;
-                                                } else
-                                                   slen = (user->hdr.argus_dsrvl8.len - 2 ) * 4;
-
-                                                slen = (user->count < slen) ? user->count : slen;
-                                                slen = (slen > len) ? len : slen;
-                                                ArgusDump ((const u_char *) &user->array, slen, "      ", sbuf);
-                                                printf ("%s\n", sbuf);
-                                             }
-                                          }
-                                       }
-                                       if (ArgusParser->RaPrintAlgorithmList[i]->print == ArgusPrintDstUserData) {
-                                          int slen = 0, len = ArgusParser->RaPrintAlgorithmList[i]->length;
-                                          if (len > 0) {
-                                             if ((user = (struct ArgusDataStruct *)argus->dsrs[ARGUS_DSTUSERDATA_INDEX]) != NULL) {
-                                                if (user->hdr.type == ARGUS_DATA_DSR) {
-                                                   slen = (user->hdr.argus_dsrvl16.len - 2 ) * 4;
-                                                } else
-                                                   slen = (user->hdr.argus_dsrvl8.len - 2 ) * 4;
-
-                                                slen = (user->count < slen) ? user->count : slen;
-                                                slen = (slen > len) ? len : slen;
-                                                ArgusDump ((const u_char *) &user->array, slen, "      ", sbuf);
-                                                printf ("%s\n", sbuf);
-                                             }
-                                          }
-                                       }
-                                    } else
-                                       break;
-                                 }
-                                 ArgusFree(sbuf);
-                              }
-                     
-                              fprintf (stdout, "\n");
-                              fflush (stdout);
-
-                           } else {
-                              if ((eNflag != 0 ) && (eNflag < argus->rank))
-                                 RaParseComplete (SIGQUIT);
-                           }
-                           ArgusFree(buf);
-                        } else 
-                           ArgusLog (LOG_ERR, "RaConvertReadFile: ArgusCalloc: error %s", strerror(errno));
-                     }
-                  }
-               }
+               if (RaConvertParseRecordString(parser, str, slen))
+                  RaConvertOutputRecord (parser, input, sNflag, eNflag);
             } else {
                RaConvertParseTitleString(str);
                ArgusProcessTitleString = 1;
@@ -1047,18 +1226,19 @@ RaConvertReadFile (struct ArgusParserStruct *parser, struct ArgusInput *input)
          }
       }
 
-      ArgusFree(strbuf);
+      RaConvertCloseScanner (scan);
 
       if (!(feof(fd)) && ferror(fd))
-         ArgusLog (LOG_ERR, "getline: error %s", strerror(errno));
+         ArgusLog (LOG_ERR, "RaConvertReadFile: fread error %s", strerror(errno));
    }
 
+   if (input->pipe) {
+      pclose(input->pipe);
+      input->pipe = NULL;
+   } else
    if (fd)
       fclose(fd);
 
-   if (input->pipe)
-      pclose(input->pipe);
-
 #ifdef ARGUSDEBUG
    ArgusDebug (9, "RaConvertReadFile('%s') done", file);
 #endif
@@ -1252,7 +1432,9 @@ ArgusParseType (struct ArgusParserStruct *parser, char *buf)
    if (strcmp("man", buf) == 0)  { argus->hdr.type |= ARGUS_MAR; found++; }
    if (strcmp("flow", buf) == 0) { argus->hdr.type |= ARGUS_FAR; found++; }
    if (strcmp("aflow", buf) == 0) { argus->hdr.type |= ARGUS_AFLOW; found++; }
+   if (strcmp("aflo", buf) == 0) { argus->hdr.type |= ARGUS_AFLOW; found++; }
    if (strcmp("nflow", buf) == 0) { argus->hdr.type |= ARGUS_NETFLOW; found++; }
+   if (strcmp("nflo", buf) == 0) { argus->hdr.type |= ARGUS_NETFLOW; found++; }
    if (strcmp("index", buf) == 0) { argus->hdr.type |= ARGUS_INDEX; found++; }
    if (strcmp("supp", buf) == 0) { argus->hdr.type |= ARGUS_DATASUP; found++; }
    if (strcmp("archive", buf) == 0) { argus->hdr.type |= ARGUS_ARCHIVAL; found++; }
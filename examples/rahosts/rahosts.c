@@ -42,6 +42,7 @@
 #include <argus_filter.h>
 
 #include <argus_grep.h>
+#include <argus_sketch.h>
 #include <argus_metric.h>
 #include <rasqlinsert.h>
 
@@ -50,7 +51,11 @@
 #include <time.h>
   
 #include <netdb.h>
+#include <fcntl.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <arpa/inet.h>
 
 #include <rabins.h>
 #include <rasplit.h>
@@ -64,6 +69,71 @@
 
 int RaHostsLabelStartTreeLevel = 0;
 int RaHostsPrintTreeLevel = 1000000;
+
+/*
+ * approx mode keeps, for each probe and region, a Space-Saving table
+ * of the hosts seen in the most flows, each with an HLL of its peers,
+ * in place of the address trees.
+ */
+
+#define RAHOSTS_APPROX_HOSTS		10000
+#define RAHOSTS_PEER_PRECISION		10
+
+int RaHostsApproxMode = 0;
+char *RaHostsSketchFile = NULL;
+struct ArgusSketchSetStruct *RaHostsSketchSet = NULL;
+
+/*
+ * graph mode keeps a persistent host/peer graph, so the peers of a host
+ * over the last weeks can be reported without reading the archive
+ * again.  The file is a header, the host table and its hash index, then
+ * the edge table and its hash index.  Each host has a chain of directed
+ * edges, one for each peer, and hosts and edges each have a bitmap of
+ * the days they were seen, bit 0 being their last day, covering the
+ * last RAHOSTS_GRAPH_DAYS days.
+ */
+
+#define RAHOSTS_GRAPH_MAGIC		0x52484752
+#define RAHOSTS_GRAPH_VERSION		1
+#define RAHOSTS_GRAPH_DAYS		64
+#define RAHOSTS_GRAPH_MINHOSTS		1024
+#define RAHOSTS_GRAPH_MINEDGES		4096
+
+struct RaHostsGraphHdr {
+   unsigned int magic, version;
+   unsigned int hsize, esize;
+   unsigned int hcapacity, hcount;
+   unsigned int ecapacity, ecount;
+   unsigned int lastday, pad;
+};
+
+struct RaHostsGraphHost {
+   unsigned int addr, day;
+   unsigned int head, degree;
+   int locality, pad;
+   unsigned long long days;
+};
+
+struct RaHostsGraphEdge {
+   unsigned int src, dst;
+   unsigned int day, next;
+   unsigned long long days;
+};
+
+struct RaHostsGraphStruct {
+   char *filename;
+   int fd;
+   size_t len;
+   struct RaHostsGraphHdr *hdr;
+   struct RaHostsGraphHost *hosts;
+   unsigned int *hindex;
+   struct RaHostsGraphEdge *edges;
+   unsigned int *eindex;
+};
+
+struct RaHostsGraphStruct *RaHostsGraph = NULL;
+int RaHostsGraphQuery = 0;
+int RaHostsGraphDays = 30;
 int RaHostsPrintTreeDebug = 0;
 
 extern char RaAddrTreeArray[];
@@ -234,6 +304,8 @@ struct ArgusProbeStruct {
    struct ArgusQueueHeader qhdr;
    struct ArgusLabelerStruct *localLabeler;
    struct ArgusLabelerStruct *remoteLabeler;
+   struct ArgusTopKStruct *localHosts;
+   struct ArgusTopKStruct *remoteHosts;
    struct ArgusAggregatorStruct *agg;
    unsigned int status;
    struct ArgusHashTableHdr *htblhdr;
@@ -245,6 +317,13 @@ struct ArgusProbeStruct *ArgusFindProbe (struct ArgusHashTable *, struct ArgusHa
 struct ArgusProbeStruct *ArgusNewProbe (struct ArgusParserStruct *, struct ArgusHashStruct *);
 
 struct RaAddressStruct *RaHostsProcessAddress (struct ArgusParserStruct *, struct ArgusLabelerStruct *, unsigned int *, int, int, int);
+void RaHostsProcessSketch (struct ArgusParserStruct *, struct ArgusProbeStruct *, struct ArgusRecordStruct *, int, int, int);
+void RaHostsPrintSketches (struct ArgusParserStruct *);
+
+struct RaHostsGraphStruct *RaHostsOpenGraph (struct ArgusParserStruct *, char *);
+void RaHostsCloseGraph (struct ArgusParserStruct *, struct RaHostsGraphStruct *);
+void RaHostsGraphRecord (struct ArgusParserStruct *, struct RaHostsGraphStruct *, struct ArgusRecordStruct *, int, int);
+void RaHostsPrintGraph (struct ArgusParserStruct *, struct RaHostsGraphStruct *);
 
 extern int ArgusTotalMarRecords;
 extern int ArgusTotalFarRecords;
@@ -290,6 +369,11 @@ RaParseComplete (int sig)
             ArgusLog(LOG_ERR, "mysql_real_query error %s", mysql_error(RaMySQL));
       }
 
+      if (RaHostsApproxMode) {
+         RaHostsPrintSketches (parser);
+         if (RaHostsSketchFile != NULL)
+            ArgusWriteSketchSet (RaHostsSketchSet, RaHostsSketchFile);
+      } else
       while ((probe = (void *)ArgusPopQueue(ArgusProbeQueue, ARGUS_LOCK)) != NULL) {
          struct ArgusLabelerStruct *labeler = probe->localLabeler;
          int status = ARGUS_MATRIX_LOCAL;
@@ -301,6 +385,13 @@ RaParseComplete (int sig)
          RaHostsPrintTreeContents (labeler, labeler->ArgusAddrTree[AF_INET], status, 0, 0);
       }
 
+      if (RaHostsGraph != NULL) {
+         if (RaHostsGraphQuery)
+            RaHostsPrintGraph (parser, RaHostsGraph);
+         RaHostsCloseGraph (parser, RaHostsGraph);
+         RaHostsGraph = NULL;
+      }
+
       mysql_close(RaMySQL);
    }
 
@@ -452,6 +543,9 @@ RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *ns)
             parser->ArgusTotalBytes += metric->dst.bytes;
          }
 
+         if (RaHostsGraph != NULL)
+            RaHostsGraphRecord (parser, RaHostsGraph, argus, sloc, dloc);
+
          if ((agg->rap = RaFlowModelOverRides(agg, ns)) == NULL)
             agg->rap = agg->drap;
 
@@ -472,6 +566,9 @@ RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *ns)
          if ((probe = ArgusFindProbe(agg->htable, hstruct)) != NULL) {
             struct ArgusLabelerStruct *labeler = NULL;
 
+            if (RaHostsApproxMode)
+               RaHostsProcessSketch (parser, probe, argus, status, sloc, dloc);
+            else
             switch (status) {
                case ARGUS_MATRIX_LOCAL:  labeler = probe->localLabeler; break;
                case ARGUS_MATRIX_REMOTE: labeler = probe->remoteLabeler; break;
@@ -1442,6 +1539,34 @@ ArgusClientInit (struct ArgusParserStruct *parser)
                    (!(strncasecmp (mode->mode, "debug", 5)))) {
                   parser->ArgusLabeler->RaPrintLabelTreeMode = ARGUS_TREE;
                   parser->ArgusLabeler->status |= ARGUS_LABELER_DEBUG;
+               } else
+               if (!(strncasecmp (mode->mode, "approx", 6))) {
+                  RaHostsApproxMode = RAHOSTS_APPROX_HOSTS;
+                  if (mode->mode[6] == '=')
+                     if ((RaHostsApproxMode = atoi(&mode->mode[7])) <= 0)
+                        ArgusLog (LOG_ERR, "ArgusClientInit: approx value %s must be > 0", &mode->mode[7]);
+               } else
+               if (!(strncasecmp (mode->mode, "sketch=", 7))) {
+                  RaHostsSketchFile = &mode->mode[7];
+                  if (RaHostsApproxMode == 0)
+                     RaHostsApproxMode = RAHOSTS_APPROX_HOSTS;
+               } else
+               if (!(strncasecmp (mode->mode, "merge=", 6))) {
+                  if (RaHostsApproxMode == 0)
+                     RaHostsApproxMode = RAHOSTS_APPROX_HOSTS;
+               } else
+               if (!(strncasecmp (mode->mode, "graph=", 6))) {
+                  if (RaHostsGraph != NULL)
+                     ArgusLog (LOG_ERR, "ArgusClientInit: only one graph file is supported");
+                  RaHostsGraph = RaHostsOpenGraph (parser, &mode->mode[6]);
+               } else
+               if (!(strncasecmp (mode->mode, "peers", 5))) {
+                  RaHostsGraphQuery = 1;
+               } else
+               if (!(strncasecmp (mode->mode, "days=", 5))) {
+                  RaHostsGraphDays = atoi(&mode->mode[5]);
+                  if ((RaHostsGraphDays <= 0) || (RaHostsGraphDays > RAHOSTS_GRAPH_DAYS))
+                     ArgusLog (LOG_ERR, "ArgusClientInit: days value %s must be 1-%d", &mode->mode[5], RAHOSTS_GRAPH_DAYS);
                }
             }
 
@@ -1449,6 +1574,19 @@ ArgusClientInit (struct ArgusParserStruct *parser)
          }
       }
 
+      if (RaHostsGraphQuery && (RaHostsGraph == NULL))
+         ArgusLog (LOG_ERR, "ArgusClientInit: peers mode needs a graph=<file>");
+
+      if (RaHostsApproxMode) {
+         if ((RaHostsSketchSet = ArgusNewSketchSet()) == NULL)
+            ArgusLog (LOG_ERR, "ArgusClientInit: ArgusNewSketchSet error %s", strerror(errno));
+
+         for (mode = parser->ArgusModeList; mode != NULL; mode = mode->nxt)
+            if (!(strncasecmp (mode->mode, "merge=", 6)))
+               if (ArgusMergeSketchFile(RaHostsSketchSet, &mode->mode[6]) < 0)
+                  ArgusLog (LOG_ERR, "ArgusClientInit: can't merge %s", &mode->mode[6]);
+      }
+
       RaBinProcess->size = nadp->size;
 
       if (nadp->mode < 0) {
@@ -1641,6 +1779,13 @@ usage ()
    fprintf (stdout, "options: -M sql='where clause'  pass where clause to database engine.\n");
    fprintf (stdout, "         -r <dbUrl>             read argus data from mysql database.\n");
    fprintf (stdout, "             Format:            mysql://[user[:pass]@]host[:port]/db/table\n");
+   fprintf (stdout, "         -M approx[=<n>]        keep only the <n> busiest hosts of each probe,\n");
+   fprintf (stdout, "                                with estimated peer counts (default 10000).\n");
+   fprintf (stdout, "         -M sketch=<file>       write the approx mode sketches to <file>.\n");
+   fprintf (stdout, "         -M merge=<file>        merge the sketches in <file> into this run.\n");
+   fprintf (stdout, "         -M graph=<file>        add the host/peer pairs to the graph in <file>.\n");
+   fprintf (stdout, "         -M peers[=<addr>]      print the peers of <addr>, or of all hosts, from the graph.\n");
+   fprintf (stdout, "         -M days=<n>            report the peers seen in the last <n> days (default 30).\n");
    fflush (stdout);
 
    exit(1);
@@ -2446,6 +2591,613 @@ RaHostsPrintTreeContents (struct ArgusLabelerStruct *labeler, struct RaAddressSt
 }
 
 
+/*
+ * The probe's sketches are named for its sid and inf, so that sketch
+ * files from different runs merge probe by probe.  IPv4 keys are kept
+ * in network byte order.
+ */
+
+void
+RaHostsProcessSketch (struct ArgusParserStruct *parser, struct ArgusProbeStruct *probe, struct ArgusRecordStruct *argus, int status, int sloc, int dloc)
+{
+   struct ArgusFlow *flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX];
+   struct ArgusTopKEntryStruct *entry;
+   struct ArgusTopKStruct *hosts;
+   unsigned int saddr, daddr;
+
+   if (probe->localHosts == NULL) {
+      char field[256], sid[256], name[MAXSTRLEN];
+
+      ArgusPrintSID(parser, field, argus, 256);
+      snprintf (sid, sizeof(sid), "%s", ArgusTrimString(field));
+      ArgusPrintInf(parser, field, argus, 256);
+
+      snprintf (name, MAXSTRLEN, "rahosts/%s/%s/local", sid, ArgusTrimString(field));
+      probe->localHosts = ArgusGetSketch(RaHostsSketchSet, name, ARGUS_SKETCH_TOPK, RaHostsApproxMode, RAHOSTS_PEER_PRECISION);
+      snprintf (name, MAXSTRLEN, "rahosts/%s/%s/remote", sid, ArgusTrimString(field));
+      probe->remoteHosts = ArgusGetSketch(RaHostsSketchSet, name, ARGUS_SKETCH_TOPK, RaHostsApproxMode, RAHOSTS_PEER_PRECISION);
+
+      if ((probe->localHosts == NULL) || (probe->remoteHosts == NULL))
+         ArgusLog (LOG_ERR, "RaHostsProcessSketch: %s is not a top-k sketch", name);
+   }
+
+   if (flow == NULL)
+      return;
+
+   switch (flow->hdr.subtype & 0x3F) {
+      case ARGUS_FLOW_CLASSIC5TUPLE:
+      case ARGUS_FLOW_LAYER_3_MATRIX: {
+         switch (flow->hdr.argus_dsrvl8.qual & 0x1F) {
+            case ARGUS_TYPE_IPV4:
+               hosts = (status == ARGUS_MATRIX_LOCAL) ? probe->localHosts : probe->remoteHosts;
+               saddr = htonl(flow->ip_flow.ip_src);
+               daddr = htonl(flow->ip_flow.ip_dst);
+
+               entry = ArgusTopKUpdate(hosts, &saddr, sizeof(saddr), 1);
+               entry->flags = sloc;
+               ArgusHLLAdd(entry->hll, ArgusSketchHash(&daddr, sizeof(daddr)));
+
+               entry = ArgusTopKUpdate(hosts, &daddr, sizeof(daddr), 1);
+               entry->flags = dloc;
+               ArgusHLLAdd(entry->hll, ArgusSketchHash(&saddr, sizeof(saddr)));
+               break;
+
+            case ARGUS_TYPE_IPV6:
+               break;
+         }
+         break;
+      }
+   }
+}
+
+/*
+ * Report each host in the sketches, busiest first.  The count is the
+ * estimated number of peers, and the peer list is left empty.  When
+ * printing, each table is preceded by its error bound, and each host
+ * reports its flow count and how much of it may be overcounted.
+ */
+
+void
+RaHostsPrintSketches (struct ArgusParserStruct *parser)
+{
+   struct ArgusTopKEntryStruct **list;
+   struct ArgusSketchStruct *sketch;
+   char name[MAXSTRLEN], saddr[32], loc[16], cnt[32], flows[64];
+   char *sid, *inf, *region;
+   int i, count;
+
+   for (sketch = RaHostsSketchSet->start; sketch != NULL; sketch = sketch->nxt) {
+      struct ArgusTopKStruct *hosts = sketch->sketch;
+
+      if ((sketch->type != ARGUS_SKETCH_TOPK) || strncmp (sketch->name, "rahosts/", 8))
+         continue;
+
+      snprintf (name, MAXSTRLEN, "%s", &sketch->name[8]);
+      if ((region = strrchr(name, '/')) == NULL)
+         continue;
+      *region++ = '\0';
+      if ((inf = strrchr(name, '/')) == NULL)
+         continue;
+      *inf++ = '\0';
+      sid = name;
+
+      if ((list = ArgusCalloc (hosts->k, sizeof(*list))) == NULL)
+         ArgusLog (LOG_ERR, "RaHostsPrintSketches: ArgusCalloc error %s", strerror(errno));
+
+      count = ArgusTopKSort(hosts, list);
+
+#ifdef ARGUSDEBUG
+      ArgusDebug (1, "RaHostsPrintSketches: %s %d hosts, counts high by at most %llu\n", sketch->name, count, ArgusTopKError(hosts));
+#endif
+      if (parser->writeDbstr == NULL)
+         printf ("# %s, %s, %s, %d hosts of %llu flows, flow counts high by at most %llu\n",
+                    region, sid, inf, count, hosts->total, ArgusTopKError(hosts));
+
+      for (i = 0; i < count; i++) {
+         unsigned int addr;
+
+         bcopy (list[i]->key, &addr, sizeof(addr));
+         snprintf (saddr, sizeof(saddr), "%s", intoa(ntohl(addr)));
+         snprintf (loc, sizeof(loc), "%d", list[i]->flags);
+         snprintf (cnt, sizeof(cnt), "%.0f", ArgusHLLCount(list[i]->hll));
+
+         if (parser->writeDbstr == NULL)
+            snprintf (flows, sizeof(flows), "flows %llu error %llu", list[i]->count, list[i]->error);
+         else
+            flows[0] = '\0';
+
+         ArgusProcessAddressData(parser, region, sid, inf, saddr, loc, cnt, flows);
+      }
+      ArgusFree (list);
+   }
+}
+
+
+static size_t
+RaHostsGraphLength (unsigned int hcapacity, unsigned int ecapacity)
+{
+   return (sizeof(struct RaHostsGraphHdr) +
+           (hcapacity * (sizeof(struct RaHostsGraphHost) + (2 * sizeof(unsigned int)))) +
+           (ecapacity * (sizeof(struct RaHostsGraphEdge) + (2 * sizeof(unsigned int)))));
+}
+
+static void
+RaHostsMapGraph (struct RaHostsGraphStruct *graph, unsigned int hcapacity, unsigned int ecapacity)
+{
+   void *map;
+
+   graph->len = RaHostsGraphLength(hcapacity, ecapacity);
+
+   if (ftruncate (graph->fd, graph->len) < 0)
+      ArgusLog (LOG_ERR, "RaHostsMapGraph: ftruncate %s error %s", graph->filename, strerror(errno));
+
+   if ((map = mmap (NULL, graph->len, PROT_READ | PROT_WRITE, MAP_SHARED, graph->fd, 0)) == MAP_FAILED)
+      ArgusLog (LOG_ERR, "RaHostsMapGraph: mmap %s error %s", graph->filename, strerror(errno));
+
+   graph->hdr    = (struct RaHostsGraphHdr *) map;
+   graph->hosts  = (struct RaHostsGraphHost *)(graph->hdr + 1);
+   graph->hindex = (unsigned int *)(graph->hosts + hcapacity);
+   graph->edges  = (struct RaHostsGraphEdge *)(graph->hindex + (hcapacity * 2));
+   graph->eindex = (unsigned int *)(graph->edges + ecapacity);
+}
+
+static void
+RaHostsUnmapGraph (struct RaHostsGraphStruct *graph)
+{
+   msync (graph->hdr, graph->len, MS_ASYNC);
+   munmap (graph->hdr, graph->len);
+   graph->hdr = NULL;
+}
+
+static unsigned int
+RaHostsGraphHash (unsigned int a, unsigned int b)
+{
+   unsigned long long h = ((unsigned long long) a << 32) | b;
+
+   h ^= h >> 33;
+   h *= 0xff51afd7ed558ccdULL;
+   h ^= h >> 33;
+   return ((unsigned int) h);
+}
+
+static void
+RaHostsIndexHost (struct RaHostsGraphStruct *graph, unsigned int host)
+{
+   unsigned int mask = (graph->hdr->hcapacity * 2) - 1;
+   unsigned int i = RaHostsGraphHash(graph->hosts[host].addr, 0) & mask;
+
+   while (graph->hindex[i] != 0)
+      i = (i + 1) & mask;
+
+   graph->hindex[i] = host + 1;
+}
+
+static void
+RaHostsIndexEdge (struct RaHostsGraphStruct *graph, unsigned int edge)
+{
+   unsigned int mask = (graph->hdr->ecapacity * 2) - 1;
+   unsigned int i = RaHostsGraphHash(graph->edges[edge].src, graph->edges[edge].dst) & mask;
+
+   while (graph->eindex[i] != 0)
+      i = (i + 1) & mask;
+
+   graph->eindex[i] = edge + 1;
+}
+
+static void
+RaHostsRebuildEdges (struct RaHostsGraphStruct *graph)
+{
+   unsigned int i;
+
+   bzero (graph->eindex, (graph->hdr->ecapacity * 2) * sizeof(unsigned int));
+   for (i = 0; i < graph->hdr->ecount; i++)
+      RaHostsIndexEdge (graph, i);
+}
+
+/*
+ *  Grow the graph by writing it, with the new capacities, to a new
+ *  file that is synced and then renamed over the old one, so a crash
+ *  at any point leaves either the old graph or the new one, never a
+ *  partly moved one.  The new file is locked before it is renamed,
+ *  and the indexes are rebuilt for the new capacities.
+ */
+
+static void
+RaHostsGrowGraph (struct RaHostsGraphStruct *graph, unsigned int hcapacity, unsigned int ecapacity)
+{
+   struct RaHostsGraphStruct ngraph;
+   char tmpname[MAXSTRLEN];
+   struct flock lock;
+   unsigned int i;
+
+   snprintf (tmpname, sizeof(tmpname), "%s.tmp", graph->filename);
+
+   bzero (&ngraph, sizeof(ngraph));
+   ngraph.filename = tmpname;
+
+   if ((ngraph.fd = open (tmpname, O_RDWR | O_CREAT | O_TRUNC, 0644)) < 0)
+      ArgusLog (LOG_ERR, "RaHostsGrowGraph: open %s error %s", tmpname, strerror(errno));
+
+   bzero (&lock, sizeof(lock));
+   lock.l_type = F_WRLCK;
+   lock.l_whence = SEEK_SET;
+
+   if (fcntl (ngraph.fd, F_SETLK, &lock) < 0)
+      ArgusLog (LOG_ERR, "RaHostsGrowGraph: %s is in use %s", tmpname, strerror(errno));
+
+   RaHostsMapGraph (&ngraph, hcapacity, ecapacity);
+
+   *ngraph.hdr = *graph->hdr;
+   ngraph.hdr->hcapacity = hcapacity;
+   ngraph.hdr->ecapacity = ecapacity;
+
+   bcopy (graph->hosts, ngraph.hosts, graph->hdr->hcount * sizeof(struct RaHostsGraphHost));
+   bcopy (graph->edges, ngraph.edges, graph->hdr->ecount * sizeof(struct RaHostsGraphEdge));
+
+   for (i = 0; i < ngraph.hdr->hcount; i++)
+      RaHostsIndexHost (&ngraph, i);
+   RaHostsRebuildEdges (&ngraph);
+
+   if ((msync (ngraph.hdr, ngraph.len, MS_SYNC) < 0) || (fsync (ngraph.fd) < 0))
+      ArgusLog (LOG_ERR, "RaHostsGrowGraph: sync %s error %s", tmpname, strerror(errno));
+
+   if (rename (tmpname, graph->filename) < 0)
+      ArgusLog (LOG_ERR, "RaHostsGrowGraph: rename %s error %s", tmpname, strerror(errno));
+
+   RaHostsUnmapGraph (graph);
+   close (graph->fd);
+
+   graph->fd     = ngraph.fd;
+   graph->len    = ngraph.len;
+   graph->hdr    = ngraph.hdr;
+   graph->hosts  = ngraph.hosts;
+   graph->hindex = ngraph.hindex;
+   graph->edges  = ngraph.edges;
+   graph->eindex = ngraph.eindex;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaHostsGrowGraph(%p) %s hosts %u edges %u\n", graph, graph->filename, hcapacity, ecapacity);
+#endif
+}
+
+struct RaHostsGraphStruct *
+RaHostsOpenGraph (struct ArgusParserStruct *parser, char *filename)
+{
+   struct RaHostsGraphStruct *graph = NULL;
+   struct flock lock;
+   struct stat statbuf;
+
+   if ((graph = (struct RaHostsGraphStruct *) ArgusCalloc (1, sizeof(*graph))) == NULL)
+      ArgusLog (LOG_ERR, "RaHostsOpenGraph: ArgusCalloc error %s", strerror(errno));
+
+   graph->filename = strdup(filename);
+
+   if ((graph->fd = open (filename, O_RDWR | O_CREAT, 0644)) < 0)
+      ArgusLog (LOG_ERR, "RaHostsOpenGraph: open %s error %s", filename, strerror(errno));
+
+   bzero (&lock, sizeof(lock));
+   lock.l_type = F_WRLCK;
+   lock.l_whence = SEEK_SET;
+
+   if (fcntl (graph->fd, F_SETLK, &lock) < 0)
+      ArgusLog (LOG_ERR, "RaHostsOpenGraph: %s is in use %s", filename, strerror(errno));
+
+   if (fstat (graph->fd, &statbuf) < 0)
+      ArgusLog (LOG_ERR, "RaHostsOpenGraph: stat %s error %s", filename, strerror(errno));
+
+   if (statbuf.st_size == 0) {
+      RaHostsMapGraph (graph, RAHOSTS_GRAPH_MINHOSTS, RAHOSTS_GRAPH_MINEDGES);
+      graph->hdr->magic     = RAHOSTS_GRAPH_MAGIC;
+      graph->hdr->version   = RAHOSTS_GRAPH_VERSION;
+      graph->hdr->hsize     = sizeof(struct RaHostsGraphHost);
+      graph->hdr->esize     = sizeof(struct RaHostsGraphEdge);
+      graph->hdr->hcapacity = RAHOSTS_GRAPH_MINHOSTS;
+      graph->hdr->ecapacity = RAHOSTS_GRAPH_MINEDGES;
+
+   } else {
+      struct RaHostsGraphHdr hdr;
+
+      if ((statbuf.st_size < sizeof(hdr)) || (read (graph->fd, &hdr, sizeof(hdr)) != sizeof(hdr)))
+         ArgusLog (LOG_ERR, "RaHostsOpenGraph: %s is not a hosts graph", filename);
+
+      if ((hdr.magic != RAHOSTS_GRAPH_MAGIC) || (hdr.version != RAHOSTS_GRAPH_VERSION) ||
+          (hdr.hsize != sizeof(struct RaHostsGraphHost)) || (hdr.esize != sizeof(struct RaHostsGraphEdge)) ||
+          (statbuf.st_size != RaHostsGraphLength(hdr.hcapacity, hdr.ecapacity)))
+         ArgusLog (LOG_ERR, "RaHostsOpenGraph: %s is not a hosts graph", filename);
+
+      RaHostsMapGraph (graph, hdr.hcapacity, hdr.ecapacity);
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaHostsOpenGraph(%p, %s) hosts %u edges %u\n", parser, filename, graph->hdr->hcount, graph->hdr->ecount);
+#endif
+   return (graph);
+}
+
+/*
+ *  Drop the edges that haven't been seen in RAHOSTS_GRAPH_DAYS, when
+ *  there are enough of them to be worth it.  The edges are packed down,
+ *  and the host chains and the edge index are rebuilt.
+ */
+
+static void
+RaHostsPruneGraph (struct RaHostsGraphStruct *graph)
+{
+   struct RaHostsGraphHdr *hdr = graph->hdr;
+   unsigned int i, n = 0;
+
+   for (i = 0; i < hdr->ecount; i++)
+      if ((hdr->lastday - graph->edges[i].day) < RAHOSTS_GRAPH_DAYS)
+         n++;
+
+   if ((hdr->ecount - n) < (hdr->ecount / 4))
+      return;
+
+   for (i = 0; i < hdr->hcount; i++) {
+      graph->hosts[i].head = 0;
+      graph->hosts[i].degree = 0;
+   }
+
+   for (i = 0, n = 0; i < hdr->ecount; i++) {
+      struct RaHostsGraphEdge *edge = &graph->edges[i];
+
+      if ((hdr->lastday - edge->day) < RAHOSTS_GRAPH_DAYS) {
+         struct RaHostsGraphHost *host = &graph->hosts[edge->src];
+
+         graph->edges[n] = *edge;
+         graph->edges[n].next = host->head;
+         host->head = n + 1;
+         host->degree++;
+         n++;
+      }
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaHostsPruneGraph(%p) %s dropped %u edges\n", graph, graph->filename, hdr->ecount - n);
+#endif
+   hdr->ecount = n;
+   RaHostsRebuildEdges (graph);
+}
+
+void
+RaHostsCloseGraph (struct ArgusParserStruct *parser, struct RaHostsGraphStruct *graph)
+{
+   if (graph->hdr != NULL) {
+      RaHostsPruneGraph (graph);
+      msync (graph->hdr, graph->len, MS_SYNC);
+      munmap (graph->hdr, graph->len);
+   }
+   close (graph->fd);
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaHostsCloseGraph(%p, %s)\n", parser, graph->filename);
+#endif
+   free (graph->filename);
+   ArgusFree (graph);
+}
+
+/*
+ *  Set the bit for day, sliding the bitmap up when day is later than
+ *  the last day seen.
+ */
+
+static void
+RaHostsGraphDay (unsigned int *last, unsigned long long *days, unsigned int day)
+{
+   if (*days == 0) {
+      *last = day;
+      *days = 1;
+
+   } else
+   if (day > *last) {
+      *days = ((day - *last) < RAHOSTS_GRAPH_DAYS) ? ((*days << (day - *last)) | 1) : 1;
+      *last = day;
+
+   } else
+   if ((*last - day) < RAHOSTS_GRAPH_DAYS)
+      *days |= 1ULL << (*last - day);
+}
+
+static unsigned int
+RaHostsFindHost (struct RaHostsGraphStruct *graph, unsigned int addr, int create)
+{
+   unsigned int i, mask = (graph->hdr->hcapacity * 2) - 1;
+   struct RaHostsGraphHost *host;
+
+   for (i = RaHostsGraphHash(addr, 0) & mask; graph->hindex[i] != 0; i = (i + 1) & mask)
+      if (graph->hosts[graph->hindex[i] - 1].addr == addr)
+         return (graph->hindex[i]);
+
+   if (!create)
+      return (0);
+
+   if (graph->hdr->hcount == graph->hdr->hcapacity) {
+      RaHostsGrowGraph (graph, graph->hdr->hcapacity * 2, graph->hdr->ecapacity);
+      return (RaHostsFindHost (graph, addr, create));
+   }
+
+   host = &graph->hosts[graph->hdr->hcount];
+   bzero (host, sizeof(*host));
+   host->addr = addr;
+
+   RaHostsIndexHost (graph, graph->hdr->hcount);
+   return (++graph->hdr->hcount);
+}
+
+static struct RaHostsGraphEdge *
+RaHostsFindEdge (struct RaHostsGraphStruct *graph, unsigned int src, unsigned int dst)
+{
+   unsigned int i, mask = (graph->hdr->ecapacity * 2) - 1;
+   struct RaHostsGraphEdge *edge;
+   struct RaHostsGraphHost *host;
+
+   for (i = RaHostsGraphHash(src, dst) & mask; graph->eindex[i] != 0; i = (i + 1) & mask) {
+      edge = &graph->edges[graph->eindex[i] - 1];
+      if ((edge->src == src) && (edge->dst == dst))
+         return (edge);
+   }
+
+   if (graph->hdr->ecount == graph->hdr->ecapacity) {
+      RaHostsGrowGraph (graph, graph->hdr->hcapacity, graph->hdr->ecapacity * 2);
+      return (RaHostsFindEdge (graph, src, dst));
+   }
+
+   host = &graph->hosts[src];
+   edge = &graph->edges[graph->hdr->ecount];
+   bzero (edge, sizeof(*edge));
+   edge->src  = src;
+   edge->dst  = dst;
+   edge->next = host->head;
+   host->head = graph->hdr->ecount + 1;
+   host->degree++;
+
+   RaHostsIndexEdge (graph, graph->hdr->ecount++);
+   return (edge);
+}
+
+void
+RaHostsGraphRecord (struct ArgusParserStruct *parser, struct RaHostsGraphStruct *graph, struct ArgusRecordStruct *argus, int sloc, int dloc)
+{
+   struct ArgusFlow *flow = (struct ArgusFlow *) argus->dsrs[ARGUS_FLOW_INDEX];
+   unsigned int src, dst, day;
+   struct tm tmbuf;
+   time_t tsec;
+
+   if (flow == NULL)
+      return;
+
+   switch (flow->hdr.subtype & 0x3F) {
+      case ARGUS_FLOW_CLASSIC5TUPLE:
+      case ARGUS_FLOW_LAYER_3_MATRIX:
+         if ((flow->hdr.argus_dsrvl8.qual & 0x1F) == ARGUS_TYPE_IPV4)
+            break;
+      default:
+         return;
+   }
+
+   tsec = ArgusFetchStartTime(argus);
+   if (localtime_r(&tsec, &tmbuf) == NULL)
+      return;
+   day = (tsec + tmbuf.tm_gmtoff) / 86400;
+
+   src = RaHostsFindHost (graph, flow->ip_flow.ip_src, 1) - 1;
+   dst = RaHostsFindHost (graph, flow->ip_flow.ip_dst, 1) - 1;
+
+   if (day > graph->hdr->lastday)
+      graph->hdr->lastday = day;
+
+   graph->hosts[src].locality = sloc;
+   graph->hosts[dst].locality = dloc;
+   RaHostsGraphDay (&graph->hosts[src].day, &graph->hosts[src].days, day);
+   RaHostsGraphDay (&graph->hosts[dst].day, &graph->hosts[dst].days, day);
+
+   if (src != dst) {
+      struct RaHostsGraphEdge *edge = RaHostsFindEdge (graph, src, dst);
+      RaHostsGraphDay (&edge->day, &edge->days, day);
+
+      edge = RaHostsFindEdge (graph, dst, src);
+      RaHostsGraphDay (&edge->day, &edge->days, day);
+   }
+}
+
+/*
+ *  The days, of the last RaHostsGraphDays ending on the graph's last
+ *  day, that a host or edge was seen.
+ */
+
+static unsigned long long
+RaHostsGraphWindow (struct RaHostsGraphStruct *graph, unsigned int last, unsigned long long days)
+{
+   unsigned int shift = graph->hdr->lastday - last;
+
+   if (shift >= RaHostsGraphDays)
+      return (0);
+
+   if ((RaHostsGraphDays - shift) < RAHOSTS_GRAPH_DAYS)
+      days &= (1ULL << (RaHostsGraphDays - shift)) - 1;
+
+   return (days);
+}
+
+static int
+RaHostsComparePeers (const void *a, const void *b)
+{
+   unsigned int pa = *(unsigned int *) a, pb = *(unsigned int *) b;
+   return ((pa < pb) ? -1 : ((pa > pb) ? 1 : 0));
+}
+
+static void
+RaHostsPrintGraphHost (struct ArgusParserStruct *parser, struct RaHostsGraphStruct *graph, unsigned int host, unsigned int *peers)
+{
+   struct RaHostsGraphHost *hptr = &graph->hosts[host];
+   char saddr[32], loc[16], cnt[32], region[16];
+   unsigned int e, count = 0, i;
+   int slen = 0;
+
+   if (RaHostsGraphWindow (graph, hptr->day, hptr->days) == 0)
+      return;
+
+   for (e = hptr->head; e != 0; e = graph->edges[e - 1].next) {
+      struct RaHostsGraphEdge *edge = &graph->edges[e - 1];
+      if (RaHostsGraphWindow (graph, edge->day, edge->days) != 0)
+         peers[count++] = graph->hosts[edge->dst].addr;
+   }
+
+   qsort (peers, count, sizeof(*peers), RaHostsComparePeers);
+
+   RaHostsAddressList[0] = '\0';
+   for (i = 0; (i < count) && (slen < RAHOSTSADDRESSLIST); i++)
+      slen += snprintf (&RaHostsAddressList[slen], RAHOSTSADDRESSLIST - slen, "%s%s", i ? "," : "", intoa(peers[i]));
+
+   snprintf (region, sizeof(region), "%dd", RaHostsGraphDays);
+   snprintf (saddr, sizeof(saddr), "%s", intoa(hptr->addr));
+   snprintf (loc, sizeof(loc), "%d", hptr->locality);
+   snprintf (cnt, sizeof(cnt), "%u", count);
+
+   ArgusProcessAddressData(parser, region, "", "", saddr, loc, cnt, RaHostsAddressList);
+}
+
+/*
+ *  Report the peers, over the last RaHostsGraphDays, of each peers=
+ *  address, or of every host seen in that time.
+ */
+
+void
+RaHostsPrintGraph (struct ArgusParserStruct *parser, struct RaHostsGraphStruct *graph)
+{
+   struct ArgusModeStruct *mode;
+   unsigned int *peers, i, maxdegree = 1;
+   int all = 1;
+
+   for (i = 0; i < graph->hdr->hcount; i++)
+      if (graph->hosts[i].degree > maxdegree)
+         maxdegree = graph->hosts[i].degree;
+
+   if ((peers = ArgusCalloc (maxdegree, sizeof(*peers))) == NULL)
+      ArgusLog (LOG_ERR, "RaHostsPrintGraph: ArgusCalloc error %s", strerror(errno));
+
+   for (mode = parser->ArgusModeList; mode != NULL; mode = mode->nxt) {
+      if (!(strncasecmp (mode->mode, "peers=", 6))) {
+         struct in_addr addr;
+         unsigned int host;
+
+         all = 0;
+         if (inet_aton (&mode->mode[6], &addr) == 0)
+            ArgusLog (LOG_ERR, "RaHostsPrintGraph: peers address %s is not valid", &mode->mode[6]);
+
+         if ((host = RaHostsFindHost (graph, ntohl(addr.s_addr), 0)) != 0)
+            RaHostsPrintGraphHost (parser, graph, host - 1, peers);
+      }
+   }
+
+   if (all)
+      for (i = 0; i < graph->hdr->hcount; i++)
+         RaHostsPrintGraphHost (parser, graph, i, peers);
+
+   ArgusFree (peers);
+}
+
+
 struct ArgusProbeStruct *
 ArgusNewProbe (struct ArgusParserStruct *parser, struct ArgusHashStruct *hstruct)
 {
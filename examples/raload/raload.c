@@ -0,0 +1,311 @@
+/*
+ * Argus-5.0 Client Software. Tools to read, analyze and manage Argus data.
+ * Copyright (c) 2000-2024 QoSient, LLC
+ * All rights reserved.
+ *
+ * THE ACCOMPANYING PROGRAM IS PROPRIETARY SOFTWARE OF QoSIENT, LLC,
+ * AND CANNOT BE USED, DISTRIBUTED, COPIED OR MODIFIED WITHOUT
+ * EXPRESS PERMISSION OF QoSIENT, LLC.
+ *
+ * QOSIENT, LLC DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS, IN NO EVENT SHALL QOSIENT, LLC BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF
+ * THIS SOFTWARE.
+ *
+ * raload.c  - load generator for radium() and other argus stream readers.
+ *
+ *    Read argus data into memory, wait for a client to attach to the
+ *    port specified with -P, and then replay the records as an argus
+ *    stream as fast as the client will take them, as many times as
+ *    requested with "-M loop=N".  When done, print the number of
+ *    records and bytes sent, and the rates achieved.
+ *
+ *    Because the writes block when the reader falls behind, the rates
+ *    reported are the rates that the reader, i.e. radium -S, sustained.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "argus_config.h"
+#endif
+
+#if defined(CYGWIN)
+#define USE_IPV6
+#endif
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <rabins.h>
+#include <argus_util.h>
+#include <argus_client.h>
+#include <argus_main.h>
+#include <signal.h>
+#include <ctype.h>
+
+#define RALOAD_BUFFER_SIZE	(1024 * 1024)
+
+static char *RaLoadBuffer = NULL;
+static long long RaLoadBufferLen = 0;
+static long long RaLoadBufferSize = 0;
+
+/* the first record is the initial MAR, which is only sent once */
+static long long RaLoadInitLen = 0;
+static long long RaLoadRecords = 0;
+static int RaLoadLoops = 1;
+static volatile int RaLoadInterrupted = 0;
+
+static char ArgusRecordBuffer[ARGUS_MAXRECORDSIZE];
+
+static void RaLoadAppend (char *, int);
+static int RaLoadWrite (int, char *, long long);
+static void RaLoadReplay (struct ArgusParserStruct *);
+
+void
+ArgusClientInit (struct ArgusParserStruct *parser)
+{
+   struct ArgusModeStruct *mode = NULL;
+
+   parser->RaWriteOut = 0;
+
+   if (!(parser->RaInitialized)) {
+      if ((mode = parser->ArgusModeList) != NULL) {
+         while (mode) {
+            if (!(strncasecmp (mode->mode, "loop=", 5))) {
+               char *endptr = NULL;
+               RaLoadLoops = strtol(&mode->mode[5], &endptr, 10);
+               if ((endptr == &mode->mode[5]) || (RaLoadLoops < 0))
+                  ArgusLog (LOG_ERR, "ArgusClientInit: loop value %s invalid", &mode->mode[5]);
+            }
+            mode = mode->nxt;
+         }
+      }
+
+      if (parser->ArgusPortNum == 0)
+         ArgusLog (LOG_ERR, "ArgusClientInit: -P port required");
+
+      (void) signal (SIGHUP,  (void (*)(int)) RaParseComplete);
+      (void) signal (SIGPIPE, SIG_IGN);
+
+      parser->RaInitialized++;
+   }
+}
+
+void RaArgusInputComplete (struct ArgusInput *input) { return; }
+
+
+void
+RaParseComplete (int sig)
+{
+   if (sig >= 0) {
+      if (!ArgusParser->RaParseCompleting++) {
+#ifdef ARGUSDEBUG
+         ArgusDebug (2, "RaParseComplete(caught signal %d)\n", sig);
+#endif
+         if (sig == 0)
+            RaLoadReplay (ArgusParser);
+
+         switch (sig) {
+            case SIGHUP:
+            case SIGINT:
+            case SIGTERM:
+            case SIGQUIT:
+               ArgusShutDown(sig);
+               exit(0);
+               break;
+         }
+
+      } else
+      if (sig > 0)
+         RaLoadInterrupted++;
+   }
+}
+
+
+void
+ArgusClientTimeout ()
+{
+#ifdef ARGUSDEBUG
+   ArgusDebug (6, "ArgusClientTimeout()\n");
+#endif
+}
+
+void
+parse_arg (int argc, char**argv)
+{}
+
+void
+usage ()
+{
+   extern char version[];
+
+   fprintf (stdout, "Raload Version %s\n", version);
+   fprintf (stdout, "usage: %s [ra-options] -P port -r argusDataFile [-M loop=N] [- filter-expression]\n\n", ArgusParser->ArgusProgramName);
+
+#if defined (ARGUSDEBUG)
+   fprintf (stdout, "options: -D <level>         specify debug level\n");
+   fprintf (stdout, "         -h                 print help.\n");
+#else
+   fprintf (stdout, "options: -h                 print help.\n");
+#endif
+   fprintf (stdout, "         -M loop=<N>        replay the records N times, 0 replays until interrupted.\n");
+   fprintf (stdout, "         -P <port>          wait for a client to attach on <port>.\n");
+   fprintf (stdout, "         -r <file>          read argus data <file>. '-' denotes stdin.\n");
+   fprintf (stdout, "         -R <dir>           recursively decend to read argus data files.\n");
+   fprintf (stdout, "         -t <timerange>     specify <timerange> for reading records.\n");
+   fflush (stdout);
+
+   exit(1);
+}
+
+
+void
+RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
+{
+   struct ArgusRecord *argusrec = NULL;
+
+   if ((RaLoadBufferLen == 0) && ((argus->hdr.type & 0xF0) != ARGUS_MAR))
+      ArgusLog (LOG_ERR, "RaProcessRecord: input does not start with a MAR record");
+
+   if ((argusrec = ArgusGenerateRecord (argus, 0L, ArgusRecordBuffer, ARGUS_VERSION)) != NULL) {
+      int len = argusrec->hdr.len * 4;
+#ifdef _LITTLE_ENDIAN
+      ArgusHtoN(argusrec);
+#endif
+      RaLoadAppend ((char *) argusrec, len);
+
+      if (RaLoadInitLen == 0)
+         RaLoadInitLen = len;
+      else
+         RaLoadRecords++;
+   }
+}
+
+int RaSendArgusRecord(struct ArgusRecordStruct *argus) {return 0;}
+
+void ArgusWindowClose(void);
+
+void ArgusWindowClose(void) { 
+#ifdef ARGUSDEBUG
+   ArgusDebug (6, "ArgusWindowClose () returning\n"); 
+#endif
+}
+
+
+static void
+RaLoadAppend (char *buf, int len)
+{
+   if ((RaLoadBufferLen + len) > RaLoadBufferSize) {
+      long long size = RaLoadBufferSize ? (RaLoadBufferSize * 2) : RALOAD_BUFFER_SIZE;
+      char *tbuf;
+
+      while (size < (RaLoadBufferLen + len))
+         size *= 2;
+
+      if ((tbuf = ArgusMalloc(size)) == NULL)
+         ArgusLog (LOG_ERR, "RaLoadAppend: ArgusMalloc error %s", strerror(errno));
+
+      if (RaLoadBuffer != NULL) {
+         bcopy (RaLoadBuffer, tbuf, RaLoadBufferLen);
+         ArgusFree(RaLoadBuffer);
+      }
+      RaLoadBuffer = tbuf;
+      RaLoadBufferSize = size;
+   }
+
+   bcopy (buf, &RaLoadBuffer[RaLoadBufferLen], len);
+   RaLoadBufferLen += len;
+}
+
+static int
+RaLoadWrite (int fd, char *buf, long long len)
+{
+   while ((len > 0) && !(RaLoadInterrupted)) {
+      ssize_t cnt;
+
+      if ((cnt = write (fd, buf, (len > RALOAD_BUFFER_SIZE) ? RALOAD_BUFFER_SIZE : len)) < 0) {
+         if (errno == EINTR)
+            continue;
+         return (-1);
+      }
+      buf += cnt;
+      len -= cnt;
+   }
+   return ((len > 0) ? -1 : 0);
+}
+
+static void
+RaLoadReplay (struct ArgusParserStruct *parser)
+{
+   struct sockaddr_in sin;
+   struct timeval start, end, diff;
+   long long records = 0, bytes = 0;
+   int s, fd, on = 1, loop = 0;
+   double secs;
+
+   if (RaLoadBufferLen == 0) {
+      ArgusLog (LOG_WARNING, "RaLoadReplay: no records to replay");
+      return;
+   }
+
+   if ((s = socket (AF_INET, SOCK_STREAM, 0)) < 0)
+      ArgusLog (LOG_ERR, "RaLoadReplay: socket error %s", strerror(errno));
+
+   (void) setsockopt (s, SOL_SOCKET, SO_REUSEADDR, (char *)&on, sizeof(on));
+
+   bzero (&sin, sizeof(sin));
+   sin.sin_family = AF_INET;
+   sin.sin_addr.s_addr = htonl(INADDR_ANY);
+   sin.sin_port = htons(parser->ArgusPortNum);
+
+   if (bind (s, (struct sockaddr *)&sin, sizeof(sin)) < 0)
+      ArgusLog (LOG_ERR, "RaLoadReplay: bind port %d error %s", parser->ArgusPortNum, strerror(errno));
+
+   if (listen (s, 1) < 0)
+      ArgusLog (LOG_ERR, "RaLoadReplay: listen error %s", strerror(errno));
+
+   fprintf (stdout, "%s: %lld records, %lld bytes loaded, waiting on port %d\n",
+                    parser->ArgusProgramName, RaLoadRecords, RaLoadBufferLen, parser->ArgusPortNum);
+   fflush (stdout);
+
+   if ((fd = accept (s, NULL, NULL)) < 0)
+      ArgusLog (LOG_ERR, "RaLoadReplay: accept error %s", strerror(errno));
+
+   close (s);
+   (void) setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, (char *)&on, sizeof(on));
+
+   gettimeofday (&start, NULL);
+
+   if (RaLoadWrite (fd, RaLoadBuffer, RaLoadInitLen) == 0) {
+      bytes += RaLoadInitLen;
+
+      while (!(RaLoadInterrupted) && ((RaLoadLoops == 0) || (loop++ < RaLoadLoops))) {
+         if (RaLoadWrite (fd, &RaLoadBuffer[RaLoadInitLen], RaLoadBufferLen - RaLoadInitLen) < 0)
+            break;
+         records += RaLoadRecords;
+         bytes += RaLoadBufferLen - RaLoadInitLen;
+      }
+   }
+
+   gettimeofday (&end, NULL);
+   close (fd);
+
+   RaDiffTime (&end, &start, &diff);
+   secs = diff.tv_sec + (diff.tv_usec / 1000000.0);
+
+   fprintf (stdout, "%s: sent %lld records %lld bytes in %.3f secs",
+                    parser->ArgusProgramName, records, bytes, secs);
+   if (secs > 0.0)
+      fprintf (stdout, " %.1f records/sec %.2f Mbps", records / secs, (bytes * 8.0) / (secs * 1000000.0));
+   fprintf (stdout, "\n");
+   fflush (stdout);
+}
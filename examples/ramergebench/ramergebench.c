@@ -0,0 +1,260 @@
+/*
+ * Argus-5.0 Client Software. Tools to read, analyze and manage Argus data.
+ * Copyright (c) 2000-2024 QoSient, LLC
+ * All rights reserved.
+ *
+ * THE ACCOMPANYING PROGRAM IS PROPRIETARY SOFTWARE OF QoSIENT, LLC,
+ * AND CANNOT BE USED, DISTRIBUTED, COPIED OR MODIFIED WITHOUT
+ * EXPRESS PERMISSION OF QoSIENT, LLC.
+ *
+ * QOSIENT, LLC DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS, IN NO EVENT SHALL QOSIENT, LLC BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF
+ * THIS SOFTWARE.
+ *
+ * ramergebench.c  - ArgusMergeRecords() throughput benchmark.
+ *
+ *    Read argus data into memory, then merge the records into a set
+ *    of "-M aggs=N" aggregates, record i into aggregate i % N, as many
+ *    times as requested with "-M loop=N".  This is done once with the
+ *    layout specific merge kernels and once running every DSR merge
+ *    routine, and the merges/sec of each are printed.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "argus_config.h"
+#endif
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <rabins.h>
+#include <argus_util.h>
+#include <argus_client.h>
+#include <argus_main.h>
+#include <argus_cluster.h>
+#include <signal.h>
+#include <ctype.h>
+
+static struct ArgusRecordStruct **RaMergeRecords = NULL;
+static int RaMergeRecordCount = 0;
+static int RaMergeRecordSize = 0;
+
+static int RaMergeLoops = 10;
+static int RaMergeAggs = 1024;
+
+static double RaMergeRun (struct ArgusParserStruct *, int, long long *);
+
+void
+ArgusClientInit (struct ArgusParserStruct *parser)
+{
+   struct ArgusModeStruct *mode = NULL;
+
+   parser->RaWriteOut = 0;
+
+   if (!(parser->RaInitialized)) {
+      if ((mode = parser->ArgusModeList) != NULL) {
+         while (mode) {
+            char *endptr = NULL;
+
+            if (!(strncasecmp (mode->mode, "loop=", 5))) {
+               RaMergeLoops = strtol(&mode->mode[5], &endptr, 10);
+               if ((endptr == &mode->mode[5]) || (RaMergeLoops <= 0))
+                  ArgusLog (LOG_ERR, "ArgusClientInit: loop value %s invalid", &mode->mode[5]);
+            } else
+            if (!(strncasecmp (mode->mode, "aggs=", 5))) {
+               RaMergeAggs = strtol(&mode->mode[5], &endptr, 10);
+               if ((endptr == &mode->mode[5]) || (RaMergeAggs <= 0))
+                  ArgusLog (LOG_ERR, "ArgusClientInit: aggs value %s invalid", &mode->mode[5]);
+            }
+            mode = mode->nxt;
+         }
+      }
+
+      if ((parser->ArgusAggregator = ArgusNewAggregator(parser, NULL, ARGUS_RECORD_AGGREGATOR)) == NULL)
+         ArgusLog (LOG_ERR, "ArgusClientInit: ArgusNewAggregator error");
+
+      (void) signal (SIGHUP,  (void (*)(int)) RaParseComplete);
+
+      parser->RaInitialized++;
+   }
+}
+
+void RaArgusInputComplete (struct ArgusInput *input) { return; }
+
+
+void
+RaParseComplete (int sig)
+{
+   if (sig >= 0) {
+      if (!ArgusParser->RaParseCompleting++) {
+         struct ArgusParserStruct *parser = ArgusParser;
+         long long merges = 0;
+         double fast, generic;
+         int i;
+
+#ifdef ARGUSDEBUG
+         ArgusDebug (2, "RaParseComplete(caught signal %d)\n", sig);
+#endif
+         if ((sig == 0) && (RaMergeRecordCount > 0)) {
+            fast = RaMergeRun (parser, 1, &merges);
+            generic = RaMergeRun (parser, 0, &merges);
+
+            fprintf (stdout, "%s: %d records, %d aggregates, %d loops, %lld merges\n",
+                             parser->ArgusProgramName, RaMergeRecordCount, RaMergeAggs, RaMergeLoops, merges);
+            fprintf (stdout, "   kernels  %.3f secs %.0f merges/sec\n", fast, (fast > 0.0) ? merges / fast : 0.0);
+            fprintf (stdout, "   generic  %.3f secs %.0f merges/sec\n", generic, (generic > 0.0) ? merges / generic : 0.0);
+            if (fast > 0.0)
+               fprintf (stdout, "   speedup  %.2fx\n", generic / fast);
+            fflush (stdout);
+         }
+
+         for (i = 0; i < RaMergeRecordCount; i++)
+            ArgusDeleteRecordStruct (parser, RaMergeRecords[i]);
+         if (RaMergeRecords != NULL)
+            ArgusFree (RaMergeRecords);
+         RaMergeRecords = NULL;
+         RaMergeRecordCount = 0;
+
+         switch (sig) {
+            case SIGHUP:
+            case SIGINT:
+            case SIGTERM:
+            case SIGQUIT:
+               ArgusShutDown(sig);
+               exit(0);
+               break;
+         }
+      }
+   }
+}
+
+
+void
+ArgusClientTimeout ()
+{
+#ifdef ARGUSDEBUG
+   ArgusDebug (6, "ArgusClientTimeout()\n");
+#endif
+}
+
+void
+parse_arg (int argc, char**argv)
+{}
+
+void
+usage ()
+{
+   extern char version[];
+
+   fprintf (stdout, "Ramergebench Version %s\n", version);
+   fprintf (stdout, "usage: %s [ra-options] -r argusDataFile [-M loop=N aggs=N] [- filter-expression]\n\n", ArgusParser->ArgusProgramName);
+
+#if defined (ARGUSDEBUG)
+   fprintf (stdout, "options: -D <level>         specify debug level\n");
+   fprintf (stdout, "         -h                 print help.\n");
+#else
+   fprintf (stdout, "options: -h                 print help.\n");
+#endif
+   fprintf (stdout, "         -M loop=<N>        merge the records N times (default 10).\n");
+   fprintf (stdout, "            aggs=<N>        merge into N aggregates (default 1024).\n");
+   fprintf (stdout, "         -r <file>          read argus data <file>. '-' denotes stdin.\n");
+   fprintf (stdout, "         -R <dir>           recursively decend to read argus data files.\n");
+   fprintf (stdout, "         -t <timerange>     specify <timerange> for reading records.\n");
+   fflush (stdout);
+
+   exit(1);
+}
+
+
+void
+RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus)
+{
+   switch (argus->hdr.type & 0xF0) {
+      case ARGUS_NETFLOW:
+      case ARGUS_AFLOW:
+      case ARGUS_FAR: {
+         if (RaMergeRecordCount == RaMergeRecordSize) {
+            int size = RaMergeRecordSize ? (RaMergeRecordSize * 2) : 4096;
+            struct ArgusRecordStruct **recs;
+
+            if ((recs = ArgusCalloc(size, sizeof(*recs))) == NULL)
+               ArgusLog (LOG_ERR, "RaProcessRecord: ArgusCalloc error %s", strerror(errno));
+
+            if (RaMergeRecords != NULL) {
+               bcopy (RaMergeRecords, recs, RaMergeRecordCount * sizeof(*recs));
+               ArgusFree(RaMergeRecords);
+            }
+            RaMergeRecords = recs;
+            RaMergeRecordSize = size;
+         }
+
+         if ((RaMergeRecords[RaMergeRecordCount] = ArgusCopyRecordStruct(argus)) == NULL)
+            ArgusLog (LOG_ERR, "RaProcessRecord: ArgusCopyRecordStruct error %s", strerror(errno));
+         RaMergeRecordCount++;
+         break;
+      }
+   }
+}
+
+int RaSendArgusRecord(struct ArgusRecordStruct *argus) {return 0;}
+
+void ArgusWindowClose(void);
+
+void ArgusWindowClose(void) {
+#ifdef ARGUSDEBUG
+   ArgusDebug (6, "ArgusWindowClose () returning\n");
+#endif
+}
+
+
+/*
+ * Merge the records into fresh copies of the first aggs records, and
+ * return the time spent merging.  Only the ArgusMergeRecords() calls
+ * are timed.
+ */
+
+static double
+RaMergeRun (struct ArgusParserStruct *parser, int fastpath, long long *merges)
+{
+   struct ArgusAggregatorStruct *agg = parser->ArgusAggregator;
+   struct ArgusRecordStruct **aggs;
+   struct timeval start, end, diff;
+   int i, loop, naggs, fp = ArgusMergeFastPath;
+
+   naggs = (RaMergeAggs < RaMergeRecordCount) ? RaMergeAggs : RaMergeRecordCount;
+
+   if ((aggs = ArgusCalloc(naggs, sizeof(*aggs))) == NULL)
+      ArgusLog (LOG_ERR, "RaMergeRun: ArgusCalloc error %s", strerror(errno));
+
+   for (i = 0; i < naggs; i++)
+      if ((aggs[i] = ArgusCopyRecordStruct(RaMergeRecords[i])) == NULL)
+         ArgusLog (LOG_ERR, "RaMergeRun: ArgusCopyRecordStruct error %s", strerror(errno));
+
+   ArgusMergeFastPath = fastpath;
+   *merges = 0;
+
+   gettimeofday (&start, NULL);
+
+   for (loop = 0; loop < RaMergeLoops; loop++) {
+      for (i = 0; i < RaMergeRecordCount; i++)
+         ArgusMergeRecords (agg, aggs[i % naggs], RaMergeRecords[i]);
+      *merges += RaMergeRecordCount;
+   }
+
+   gettimeofday (&end, NULL);
+   ArgusMergeFastPath = fp;
+
+   for (i = 0; i < naggs; i++)
+      ArgusDeleteRecordStruct (parser, aggs[i]);
+   ArgusFree(aggs);
+
+   RaDiffTime (&end, &start, &diff);
+   return (diff.tv_sec + (diff.tv_usec / 1000000.0));
+}
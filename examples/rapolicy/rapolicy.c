@@ -61,6 +61,7 @@
 
 struct RaPolicyPolicyStruct *RaPolicy = NULL;
 struct RaPolicyPolicyStruct *RaGlobalPolicy = NULL;
+struct RaPolicyClassifierStruct *RaPolicyClassifier = NULL;
 
 static int argus_version = ARGUS_VERSION;
 
@@ -69,14 +70,32 @@ int RaReadPolicy (struct ArgusParserStruct *, struct RaPolicyPolicyStruct **, ch
 int RaParsePolicy (struct ArgusParserStruct *, struct RaPolicyPolicyStruct **, char *);
 int RaCheckPolicy (struct ArgusParserStruct *, struct ArgusRecordStruct *, struct RaPolicyPolicyStruct *);
 int RaMeetsPolicyCriteria (struct ArgusParserStruct *, struct ArgusRecordStruct *, struct RaPolicyPolicyStruct *);
+int RaPolicyMatch (struct ArgusParserStruct *, struct ArgusRecordStruct *, struct RaPolicyPolicyStruct *);
+int RaPolicyHit (struct ArgusParserStruct *, struct ArgusRecordStruct *, struct RaPolicyPolicyStruct *);
+struct RaPolicyClassifierStruct *RaPolicyCompile (struct RaPolicyPolicyStruct *);
+void RaPolicyDeleteClassifier (struct RaPolicyClassifierStruct *);
+int RaPolicyClassify (struct ArgusParserStruct *, struct ArgusRecordStruct *, struct RaPolicyClassifierStruct *);
 void RaDumpPolicy (struct ArgusParserStruct *, struct RaPolicyPolicyStruct *);
 void RaDumpCounters (struct RaPolicyPolicyStruct *);
 int RaDoNotification (struct ArgusRecordStruct *, struct RaPolicyPolicyStruct *);
 
+static int RaPolicyLinear = 0;
+static int RaPolicyBench = 0;
+static int RaPolicySynth = 0;
+
+static struct ArgusRecordStruct **RaPolicyRecords = NULL;
+static int RaPolicyRecordCount = 0;
+static int RaPolicyRecordSize = 0;
+
+static void RaPolicySynthesize (struct ArgusParserStruct *, struct RaPolicyPolicyStruct **, int);
+static void RaPolicyRunBench (struct ArgusParserStruct *);
+
 
 void
 ArgusClientInit (struct ArgusParserStruct *parser)
 {
+   struct ArgusModeStruct *mode = NULL;
+
    parser->RaWriteOut = 1;
 
    if (!(parser->RaInitialized)) {
@@ -88,6 +107,25 @@ ArgusClientInit (struct ArgusParserStruct *parser)
       parser->RaInitialized++;
       parser->RaWriteOut = 0;
 
+      if ((mode = parser->ArgusModeList) != NULL) {
+         while (mode) {
+            if (!(strncasecmp (mode->mode, "linear", 6)))
+               RaPolicyLinear = 1;
+            else
+            if (!(strncasecmp (mode->mode, "bench", 5)))
+               RaPolicyBench = 1;
+            else
+            if (!(strncasecmp (mode->mode, "synth=", 6))) {
+               char *endptr = NULL;
+
+               RaPolicySynth = strtol(&mode->mode[6], &endptr, 10);
+               if ((endptr == &mode->mode[6]) || (RaPolicySynth <= 0))
+                  ArgusLog (LOG_ERR, "ArgusClientInit: synth value %s invalid", &mode->mode[6]);
+            }
+            mode = mode->nxt;
+         }
+      }
+
       if (parser->ArgusFlowModelFile != NULL) {
          RaPolicyParseResourceFile (parser, parser->ArgusFlowModelFile, &RaPolicy);
       } else {
@@ -95,6 +133,12 @@ ArgusClientInit (struct ArgusParserStruct *parser)
             RaPolicyParseResourceFile (parser, "/etc/rapolicy.conf", &RaPolicy);
          }
       }
+
+      if (RaPolicySynth)
+         RaPolicySynthesize (parser, &RaPolicy, RaPolicySynth);
+
+      if ((RaPolicy != NULL) && !(RaPolicyLinear))
+         RaPolicyClassifier = RaPolicyCompile (RaPolicy);
    }
 }
 
@@ -109,6 +153,9 @@ RaParseComplete (int sig)
          if (ArgusParser->ArgusPrintJson)
             fprintf (stdout, "\n");
 
+         if (RaPolicyBench && (sig == 0) && (RaPolicy != NULL))
+            RaPolicyRunBench (ArgusParser);
+
 #ifdef ARGUSDEBUG
          ArgusDebug (2, "RaParseComplete(caught signal %d)\n", sig);
 #endif
@@ -175,6 +222,9 @@ usage ()
    fprintf (stdout, "usage: %s -f rapolicy.conf [ra-options]\n", ArgusParser->ArgusProgramName);
 
    fprintf (stdout, "options: -f rapolicy.conf file.\n");
+   fprintf (stdout, "         -M linear          check the ACL entries in order, without the classifier.\n");
+   fprintf (stdout, "            bench           time the linear scan against the classifier.\n");
+   fprintf (stdout, "            synth=<N>       use <N> random ACL entries in place of the ACL file.\n");
    fflush (stdout);
 
    exit(1);
@@ -239,6 +289,28 @@ RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *arg
                }
             }
 
+            if (process && RaPolicyBench) {
+               if (RaPolicyRecordCount == RaPolicyRecordSize) {
+                  int size = RaPolicyRecordSize ? (RaPolicyRecordSize * 2) : 4096;
+                  struct ArgusRecordStruct **recs;
+
+                  if ((recs = ArgusCalloc(size, sizeof(*recs))) == NULL)
+                     ArgusLog (LOG_ERR, "RaProcessRecord: ArgusCalloc error %s", strerror(errno));
+
+                  if (RaPolicyRecords != NULL) {
+                     bcopy (RaPolicyRecords, recs, RaPolicyRecordCount * sizeof(*recs));
+                     ArgusFree(RaPolicyRecords);
+                  }
+                  RaPolicyRecords = recs;
+                  RaPolicyRecordSize = size;
+               }
+
+               if ((RaPolicyRecords[RaPolicyRecordCount] = ArgusCopyRecordStruct(argus)) == NULL)
+                  ArgusLog (LOG_ERR, "RaProcessRecord: ArgusCopyRecordStruct error %s", strerror(errno));
+               RaPolicyRecordCount++;
+               return;
+            }
+
             if (process){
                struct ArgusRecordStruct *ns = ArgusCopyRecordStruct(argus);
                if ((RaCheckPolicy (parser, ns, RaPolicy) || (parser->RaPolicyStatus & ARGUS_POLICY_JUST_LABEL)))
@@ -1515,6 +1587,366 @@ RaParsePolicy (struct ArgusParserStruct *parser, struct RaPolicyPolicyStruct **p
    return 1;
 }
 
+/*
+ * The compiled classifier, a tuple space search.  Each permit or deny
+ * entry goes into the tuple for its source and destination wildcard
+ * masks and whether it names a protocol, and into a hash table under
+ * the tuple, its addresses and protocol.  A flow is looked up in each
+ * tuple, with that tuple's masks applied, and the entries found are
+ * tested with RaPolicyMatch() in ACL order.  The tuples are kept in
+ * the order of their first entry, and once an entry has matched, the
+ * tuples and entries that come after it are passed over, so the entry
+ * found is the one the linear scan would stop at.  Entries that neither
+ * permit nor deny are counted without ending the scan, so they are
+ * kept aside and tested in order up to that entry.
+ */
+
+static unsigned int
+RaPolicyClassHash (int tuple, arg_uint32 saddr, arg_uint32 daddr, int proto)
+{
+   unsigned int hash = saddr * 0x9E3779B1;
+
+   hash ^= (daddr + (hash >> 15)) * 0x85EBCA6B;
+   hash ^= ((tuple << 8) | proto) * 0xC2B2AE35;
+   hash ^= hash >> 16;
+   return (hash);
+}
+
+static struct RaPolicyClassEntry *
+RaPolicyClassFind (struct RaPolicyClassifierStruct *cls, int tuple, arg_uint32 saddr, arg_uint32 daddr, int proto, int create)
+{
+   unsigned int ind = RaPolicyClassHash(tuple, saddr, daddr, proto) & (cls->size - 1);
+   struct RaPolicyClassEntry *entry;
+
+   for (entry = cls->table[ind]; entry != NULL; entry = entry->nxt)
+      if ((entry->saddr == saddr) && (entry->daddr == daddr) && (entry->tuple == tuple) && (entry->proto == proto))
+         return (entry);
+
+   if (create) {
+      if ((entry = ArgusCalloc (1, sizeof(*entry))) == NULL)
+         ArgusLog (LOG_ERR, "RaPolicyClassFind: ArgusCalloc error %s", strerror(errno));
+      entry->saddr = saddr;
+      entry->daddr = daddr;
+      entry->tuple = tuple;
+      entry->proto = proto;
+      entry->nxt = cls->table[ind];
+      cls->table[ind] = entry;
+      cls->entries++;
+   }
+   return (entry);
+}
+
+struct RaPolicyClassifierStruct *
+RaPolicyCompile (struct RaPolicyPolicyStruct *policy)
+{
+   struct RaPolicyClassifierStruct *cls;
+   struct RaPolicyPolicyStruct *pol;
+   int i, t, count = 0;
+
+   for (pol = policy; pol != NULL; pol = pol->nxt)
+      count++;
+
+   if ((cls = ArgusCalloc (1, sizeof(*cls))) == NULL)
+      ArgusLog (LOG_ERR, "RaPolicyCompile: ArgusCalloc error %s", strerror(errno));
+
+   for (cls->size = 1024; cls->size < (count * 2); cls->size <<= 1) ;
+
+   if (((cls->policy = ArgusCalloc (count + 1, sizeof(*cls->policy))) == NULL) ||
+       ((cls->tuples = ArgusCalloc (count + 1, sizeof(*cls->tuples))) == NULL) ||
+       ((cls->others = ArgusCalloc (count + 1, sizeof(*cls->others))) == NULL) ||
+       ((cls->table  = ArgusCalloc (cls->size, sizeof(*cls->table))) == NULL))
+      ArgusLog (LOG_ERR, "RaPolicyCompile: ArgusCalloc error %s", strerror(errno));
+
+   for (i = 0, pol = policy; pol != NULL; i++, pol = pol->nxt) {
+      arg_uint32 saddr = 0, daddr = 0, smask = 0xFFFFFFFF, dmask = 0xFFFFFFFF;
+      struct RaPolicyClassEntry *entry;
+      int proto = 0, hasproto = 0;
+
+      cls->policy[i] = pol;
+
+      if (pol->flags & RA_COMMENT)
+         continue;
+
+      if (!(pol->flags & (RA_PERMIT | RA_DENY))) {
+         cls->others[cls->nothers++] = i;
+         continue;
+      }
+
+      if (pol->flags & RA_SRC_SET) {
+         saddr = pol->src.addr;
+         smask = pol->src.mask;
+      }
+      if (pol->flags & RA_DST_SET) {
+         daddr = pol->dst.addr;
+         dmask = pol->dst.mask;
+      }
+      if ((pol->flags & RA_PROTO_SET) && pol->proto) {
+         proto = (u_char) pol->proto;
+         hasproto = 1;
+      }
+
+      for (t = 0; t < cls->ntuples; t++)
+         if ((cls->tuples[t].smask == smask) && (cls->tuples[t].dmask == dmask) && (cls->tuples[t].proto == hasproto))
+            break;
+
+      if (t == cls->ntuples) {
+         if (t > 0xFFFF)
+            ArgusLog (LOG_ERR, "RaPolicyCompile: too many address masks");
+         cls->tuples[t].smask = smask;
+         cls->tuples[t].dmask = dmask;
+         cls->tuples[t].proto = hasproto;
+         cls->tuples[t].first = i;
+         cls->ntuples++;
+      }
+
+      entry = RaPolicyClassFind (cls, t, saddr, daddr, proto, 1);
+
+      if (entry->count == entry->size) {
+         int *index, size = entry->size ? entry->size * 2 : 4;
+
+         if ((index = ArgusCalloc (size, sizeof(*index))) == NULL)
+            ArgusLog (LOG_ERR, "RaPolicyCompile: ArgusCalloc error %s", strerror(errno));
+         if (entry->index != NULL) {
+            bcopy (entry->index, index, entry->count * sizeof(*index));
+            ArgusFree (entry->index);
+         }
+         entry->index = index;
+         entry->size = size;
+      }
+      entry->index[entry->count++] = i;
+   }
+   cls->policies = count;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaPolicyCompile (%p) %d entries %d tuples %u keys %d others\n", policy, count, cls->ntuples, cls->entries, cls->nothers);
+#endif
+   return (cls);
+}
+
+void
+RaPolicyDeleteClassifier (struct RaPolicyClassifierStruct *cls)
+{
+   struct RaPolicyClassEntry *entry, *nxt;
+   unsigned int i;
+
+   for (i = 0; i < cls->size; i++) {
+      for (entry = cls->table[i]; entry != NULL; entry = nxt) {
+         nxt = entry->nxt;
+         if (entry->index != NULL)
+            ArgusFree (entry->index);
+         ArgusFree (entry);
+      }
+   }
+   ArgusFree (cls->table);
+   ArgusFree (cls->others);
+   ArgusFree (cls->tuples);
+   ArgusFree (cls->policy);
+   ArgusFree (cls);
+}
+
+// returns what RaMeetsPolicyCriteria() returns for the first entry
+// in the ACL that the flow meets, or 0.
+
+int
+RaPolicyClassify (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus, struct RaPolicyClassifierStruct *cls)
+{
+   struct ArgusFlow *flow = (void *)argus->dsrs[ARGUS_FLOW_INDEX];
+   struct RaPolicyClassEntry *entry;
+   int i, t, best = cls->policies;
+
+   if (flow != NULL) {
+      arg_uint32 saddr = flow->ip_flow.ip_src;
+      arg_uint32 daddr = flow->ip_flow.ip_dst;
+      u_char proto = flow->ip_flow.ip_p;
+
+      for (t = 0; (t < cls->ntuples) && (cls->tuples[t].first < best); t++) {
+         struct RaPolicyTupleStruct *tuple = &cls->tuples[t];
+
+         if ((entry = RaPolicyClassFind (cls, t, saddr & ~tuple->smask, daddr & ~tuple->dmask, tuple->proto ? proto : 0, 0)) != NULL) {
+            for (i = 0; (i < entry->count) && (entry->index[i] < best); i++) {
+               if (RaPolicyMatch (parser, argus, cls->policy[entry->index[i]])) {
+                  best = entry->index[i];
+                  break;
+               }
+            }
+         }
+      }
+
+      for (i = 0; (i < cls->nothers) && (cls->others[i] < best); i++)
+         if (RaPolicyMatch (parser, argus, cls->policy[cls->others[i]]))
+            RaPolicyHit (parser, argus, cls->policy[cls->others[i]]);
+
+      if (best < cls->policies)
+         return (RaPolicyHit (parser, argus, cls->policy[best]));
+   }
+
+   return 0;
+}
+
+/*
+ * Benchmark support, -M bench and -M synth=<N>.  With bench the flows
+ * are read into memory, and at the end checked against the ACL once
+ * with the linear scan and once with the classifier, and the times,
+ * and whether the results and hit counters agree, are printed.  synth
+ * replaces the ACL with <N> random extended ACL entries, written out
+ * and read back with RaReadPolicy().
+ */
+
+static void
+RaPolicySynthAddr (char *buf, int len)
+{
+   static int bits[] = { 2, 4, 8 };
+   unsigned int addr = 0x0A000000 | ((random() % 16) << 8) | (random() % 256);
+   unsigned int wc, type = random() % 64;
+
+   if (type == 0)
+      snprintf (buf, len, "any");
+   else
+   if (type < 16) {
+      wc = (0x01 << bits[random() % 3]) - 1;
+      addr &= ~wc;
+      snprintf (buf, len, "%u.%u.%u.%u %u.%u.%u.%u", addr >> 24, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF,
+                     wc >> 24, (wc >> 16) & 0xFF, (wc >> 8) & 0xFF, wc & 0xFF);
+   } else
+      snprintf (buf, len, "host %u.%u.%u.%u", addr >> 24, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF);
+}
+
+static void
+RaPolicySynthesize (struct ArgusParserStruct *parser, struct RaPolicyPolicyStruct **policy, int count)
+{
+   static char *protos[] = { "ip", "tcp", "udp", "icmp" };
+   static char *ops[] = { "eq", "neq", "lt", "gt" };
+   static int ports[] = { 22, 53, 80, 443, 3389, 8080 };
+   char path[MAXSTRLEN], src[64], dst[64], port[64], *dir;
+   FILE *fp;
+   int i, fd, proto;
+
+   if ((dir = getenv("TMPDIR")) == NULL)
+      dir = "/tmp";
+
+   snprintf (path, MAXSTRLEN, "%s/rapolicy.XXXXXX", dir);
+   if ((fd = mkstemp(path)) < 0)
+      ArgusLog (LOG_ERR, "RaPolicySynthesize: mkstemp %s error %s", path, strerror(errno));
+
+   if ((fp = fdopen(fd, "w")) == NULL)
+      ArgusLog (LOG_ERR, "RaPolicySynthesize: fdopen error %s", strerror(errno));
+
+   srandom (1);
+
+   for (i = 0; i < count; i++) {
+      proto = random() % 4;
+      RaPolicySynthAddr (src, sizeof(src));
+      RaPolicySynthAddr (dst, sizeof(dst));
+
+      port[0] = '\0';
+      if (((proto == 1) || (proto == 2)) && (random() % 2)) {
+         int p = (random() % 2) ? ports[random() % 6] : (int)(1 + (random() % 1024));
+
+         if (random() % 5)
+            snprintf (port, sizeof(port), " %s %d", ops[random() % 4], p);
+         else
+            snprintf (port, sizeof(port), " range %d %d", p, p + (int)(random() % 1024));
+      }
+
+      fprintf (fp, "access-list 101 %s %s %s %s%s\n", (random() % 4) ? "deny" : "permit", protos[proto], src, dst, port);
+   }
+
+   if (fclose (fp) != 0)
+      ArgusLog (LOG_ERR, "RaPolicySynthesize: fclose error %s", strerror(errno));
+
+   *policy = NULL;
+   RaReadPolicy (parser, policy, path);
+   unlink (path);
+}
+
+static void
+RaPolicyRunBench (struct ArgusParserStruct *parser)
+{
+   struct RaPolicyClassifierStruct *cls = RaPolicyClassifier;
+   struct RaPolicyPolicyStruct *pol;
+   struct ArgusRecordStruct **recs;
+   struct timeval start, end, diff;
+   int i, j, pass, n = RaPolicyRecordCount, entries = 0, mismatches = 0;
+   long long *counts;
+   double secs[2];
+   int *results;
+
+   if (cls == NULL)
+      cls = RaPolicyCompile (RaPolicy);
+
+   for (pol = RaPolicy; pol != NULL; pol = pol->nxt)
+      entries++;
+
+   if ((counts = ArgusCalloc (entries + 1, 3 * sizeof(*counts))) == NULL)
+      ArgusLog (LOG_ERR, "RaPolicyRunBench: ArgusCalloc error %s", strerror(errno));
+   if ((results = ArgusCalloc (n + 1, sizeof(*results))) == NULL)
+      ArgusLog (LOG_ERR, "RaPolicyRunBench: ArgusCalloc error %s", strerror(errno));
+   if ((recs = ArgusCalloc (n + 1, sizeof(*recs))) == NULL)
+      ArgusLog (LOG_ERR, "RaPolicyRunBench: ArgusCalloc error %s", strerror(errno));
+
+   for (pass = 0; pass < 2; pass++) {
+      for (i = 0; i < n; i++)
+         if ((recs[i] = ArgusCopyRecordStruct (RaPolicyRecords[i])) == NULL)
+            ArgusLog (LOG_ERR, "RaPolicyRunBench: ArgusCopyRecordStruct error %s", strerror(errno));
+
+      for (pol = RaPolicy; pol != NULL; pol = pol->nxt)
+         pol->hitCount = pol->hitPkts = pol->hitBytes = 0;
+
+      RaPolicyClassifier = pass ? cls : NULL;
+      gettimeofday (&start, NULL);
+
+      for (i = 0; i < n; i++) {
+         int retn = RaCheckPolicy (parser, recs[i], RaPolicy);
+
+         if (pass == 0)
+            results[i] = retn;
+         else
+         if (results[i] != retn)
+            mismatches++;
+      }
+
+      gettimeofday (&end, NULL);
+      RaDiffTime (&end, &start, &diff);
+      secs[pass] = diff.tv_sec + (diff.tv_usec / 1000000.0);
+
+      for (j = 0, pol = RaPolicy; pol != NULL; j++, pol = pol->nxt) {
+         if (pass == 0) {
+            counts[j * 3]     = pol->hitCount;
+            counts[j * 3 + 1] = pol->hitPkts;
+            counts[j * 3 + 2] = pol->hitBytes;
+         } else
+         if ((counts[j * 3] != pol->hitCount) || (counts[j * 3 + 1] != pol->hitPkts) || (counts[j * 3 + 2] != pol->hitBytes))
+            mismatches++;
+      }
+
+      for (i = 0; i < n; i++)
+         ArgusDeleteRecordStruct (parser, recs[i]);
+   }
+
+   fprintf (stdout, "%s: %d flows, %d ACL entries, %d tuples, %u keys\n", parser->ArgusProgramName, n, entries, cls->ntuples, cls->entries);
+   fprintf (stdout, "   linear      %.3f secs %.0f flows/sec\n", secs[0], (secs[0] > 0.0) ? n / secs[0] : 0.0);
+   fprintf (stdout, "   classifier  %.3f secs %.0f flows/sec\n", secs[1], (secs[1] > 0.0) ? n / secs[1] : 0.0);
+   if (secs[1] > 0.0)
+      fprintf (stdout, "   speedup     %.2fx\n", secs[0] / secs[1]);
+   fprintf (stdout, "   %d mismatches\n", mismatches);
+   fflush (stdout);
+
+   RaPolicyClassifier = RaPolicyLinear ? NULL : cls;
+   if (RaPolicyLinear)
+      RaPolicyDeleteClassifier (cls);
+
+   ArgusFree (recs);
+   ArgusFree (results);
+   ArgusFree (counts);
+
+   for (i = 0; i < RaPolicyRecordCount; i++)
+      ArgusDeleteRecordStruct (parser, RaPolicyRecords[i]);
+   if (RaPolicyRecords != NULL)
+      ArgusFree (RaPolicyRecords);
+   RaPolicyRecords = NULL;
+   RaPolicyRecordCount = 0;
+}
+
 int
 RaCheckPolicy (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus, struct RaPolicyPolicyStruct *policy)
 {
@@ -1532,6 +1964,12 @@ RaCheckPolicy (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus
 //      Make the appropriate adjustments based on what you are displaying (deny or permit)
 
    if (policy) {
+      if ((policy == RaPolicy) && (RaPolicyClassifier != NULL)) {
+         if ((retn = RaPolicyClassify (parser, argus, RaPolicyClassifier))) {
+            if (retn == 1) { return 1;}  //do the permit stuff
+            if (retn == 2) { return 0;}  //do the deny stuff
+         }
+      } else
       while (policy) {
          if ((retn = RaMeetsPolicyCriteria (parser, argus, policy))) {
             if (retn == 1) { return 1;}  //do the permit stuff
@@ -1563,6 +2001,20 @@ RaMeetsPolicyCriteria (struct ArgusParserStruct *parser, struct ArgusRecordStruc
 //      There is no match for a permit or a deny ACL entry - check the next entry = 0
 //
 
+   if (RaPolicyMatch (parser, argus, policy))
+      return (RaPolicyHit (parser, argus, policy));
+
+   return 0;
+}
+
+// RaPolicyMatch tests the entry's criteria against the flow, without
+// touching the entry or the flow, so the classifier can try entries
+// out of order.  RaPolicyHit then counts and labels the matching entry.
+
+int
+RaPolicyMatch (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus, struct RaPolicyPolicyStruct *policy)
+{
+
    struct ArgusFlow *flow = (void *)argus->dsrs[ARGUS_FLOW_INDEX];
  
    if (flow != NULL) {
@@ -1768,30 +2220,39 @@ RaMeetsPolicyCriteria (struct ArgusParserStruct *parser, struct ArgusRecordStruc
          // TBD - code being tested now
       }
 
-      // If we make it to here we have a good match. Update the counts for this entry
+      // If we make it to here we have a good match.
 
-      {
-         struct ArgusMetricStruct *metric = (void *)argus->dsrs[ARGUS_METRIC_INDEX];
-         policy->hitCount++;
+      return 1;
+   }
 
-         if (metric != NULL) {
-            policy->hitPkts  += metric->src.pkts;
-            policy->hitBytes += metric->src.bytes;
-         }
+   return 0;
+}
 
-         if ((policy->flags & RA_PERMIT) || (policy->flags & RA_DENY)) {
-            if ((((parser->RaPolicyStatus & ARGUS_POLICY_LABEL_LOG)) && (policy->flags & RA_LOG_SET)) || 
-                         (parser->RaPolicyStatus & ARGUS_POLICY_LABEL_ALL))
-            ArgusAddToRecordLabel ( parser, argus, policy->labelStr);
-         }
+int
+RaPolicyHit (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus, struct RaPolicyPolicyStruct *policy)
+{
+   struct ArgusMetricStruct *metric = (void *)argus->dsrs[ARGUS_METRIC_INDEX];
 
-         if (policy->flags & (RA_PERMIT))
-            return((parser->RaPolicyStatus &  ARGUS_POLICY_SHOW_DENY) ? 2 : 1);
+   // Update the counts for this entry
 
-         if (policy->flags & (RA_DENY))
-            return((parser->RaPolicyStatus &  ARGUS_POLICY_SHOW_DENY) ? 1 : 2);
-      }
+   policy->hitCount++;
+
+   if (metric != NULL) {
+      policy->hitPkts  += metric->src.pkts;
+      policy->hitBytes += metric->src.bytes;
    }
 
+   if ((policy->flags & RA_PERMIT) || (policy->flags & RA_DENY)) {
+      if ((((parser->RaPolicyStatus & ARGUS_POLICY_LABEL_LOG)) && (policy->flags & RA_LOG_SET)) || 
+                   (parser->RaPolicyStatus & ARGUS_POLICY_LABEL_ALL))
+      ArgusAddToRecordLabel ( parser, argus, policy->labelStr);
+   }
+
+   if (policy->flags & (RA_PERMIT))
+      return((parser->RaPolicyStatus &  ARGUS_POLICY_SHOW_DENY) ? 2 : 1);
+
+   if (policy->flags & (RA_DENY))
+      return((parser->RaPolicyStatus &  ARGUS_POLICY_SHOW_DENY) ? 1 : 2);
+
    return 0;
 }
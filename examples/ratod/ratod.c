@@ -53,6 +53,8 @@
 
 #include <signal.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 
 int RaRealTime = 0;
 float RaUpdateRate = 1.0;
@@ -76,6 +78,77 @@ static int argus_version = ARGUS_VERSION;
 
 extern int ArgusTimeRangeStrategy;
 
+/*
+ *  Time of week baseline cube.
+ *
+ *  The cube is a file, mapped into memory, that holds, for each flow
+ *  key and each 5 minute slot of the week, the running sum and sum of
+ *  squares of the flows, packets and bytes seen in that slot, one sample
+ *  per week.  The samples for the open 5 minute interval are kept in
+ *  cur, and are folded into the moments when the slot is next used, so
+ *  the cube can be updated from each new archive file as it arrives,
+ *  and a key is found with a single hash probe.
+ *
+ *  The file is a header, the key table, and the hash index, which is
+ *  rebuilt when the key table grows.
+ */
+
+#define RATOD_CUBE_MAGIC	0x52544f44
+#define RATOD_CUBE_VERSION	1
+
+#define RATOD_SLOTSECS		300
+#define RATOD_SLOTS		(7 * 24 * 3600 / RATOD_SLOTSECS)
+#define RATOD_METRICS		3
+#define RATOD_KEYLEN		64
+#define RATOD_LABELLEN		128
+#define RATOD_MINKEYS		1024
+#define RATOD_MINWEEKS		2
+
+struct RaTodSlotStruct {
+   unsigned int interval, spare;
+   double cur[RATOD_METRICS];
+   double sum[RATOD_METRICS];
+   double sumsq[RATOD_METRICS];
+};
+
+struct RaTodKeyStruct {
+   unsigned int hash, len;
+   unsigned char key[RATOD_KEYLEN];
+   char label[RATOD_LABELLEN];
+   struct RaTodSlotStruct slots[RATOD_SLOTS];
+};
+
+struct RaTodCubeHdr {
+   unsigned int magic, version;
+   unsigned int keysize, nslots;
+   unsigned int capacity, count;
+   unsigned int interval, closed;
+   long long mask;
+   struct {
+      unsigned int interval, weeks;
+   } slots[RATOD_SLOTS];
+};
+
+struct RaTodCubeStruct {
+   char *filename;
+   int fd, score;
+   size_t len;
+   double zscore;
+   long long late;
+   struct RaTodCubeHdr *hdr;
+   struct RaTodKeyStruct *keys;
+   unsigned int *index;
+};
+
+struct RaTodCubeStruct *RaTodCube = NULL;
+static char *RaTodCubeFile = NULL;
+
+static const char *RaTodMetricNames[RATOD_METRICS] = { "flows", "pkts", "bytes" };
+
+struct RaTodCubeStruct *RaTodOpenCube (struct ArgusParserStruct *, char *, long long);
+void RaTodCloseCube (struct ArgusParserStruct *, struct RaTodCubeStruct *);
+void RaTodCubeUpdate (struct ArgusParserStruct *, struct RaTodCubeStruct *, struct ArgusRecordStruct *);
+
 void
 ArgusClientInit (struct ArgusParserStruct *parser)
 {
@@ -86,6 +159,7 @@ ArgusClientInit (struct ArgusParserStruct *parser)
    char outputfile[MAXSTRLEN];
    char *nocorrect = NULL;
    char *correct = NULL;
+   double score = 0.0;
 
    parser->RaWriteOut = 0;
    *outputfile = '\0';
@@ -160,7 +234,23 @@ ArgusClientInit (struct ArgusParserStruct *parser)
                else
                if (!(strncasecmp (mode->mode, "noman", 5)))
                   parser->ArgusPrintMan = 0;
-               else {
+               else
+               if (!(strncasecmp (mode->mode, "cube=", 5))) {
+                  if (RaTodCubeFile != NULL)
+                     free(RaTodCubeFile);
+                  RaTodCubeFile = strdup(&mode->mode[5]);
+                  ind = ARGUSSPLITMODENUM;
+               } else
+               if (!(strncasecmp (mode->mode, "score", 5))) {
+                  score = 3.0;
+                  if (mode->mode[5] == '=') {
+                     char *ptr = NULL;
+                     score = strtod(&mode->mode[6], (char **)&ptr);
+                     if ((ptr == &mode->mode[6]) || (score <= 0.0))
+                        usage();
+                  }
+                  ind = ARGUSSPLITMODENUM;
+               } else {
                   for (i = 0, ind = -1; i < ARGUSSPLITMODENUM; i++) {
                      if (!(strncasecmp (mode->mode, RaSplitModes[i], 3))) {
                         ind = i;
@@ -325,9 +415,12 @@ ArgusClientInit (struct ArgusParserStruct *parser)
          }
       }
 
-      if ((RaBinProcess->size  = nadp->size) == 0)
+      if (((RaBinProcess->size  = nadp->size) == 0) && (RaTodCubeFile == NULL))
          ArgusLog (LOG_ERR, "ArgusClientInit: no bin size specified");
 
+      if ((score > 0.0) && (RaTodCubeFile == NULL))
+         ArgusLog (LOG_ERR, "ArgusClientInit: score mode needs a baseline cube");
+
       if (!(nadp->value))
          nadp->value = 1;
 
@@ -449,9 +542,15 @@ ArgusClientInit (struct ArgusParserStruct *parser)
          if ((parser->ArgusAggregator = ArgusNewAggregator(parser, NULL, ARGUS_RECORD_AGGREGATOR)) == NULL)
             ArgusLog (LOG_ERR, "ArgusClientInit: ArgusNewAggregator error");
 
-      if (RaBinProcess->size == 0)
+      if ((RaBinProcess->size == 0) && (RaTodCubeFile == NULL))
          usage ();
 
+      if (RaTodCubeFile != NULL) {
+         RaTodCube = RaTodOpenCube(parser, RaTodCubeFile, parser->ArgusAggregator->mask);
+         if ((RaTodCube->zscore = score) > 0.0)
+            RaTodCube->score = 1;
+      }
+
       if (nocorrect != NULL) {
          if (parser->ArgusAggregator->correct != NULL) {
             free (parser->ArgusAggregator->correct);
@@ -490,6 +589,11 @@ RaParseComplete (int sig)
             break;
       }
       if (!(ArgusParser->RaParseCompleting++)) {
+         if (RaTodCube != NULL) {
+            RaTodCloseCube(ArgusParser, RaTodCube);
+            RaTodCube = NULL;
+         }
+
          if (RaBinProcess != NULL) {
             RaCloseBinProcess(ArgusParser, RaBinProcess);
             RaDeleteBinProcess(ArgusParser, RaBinProcess);
@@ -734,7 +838,10 @@ usage ()
    fprintf (stdout, "                              s[econds], m[inutes], h[ours], d[ays], w[eeks], m[onths], y[ears].\n");
    fprintf (stdout, "             nomodify         don't modify/split the input records when placing into bins\n");
    fprintf (stdout, "             hard             set start and ending timestamps to bin time boundary values\n");
-   fprintf (stdout, "             zero             generate zero records when there are gaps in the series\n\n");
+   fprintf (stdout, "             zero             generate zero records when there are gaps in the series\n");
+   fprintf (stdout, "             cube=<file>      update the time of week baseline cube in <file>\n");
+   fprintf (stdout, "             score[=<z>]      report keys whose 5 minute totals are <z> (3.0) deviations\n");
+   fprintf (stdout, "                              from their baseline\n\n");
 
    fprintf (stdout, "         -m <mode>            supported aggregation objects:\n");
    fprintf (stdout, "             none             no flow key\n");
@@ -754,7 +861,8 @@ void RaProcessThisRecord (struct ArgusParserStruct *, struct ArgusRecordStruct *
 void
 RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *ns)
 {
-   ArgusTimeAdjustRecord(&RaBinProcess->nadp, ns);
+   if (RaTodCube == NULL)
+      ArgusTimeAdjustRecord(&RaBinProcess->nadp, ns);
 
    switch (ns->hdr.type & 0xF0) {
       case ARGUS_MAR:
@@ -914,8 +1022,6 @@ ArgusTimeAdjustRecord(struct ArgusAdjustStruct *nadp, struct ArgusRecordStruct *
 		 time->dst.end.tv_sec   -= nsec; 
 	 }
 
-	 time->hdr.subtype &= ~ARGUS_TIME_TYPE_MASK;
-	 time->hdr.subtype |= ARGUS_TIME_RELATIVE;
 	 tns->status |= ARGUS_RECORD_MODIFIED;
       }
    }
@@ -929,6 +1035,11 @@ RaProcessThisRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct
    struct ArgusAggregatorStruct *agg = parser->ArgusAggregator;
    int found = 0, offset, tstrat;
 
+   if (RaTodCube != NULL) {
+      RaTodCubeUpdate(parser, RaTodCube, argus);
+      return;
+   }
+
    tstrat = ArgusTimeRangeStrategy;
    while (agg && !found) {
       int tretn = 0, fretn = -1, lretn = -1;
@@ -1362,3 +1473,386 @@ RaCloseBinProcess(struct ArgusParserStruct *parser, struct RaBinProcessStruct *r
 
    return (retn);
 }
+
+
+/*
+ *  Baseline cube support.  The cube is mapped shared, so updates go
+ *  straight to the file, and a record lock on the file keeps a second
+ *  ratod from updating it at the same time.
+ */
+
+static size_t
+RaTodCubeLength (unsigned int capacity)
+{
+   return (sizeof(struct RaTodCubeHdr) + (capacity * sizeof(struct RaTodKeyStruct)) +
+          ((capacity * 2) * sizeof(unsigned int)));
+}
+
+static void
+RaTodMapCube (struct RaTodCubeStruct *cube, unsigned int capacity)
+{
+   void *map;
+
+   cube->len = RaTodCubeLength(capacity);
+
+   if (ftruncate (cube->fd, cube->len) < 0)
+      ArgusLog (LOG_ERR, "RaTodMapCube: ftruncate %s error %s", cube->filename, strerror(errno));
+
+   if ((map = mmap (NULL, cube->len, PROT_READ | PROT_WRITE, MAP_SHARED, cube->fd, 0)) == MAP_FAILED)
+      ArgusLog (LOG_ERR, "RaTodMapCube: mmap %s error %s", cube->filename, strerror(errno));
+
+   cube->hdr   = (struct RaTodCubeHdr *) map;
+   cube->keys  = (struct RaTodKeyStruct *)(cube->hdr + 1);
+   cube->index = (unsigned int *)(cube->keys + capacity);
+}
+
+static void
+RaTodIndexKey (struct RaTodCubeStruct *cube, unsigned int key)
+{
+   unsigned int mask = (cube->hdr->capacity * 2) - 1;
+   unsigned int i = cube->keys[key].hash & mask;
+
+   while (cube->index[i] != 0)
+      i = (i + 1) & mask;
+
+   cube->index[i] = key + 1;
+}
+
+/*
+ *  Double the key table.  The keys stay where they are, the index
+ *  follows them, so it is rebuilt.  The old index is cleared first,
+ *  so that, like the rest of the file, the new key space reads as
+ *  zero and new keys don't need to touch all of their slot pages.
+ */
+
+static void
+RaTodGrowCube (struct RaTodCubeStruct *cube)
+{
+   unsigned int capacity = cube->hdr->capacity * 2, i;
+
+   bzero (cube->index, capacity * sizeof(unsigned int));
+   msync (cube->hdr, cube->len, MS_ASYNC);
+   munmap (cube->hdr, cube->len);
+
+   RaTodMapCube (cube, capacity);
+   cube->hdr->capacity = capacity;
+
+   bzero (cube->index, (capacity * 2) * sizeof(unsigned int));
+   for (i = 0; i < cube->hdr->count; i++)
+      RaTodIndexKey (cube, i);
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaTodGrowCube(%p) %s capacity %u\n", cube, cube->filename, capacity);
+#endif
+}
+
+struct RaTodCubeStruct *
+RaTodOpenCube (struct ArgusParserStruct *parser, char *filename, long long mask)
+{
+   struct RaTodCubeStruct *cube = NULL;
+   struct flock lock;
+   struct stat statbuf;
+
+   if ((cube = (struct RaTodCubeStruct *) ArgusCalloc (1, sizeof(*cube))) == NULL)
+      ArgusLog (LOG_ERR, "RaTodOpenCube: ArgusCalloc error %s", strerror(errno));
+
+   cube->filename = strdup(filename);
+
+   if ((cube->fd = open (filename, O_RDWR | O_CREAT, 0644)) < 0)
+      ArgusLog (LOG_ERR, "RaTodOpenCube: open %s error %s", filename, strerror(errno));
+
+   bzero (&lock, sizeof(lock));
+   lock.l_type = F_WRLCK;
+   lock.l_whence = SEEK_SET;
+
+   if (fcntl (cube->fd, F_SETLK, &lock) < 0)
+      ArgusLog (LOG_ERR, "RaTodOpenCube: %s is in use %s", filename, strerror(errno));
+
+   if (fstat (cube->fd, &statbuf) < 0)
+      ArgusLog (LOG_ERR, "RaTodOpenCube: stat %s error %s", filename, strerror(errno));
+
+   if (statbuf.st_size == 0) {
+      RaTodMapCube (cube, RATOD_MINKEYS);
+      cube->hdr->magic    = RATOD_CUBE_MAGIC;
+      cube->hdr->version  = RATOD_CUBE_VERSION;
+      cube->hdr->keysize  = sizeof(struct RaTodKeyStruct);
+      cube->hdr->nslots   = RATOD_SLOTS;
+      cube->hdr->capacity = RATOD_MINKEYS;
+      cube->hdr->mask     = mask;
+
+   } else {
+      struct RaTodCubeHdr hdr;
+
+      if ((statbuf.st_size < sizeof(hdr)) || (read (cube->fd, &hdr, sizeof(hdr)) != sizeof(hdr)))
+         ArgusLog (LOG_ERR, "RaTodOpenCube: %s is not a baseline cube", filename);
+
+      if ((hdr.magic != RATOD_CUBE_MAGIC) || (hdr.version != RATOD_CUBE_VERSION) ||
+          (hdr.keysize != sizeof(struct RaTodKeyStruct)) || (hdr.nslots != RATOD_SLOTS) ||
+          (statbuf.st_size != RaTodCubeLength(hdr.capacity)))
+         ArgusLog (LOG_ERR, "RaTodOpenCube: %s is not a baseline cube", filename);
+
+      if (hdr.mask != mask)
+         ArgusLog (LOG_ERR, "RaTodOpenCube: %s was built with a different flow key", filename);
+
+      RaTodMapCube (cube, hdr.capacity);
+   }
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaTodOpenCube(%p, %s) keys %u capacity %u\n", parser, filename, cube->hdr->count, cube->hdr->capacity);
+#endif
+   return (cube);
+}
+
+void
+RaTodCloseCube (struct ArgusParserStruct *parser, struct RaTodCubeStruct *cube)
+{
+   if (cube->late)
+      ArgusLog (LOG_WARNING, "%s: %lld records older than the cube's closed interval were skipped", cube->filename, cube->late);
+
+   if (cube->hdr != NULL) {
+      msync (cube->hdr, cube->len, MS_SYNC);
+      munmap (cube->hdr, cube->len);
+   }
+   close (cube->fd);
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (2, "RaTodCloseCube(%p, %s)\n", parser, cube->filename);
+#endif
+   free (cube->filename);
+   ArgusFree (cube);
+}
+
+
+/*
+ *  The key label is the aggregation fields of the first record seen
+ *  for the key, printed the way ra prints them.
+ */
+
+static void
+RaTodKeyLabel (struct ArgusParserStruct *parser, struct ArgusAggregatorStruct *agg,
+               struct ArgusRecordStruct *ns, char *label, int len)
+{
+   struct ArgusMaskStruct *defs = ArgusSelectMaskDefs(ns);
+   struct ArgusPrintFieldStruct *alg = parser->RaPrintAlgorithm;
+   struct ArgusPrintFieldStruct *entry = parser->RaPrintAlgorithmList[parser->RaPrintIndex];
+   char tmpbuf[MAXSTRLEN];
+   int i, x, slen = 0;
+
+   *label = '\0';
+
+// the printers take their format from the current print list entry,
+// so it points at the table entry for each field while it is printed.
+
+   for (i = 0; (defs != NULL) && (i < ARGUS_MAX_MASK_LIST); i++) {
+      if ((agg->mask & (0x01LL << i)) && (defs[i].name != NULL)) {
+         for (x = 0; x < MAX_PRINT_ALG_TYPES; x++) {
+            if (RaPrintAlgorithmTable[x].field == NULL)
+               break;
+
+            if (!strcmp (RaPrintAlgorithmTable[x].field, defs[i].name)) {
+               char *ptr = tmpbuf;
+               int tlen;
+
+               bzero (tmpbuf, sizeof(tmpbuf));
+               parser->RaPrintAlgorithm = &RaPrintAlgorithmTable[x];
+               parser->RaPrintAlgorithmList[parser->RaPrintIndex] = &RaPrintAlgorithmTable[x];
+               RaPrintAlgorithmTable[x].print(parser, tmpbuf, ns, RaPrintAlgorithmTable[x].length);
+               parser->RaPrintAlgorithmList[parser->RaPrintIndex] = entry;
+               parser->RaPrintAlgorithm = alg;
+
+               while (isspace((int)*ptr)) ptr++;
+               tlen = strlen(ptr);
+               while ((tlen > 0) && isspace((int)ptr[tlen - 1]))
+                  ptr[--tlen] = '\0';
+
+               if (tlen > 0)
+                  slen += snprintf (&label[slen], len - slen, "%s%s", slen ? " " : "", ptr);
+               if (slen >= len)
+                  return;
+               break;
+            }
+         }
+      }
+   }
+}
+
+static struct RaTodKeyStruct *
+RaTodFindKey (struct ArgusParserStruct *parser, struct RaTodCubeStruct *cube,
+              struct ArgusAggregatorStruct *agg, struct ArgusRecordStruct *ns)
+{
+   struct ArgusHashStruct *hstruct;
+   struct RaTodKeyStruct *key;
+   unsigned int i, mask, len;
+
+   if ((hstruct = ArgusGenerateHashStruct(agg, ns, NULL)) == NULL)
+      return (NULL);
+
+   len = (hstruct->len > RATOD_KEYLEN) ? RATOD_KEYLEN : hstruct->len;
+   mask = (cube->hdr->capacity * 2) - 1;
+
+   for (i = hstruct->hash & mask; cube->index[i] != 0; i = (i + 1) & mask) {
+      key = &cube->keys[cube->index[i] - 1];
+      if ((key->hash == hstruct->hash) && (key->len == len) && !bcmp(key->key, hstruct->buf, len))
+         return (key);
+   }
+
+   if (cube->hdr->count == cube->hdr->capacity) {
+      RaTodGrowCube (cube);
+      return (RaTodFindKey (parser, cube, agg, ns));
+   }
+
+   key = &cube->keys[cube->hdr->count];
+   key->hash = hstruct->hash;
+   key->len  = len;
+   bcopy (hstruct->buf, key->key, len);
+   RaTodKeyLabel (parser, agg, ns, key->label, sizeof(key->label));
+
+   RaTodIndexKey (cube, cube->hdr->count++);
+   return (key);
+}
+
+static int
+RaTodSlot (unsigned int interval)
+{
+   time_t tsec = (time_t) interval * RATOD_SLOTSECS;
+   struct tm tmbuf, *tm;
+
+   if ((tm = localtime_r(&tsec, &tmbuf)) == NULL)
+      return (-1);
+
+   return ((((tm->tm_wday * 24) + tm->tm_hour) * 60 + tm->tm_min) / (RATOD_SLOTSECS / 60));
+}
+
+/*
+ *  Score the keys for a closed interval against the weeks before it.
+ *  A key that is missing from the interval scores its observed values
+ *  as 0, so expected traffic that doesn't show up is reported too.
+ */
+
+static void
+RaTodScoreInterval (struct ArgusParserStruct *parser, struct RaTodCubeStruct *cube, unsigned int interval)
+{
+   int s = RaTodSlot(interval), weeks;
+   char tbuf[128];
+   struct timeval tvp;
+   unsigned int i;
+
+   if ((s < 0) || (cube->hdr->slots[s].interval != interval))
+      return;
+
+   if ((weeks = cube->hdr->slots[s].weeks - 1) < RATOD_MINWEEKS)
+      return;
+
+   tvp.tv_sec  = (time_t) interval * RATOD_SLOTSECS;
+   tvp.tv_usec = 0;
+   bzero (tbuf, sizeof(tbuf));
+   ArgusPrintTime(parser, tbuf, sizeof(tbuf) - 1, &tvp);
+   for (i = strlen(tbuf); (i > 0) && isspace((int)tbuf[i - 1]); i--)
+      tbuf[i - 1] = '\0';
+
+   for (i = 0; i < cube->hdr->count; i++) {
+      struct RaTodKeyStruct *key = &cube->keys[i];
+      struct RaTodSlotStruct *slot = &key->slots[s];
+      int m, open = (slot->interval == interval);
+
+      if (slot->interval == 0)
+         continue;
+
+      for (m = 0; m < RATOD_METRICS; m++) {
+         double sum = slot->sum[m], sumsq = slot->sumsq[m];
+         double obs = open ? slot->cur[m] : 0.0;
+         double mean, sdev, z;
+
+         if (!open) {
+            sum   += slot->cur[m];
+            sumsq += slot->cur[m] * slot->cur[m];
+         }
+
+         mean = sum / weeks;
+         sdev = (sumsq / weeks) - (mean * mean);
+         sdev = (sdev > 1.0) ? sqrt(sdev) : 1.0;
+         z = (obs - mean) / sdev;
+
+         if (fabs(z) >= cube->zscore)
+            fprintf (stdout, "%s %s %s %.0f mean %.2f sdev %.2f z %.2f\n",
+               tbuf, key->label, RaTodMetricNames[m], obs, mean, sdev, z);
+      }
+   }
+   fflush (stdout);
+}
+
+/*
+ *  Add the record to its key and slot.  Intervals are closed, and
+ *  scored, once a record two intervals later is seen, which leaves
+ *  one interval for late records.
+ */
+
+void
+RaTodCubeUpdate (struct ArgusParserStruct *parser, struct RaTodCubeStruct *cube, struct ArgusRecordStruct *ns)
+{
+   struct ArgusAggregatorStruct *agg = parser->ArgusAggregator;
+   struct ArgusMetricStruct *metric = (void *)ns->dsrs[ARGUS_METRIC_INDEX];
+   struct RaTodCubeHdr *hdr = cube->hdr;
+   struct RaTodKeyStruct *key;
+   struct RaTodSlotStruct *slot;
+   unsigned int interval;
+   int s, m;
+
+   if ((interval = ArgusFetchStartTime(ns) / RATOD_SLOTSECS) == 0)
+      return;
+
+   if (interval <= hdr->closed) {
+      cube->late++;
+      return;
+   }
+
+   if (interval > hdr->interval) {
+      unsigned int closed = interval - 2;
+
+      if (hdr->closed && ((closed - hdr->closed) > RATOD_SLOTS))
+         hdr->closed = closed - RATOD_SLOTS;
+
+      if (hdr->interval && cube->score) {
+         unsigned int i;
+         for (i = hdr->closed + 1; i <= closed; i++)
+            RaTodScoreInterval (parser, cube, i);
+      }
+
+      if (hdr->closed < closed)
+         hdr->closed = closed;
+      hdr->interval = interval;
+   }
+
+   while (agg && agg->filterstr && !ArgusFilterRecord (agg->filter.bf_insns, ns))
+      agg = agg->nxt;
+
+   if ((agg == NULL) || ((s = RaTodSlot(interval)) < 0))
+      return;
+
+   if ((key = RaTodFindKey (parser, cube, agg, ns)) == NULL)
+      return;
+
+   hdr = cube->hdr;     /* the cube may have been remapped */
+   if (interval > hdr->slots[s].interval) {
+      hdr->slots[s].interval = interval;
+      hdr->slots[s].weeks++;
+   }
+
+   slot = &key->slots[s];
+   if (slot->interval != interval) {
+      if (slot->interval) {
+         for (m = 0; m < RATOD_METRICS; m++) {
+            slot->sum[m]   += slot->cur[m];
+            slot->sumsq[m] += slot->cur[m] * slot->cur[m];
+            slot->cur[m]    = 0.0;
+         }
+      }
+      slot->interval = interval;
+   }
+
+   slot->cur[0] += 1.0;
+   if (metric != NULL) {
+      slot->cur[1] += metric->src.pkts  + metric->dst.pkts;
+      slot->cur[2] += metric->src.bytes + metric->dst.bytes;
+   }
+}
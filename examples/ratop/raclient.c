@@ -2754,7 +2754,7 @@ ArgusProcessQueue (struct ArgusQueueStruct *queue)
          }
 
          if (deleted)
-            RaClientSortQueue(ArgusSorter, queue, ARGUS_NOLOCK);
+            RaClientSortQueueDepth(ArgusSorter, queue, RaSortDepth, ARGUS_NOLOCK);
 
          queue->status = status;
 
@@ -3041,6 +3041,41 @@ RaCursesDeleteProcess (struct ArgusParserStruct *parser, struct RaCursesProcessS
  
 int
 RaClientSortQueue (struct ArgusSorterStruct *sorter, struct ArgusQueueStruct *queue, int type)
+{
+   return (RaClientSortQueueDepth (sorter, queue, 0, type));
+}
+
+/*
+   RaClientSortQueueDepth - build the display array for the queue, but only
+   put the first 'depth' entries into sorted order.  The screen only shows
+   a page or two of the top of the list, so rather than qsort() the whole
+   queue on every refresh, we select the top 'depth' records with a bounded
+   heap, O(n log depth), and sort just those.  The remaining records follow
+   in queue order.  A depth of 0 sorts everything, and RaSortDepth records
+   what the array currently holds, so callers that walk the whole array can
+   ask for a full sort when needed.
+*/
+
+static void
+RaClientSiftDown (struct ArgusQueueHeader **heap, int n, int i)
+{
+   struct ArgusQueueHeader *tmp;
+
+   for (;;) {
+      int l = (i * 2) + 1, r = l + 1, m = i;
+
+      if ((l < n) && (ArgusSortRoutine (&heap[l], &heap[m]) > 0)) m = l;
+      if ((r < n) && (ArgusSortRoutine (&heap[r], &heap[m]) > 0)) m = r;
+      if (m == i)
+         break;
+
+      tmp = heap[i]; heap[i] = heap[m]; heap[m] = tmp;
+      i = m;
+   }
+}
+
+int
+RaClientSortQueueDepth (struct ArgusSorterStruct *sorter, struct ArgusQueueStruct *queue, int depth, int type)
 {
    struct nff_insn *fcode = NULL;
    int cnt, x = 0;
@@ -3052,6 +3087,7 @@ RaClientSortQueue (struct ArgusSorterStruct *sorter, struct ArgusQueueStruct *qu
 #endif
 
    cnt = queue->count;
+   RaSortDepth = 0;
 
    if (queue->array != NULL) {
       ArgusFree(queue->array);
@@ -3080,7 +3116,25 @@ RaClientSortQueue (struct ArgusSorterStruct *sorter, struct ArgusQueueStruct *qu
 
          if (x > 0) {
             queue->array[x] = NULL;
-            qsort ((char *) queue->array, x, sizeof (struct ArgusQueueHeader *), ArgusSortRoutine);
+
+            if ((depth > 0) && (depth < x)) {
+               struct ArgusQueueHeader **heap = queue->array, *tmp;
+
+               for (i = (depth / 2) - 1; i >= 0; i--)
+                  RaClientSiftDown (heap, depth, i);
+
+               for (i = depth; i < x; i++) {
+                  if (ArgusSortRoutine (&heap[i], &heap[0]) < 0) {
+                     tmp = heap[0]; heap[0] = heap[i]; heap[i] = tmp;
+                     RaClientSiftDown (heap, depth, 0);
+                  }
+               }
+               qsort ((char *) queue->array, depth, sizeof (struct ArgusQueueHeader *), ArgusSortRoutine);
+               RaSortDepth = depth;
+
+            } else {
+               qsort ((char *) queue->array, x, sizeof (struct ArgusQueueHeader *), ArgusSortRoutine);
+            }
 
             for (i = 0; i < x; i++) {
                struct ArgusRecordStruct *ns = (struct ArgusRecordStruct *) queue->array[i];
@@ -3092,7 +3146,7 @@ RaClientSortQueue (struct ArgusSorterStruct *sorter, struct ArgusQueueStruct *qu
          }
 
       } else 
-         ArgusLog (LOG_ERR, "RaClientSortQueue: ArgusMalloc(%d) %s\n", sizeof(struct ArgusRecord *), cnt, strerror(errno));
+         ArgusLog (LOG_ERR, "RaClientSortQueueDepth: ArgusMalloc(%d) %s\n", sizeof(struct ArgusRecord *), cnt, strerror(errno));
    }
 
    bzero (&ArgusParser->ArgusStartTimeVal, sizeof(ArgusParser->ArgusStartTimeVal));
@@ -3105,7 +3159,7 @@ RaClientSortQueue (struct ArgusSorterStruct *sorter, struct ArgusQueueStruct *qu
    ArgusParser->RaTasksToDo &= ~RA_SORTING;
 
 #ifdef ARGUSDEBUG 
-   ArgusDebug (5, "RaClientSortQueue(0x%x, 0x%x, %d) returns %d\n", sorter, queue, type, x);
+   ArgusDebug (5, "RaClientSortQueueDepth(%p, %p, %d, %d) returns %d\n", sorter, queue, depth, type, x);
 #endif
 
    return(x);
@@ -1400,6 +1400,9 @@ ArgusProcessTerminator(WINDOW *win, int status, int ch)
                   setArgusWfile (ArgusParser, RaCommandInputStr, NULL);
                   wfile = (struct ArgusWfileStruct *) ArgusParser->ArgusWfileList->start;
 
+                  if (RaSortDepth)
+                     RaSortItems = RaClientSortQueue(ArgusSorter, RaCursesProcess->queue, ARGUS_LOCK);
+
                   for (i = 0; i < RaCursesProcess->queue->count; i++) {
                      int pass = 1;
 
@@ -1517,7 +1520,11 @@ ArgusProcessTerminator(WINDOW *win, int status, int ch)
             int cursx = RaWindowCursorX, cursy = RaWindowCursorY + RaWindowStartLine;
             char sbuf[2048];
 
-            if ((linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, RaCommandInputStr, ARGUS_LOCK)) < 0) {
+#if defined(ARGUS_THREADS)
+            pthread_mutex_lock(&RaCursesProcess->queue->lock);
+#endif
+            RaSearchSortQueue (RaCursesProcess->queue);
+            if ((linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, RaCommandInputStr, ARGUS_NOLOCK)) < 0) {
                if (ArgusSearchDirection == ARGUS_FORWARD) {
                   sprintf (sbuf, "search hit BOTTOM, continuing at TOP");
                   ArgusSetDebugString (sbuf, LOG_ERR, ARGUS_LOCK);
@@ -1527,8 +1534,11 @@ ArgusProcessTerminator(WINDOW *win, int status, int ch)
                   ArgusSetDebugString (sbuf, LOG_ERR, ARGUS_LOCK);
                   cursx = RaScreenColumns; cursy = RaCursesProcess->queue->count;
                }
-               linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, RaCommandInputStr, ARGUS_LOCK);
+               linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, RaCommandInputStr, ARGUS_NOLOCK);
             }
+#if defined(ARGUS_THREADS)
+            pthread_mutex_unlock(&RaCursesProcess->queue->lock);
+#endif
 
             if (linenum >= 0) {
                int startline = ((cursy - 1)/ RaDisplayLines) * RaDisplayLines;
@@ -2136,8 +2146,10 @@ ArgusProcessCharacter(WINDOW *win, int status, int ch)
                      int linenum;
 #if defined(ARGUS_THREADS)
                      pthread_mutex_lock(&RaCursesLock);
+                     pthread_mutex_lock(&queue->lock);
 #endif
-                     if ((linenum = RaSearchDisplay(ArgusParser, queue, ArgusSearchDirection, &cursx, &cursy, ArgusSearchString, ARGUS_LOCK)) < 0) {
+                     RaSearchSortQueue (queue);
+                     if ((linenum = RaSearchDisplay(ArgusParser, queue, ArgusSearchDirection, &cursx, &cursy, ArgusSearchString, ARGUS_NOLOCK)) < 0) {
                         if (ArgusSearchDirection == ARGUS_FORWARD) {
                            sprintf (sbuf, "search hit BOTTOM, continuing at TOP");
                            ArgusSetDebugString (sbuf, LOG_ERR, ARGUS_LOCK);
@@ -2147,8 +2159,11 @@ ArgusProcessCharacter(WINDOW *win, int status, int ch)
                            ArgusSetDebugString (sbuf, LOG_ERR, ARGUS_LOCK);
                            cursx = RaScreenColumns; cursy = queue->count;
                         }
-                        linenum = RaSearchDisplay(ArgusParser, queue, ArgusSearchDirection, &cursx, &cursy, ArgusSearchString, ARGUS_LOCK);
+                        linenum = RaSearchDisplay(ArgusParser, queue, ArgusSearchDirection, &cursx, &cursy, ArgusSearchString, ARGUS_NOLOCK);
                      }
+#if defined(ARGUS_THREADS)
+                     pthread_mutex_unlock(&queue->lock);
+#endif
                      if (linenum >= 0) {
                         if ((linenum < RaWindowStartLine) || ((linenum > RaWindowStartLine + RaDisplayLines))) {
                            int startline = ((cursy - 1)/ RaDisplayLines) * RaDisplayLines;
@@ -3000,16 +3015,27 @@ ArgusDrawWindow(struct ArgusWindowStruct *ws)
 #endif
          if (RaWindowStatus) {
             if ((parser->status & ARGUS_FILE_LIST_PROCESSED) || (parser->ProcessRealTime > 0)) {
+               int depth = 0;
+
+/*
+   Only the rows on the screen, and a page beyond for scrolling, need
+   to be in sorted order, so ask for just that many, unless a search is
+   active, which walks the whole array.  If the user scrolls past what
+   was sorted, sort deeper even when the queue hasn't changed.
+*/
+               if (parser->ArgusSearchString == NULL)
+                  depth = RaWindowStartLine + (((RaDisplayLines > 0) ? RaDisplayLines : RaWindowLines) * 2);
+
 #if defined(ARGUS_THREADS)
                pthread_mutex_lock(&queue->lock);
 #endif
-               if (queue->status & RA_MODIFIED) {
+               if ((queue->status & RA_MODIFIED) || (RaSortDepth && ((depth == 0) || (depth > RaSortDepth)))) {
 #ifdef ARGUSDEBUG
                   ArgusDebug (5, "ArgusDrawWindow(%p) processing queue\n", ws);
 #endif
                   ArgusParser->RaTasksToDo |= RA_SORTING;
                   RaUpdateDebugWindow(RaDebugWindow);
-                  RaSortItems = RaClientSortQueue(ArgusSorter, queue, ARGUS_NOLOCK);
+                  RaSortItems = RaClientSortQueueDepth(ArgusSorter, queue, depth, ARGUS_NOLOCK);
                   ArgusParser->RaTasksToDo &= ~RA_SORTING;
 
                   if (queue->count) {
@@ -3164,6 +3190,7 @@ ArgusDrawWindow(struct ArgusWindowStruct *ws)
                      char sbuf[2048];
 
                      cursx = RaWindowCursorX, cursy = RaWindowCursorY + RaWindowStartLine;
+                     RaSearchSortQueue (RaCursesProcess->queue);
                      if ((linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, parser->ArgusSearchString, ARGUS_NOLOCK)) < 0) {
 
                         if (ArgusSearchDirection == ARGUS_FORWARD) {
@@ -3747,7 +3774,11 @@ argus_getsearch_string(int dir)
 
       ArgusParser->ArgusSearchString = strdup(RaCommandInputStr);
 
-      if ((linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, ArgusParser->ArgusSearchString, ARGUS_LOCK)) < 0) {
+#if defined(ARGUS_THREADS)
+      pthread_mutex_lock(&RaCursesProcess->queue->lock);
+#endif
+      RaSearchSortQueue (RaCursesProcess->queue);
+      if ((linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, ArgusParser->ArgusSearchString, ARGUS_NOLOCK)) < 0) {
          if (ArgusSearchDirection == ARGUS_FORWARD) {
             ArgusSetDebugString ("search hit BOTTOM, continuing at TOP", LOG_ERR, ARGUS_LOCK);
             cursx = 0; cursy = 0;
@@ -3755,8 +3786,11 @@ argus_getsearch_string(int dir)
             ArgusSetDebugString ("search hit TOP, continuing at BOTTOM", LOG_ERR, ARGUS_LOCK);
             cursx = RaScreenColumns; cursy = RaSortItems;
          }
-         linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, ArgusParser->ArgusSearchString, ARGUS_LOCK);
+         linenum = RaSearchDisplay(ArgusParser, RaCursesProcess->queue, ArgusSearchDirection, &cursx, &cursy, ArgusParser->ArgusSearchString, ARGUS_NOLOCK);
       }
+#if defined(ARGUS_THREADS)
+      pthread_mutex_unlock(&RaCursesProcess->queue->lock);
+#endif
 
       if (linenum >= 0) {
          if ((linenum < RaWindowStartLine) || ((linenum > RaWindowStartLine + RaDisplayLines))) {
@@ -4849,6 +4883,9 @@ argus_command_string(void)
 #if defined(ARGUS_THREADS)
                   pthread_mutex_lock(&RaCursesProcess->queue->lock);
 #endif
+                  if (RaSortDepth)
+                     RaSortItems = RaClientSortQueue(ArgusSorter, RaCursesProcess->queue, ARGUS_NOLOCK);
+
                   for (i = 0; i < RaSortItems; i++) {
                      int pass = 1;
 
@@ -5721,6 +5758,19 @@ RaHighlightDisplay (struct ArgusParserStruct *parser, struct ArgusQueueStruct *q
    return (retn);
 }
 
+/*
+   RaSearchDisplay() walks the whole queue array, which ArgusDrawWindow()
+   may have sorted only as deep as the display, so finish the sort first.
+   Called with the queue locked.
+*/
+
+void
+RaSearchSortQueue (struct ArgusQueueStruct *queue)
+{
+   if (RaSortDepth)
+      RaSortItems = RaClientSortQueue(ArgusSorter, queue, ARGUS_NOLOCK);
+}
+
 int
 RaSearchDisplay (struct ArgusParserStruct *parser, struct ArgusQueueStruct *queue, 
                                  int dir, int *cursx, int *cursy, char *pattern, int type)
@@ -252,6 +252,7 @@ int (*RaColorAlgorithms[ARGUS_MAX_COLOR_ALG]) (struct ArgusParserStruct *, struc
 char RaOutputBuffer[MAXBUFFERLEN];
 struct RaCursesProcessStruct *RaCursesNewProcess(struct ArgusParserStruct *parser);
 int RaClientSortQueue (struct ArgusSorterStruct *, struct ArgusQueueStruct *, int);
+int RaClientSortQueueDepth (struct ArgusSorterStruct *, struct ArgusQueueStruct *, int, int);
 void ArgusUpdateScreen(void);
 void ArgusTouchScreen(void);
 
@@ -279,6 +280,7 @@ struct ArgusAggregatorStruct *ArgusEventAggregator = NULL;
 
 int ArgusWindowClosing = 0;
 int RaSortItems = 0;
+int RaSortDepth = 0;
 
 float RaUpdateRate = 1.0;
 int RaCursesRealTime = 0;
@@ -330,6 +332,7 @@ extern void ArgusInitAggregatorStructs(struct ArgusAggregatorStruct *);
 void RaCursesLoop (struct ArgusParserStruct *);
 void RaOutputModifyScreen (void);
 void RaOutputHelpScreen (void);
+void RaSearchSortQueue (struct ArgusQueueStruct *);
 int RaSearchDisplay (struct ArgusParserStruct *, struct ArgusQueueStruct *, int, int *, int *, char *, int);
 
 
@@ -489,6 +492,7 @@ int RaScreenStartY    = 0;
 extern char RaOutputBuffer[MAXBUFFERLEN];
 extern struct RaCursesProcessStruct *RaCursesNewProcess(struct ArgusParserStruct *parser);
 extern int RaClientSortQueue (struct ArgusSorterStruct *, struct ArgusQueueStruct *, int);
+extern int RaClientSortQueueDepth (struct ArgusSorterStruct *, struct ArgusQueueStruct *, int, int);
 extern void ArgusSetDebugString (char *, int, int);
 extern void ArgusUpdateScreen(void);
 extern void ArgusResetSearch (void);
@@ -513,6 +517,7 @@ extern int RaWindowModified;
 extern int RaWindowImmediate;
 extern int ArgusWindowClosing;
 extern int RaSortItems;
+extern int RaSortDepth;
 
 extern float RaUpdateRate;
 extern int RaCursesRealTime;
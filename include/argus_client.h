@@ -217,6 +217,7 @@ struct ArgusInput {
    int ArgusReadSocketNum, ArgusReadSize;
    ArgusNetFlowHandler ArgusCiscoNetFlowParse;
    ArgusSFlowHandler ArgusSFlowParse;
+   struct ArgusDatagramBatch *ArgusDgramBatch;
 
 #ifdef ARGUS_SASL
    sasl_conn_t *sasl_conn;
@@ -274,9 +275,25 @@ struct RaSrvSignature {
    unsigned char src[RASIGLENGTH], dst[RASIGLENGTH];
 };
 
+/* signature bytes held as machine words, so a node compare is a
+ * handful of masked word operations rather than RASIGLENGTH byte tests */
+
+#define RASIGWORDS              (RASIGLENGTH / sizeof(unsigned long long))
+
+union RaSrvSigWords {
+   unsigned long long w[RASIGWORDS];
+   unsigned char b[RASIGLENGTH];
+};
+
+struct RaSrvMatch {
+   int mode, valid;
+   union RaSrvSigWords raw, value, fold, care;
+};
+
 struct RaSrvTreeNode {
    struct RaSrvTreeNode *l, *r;
    struct RaSrvSignature *srv;
+   struct RaSrvMatch *match;
 };
 
 
@@ -1181,6 +1198,7 @@ int ArgusProcessFileIndependantly = 0;
 struct ArgusAggregatorStruct *ArgusParseAggregator (struct ArgusParserStruct *, char *, char **);
 
 struct ArgusRecordStruct *ArgusGenerateRecordStruct (struct ArgusParserStruct *, struct ArgusInput *, struct ArgusRecord *);
+struct ArgusRecordStruct *ArgusGenerateRecordStructDSRs (struct ArgusParserStruct *, struct ArgusInput *, struct ArgusRecord *, unsigned int);
 struct ArgusRecord *ArgusGenerateRecord (struct ArgusRecordStruct *, unsigned char, char *, int);
 int ArgusGenerateCiscoRecord (struct ArgusRecordStruct *, unsigned char, char *);
 
@@ -1261,6 +1279,8 @@ int ArgusReadSflowDatagramSocket (struct ArgusParserStruct *, struct ArgusInput
 
 int ArgusReadCiscoStreamSocket (struct ArgusParserStruct *, struct ArgusInput *);
 int ArgusReadCiscoDatagramSocket (struct ArgusParserStruct *, struct ArgusInput *);
+void ArgusDeleteDatagramBatch (struct ArgusInput *);
+int ArgusReadDatagramBatch (struct ArgusParserStruct *, struct ArgusInput *, int (*)(struct ArgusParserStruct *, struct ArgusInput *, int));
 
 void ArgusShiftArray (struct ArgusParserStruct *, struct RaBinProcessStruct *, int, int);
 
@@ -1354,6 +1374,7 @@ extern int ArgusProcessFileIndependantly;
 
 extern struct ArgusAggregatorStruct *ArgusParseAggregator (struct ArgusParserStruct *, char *, char **);
 extern struct ArgusRecordStruct *ArgusGenerateRecordStruct (struct ArgusParserStruct *, struct ArgusInput *, struct ArgusRecord *);
+extern struct ArgusRecordStruct *ArgusGenerateRecordStructDSRs (struct ArgusParserStruct *, struct ArgusInput *, struct ArgusRecord *, unsigned int);
 extern struct ArgusRecord *ArgusGenerateRecord (struct ArgusRecordStruct *, unsigned char, char *, int);
 extern int ArgusGenerateCiscoRecord (struct ArgusRecordStruct *, unsigned char, char *);
 
@@ -1426,6 +1447,8 @@ extern void ArgusAdjustDstLoss (struct ArgusRecordStruct *, struct ArgusRecordSt
 
 extern int ArgusReadCiscoStreamSocket (struct ArgusParserStruct *, struct ArgusInput *);
 extern int ArgusReadCiscoDatagramSocket (struct ArgusParserStruct *, struct ArgusInput *);
+extern void ArgusDeleteDatagramBatch (struct ArgusInput *);
+extern int ArgusReadDatagramBatch (struct ArgusParserStruct *, struct ArgusInput *, int (*)(struct ArgusParserStruct *, struct ArgusInput *, int));
 
 extern int ArgusReadSflowStreamSocket (struct ArgusParserStruct *, struct ArgusInput *);
 extern int ArgusReadSflowDatagramSocket (struct ArgusParserStruct *, struct ArgusInput *);
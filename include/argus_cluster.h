@@ -99,6 +99,7 @@ struct ArgusAggregatorStruct {
    struct ArgusHashTable *htable;
    struct ArgusHashStruct hstruct;
    struct ArgusSystemFlow fstruct;
+   struct ArgusKeyCache *kcache;
 
    char *filterstr;
    struct nff_program filter;
@@ -107,6 +108,7 @@ struct ArgusAggregatorStruct {
    char *grepstr;
    char *labelstr;
    regex_t lpreg;
+   struct ArgusGrepMatcherStruct *grepmatcher;
 
    char *estr;
    regex_t upreg;
@@ -1209,6 +1211,9 @@ struct RaPolicyStruct *RaFlowModelOverRides(struct ArgusAggregatorStruct *, stru
 void ArgusGenerateNewFlow(struct ArgusAggregatorStruct *, struct ArgusRecordStruct *);
 
 void RaMatrixNormalizeEtherAddrs (struct ArgusRecordStruct *ns);
+
+/* use the layout specific merge kernels, 0 runs every DSR merge routine */
+int ArgusMergeFastPath = 1;
  
 unsigned int ArgusMergeAddress(unsigned int *, unsigned int *, int, int, unsigned char *);
 void ArgusMergeRecords (const struct ArgusAggregatorStruct * const,
@@ -1234,6 +1239,8 @@ extern struct RaPolicyStruct *RaFlowModelOverRides(struct ArgusAggregatorStruct
 extern void ArgusGenerateNewFlow(struct ArgusAggregatorStruct *, struct ArgusRecordStruct *);
 
 extern void RaMatrixNormalizeEtherAddrs (struct ArgusRecordStruct *ns);
+
+extern int ArgusMergeFastPath;
  
 extern unsigned int ArgusMergeAddress(unsigned int *, unsigned int *, int, int, unsigned char *);
 extern void ArgusMergeRecords (const struct ArgusAggregatorStruct * const,
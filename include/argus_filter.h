@@ -94,6 +94,9 @@ extern "C" {
  */
 #define PROTO_UNDEF             -1
 
+#define ARGUS_FILTER_HDR        0x80000000
+#define ARGUS_FILTER_ALL_DSRS   0xFFFFFFFF
+
 
 
 #ifdef ArgusFilter
@@ -108,6 +111,7 @@ char *read_infile(char *);
 static inline int xdtoi(int c);
 int ArgusFilterRecord (struct nff_insn *pc,  struct ArgusRecordStruct *);
 int ArgusFilterOrig (struct nff_insn *, struct ArgusRecordStruct *, int, int);
+unsigned int ArgusFilterDSRs (struct nff_program *);
 
 static inline int skip_space(FILE *);
 static inline int skip_line(FILE *);
@@ -199,6 +203,7 @@ extern char *read_infile(char *);
 
 extern int ArgusFilterRecord (struct nff_insn *pc,  struct ArgusRecordStruct *);
 extern int ArgusFilterOrig (struct nff_insn *, u_char *, int, int);
+extern unsigned int ArgusFilterDSRs (struct nff_program *);
 
 extern struct argus_etherent *argus_next_etherent(FILE *fp);
 extern char *ArgusLookupDev(char *);
@@ -37,9 +37,45 @@
 extern "C" {
 #endif
 
+/*
+ * Multi-pattern matcher.  The literal strings that any match of a
+ * regular expression has to contain are pulled from each pattern, and
+ * kept in one Aho-Corasick automaton, so a buffer is scanned once for
+ * all the patterns, and regexec() only runs for the patterns whose
+ * literals were found.  Patterns without a usable literal are always
+ * run.
+ */
+
+struct ArgusGrepNodeStruct {
+   int child, sibling, fail, output, hits;
+   unsigned char ch;
+};
+
+struct ArgusGrepHitStruct {
+   int pattern, nxt;
+};
+
+struct ArgusGrepMatcherStruct {
+   int icase, compiled;
+   int patterns, psize;
+   int nodes, nsize, hits, hsize;
+   int root[256];
+   struct ArgusGrepNodeStruct *node;
+   struct ArgusGrepHitStruct *hit;
+   unsigned char *always;
+   unsigned int *stamp, generation;
+};
+
 extern void ArgusInitializeGrep (struct ArgusParserStruct *parser);
 extern int ArgusGrepUserData (struct ArgusParserStruct *, struct ArgusRecordStruct *);
 
+extern struct ArgusGrepMatcherStruct *ArgusNewGrepMatcher (int);
+extern void ArgusDeleteGrepMatcher (struct ArgusGrepMatcherStruct *);
+extern int ArgusGrepMatcherAdd (struct ArgusGrepMatcherStruct *, char *);
+extern int ArgusGrepMatch (struct ArgusGrepMatcherStruct *, regex_t *, char *, char *);
+extern int ArgusGrepLabel (struct ArgusGrepMatcherStruct *, regex_t *, char *);
+extern int ArgusGrepBuf (regex_t *, char *, char *);
+
 #ifdef __cplusplus
 }
 #endif
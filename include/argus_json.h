@@ -78,6 +78,15 @@ void vector_foreach_data(const vector*, vector_foreach_data_t, void*);
 ArgusJsonValue *ArgusJsonMergeValues(ArgusJsonValue *, ArgusJsonValue *);
 
 ArgusJsonValue *ArgusJsonParse(const char* input, ArgusJsonValue *);
+
+// Scan one object without building a value tree.  The handler is called
+// for each member with its key, the value type, and the value text as it
+// appears in the input; strings without their quotes, arrays and objects
+// including their brackets.  The text isn't terminated or unescaped.
+// The cursor is left after the object, return 1 if successful.
+
+typedef int(*ArgusJsonHandler)(void *, const char *, int, int, const char *, int);
+int ArgusJsonScan(const char **, ArgusJsonHandler, void *);
 char *ArgusJsonPrint(ArgusJsonValue *, char *, int);
 
 // Free the structure and all the allocated values
@@ -86,6 +86,8 @@ extern "C" {
 
 #define ARGUS_PRUNE_TREE            0x1000
 
+#define ARGUS_GEOIP2_CACHE_DEFAULT  16384
+
 struct ArgusGeoIPCityObject {
    char *field, *format;
    int length, index, offset, value;
@@ -125,6 +127,8 @@ struct ArgusLabelerStruct {
    int RaLabelGeoIPCity;
    MMDB_s RaGeoIPCityObject;
    int RaLabelGeoIPCityLabels[16];
+   int RaGeoIPCacheSize;
+   struct ArgusGeoIP2Cache *RaGeoIPCache;
 #elif defined(ARGUS_GEOIP)
    int RaLabelGeoIPAsn;
    GeoIP *RaGeoIPv4AsnObject;
@@ -140,6 +144,7 @@ struct ArgusLabelerStruct {
    struct RaPortStruct **ArgusTCPPortLabels;
    struct RaPortStruct **ArgusUDPPortLabels;
    struct ArgusQueueStruct *ArgusFlowQueue;
+   struct RaFlowLabelIndex *ArgusFlowIndex;
 };
 
 #define ARGUS_EXACT_MATCH       0x00
@@ -195,11 +200,40 @@ struct RaPortStruct {
 };
 
 
+/* necessary conditions extracted from a flow label filter, used to
+ * index the rules and to reject records before running the filter */
+
+#define RA_FLOW_LABEL_MAXTERMS      4
+
+struct RaFlowLabelTerm {
+   int dir;
+   unsigned int value, mask;
+};
+
+struct RaFlowLabelKey {
+   int proto, nports, naddrs;
+   struct RaFlowLabelTerm ports[RA_FLOW_LABEL_MAXTERMS];
+   struct RaFlowLabelTerm addrs[RA_FLOW_LABEL_MAXTERMS];
+};
+
 struct RaFlowLabelStruct {
    struct ArgusQueueHeader qhdr;
    int status, cont;
    char *filterstr, *labelstr, *grepstr, *colorstr;
    struct nff_program filter;
+   struct RaFlowLabelKey key;
+};
+
+struct RaFlowLabelBucket {
+   int count, size;
+   int *rules;
+};
+
+struct RaFlowLabelIndex {
+   int count;
+   struct RaFlowLabelStruct **rules;
+   struct RaFlowLabelBucket generic;
+   struct RaFlowLabelBucket *ports;
 };
 
 
@@ -39,7 +39,11 @@ int ArgusLabelRecordGeoIP(struct ArgusParserStruct *,
 #endif
 
 #if defined(ARGUS_GEOIP2)
+struct ArgusLabelerStruct;
+
 int ArgusLabelRecordGeoIP2(struct ArgusParserStruct *,
                            struct ArgusRecordStruct *, char *, size_t, int *);
 int ArgusGeoIP2FindObject(const char * const);
+void ArgusFlushGeoIP2Cache(struct ArgusLabelerStruct *);
+void ArgusDeleteGeoIP2Cache(struct ArgusLabelerStruct *);
 #endif
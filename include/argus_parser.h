@@ -251,6 +251,8 @@ struct ArgusRecordStruct {
    float srate, drate, sload, dload, dur, mean;
    float pcr, sploss, dploss;
    long long offset;
+   long long seq;                       /* racluster spill arrival sequence */
+   unsigned long long khash;            /* racluster spill partition hash */
 };
 
 struct ArgusRemoteStruct {
@@ -405,6 +407,7 @@ struct ArgusParserStruct {
 
    regex_t upreg[ARGUS_MAX_REGEX];
    regex_t lpreg;
+   struct ArgusGrepMatcherStruct *ArgusGrepMatcher, *ArgusLabelMatcher;
    regex_t sgpreg, dgpreg;
 
    int ArgusHashTableSize;
@@ -458,6 +461,8 @@ struct ArgusParserStruct {
    long long ArgusTotalMarRecords;
    long long ArgusTotalEventRecords;
    long long ArgusTotalFarRecords;
+   long long ArgusTimeRejects, ArgusHeaderRejects;
+   long long ArgusLazyRejects, ArgusFilterRejects;
    long long ArgusTotalPkts, ArgusTotalSrcPkts, ArgusTotalDstPkts;
    long long ArgusTotalBytes, ArgusTotalSrcBytes, ArgusTotalDstBytes;
 
@@ -0,0 +1,120 @@
+/*
+ * Argus-5.0 Client Software. Tools to read, analyze and manage Argus data.
+ * Copyright (c) 2000-2024 QoSient, LLC
+ * All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+
+#ifndef ArgusSketch_h
+#define ArgusSketch_h
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fixed memory summaries, for when the exact address tables won't fit.
+ *
+ * ArgusHLLStruct is a HyperLogLog distinct counter, 2^p one byte
+ * registers, with a standard error of 1.04 / sqrt(2^p).
+ *
+ * ArgusTopKStruct is a Space-Saving heavy hitter table of k keys.
+ * Each count is high by no more than its error, which is never more
+ * than total / k, and any key whose weight is more than total / k is
+ * in the table.  An entry can carry its own HLL, to count the distinct
+ * peers of a host.
+ *
+ * Both merge, an HLL by taking the larger register, and a top-k table
+ * by adding the counts, using the other table's smallest count for keys
+ * it doesn't have, so sketches written to disk each day can be merged
+ * into weekly ones, with the same error bounds as if the week had been
+ * read in one pass.
+ */
+
+#define ARGUS_SKETCH_MAGIC	"ARGUSSKT"
+#define ARGUS_SKETCH_VERSION	1
+
+#define ARGUS_SKETCH_HLL	1
+#define ARGUS_SKETCH_TOPK	2
+
+#define ARGUS_SKETCH_KEYLEN	20
+#define ARGUS_HLL_MINP		4
+#define ARGUS_HLL_MAXP		18
+
+struct ArgusHLLStruct {
+   int p, m;
+   unsigned char *reg;
+};
+
+struct ArgusTopKEntryStruct {
+   unsigned long long count, error;
+   unsigned int hash, flags;
+   int len, heap, nxt;
+   unsigned char key[ARGUS_SKETCH_KEYLEN];
+   struct ArgusHLLStruct *hll;
+};
+
+struct ArgusTopKStruct {
+   int k, p, count, buckets;
+   unsigned long long total;
+   struct ArgusTopKEntryStruct *entries;
+   int *heap, *bucket;
+};
+
+struct ArgusSketchStruct {
+   struct ArgusSketchStruct *nxt;
+   char *name;
+   int type;
+   void *sketch;
+};
+
+struct ArgusSketchSetStruct {
+   struct ArgusSketchStruct *start;
+   int count;
+};
+
+extern struct ArgusHLLStruct *ArgusNewHLL (int);
+extern void ArgusDeleteHLL (struct ArgusHLLStruct *);
+extern void ArgusHLLAdd (struct ArgusHLLStruct *, unsigned long long);
+extern double ArgusHLLCount (struct ArgusHLLStruct *);
+extern double ArgusHLLError (struct ArgusHLLStruct *);
+extern int ArgusMergeHLL (struct ArgusHLLStruct *, struct ArgusHLLStruct *);
+
+extern struct ArgusTopKStruct *ArgusNewTopK (int, int);
+extern void ArgusDeleteTopK (struct ArgusTopKStruct *);
+extern struct ArgusTopKEntryStruct *ArgusTopKUpdate (struct ArgusTopKStruct *, void *, int, unsigned long long);
+extern unsigned long long ArgusTopKError (struct ArgusTopKStruct *);
+extern int ArgusTopKSort (struct ArgusTopKStruct *, struct ArgusTopKEntryStruct **);
+extern int ArgusMergeTopK (struct ArgusTopKStruct *, struct ArgusTopKStruct *);
+
+extern unsigned long long ArgusSketchHash (void *, int);
+
+extern struct ArgusSketchSetStruct *ArgusNewSketchSet (void);
+extern void ArgusDeleteSketchSet (struct ArgusSketchSetStruct *);
+extern struct ArgusSketchStruct *ArgusFindSketch (struct ArgusSketchSetStruct *, char *);
+extern void *ArgusGetSketch (struct ArgusSketchSetStruct *, char *, int, int, int);
+extern int ArgusWriteSketchSet (struct ArgusSketchSetStruct *, char *);
+extern int ArgusMergeSketchFile (struct ArgusSketchSetStruct *, char *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* ArgusSketch_h */
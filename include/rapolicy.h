@@ -151,6 +151,31 @@ struct RaPolicyPolicyStruct {
    char *labelStr;
 };
 
+/*
+ * The compiled classifier, a tuple space over the source and
+ * destination wildcard masks and whether the entry names a protocol.
+ */
+
+struct RaPolicyTupleStruct {
+   arg_uint32 smask, dmask;
+   int proto, first;
+};
+
+struct RaPolicyClassEntry {
+   struct RaPolicyClassEntry *nxt;
+   arg_uint32 saddr, daddr;
+   arg_uint16 tuple, proto;
+   int count, size, *index;
+};
+
+struct RaPolicyClassifierStruct {
+   struct RaPolicyPolicyStruct **policy;
+   struct RaPolicyTupleStruct *tuples;
+   struct RaPolicyClassEntry **table;
+   int policies, ntuples, nothers, *others;
+   unsigned int size, entries;
+};
+
 
 #if defined(RA_POLICY_C)
 
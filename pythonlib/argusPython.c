@@ -187,9 +187,24 @@ ArgusIdleClientTimeout ()
 
 void RaProcessThisRecord (struct ArgusParserStruct *, struct ArgusRecordStruct *);
 
+struct ArgusColumnReaderStruct;
+static struct ArgusColumnReaderStruct *ArgusColumnReader;
+static void ArgusColumnAppend (struct ArgusColumnReaderStruct *, struct ArgusRecordStruct *);
+
 void
 RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *ns)
 {
+   if (ArgusColumnReader != NULL) {
+      switch (ns->hdr.type & 0xF0) {
+         case ARGUS_NETFLOW:
+         case ARGUS_AFLOW:
+         case ARGUS_FAR:
+            ArgusColumnAppend (ArgusColumnReader, ns);
+            break;
+      }
+      return;
+   }
+
    {
       double nowTime = ArgusFetchStartTime(ns);
       if (parser->ArgusLastRecordTime == 0) {
@@ -876,19 +891,29 @@ RaConvertParseTitleString (char *str)
 }
 
 
+// the record and field buffers are allocated once and reused, and the
+// fields are split in place with memchr() rather than strsep().
+
+static char *RaConvertRecordBuffer = NULL;
+static char **RaConvertRecordFields = NULL;
+
 int
 RaConvertParseRecordString (struct ArgusParserStruct *parser, char *str)
 {
    struct ArgusRecordStruct *argus = &parser->argus;
-   char *buf, delim[16], *ptr, *tptr;
-   char **ap, **argv;
-   int retn = 1, numfields, i;
+   char *buf, *ptr, *end, *tok;
+   char **argv;
+   int retn = 1, numfields = 0, slen, i;
 
-   if ((buf = ArgusCalloc(1, MAXSTRLEN)) == NULL)
-      ArgusLog(LOG_ERR, "RaConvertParseTitleString ArgusCalloc error %s", strerror(errno));
+   if (RaConvertRecordBuffer == NULL) {
+      if ((RaConvertRecordBuffer = ArgusCalloc(1, MAXSTRLEN)) == NULL)
+         ArgusLog(LOG_ERR, "RaConvertParseRecordString ArgusCalloc error %s", strerror(errno));
 
-   if ((argv = ArgusCalloc(sizeof(char *), ARGUS_MAX_PRINT_FIELDS)) == NULL)
-      ArgusLog(LOG_ERR, "RaConvertParseTitleString ArgusCalloc error %s", strerror(errno));
+      if ((RaConvertRecordFields = ArgusCalloc(sizeof(char *), ARGUS_MAX_PRINT_FIELDS)) == NULL)
+         ArgusLog(LOG_ERR, "RaConvertParseRecordString ArgusCalloc error %s", strerror(errno));
+   }
+   buf = RaConvertRecordBuffer;
+   argv = RaConvertRecordFields;
 
 #ifdef ARGUSDEBUG
    ArgusDebug (1, "RaConvertParseRecordString('%s')", str);
@@ -897,26 +922,31 @@ RaConvertParseRecordString (struct ArgusParserStruct *parser, char *str)
    if ((ptr = strchr(str, '\n')) != NULL)
       *ptr = '\0';
 
-   ptr = buf;
+   if ((slen = strlen(str)) >= MAXSTRLEN)
+      slen = MAXSTRLEN - 1;
 
-   bzero ((char *)argus, sizeof(*argus));
-   bcopy (str, buf, strlen(str) + 1);
-   bzero (delim, sizeof(delim));
+   bcopy (str, buf, slen);
+   buf[slen] = '\0';
 
    bzero ((char *)&parser->argus, sizeof(parser->argus));
    bzero ((char *)&parser->canon, sizeof(parser->canon));
 
    ArgusThisProto = 0;
 
+   ptr = buf;
+   end = buf + slen;
    while (isspace((int)*ptr)) ptr++;
-   sprintf (delim, "%c", RaConvertDelimiter[0]);
-   tptr = ptr;
 
-   for (ap = argv; (*ap = strsep(&tptr, delim)) != NULL;)
-      if (++ap >= &argv[ARGUS_MAX_PRINT_FIELDS])
-         break;
+   while (numfields < ARGUS_MAX_PRINT_FIELDS) {
+      if ((tok = memchr(ptr, RaConvertDelimiter[0], end - ptr)) == NULL)
+         tok = end;
+      *tok = '\0';
+      argv[numfields++] = ptr;
 
-   numfields = ((char *)ap - (char *)argv)/sizeof(ap);
+      if (tok == end)
+         break;
+      ptr = tok + 1;
+   }
 
    for (i = 0; i < numfields; i++) {
       if ((strcasecmp(argv[i], "-nan") == 0) || (strcasecmp(argv[i], "nan") == 0)) {
@@ -1049,9 +1079,6 @@ RaConvertParseRecordString (struct ArgusParserStruct *parser, char *str)
       }
    }
 
-   ArgusFree (argv);
-   ArgusFree (buf);
-
 #ifdef ARGUSDEBUG
    ArgusDebug (1, "RaConvertParseRecordString('%s') returning %d", str, retn);
 #endif
@@ -1077,6 +1104,48 @@ setArgusSchema (char *str)
 }
 
 
+// strip the "cisco:", "ft:", ... prefix from a data source name
+// and return the source type it names.
+
+static int
+ArgusPythonSourceType (struct ArgusParserStruct *parser, char **name)
+{
+   int type = ARGUS_DATA_SOURCE;
+   char *optarg = *name;
+
+#if defined(ARGUS_MYSQL)
+   if (!(strncmp ("mysql:", optarg, 6))) {
+      if (parser->readDbstr != NULL)
+         free(parser->readDbstr);
+      parser->readDbstr = strdup(optarg);
+      type &= ~ARGUS_DATA_SOURCE;
+      type |= ARGUS_DBASE_SOURCE;
+      optarg += 6;
+   }
+#endif
+   if (!(strncmp ("cisco:", optarg, 6))) {
+      parser->Cflag++;
+      type |= ARGUS_CISCO_DATA_SOURCE;
+      optarg += 6;
+   } else
+   if (!(strncmp ("jflow:", optarg, 6))) {
+      parser->Cflag++;
+      type |= ARGUS_JFLOW_DATA_SOURCE;
+      optarg += 6;
+   } else
+   if (!(strncmp ("ft:", optarg, 3))) {
+      type |= ARGUS_FLOW_TOOLS_SOURCE;
+      optarg += 3;
+   } else
+   if (!(strncmp ("sflow:", optarg, 6))) {
+      type |= ARGUS_SFLOW_DATA_SOURCE;
+      optarg += 6;
+   }
+
+   *name = optarg;
+   return (type);
+}
+
 int
 readArgusData (char *optarg)
 {
@@ -1087,34 +1156,7 @@ readArgusData (char *optarg)
    char *ptr, *eptr;
 
    if ((parser = ArgusParser) != NULL) {
-#if defined(ARGUS_MYSQL)
-      if (!(strncmp ("mysql:", optarg, 6))) {
-         if (parser->readDbstr != NULL)
-            free(parser->readDbstr);
-         parser->readDbstr = strdup(optarg);
-         type &= ~ARGUS_DATA_SOURCE;
-         type |= ARGUS_DBASE_SOURCE;
-         optarg += 6;
-      }
-#endif
-      if (!(strncmp ("cisco:", optarg, 6))) {
-         parser->Cflag++;
-         type |= ARGUS_CISCO_DATA_SOURCE;
-         optarg += 6;
-      } else
-      if (!(strncmp ("jflow:", optarg, 6))) {
-         parser->Cflag++;
-         type |= ARGUS_JFLOW_DATA_SOURCE;
-         optarg += 6;
-      } else
-      if (!(strncmp ("ft:", optarg, 3))) {
-         type |= ARGUS_FLOW_TOOLS_SOURCE;
-         optarg += 3;
-      } else
-      if (!(strncmp ("sflow:", optarg, 6))) {
-         type |= ARGUS_SFLOW_DATA_SOURCE;
-         optarg += 6;
-      }
+      type = ArgusPythonSourceType (parser, &optarg);
 
 
       if ((ptr = strstr(optarg, "::")) != NULL) {
@@ -1152,6 +1194,395 @@ readArgusData (char *optarg)
    return (retn);
 }
 
+/*
+ * Columnar export.  argus_columns() reads an argus data source into one
+ * typed buffer per field, and returns a dict of numpy arrays built on
+ * those buffers, so no python object is made per record.  The fields
+ * are metric names from RaFetchAlgorithmTable, e.g. "stime dur saddr
+ * sport daddr dport proto pkts bytes", and default to the -s fields.
+ * argus_open(), argus_next_chunk() and argus_close() do the same a
+ * chunk of records at a time, for data larger than memory.
+ *
+ * Counters are int64, addresses uint32 (IPv4, host order), ports and
+ * vlans uint16, proto, tos and ttl uint8, everything else float64.
+ */
+
+#define ARGUS_MAX_COLUMNS	64
+#define ARGUS_COLUMN_CHUNK	65536
+
+struct ArgusColumnTypeStruct {
+   char *field;
+   int type, size;
+};
+
+static struct ArgusColumnTypeStruct ArgusColumnTypes[] = {
+   { "srcid",     NPY_UINT32, sizeof(npy_uint32) },
+   { "sid",       NPY_UINT32, sizeof(npy_uint32) },
+   { "inf",       NPY_UINT32, sizeof(npy_uint32) },
+   { "saddr",     NPY_UINT32, sizeof(npy_uint32) },
+   { "daddr",     NPY_UINT32, sizeof(npy_uint32) },
+   { "smpls",     NPY_UINT32, sizeof(npy_uint32) },
+   { "dmpls",     NPY_UINT32, sizeof(npy_uint32) },
+   { "sport",     NPY_UINT16, sizeof(npy_uint16) },
+   { "dport",     NPY_UINT16, sizeof(npy_uint16) },
+   { "ipid",      NPY_UINT16, sizeof(npy_uint16) },
+   { "svlan",     NPY_UINT16, sizeof(npy_uint16) },
+   { "dvlan",     NPY_UINT16, sizeof(npy_uint16) },
+   { "etype",     NPY_UINT16, sizeof(npy_uint16) },
+   { "proto",     NPY_UINT8,  sizeof(npy_uint8) },
+   { "stos",      NPY_UINT8,  sizeof(npy_uint8) },
+   { "dtos",      NPY_UINT8,  sizeof(npy_uint8) },
+   { "sttl",      NPY_UINT8,  sizeof(npy_uint8) },
+   { "dttl",      NPY_UINT8,  sizeof(npy_uint8) },
+   { "trans",     NPY_INT64,  sizeof(npy_int64) },
+   { "pkts",      NPY_INT64,  sizeof(npy_int64) },
+   { "spkts",     NPY_INT64,  sizeof(npy_int64) },
+   { "dpkts",     NPY_INT64,  sizeof(npy_int64) },
+   { "bytes",     NPY_INT64,  sizeof(npy_int64) },
+   { "sbytes",    NPY_INT64,  sizeof(npy_int64) },
+   { "dbytes",    NPY_INT64,  sizeof(npy_int64) },
+   { "appbytes",  NPY_INT64,  sizeof(npy_int64) },
+   { "sappbytes", NPY_INT64,  sizeof(npy_int64) },
+   { "dappbytes", NPY_INT64,  sizeof(npy_int64) },
+   { "seq",       NPY_INT64,  sizeof(npy_int64) },
+   { "stcpb",     NPY_INT64,  sizeof(npy_int64) },
+   { "dtcpb",     NPY_INT64,  sizeof(npy_int64) },
+   { NULL,        NPY_FLOAT64, sizeof(npy_float64) },
+};
+
+struct ArgusColumnStruct {
+   char field[32];
+   double (*fetch)(struct ArgusRecordStruct *);
+   int type, size;
+   char *data;
+};
+
+struct ArgusColumnReaderStruct {
+   struct ArgusFileInput file;
+   struct ArgusInput *input;
+   struct ArgusColumnStruct columns[ARGUS_MAX_COLUMNS];
+   int ncolumns, count, size, done;
+};
+
+static struct ArgusColumnReaderStruct *ArgusColumnReader = NULL;
+
+static void
+ArgusColumnResize (struct ArgusColumnReaderStruct *rdr, int size)
+{
+   int i;
+
+   for (i = 0; i < rdr->ncolumns; i++) {
+      struct ArgusColumnStruct *col = &rdr->columns[i];
+      char *data;
+
+      if ((data = PyDataMem_RENEW(col->data, (size_t) size * col->size)) == NULL)
+         ArgusLog (LOG_ERR, "ArgusColumnResize: PyDataMem_RENEW error %s", strerror(errno));
+      col->data = data;
+   }
+   rdr->size = size;
+}
+
+static void
+ArgusColumnAppend (struct ArgusColumnReaderStruct *rdr, struct ArgusRecordStruct *ns)
+{
+   int i, n;
+
+   if ((n = rdr->count) == rdr->size)
+      ArgusColumnResize (rdr, rdr->size ? (rdr->size * 2) : 4096);
+
+   for (i = 0; i < rdr->ncolumns; i++) {
+      struct ArgusColumnStruct *col = &rdr->columns[i];
+      double value = col->fetch(ns);
+
+      switch (col->type) {
+         case NPY_UINT8:   ((npy_uint8 *)col->data)[n]   = value; break;
+         case NPY_UINT16:  ((npy_uint16 *)col->data)[n]  = value; break;
+         case NPY_UINT32:  ((npy_uint32 *)col->data)[n]  = value; break;
+         case NPY_INT64:   ((npy_int64 *)col->data)[n]   = value; break;
+         default:          ((npy_float64 *)col->data)[n] = value; break;
+      }
+   }
+   rdr->count++;
+}
+
+// parse the field list, "stime,dur saddr ...", or the -s fields if it
+// is NULL.  Unknown fields are an error when asked for, and skipped
+// when they come from -s, which also names strings such as "state".
+
+static int
+ArgusColumnFields (struct ArgusParserStruct *parser, struct ArgusColumnReaderStruct *rdr, char *fields)
+{
+   char *fbuf = NULL, *field, *ptr, *tok[ARGUS_MAX_S_OPTIONS];
+   int i, x, ntok = 0;
+
+   if (fields != NULL) {
+      fbuf = strdup(fields);
+      for (ptr = fbuf; (ntok < ARGUS_MAX_S_OPTIONS) && ((field = strtok(ptr, " ,\t")) != NULL); ptr = NULL)
+         tok[ntok++] = field;
+   } else {
+      for (i = 0; (i < parser->RaPrintOptionIndex) && (ntok < ARGUS_MAX_S_OPTIONS); i++)
+         if (parser->RaPrintOptionStrings[i] != NULL)
+            tok[ntok++] = parser->RaPrintOptionStrings[i];
+   }
+
+   for (i = 0; i < ntok; i++) {
+      struct ArgusColumnStruct *col = &rdr->columns[rdr->ncolumns];
+      struct ArgusColumnTypeStruct *ctype;
+      char name[32];
+
+      snprintf (name, sizeof(name), "%s", (*tok[i] == '+') ? tok[i] + 1 : tok[i]);
+      if ((ptr = strchr(name, ':')) != NULL)
+         *ptr = '\0';
+
+      for (x = 0; x < ARGUS_MAX_METRIC_ALG; x++)
+         if (!(strcmp(name, RaFetchAlgorithmTable[x].field)))
+            break;
+
+      if (x == ARGUS_MAX_METRIC_ALG) {
+         if (fields == NULL)
+            continue;
+         PyErr_Format (PyExc_ValueError, "argus field '%s' is not a metric", name);
+         free(fbuf);
+         return (0);
+      }
+
+      if (rdr->ncolumns == ARGUS_MAX_COLUMNS) {
+         PyErr_Format (PyExc_ValueError, "more than %d argus fields", ARGUS_MAX_COLUMNS);
+         free(fbuf);
+         return (0);
+      }
+
+      for (ctype = ArgusColumnTypes; ctype->field != NULL; ctype++)
+         if (!(strcmp(name, ctype->field)))
+            break;
+
+      snprintf (col->field, sizeof(col->field), "%s", name);
+      col->fetch = RaFetchAlgorithmTable[x].fetch;
+      col->type = ctype->type;
+      col->size = ctype->size;
+      rdr->ncolumns++;
+   }
+
+   if (fbuf != NULL)
+      free(fbuf);
+
+   if (rdr->ncolumns == 0) {
+      PyErr_SetString (PyExc_ValueError, "no argus fields to read");
+      return (0);
+   }
+   return (1);
+}
+
+static void
+ArgusColumnDelete (struct ArgusColumnReaderStruct *rdr)
+{
+   int i;
+
+   if (rdr->input != NULL)
+      ArgusDeleteInput (ArgusParser, rdr->input);
+   if (rdr->file.filename != NULL)
+      free(rdr->file.filename);
+
+   for (i = 0; i < rdr->ncolumns; i++)
+      if (rdr->columns[i].data != NULL)
+         PyDataMem_FREE(rdr->columns[i].data);
+
+   ArgusFree(rdr);
+}
+
+// hand the first n rows to numpy, which takes ownership of the
+// buffers, and start new buffers with the rows left over.
+
+static PyObject *
+ArgusColumnDict (struct ArgusColumnReaderStruct *rdr, int n)
+{
+   int i, left = rdr->count - n, size = (left > 4096) ? left : 4096;
+   PyObject *dict;
+
+   if ((dict = PyDict_New()) == NULL)
+      return (NULL);
+
+   for (i = 0; i < rdr->ncolumns; i++) {
+      struct ArgusColumnStruct *col = &rdr->columns[i];
+      npy_intp dims = n;
+      PyObject *array;
+      char *data;
+
+      if ((data = PyDataMem_NEW((size_t) size * col->size)) == NULL)
+         ArgusLog (LOG_ERR, "ArgusColumnDict: PyDataMem_NEW error %s", strerror(errno));
+      if (left > 0)
+         bcopy (col->data + ((size_t) n * col->size), data, (size_t) left * col->size);
+
+      if ((n > 0) && (n < rdr->size)) {
+         char *tdata;
+         if ((tdata = PyDataMem_RENEW(col->data, (size_t) n * col->size)) != NULL)
+            col->data = tdata;
+      }
+
+      if ((array = PyArray_SimpleNewFromData(1, &dims, col->type, col->data)) == NULL) {
+         PyDataMem_FREE(data);
+         Py_DECREF(dict);
+         return (NULL);
+      }
+      PyArray_ENABLEFLAGS((PyArrayObject *) array, NPY_ARRAY_OWNDATA);
+      col->data = data;
+
+      PyDict_SetItemString(dict, col->field, array);
+      Py_DECREF(array);
+   }
+
+   rdr->count = left;
+   rdr->size = size;
+   return (dict);
+}
+
+static int
+ArgusColumnRead (struct ArgusParserStruct *parser, struct ArgusColumnReaderStruct *rdr, int count)
+{
+   struct ArgusInput *current = parser->ArgusCurrentInput;
+   int retn = 0;
+
+   parser->ArgusCurrentInput = rdr->input;
+
+   while (!rdr->done && (rdr->count < count)) {
+      switch (rdr->input->type & ARGUS_DATA_TYPE) {
+         case ARGUS_CISCO_DATA_SOURCE:
+            retn = ArgusReadCiscoStreamSocket (parser, rdr->input);
+            break;
+         default:
+            retn = ArgusReadStreamSocket (parser, rdr->input);
+            break;
+      }
+      if (retn > 0)
+         rdr->done = 1;
+   }
+
+   parser->ArgusCurrentInput = current;
+   return (rdr->count);
+}
+
+/*
+ * argus_open - open datafile for chunked column reads.  Returns 1,
+ * or -1 with a Python exception set.
+ */
+
+int
+argus_open (char *datafile, char *fields)
+{
+   struct ArgusParserStruct *parser = ArgusParser;
+   struct ArgusColumnReaderStruct *rdr;
+   struct ArgusFileInput *files;
+   struct ArgusInput *current;
+   char *optarg;
+   int type;
+
+   if (parser == NULL) {
+      PyErr_SetString (PyExc_RuntimeError, "argusInit() has not been called");
+      return (-1);
+   }
+
+   if (ArgusColumnReader != NULL) {
+      ArgusColumnDelete (ArgusColumnReader);
+      ArgusColumnReader = NULL;
+   }
+
+   if ((rdr = ArgusCalloc (1, sizeof(*rdr))) == NULL)
+      ArgusLog (LOG_ERR, "argus_open: ArgusCalloc error %s", strerror(errno));
+
+   if (!(ArgusColumnFields (parser, rdr, fields))) {
+      ArgusColumnDelete (rdr);
+      return (-1);
+   }
+
+   optarg = datafile;
+   type = ArgusPythonSourceType (parser, &optarg);
+
+   rdr->file.filename = strdup(optarg);
+   rdr->file.type = type;
+   rdr->file.ostart = -1;
+   rdr->file.ostop = -1;
+   rdr->file.fd = -1;
+
+   if ((rdr->input = ArgusCalloc (1, sizeof(*rdr->input))) == NULL)
+      ArgusLog (LOG_ERR, "argus_open: ArgusCalloc error %s", strerror(errno));
+
+   ArgusInputFromFile (rdr->input, &rdr->file);
+
+// ArgusParseInit() sets up netflow inputs as files only when they
+// are on the input file list, so the file is put there while the
+// connection is read.
+
+   current = parser->ArgusCurrentInput;
+   parser->ArgusCurrentInput = rdr->input;
+   files = parser->ArgusInputFileList;
+   if (files == NULL)
+      parser->ArgusInputFileList = &rdr->file;
+
+   if (((rdr->input->file = fopen(rdr->input->filename, "r")) == NULL) ||
+        (ArgusReadConnection (parser, rdr->input, ARGUS_FILE) < 0)) {
+      PyErr_Format (PyExc_IOError, "argus_open: %s: %s", optarg, strerror(errno));
+      parser->ArgusInputFileList = files;
+      parser->ArgusCurrentInput = current;
+      ArgusColumnDelete (rdr);
+      return (-1);
+   }
+   parser->ArgusInputFileList = files;
+
+   ArgusColumnResize (rdr, 4096);
+   ArgusColumnReader = rdr;
+
+   parser->ArgusTotalMarRecords++;
+   parser->ArgusTotalRecords++;
+   ArgusHandleRecord (parser, rdr->input, &rdr->input->ArgusInitCon, 0, &parser->ArgusFilterCode);
+   parser->ArgusCurrentInput = current;
+
+#ifdef ARGUSDEBUG
+   ArgusDebug (1, "argus_open('%s', '%s') %d columns", datafile, fields ? fields : "", rdr->ncolumns);
+#endif
+   return (1);
+}
+
+PyObject *
+argus_next_chunk (int count)
+{
+   struct ArgusColumnReaderStruct *rdr;
+
+   if ((rdr = ArgusColumnReader) == NULL) {
+      PyErr_SetString (PyExc_RuntimeError, "argus_next_chunk: no input open");
+      return (NULL);
+   }
+
+   if (count <= 0)
+      count = ARGUS_COLUMN_CHUNK;
+
+   if (ArgusColumnRead (ArgusParser, rdr, count) == 0)
+      Py_RETURN_NONE;
+
+   return (ArgusColumnDict (rdr, (rdr->count < count) ? rdr->count : count));
+}
+
+void
+argus_close (void)
+{
+   if (ArgusColumnReader != NULL) {
+      ArgusColumnDelete (ArgusColumnReader);
+      ArgusColumnReader = NULL;
+   }
+}
+
+PyObject *
+argus_columns (char *datafile, char *fields)
+{
+   PyObject *retn = NULL;
+
+   if (argus_open (datafile, fields) > 0) {
+      ArgusColumnRead (ArgusParser, ArgusColumnReader, INT_MAX);
+      retn = ArgusColumnDict (ArgusColumnReader, ArgusColumnReader->count);
+      argus_close ();
+   }
+   return (retn);
+}
+
 int
 setArgusBaseline (char *optarg)
 {
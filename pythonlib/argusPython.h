@@ -33,6 +33,10 @@ void ArgusDebug (int d, char *fmt, ...);
 int argustime (char *time_string, int *start, int *end);
 PyObject *argus_critic(PyObject *y_true, PyObject *y_pred);
 PyObject *argus_match(PyObject *y_true);
+PyObject *argus_columns(char *datafile, char *fields);
+int argus_open(char *datafile, char *fields);
+PyObject *argus_next_chunk(int count);
+void argus_close(void);
 
 struct RaCursesProcessStruct {
    int status, timeout;
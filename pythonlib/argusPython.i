@@ -12,6 +12,10 @@ int setArgusSchema (char *titles);
 int setArgusBaseline (char *baseline);
 PyObject *argus_critic (PyObject *y_true, PyObject *y_pred);
 PyObject *argus_match (PyObject *y_true);
+PyObject *argus_columns (char *datafile, char *fields);
+int argus_open (char *datafile, char *fields);
+PyObject *argus_next_chunk (int count);
+void argus_close (void);
 int argustime (char *time_string, int *start, int *end);
 %}
 
@@ -21,10 +25,44 @@ int argustime (char *time_string, int *start, int *end);
     import_array();
 %}
 
+%exception argus_open {
+   $action
+   if ((result < 0) && PyErr_Occurred())
+      SWIG_fail;
+}
+
 int argusInit (void);
 int readArgusData (char *datafile);
 int setArgusSchema (char *titles);
 int setArgusBaseline (char *baseline);
 PyObject *argus_critic (PyObject *y_true, PyObject *y_pred);
 PyObject *argus_match (PyObject *y_true);
+PyObject *argus_columns (char *datafile, char *fields);
+int argus_open (char *datafile, char *fields);
+PyObject *argus_next_chunk (int count);
+void argus_close (void);
 int argustime (char *time_string, int *start, int *end);
+
+%pythoncode %{
+def argus_chunks(datafile, fields=None, count=65536):
+    """Yield dicts of numpy arrays, count records at a time."""
+    argus_open(datafile, fields)
+    try:
+        while True:
+            columns = argus_next_chunk(count)
+            if columns is None:
+                break
+            yield columns
+    finally:
+        argus_close()
+
+def argus_structured(columns):
+    """Pack a dict of argus columns into a numpy structured array."""
+    import numpy
+    return numpy.rec.fromarrays(list(columns.values()), names=list(columns.keys()))
+
+def argus_record_batch(columns):
+    """Wrap a dict of argus columns as a pyarrow RecordBatch, without copying."""
+    import pyarrow
+    return pyarrow.RecordBatch.from_arrays([pyarrow.array(v) for v in columns.values()], names=list(columns.keys()))
+%}
@@ -0,0 +1,171 @@
+/*
+ * Argus-5.0 Client Software. Tools to read, analyze and manage Argus data.
+ * Copyright (c) 2000-2024 QoSient, LLC
+ * All rights reserved.
+ *
+ * THE ACCOMPANYING PROGRAM IS PROPRIETARY SOFTWARE OF QoSIENT, LLC,
+ * AND CANNOT BE USED, DISTRIBUTED, COPIED OR MODIFIED WITHOUT
+ * EXPRESS PERMISSION OF QoSIENT, LLC.
+ *
+ * QOSIENT, LLC DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS, IN NO EVENT SHALL QOSIENT, LLC BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF
+ * THIS SOFTWARE.
+ *
+ * argus_grep_test.c  - ArgusGrepMatch() literal prefilter test.
+ *
+ *    Each pattern is matched against its buffers with the multi-pattern
+ *    matcher, and with regexec() alone, through ArgusGrepBuf().  The
+ *    prefilter must never change the result, so any difference is a
+ *    failure.  The case sensitive patterns, which come first, are then
+ *    all loaded into one matcher, and each buffer is checked against the
+ *    any-pattern result.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "argus_config.h"
+#endif
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+
+#include <argus_compat.h>
+#include <argus_util.h>
+#include <argus_client.h>
+#include <argus_main.h>
+#include <argus_grep.h>
+
+struct ArgusGrepTestStruct {
+   char *pattern;
+   int icase;
+};
+
+static struct ArgusGrepTestStruct ArgusGrepTests[] = {
+   { "foo", 0 },
+   { "foo|bar", 0 },
+   { "ab+c", 0 },
+   { "abc?d", 0 },
+   { "a(bc)*d", 0 },
+   { "x[0-9]y", 0 },
+   { "^foo$", 0 },
+   { "foo\\.bar", 0 },
+   { "a\\+b", 0 },
+   { "\\(x\\)", 0 },
+   { "a\\|b", 0 },
+   { "c\\$", 0 },
+   { "a\\\\b", 0 },
+   { "\\<foo\\>", 0 },
+   { "\\<foo", 0 },
+   { "foo\\>", 0 },
+   { "\\`foo", 0 },
+   { "foo\\'", 0 },
+   { "\\bfoo\\b", 0 },
+   { "\\wfoo", 0 },
+   { "ba{2,3}r", 0 },
+   { "FOO", 1 },
+   { NULL, 0 },
+};
+
+static char *ArgusGrepBuffers[] = {
+   "foo", "a foo b", "xfoo", "foox", "FoO", "bar", "abbbc", "abd", "abcd",
+   "abcbcd", "ad", "x5y", "xay", "foo.bar", "fooxbar", "a+b", "aab", "(x)",
+   "a|b", "c$", "a\\b", "ab", "_foo", "baar", "baaar", "bar", "", NULL,
+};
+
+static int
+ArgusGrepTestCompile (regex_t *preg, char *pattern, int icase)
+{
+   int options, rege;
+
+#if defined(ARGUS_PCRE)
+   options = 0;
+#else
+   options = REG_EXTENDED | REG_NOSUB;
+#if defined(REG_ENHANCED)
+   options |= REG_ENHANCED;
+#endif
+#endif
+   if (icase)
+      options |= REG_ICASE;
+
+   if ((rege = regcomp(preg, pattern, options)) != 0) {
+      char errbuf[MAXSTRLEN];
+      regerror(rege, preg, errbuf, MAXSTRLEN);
+      fprintf (stderr, "argus_grep_test: '%s' regcomp error %s\n", pattern, errbuf);
+   }
+   return (rege);
+}
+
+int
+main (int argc, char **argv)
+{
+   struct ArgusGrepMatcherStruct *all, *matcher;
+   regex_t preg[sizeof(ArgusGrepTests) / sizeof(ArgusGrepTests[0])];
+   int i, b, patterns = 0, tests = 0, failures = 0;
+
+   if ((all = ArgusNewGrepMatcher(0)) == NULL)
+      ArgusLog (LOG_ERR, "argus_grep_test: ArgusNewGrepMatcher error %s", strerror(errno));
+
+   for (i = 0; ArgusGrepTests[i].pattern != NULL; i++) {
+      struct ArgusGrepTestStruct *test = &ArgusGrepTests[i];
+
+      if (ArgusGrepTestCompile (&preg[i], test->pattern, test->icase) != 0) {
+         failures++;
+         continue;
+      }
+
+      if ((matcher = ArgusNewGrepMatcher(test->icase)) == NULL)
+         ArgusLog (LOG_ERR, "argus_grep_test: ArgusNewGrepMatcher error %s", strerror(errno));
+      ArgusGrepMatcherAdd (matcher, test->pattern);
+
+      for (b = 0; ArgusGrepBuffers[b] != NULL; b++) {
+         char *buf = ArgusGrepBuffers[b], *lim = buf + strlen(buf);
+         int expect = ArgusGrepBuf (&preg[i], buf, lim);
+         int found = ArgusGrepMatch (matcher, &preg[i], buf, lim);
+
+         tests++;
+         if (found != expect) {
+            fprintf (stderr, "argus_grep_test: '%s' on \"%s\" matched %d, regexec %d\n", test->pattern, buf, found, expect);
+            failures++;
+         }
+      }
+      ArgusDeleteGrepMatcher (matcher);
+
+      if (!test->icase) {
+         ArgusGrepMatcherAdd (all, test->pattern);
+         patterns = i + 1;
+      }
+   }
+
+   for (b = 0; ArgusGrepBuffers[b] != NULL; b++) {
+      char *buf = ArgusGrepBuffers[b], *lim = buf + strlen(buf);
+      int expect = 0;
+
+      for (i = 0; i < patterns; i++)
+         if (!ArgusGrepTests[i].icase && ArgusGrepBuf (&preg[i], buf, lim))
+            expect = 1;
+
+      tests++;
+      if (ArgusGrepMatch (all, preg, buf, lim) != expect) {
+         fprintf (stderr, "argus_grep_test: all patterns on \"%s\" matched %d, regexec %d\n", buf, !expect, expect);
+         failures++;
+      }
+   }
+   ArgusDeleteGrepMatcher (all);
+
+   fprintf (stdout, "argus_grep_test: %d tests, %d failures\n", tests, failures);
+   exit (failures ? 1 : 0);
+}
+
+void RaParseComplete (int sig) { }
+void ArgusClientTimeout (void) { }
+void ArgusWindowClose (void) { }
+void RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus) { }
+int RaSendArgusRecord (struct ArgusRecordStruct *argus) { return (0); }
+void usage (void) { exit (1); }
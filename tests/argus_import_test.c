@@ -0,0 +1,192 @@
+/*
+ * Argus-5.0 Client Software. Tools to read, analyze and manage Argus data.
+ * Copyright (c) 2000-2024 QoSient, LLC
+ * All rights reserved.
+ *
+ * THE ACCOMPANYING PROGRAM IS PROPRIETARY SOFTWARE OF QoSIENT, LLC,
+ * AND CANNOT BE USED, DISTRIBUTED, COPIED OR MODIFIED WITHOUT
+ * EXPRESS PERMISSION OF QoSIENT, LLC.
+ *
+ * QOSIENT, LLC DISCLAIMS ALL WARRANTIES WITH REGARD TO THIS
+ * SOFTWARE, INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+ * AND FITNESS, IN NO EVENT SHALL QOSIENT, LLC BE LIABLE FOR ANY
+ * SPECIAL, INDIRECT OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER
+ * IN AN ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION,
+ * ARISING OUT OF OR IN CONNECTION WITH THE USE OR PERFORMANCE OF
+ * THIS SOFTWARE.
+ *
+ * argus_import_test.c  - ArgusReadDatagramBatch() loopback replay test.
+ *
+ *    A run of numbered datagrams, more than fit in one batch, is sent
+ *    over loopback UDP to a socket read with ArgusReadDatagramBatch().
+ *    Each datagram has to come back once, in the order it was sent,
+ *    with its own length, source address and contents, including one
+ *    cut short of its sequence number, and no read may hand over more
+ *    than a batch.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "argus_config.h"
+#endif
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include <argus_compat.h>
+#include <argus_util.h>
+#include <argus_client.h>
+#include <argus_main.h>
+
+#define ARGUS_IMPORT_TEST_DGRAMS	75
+#define ARGUS_IMPORT_TEST_SHORT		40
+#define ARGUS_IMPORT_TEST_BATCH		32
+
+static int ArgusImportTestCount = 0;
+static int ArgusImportTestPerRead = 0;
+static int ArgusImportTestFailures = 0;
+
+static int
+ArgusImportTestLength (int seq)
+{
+   return ((seq == ARGUS_IMPORT_TEST_SHORT) ? 2 : (4 + ((seq % 50) * 16)));
+}
+
+static void
+ArgusImportTestFill (unsigned char *buf, int seq)
+{
+   unsigned int nseq = htonl(seq);
+   int i, len = ArgusImportTestLength (seq);
+
+   bcopy (&nseq, buf, (len < sizeof(nseq)) ? len : sizeof(nseq));
+   for (i = sizeof(nseq); i < len; i++)
+      buf[i] = (seq + i) & 0xFF;
+}
+
+static int
+ArgusImportTestProcess (struct ArgusParserStruct *parser, struct ArgusInput *input, int len)
+{
+   unsigned char expect[1024];
+   int seq = ArgusImportTestCount++;
+
+   ArgusImportTestPerRead++;
+
+   if (seq >= ARGUS_IMPORT_TEST_DGRAMS) {
+      fprintf (stderr, "argus_import_test: datagram %d, only %d were sent\n", seq, ARGUS_IMPORT_TEST_DGRAMS);
+      ArgusImportTestFailures++;
+      return (0);
+   }
+
+   ArgusImportTestFill (expect, seq);
+
+   if (len != ArgusImportTestLength (seq)) {
+      fprintf (stderr, "argus_import_test: datagram %d is %d bytes, sent %d\n", seq, len, ArgusImportTestLength (seq));
+      ArgusImportTestFailures++;
+   } else
+   if (bcmp (input->ArgusReadPtr, expect, len)) {
+      fprintf (stderr, "argus_import_test: datagram %d out of order or corrupt\n", seq);
+      ArgusImportTestFailures++;
+   }
+
+   if (input->addr.s_addr != INADDR_LOOPBACK) {
+      fprintf (stderr, "argus_import_test: datagram %d from 0x%08x\n", seq, input->addr.s_addr);
+      ArgusImportTestFailures++;
+   }
+   return (0);
+}
+
+int
+main (int argc, char **argv)
+{
+#if defined(MSG_WAITFORONE)
+   struct sockaddr_in addr;
+   socklen_t alen = sizeof(addr);
+   struct ArgusInput *input;
+   unsigned char buf[1024];
+   struct pollfd pfd;
+   int sfd, i, reads = 0;
+
+   if ((input = ArgusCalloc (1, sizeof(*input))) == NULL)
+      ArgusLog (LOG_ERR, "argus_import_test: ArgusCalloc error %s", strerror(errno));
+
+   bzero (&addr, sizeof(addr));
+   addr.sin_family = AF_INET;
+   addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+   if ((input->fd = socket (AF_INET, SOCK_DGRAM, 0)) < 0)
+      ArgusLog (LOG_ERR, "argus_import_test: socket error %s", strerror(errno));
+   if (bind (input->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+      ArgusLog (LOG_ERR, "argus_import_test: bind error %s", strerror(errno));
+   if (getsockname (input->fd, (struct sockaddr *)&addr, &alen) < 0)
+      ArgusLog (LOG_ERR, "argus_import_test: getsockname error %s", strerror(errno));
+   input->portnum = ntohs(addr.sin_port);
+
+   if ((sfd = socket (AF_INET, SOCK_DGRAM, 0)) < 0)
+      ArgusLog (LOG_ERR, "argus_import_test: socket error %s", strerror(errno));
+
+/* an empty socket is not an error, and the first read sets up the batch and its receive buffer */
+
+   if (ArgusReadDatagramBatch (ArgusParser, input, ArgusImportTestProcess) != 0) {
+      fprintf (stderr, "argus_import_test: read of an empty socket failed\n");
+      ArgusImportTestFailures++;
+   }
+
+   for (i = 0; i < ARGUS_IMPORT_TEST_DGRAMS; i++) {
+      ArgusImportTestFill (buf, i);
+      if (sendto (sfd, buf, ArgusImportTestLength (i), 0, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+         ArgusLog (LOG_ERR, "argus_import_test: sendto error %s", strerror(errno));
+   }
+
+   pfd.fd = input->fd;
+   pfd.events = POLLIN;
+
+   while ((ArgusImportTestCount < ARGUS_IMPORT_TEST_DGRAMS) && (poll (&pfd, 1, 1000) > 0)) {
+      ArgusImportTestPerRead = 0;
+      if (ArgusReadDatagramBatch (ArgusParser, input, ArgusImportTestProcess) != 0) {
+         fprintf (stderr, "argus_import_test: read failed\n");
+         ArgusImportTestFailures++;
+         break;
+      }
+      if (ArgusImportTestPerRead > ARGUS_IMPORT_TEST_BATCH) {
+         fprintf (stderr, "argus_import_test: %d datagrams in one read\n", ArgusImportTestPerRead);
+         ArgusImportTestFailures++;
+      }
+      if (ArgusImportTestPerRead > 0)
+         reads++;
+   }
+
+   if (ArgusImportTestCount != ARGUS_IMPORT_TEST_DGRAMS) {
+      fprintf (stderr, "argus_import_test: %d datagrams read, %d sent\n", ArgusImportTestCount, ARGUS_IMPORT_TEST_DGRAMS);
+      ArgusImportTestFailures++;
+   }
+   if (reads < (ARGUS_IMPORT_TEST_DGRAMS + ARGUS_IMPORT_TEST_BATCH - 1) / ARGUS_IMPORT_TEST_BATCH) {
+      fprintf (stderr, "argus_import_test: %d datagrams in %d reads\n", ArgusImportTestCount, reads);
+      ArgusImportTestFailures++;
+   }
+
+   ArgusDeleteDatagramBatch (input);
+   close (sfd);
+   close (input->fd);
+   ArgusFree (input);
+
+   fprintf (stdout, "argus_import_test: %d datagrams in %d reads, %d failures\n", ArgusImportTestCount, reads, ArgusImportTestFailures);
+   exit (ArgusImportTestFailures ? 1 : 0);
+#else
+   fprintf (stdout, "argus_import_test: no recvmmsg(), skipped\n");
+   exit (0);
+#endif
+}
+
+void RaParseComplete (int sig) { }
+void ArgusClientTimeout (void) { }
+void ArgusWindowClose (void) { }
+void RaProcessRecord (struct ArgusParserStruct *parser, struct ArgusRecordStruct *argus) { }
+int RaSendArgusRecord (struct ArgusRecordStruct *argus) { return (0); }
+void usage (void) { exit (1); }
@@ -0,0 +1,47 @@
+#!/bin/sh
+#
+# raconvert_json_test.sh - raconvert() wrapped JSON regression test.
+#
+#    pythonlib/test/argus.out.json holds its records wrapped as
+#    {"ArgusData":[ ... ]}, with the wrapper on the first record's line
+#    and the closing ]} on the last.  Every flow record, the first and
+#    last included, has to come back out of the converted file.
+#
+
+bin=../bin
+json=${srcdir:-.}/../pythonlib/test/argus.out.json
+out=raconvert_json_test.out
+
+if [ ! -x $bin/raconvert ] || [ ! -x $bin/ra ] ; then
+   echo "raconvert_json_test: raconvert not built, skipped"
+   exit 0
+fi
+
+rm -f $out
+$bin/raconvert -r $json -w $out || exit 1
+
+$bin/ra -r $out -n -L -1 -c , -s saddr > $out.txt
+rm -f $out
+
+expect=`grep -c '"type":"flow"' $json`
+count=`wc -l < $out.txt`
+first=`grep -m 1 -o '"saddr":"[^"]*"' $json | cut -d'"' -f4`
+last=`grep -o '"saddr":"[^"]*"' $json | tail -1 | cut -d'"' -f4`
+
+failures=0
+if [ $count -ne $expect ] ; then
+   echo "raconvert_json_test: $count records converted, $expect in $json" >&2
+   failures=`expr $failures + 1`
+fi
+if [ "`head -1 $out.txt`" != "$first" ] ; then
+   echo "raconvert_json_test: first record `head -1 $out.txt`, expected $first" >&2
+   failures=`expr $failures + 1`
+fi
+if [ "`tail -1 $out.txt`" != "$last" ] ; then
+   echo "raconvert_json_test: last record `tail -1 $out.txt`, expected $last" >&2
+   failures=`expr $failures + 1`
+fi
+rm -f $out.txt
+
+echo "raconvert_json_test: $count of $expect records, $failures failures"
+[ $failures -eq 0 ]